@@ -13,6 +13,7 @@ cpp_examples = [
     ("tcp-nsc-lfn", "NSC_ENABLED == True", "False"),
     ("tcp-nsc-zoo", "NSC_ENABLED == True", "False"),
     ("tcp-star-server", "True", "True"),
+    ("tcp-sack-loss --duration=2 --runs=1", "True", "True"),
     ("tcp-variants-comparison", "True", "True"),
 ]
 
@@ -20,6 +20,7 @@
 #include "udp-client-server-helper.h"
 #include "ns3/udp-server.h"
 #include "ns3/udp-client.h"
+#include "ns3/udp-batch-client.h"
 #include "ns3/udp-trace-client.h"
 #include "ns3/uinteger.h"
 #include "ns3/string.h"
@@ -109,6 +110,37 @@ UdpClientHelper::Install (NodeContainer c)
   return apps;
 }
 
+UdpBatchClientHelper::UdpBatchClientHelper ()
+{
+}
+
+UdpBatchClientHelper::UdpBatchClientHelper (Address address, uint16_t port)
+{
+  m_factory.SetTypeId (UdpBatchClient::GetTypeId ());
+  SetAttribute ("RemoteAddress", AddressValue (address));
+  SetAttribute ("RemotePort", UintegerValue (port));
+}
+
+void
+UdpBatchClientHelper::SetAttribute (std::string name, const AttributeValue &value)
+{
+  m_factory.Set (name, value);
+}
+
+ApplicationContainer
+UdpBatchClientHelper::Install (NodeContainer c)
+{
+  ApplicationContainer apps;
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Ptr<Node> node = *i;
+      Ptr<UdpBatchClient> client = m_factory.Create<UdpBatchClient> ();
+      node->AddApplication (client);
+      apps.Add (client);
+    }
+  return apps;
+}
+
 UdpTraceClientHelper::UdpTraceClientHelper ()
 {
 }
@@ -27,6 +27,7 @@
 #include "ns3/ipv4-address.h"
 #include "ns3/udp-server.h"
 #include "ns3/udp-client.h"
+#include "ns3/udp-batch-client.h"
 namespace ns3 {
 /**
  * \ingroup udpclientserver
@@ -149,6 +150,50 @@ public:
 private:
   ObjectFactory m_factory; //!< Object factory.
 };
+/**
+ * \ingroup udpclientserver
+ * \brief Create a client application which sends its UDP packets in
+ *  batches, through Socket::SendMany ().
+ */
+class UdpBatchClientHelper
+{
+public:
+  /**
+   * Create UdpBatchClientHelper which will make life easier for people
+   * trying to set up simulations with udp-client-server.
+   */
+  UdpBatchClientHelper ();
+
+  /**
+   * Create UdpBatchClientHelper which will make life easier for people
+   * trying to set up simulations with udp-client-server.
+   *
+   * \param ip The IP address of the remote UDP server
+   * \param port The port number of the remote UDP server
+   */
+  UdpBatchClientHelper (Address ip, uint16_t port);
+
+  /**
+   * Record an attribute to be set in each Application after it is is created.
+   *
+   * \param name the name of the attribute to set
+   * \param value the value of the attribute to set
+   */
+  void SetAttribute (std::string name, const AttributeValue &value);
+
+  /**
+   * \param c the nodes
+   *
+   * Create one batched UDP client application on each of the input nodes
+   *
+   * \returns the applications created, one application per input node.
+   */
+  ApplicationContainer Install (NodeContainer c);
+
+private:
+  ObjectFactory m_factory; //!< Object factory.
+};
+
 /**
  * \ingroup udpclientserver
  * Create UdpTraceClient application which sends UDP packets based on a trace
@@ -0,0 +1,182 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <algorithm>
+
+#include "ns3/log.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv6-address.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/inet6-socket-address.h"
+#include "ns3/socket.h"
+#include "ns3/simulator.h"
+#include "ns3/socket-factory.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "udp-batch-client.h"
+#include "seq-ts-header.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("UdpBatchClient");
+
+NS_OBJECT_ENSURE_REGISTERED (UdpBatchClient);
+
+TypeId
+UdpBatchClient::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::UdpBatchClient")
+    .SetParent<Application> ()
+    .SetGroupName("Applications")
+    .AddConstructor<UdpBatchClient> ()
+    .AddAttribute ("MaxPackets",
+                   "The maximum number of packets the application will send",
+                   UintegerValue (100),
+                   MakeUintegerAccessor (&UdpBatchClient::m_count),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Interval",
+                   "The mean time between packets: a batch leaves every BatchSize intervals",
+                   TimeValue (Seconds (1.0)),
+                   MakeTimeAccessor (&UdpBatchClient::m_interval),
+                   MakeTimeChecker ())
+    .AddAttribute ("BatchSize",
+                   "The number of packets handed to the socket at once",
+                   UintegerValue (32),
+                   MakeUintegerAccessor (&UdpBatchClient::m_batchSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("RemoteAddress",
+                   "The destination Address of the outbound packets",
+                   AddressValue (),
+                   MakeAddressAccessor (&UdpBatchClient::m_peerAddress),
+                   MakeAddressChecker ())
+    .AddAttribute ("RemotePort", "The destination port of the outbound packets",
+                   UintegerValue (100),
+                   MakeUintegerAccessor (&UdpBatchClient::m_peerPort),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("PacketSize",
+                   "Size of packets generated. The minimum packet size is 12 bytes which is the size of the header carrying the sequence number and the time stamp.",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&UdpBatchClient::m_size),
+                   MakeUintegerChecker<uint32_t> (12,1500))
+  ;
+  return tid;
+}
+
+UdpBatchClient::UdpBatchClient ()
+  : m_sent (0),
+    m_socket (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+UdpBatchClient::~UdpBatchClient ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+UdpBatchClient::SetRemote (Address ip, uint16_t port)
+{
+  NS_LOG_FUNCTION (this << ip << port);
+  m_peerAddress = ip;
+  m_peerPort = port;
+}
+
+uint32_t
+UdpBatchClient::GetSent (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_sent;
+}
+
+void
+UdpBatchClient::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_socket = 0;
+  m_batch.clear ();
+  Application::DoDispose ();
+}
+
+void
+UdpBatchClient::StartApplication (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_socket == 0)
+    {
+      TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
+      m_socket = Socket::CreateSocket (GetNode (), tid);
+      if (Ipv4Address::IsMatchingType (m_peerAddress) == true)
+        {
+          m_socket->Bind ();
+          m_socket->Connect (InetSocketAddress (Ipv4Address::ConvertFrom (m_peerAddress), m_peerPort));
+        }
+      else if (Ipv6Address::IsMatchingType (m_peerAddress) == true)
+        {
+          m_socket->Bind6 ();
+          m_socket->Connect (Inet6SocketAddress (Ipv6Address::ConvertFrom (m_peerAddress), m_peerPort));
+        }
+    }
+
+  m_socket->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
+  m_sendEvent = Simulator::Schedule (Seconds (0.0), &UdpBatchClient::Send, this);
+}
+
+void
+UdpBatchClient::StopApplication (void)
+{
+  NS_LOG_FUNCTION (this);
+  Simulator::Cancel (m_sendEvent);
+}
+
+void
+UdpBatchClient::Send (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_sendEvent.IsExpired ());
+
+  uint32_t n = std::min (m_batchSize, m_count - m_sent);
+  m_batch.clear ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      SeqTsHeader seqTs;
+      seqTs.SetSeq (m_sent + i);
+      Ptr<Packet> p = Create<Packet> (m_size - (8 + 4)); // 8+4 : the size of the seqTs header
+      p->AddHeader (seqTs);
+      m_batch.push_back (p);
+    }
+
+  int sent = m_socket->SendMany (m_batch, 0);
+  if (sent >= 0)
+    {
+      m_sent += sent;
+      NS_LOG_INFO ("TX " << sent << " packets of " << m_size << " bytes at "
+                         << Simulator::Now ().GetSeconds ());
+    }
+  else
+    {
+      NS_LOG_INFO ("Error while sending " << n << " packets of " << m_size << " bytes");
+    }
+
+  if (m_sent < m_count)
+    {
+      m_sendEvent = Simulator::Schedule (m_interval * static_cast<int64_t> (n), &UdpBatchClient::Send, this);
+    }
+}
+
+} // Namespace ns3
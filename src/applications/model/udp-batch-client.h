@@ -0,0 +1,101 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef UDP_BATCH_CLIENT_H
+#define UDP_BATCH_CLIENT_H
+
+#include <vector>
+
+#include "ns3/application.h"
+#include "ns3/event-id.h"
+#include "ns3/ptr.h"
+#include "ns3/address.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+class Socket;
+class Packet;
+
+/**
+ * \ingroup udpclientserver
+ * \class UdpBatchClient
+ * \brief A Udp client sending its packets in batches
+ *
+ * Like UdpClient, the client sends UDP packets carrying a sequence number
+ * and a time stamp in their payloads, that UdpServer counts. Instead of
+ * scheduling one event and calling Socket::Send () for each packet, the
+ * client schedules one event for every BatchSize packets and hands them
+ * to Socket::SendMany (), which shares the route lookup among them: it
+ * sends the same packets as a UdpClient of the same Interval, at a
+ * fraction of the cost, but in bursts of BatchSize packets that carry
+ * the same time stamp.
+ */
+class UdpBatchClient : public Application
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  UdpBatchClient ();
+
+  virtual ~UdpBatchClient ();
+
+  /**
+   * \brief set the remote address and port
+   * \param ip remote IP address
+   * \param port remote port
+   */
+  void SetRemote (Address ip, uint16_t port);
+
+  /**
+   * \return the number of packets sent so far
+   */
+  uint32_t GetSent (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+
+  virtual void StartApplication (void);
+  virtual void StopApplication (void);
+
+  /**
+   * \brief Send a batch of packets
+   */
+  void Send (void);
+
+  uint32_t m_count; //!< Maximum number of packets the application will send
+  Time m_interval; //!< Mean packet inter-send time
+  uint32_t m_size; //!< Size of the sent packet (including the SeqTsHeader)
+  uint32_t m_batchSize; //!< Number of packets sent by each event
+
+  uint32_t m_sent; //!< Counter for sent packets
+  Ptr<Socket> m_socket; //!< Socket
+  Address m_peerAddress; //!< Remote peer address
+  uint16_t m_peerPort; //!< Remote peer port
+  EventId m_sendEvent; //!< Event to send the next batch
+  std::vector<Ptr<Packet> > m_batch; //!< Packets of the batch being sent
+};
+
+} // namespace ns3
+
+#endif /* UDP_BATCH_CLIENT_H */
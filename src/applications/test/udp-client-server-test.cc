@@ -20,6 +20,9 @@
  */
 
 #include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <ctime>
 #include "ns3/log.h"
 #include "ns3/abort.h"
 #include "ns3/config.h"
@@ -30,6 +33,7 @@
 #include "ns3/ipv4-address-helper.h"
 #include "ns3/udp-client-server-helper.h"
 #include "ns3/udp-echo-helper.h"
+#include "ns3/neighbor-cache-helper.h"
 #include "ns3/simple-net-device.h"
 #include "ns3/simple-channel.h"
 #include "ns3/test.h"
@@ -331,6 +335,117 @@ void UdpEchoClientSetFillTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * Two nodes linked by a simple channel, the first one sending UDP
+ * packets to a UdpServer on the second one
+ */
+class UdpBatchNetwork
+{
+public:
+  UdpBatchNetwork ();
+
+  /**
+   * Install a UdpClient, or a UdpBatchClient if batchSize is not zero
+   * \param count the number of packets to send
+   * \param interval the time between packets
+   * \param batchSize the number of packets of a batch
+   * \return the client
+   */
+  Ptr<Application> Install (uint32_t count, Time interval, uint32_t batchSize);
+
+  NodeContainer m_nodes; //!< the client and the server nodes
+  Ipv4InterfaceContainer m_interfaces; //!< the interfaces of the nodes
+  UdpServerHelper m_server; //!< the server
+};
+
+UdpBatchNetwork::UdpBatchNetwork ()
+  : m_server (4000)
+{
+  m_nodes.Create (2);
+  InternetStackHelper internet;
+  internet.Install (m_nodes);
+
+  Ptr<SimpleNetDevice> txDev = CreateObject<SimpleNetDevice> ();
+  Ptr<SimpleNetDevice> rxDev = CreateObject<SimpleNetDevice> ();
+  m_nodes.Get (0)->AddDevice (txDev);
+  m_nodes.Get (1)->AddDevice (rxDev);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  rxDev->SetChannel (channel);
+  txDev->SetChannel (channel);
+  NetDeviceContainer d;
+  d.Add (txDev);
+  d.Add (rxDev);
+
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  m_interfaces = ipv4.Assign (d);
+  // A batch would overflow the ARP pending queue of the first packet
+  NeighborCacheHelper neighbors;
+  neighbors.PopulateNeighborCache (d);
+
+  ApplicationContainer apps = m_server.Install (m_nodes.Get (1));
+  apps.Start (Seconds (1.0));
+}
+
+Ptr<Application>
+UdpBatchNetwork::Install (uint32_t count, Time interval, uint32_t batchSize)
+{
+  ApplicationContainer apps;
+  if (batchSize == 0)
+    {
+      UdpClientHelper client (m_interfaces.GetAddress (1), 4000);
+      client.SetAttribute ("MaxPackets", UintegerValue (count));
+      client.SetAttribute ("Interval", TimeValue (interval));
+      apps = client.Install (m_nodes.Get (0));
+    }
+  else
+    {
+      UdpBatchClientHelper client (m_interfaces.GetAddress (1), 4000);
+      client.SetAttribute ("MaxPackets", UintegerValue (count));
+      client.SetAttribute ("Interval", TimeValue (interval));
+      client.SetAttribute ("BatchSize", UintegerValue (batchSize));
+      apps = client.Install (m_nodes.Get (0));
+    }
+  apps.Start (Seconds (2.0));
+  return apps.Get (0);
+}
+
+/**
+ * Test that all the udp packets generated by an udpBatchClient application
+ * are correctly received by an udpServer application
+ */
+class UdpBatchClientServerTestCase : public TestCase
+{
+public:
+  UdpBatchClientServerTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+UdpBatchClientServerTestCase::UdpBatchClientServerTestCase ()
+  : TestCase ("Test that all the udp packets generated by an udpBatchClient application are correctly received by an udpServer application")
+{
+}
+
+void
+UdpBatchClientServerTestCase::DoRun (void)
+{
+  UdpBatchNetwork network;
+  Ptr<UdpBatchClient> client = DynamicCast<UdpBatchClient> (network.Install (100, MilliSeconds (10), 16));
+
+  // 100 packets in 7 batches, one every 160 ms, the last one leaving at 2.96 s
+  Simulator::Stop (Seconds (2.5));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (client->GetSent (), 64, "Did not send the expected number of batches !");
+  Simulator::Stop (Seconds (1.0));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (client->GetSent (), 100, "Did not send expected number of packets !");
+  NS_TEST_ASSERT_MSG_EQ (network.m_server.GetServer ()->GetLost (), 0, "Packets were lost !");
+  NS_TEST_ASSERT_MSG_EQ (network.m_server.GetServer ()->GetReceived (), 100, "Did not receive expected number of packets !");
+  Simulator::Destroy ();
+}
+
 class UdpClientServerTestSuite : public TestSuite
 {
 public:
@@ -342,8 +457,72 @@ UdpClientServerTestSuite::UdpClientServerTestSuite ()
 {
   AddTestCase (new UdpTraceClientServerTestCase, TestCase::QUICK);
   AddTestCase (new UdpClientServerTestCase, TestCase::QUICK);
+  AddTestCase (new UdpBatchClientServerTestCase, TestCase::QUICK);
   AddTestCase (new PacketLossCounterTestCase, TestCase::QUICK);
   AddTestCase (new UdpEchoClientSetFillTestCase, TestCase::QUICK);
 }
 
 static UdpClientServerTestSuite udpClientServerTestSuite;
+
+/**
+ * Measure the cost of sending UDP packets one at a time and in batches
+ */
+class UdpBatchClientPerfTestCase : public TestCase
+{
+public:
+  UdpBatchClientPerfTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Send packets from a client to a server
+   * \param count the number of packets to send
+   * \param batchSize the number of packets of a batch, 0 for UdpClient
+   */
+  void Measure (uint32_t count, uint32_t batchSize);
+};
+
+UdpBatchClientPerfTestCase::UdpBatchClientPerfTestCase ()
+  : TestCase ("Measure the cost of sending UDP packets in batches")
+{
+}
+
+void
+UdpBatchClientPerfTestCase::Measure (uint32_t count, uint32_t batchSize)
+{
+  UdpBatchNetwork network;
+  network.Install (count, MicroSeconds (10), batchSize);
+  std::clock_t start = std::clock ();
+  Simulator::Run ();
+  double seconds = double (std::clock () - start) / CLOCKS_PER_SEC;
+  NS_TEST_ASSERT_MSG_EQ (network.m_server.GetServer ()->GetReceived (), count, "Did not receive expected number of packets !");
+  std::cout << GetParent ()->GetName () << ": "
+            << (batchSize == 0 ? "UdpClient      " : "UdpBatchClient ")
+            << std::setw (4) << batchSize << " packets/batch "
+            << std::fixed << std::setprecision (3)
+            << std::setw (8) << 1e6 * seconds / count << " us/packet" << std::endl;
+  Simulator::Destroy ();
+}
+
+void
+UdpBatchClientPerfTestCase::DoRun (void)
+{
+  Measure (100000, 0);
+  Measure (100000, 1);
+  Measure (100000, 8);
+  Measure (100000, 32);
+}
+
+class UdpBatchClientPerfTestSuite : public TestSuite
+{
+public:
+  UdpBatchClientPerfTestSuite ();
+};
+
+UdpBatchClientPerfTestSuite::UdpBatchClientPerfTestSuite ()
+  : TestSuite ("udp-batch-client-perf", PERFORMANCE)
+{
+  AddTestCase (new UdpBatchClientPerfTestCase, TestCase::QUICK);
+}
+
+static UdpBatchClientPerfTestSuite udpBatchClientPerfTestSuite;
@@ -28,6 +28,8 @@
 #include "attribute.h"
 #include "attribute-helper.h"
 #include "simple-ref-count.h"
+#include "int-to-type.h"
+#include <cstring>
 #include <typeinfo>
 
 /**
@@ -1084,6 +1086,403 @@ private:
   typename TypeTraits<TX3>::ReferencedType m_a3;  //!< third bound argument
 };
 
+/**
+ * \ingroup callbackimpl
+ * Storage of a Callback which needs no CallbackImpl: a function
+ * pointer, or a raw object pointer and a pointer to member function.
+ * It is copied with the Callback and called directly, without a heap
+ * allocation or a virtual call.
+ */
+struct CallbackInline
+{
+  /** Size of the function storage. */
+  enum { SIZE = 2 * sizeof (void *) };
+  /** Type-erased pointer to the invocation function. */
+  typedef void (*Invoke)(void);
+  /** Function to build the CallbackImpl equivalent to a CallbackInline. */
+  typedef Ptr<CallbackImplBase> (*MakeImpl)(const CallbackInline &data);
+  void *m_object;                       //!< the object pointer
+  void *m_function[2];                  //!< the function or member function pointer
+};
+
+/**
+ * \ingroup callbackimpl
+ * Count the arguments of a Callback: one for each non-empty type.
+ */
+template <typename T>
+struct CallbackArgument
+{
+  /** Value. */  enum { Count = 1 /**< A real argument. */ };
+};
+/**
+ * \ingroup callbackimpl
+ * Count the arguments of a Callback: none for empty.
+ */
+template <>
+struct CallbackArgument<empty>
+{
+  /** Value. */  enum { Count = 0 /**< No argument. */ };
+};
+
+/**
+ * \ingroup callbackimpl
+ * Select the invocation function of an invoker by number of arguments,
+ * so that only the function with the Callback arity is instantiated.
+ * \tparam INVOKER \explicit The invoker class.
+ * \return The type-erased invocation function.
+ * @{
+ */
+template <typename INVOKER>
+CallbackInline::Invoke GetCallbackInvoke (IntToType<0>) {
+  return reinterpret_cast<CallbackInline::Invoke> (&INVOKER::Call0);
+}
+template <typename INVOKER>
+CallbackInline::Invoke GetCallbackInvoke (IntToType<1>) {
+  return reinterpret_cast<CallbackInline::Invoke> (&INVOKER::Call1);
+}
+template <typename INVOKER>
+CallbackInline::Invoke GetCallbackInvoke (IntToType<2>) {
+  return reinterpret_cast<CallbackInline::Invoke> (&INVOKER::Call2);
+}
+template <typename INVOKER>
+CallbackInline::Invoke GetCallbackInvoke (IntToType<3>) {
+  return reinterpret_cast<CallbackInline::Invoke> (&INVOKER::Call3);
+}
+template <typename INVOKER>
+CallbackInline::Invoke GetCallbackInvoke (IntToType<4>) {
+  return reinterpret_cast<CallbackInline::Invoke> (&INVOKER::Call4);
+}
+template <typename INVOKER>
+CallbackInline::Invoke GetCallbackInvoke (IntToType<5>) {
+  return reinterpret_cast<CallbackInline::Invoke> (&INVOKER::Call5);
+}
+template <typename INVOKER>
+CallbackInline::Invoke GetCallbackInvoke (IntToType<6>) {
+  return reinterpret_cast<CallbackInline::Invoke> (&INVOKER::Call6);
+}
+template <typename INVOKER>
+CallbackInline::Invoke GetCallbackInvoke (IntToType<7>) {
+  return reinterpret_cast<CallbackInline::Invoke> (&INVOKER::Call7);
+}
+template <typename INVOKER>
+CallbackInline::Invoke GetCallbackInvoke (IntToType<8>) {
+  return reinterpret_cast<CallbackInline::Invoke> (&INVOKER::Call8);
+}
+template <typename INVOKER>
+CallbackInline::Invoke GetCallbackInvoke (IntToType<9>) {
+  return reinterpret_cast<CallbackInline::Invoke> (&INVOKER::Call9);
+}
+/**@}*/
+
+/**
+ * \ingroup callbackimpl
+ * Invoke functors stored in a CallbackInline.
+ */
+template <typename T, typename R, typename T1, typename T2, typename T3, typename T4,typename T5, typename T6, typename T7, typename T8, typename T9>
+class FunctorCallbackInvoker {
+public:
+  /**
+   * \param [out] data The storage
+   * \param [in] functor The functor
+   */
+  static void Store (CallbackInline &data, T const &functor) {
+    std::memcpy (data.m_function, &functor, sizeof (T));
+  }
+  /**
+   * \param [in] data The stored callback
+   * \return The equivalent CallbackImpl
+   */
+  static Ptr<CallbackImplBase> MakeImpl (const CallbackInline &data) {
+    return Create<FunctorCallbackImpl<T,R,T1,T2,T3,T4,T5,T6,T7,T8,T9> > (Load (data));
+  }
+  /**
+   * Call the stored functor with varying numbers of arguments
+   * @{
+   */
+  /**
+   * \param [in] data The stored callback
+   * \return Callback value
+   */
+  static R Call0 (const CallbackInline &data) {
+    return Load (data) ();
+  }
+  /**
+   * \param [in] data The stored callback
+   * \param [in] a1 First argument
+   * \return Callback value
+   */
+  static R Call1 (const CallbackInline &data, T1 a1) {
+    return Load (data) (a1);
+  }
+  /**
+   * \param [in] data The stored callback
+   * \param [in] a1 First argument
+   * \param [in] a2 Second argument
+   * \return Callback value
+   */
+  static R Call2 (const CallbackInline &data, T1 a1, T2 a2) {
+    return Load (data) (a1,a2);
+  }
+  /**
+   * \param [in] data The stored callback
+   * \param [in] a1 First argument
+   * \param [in] a2 Second argument
+   * \param [in] a3 Third argument
+   * \return Callback value
+   */
+  static R Call3 (const CallbackInline &data, T1 a1, T2 a2, T3 a3) {
+    return Load (data) (a1,a2,a3);
+  }
+  /**
+   * \param [in] data The stored callback
+   * \param [in] a1 First argument
+   * \param [in] a2 Second argument
+   * \param [in] a3 Third argument
+   * \param [in] a4 Fourth argument
+   * \return Callback value
+   */
+  static R Call4 (const CallbackInline &data, T1 a1, T2 a2, T3 a3, T4 a4) {
+    return Load (data) (a1,a2,a3,a4);
+  }
+  /**
+   * \param [in] data The stored callback
+   * \param [in] a1 First argument
+   * \param [in] a2 Second argument
+   * \param [in] a3 Third argument
+   * \param [in] a4 Fourth argument
+   * \param [in] a5 Fifth argument
+   * \return Callback value
+   */
+  static R Call5 (const CallbackInline &data, T1 a1, T2 a2, T3 a3, T4 a4, T5 a5) {
+    return Load (data) (a1,a2,a3,a4,a5);
+  }
+  /**
+   * \param [in] data The stored callback
+   * \param [in] a1 First argument
+   * \param [in] a2 Second argument
+   * \param [in] a3 Third argument
+   * \param [in] a4 Fourth argument
+   * \param [in] a5 Fifth argument
+   * \param [in] a6 Sixth argument
+   * \return Callback value
+   */
+  static R Call6 (const CallbackInline &data, T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6) {
+    return Load (data) (a1,a2,a3,a4,a5,a6);
+  }
+  /**
+   * \param [in] data The stored callback
+   * \param [in] a1 First argument
+   * \param [in] a2 Second argument
+   * \param [in] a3 Third argument
+   * \param [in] a4 Fourth argument
+   * \param [in] a5 Fifth argument
+   * \param [in] a6 Sixth argument
+   * \param [in] a7 Seventh argument
+   * \return Callback value
+   */
+  static R Call7 (const CallbackInline &data, T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7) {
+    return Load (data) (a1,a2,a3,a4,a5,a6,a7);
+  }
+  /**
+   * \param [in] data The stored callback
+   * \param [in] a1 First argument
+   * \param [in] a2 Second argument
+   * \param [in] a3 Third argument
+   * \param [in] a4 Fourth argument
+   * \param [in] a5 Fifth argument
+   * \param [in] a6 Sixth argument
+   * \param [in] a7 Seventh argument
+   * \param [in] a8 Eighth argument
+   * \return Callback value
+   */
+  static R Call8 (const CallbackInline &data, T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7, T8 a8) {
+    return Load (data) (a1,a2,a3,a4,a5,a6,a7,a8);
+  }
+  /**
+   * \param [in] data The stored callback
+   * \param [in] a1 First argument
+   * \param [in] a2 Second argument
+   * \param [in] a3 Third argument
+   * \param [in] a4 Fourth argument
+   * \param [in] a5 Fifth argument
+   * \param [in] a6 Sixth argument
+   * \param [in] a7 Seventh argument
+   * \param [in] a8 Eighth argument
+   * \param [in] a9 Ninth argument
+   * \return Callback value
+   */
+  static R Call9 (const CallbackInline &data, T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7, T8 a8, T9 a9) {
+    return Load (data) (a1,a2,a3,a4,a5,a6,a7,a8,a9);
+  }
+  /**@}*/
+private:
+  /**
+   * \param [in] data The stored callback
+   * \return The functor
+   */
+  static T Load (const CallbackInline &data) {
+    T functor;
+    std::memcpy (&functor, data.m_function, sizeof (T));
+    return functor;
+  }
+};
+
+/**
+ * \ingroup callbackimpl
+ * Invoke raw object pointers and pointers to member functions stored
+ * in a CallbackInline.
+ */
+template <typename OBJ_PTR, typename MEM_PTR, typename R, typename T1, typename T2, typename T3, typename T4, typename T5, typename T6, typename T7, typename T8, typename T9>
+class MemPtrCallbackInvoker {
+public:
+  /**
+   * \param [out] data The storage
+   * \param [in] objPtr The object pointer
+   * \param [in] memPtr The object class member function
+   */
+  static void Store (CallbackInline &data, OBJ_PTR objPtr, MEM_PTR memPtr) {
+    data.m_object = const_cast<void *> (static_cast<const void *> (objPtr));
+    std::memcpy (data.m_function, &memPtr, sizeof (MEM_PTR));
+  }
+  /**
+   * \param [in] data The stored callback
+   * \return The equivalent CallbackImpl
+   */
+  static Ptr<CallbackImplBase> MakeImpl (const CallbackInline &data) {
+    return Create<MemPtrCallbackImpl<OBJ_PTR,MEM_PTR,R,T1,T2,T3,T4,T5,T6,T7,T8,T9> > (static_cast<OBJ_PTR> (data.m_object), Load (data));
+  }
+  /**
+   * Call the stored member function with varying numbers of arguments
+   * @{
+   */
+  /**
+   * \param [in] data The stored callback
+   * \return Callback value
+   */
+  static R Call0 (const CallbackInline &data) {
+    return ((*static_cast<OBJ_PTR> (data.m_object)).*Load (data)) ();
+  }
+  /**
+   * \param [in] data The stored callback
+   * \param [in] a1 First argument
+   * \return Callback value
+   */
+  static R Call1 (const CallbackInline &data, T1 a1) {
+    return ((*static_cast<OBJ_PTR> (data.m_object)).*Load (data)) (a1);
+  }
+  /**
+   * \param [in] data The stored callback
+   * \param [in] a1 First argument
+   * \param [in] a2 Second argument
+   * \return Callback value
+   */
+  static R Call2 (const CallbackInline &data, T1 a1, T2 a2) {
+    return ((*static_cast<OBJ_PTR> (data.m_object)).*Load (data)) (a1,a2);
+  }
+  /**
+   * \param [in] data The stored callback
+   * \param [in] a1 First argument
+   * \param [in] a2 Second argument
+   * \param [in] a3 Third argument
+   * \return Callback value
+   */
+  static R Call3 (const CallbackInline &data, T1 a1, T2 a2, T3 a3) {
+    return ((*static_cast<OBJ_PTR> (data.m_object)).*Load (data)) (a1,a2,a3);
+  }
+  /**
+   * \param [in] data The stored callback
+   * \param [in] a1 First argument
+   * \param [in] a2 Second argument
+   * \param [in] a3 Third argument
+   * \param [in] a4 Fourth argument
+   * \return Callback value
+   */
+  static R Call4 (const CallbackInline &data, T1 a1, T2 a2, T3 a3, T4 a4) {
+    return ((*static_cast<OBJ_PTR> (data.m_object)).*Load (data)) (a1,a2,a3,a4);
+  }
+  /**
+   * \param [in] data The stored callback
+   * \param [in] a1 First argument
+   * \param [in] a2 Second argument
+   * \param [in] a3 Third argument
+   * \param [in] a4 Fourth argument
+   * \param [in] a5 Fifth argument
+   * \return Callback value
+   */
+  static R Call5 (const CallbackInline &data, T1 a1, T2 a2, T3 a3, T4 a4, T5 a5) {
+    return ((*static_cast<OBJ_PTR> (data.m_object)).*Load (data)) (a1,a2,a3,a4,a5);
+  }
+  /**
+   * \param [in] data The stored callback
+   * \param [in] a1 First argument
+   * \param [in] a2 Second argument
+   * \param [in] a3 Third argument
+   * \param [in] a4 Fourth argument
+   * \param [in] a5 Fifth argument
+   * \param [in] a6 Sixth argument
+   * \return Callback value
+   */
+  static R Call6 (const CallbackInline &data, T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6) {
+    return ((*static_cast<OBJ_PTR> (data.m_object)).*Load (data)) (a1,a2,a3,a4,a5,a6);
+  }
+  /**
+   * \param [in] data The stored callback
+   * \param [in] a1 First argument
+   * \param [in] a2 Second argument
+   * \param [in] a3 Third argument
+   * \param [in] a4 Fourth argument
+   * \param [in] a5 Fifth argument
+   * \param [in] a6 Sixth argument
+   * \param [in] a7 Seventh argument
+   * \return Callback value
+   */
+  static R Call7 (const CallbackInline &data, T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7) {
+    return ((*static_cast<OBJ_PTR> (data.m_object)).*Load (data)) (a1,a2,a3,a4,a5,a6,a7);
+  }
+  /**
+   * \param [in] data The stored callback
+   * \param [in] a1 First argument
+   * \param [in] a2 Second argument
+   * \param [in] a3 Third argument
+   * \param [in] a4 Fourth argument
+   * \param [in] a5 Fifth argument
+   * \param [in] a6 Sixth argument
+   * \param [in] a7 Seventh argument
+   * \param [in] a8 Eighth argument
+   * \return Callback value
+   */
+  static R Call8 (const CallbackInline &data, T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7, T8 a8) {
+    return ((*static_cast<OBJ_PTR> (data.m_object)).*Load (data)) (a1,a2,a3,a4,a5,a6,a7,a8);
+  }
+  /**
+   * \param [in] data The stored callback
+   * \param [in] a1 First argument
+   * \param [in] a2 Second argument
+   * \param [in] a3 Third argument
+   * \param [in] a4 Fourth argument
+   * \param [in] a5 Fifth argument
+   * \param [in] a6 Sixth argument
+   * \param [in] a7 Seventh argument
+   * \param [in] a8 Eighth argument
+   * \param [in] a9 Ninth argument
+   * \return Callback value
+   */
+  static R Call9 (const CallbackInline &data, T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7, T8 a8, T9 a9) {
+    return ((*static_cast<OBJ_PTR> (data.m_object)).*Load (data)) (a1,a2,a3,a4,a5,a6,a7,a8,a9);
+  }
+  /**@}*/
+private:
+  /**
+   * \param [in] data The stored callback
+   * \return The member function pointer
+   */
+  static MEM_PTR Load (const CallbackInline &data) {
+    MEM_PTR memPtr;
+    std::memcpy (&memPtr, data.m_function, sizeof (MEM_PTR));
+    return memPtr;
+  }
+};
+
 /**
  * \ingroup callbackimpl
  * Base class for Callback class.
@@ -1091,16 +1490,38 @@ private:
  */
 class CallbackBase {
 public:
-  CallbackBase () : m_impl () {}
-  /** \return The impl pointer */
-  Ptr<CallbackImplBase> GetImpl (void) const { return m_impl; }
+  CallbackBase () : m_impl (), m_inline (), m_invoke (0), m_makeImpl (0) {}
+  /**
+   * \return The impl pointer
+   *
+   * Callbacks stored inline build their impl on the first call.
+   */
+  Ptr<CallbackImplBase> GetImpl (void) const {
+    if (m_impl == 0 && m_makeImpl != 0)
+      {
+        m_impl = m_makeImpl (m_inline);
+      }
+    return m_impl;
+  }
 protected:
   /**
    * Construct from a pimpl
    * \param [in] impl The CallbackImplBase Ptr
    */
-  CallbackBase (Ptr<CallbackImplBase> impl) : m_impl (impl) {}
-  Ptr<CallbackImplBase> m_impl;         //!< the pimpl
+  CallbackBase (Ptr<CallbackImplBase> impl) : m_impl (impl), m_inline (), m_invoke (0), m_makeImpl (0) {}
+  /**
+   * Copy the inline storage of another callback.
+   * \param [in] other The callback to copy from
+   */
+  void CopyInline (const CallbackBase &other) {
+    m_inline = other.m_inline;
+    m_invoke = other.m_invoke;
+    m_makeImpl = other.m_makeImpl;
+  }
+  mutable Ptr<CallbackImplBase> m_impl; //!< the pimpl
+  CallbackInline m_inline;              //!< the inline callback, if m_invoke is set
+  CallbackInline::Invoke m_invoke;      //!< the inline invocation function, or 0
+  CallbackInline::MakeImpl m_makeImpl;  //!< builds m_impl from m_inline
 };
 
 /**
@@ -1145,6 +1566,11 @@ protected:
  *     member functions.
  *   - a reference list implementation to implement the Callback's
  *     value semantics.
+ *   - function pointers, and pointers to member functions bound to
+ *     raw object pointers, are stored inline in the Callback instead:
+ *     binding them allocates nothing and calling them goes through
+ *     a single function pointer, not a virtual call on the pimpl.
+ *     The equivalent pimpl is built on demand by GetImpl().
  *
  * This code most notably departs from the alexandrescu 
  * implementation in that it does not use type lists to specify
@@ -1176,8 +1602,11 @@ public:
    */
   template <typename FUNCTOR>
   Callback (FUNCTOR const &functor, bool, bool) 
-    : CallbackBase (Create<FunctorCallbackImpl<FUNCTOR,R,T1,T2,T3,T4,T5,T6,T7,T8,T9> > (functor))
-  {}
+  {
+    // function pointers are stored inline
+    DoInitFunctor (functor, IntToType<(TypeTraits<FUNCTOR>::IsPointer
+                                       && sizeof (FUNCTOR) <= CallbackInline::SIZE) ? 1 : 0> ());
+  }
 
   /**
    * Construct a member function pointer call back.
@@ -1187,8 +1616,11 @@ public:
    */
   template <typename OBJ_PTR, typename MEM_PTR>
   Callback (OBJ_PTR const &objPtr, MEM_PTR memPtr)
-    : CallbackBase (Create<MemPtrCallbackImpl<OBJ_PTR,MEM_PTR,R,T1,T2,T3,T4,T5,T6,T7,T8,T9> > (objPtr, memPtr))
-  {}
+  {
+    // raw object pointers are stored inline, Ptr<> need the impl
+    DoInitMemPtr (objPtr, memPtr, IntToType<(TypeTraits<OBJ_PTR>::IsPointer
+                                             && sizeof (MEM_PTR) <= CallbackInline::SIZE) ? 1 : 0> ());
+  }
 
   /**
    * Construct from a CallbackImpl pointer
@@ -1256,11 +1688,13 @@ public:
    * \return \c true if I don't have an implementation
    */
   bool IsNull (void) const {
-    return (DoPeekImpl () == 0) ? true : false;
+    return (m_invoke == 0 && DoPeekImpl () == 0) ? true : false;
   }
   /** Discard the implementation, set it to null */
   void Nullify (void) {
     m_impl = 0;
+    m_invoke = 0;
+    m_makeImpl = 0;
   }
 
   /**
@@ -1269,6 +1703,10 @@ public:
    */
   /** \return Callback value */
   R operator() (void) const {
+    if (m_invoke != 0)
+      {
+        return reinterpret_cast<R (*)(const CallbackInline &)> (m_invoke) (m_inline);
+      }
     return (*(DoPeekImpl ()))();
   }
   /**
@@ -1276,6 +1714,10 @@ public:
    * \return Callback value
    */
   R operator() (T1 a1) const {
+    if (m_invoke != 0)
+      {
+        return reinterpret_cast<R (*)(const CallbackInline &, T1)> (m_invoke) (m_inline, a1);
+      }
     return (*(DoPeekImpl ()))(a1);
   }
   /**
@@ -1284,6 +1726,10 @@ public:
    * \return Callback value
    */
   R operator() (T1 a1, T2 a2) const {
+    if (m_invoke != 0)
+      {
+        return reinterpret_cast<R (*)(const CallbackInline &, T1, T2)> (m_invoke) (m_inline, a1, a2);
+      }
     return (*(DoPeekImpl ()))(a1,a2);
   }
   /**
@@ -1293,6 +1739,10 @@ public:
    * \return Callback value
    */
   R operator() (T1 a1, T2 a2, T3 a3) const {
+    if (m_invoke != 0)
+      {
+        return reinterpret_cast<R (*)(const CallbackInline &, T1, T2, T3)> (m_invoke) (m_inline, a1, a2, a3);
+      }
     return (*(DoPeekImpl ()))(a1,a2,a3);
   }
   /**
@@ -1303,6 +1753,10 @@ public:
    * \return Callback value
    */
   R operator() (T1 a1, T2 a2, T3 a3, T4 a4) const {
+    if (m_invoke != 0)
+      {
+        return reinterpret_cast<R (*)(const CallbackInline &, T1, T2, T3, T4)> (m_invoke) (m_inline, a1, a2, a3, a4);
+      }
     return (*(DoPeekImpl ()))(a1,a2,a3,a4);
   }
   /**
@@ -1314,6 +1768,10 @@ public:
    * \return Callback value
    */
   R operator() (T1 a1, T2 a2, T3 a3, T4 a4,T5 a5) const {
+    if (m_invoke != 0)
+      {
+        return reinterpret_cast<R (*)(const CallbackInline &, T1, T2, T3, T4, T5)> (m_invoke) (m_inline, a1, a2, a3, a4, a5);
+      }
     return (*(DoPeekImpl ()))(a1,a2,a3,a4,a5);
   }
   /**
@@ -1326,6 +1784,10 @@ public:
    * \return Callback value
    */
   R operator() (T1 a1, T2 a2, T3 a3, T4 a4,T5 a5,T6 a6) const {
+    if (m_invoke != 0)
+      {
+        return reinterpret_cast<R (*)(const CallbackInline &, T1, T2, T3, T4, T5, T6)> (m_invoke) (m_inline, a1, a2, a3, a4, a5, a6);
+      }
     return (*(DoPeekImpl ()))(a1,a2,a3,a4,a5,a6);
   }
   /**
@@ -1339,6 +1801,10 @@ public:
    * \return Callback value
    */
   R operator() (T1 a1, T2 a2, T3 a3, T4 a4,T5 a5,T6 a6,T7 a7) const {
+    if (m_invoke != 0)
+      {
+        return reinterpret_cast<R (*)(const CallbackInline &, T1, T2, T3, T4, T5, T6, T7)> (m_invoke) (m_inline, a1, a2, a3, a4, a5, a6, a7);
+      }
     return (*(DoPeekImpl ()))(a1,a2,a3,a4,a5,a6,a7);
   }
   /**
@@ -1353,6 +1819,10 @@ public:
    * \return Callback value
    */
   R operator() (T1 a1, T2 a2, T3 a3, T4 a4,T5 a5,T6 a6,T7 a7,T8 a8) const {
+    if (m_invoke != 0)
+      {
+        return reinterpret_cast<R (*)(const CallbackInline &, T1, T2, T3, T4, T5, T6, T7, T8)> (m_invoke) (m_inline, a1, a2, a3, a4, a5, a6, a7, a8);
+      }
     return (*(DoPeekImpl ()))(a1,a2,a3,a4,a5,a6,a7,a8);
   }
   /**
@@ -1368,6 +1838,10 @@ public:
    * \return Callback value
    */
   R operator() (T1 a1, T2 a2, T3 a3, T4 a4,T5 a5,T6 a6,T7 a7,T8 a8, T9 a9) const {
+    if (m_invoke != 0)
+      {
+        return reinterpret_cast<R (*)(const CallbackInline &, T1, T2, T3, T4, T5, T6, T7, T8, T9)> (m_invoke) (m_inline, a1, a2, a3, a4, a5, a6, a7, a8, a9);
+      }
     return (*(DoPeekImpl ()))(a1,a2,a3,a4,a5,a6,a7,a8,a9);
   }
   /**@}*/
@@ -1379,7 +1853,7 @@ public:
    * \return \c true if we are equal
    */
   bool IsEqual (const CallbackBase &other) const {
-    return m_impl->IsEqual (other.GetImpl ());
+    return GetImpl ()->IsEqual (other.GetImpl ());
   }
 
   /**
@@ -1397,9 +1871,61 @@ public:
    * \param [in] other Callback
    */
   bool Assign (const CallbackBase &other) {
-    return DoAssign (other.GetImpl ());
+    if (!DoAssign (other.GetImpl ()))
+      {
+        return false;
+      }
+    // the types match, so does the inline invocation function
+    CopyInline (other);
+    return true;
   }
 private:
+  /** Number of arguments. */
+  enum { ARITY = CallbackArgument<T1>::Count + CallbackArgument<T2>::Count
+         + CallbackArgument<T3>::Count + CallbackArgument<T4>::Count
+         + CallbackArgument<T5>::Count + CallbackArgument<T6>::Count
+         + CallbackArgument<T7>::Count + CallbackArgument<T8>::Count
+         + CallbackArgument<T9>::Count };
+  /**
+   * Store a functor in a FunctorCallbackImpl.
+   * \param [in] functor The functor
+   */
+  template <typename FUNCTOR>
+  void DoInitFunctor (FUNCTOR const &functor, IntToType<0>) {
+    m_impl = Create<FunctorCallbackImpl<FUNCTOR,R,T1,T2,T3,T4,T5,T6,T7,T8,T9> > (functor);
+  }
+  /**
+   * Store a function pointer inline.
+   * \param [in] functor The function pointer
+   */
+  template <typename FUNCTOR>
+  void DoInitFunctor (FUNCTOR const &functor, IntToType<1>) {
+    typedef FunctorCallbackInvoker<FUNCTOR,R,T1,T2,T3,T4,T5,T6,T7,T8,T9> Invoker;
+    Invoker::Store (m_inline, functor);
+    m_invoke = GetCallbackInvoke<Invoker> (IntToType<ARITY> ());
+    m_makeImpl = &Invoker::MakeImpl;
+  }
+  /**
+   * Store an object and a member function in a MemPtrCallbackImpl.
+   * \param [in] objPtr Pointer to the object
+   * \param [in] memPtr Pointer to the member function
+   */
+  template <typename OBJ_PTR, typename MEM_PTR>
+  void DoInitMemPtr (OBJ_PTR const &objPtr, MEM_PTR memPtr, IntToType<0>) {
+    m_impl = Create<MemPtrCallbackImpl<OBJ_PTR,MEM_PTR,R,T1,T2,T3,T4,T5,T6,T7,T8,T9> > (objPtr, memPtr);
+  }
+  /**
+   * Store a raw object pointer and a member function inline.
+   * \param [in] objPtr Pointer to the object
+   * \param [in] memPtr Pointer to the member function
+   */
+  template <typename OBJ_PTR, typename MEM_PTR>
+  void DoInitMemPtr (OBJ_PTR const &objPtr, MEM_PTR memPtr, IntToType<1>) {
+    typedef MemPtrCallbackInvoker<OBJ_PTR,MEM_PTR,R,T1,T2,T3,T4,T5,T6,T7,T8,T9> Invoker;
+    Invoker::Store (m_inline, objPtr, memPtr);
+    m_invoke = GetCallbackInvoke<Invoker> (IntToType<ARITY> ());
+    m_makeImpl = &Invoker::MakeImpl;
+  }
   /** \return The pimpl pointer */
   CallbackImpl<R,T1,T2,T3,T4,T5,T6,T7,T8,T9> *DoPeekImpl (void) const {
     return static_cast<CallbackImpl<R,T1,T2,T3,T4,T5,T6,T7,T8,T9> *> (PeekPointer (m_impl));
@@ -26,6 +26,9 @@
 #include "pointer.h"
 #include "log.h"
 
+#include <cstdio>
+#include <map>
+#include <set>
 #include <sstream>
 
 /**
@@ -156,6 +159,9 @@ public:
   /**
    * Construct from a Config path specification.
    *
+   * The specification is parsed once, here, into a list of index
+   * ranges; Matches() only compares integers.
+   *
    * \param [in] element The Config path specification.
    */
   ArrayMatcher (std::string element);
@@ -167,6 +173,12 @@ public:
    */
   bool Matches (uint32_t i) const;
 private:
+  /**
+   * Parse a Config path specification, or one of its alternatives.
+   *
+   * \param [in] element The Config path specification.
+   */
+  void Parse (std::string element);
   /**
    * Convert a string to an \c uint32_t.
    *
@@ -175,76 +187,87 @@ private:
    * \returns \c true if the string could be converted.
    */
   bool StringToUint32 (std::string str, uint32_t *value) const;
+
+  /** An inclusive range of matching indices. */
+  struct Range
+  {
+    uint32_t min;  //!< The first matching index.
+    uint32_t max;  //!< The last matching index.
+  };
   /** The Config path element. */
   std::string m_element;
+  /** Whether any index matches. */
+  bool m_any;
+  /** The ranges of matching indices. */
+  std::vector<Range> m_ranges;
 };
 
 
 ArrayMatcher::ArrayMatcher (std::string element)
-  : m_element (element)
+  : m_element (element),
+    m_any (false)
 {
   NS_LOG_FUNCTION (this << element);
+  Parse (element);
 }
-bool
-ArrayMatcher::Matches (uint32_t i) const
+void
+ArrayMatcher::Parse (std::string element)
 {
-  NS_LOG_FUNCTION (this << i);
-  if (m_element == "*")
+  NS_LOG_FUNCTION (this << element);
+  if (element == "*")
     {
-      NS_LOG_DEBUG ("Array "<<i<<" matches *");
-      return true;
+      m_any = true;
+      return;
     }
   std::string::size_type tmp;
-  tmp = m_element.find ("|");
+  tmp = element.find ("|");
   if (tmp != std::string::npos)
     {
-      std::string left = m_element.substr (0, tmp-0);
-      std::string right = m_element.substr (tmp+1, m_element.size () - (tmp + 1));
-      ArrayMatcher matcher = ArrayMatcher (left);
-      if (matcher.Matches (i))
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<left);
-          return true;
-        }
-      matcher = ArrayMatcher (right);
-      if (matcher.Matches (i))
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<right);
-          return true;
-        }
-      NS_LOG_DEBUG ("Array "<<i<<" does not match "<<m_element);
-      return false;
+      std::string left = element.substr (0, tmp-0);
+      std::string right = element.substr (tmp+1, element.size () - (tmp + 1));
+      Parse (left);
+      Parse (right);
+      return;
     }
-  std::string::size_type leftBracket = m_element.find ("[");
-  std::string::size_type rightBracket = m_element.find ("]");
-  std::string::size_type dash = m_element.find ("-");
-  if (leftBracket == 0 && rightBracket == m_element.size () - 1 &&
+  std::string::size_type leftBracket = element.find ("[");
+  std::string::size_type rightBracket = element.find ("]");
+  std::string::size_type dash = element.find ("-");
+  Range range;
+  if (leftBracket == 0 && rightBracket == element.size () - 1 &&
       dash > leftBracket && dash < rightBracket)
     {
-      std::string lowerBound = m_element.substr (leftBracket + 1, dash - (leftBracket + 1));
-      std::string upperBound = m_element.substr (dash + 1, rightBracket - (dash + 1));
-      uint32_t min;
-      uint32_t max;
-      if (StringToUint32 (lowerBound, &min) && 
-          StringToUint32 (upperBound, &max) &&
-          i >= min && i <= max)
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
-          return true;
-        }
-      else
+      std::string lowerBound = element.substr (leftBracket + 1, dash - (leftBracket + 1));
+      std::string upperBound = element.substr (dash + 1, rightBracket - (dash + 1));
+      if (StringToUint32 (lowerBound, &range.min) && 
+          StringToUint32 (upperBound, &range.max))
         {
-          NS_LOG_DEBUG ("Array "<<i<<" does not "<<m_element);
-          return false;
+          m_ranges.push_back (range);
         }
+      return;
+    }
+  if (StringToUint32 (element, &range.min))
+    {
+      range.max = range.min;
+      m_ranges.push_back (range);
     }
-  uint32_t value;
-  if (StringToUint32 (m_element, &value) &&
-      i == value)
+}
+bool
+ArrayMatcher::Matches (uint32_t i) const
+{
+  NS_LOG_FUNCTION (this << i);
+  if (m_any)
     {
-      NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
+      NS_LOG_DEBUG ("Array "<<i<<" matches *");
       return true;
     }
+  for (std::vector<Range>::const_iterator j = m_ranges.begin (); j != m_ranges.end (); ++j)
+    {
+      if (i >= j->min && i <= j->max)
+        {
+          NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
+          return true;
+        }
+    }
   NS_LOG_DEBUG ("Array "<<i<<" does not match "<<m_element);
   return false;
 }
@@ -260,22 +283,285 @@ ArrayMatcher::StringToUint32 (std::string str, uint32_t *value) const
 }
 
 /**
- * Abstract class to parse Config paths into object references.
+ * One element of a compiled Config path.
+ *
+ * Everything which does not depend on the objects matched is computed
+ * once: the kind of element, the index matcher, the TypeId of a
+ * \c $ element and, per TypeId, the object attributes the element
+ * designates.
+ */
+class PathElement
+{
+public:
+  /** An object attribute designated by a path element. */
+  struct Attribute
+  {
+    std::string name;                       //!< The attribute name.
+    Ptr<const AttributeAccessor> accessor;  //!< The accessor ObjectBase::GetAttribute() would use.
+    bool gettable;                          //!< Whether the accessor can be used directly.
+    bool isContainer;                       //!< Object container, rather than pointer.
+  };
+  /** The attributes designated by an element on a TypeId. */
+  typedef std::vector<Attribute> Attributes;
+
+  /**
+   * Construct from a Config path item.
+   *
+   * \param [in] item The text between two slashes.
+   */
+  PathElement (std::string item);
+  /** \returns The text of this element. */
+  std::string GetItem (void) const;
+  /** \returns \c true if this element opens the "/Names" namespace. */
+  bool IsNames (void) const;
+  /** \returns \c true if this element is a \c $ (GetObject) element. */
+  bool IsGetObject (void) const;
+  /** \returns The TypeId of a \c $ element. */
+  TypeId GetObjectTypeId (void) const;
+  /** \returns The matcher for an index element. */
+  const ArrayMatcher & GetMatcher (void) const;
+  /**
+   * Get the pointer and object container attributes this element
+   * designates on objects of a given TypeId.
+   *
+   * \param [in] tid The instance TypeId of the object.
+   * \returns The attributes, in the order the TypeId hierarchy lists them.
+   */
+  const Attributes & GetAttributes (TypeId tid) const;
+
+private:
+  std::string m_item;            //!< The element text.
+  bool m_isNames;                //!< Opens the "/Names" namespace.
+  bool m_isGetObject;            //!< Is a \c $ element.
+  ArrayMatcher m_matcher;        //!< The index matcher.
+  mutable bool m_tidValid;       //!< Whether m_tid was looked up.
+  mutable TypeId m_tid;          //!< The TypeId of a \c $ element.
+  /** The attributes designated, indexed by TypeId uid. */
+  mutable std::map<uint16_t, Attributes> m_attributes;
+};
+
+PathElement::PathElement (std::string item)
+  : m_item (item),
+    m_isNames (item.compare (0, 5, "Names") == 0),
+    m_isGetObject (item.find ("$") == 0),
+    m_matcher (item),
+    m_tidValid (false)
+{
+  NS_LOG_FUNCTION (this << item);
+}
+std::string
+PathElement::GetItem (void) const
+{
+  return m_item;
+}
+bool
+PathElement::IsNames (void) const
+{
+  return m_isNames;
+}
+bool
+PathElement::IsGetObject (void) const
+{
+  return m_isGetObject;
+}
+TypeId
+PathElement::GetObjectTypeId (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_isGetObject);
+  if (!m_tidValid)
+    {
+      m_tid = TypeId::LookupByName (m_item.substr (1, m_item.size () - 1));
+      m_tidValid = true;
+    }
+  return m_tid;
+}
+const ArrayMatcher &
+PathElement::GetMatcher (void) const
+{
+  return m_matcher;
+}
+const PathElement::Attributes &
+PathElement::GetAttributes (TypeId tid) const
+{
+  NS_LOG_FUNCTION (this << tid);
+  std::map<uint16_t, Attributes>::const_iterator found = m_attributes.find (tid.GetUid ());
+  if (found != m_attributes.end ())
+    {
+      return found->second;
+    }
+  Attributes &attributes = m_attributes[tid.GetUid ()];
+  TypeId current;
+  TypeId next = tid;
+  do
+    {
+      current = next;
+      for (uint32_t i = 0; i < current.GetAttributeN (); i++)
+        {
+          struct TypeId::AttributeInformation info = current.GetAttribute (i);
+          if (info.name != m_item && m_item != "*")
+            {
+              continue;
+            }
+          Attribute attribute;
+          if (dynamic_cast<const PointerChecker *> (PeekPointer (info.checker)) != 0)
+            {
+              attribute.isContainer = false;
+            }
+          else if (dynamic_cast<const ObjectPtrContainerChecker *> (PeekPointer (info.checker)) != 0)
+            {
+              attribute.isContainer = true;
+            }
+          else
+            {
+              // this could be anything else and we don't know what to do with it.
+              // So, we just ignore it.
+              continue;
+            }
+          // Getting the attribute by name resolves to the most derived
+          // attribute of that name: remember that one.
+          struct TypeId::AttributeInformation actual;
+          tid.LookupAttributeByName (info.name, &actual);
+          attribute.name = info.name;
+          attribute.accessor = actual.accessor;
+          attribute.gettable = (actual.flags & TypeId::ATTR_GET) && actual.accessor->HasGetter ();
+          attributes.push_back (attribute);
+        }
+      next = current.GetParent ();
+    } while (next != current);
+  return attributes;
+}
+
+/**
+ * A tree of compiled Config paths.
+ *
+ * The paths added to a tree share the nodes of their common leading
+ * elements, so a resolver walks the objects matched by a common prefix
+ * once for all of them.
+ */
+class PathTree
+{
+public:
+  /** A node of the tree: a path element and the elements which follow it. */
+  struct Node
+  {
+    /**
+     * Constructor.
+     * \param [in] item The path element text.
+     */
+    Node (std::string item);
+    /** Destructor. */
+    ~Node ();
+    PathElement element;              //!< The element leading to this node.
+    std::vector<Node *> children;     //!< The nodes which follow.
+    std::vector<uint32_t> terminals;  //!< The ids of the paths ending here.
+  };
+
+  /** Constructor. */
+  PathTree ();
+  /**
+   * Add a path to the tree.
+   *
+   * \param [in] path The Config path to the matched objects.
+   * \param [in] terminal The id reported when the path matches.
+   */
+  void Add (std::string path, uint32_t terminal);
+  /** \returns The root of the tree, which matches the empty path. */
+  const Node * GetRoot (void) const;
+
+private:
+  /** Copy constructor: not implemented. */
+  PathTree (const PathTree &);
+  /**
+   * Assignment: not implemented.
+   * \returns The tree.
+   */
+  PathTree & operator = (const PathTree &);
+
+  Node m_root;  //!< The root of the tree.
+};
+
+PathTree::Node::Node (std::string item)
+  : element (item)
+{
+}
+PathTree::Node::~Node ()
+{
+  for (std::vector<Node *>::iterator i = children.begin (); i != children.end (); ++i)
+    {
+      delete *i;
+    }
+}
+
+PathTree::PathTree ()
+  : m_root ("")
+{
+  NS_LOG_FUNCTION (this);
+}
+void
+PathTree::Add (std::string path, uint32_t terminal)
+{
+  NS_LOG_FUNCTION (this << path << terminal);
+
+  // ensure that we start and end with a '/'
+  if (path.find ("/") != 0)
+    {
+      path = "/" + path;
+    }
+  if (path.find_last_of ("/") != path.size () - 1)
+    {
+      path = path + "/";
+    }
+
+  Node *node = &m_root;
+  std::string::size_type start = 0;
+  std::string::size_type next;
+  while ((next = path.find ("/", start + 1)) != std::string::npos)
+    {
+      std::string item = path.substr (start + 1, next - (start + 1));
+      start = next;
+      Node *child = 0;
+      for (std::vector<Node *>::const_iterator i = node->children.begin ();
+           i != node->children.end (); ++i)
+        {
+          if ((*i)->element.GetItem () == item)
+            {
+              child = *i;
+              break;
+            }
+        }
+      if (child == 0)
+        {
+          child = new Node (item);
+          node->children.push_back (child);
+        }
+      node = child;
+    }
+  node->terminals.push_back (terminal);
+}
+const PathTree::Node *
+PathTree::GetRoot (void) const
+{
+  return &m_root;
+}
+
+/**
+ * Abstract class to resolve compiled Config paths into object references.
  */
 class Resolver
 {
 public:
   /**
-   * Construct from a base Config path.
+   * Construct from a tree of compiled Config paths.
    *
-   * \param [in] path The Config path.
+   * \param [in] tree The Config paths.
    */
-  Resolver (std::string path);
+  Resolver (const PathTree &tree);
   /** Destructor. */
   virtual ~Resolver ();
 
   /**
-   * Parse the stored Config path into an object reference,
+   * Resolve the Config paths into object references,
    * beginning at the indicated root object.
    *
    * \param [in] root The object corresponding to the current position in
@@ -283,86 +569,91 @@ public:
    */
   void Resolve (Ptr<Object> root);
   
+protected:
+  /**
+   * Get the current Config path.
+   *
+   * \returns The current Config path.
+   */
+  std::string GetResolvedPath (void) const;
+
 private:
-  /** Ensure the Config path starts and ends with a '/'. */
-  void Canonicalize (void);
   /**
-   * Parse the next element in the Config path.
+   * Report the paths ending at a node, and resolve the elements which
+   * follow it.
    *
-   * \param [in] path The remaining portion of the Config path.
+   * \param [in] node The node matched by \p root.
    * \param [in] root The object corresponding to the current positon
    *                  in the Config path.
    */
-  void DoResolve (std::string path, Ptr<Object> root);
+  void DoResolve (const PathTree::Node *node, Ptr<Object> root);
   /**
-   * Parse an index on the Config path.
+   * Resolve one element of the Config path.
    *
-   * \param [in] path The remaining Config path.
-   * \param [in,out] vector The resulting list of matching objects.
+   * \param [in] node The node of the element to resolve.
+   * \param [in] root The object corresponding to the current positon
+   *                  in the Config path.
    */
-  void DoArrayResolve (std::string path, const ObjectPtrContainerValue &vector);
+  void DoResolveElement (const PathTree::Node *node, Ptr<Object> root);
   /**
-   * Handle one object found on the path.
+   * Resolve the indices which follow an object container attribute.
    *
-   * \param [in] object The current object on the Config path.
+   * \param [in] node The node of the container attribute.
+   * \param [in] container The object container.
    */
-  void DoResolveOne (Ptr<Object> object);
+  void DoArrayResolve (const PathTree::Node *node, const ObjectPtrContainerValue &container);
   /**
-   * Get the current Config path.
+   * Get the value of a pointer or object container attribute.
    *
-   * \returns The current Config path.
+   * \param [in] object The object holding the attribute.
+   * \param [in] attribute The attribute.
+   * \param [out] value The attribute value.
    */
-  std::string GetResolvedPath (void) const;
+  void GetValue (Ptr<Object> object, const PathElement::Attribute &attribute,
+                 AttributeValue &value) const;
+  /**
+   * Decide whether to resolve the rest of the paths below an entry of
+   * an object container.
+   *
+   * The Config path of the entry is available from GetResolvedPath().
+   *
+   * \param [in] node The node of the index element matching the entry.
+   * \param [in] object The object in the container.
+   * \returns \c true to resolve the paths below \p object.
+   */
+  virtual bool DoEnter (const PathTree::Node *node, Ptr<Object> object);
   /**
    * Handle one found object.
    *
+   * The matching Config path context is available from GetResolvedPath().
+   *
    * \param [in] object The found object.
-   * \param [in] path The matching Config path context.
+   * \param [in] terminal The id of the matching path.
    */
-  virtual void DoOne (Ptr<Object> object, std::string path) = 0;
+  virtual void DoOne (Ptr<Object> object, uint32_t terminal) = 0;
 
   /** Current list of path tokens. */
   std::vector<std::string> m_workStack;
-  /** The Config path. */
-  std::string m_path;
+  /** The Config paths. */
+  const PathTree &m_tree;
 };
 
-Resolver::Resolver (std::string path)
-  : m_path (path)
+Resolver::Resolver (const PathTree &tree)
+  : m_tree (tree)
 {
-  NS_LOG_FUNCTION (this << path);
-  Canonicalize ();
+  NS_LOG_FUNCTION (this << &tree);
 }
 Resolver::~Resolver ()
 {
   NS_LOG_FUNCTION (this);
 }
-void
-Resolver::Canonicalize (void)
-{
-  NS_LOG_FUNCTION (this);
-
-  // ensure that we start and end with a '/'
-  std::string::size_type tmp = m_path.find ("/");
-  if (tmp != 0)
-    {
-      // no slash at start
-      m_path = "/" + m_path;
-    }
-  tmp = m_path.find_last_of ("/");
-  if (tmp != (m_path.size () - 1))
-    {
-      // no slash at end
-      m_path = m_path + "/";
-    }
-}
 
 void 
 Resolver::Resolve (Ptr<Object> root)
 {
   NS_LOG_FUNCTION (this << root);
 
-  DoResolve (m_path, root);
+  DoResolve (m_tree.GetRoot (), root);
 }
 
 std::string
@@ -378,40 +669,58 @@ Resolver::GetResolvedPath (void) const
   return fullPath;
 }
 
-void 
-Resolver::DoResolveOne (Ptr<Object> object)
+void
+Resolver::GetValue (Ptr<Object> object, const PathElement::Attribute &attribute,
+                    AttributeValue &value) const
 {
-  NS_LOG_FUNCTION (this << object);
+  if (attribute.gettable && attribute.accessor->Get (PeekPointer (object), value))
+    {
+      return;
+    }
+  // Let ObjectBase report the error, or convert the value.
+  object->GetAttribute (attribute.name, value);
+}
 
-  NS_LOG_DEBUG ("resolved="<<GetResolvedPath ());
-  DoOne (object, GetResolvedPath ());
+bool
+Resolver::DoEnter (const PathTree::Node *node, Ptr<Object> object)
+{
+  return true;
 }
 
 void
-Resolver::DoResolve (std::string path, Ptr<Object> root)
-{
-  NS_LOG_FUNCTION (this << path << root);
-  NS_ASSERT ((path.find ("/")) == 0);
-  std::string::size_type next = path.find ("/", 1);
-
-  if (next == std::string::npos)
-    {
-      //
-      // If root is zero, we're beginning to see if we can use the object name 
-      // service to resolve this path.  It is impossible to have a object name 
-      // associated with the root of the object name service since that root
-      // is not an object.  This path must be referring to something in another
-      // namespace and it will have been found already since the name service
-      // is always consulted last.
-      // 
-      if (root)
+Resolver::DoResolve (const PathTree::Node *node, Ptr<Object> root)
+{
+  NS_LOG_FUNCTION (this << node << root);
+
+  //
+  // If root is zero, we're beginning to see if we can use the object name 
+  // service to resolve this path.  It is impossible to have a object name 
+  // associated with the root of the object name service since that root
+  // is not an object.  This path must be referring to something in another
+  // namespace and it will have been found already since the name service
+  // is always consulted last.
+  // 
+  if (root && !node->terminals.empty ())
+    {
+      NS_LOG_DEBUG ("resolved="<<GetResolvedPath ());
+      for (std::vector<uint32_t>::const_iterator i = node->terminals.begin ();
+           i != node->terminals.end (); ++i)
         {
-          DoResolveOne (root);
+          DoOne (root, *i);
         }
-      return;
     }
-  std::string item = path.substr (1, next-1);
-  std::string pathLeft = path.substr (next, path.size ()-next);
+  for (std::vector<PathTree::Node *>::const_iterator i = node->children.begin ();
+       i != node->children.end (); ++i)
+    {
+      DoResolveElement (*i, root);
+    }
+}
+
+void
+Resolver::DoResolveElement (const PathTree::Node *node, Ptr<Object> root)
+{
+  NS_LOG_FUNCTION (this << node << root);
+  const PathElement &element = node->element;
 
   //
   // If root is zero, we're beginning to see if we can use the object name 
@@ -420,16 +729,12 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
   // the root of the "/Names" namespace, so we just ignore it and move on to 
   // the next segment.
   //
-  if (root == 0)
+  if (root == 0 && element.IsNames ())
     {
-      std::string::size_type offset = path.find ("/Names");
-      if (offset == 0)
-        {
-          m_workStack.push_back (item);
-          DoResolve (pathLeft, root);
-          m_workStack.pop_back ();
-          return;
-        }
+      m_workStack.push_back (element.GetItem ());
+      DoResolve (node, root);
+      m_workStack.pop_back ();
+      return;
     }
 
   //
@@ -438,12 +743,12 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
   // zero, this means to look in the root of the "/Names" name space, otherwise
   // it refers to a name space context (level).
   //
-  Ptr<Object> namedObject = Names::Find<Object> (root, item);
+  Ptr<Object> namedObject = Names::Find<Object> (root, element.GetItem ());
   if (namedObject)
     {
-      NS_LOG_DEBUG ("Name system resolved item = " << item << " to " << namedObject);
-      m_workStack.push_back (item);
-      DoResolve (pathLeft, namedObject);
+      NS_LOG_DEBUG ("Name system resolved item = " << element.GetItem () << " to " << namedObject);
+      m_workStack.push_back (element.GetItem ());
+      DoResolve (node, namedObject);
       m_workStack.pop_back ();
       return;
     }
@@ -459,119 +764,110 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
     {
       return;
     }
-  std::string::size_type dollarPos = item.find ("$");
-  if (dollarPos == 0)
+  if (element.IsGetObject ())
     {
       // This is a call to GetObject
-      std::string tidString = item.substr (1, item.size () - 1);
-      NS_LOG_DEBUG ("GetObject="<<tidString<<" on path="<<GetResolvedPath ());
-      TypeId tid = TypeId::LookupByName (tidString);
-      Ptr<Object> object = root->GetObject<Object> (tid);
+      NS_LOG_DEBUG ("GetObject="<<element.GetItem ()<<" on path="<<GetResolvedPath ());
+      Ptr<Object> object = root->GetObject<Object> (element.GetObjectTypeId ());
       if (object == 0)
         {
-          NS_LOG_DEBUG ("GetObject ("<<tidString<<") failed on path="<<GetResolvedPath ());
+          NS_LOG_DEBUG ("GetObject ("<<element.GetItem ()<<") failed on path="<<GetResolvedPath ());
           return;
         }
-      m_workStack.push_back (item);
-      DoResolve (pathLeft, object);
+      m_workStack.push_back (element.GetItem ());
+      DoResolve (node, object);
       m_workStack.pop_back ();
+      return;
     }
-  else 
+
+  // this is a normal attribute.
+  const PathElement::Attributes &attributes = element.GetAttributes (root->GetInstanceTypeId ());
+  if (attributes.empty ())
     {
-      // this is a normal attribute.
-      TypeId tid;
-      TypeId nextTid = root->GetInstanceTypeId ();
-      bool foundMatch = false;
-      
-      do
+      NS_LOG_DEBUG ("Requested item="<<element.GetItem ()<<" does not exist on path="<<GetResolvedPath ());
+      return;
+    }
+  for (PathElement::Attributes::const_iterator i = attributes.begin (); i != attributes.end (); ++i)
+    {
+      if (!i->isContainer)
         {
-          tid = nextTid;
-          
-          for (uint32_t i = 0; i < tid.GetAttributeN(); i++)
+          NS_LOG_DEBUG ("GetAttribute(ptr)="<<i->name<<" on path="<<GetResolvedPath ());
+          PointerValue ptr;
+          GetValue (root, *i, ptr);
+          Ptr<Object> object = ptr.Get<Object> ();
+          if (object == 0)
             {
-              struct TypeId::AttributeInformation info;
-              info = tid.GetAttribute(i);
-              if (info.name != item && item != "*")
-                {
-                  continue;
-                }
-              // attempt to cast to a pointer checker.
-              const PointerChecker *ptr = dynamic_cast<const PointerChecker *> (PeekPointer (info.checker));
-              if (ptr != 0)
-                {
-                  NS_LOG_DEBUG ("GetAttribute(ptr)="<<info.name<<" on path="<<GetResolvedPath ());
-                  PointerValue ptr;
-                  root->GetAttribute (info.name, ptr);
-                  Ptr<Object> object = ptr.Get<Object> ();
-                  if (object == 0)
-                    {
-                      NS_LOG_ERROR ("Requested object name=\""<<item<<
-                                    "\" exists on path=\""<<GetResolvedPath ()<<"\""
-                                    " but is null.");
-                      continue;
-                    }
-                  foundMatch = true;
-                  m_workStack.push_back (info.name);
-                  DoResolve (pathLeft, object);
-                  m_workStack.pop_back ();
-                }
-              // attempt to cast to an object vector.
-              const ObjectPtrContainerChecker *vectorChecker = 
-                dynamic_cast<const ObjectPtrContainerChecker *> (PeekPointer (info.checker));
-              if (vectorChecker != 0)
-                {
-                  NS_LOG_DEBUG ("GetAttribute(vector)="<<info.name<<" on path="<<GetResolvedPath () << pathLeft);
-                  foundMatch = true;
-                  ObjectPtrContainerValue vector;
-                  root->GetAttribute (info.name, vector);
-                  m_workStack.push_back (info.name);
-                  DoArrayResolve (pathLeft, vector);
-                  m_workStack.pop_back ();
-                }
-              // this could be anything else and we don't know what to do with it.
-              // So, we just ignore it.
+              NS_LOG_ERROR ("Requested object name=\""<<element.GetItem ()<<
+                            "\" exists on path=\""<<GetResolvedPath ()<<"\""
+                            " but is null.");
+              continue;
             }
-
-          nextTid = tid.GetParent ();
-        } while (nextTid != tid);
-      
-      if (!foundMatch)
+          m_workStack.push_back (i->name);
+          DoResolve (node, object);
+          m_workStack.pop_back ();
+        }
+      else
         {
-          NS_LOG_DEBUG ("Requested item="<<item<<" does not exist on path="<<GetResolvedPath ());
-          return;
+          NS_LOG_DEBUG ("GetAttribute(vector)="<<i->name<<" on path="<<GetResolvedPath ());
+          ObjectPtrContainerValue vector;
+          GetValue (root, *i, vector);
+          m_workStack.push_back (i->name);
+          DoArrayResolve (node, vector);
+          m_workStack.pop_back ();
         }
     }
 }
 
 void 
-Resolver::DoArrayResolve (std::string path, const ObjectPtrContainerValue &container)
+Resolver::DoArrayResolve (const PathTree::Node *node, const ObjectPtrContainerValue &container)
 {
-  NS_LOG_FUNCTION(this << path << &container);
-  NS_ASSERT (path != "");
-  NS_ASSERT ((path.find ("/")) == 0);
-  std::string::size_type next = path.find ("/", 1);
-  if (next == std::string::npos)
-    {
-      return;
-    }
-  std::string item = path.substr (1, next-1);
-  std::string pathLeft = path.substr (next, path.size ()-next);
+  NS_LOG_FUNCTION(this << node << &container);
 
-  ArrayMatcher matcher = ArrayMatcher (item);
-  ObjectPtrContainerValue::Iterator it;
-  for (it = container.Begin (); it != container.End (); ++it)
+  // A path ending with the container attribute matches nothing: only
+  // the index elements which follow it are resolved.
+  for (std::vector<PathTree::Node *>::const_iterator i = node->children.begin ();
+       i != node->children.end (); ++i)
     {
-      if (matcher.Matches ((*it).first))
+      const ArrayMatcher &matcher = (*i)->element.GetMatcher ();
+      ObjectPtrContainerValue::Iterator it;
+      for (it = container.Begin (); it != container.End (); ++it)
         {
-          std::ostringstream oss;
-          oss << (*it).first;
-          m_workStack.push_back (oss.str ());
-          DoResolve (pathLeft, (*it).second);
-          m_workStack.pop_back ();
+          if (matcher.Matches ((*it).first))
+            {
+              char index[16];
+              std::sprintf (index, "%u", (*it).first);
+              m_workStack.push_back (index);
+              if (DoEnter (*i, (*it).second))
+                {
+                  DoResolve (*i, (*it).second);
+                }
+              m_workStack.pop_back ();
+            }
         }
     }
 }
 
+/** A Resolver which collects the objects matched, with their contexts. */
+class MatchResolver : public Resolver
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] tree The Config paths to match.
+   */
+  MatchResolver (const PathTree &tree)
+    : Resolver (tree)
+  {}
+  std::vector<Ptr<Object> > m_objects;  //!< The objects matched.
+  std::vector<std::string> m_contexts;  //!< The context of each object.
+private:
+  virtual void DoOne (Ptr<Object> object, uint32_t terminal)
+  {
+    m_objects.push_back (object);
+    m_contexts.push_back (GetResolvedPath ());
+  }
+};
+
 /** Config system implementation class. */
 class ConfigImpl : public Singleton<ConfigImpl>
 {
@@ -588,6 +884,21 @@ public:
   void Disconnect (std::string path, const CallbackBase &cb);
   /** \copydoc Config::LookupMatches() */
   Config::MatchContainer LookupMatches (std::string path);
+  /**
+   * Match a compiled Config path.
+   *
+   * \param [in] tree The compiled Config path.
+   * \param [in] path The Config path, as text.
+   * \returns The objects matched.
+   */
+  Config::MatchContainer LookupMatches (const PathTree &tree, std::string path);
+  /**
+   * Run a resolver over all the root namespace objects,
+   * then over the "/Names" namespace.
+   *
+   * \param [in] resolver The resolver.
+   */
+  void Resolve (Resolver &resolver) const;
 
   /** \copydoc Config::RegisterRootNamespaceObject() */
   void RegisterRootNamespaceObject (Ptr<Object> obj);
@@ -600,6 +911,10 @@ public:
   Ptr<Object> GetRootNamespaceObject (uint32_t i) const;
 
 private:
+  // These split the paths they compile with ParsePath().
+  friend class Config::CompiledPathImpl;
+  friend class Config::BatchImpl;
+
   /**
    * Break a Config path into the leading path and the last leaf token.
    * \param [in] path The Config path.
@@ -681,19 +996,24 @@ Config::MatchContainer
 ConfigImpl::LookupMatches (std::string path)
 {
   NS_LOG_FUNCTION (this << path);
-  class LookupMatchesResolver : public Resolver 
-  {
-  public:
-    LookupMatchesResolver (std::string path)
-      : Resolver (path)
-    {}
-    virtual void DoOne (Ptr<Object> object, std::string path) {
-      m_objects.push_back (object);
-      m_contexts.push_back (path);
-    }
-    std::vector<Ptr<Object> > m_objects;
-    std::vector<std::string> m_contexts;
-  } resolver = LookupMatchesResolver (path);
+  PathTree tree;
+  tree.Add (path, 0);
+  return LookupMatches (tree, path);
+}
+
+Config::MatchContainer 
+ConfigImpl::LookupMatches (const PathTree &tree, std::string path)
+{
+  NS_LOG_FUNCTION (this << &tree << path);
+  MatchResolver resolver (tree);
+  Resolve (resolver);
+  return Config::MatchContainer (resolver.m_objects, resolver.m_contexts, path);
+}
+
+void
+ConfigImpl::Resolve (Resolver &resolver) const
+{
+  NS_LOG_FUNCTION (this << &resolver);
   for (Roots::const_iterator i = m_roots.begin (); i != m_roots.end (); i++)
     {
       resolver.Resolve (*i);
@@ -705,8 +1025,6 @@ ConfigImpl::LookupMatches (std::string path)
   // looking at the root of the "/Names" namespace during this go.
   //
   resolver.Resolve (0);
-
-  return Config::MatchContainer (resolver.m_objects, resolver.m_contexts, path);
 }
 
 void 
@@ -849,6 +1167,242 @@ Config::MatchContainer LookupMatches (std::string path)
   return ConfigImpl::Get ()->LookupMatches (path);
 }
 
+/** The state shared by the copies of a Config::CompiledPath. */
+class CompiledPathImpl : public SimpleRefCount<CompiledPathImpl>
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] path The Config path.
+   */
+  CompiledPathImpl (std::string path)
+    : m_path (path)
+  {
+    ConfigImpl::Get ()->ParsePath (path, &m_root, &m_leaf);
+    m_tree.Add (m_root, 0);
+  }
+  std::string m_path;  //!< The full Config path.
+  std::string m_root;  //!< The path to the objects holding the leaf.
+  std::string m_leaf;  //!< The attribute or trace source name.
+  PathTree m_tree;     //!< The compiled path to the objects.
+};
+
+CompiledPath::CompiledPath (std::string path)
+  : m_impl (Create<CompiledPathImpl> (path))
+{
+  NS_LOG_FUNCTION (this << path);
+}
+CompiledPath::CompiledPath (const CompiledPath &o)
+  : m_impl (o.m_impl)
+{
+  NS_LOG_FUNCTION (this << &o);
+}
+CompiledPath &
+CompiledPath::operator = (const CompiledPath &o)
+{
+  NS_LOG_FUNCTION (this << &o);
+  m_impl = o.m_impl;
+  return *this;
+}
+CompiledPath::~CompiledPath ()
+{
+  NS_LOG_FUNCTION (this);
+}
+std::string
+CompiledPath::GetPath (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_impl->m_path;
+}
+MatchContainer
+CompiledPath::LookupMatches (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return ConfigImpl::Get ()->LookupMatches (m_impl->m_tree, m_impl->m_root);
+}
+void
+CompiledPath::Set (const AttributeValue &value) const
+{
+  NS_LOG_FUNCTION (this << &value);
+  LookupMatches ().Set (m_impl->m_leaf, value);
+}
+void
+CompiledPath::Connect (const CallbackBase &cb) const
+{
+  NS_LOG_FUNCTION (this << &cb);
+  LookupMatches ().Connect (m_impl->m_leaf, cb);
+}
+void
+CompiledPath::ConnectWithoutContext (const CallbackBase &cb) const
+{
+  NS_LOG_FUNCTION (this << &cb);
+  LookupMatches ().ConnectWithoutContext (m_impl->m_leaf, cb);
+}
+void
+CompiledPath::Disconnect (const CallbackBase &cb) const
+{
+  NS_LOG_FUNCTION (this << &cb);
+  LookupMatches ().Disconnect (m_impl->m_leaf, cb);
+}
+void
+CompiledPath::DisconnectWithoutContext (const CallbackBase &cb) const
+{
+  NS_LOG_FUNCTION (this << &cb);
+  LookupMatches ().DisconnectWithoutContext (m_impl->m_leaf, cb);
+}
+
+/** The operations recorded by a Config::Batch. */
+class BatchImpl
+{
+public:
+  /** The kinds of operations. */
+  enum Type
+  {
+    SET,                     //!< Config::Set()
+    CONNECT,                 //!< Config::Connect()
+    CONNECT_WITHOUT_CONTEXT  //!< Config::ConnectWithoutContext()
+  };
+  /** An operation to apply to the objects matched by a path. */
+  struct Operation
+  {
+    Type type;                   //!< The kind of operation.
+    std::string leaf;            //!< The attribute or trace source name.
+    Ptr<AttributeValue> value;   //!< The value to set.
+    CallbackBase cb;             //!< The sink to connect.
+  };
+  /**
+   * Record an operation.
+   * \param [in] type The kind of operation.
+   * \param [in] path The Config path.
+   * \param [in] value The value to set, if any.
+   * \param [in] cb The sink to connect, if any.
+   */
+  void Add (Type type, std::string path, Ptr<AttributeValue> value, const CallbackBase &cb)
+  {
+    Operation operation;
+    std::string root;
+    ConfigImpl::Get ()->ParsePath (path, &root, &operation.leaf);
+    operation.type = type;
+    operation.value = value;
+    operation.cb = cb;
+    m_tree.Add (root, m_operations.size ());
+    m_operations.push_back (operation);
+  }
+
+  PathTree m_tree;                        //!< The compiled paths.
+  std::vector<Operation> m_operations;    //!< The operations, indexed by path id.
+  /**
+   * The operations already applied, with the resolved Config path of
+   * the object they were applied to.  Paths, rather than the objects,
+   * so that the batch does not keep the objects alive.
+   */
+  std::set<std::pair<uint32_t, std::string> > m_applied;
+  /** The container entries already resolved, per index element, by resolved Config path. */
+  std::set<std::pair<const PathTree::Node *, std::string> > m_entered;
+};
+
+/** A Resolver which applies the operations of a Config::Batch. */
+class BatchResolver : public Resolver
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] batch The batch to apply.
+   * \param [in] update Whether to skip the container entries resolved before.
+   */
+  BatchResolver (BatchImpl *batch, bool update)
+    : Resolver (batch->m_tree),
+      m_batch (batch),
+      m_update (update),
+      m_count (0)
+  {}
+  /** \returns The number of operations applied. */
+  uint32_t GetCount (void) const
+  {
+    return m_count;
+  }
+private:
+  virtual bool DoEnter (const PathTree::Node *node, Ptr<Object> object)
+  {
+    if (m_batch->m_entered.insert (std::make_pair (node, GetResolvedPath ())).second)
+      {
+        return true;
+      }
+    return !m_update;
+  }
+  virtual void DoOne (Ptr<Object> object, uint32_t terminal)
+  {
+    std::string path = GetResolvedPath ();
+    if (!m_batch->m_applied.insert (std::make_pair (terminal, path)).second)
+      {
+        return;
+      }
+    const BatchImpl::Operation &operation = m_batch->m_operations[terminal];
+    switch (operation.type)
+      {
+      case BatchImpl::SET:
+        object->SetAttribute (operation.leaf, *operation.value);
+        break;
+      case BatchImpl::CONNECT:
+        object->TraceConnect (operation.leaf, path + operation.leaf, operation.cb);
+        break;
+      case BatchImpl::CONNECT_WITHOUT_CONTEXT:
+        object->TraceConnectWithoutContext (operation.leaf, operation.cb);
+        break;
+      }
+    m_count++;
+  }
+  BatchImpl *m_batch;  //!< The batch to apply.
+  bool m_update;       //!< Skip the container entries resolved before.
+  uint32_t m_count;    //!< The number of operations applied.
+};
+
+Batch::Batch ()
+  : m_impl (new BatchImpl ())
+{
+  NS_LOG_FUNCTION (this);
+}
+Batch::~Batch ()
+{
+  NS_LOG_FUNCTION (this);
+  delete m_impl;
+  m_impl = 0;
+}
+void
+Batch::Set (std::string path, const AttributeValue &value)
+{
+  NS_LOG_FUNCTION (this << path << &value);
+  m_impl->Add (BatchImpl::SET, path, value.Copy (), CallbackBase ());
+}
+void
+Batch::Connect (std::string path, const CallbackBase &cb)
+{
+  NS_LOG_FUNCTION (this << path << &cb);
+  m_impl->Add (BatchImpl::CONNECT, path, 0, cb);
+}
+void
+Batch::ConnectWithoutContext (std::string path, const CallbackBase &cb)
+{
+  NS_LOG_FUNCTION (this << path << &cb);
+  m_impl->Add (BatchImpl::CONNECT_WITHOUT_CONTEXT, path, 0, cb);
+}
+uint32_t
+Batch::Apply (void)
+{
+  NS_LOG_FUNCTION (this);
+  BatchResolver resolver (m_impl, false);
+  ConfigImpl::Get ()->Resolve (resolver);
+  return resolver.GetCount ();
+}
+uint32_t
+Batch::Update (void)
+{
+  NS_LOG_FUNCTION (this);
+  BatchResolver resolver (m_impl, true);
+  ConfigImpl::Get ()->Resolve (resolver);
+  return resolver.GetCount ();
+}
+
 void RegisterRootNamespaceObject (Ptr<Object> obj)
 {
   NS_LOG_FUNCTION (obj);
@@ -258,6 +258,171 @@ private:
  */
 MatchContainer LookupMatches (std::string path);
 
+class CompiledPathImpl;
+class BatchImpl;
+
+/**
+ * \ingroup config
+ * \brief A Config path parsed once, to be matched many times.
+ *
+ * The path is split into its elements when the CompiledPath is
+ * built: index specifications such as "*", "3", "[2-5]" or "1|4" are
+ * parsed, the TypeId of "$" elements is looked up once and the
+ * attributes each element designates are cached per TypeId.  Matching
+ * the path then only walks the objects, which makes it cheap to
+ * apply the same path repeatedly, for example after more nodes were
+ * created.
+ *
+ * Copies share the compiled path.
+ */
+class CompiledPath
+{
+public:
+  /**
+   * Compile a Config path.
+   *
+   * \param [in] path A path, as accepted by Config::Set and Config::Connect:
+   *             the last element names an attribute or a trace source.
+   */
+  CompiledPath (std::string path);
+  /**
+   * Copy constructor.
+   * \param [in] o The CompiledPath to copy.
+   */
+  CompiledPath (const CompiledPath &o);
+  /**
+   * Assignment.
+   * \param [in] o The CompiledPath to copy.
+   * \returns This CompiledPath.
+   */
+  CompiledPath & operator = (const CompiledPath &o);
+  /** Destructor. */
+  ~CompiledPath ();
+
+  /** \returns The path this object was compiled from. */
+  std::string GetPath (void) const;
+  /**
+   * \returns A container of the objects which hold the attribute or
+   *          trace source named by the last path element.
+   */
+  MatchContainer LookupMatches (void) const;
+
+  /**
+   * \param [in] value The value to set in all matching attributes.
+   * \sa ns3::Config::Set
+   */
+  void Set (const AttributeValue &value) const;
+  /**
+   * \param [in] cb The sink to connect to all matching trace sources.
+   * \sa ns3::Config::Connect
+   */
+  void Connect (const CallbackBase &cb) const;
+  /**
+   * \param [in] cb The sink to connect to all matching trace sources.
+   * \sa ns3::Config::ConnectWithoutContext
+   */
+  void ConnectWithoutContext (const CallbackBase &cb) const;
+  /**
+   * \param [in] cb The sink to disconnect from all matching trace sources.
+   * \sa ns3::Config::Disconnect
+   */
+  void Disconnect (const CallbackBase &cb) const;
+  /**
+   * \param [in] cb The sink to disconnect from all matching trace sources.
+   * \sa ns3::Config::DisconnectWithoutContext
+   */
+  void DisconnectWithoutContext (const CallbackBase &cb) const;
+
+private:
+  /** The compiled path. */
+  Ptr<CompiledPathImpl> m_impl;
+};
+
+/**
+ * \ingroup config
+ * \brief Apply many Config operations in a single walk of the objects.
+ *
+ * Set and Connect operations are recorded first, then Apply() resolves
+ * all their paths at once: the objects matched by the elements the
+ * paths have in common, typically the node and device lists, are
+ * walked once for all of them.
+ *
+ * Each operation is applied at most once per matched Config path, so
+ * Apply() can be called again after the topology grew: it only sets and
+ * connects the objects at paths which were not matched before.  Update()
+ * does the same without walking again below the entries of object
+ * containers (such as the node list) which were already resolved, which
+ * makes it proportional to the number of new entries.  The batch
+ * remembers the resolved paths, not the objects: it does not keep them
+ * alive.  As with Config::Set() and Config::Connect(), an object matched
+ * through two different paths is set or connected once per path.
+ *
+ * \code
+ *   Config::Batch batch;
+ *   batch.Set ("/NodeList/[0-99]/DeviceList/0/Mtu", UintegerValue (9000));
+ *   batch.Connect ("/NodeList/[0-99]/DeviceList/0/MacTx", MakeCallback (&MacTx));
+ *   batch.Apply ();
+ *   // ... create more nodes ...
+ *   batch.Update ();
+ * \endcode
+ */
+class Batch
+{
+public:
+  /** Constructor. */
+  Batch ();
+  /** Destructor. */
+  ~Batch ();
+
+  /**
+   * Record a Config::Set operation.
+   * \param [in] path A path to match attributes.
+   * \param [in] value The value to set in all matching attributes.
+   */
+  void Set (std::string path, const AttributeValue &value);
+  /**
+   * Record a Config::Connect operation.
+   * \param [in] path A path to match trace sources.
+   * \param [in] cb The callback to connect to the matching trace sources.
+   */
+  void Connect (std::string path, const CallbackBase &cb);
+  /**
+   * Record a Config::ConnectWithoutContext operation.
+   * \param [in] path A path to match trace sources.
+   * \param [in] cb The callback to connect to the matching trace sources.
+   */
+  void ConnectWithoutContext (std::string path, const CallbackBase &cb);
+
+  /**
+   * Apply the recorded operations to the objects not matched yet.
+   * \returns The number of (operation, path) pairs applied by this call.
+   */
+  uint32_t Apply (void);
+  /**
+   * Apply the recorded operations to the objects below the entries of
+   * object containers which were not resolved yet.
+   *
+   * Objects added below an entry resolved by a previous call, such as a
+   * device added to an existing node, are not matched: use Apply() for
+   * these.
+   *
+   * \returns The number of (operation, path) pairs applied by this call.
+   */
+  uint32_t Update (void);
+
+private:
+  /** Copy constructor: not implemented. */
+  Batch (const Batch &);
+  /**
+   * Assignment: not implemented.
+   * \returns The Batch.
+   */
+  Batch & operator = (const Batch &);
+
+  /** The recorded operations. */
+  BatchImpl *m_impl;
+};
+
 /**
  * \ingroup config
  * \param [in] obj A new root object
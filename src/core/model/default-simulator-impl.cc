@@ -22,9 +22,12 @@
 #include "default-simulator-impl.h"
 #include "scheduler.h"
 #include "event-impl.h"
+#include "event-profiler.h"
 
 #include "ptr.h"
 #include "pointer.h"
+#include "string.h"
+#include "uinteger.h"
 #include "assert.h"
 #include "log.h"
 
@@ -53,6 +56,19 @@ DefaultSimulatorImpl::GetTypeId (void)
     .SetParent<SimulatorImpl> ()
     .SetGroupName ("Core")
     .AddConstructor<DefaultSimulatorImpl> ()
+    .AddAttribute ("ProfileFile",
+                   "If not empty, profile every event and write the profile "
+                   "to this file at Simulator::Destroy.",
+                   StringValue (""),
+                   MakeStringAccessor (&DefaultSimulatorImpl::SetProfileFile,
+                                       &DefaultSimulatorImpl::GetProfileFile),
+                   MakeStringChecker ())
+    .AddAttribute ("ProfileContexts",
+                   "The number of rows in the per-context sections "
+                   "of the event profile.",
+                   UintegerValue (100),
+                   MakeUintegerAccessor (&DefaultSimulatorImpl::m_profileContexts),
+                   MakeUintegerChecker<uint32_t> ())
   ;
   return tid;
 }
@@ -73,11 +89,13 @@ DefaultSimulatorImpl::DefaultSimulatorImpl ()
   m_unscheduledEvents = 0;
   m_eventsWithContextEmpty = true;
   m_main = SystemThread::Self();
+  m_profiler = 0;
 }
 
 DefaultSimulatorImpl::~DefaultSimulatorImpl ()
 {
   NS_LOG_FUNCTION (this);
+  delete m_profiler;
 }
 
 void
@@ -108,6 +126,32 @@ DefaultSimulatorImpl::Destroy ()
           ev->Invoke ();
         }
     }
+  if (m_profiler != 0)
+    {
+      m_profiler->Write (m_profileFile, m_profileContexts);
+    }
+}
+
+void
+DefaultSimulatorImpl::SetProfileFile (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  m_profileFile = filename;
+  if (filename.empty ())
+    {
+      delete m_profiler;
+      m_profiler = 0;
+    }
+  else if (m_profiler == 0)
+    {
+      m_profiler = new EventProfiler ();
+    }
+}
+
+std::string
+DefaultSimulatorImpl::GetProfileFile (void) const
+{
+  return m_profileFile;
 }
 
 void
@@ -146,7 +190,16 @@ DefaultSimulatorImpl::ProcessOneEvent (void)
   m_currentTs = next.key.m_ts;
   m_currentContext = next.key.m_context;
   m_currentUid = next.key.m_uid;
-  next.impl->Invoke ();
+  if (m_profiler != 0)
+    {
+      m_profiler->BeginEvent (next.impl, m_currentContext, m_currentTs);
+      next.impl->Invoke ();
+      m_profiler->EndEvent ();
+    }
+  else
+    {
+      next.impl->Invoke ();
+    }
   next.impl->Unref ();
 
   ProcessEventsWithContext ();
@@ -242,6 +295,10 @@ DefaultSimulatorImpl::Schedule (Time const &delay, EventImpl *event)
   m_uid++;
   m_unscheduledEvents++;
   m_events->Insert (ev);
+  if (m_profiler != 0)
+    {
+      m_profiler->NotifySchedule ();
+    }
   return EventId (event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
 }
 
@@ -261,6 +318,10 @@ DefaultSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay,
       m_uid++;
       m_unscheduledEvents++;
       m_events->Insert (ev);
+      if (m_profiler != 0)
+        {
+          m_profiler->NotifySchedule ();
+        }
     }
   else
     {
@@ -290,6 +351,10 @@ DefaultSimulatorImpl::ScheduleNow (EventImpl *event)
   m_uid++;
   m_unscheduledEvents++;
   m_events->Insert (ev);
+  if (m_profiler != 0)
+    {
+      m_profiler->NotifySchedule ();
+    }
   return EventId (event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
 }
 
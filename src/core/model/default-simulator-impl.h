@@ -30,6 +30,7 @@
 #include "ptr.h"
 
 #include <list>
+#include <string>
 
 /**
  * \file
@@ -39,10 +40,17 @@
 
 namespace ns3 {
 
+class EventProfiler;
+
 /**
  * \ingroup simulator
  *
  * The default single process simulator implementation.
+ *
+ * Setting the \c ProfileFile attribute enables the event profiler:
+ * every event is then timed and attributed to its target and context,
+ * and the resulting profile is written to that file by Destroy().
+ * See EventProfiler for details.
  */
 class DefaultSimulatorImpl : public SimulatorImpl
 {
@@ -85,6 +93,18 @@ private:
   void ProcessOneEvent (void);
   /** Move events from a different context into the main event queue. */
   void ProcessEventsWithContext (void);
+
+  /**
+   * Enable or disable the event profiler.
+   * \param [in] filename The profile output file, or an empty string
+   *             to disable profiling.
+   */
+  void SetProfileFile (std::string filename);
+  /**
+   * Get the profile output file name.
+   * \returns The profile output file, empty if profiling is disabled.
+   */
+  std::string GetProfileFile (void) const;
  
   /** Wrap an event with its execution context. */
   struct EventWithContext {
@@ -132,6 +152,13 @@ private:
 
   /** Main execution thread. */
   SystemThread::ThreadId m_main;
+
+  /** The event profiler, or 0 if profiling is disabled. */
+  EventProfiler *m_profiler;
+  /** The profile output file. */
+  std::string m_profileFile;
+  /** Number of rows in the per-context sections of the profile. */
+  uint32_t m_profileContexts;
 };
 
 } // namespace ns3
@@ -0,0 +1,391 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "event-profiler.h"
+#include "event-impl.h"
+#include "nstime.h"
+#include "log.h"
+#include "fatal-error.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <time.h>
+#include <sys/time.h>
+
+#if (__GNUC__ >= 3)
+#include <cstdlib>
+#include <cxxabi.h>
+#endif
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::EventProfiler implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("EventProfiler");
+
+namespace {
+
+/** A profile row: a name, a context and its counters. */
+struct ProfileRow
+{
+  /** Constructor. */
+  ProfileRow ()
+    : context (0xffffffff),
+      events (0),
+      wallNs (0),
+      scheduled (0)
+  {
+  }
+  std::string name;   //!< Target name.
+  uint32_t context;   //!< Execution context.
+  uint64_t events;    //!< Number of events executed.
+  uint64_t wallNs;    //!< Wall-clock time spent, in nanoseconds.
+  uint64_t scheduled; //!< Number of events scheduled.
+};
+
+/**
+ * Order profile rows by decreasing wall-clock time.
+ * \param [in] a The first row.
+ * \param [in] b The second row.
+ * \returns \c true if \p a is hotter than \p b.
+ */
+bool
+CompareRowsByWall (const ProfileRow &a, const ProfileRow &b)
+{
+  if (a.wallNs != b.wallNs)
+    {
+      return a.wallNs > b.wallNs;
+    }
+  return a.events > b.events;
+}
+
+/**
+ * Print one profile row.
+ * \param [in] os The output stream.
+ * \param [in] row The row to print.
+ * \param [in] totalNs The total wall-clock time of all events.
+ * \param [in] withContext Whether to print the context column.
+ */
+void
+PrintRow (std::ostream &os, const ProfileRow &row, uint64_t totalNs, bool withContext)
+{
+  double share = totalNs == 0 ? 0.0 : 100.0 * row.wallNs / totalNs;
+  double avg = row.events == 0 ? 0.0 : static_cast<double> (row.wallNs) / row.events;
+  double fanout = row.events == 0 ? 0.0 : static_cast<double> (row.scheduled) / row.events;
+  os << std::setw (12) << row.events
+     << std::setw (14) << std::fixed << std::setprecision (3) << row.wallNs / 1e6
+     << std::setw (8) << std::setprecision (2) << share
+     << std::setw (12) << std::setprecision (1) << avg
+     << std::setw (9) << std::setprecision (2) << fanout;
+  if (withContext)
+    {
+      os << std::setw (11);
+      if (row.context == 0xffffffff)
+        {
+          os << "-";
+        }
+      else
+        {
+          os << row.context;
+        }
+    }
+  os << "  " << row.name << std::endl;
+}
+
+} // anonymous namespace
+
+EventProfiler::Record::Record ()
+  : events (0),
+    wallNs (0),
+    scheduled (0)
+{
+}
+
+bool
+EventProfiler::Key::operator < (const Key &o) const
+{
+  if (context != o.context)
+    {
+      return context < o.context;
+    }
+  return type->before (*o.type);
+}
+
+EventProfiler::EventProfiler ()
+  : m_stepsPerSecond (Seconds (1).GetTimeStep ()),
+    m_start (GetWallClockNs ()),
+    m_eventStart (0),
+    m_current (0),
+    m_currentSlot (0),
+    m_slot (0),
+    m_slotSecond (0),
+    m_events (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+EventProfiler::~EventProfiler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint64_t
+EventProfiler::GetWallClockNs (void)
+{
+#if defined (CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t> (ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return static_cast<uint64_t> (tv.tv_sec) * 1000000000 + tv.tv_usec * 1000;
+#endif
+}
+
+void
+EventProfiler::BeginEvent (const EventImpl *event, uint32_t context, uint64_t ts)
+{
+  // Do not add function logging here: this runs once per event.
+  Key key;
+  key.type = &typeid (*event);
+  key.context = context;
+  m_current = &m_records[key];
+  m_current->events++;
+
+  uint64_t second = ts / m_stepsPerSecond;
+  if (m_slot == 0 || second != m_slotSecond)
+    {
+      // Events are executed in time order, so the slot changes at most
+      // once per simulated second and the map is rarely searched.
+      m_slot = &m_timeline[second];
+      m_slotSecond = second;
+    }
+  m_currentSlot = m_slot;
+  m_currentSlot->events++;
+  m_events++;
+
+  m_eventStart = GetWallClockNs ();
+}
+
+void
+EventProfiler::EndEvent (void)
+{
+  uint64_t elapsed = GetWallClockNs () - m_eventStart;
+  m_current->wallNs += elapsed;
+  m_currentSlot->wallNs += elapsed;
+  m_current = 0;
+  m_currentSlot = 0;
+}
+
+void
+EventProfiler::NotifySchedule (void)
+{
+  if (m_current != 0)
+    {
+      m_current->scheduled++;
+      m_currentSlot->scheduled++;
+    }
+}
+
+uint64_t
+EventProfiler::GetEventCount (void) const
+{
+  return m_events;
+}
+
+std::string
+EventProfiler::GetTargetName (const std::type_info &type)
+{
+  std::string name = type.name ();
+#if (__GNUC__ >= 3)
+  int status;
+  char *demangled = abi::__cxa_demangle (name.c_str (), NULL, NULL, &status);
+  if (status == 0 && demangled != 0)
+    {
+      name = demangled;
+    }
+  if (demangled != 0)
+    {
+      std::free (demangled);
+    }
+#endif
+  // Events built by MakeEvent() are local classes of a function template,
+  // whose first template argument is the member function (or function)
+  // pointer type.  Keep only that argument.
+  const std::string prefix = "ns3::MakeEvent<";
+  if (name.compare (0, prefix.size (), prefix) != 0)
+    {
+      return name;
+    }
+  int depth = 0;
+  for (std::string::size_type i = prefix.size (); i < name.size (); ++i)
+    {
+      char c = name[i];
+      if (c == '<' || c == '(')
+        {
+          depth++;
+        }
+      else if (c == '>' || c == ')')
+        {
+          if (depth == 0)
+            {
+              return name.substr (prefix.size (), i - prefix.size ());
+            }
+          depth--;
+        }
+      else if (c == ',' && depth == 0)
+        {
+          return name.substr (prefix.size (), i - prefix.size ());
+        }
+    }
+  return name;
+}
+
+void
+EventProfiler::Write (std::string filename, uint32_t maxContexts) const
+{
+  NS_LOG_FUNCTION (this << filename << maxContexts);
+
+  std::ofstream os (filename.c_str ());
+  if (!os.is_open ())
+    {
+      NS_FATAL_ERROR ("Can't open event profile file " << filename);
+    }
+
+  // Several shared libraries may instantiate the same event type, so
+  // merge records by name rather than by type_info.
+  std::map<std::string, std::string> names;
+  std::map<std::string, ProfileRow> targets;
+  std::map<std::pair<std::string, uint32_t>, ProfileRow> pairs;
+  std::map<uint32_t, ProfileRow> contexts;
+  uint64_t totalNs = 0;
+  uint64_t totalScheduled = 0;
+  for (Records::const_iterator i = m_records.begin (); i != m_records.end (); ++i)
+    {
+      std::string mangled = i->first.type->name ();
+      std::map<std::string, std::string>::iterator n = names.find (mangled);
+      if (n == names.end ())
+        {
+          n = names.insert (std::make_pair (mangled, GetTargetName (*i->first.type))).first;
+        }
+      const std::string &name = n->second;
+      const Record &r = i->second;
+      totalNs += r.wallNs;
+      totalScheduled += r.scheduled;
+
+      ProfileRow row;
+      row.name = name;
+      row.context = i->first.context;
+      row.events = r.events;
+      row.wallNs = r.wallNs;
+      row.scheduled = r.scheduled;
+
+      std::pair<std::string, uint32_t> pairKey (name, i->first.context);
+      std::map<std::pair<std::string, uint32_t>, ProfileRow>::iterator p = pairs.find (pairKey);
+      if (p == pairs.end ())
+        {
+          pairs.insert (std::make_pair (pairKey, row));
+        }
+      else
+        {
+          p->second.events += row.events;
+          p->second.wallNs += row.wallNs;
+          p->second.scheduled += row.scheduled;
+        }
+
+      ProfileRow &target = targets[name];
+      target.name = name;
+      target.events += row.events;
+      target.wallNs += row.wallNs;
+      target.scheduled += row.scheduled;
+
+      ProfileRow &context = contexts[i->first.context];
+      context.context = i->first.context;
+      context.events += row.events;
+      context.wallNs += row.wallNs;
+      context.scheduled += row.scheduled;
+    }
+
+  std::vector<ProfileRow> rows;
+
+  os << "# ns-3 event profile" << std::endl;
+  os << "# events " << m_events
+     << ", event wall time " << std::fixed << std::setprecision (3) << totalNs / 1e9 << " s"
+     << ", total wall time " << (GetWallClockNs () - m_start) / 1e9 << " s"
+     << ", events scheduled " << totalScheduled
+     << ", simulated seconds " << (m_timeline.empty () ? 0 : m_timeline.rbegin ()->first + 1)
+     << std::endl;
+
+  os << std::endl << "# Flat profile by event target" << std::endl;
+  os << "#     events      wall(ms)   %wall     avg(ns)   fanout  target" << std::endl;
+  for (std::map<std::string, ProfileRow>::const_iterator i = targets.begin (); i != targets.end (); ++i)
+    {
+      rows.push_back (i->second);
+    }
+  std::sort (rows.begin (), rows.end (), &CompareRowsByWall);
+  for (std::vector<ProfileRow>::const_iterator i = rows.begin (); i != rows.end (); ++i)
+    {
+      PrintRow (os, *i, totalNs, false);
+    }
+
+  os << std::endl << "# Hottest (target, context) pairs" << std::endl;
+  os << "#     events      wall(ms)   %wall     avg(ns)   fanout    context  target" << std::endl;
+  rows.clear ();
+  for (std::map<std::pair<std::string, uint32_t>, ProfileRow>::const_iterator i = pairs.begin ();
+       i != pairs.end (); ++i)
+    {
+      rows.push_back (i->second);
+    }
+  std::sort (rows.begin (), rows.end (), &CompareRowsByWall);
+  for (uint32_t i = 0; i < rows.size () && i < maxContexts; ++i)
+    {
+      PrintRow (os, rows[i], totalNs, true);
+    }
+
+  os << std::endl << "# Hottest contexts" << std::endl;
+  os << "#     events      wall(ms)   %wall     avg(ns)   fanout    context" << std::endl;
+  rows.clear ();
+  for (std::map<uint32_t, ProfileRow>::const_iterator i = contexts.begin (); i != contexts.end (); ++i)
+    {
+      rows.push_back (i->second);
+    }
+  std::sort (rows.begin (), rows.end (), &CompareRowsByWall);
+  for (uint32_t i = 0; i < rows.size () && i < maxContexts; ++i)
+    {
+      PrintRow (os, rows[i], totalNs, true);
+    }
+
+  os << std::endl << "# Timeline per simulated second" << std::endl;
+  os << "#   second      events      wall(ms)   scheduled" << std::endl;
+  for (Timeline::const_iterator i = m_timeline.begin (); i != m_timeline.end (); ++i)
+    {
+      const Record &r = i->second;
+      os << std::setw (10) << i->first
+         << std::setw (12) << r.events
+         << std::setw (14) << std::setprecision (3) << r.wallNs / 1e6
+         << std::setw (12) << r.scheduled
+         << std::endl;
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,147 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef EVENT_PROFILER_H
+#define EVENT_PROFILER_H
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <typeinfo>
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::EventProfiler declaration.
+ */
+
+namespace ns3 {
+
+class EventImpl;
+
+/**
+ * \ingroup simulator
+ * \brief Attribute wall-clock time spent in events to their targets.
+ *
+ * The profiler is owned by a simulator implementation, which calls
+ * BeginEvent() and EndEvent() around each event invocation and
+ * NotifySchedule() every time a new event is inserted.  Events are
+ * keyed by the dynamic type of their EventImpl (which, for events built
+ * by MakeEvent(), encodes the target class and member function
+ * signature) and by the execution context (the node id).
+ *
+ * For every key the profiler records the number of events executed,
+ * the wall-clock time spent in them and the number of events they
+ * scheduled (their fan-out).  It also keeps the same counters per
+ * simulated second, to build a timeline of the run.
+ *
+ * The simulator only creates a profiler when profiling is requested,
+ * so the cost of a disabled profiler is a single pointer test per event.
+ */
+class EventProfiler
+{
+public:
+  /** Constructor. */
+  EventProfiler ();
+  /** Destructor. */
+  ~EventProfiler ();
+
+  /**
+   * Start accounting for an event.
+   *
+   * \param [in] event The event about to be invoked.
+   * \param [in] context The execution context of the event.
+   * \param [in] ts The timestamp of the event, in Time steps.
+   */
+  void BeginEvent (const EventImpl *event, uint32_t context, uint64_t ts);
+  /** Stop accounting for the event started by the last BeginEvent(). */
+  void EndEvent (void);
+  /**
+   * Record that the event currently running scheduled another one.
+   * Calls made outside of an event are ignored.
+   */
+  void NotifySchedule (void);
+
+  /**
+   * Write the flat profile, the hottest contexts and the per-second
+   * timeline to a text file.
+   *
+   * \param [in] filename The output file name.
+   * \param [in] maxContexts The number of (target, context) rows
+   *             and context rows to output.
+   */
+  void Write (std::string filename, uint32_t maxContexts) const;
+
+  /** \returns The total number of events profiled so far. */
+  uint64_t GetEventCount (void) const;
+
+private:
+  /** Counters collected per key or per timeline slot. */
+  struct Record
+  {
+    Record ();
+    uint64_t events;     //!< Number of events executed.
+    uint64_t wallNs;     //!< Wall-clock time spent, in nanoseconds.
+    uint64_t scheduled;  //!< Number of events scheduled while executing.
+  };
+  /** Profile key: the event target and its execution context. */
+  struct Key
+  {
+    const std::type_info *type;  //!< Dynamic type of the EventImpl.
+    uint32_t context;            //!< Execution context.
+    /**
+     * Strict ordering for use in std::map.
+     * \param [in] o The other key.
+     * \returns \c true if this key sorts before \p o.
+     */
+    bool operator < (const Key &o) const;
+  };
+  /** Container of records indexed by key. */
+  typedef std::map<Key, Record> Records;
+  /**
+   * Timeline records indexed by simulated second.  Sparse, so a run
+   * that jumps far ahead in simulated time costs one entry per second
+   * that actually executed events.
+   */
+  typedef std::map<uint64_t, Record> Timeline;
+
+  /**
+   * Get a monotonic wall-clock time stamp.
+   * \returns The time stamp, in nanoseconds.
+   */
+  static uint64_t GetWallClockNs (void);
+  /**
+   * Get a short, readable name for an event target.
+   * \param [in] type The dynamic type of the EventImpl.
+   * \returns The demangled target name.
+   */
+  static std::string GetTargetName (const std::type_info &type);
+
+  Records m_records;              //!< Counters per (target, context).
+  Timeline m_timeline;            //!< Counters per simulated second.
+  uint64_t m_stepsPerSecond;      //!< Number of Time steps in a second.
+  uint64_t m_start;               //!< Wall clock at profiler creation.
+  uint64_t m_eventStart;          //!< Wall clock at the last BeginEvent().
+  Record *m_current;              //!< Record of the running event, if any.
+  Record *m_currentSlot;          //!< Timeline slot of the running event.
+  Record *m_slot;                 //!< Last timeline slot used, if any.
+  uint64_t m_slotSecond;          //!< Simulated second of m_slot.
+  uint64_t m_events;              //!< Total number of events profiled.
+};
+
+} // namespace ns3
+
+#endif /* EVENT_PROFILER_H */
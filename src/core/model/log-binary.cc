@@ -0,0 +1,833 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "log-binary.h"
+#include "fatal-error.h"
+#include "ns3/core-config.h"
+
+#include <cstdio>
+#include <list>
+#include <map>
+#include <sstream>
+#include <vector>
+
+#ifdef HAVE_PTHREAD_H
+#include "system-mutex.h"
+#include <pthread.h>
+#endif
+
+#ifdef HAVE_STDLIB_H
+#include <cstdlib>
+#endif
+
+/**
+ * \file
+ * \ingroup logbinary
+ * Binary logging backend implementation.
+ *
+ * A binary log file starts with an 8 byte magic string, the format
+ * version and a byte order mark, all 32 bit unsigned integers.  It is
+ * followed by a sequence of records, each starting with a one byte
+ * record type:
+ *
+ *   - Site records: the site id, a NS_LOG_FUNCTION() flag byte, the
+ *     source line, and the component name, function name and file
+ *     name, each as a 32 bit length followed by the characters.
+ *   - Log records: the site id, the log level, a flags byte, the
+ *     time in seconds (a double), the context, and the argument bytes
+ *     preceded by their total size.
+ *
+ * Each argument starts with a one byte type tag, followed by a fixed
+ * size value or, for strings and text, a 32 bit length and the
+ * characters.
+ *
+ * No logging is done in this file: it would recurse.
+ */
+
+namespace ns3 {
+
+bool g_logBinary = false;
+
+namespace {
+
+/** File magic string. */
+const char MAGIC[8] = { 'N', 'S', '3', 'B', 'L', 'O', 'G', '\0' };
+/** File format version. */
+const uint32_t VERSION = 1;
+/** Byte order mark. */
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+/** Site record type. */
+const char SITE_RECORD = 'S';
+/** Log record type. */
+const char LOG_RECORD = 'R';
+/** Log record flag: the time and context are valid. */
+const uint8_t STAMPED = 0x01;
+/** Size of the log record header, up to the argument size included. */
+const uint32_t HEADER_SIZE = 1 + 4 + 1 + 1 + 8 + 4 + 4;
+/** The context of records stamped outside of any context. */
+const uint32_t NO_CONTEXT = 0xffffffff;
+
+/**
+ * A per-thread record buffer.
+ *
+ * Only the thread which owns the buffer reads or writes it: the other
+ * threads never flush it, they could read it while it is appended to.
+ */
+struct ThreadBuffer
+{
+  char *data;          //!< The buffered records.
+  uint32_t size;       //!< Number of bytes used.
+  uint32_t capacity;   //!< Size of data.
+  uint32_t generation; //!< The log file generation of the records.
+};
+
+#ifdef HAVE_PTHREAD_H
+void ExitThread (void *buffer);
+#endif
+
+/** The binary log file and the buffers which write to it. */
+struct Backend
+{
+  /** Constructor. */
+  Backend ()
+    : file (0),
+      bufferSize (64 * 1024),
+      nextSiteId (1)
+  {
+#ifdef HAVE_PTHREAD_H
+    pthread_key_create (&exitKey, &ExitThread);
+#endif
+  }
+  /** Destructor. */
+  ~Backend ()
+  {
+#ifdef HAVE_PTHREAD_H
+    pthread_key_delete (exitKey);
+#endif
+    for (std::list<ThreadBuffer *>::iterator i = buffers.begin (); i != buffers.end (); ++i)
+      {
+        delete [] (*i)->data;
+        delete *i;
+      }
+  }
+  std::FILE *file;                    //!< The output file, if open.
+  uint32_t bufferSize;                //!< Size of new thread buffers.
+  uint32_t nextSiteId;                //!< The next site id to assign.
+  std::list<ThreadBuffer *> buffers;  //!< All the thread buffers.
+#ifdef HAVE_PTHREAD_H
+  SystemMutex mutex;                  //!< Protects the other fields.
+  pthread_key_t exitKey;              //!< Flushes the buffer of exiting threads.
+#endif
+};
+
+/** The LogStampGetter. */
+LogStampGetter g_logStampGetter = 0;
+/**
+ * Log file generation, incremented every time a file is opened.
+ * Sites defined for an older generation are defined again.
+ */
+volatile uint32_t g_generation = 0;
+
+#ifdef HAVE_PTHREAD_H
+/** The buffer of the current thread. */
+__thread ThreadBuffer *t_buffer = 0;
+#else
+/** The buffer of the only thread. */
+ThreadBuffer *t_buffer = 0;
+#endif
+
+/**
+ * Get the backend singleton.
+ * \returns The backend.
+ */
+Backend *
+GetBackend (void)
+{
+  static Backend backend;
+  return &backend;
+}
+
+/** Scoped lock of the backend. */
+class BackendLock
+{
+public:
+  /**
+   * Lock the backend.
+   * \param [in] backend The backend.
+   */
+  BackendLock (Backend *backend)
+    : m_backend (backend)
+  {
+#ifdef HAVE_PTHREAD_H
+    m_backend->mutex.Lock ();
+#endif
+  }
+  /** Unlock the backend. */
+  ~BackendLock ()
+  {
+#ifdef HAVE_PTHREAD_H
+    m_backend->mutex.Unlock ();
+#endif
+  }
+private:
+  Backend *m_backend; //!< The locked backend.
+};
+
+/**
+ * Write bytes to the log file, with the backend locked.
+ * \param [in] backend The backend.
+ * \param [in] data The bytes.
+ * \param [in] n The number of bytes.
+ */
+void
+WriteLocked (Backend *backend, const void *data, std::size_t n)
+{
+  if (backend->file != 0 && n > 0)
+    {
+      std::fwrite (data, 1, n, backend->file);
+    }
+}
+
+/**
+ * Write a string with its length, with the backend locked.
+ * \param [in] backend The backend.
+ * \param [in] s The string.
+ */
+void
+WriteStringLocked (Backend *backend, const std::string &s)
+{
+  uint32_t n = s.size ();
+  WriteLocked (backend, &n, sizeof (n));
+  WriteLocked (backend, s.data (), n);
+}
+
+/**
+ * Empty a thread buffer into the log file, with the backend locked.
+ * Only the thread which owns the buffer calls this.
+ * \param [in] backend The backend.
+ * \param [in] buffer The buffer.
+ */
+void
+WriteBufferLocked (Backend *backend, ThreadBuffer *buffer)
+{
+  if (buffer->generation == g_generation)
+    {
+      WriteLocked (backend, buffer->data, buffer->size);
+    }
+  buffer->size = 0;
+}
+
+/**
+ * Empty the buffer of the current thread into the log file, with the
+ * backend locked.
+ * \param [in] backend The backend.
+ */
+void
+FlushLocked (Backend *backend)
+{
+  if (t_buffer != 0)
+    {
+      WriteBufferLocked (backend, t_buffer);
+    }
+  if (backend->file != 0)
+    {
+      std::fflush (backend->file);
+    }
+}
+
+#ifdef HAVE_PTHREAD_H
+/**
+ * Write and release the buffer of an exiting thread.
+ * \param [in] buffer The ThreadBuffer of the thread.
+ */
+void
+ExitThread (void *buffer)
+{
+  ThreadBuffer *exiting = static_cast<ThreadBuffer *> (buffer);
+  Backend *backend = GetBackend ();
+  BackendLock lock (backend);
+  WriteBufferLocked (backend, exiting);
+  backend->buffers.remove (exiting);
+  delete [] exiting->data;
+  delete exiting;
+}
+#endif
+
+/**
+ * Append a record to the buffer of the current thread.
+ * \param [in] data The record.
+ * \param [in] n The record size.
+ */
+void
+Append (const char *data, uint32_t n)
+{
+  ThreadBuffer *buffer = t_buffer;
+  if (buffer == 0)
+    {
+      Backend *backend = GetBackend ();
+      BackendLock lock (backend);
+      buffer = new ThreadBuffer;
+      buffer->capacity = backend->bufferSize;
+      buffer->data = new char[buffer->capacity];
+      buffer->size = 0;
+      buffer->generation = g_generation;
+      backend->buffers.push_back (buffer);
+      t_buffer = buffer;
+#ifdef HAVE_PTHREAD_H
+      pthread_setspecific (backend->exitKey, buffer);
+#endif
+    }
+  if (buffer->generation != g_generation)
+    {
+      // Written for a log file which is closed now.
+      buffer->size = 0;
+      buffer->generation = g_generation;
+    }
+  if (buffer->size + n > buffer->capacity)
+    {
+      Backend *backend = GetBackend ();
+      BackendLock lock (backend);
+      WriteBufferLocked (backend, buffer);
+      if (n > buffer->capacity)
+        {
+          WriteLocked (backend, data, n);
+          return;
+        }
+    }
+  std::memcpy (buffer->data + buffer->size, data, n);
+  buffer->size += n;
+}
+
+/**
+ * Read a value from a binary log.
+ * \param [in] is The binary log.
+ * \param [out] v The value read.
+ * \returns \c true if the value was read.
+ */
+template <typename T>
+bool
+ReadValue (std::istream &is, T &v)
+{
+  return is.read (reinterpret_cast<char *> (&v), sizeof (v)).gcount () == sizeof (v);
+}
+
+/**
+ * Read a string with its length from a binary log.
+ * \param [in] is The binary log.
+ * \param [out] s The string read.
+ * \returns \c true if the string was read.
+ */
+bool
+ReadString (std::istream &is, std::string &s)
+{
+  uint32_t n;
+  if (!ReadValue (is, n))
+    {
+      return false;
+    }
+  s.resize (n);
+  return n == 0 || is.read (&s[0], n).gcount () == n;
+}
+
+/**
+ * Get a value from decoded argument bytes.
+ * \param [in] args The argument bytes.
+ * \param [in,out] pos The position of the value, updated past it.
+ * \param [out] v The value.
+ * \returns \c true if the bytes hold the whole value.
+ */
+template <typename T>
+bool
+GetValue (const std::vector<char> &args, uint32_t &pos, T &v)
+{
+  if (args.size () - pos < sizeof (v))
+    {
+      return false;
+    }
+  std::memcpy (&v, &args[pos], sizeof (v));
+  pos += sizeof (v);
+  return true;
+}
+
+/** A call site read from a binary log. */
+struct DecodedSite
+{
+  std::string component; //!< The log component name.
+  std::string function;  //!< The function name.
+  std::string file;      //!< The source file name.
+  uint32_t line;         //!< The source line.
+  bool isFunction;       //!< NS_LOG_FUNCTION() call site.
+};
+
+/**
+ * Print the arguments of a log record.
+ * \param [in] site The call site.
+ * \param [in] args The argument bytes.
+ * \param [out] os The text output.
+ * \returns \c true if the arguments are well formed.
+ */
+bool
+PrintArguments (const DecodedSite &site, const std::vector<char> &args, std::ostream &os)
+{
+  uint32_t pos = 0;
+  uint32_t n = 0;
+  while (pos < args.size ())
+    {
+      char tag = args[pos++];
+      if (site.isFunction && n > 0 && tag != 'f')
+        {
+          os << ", ";
+        }
+      n++;
+      switch (tag)
+        {
+        case 'b':
+          {
+            uint8_t v;
+            if (!GetValue (args, pos, v))
+              {
+                return false;
+              }
+            os << (v != 0);
+            break;
+          }
+        case 'c':
+          {
+            char v;
+            if (!GetValue (args, pos, v))
+              {
+                return false;
+              }
+            os << v;
+            break;
+          }
+        case 'i':
+          {
+            int64_t v;
+            if (!GetValue (args, pos, v))
+              {
+                return false;
+              }
+            os << v;
+            break;
+          }
+        case 'u':
+          {
+            uint64_t v;
+            if (!GetValue (args, pos, v))
+              {
+                return false;
+              }
+            os << v;
+            break;
+          }
+        case 'd':
+          {
+            double v;
+            if (!GetValue (args, pos, v))
+              {
+                return false;
+              }
+            os << v;
+            break;
+          }
+        case 'p':
+          {
+            uint64_t v;
+            if (!GetValue (args, pos, v))
+              {
+                return false;
+              }
+            os << reinterpret_cast<const void *> (static_cast<uintptr_t> (v));
+            break;
+          }
+        case 's':
+        case 'f':
+          {
+            uint32_t len;
+            if (!GetValue (args, pos, len) || args.size () - pos < len)
+              {
+                return false;
+              }
+            os.write (&args[pos], len);
+            pos += len;
+            break;
+          }
+        default:
+          return false;
+        }
+    }
+  return true;
+}
+
+/** Open the binary log file named by the \c NS_LOG_BINARY environment variable. */
+class LogBinaryEnvironment
+{
+public:
+  /** Read \c NS_LOG_BINARY. */
+  LogBinaryEnvironment ()
+  {
+    GetBackend ();
+#ifdef HAVE_GETENV
+    char *envVar = getenv ("NS_LOG_BINARY");
+    if (envVar != 0 && *envVar != 0)
+      {
+        LogBinaryEnable (envVar);
+      }
+#endif
+  }
+  /** Flush and close the binary log file at exit. */
+  ~LogBinaryEnvironment ()
+  {
+    LogBinaryDisable ();
+  }
+};
+
+/** Invoke the \c NS_LOG_BINARY handler. */
+LogBinaryEnvironment g_logBinaryEnvironment;
+
+} // anonymous namespace
+
+
+void
+LogSetStampGetter (LogStampGetter getter)
+{
+  g_logStampGetter = getter;
+}
+
+LogStampGetter
+LogGetStampGetter (void)
+{
+  return g_logStampGetter;
+}
+
+void
+LogBinaryEnable (std::string filename, uint32_t bufferSize)
+{
+  LogBinaryDisable ();
+  std::FILE *file = std::fopen (filename.c_str (), "wb");
+  if (file == 0)
+    {
+      NS_FATAL_ERROR ("Can't open binary log file " << filename);
+    }
+  Backend *backend = GetBackend ();
+  BackendLock lock (backend);
+  backend->file = file;
+  backend->bufferSize = bufferSize;
+  WriteLocked (backend, MAGIC, sizeof (MAGIC));
+  WriteLocked (backend, &VERSION, sizeof (VERSION));
+  WriteLocked (backend, &BYTE_ORDER_MARK, sizeof (BYTE_ORDER_MARK));
+  g_generation++;
+  g_logBinary = true;
+}
+
+void
+LogBinaryDisable (void)
+{
+  Backend *backend = GetBackend ();
+  BackendLock lock (backend);
+  g_logBinary = false;
+  if (backend->file == 0)
+    {
+      return;
+    }
+  FlushLocked (backend);
+  std::fclose (backend->file);
+  backend->file = 0;
+}
+
+void
+LogBinaryFlush (void)
+{
+  Backend *backend = GetBackend ();
+  BackendLock lock (backend);
+  FlushLocked (backend);
+}
+
+bool
+LogBinaryDecode (std::istream &is, std::ostream &os)
+{
+  char magic[sizeof (MAGIC)];
+  uint32_t version;
+  uint32_t byteOrder;
+  if (is.read (magic, sizeof (magic)).gcount () != sizeof (magic)
+      || std::memcmp (magic, MAGIC, sizeof (magic)) != 0
+      || !ReadValue (is, version) || version != VERSION
+      || !ReadValue (is, byteOrder) || byteOrder != BYTE_ORDER_MARK)
+    {
+      return false;
+    }
+
+  std::map<uint32_t, DecodedSite> sites;
+  std::vector<char> args;
+  char type;
+  while (is.get (type))
+    {
+      if (type == SITE_RECORD)
+        {
+          uint32_t id;
+          uint8_t isFunction;
+          DecodedSite site;
+          if (!ReadValue (is, id) || !ReadValue (is, isFunction)
+              || !ReadValue (is, site.line)
+              || !ReadString (is, site.component)
+              || !ReadString (is, site.function)
+              || !ReadString (is, site.file))
+            {
+              return false;
+            }
+          site.isFunction = isFunction != 0;
+          sites[id] = site;
+        }
+      else if (type == LOG_RECORD)
+        {
+          uint32_t id;
+          uint8_t level;
+          uint8_t flags;
+          double seconds;
+          uint32_t context;
+          uint32_t size;
+          if (!ReadValue (is, id) || !ReadValue (is, level) || !ReadValue (is, flags)
+              || !ReadValue (is, seconds) || !ReadValue (is, context)
+              || !ReadValue (is, size))
+            {
+              return false;
+            }
+          args.resize (size);
+          if (size > 0 && is.read (&args[0], size).gcount () != size)
+            {
+              return false;
+            }
+          std::map<uint32_t, DecodedSite>::const_iterator site = sites.find (id);
+          if (site == sites.end ())
+            {
+              return false;
+            }
+          if (flags & STAMPED)
+            {
+              os << seconds << "s ";
+              if (context == NO_CONTEXT)
+                {
+                  os << "-1";
+                }
+              else
+                {
+                  os << context;
+                }
+              os << " ";
+            }
+          os << site->second.component << ":" << site->second.function << "(";
+          if (!site->second.isFunction)
+            {
+              os << "): [" << LogComponent::GetLevelLabel (static_cast<enum LogLevel> (level)) << "] ";
+            }
+          if (!PrintArguments (site->second, args, os))
+            {
+              return false;
+            }
+          if (site->second.isFunction)
+            {
+              os << ")";
+            }
+          os << std::endl;
+        }
+      else
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+
+LogSite::LogSite (const LogComponent &component, const char *function,
+                  const char *file, uint32_t line, bool isFunction)
+  : m_component (&component),
+    m_function (function),
+    m_file (file),
+    m_line (line),
+    m_isFunction (isFunction),
+    m_id (0),
+    m_generation (0)
+{
+}
+
+
+LogRecord::LogRecord (LogSite &site, enum LogLevel level)
+  : m_site (site),
+    m_text (0),
+    m_data (m_inline),
+    m_size (HEADER_SIZE),
+    m_capacity (INLINE_SIZE),
+    m_args (0)
+{
+  if (site.m_generation != g_generation)
+    {
+      Define (site);
+    }
+  double seconds = 0;
+  uint32_t context = NO_CONTEXT;
+  uint8_t flags = 0;
+  if (g_logStampGetter != 0)
+    {
+      (*g_logStampGetter)(&seconds, &context);
+      flags |= STAMPED;
+    }
+  uint8_t level8 = static_cast<uint8_t> (level);
+  char *p = m_data;
+  *p++ = LOG_RECORD;
+  std::memcpy (p, &site.m_id, 4);
+  p += 4;
+  *p++ = level8;
+  *p++ = flags;
+  std::memcpy (p, &seconds, 8);
+  p += 8;
+  std::memcpy (p, &context, 4);
+}
+
+LogRecord::~LogRecord ()
+{
+  if (m_text != 0)
+    {
+      std::string text = m_text->str ();
+      delete m_text;
+      m_text = 0;
+      uint32_t n = text.size ();
+      Reserve (1 + 4 + n);
+      m_data[m_size] = 'f';
+      std::memcpy (m_data + m_size + 1, &n, 4);
+      std::memcpy (m_data + m_size + 5, text.data (), n);
+      m_size += 1 + 4 + n;
+    }
+  uint32_t size = m_size - HEADER_SIZE;
+  std::memcpy (m_data + HEADER_SIZE - 4, &size, 4);
+  if (g_logBinary)
+    {
+      Append (m_data, m_size);
+    }
+  if (m_data != m_inline)
+    {
+      delete [] m_data;
+    }
+}
+
+void
+LogRecord::Define (LogSite &site)
+{
+  Backend *backend = GetBackend ();
+  BackendLock lock (backend);
+  if (site.m_generation == g_generation)
+    {
+      return;
+    }
+  if (site.m_id == 0)
+    {
+      site.m_id = backend->nextSiteId++;
+    }
+  uint8_t isFunction = site.m_isFunction;
+  WriteLocked (backend, &SITE_RECORD, 1);
+  WriteLocked (backend, &site.m_id, sizeof (site.m_id));
+  WriteLocked (backend, &isFunction, sizeof (isFunction));
+  WriteLocked (backend, &site.m_line, sizeof (site.m_line));
+  WriteStringLocked (backend, site.m_component->Name ());
+  WriteStringLocked (backend, site.m_function);
+  WriteStringLocked (backend, site.m_file);
+  site.m_generation = g_generation;
+}
+
+LogRecord &
+LogRecord::PutString (const char *s, std::size_t n)
+{
+  if (m_text != 0)
+    {
+      Text () << s;
+      return *this;
+    }
+  uint32_t len = n;
+  Reserve (1 + 4 + len);
+  m_data[m_size] = 's';
+  std::memcpy (m_data + m_size + 1, &len, 4);
+  if (len > 0)
+    {
+      std::memcpy (m_data + m_size + 5, s, len);
+    }
+  m_size += 1 + 4 + len;
+  m_args++;
+  return *this;
+}
+
+void
+LogRecord::Grow (std::size_t n)
+{
+  uint32_t capacity = m_capacity * 2;
+  if (capacity < m_size + n)
+    {
+      capacity = m_size + n;
+    }
+  char *data = new char[capacity];
+  std::memcpy (data, m_data, m_size);
+  if (m_data != m_inline)
+    {
+      delete [] m_data;
+    }
+  m_data = data;
+  m_capacity = capacity;
+}
+
+std::ostream &
+LogRecord::TextStream (void)
+{
+  if (m_text == 0)
+    {
+      m_text = new std::ostringstream;
+    }
+  return *m_text;
+}
+
+std::ostream &
+LogRecord::Text (void)
+{
+  std::ostream &os = TextStream ();
+  if (m_site.m_isFunction && m_args > 0)
+    {
+      os << ", ";
+    }
+  m_args++;
+  return os;
+}
+
+LogRecord &
+LogRecord::operator<< (std::ostream & (*f)(std::ostream &))
+{
+  (*f)(TextStream ());
+  return *this;
+}
+
+LogRecord &
+LogRecord::operator<< (std::ios & (*f)(std::ios &))
+{
+  (*f)(TextStream ());
+  return *this;
+}
+
+LogRecord &
+LogRecord::operator<< (std::ios_base & (*f)(std::ios_base &))
+{
+  (*f)(TextStream ());
+  return *this;
+}
+
+} // namespace ns3
@@ -0,0 +1,446 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_LOG_BINARY_H
+#define NS3_LOG_BINARY_H
+
+#include "log.h"
+
+#include <string>
+#include <iostream>
+#include <iosfwd>
+#include <cstring>
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup logging
+ * Binary structured logging backend.
+ */
+
+/**
+ * \ingroup logging
+ * \defgroup logbinary Binary logging
+ *
+ * \brief Compact binary backend for the NS_LOG macros.
+ *
+ * Formatting log messages on \c std::clog dominates the cost of
+ * running with \c LOG_LEVEL_INFO enabled.  When the binary backend is
+ * enabled, the NS_LOG(), NS_LOG_FUNCTION() and NS_LOG_FUNCTION_NOARGS()
+ * macros of enabled components do not format anything: they append a
+ * compact record to a per-thread buffer, which is written to the
+ * output file when it fills up.  Each record holds the call site id
+ * (which identifies the component, the function and the source
+ * location, and serves as format id), the log level, the simulation
+ * time and context, and the raw bytes of the streamed arguments.
+ * Integers, floating point values, characters, booleans, strings and
+ * pointers (including Ptr<>) are stored without formatting.  Any other
+ * type, and everything streamed after it or after an I/O manipulator,
+ * is formatted with its \c operator<< as usual and stored as text, so
+ * the decoded output is always the same as the text backend output.
+ *
+ * The file is decoded offline with LogBinaryDecode(), or with the
+ * \c log-decode program:
+ * \code
+ *   $ NS_LOG="Ipv4L3Protocol=info" NS_LOG_BINARY=run.blog ./waf --run ...
+ *   $ ./waf --run "log-decode --file=run.blog"
+ * \endcode
+ * Decoded records look like the text output with all prefixes
+ * enabled.  The file-local NS_LOG_APPEND_CONTEXT prefix is not
+ * recorded; the simulation context is recorded instead.
+ *
+ * Records from different threads are interleaved in the file one
+ * buffer at a time; the time stamps give the order of the records.
+ * Each thread writes only its own buffer: when it fills up, when the
+ * thread calls LogBinaryFlush() or LogBinaryDisable(), and when the
+ * thread exits.
+ * The file uses the byte order of the host which wrote it.
+ */
+
+namespace ns3 {
+
+template <typename T>
+class Ptr;
+
+/**
+ * \ingroup logbinary
+ * Function signature for stamping binary log records with the
+ * simulation time and context.
+ *
+ * \param [out] seconds The current simulation time, in seconds.
+ * \param [out] context The current simulation context.
+ */
+typedef void (*LogStampGetter)(double *seconds, uint32_t *context);
+
+/**
+ * \ingroup logbinary
+ * Set the LogStampGetter function used to stamp binary log records.
+ *
+ * \param [in] getter The LogStampGetter function, or 0 to record
+ *             unstamped records.
+ */
+void LogSetStampGetter (LogStampGetter getter);
+/**
+ * \ingroup logbinary
+ * Get the LogStampGetter function currently in use.
+ * \returns The LogStampGetter function.
+ */
+LogStampGetter LogGetStampGetter (void);
+
+/**
+ * \ingroup logbinary
+ * Send the output of the logging macros to a binary log file.
+ *
+ * Same as running your program with the \c NS_LOG_BINARY environment
+ * variable set to \p filename.  Any binary log file already open is
+ * closed first.
+ *
+ * \param [in] filename The binary log file name.
+ * \param [in] bufferSize The size of the per-thread buffers, in bytes.
+ *             This applies to the buffers of threads which did not
+ *             log anything yet.
+ */
+void LogBinaryEnable (std::string filename, uint32_t bufferSize = 64 * 1024);
+/**
+ * \ingroup logbinary
+ * Flush the buffer of the calling thread, close the binary log file,
+ * and send the output of the logging macros back to \c std::clog.
+ *
+ * The other threads should not be logging while this is called.
+ * Records they buffered and did not write yet are dropped.
+ */
+void LogBinaryDisable (void);
+/**
+ * \ingroup logbinary
+ * Write the content of the buffer of the calling thread to the
+ * binary log file.
+ */
+void LogBinaryFlush (void);
+/**
+ * \ingroup logbinary
+ * Decode a binary log file to text.
+ *
+ * \param [in] is The binary log input.
+ * \param [out] os The text output.
+ * \returns \c true if the whole input was decoded, \c false if it is
+ *          not a binary log file or is truncated.
+ */
+bool LogBinaryDecode (std::istream &is, std::ostream &os);
+
+/**
+ * \ingroup logbinary
+ * Whether the logging macros write to the binary backend.
+ * This is private to the logging implementation.
+ */
+extern bool g_logBinary;
+
+/**
+ * \ingroup logbinary
+ * A logging macro call site.
+ *
+ * The macros create one static LogSite per call site the first time it
+ * logs to the binary backend.  Its definition is written to the log
+ * file once, before the first record which uses it.
+ */
+class LogSite
+{
+public:
+  /**
+   * Constructor.
+   *
+   * \param [in] component The log component of the call site.
+   * \param [in] function The function name.
+   * \param [in] file The source file name.
+   * \param [in] line The source line.
+   * \param [in] isFunction Whether this is a NS_LOG_FUNCTION() call site,
+   *             whose arguments are separated by `, `.
+   */
+  LogSite (const LogComponent &component, const char *function,
+           const char *file, uint32_t line, bool isFunction);
+
+private:
+  friend class LogRecord;
+
+  const LogComponent *m_component; //!< The log component.
+  const char *m_function;          //!< The function name.
+  const char *m_file;              //!< The source file name.
+  uint32_t m_line;                 //!< The source line.
+  bool m_isFunction;               //!< NS_LOG_FUNCTION() call site.
+  uint32_t m_id;                   //!< Site id, 0 until first defined.
+  volatile uint32_t m_generation;  //!< Log file the site was defined in.
+};
+
+/**
+ * \ingroup logbinary
+ * Build and commit one binary log record.
+ *
+ * The record is assembled in a local buffer while the arguments are
+ * streamed in, and appended to the per-thread buffer by the destructor,
+ * so that logging from an \c operator<< called while streaming a
+ * record is safe.
+ */
+class LogRecord
+{
+public:
+  /**
+   * Start a record.
+   *
+   * \param [in] site The call site.
+   * \param [in] level The log level of the record.
+   */
+  LogRecord (LogSite &site, enum LogLevel level);
+  /** Commit the record. */
+  ~LogRecord ();
+
+  /**
+   * \name Append an argument to the record.
+   * \param [in] v The argument.
+   * \returns This LogRecord, so it's chainable.
+   */
+  /**@{*/
+  LogRecord & operator<< (bool v)
+  {
+    return PutRaw ('b', static_cast<uint8_t> (v), v);
+  }
+  LogRecord & operator<< (char v)
+  {
+    return PutRaw ('c', v, v);
+  }
+  LogRecord & operator<< (signed char v)
+  {
+    return PutRaw ('c', static_cast<char> (v), v);
+  }
+  LogRecord & operator<< (unsigned char v)
+  {
+    return PutRaw ('c', static_cast<char> (v), v);
+  }
+  LogRecord & operator<< (short v)
+  {
+    return PutRaw ('i', static_cast<int64_t> (v), v);
+  }
+  LogRecord & operator<< (unsigned short v)
+  {
+    return PutRaw ('u', static_cast<uint64_t> (v), v);
+  }
+  LogRecord & operator<< (int v)
+  {
+    return PutRaw ('i', static_cast<int64_t> (v), v);
+  }
+  LogRecord & operator<< (unsigned int v)
+  {
+    return PutRaw ('u', static_cast<uint64_t> (v), v);
+  }
+  LogRecord & operator<< (long v)
+  {
+    return PutRaw ('i', static_cast<int64_t> (v), v);
+  }
+  LogRecord & operator<< (unsigned long v)
+  {
+    return PutRaw ('u', static_cast<uint64_t> (v), v);
+  }
+  LogRecord & operator<< (long long v)
+  {
+    return PutRaw ('i', static_cast<int64_t> (v), v);
+  }
+  LogRecord & operator<< (unsigned long long v)
+  {
+    return PutRaw ('u', static_cast<uint64_t> (v), v);
+  }
+  LogRecord & operator<< (float v)
+  {
+    return PutRaw ('d', static_cast<double> (v), v);
+  }
+  LogRecord & operator<< (double v)
+  {
+    return PutRaw ('d', v, v);
+  }
+  LogRecord & operator<< (long double v)
+  {
+    return PutRaw ('d', static_cast<double> (v), v);
+  }
+  LogRecord & operator<< (const char *v)
+  {
+    return PutString (v, v == 0 ? 0 : std::strlen (v));
+  }
+  LogRecord & operator<< (char *v)
+  {
+    return PutString (v, v == 0 ? 0 : std::strlen (v));
+  }
+  LogRecord & operator<< (const signed char *v)
+  {
+    return *this << reinterpret_cast<const char *> (v);
+  }
+  LogRecord & operator<< (const unsigned char *v)
+  {
+    return *this << reinterpret_cast<const char *> (v);
+  }
+  LogRecord & operator<< (const std::string &v)
+  {
+    return PutString (v.data (), v.size ());
+  }
+  LogRecord & operator<< (std::string &v)
+  {
+    return PutString (v.data (), v.size ());
+  }
+  template <typename T>
+  LogRecord & operator<< (T *v)
+  {
+    return PutPointer (v);
+  }
+  template <typename T>
+  LogRecord & operator<< (const Ptr<T> &v)
+  {
+    return *this << PeekPointer (v);
+  }
+  template <typename T>
+  LogRecord & operator<< (Ptr<T> &v)
+  {
+    return *this << PeekPointer (v);
+  }
+  template <typename T>
+  LogRecord & operator<< (const T &v)
+  {
+    Text () << v;
+    return *this;
+  }
+  template <typename T>
+  LogRecord & operator<< (T &v)
+  {
+    Text () << v;
+    return *this;
+  }
+  /**@}*/
+
+  /**
+   * \name Apply an I/O manipulator.
+   * Manipulators switch the rest of the record to text.
+   * \param [in] f The manipulator.
+   * \returns This LogRecord, so it's chainable.
+   */
+  /**@{*/
+  LogRecord & operator<< (std::ostream & (*f)(std::ostream &));
+  LogRecord & operator<< (std::ios & (*f)(std::ios &));
+  LogRecord & operator<< (std::ios_base & (*f)(std::ios_base &));
+  /**@}*/
+
+private:
+  /** Copy constructor, not implemented. */
+  LogRecord (const LogRecord &);
+  /**
+   * Assignment, not implemented.
+   * \returns This LogRecord.
+   */
+  LogRecord & operator= (const LogRecord &);
+
+  /**
+   * Append a fixed size argument.
+   * \param [in] tag The argument type tag.
+   * \param [in] raw The argument value as stored.
+   * \param [in] v The argument value as streamed in text mode.
+   * \returns This LogRecord.
+   */
+  template <typename R, typename V>
+  LogRecord & PutRaw (char tag, R raw, V v)
+  {
+    if (m_text != 0)
+      {
+        Text () << v;
+      }
+    else
+      {
+        Reserve (1 + sizeof (raw));
+        m_data[m_size] = tag;
+        std::memcpy (m_data + m_size + 1, &raw, sizeof (raw));
+        m_size += 1 + sizeof (raw);
+        m_args++;
+      }
+    return *this;
+  }
+  /**
+   * Append an object pointer argument.
+   * \param [in] v The pointer.
+   * \returns This LogRecord.
+   */
+  LogRecord & PutPointer (const void *v)
+  {
+    return PutRaw ('p', static_cast<uint64_t> (reinterpret_cast<uintptr_t> (v)), v);
+  }
+  /**
+   * Append a function pointer argument, which std::ostream
+   * prints as a boolean.
+   * \param [in] v The pointer, converted to bool.
+   * \returns This LogRecord.
+   */
+  LogRecord & PutPointer (bool v)
+  {
+    return *this << v;
+  }
+  /**
+   * Append a string argument.
+   * \param [in] s The string, possibly 0.
+   * \param [in] n The string length.
+   * \returns This LogRecord.
+   */
+  LogRecord & PutString (const char *s, std::size_t n);
+  /**
+   * Assign an id to a call site, and write its definition
+   * to the current log file.
+   * \param [in] site The call site.
+   */
+  static void Define (LogSite &site);
+  /**
+   * Make room for \p n more bytes.
+   * \param [in] n The number of bytes.
+   */
+  void Reserve (std::size_t n)
+  {
+    if (m_size + n > m_capacity)
+      {
+        Grow (n);
+      }
+  }
+  /**
+   * Grow the record buffer.
+   * \param [in] n The number of bytes needed.
+   */
+  void Grow (std::size_t n);
+  /**
+   * Switch the record to text, and output the argument separator
+   * if needed.
+   * \returns The text stream.
+   */
+  std::ostream & Text (void);
+  /**
+   * Switch the record to text without separator.
+   * \returns The text stream.
+   */
+  std::ostream & TextStream (void);
+
+  /** Size of the buffer embedded in the record. */
+  static const uint32_t INLINE_SIZE = 256;
+
+  LogSite &m_site;                 //!< The call site.
+  std::ostringstream *m_text;      //!< Text arguments, if any.
+  char *m_data;                    //!< The record bytes.
+  uint32_t m_size;                 //!< Number of record bytes used.
+  uint32_t m_capacity;             //!< Size of m_data.
+  uint32_t m_args;                 //!< Number of arguments streamed.
+  char m_inline[INLINE_SIZE];      //!< Embedded record buffer.
+};
+
+} // namespace ns3
+
+#endif /* NS3_LOG_BINARY_H */
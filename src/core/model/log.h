@@ -48,6 +48,10 @@
  * messages, use the ns3::LogComponentEnable
  * function or use the NS_LOG environment variable 
  *
+ * Set the \c NS_LOG_BINARY environment variable to a file name to
+ * write compact binary records to that file instead of formatting
+ * the messages on \c std::clog; see \ref logbinary.
+ *
  * Use the environment variable NS_LOG to define a ':'-separated list of
  * logging components to enable. For example (using bash syntax),
  * \code
@@ -452,4 +456,6 @@ public:
 
 /**@}*/  // \ingroup logging
 
+#include "log-binary.h"
+
 #endif /* NS3_LOG_H */
@@ -441,11 +441,29 @@ public:
   }
   inline static Time FromDouble (double value, enum Unit unit)
   {
+    struct Information *info = PeekInformation (unit);
+    // Integral values in a coarser unit, such as Seconds (10.0),
+    // convert exactly with a single integer multiplication.
+    if (info->fromMul
+        && value >= -MAX_INTEGRAL_DOUBLE && value <= MAX_INTEGRAL_DOUBLE)
+      {
+        int64_t v = static_cast<int64_t> (value);
+        if (v == value && v <= info->maxFrom && v >= -info->maxFrom)
+          {
+            return Time (v * info->factor);
+          }
+      }
     return From (int64x64_t (value), unit);
   }
   inline static Time From (const int64x64_t & value, enum Unit unit)
   {
     struct Information *info = PeekInformation (unit);
+    if (info->fromMul && value.GetLow () == 0
+        && value.GetHigh () <= info->maxFrom
+        && value.GetHigh () >= -info->maxFrom)
+      {
+        return Time (value.GetHigh () * info->factor);
+      }
     // DO NOT REMOVE this temporary variable. It's here
     // to work around a compiler bug in gcc 3.4
     int64x64_t retval = value;
@@ -490,6 +508,15 @@ public:
   }
   inline double ToDouble (enum Unit unit) const
   {
+    struct Information *info = PeekInformation (unit);
+    // Converting to the current or a coarser unit, such as
+    // GetSeconds (), only needs a correctly rounded floating point
+    // division for any Time which fits in the double mantissa.
+    if ((!info->toMul || info->factor == 1)
+        && m_data >= -MAX_INTEGRAL_DOUBLE && m_data <= MAX_INTEGRAL_DOUBLE)
+      {
+        return static_cast<double> (m_data) / info->factor;
+      }
     return To (unit).GetDouble ();
   }
   inline int64x64_t To (enum Unit unit) const
@@ -532,12 +559,19 @@ public:
   TimeWithUnit As (const enum Unit unit) const;
 
 private:
+  /**
+   * Largest magnitude up to which every integer is exactly
+   * representable as a double (2^53).
+   */
+  static const int64_t MAX_INTEGRAL_DOUBLE = 9007199254740992LL;
+
   /** How to convert between other units and the current unit. */
   struct Information
   {
     bool toMul;                     //!< Multiply when converting To, otherwise divide
     bool fromMul;                   //!< Multiple when converting From, otherwise divide
     int64_t factor;                 //!< Ratio of this unit / current unit
+    int64_t maxFrom;                //!< Largest magnitude converted From this unit by an integer multiply
     int64x64_t timeTo;              //!< Multiplier to convert to this unit
     int64x64_t timeFrom;            //!< Multiplier to convert from this unit
   };
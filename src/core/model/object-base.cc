@@ -57,6 +57,25 @@ GetObjectIid (void)
   return tid;
 }
 
+#ifdef HAVE_GETENV
+/**
+ * Get the value of the \c NS_ATTRIBUTE_DEFAULT environment variable.
+ *
+ * The variable is read on first use only, not on every object
+ * construction.
+ *
+ * \relates ns3::ObjectBase
+ *
+ * \return The value of the variable, or 0 if it is not set.
+ */
+static const char *
+GetAttributeDefaultEnv (void)
+{
+  static const char *envVar = getenv ("NS_ATTRIBUTE_DEFAULT");
+  return envVar;
+}
+#endif /* HAVE_GETENV */
+
 TypeId 
 ObjectBase::GetTypeId (void)
 {
@@ -81,6 +100,9 @@ ObjectBase::ConstructSelf (const AttributeConstructionList &attributes)
 {
   // loop over the inheritance tree back to the Object base class.
   NS_LOG_FUNCTION (this << &attributes);
+#ifdef HAVE_GETENV
+  const char *envVar = GetAttributeDefaultEnv ();
+#endif /* HAVE_GETENV */
   TypeId tid = GetInstanceTypeId ();
   do {
       // loop over all attributes in object type
@@ -128,7 +150,6 @@ ObjectBase::ConstructSelf (const AttributeConstructionList &attributes)
             {
               // No matching attribute value so we try to look at the env var.
 #ifdef HAVE_GETENV
-              char *envVar = getenv ("NS_ATTRIBUTE_DEFAULT");
               if (envVar != 0)
                 {
                   std::string env = std::string (envVar);
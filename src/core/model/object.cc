@@ -97,11 +97,13 @@ Object::Object ()
   : m_tid (Object::GetTypeId ()),
     m_disposed (false),
     m_initialized (false),
-    m_aggregates ((struct Aggregates *) std::malloc (sizeof (struct Aggregates))),
-    m_getObjectCount (0)
+    m_aggregates ((struct Aggregates *) std::malloc (sizeof (struct Aggregates)))
 {
   NS_LOG_FUNCTION (this);
   m_aggregates->n = 1;
+  m_aggregates->indexMask = 0;
+  m_aggregates->index = 0;
+  m_aggregates->untyped = false;
   m_aggregates->buffer[0] = this;
 }
 Object::~Object () 
@@ -120,6 +122,8 @@ Object::~Object ()
           m_aggregates->n--;
         }
     }
+  // the index may point to this object: drop it.
+  FreeIndex (m_aggregates);
   // finally, if all objects have been removed from the list,
   // delete the aggregate list
   if (m_aggregates->n == 0)
@@ -132,10 +136,12 @@ Object::Object (const Object &o)
   : m_tid (o.m_tid),
     m_disposed (false),
     m_initialized (false),
-    m_aggregates ((struct Aggregates *) std::malloc (sizeof (struct Aggregates))),
-    m_getObjectCount (0)
+    m_aggregates ((struct Aggregates *) std::malloc (sizeof (struct Aggregates)))
 {
   m_aggregates->n = 1;
+  m_aggregates->indexMask = 0;
+  m_aggregates->index = 0;
+  m_aggregates->untyped = false;
   m_aggregates->buffer[0] = this;
 }
 void
@@ -145,39 +151,130 @@ Object::Construct (const AttributeConstructionList &attributes)
   ConstructSelf (attributes);
 }
 
+/**
+ * Check if the parent of a TypeId can be indexed.
+ *
+ * \param [in] tid The TypeId.
+ * \returns \c true if \p tid has a registered parent.
+ */
+static bool
+HasIndexedParent (TypeId tid)
+{
+  return tid.HasParent () && tid.GetParent ().GetUid () != 0;
+}
+
 Ptr<Object>
 Object::DoGetObject (TypeId tid) const
 {
   NS_LOG_FUNCTION (this << tid);
   NS_ASSERT (CheckLoose ());
 
-  uint32_t n = m_aggregates->n;
+  if (m_aggregates->index == 0)
+    {
+      // Objects which were never aggregated are not indexed: walking
+      // the parents of their TypeId is as fast as a lookup, and avoids
+      // an allocation for every Object.
+      TypeId objectTid = Object::GetTypeId ();
+      m_aggregates->untyped = false;
+      for (uint32_t i = 0; i < m_aggregates->n; i++)
+        {
+          Object *current = m_aggregates->buffer[i];
+          TypeId cur = current->GetInstanceTypeId ();
+          if (cur == objectTid)
+            {
+              m_aggregates->untyped = true;
+            }
+          while (cur != tid && cur != objectTid && HasIndexedParent (cur))
+            {
+              cur = cur.GetParent ();
+            }
+          if (cur == tid)
+            {
+              return current;
+            }
+        }
+      return 0;
+    }
+  uint16_t uid = tid.GetUid ();
+  uint32_t mask = m_aggregates->indexMask;
+  for (uint32_t i = uid & mask; ; i = (i + 1) & mask)
+    {
+      const struct IndexEntry &entry = m_aggregates->index[i];
+      if (entry.uid == uid)
+        {
+          return entry.object;
+        }
+      if (entry.uid == 0)
+        {
+          return 0;
+        }
+    }
+}
+void
+Object::BuildIndex (struct Aggregates *aggregates)
+{
+  NS_LOG_FUNCTION (aggregates);
   TypeId objectTid = Object::GetTypeId ();
-  for (uint32_t i = 0; i < n; i++)
+  uint32_t entries = 0;
+  aggregates->untyped = false;
+  for (uint32_t i = 0; i < aggregates->n; i++)
     {
-      Object *current = m_aggregates->buffer[i];
-      TypeId cur = current->GetInstanceTypeId ();
-      while (cur != tid && cur != objectTid)
+      TypeId cur = aggregates->buffer[i]->GetInstanceTypeId ();
+      if (cur == objectTid)
+        {
+          aggregates->untyped = true;
+        }
+      entries++;
+      while (cur != objectTid && HasIndexedParent (cur))
         {
           cur = cur.GetParent ();
+          entries++;
         }
-      if (cur == tid)
+    }
+  // Keep the table at most half full so that lookups for TypeIds which
+  // are not in the aggregate stop early.
+  uint32_t size = 4;
+  while (size < 2 * entries)
+    {
+      size *= 2;
+    }
+  FreeIndex (aggregates);
+  aggregates->index = (struct IndexEntry *) std::calloc (size, sizeof (struct IndexEntry));
+  aggregates->indexMask = size - 1;
+  for (uint32_t i = 0; i < aggregates->n; i++)
+    {
+      Object *current = aggregates->buffer[i];
+      TypeId cur = current->GetInstanceTypeId ();
+      while (true)
         {
-          // This is an attempt to 'cache' the result of this lookup.
-          // the idea is that if we perform a lookup for a TypeId on this object,
-          // we are likely to perform the same lookup later so, we make sure
-          // that the aggregate array is sorted by the number of accesses
-          // to each object.
-
-          // first, increment the access count
-          current->m_getObjectCount++;
-          // then, update the sort
-          UpdateSortedArray (m_aggregates, i);
-          // finally, return the match
-          return const_cast<Object *> (current);
+          uint16_t uid = cur.GetUid ();
+          uint32_t j = uid & aggregates->indexMask;
+          while (aggregates->index[j].uid != 0 && aggregates->index[j].uid != uid)
+            {
+              j = (j + 1) & aggregates->indexMask;
+            }
+          // When several aggregates share a parent TypeId,
+          // the first one in the list wins.
+          if (aggregates->index[j].uid == 0)
+            {
+              aggregates->index[j].uid = uid;
+              aggregates->index[j].object = current;
+            }
+          if (cur == objectTid || !HasIndexedParent (cur))
+            {
+              break;
+            }
+          cur = cur.GetParent ();
         }
     }
-  return 0;
+}
+void
+Object::FreeIndex (struct Aggregates *aggregates)
+{
+  NS_LOG_FUNCTION (aggregates);
+  std::free (aggregates->index);
+  aggregates->index = 0;
+  aggregates->indexMask = 0;
 }
 void
 Object::Initialize (void)
@@ -185,9 +282,8 @@ Object::Initialize (void)
   /**
    * Note: the code here is a bit tricky because we need to protect ourselves from
    * modifications in the aggregate array while DoInitialize is called. The user's
-   * implementation of the DoInitialize method could call GetObject (which could
-   * reorder the array) and it could call AggregateObject which would add an 
-   * object at the end of the array. To be safe, we restart iteration over the 
+   * implementation of the DoInitialize method could call AggregateObject which
+   * would replace the array. To be safe, we restart iteration over the 
    * array whenever we call some user code, just in case.
    */
   NS_LOG_FUNCTION (this);
@@ -210,8 +306,7 @@ Object::Dispose (void)
   /**
    * Note: the code here is a bit tricky because we need to protect ourselves from
    * modifications in the aggregate array while DoDispose is called. The user's
-   * DoDispose implementation could call GetObject (which could reorder the array) 
-   * and it could call AggregateObject which would add an object at the end of the array.
+   * DoDispose implementation could call AggregateObject which would replace the array.
    * So, to be safe, we restart the iteration over the array whenever we call some
    * user code.
    */
@@ -229,19 +324,6 @@ restart:
         }
     }
 }
-void
-Object::UpdateSortedArray (struct Aggregates *aggregates, uint32_t j) const
-{
-  NS_LOG_FUNCTION (this << aggregates << j);
-  while (j > 0 && 
-         aggregates->buffer[j]->m_getObjectCount > aggregates->buffer[j-1]->m_getObjectCount)
-    {
-      Object *tmp = aggregates->buffer[j-1];
-      aggregates->buffer[j-1] = aggregates->buffer[j];
-      aggregates->buffer[j] = tmp;
-      j--;
-    }
-}
 void 
 Object::AggregateObject (Ptr<Object> o)
 {
@@ -264,6 +346,8 @@ Object::AggregateObject (Ptr<Object> o)
   struct Aggregates *aggregates = 
     (struct Aggregates *)std::malloc (sizeof(struct Aggregates)+(total-1)*sizeof(Object*));
   aggregates->n = total;
+  aggregates->indexMask = 0;
+  aggregates->index = 0;
 
   // copy our buffer to the new buffer
   std::memcpy (&aggregates->buffer[0], 
@@ -271,11 +355,12 @@ Object::AggregateObject (Ptr<Object> o)
           m_aggregates->n*sizeof(Object*));
 
   // append the other buffer into the new buffer too
-  for (uint32_t i = 0; i < other->m_aggregates->n; i++)
-    {
-      aggregates->buffer[m_aggregates->n+i] = other->m_aggregates->buffer[i];
-      UpdateSortedArray (aggregates, m_aggregates->n + i);
-    }
+  std::memcpy (&aggregates->buffer[m_aggregates->n], 
+          &other->m_aggregates->buffer[0], 
+          other->m_aggregates->n*sizeof(Object*));
+
+  // and index the whole list
+  BuildIndex (aggregates);
 
   // keep track of the old aggregate buffers for the iteration
   // of NotifyNewAggregates
@@ -307,6 +392,8 @@ Object::AggregateObject (Ptr<Object> o)
     }
 
   // Now that we are done with them, we can free our old aggregate buffers
+  FreeIndex (a);
+  FreeIndex (b);
   std::free (a);
   std::free (b);
 }
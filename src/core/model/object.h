@@ -316,6 +316,17 @@ private:
   friend class AggregateIterator;
   friend struct ObjectDeleter;
 
+  /**
+   * An entry of the aggregate index: an Object found by GetObject()
+   * for a TypeId uid.
+   */
+  struct IndexEntry {
+    /** The TypeId uid, or 0 for an empty entry. */
+    uint16_t uid;
+    /** The Object returned for this uid. */
+    Object *object;
+  };
+
   /**
    * The list of Objects aggregated to this one.
    *
@@ -327,10 +338,26 @@ private:
    * chunk of memory than the struct to allow space for a larger
    * variable sized buffer whose size is indicated by the element
    * \c n
+   *
+   * The list of an aggregation also owns an open-addressing hash
+   * table which maps the uid of the TypeId of every aggregated
+   * Object, and of all its parent TypeIds, to that Object.  The
+   * table is built by AggregateObject() and dropped when an Object
+   * leaves the list.
    */
   struct Aggregates {
     /** The number of entries in \c buffer. */
     uint32_t n;
+    /** The number of entries in \c index, minus one, or 0. */
+    uint32_t indexMask;
+    /** The index by TypeId uid, or 0 until it is built. */
+    struct IndexEntry *index;
+    /**
+     * Whether an aggregated Object was not constructed through
+     * CreateObject() or an ObjectFactory, and so only knows its
+     * TypeId as ns3::Object.  Valid after a failed DoGetObject().
+     */
+    bool untyped;
     /** The array of Objects. */
     Object *buffer[1];
   };
@@ -383,12 +410,17 @@ private:
   void Construct (const AttributeConstructionList &attributes);
 
   /**
-   * Keep the list of aggregates in most-recently-used order
+   * Build the index of a list of aggregates by TypeId uid.
+   *
+   * \param [in,out] aggregates The list of aggregated Objects.
+   */
+  static void BuildIndex (struct Aggregates *aggregates);
+  /**
+   * Drop the index of a list of aggregates.
    *
    * \param [in,out] aggregates The list of aggregated Objects.
-   * \param [in] i The most recently used entry in the list.
    */
-  void UpdateSortedArray (struct Aggregates *aggregates, uint32_t i) const;
+  static void FreeIndex (struct Aggregates *aggregates);
   /**
    * Attempt to delete this Object.
    *
@@ -420,14 +452,6 @@ private:
    * so the size of the array is indirectly a reference count.
    */
   struct Aggregates * m_aggregates;
-  /**
-   * The number of times the Object was accessed with a
-   * call to GetObject().
-   *
-   * This integer is used to implement a heuristic to sort
-   * the array of aggregates in most-frequently accessed order.
-   */
-  uint32_t m_getObjectCount;
 };
 
 template <typename T>
@@ -467,6 +491,19 @@ Object::GetObject () const
     {
       return Ptr<T> (static_cast<T *> (PeekPointer (found)));
     }
+  // Objects which only know their TypeId as ns3::Object are not
+  // in the index under their real type: try a C++ type check.
+  if (m_aggregates->untyped)
+    {
+      for (uint32_t i = 1; i < m_aggregates->n; i++)
+        {
+          result = dynamic_cast<T *> (m_aggregates->buffer[i]);
+          if (result != 0)
+            {
+              return Ptr<T> (result);
+            }
+        }
+    }
   return 0;
 }
 
@@ -28,6 +28,7 @@
 #include "boolean.h"
 #include "double.h"
 #include "integer.h"
+#include "uinteger.h"
 #include "string.h"
 #include "pointer.h"
 #include "log.h"
@@ -72,7 +73,9 @@ RandomVariableStream::GetTypeId (void)
 }
 
 RandomVariableStream::RandomVariableStream()
-  : m_rng (0)
+  : m_rng (0),
+    m_bufferPos (0),
+    m_bufferSize (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -122,6 +125,9 @@ RandomVariableStream::SetStream (int64_t stream)
                              RngSeedManager::GetRun ());
     }
   m_stream = stream;
+  // Uniforms buffered from the previous stream are no longer valid.
+  m_buffer.clear ();
+  m_bufferPos = 0;
 }
 int64_t
 RandomVariableStream::GetStream(void) const
@@ -137,6 +143,58 @@ RandomVariableStream::Peek(void) const
   return m_rng;
 }
 
+void
+RandomVariableStream::GetValues (double *values, uint32_t count)
+{
+  NS_LOG_FUNCTION (this << values << count);
+  for (uint32_t i = 0; i < count; ++i)
+    {
+      values[i] = GetValue ();
+    }
+}
+
+void
+RandomVariableStream::FillU01 (double *u, uint32_t count)
+{
+  NS_LOG_FUNCTION (this << u << count);
+  uint32_t i = 0;
+  while (i < count && m_bufferPos < m_buffer.size ())
+    {
+      u[i++] = m_buffer[m_bufferPos++];
+    }
+  if (i < count)
+    {
+      m_rng->RandU01 (u + i, count - i);
+    }
+}
+
+void
+RandomVariableStream::SetBufferSize (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  m_bufferSize = size;
+}
+
+uint32_t
+RandomVariableStream::GetBufferSize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_bufferSize;
+}
+
+double
+RandomVariableStream::DoRandU01 (void)
+{
+  if (m_bufferSize == 0)
+    {
+      return m_rng->RandU01 ();
+    }
+  m_buffer.resize (m_bufferSize);
+  m_rng->RandU01 (&m_buffer[0], m_bufferSize);
+  m_bufferPos = 1;
+  return m_buffer[0];
+}
+
 NS_OBJECT_ENSURE_REGISTERED(UniformRandomVariable);
 
 TypeId 
@@ -180,7 +238,7 @@ double
 UniformRandomVariable::GetValue (double min, double max)
 {
   NS_LOG_FUNCTION (this << min << max);
-  double v = min + Peek ()->RandU01 () * (max - min);
+  double v = min + RandU01 () * (max - min);
   if (IsAntithetic ())
     {
       v = min + (max - v);
@@ -207,6 +265,21 @@ UniformRandomVariable::GetInteger (void)
   NS_LOG_FUNCTION (this);
   return (uint32_t)GetValue (m_min, m_max + 1);
 }
+void
+UniformRandomVariable::GetValues (double *values, uint32_t count)
+{
+  NS_LOG_FUNCTION (this << values << count);
+  FillU01 (values, count);
+  for (uint32_t i = 0; i < count; ++i)
+    {
+      double v = m_min + values[i] * (m_max - m_min);
+      if (IsAntithetic ())
+        {
+          v = m_min + (m_max - v);
+        }
+      values[i] = v;
+    }
+}
 
 NS_OBJECT_ENSURE_REGISTERED(ConstantRandomVariable);
 
@@ -380,6 +453,12 @@ ExponentialRandomVariable::GetTypeId (void)
 		  DoubleValue(0.0),
 		  MakeDoubleAccessor(&ExponentialRandomVariable::m_bound),
 		  MakeDoubleChecker<double>())
+    .AddAttribute("BufferSize", "The number of uniform random numbers generated at once "
+                  "by this RNG stream; 0 generates them one at a time.",
+                  UintegerValue(0),
+                  MakeUintegerAccessor(&ExponentialRandomVariable::SetBufferSize,
+                                       &ExponentialRandomVariable::GetBufferSize),
+                  MakeUintegerChecker<uint32_t>())
     ;
   return tid;
 }
@@ -409,7 +488,7 @@ ExponentialRandomVariable::GetValue (double mean, double bound)
   while (1)
     {
       // Get a uniform random variable in [0,1].
-      double v = Peek ()->RandU01 ();
+      double v = RandU01 ();
       if (IsAntithetic ())
         {
           v = (1 - v);
@@ -444,6 +523,27 @@ ExponentialRandomVariable::GetInteger (void)
   NS_LOG_FUNCTION (this);
   return (uint32_t)GetValue (m_mean, m_bound);
 }
+void
+ExponentialRandomVariable::GetValues (double *values, uint32_t count)
+{
+  NS_LOG_FUNCTION (this << values << count);
+  if (m_bound != 0)
+    {
+      // Rejected values consume extra uniforms.
+      RandomVariableStream::GetValues (values, count);
+      return;
+    }
+  FillU01 (values, count);
+  for (uint32_t i = 0; i < count; ++i)
+    {
+      double v = values[i];
+      if (IsAntithetic ())
+        {
+          v = (1 - v);
+        }
+      values[i] = -m_mean*std::log (v);
+    }
+}
 
 NS_OBJECT_ENSURE_REGISTERED(ParetoRandomVariable);
 
@@ -505,7 +605,7 @@ ParetoRandomVariable::GetValue (double mean, double shape, double bound)
   while (1)
     {
       // Get a uniform random variable in [0,1].
-      double v = Peek ()->RandU01 ();
+      double v = RandU01 ();
       if (IsAntithetic ())
         {
           v = (1 - v);
@@ -599,7 +699,7 @@ WeibullRandomVariable::GetValue (double scale, double shape, double bound)
   while (1)
     {
       // Get a uniform random variable in [0,1].
-      double v = Peek ()->RandU01 ();
+      double v = RandU01 ();
       if (IsAntithetic ())
         {
           v = (1 - v);
@@ -658,6 +758,12 @@ NormalRandomVariable::GetTypeId (void)
 		  DoubleValue(INFINITE_VALUE),
 		  MakeDoubleAccessor(&NormalRandomVariable::m_bound),
 		  MakeDoubleChecker<double>())
+    .AddAttribute("BufferSize", "The number of uniform random numbers generated at once "
+                  "by this RNG stream; 0 generates them one at a time.",
+                  UintegerValue(0),
+                  MakeUintegerAccessor(&NormalRandomVariable::SetBufferSize,
+                                       &NormalRandomVariable::GetBufferSize),
+                  MakeUintegerChecker<uint32_t>())
     ;
   return tid;
 }
@@ -702,8 +808,8 @@ NormalRandomVariable::GetValue (double mean, double variance, double bound)
     { // See Simulation Modeling and Analysis p. 466 (Averill Law)
       // for algorithm; basically a Box-Muller transform:
       // http://en.wikipedia.org/wiki/Box-Muller_transform
-      double u1 = Peek ()->RandU01 ();
-      double u2 = Peek ()->RandU01 ();
+      double u1 = RandU01 ();
+      double u2 = RandU01 ();
       if (IsAntithetic ())
         {
           u1 = (1 - u1);
@@ -754,6 +860,17 @@ NormalRandomVariable::GetInteger (void)
   NS_LOG_FUNCTION (this);
   return (uint32_t)GetValue (m_mean, m_variance, m_bound);
 }
+void
+NormalRandomVariable::GetValues (double *values, uint32_t count)
+{
+  NS_LOG_FUNCTION (this << values << count);
+  // The polar method rejects a variable number of uniforms, so the
+  // uniforms are drawn through the buffer, if enabled.
+  for (uint32_t i = 0; i < count; ++i)
+    {
+      values[i] = GetValue (m_mean, m_variance, m_bound);
+    }
+}
 
 NS_OBJECT_ENSURE_REGISTERED(LogNormalRandomVariable);
 
@@ -1018,8 +1135,8 @@ GammaRandomVariable::GetNormalValue (double mean, double variance, double bound)
     { // See Simulation Modeling and Analysis p. 466 (Averill Law)
       // for algorithm; basically a Box-Muller transform:
       // http://en.wikipedia.org/wiki/Box-Muller_transform
-      double u1 = Peek ()->RandU01 ();
-      double u2 = Peek ()->RandU01 ();
+      double u1 = RandU01 ();
+      double u2 = RandU01 ();
       if (IsAntithetic ())
         {
           u1 = (1 - u1);
@@ -1146,7 +1263,7 @@ ErlangRandomVariable::GetExponentialValue (double mean, double bound)
   while (1)
     {
       // Get a uniform random variable in [0,1].
-      double v = Peek ()->RandU01 ();
+      double v = RandU01 ();
       if (IsAntithetic ())
         {
           v = (1 - v);
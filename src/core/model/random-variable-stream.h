@@ -30,6 +30,7 @@
 #include "object.h"
 #include "attribute-helper.h"
 #include <stdint.h>
+#include <vector>
 
 /**
  * \file
@@ -93,6 +94,12 @@ class RngStream;
  * Instances can be configured to return "antithetic" values.
  * See the documentation for the specific distributions to see
  * how this modifies the returned values.
+ *
+ * Blocks of values can be drawn at once with GetValues(), which
+ * returns the same values as the same number of GetValue() calls.
+ * Some distributions can also buffer the uniform random numbers they
+ * consume, generating them in blocks of \c BufferSize values; the
+ * sequence of values returned is the same as without buffering.
  */
 class RandomVariableStream : public Object
 {
@@ -149,13 +156,69 @@ public:
    */
   virtual uint32_t GetInteger (void) = 0;
 
+  /**
+   * \brief Get the next \p count random values drawn from the distribution.
+   *
+   * This returns the same values as \p count calls to GetValue(void),
+   * but distributions which support it generate them as a block.
+   *
+   * \param [out] values The array to fill.
+   * \param [in] count The number of values to generate.
+   */
+  virtual void GetValues (double *values, uint32_t count);
+
 protected:
   /**
    * \brief Get the pointer to the underlying RNG stream.
    */
   RngStream *Peek(void) const;
 
+  /**
+   * \brief Get the next uniform random number of this stream,
+   * from the buffer if buffering is enabled.
+   *
+   * Subclasses which support buffering must draw all their uniforms
+   * through this method or FillU01(), rather than from Peek().
+   * \return A uniform random number on [0,1).
+   */
+  double RandU01 (void)
+  {
+    if (m_bufferPos < m_buffer.size ())
+      {
+        return m_buffer[m_bufferPos++];
+      }
+    return DoRandU01 ();
+  }
+  /**
+   * \brief Get the next \p count uniform random numbers of this stream.
+   *
+   * \param [out] u The array to fill with uniforms on [0,1).
+   * \param [in] count The number of values to generate.
+   */
+  void FillU01 (double *u, uint32_t count);
+
+  /**
+   * \brief Set the number of uniforms generated at once by RandU01(void).
+   *
+   * Values already buffered are still returned first, so changing the
+   * buffer size does not change the sequence of random numbers.
+   * \param [in] size The buffer size; 0 disables buffering.
+   */
+  void SetBufferSize (uint32_t size);
+  /**
+   * \brief Get the number of uniforms generated at once by RandU01(void).
+   * \return The buffer size; 0 means no buffering.
+   */
+  uint32_t GetBufferSize (void) const;
+
 private:
+  /**
+   * \brief Draw a uniform when the buffer is empty: refill the buffer
+   * or, if buffering is disabled, draw directly from the stream.
+   * \return A uniform random number on [0,1).
+   */
+  double DoRandU01 (void);
+
   /**
    * Copy constructor.  These objects are not copyable.
    *
@@ -186,6 +249,13 @@ private:
   /** The stream number for this RNG stream. */
   int64_t m_stream;
 
+  /** Uniforms generated ahead of use, when buffering is enabled. */
+  std::vector<double> m_buffer;
+  /** The index of the next unused value in m_buffer. */
+  uint32_t m_bufferPos;
+  /** The number of uniforms to generate at once, 0 to disable buffering. */
+  uint32_t m_bufferSize;
+
 };  // class RandomVariableStream
 
   
@@ -293,6 +363,7 @@ public:
    * \note The upper limit is included in the output range.
    */
   virtual uint32_t GetInteger (void);
+  virtual void GetValues (double *values, uint32_t count);
   
 private:
   /** The lower bound on values that can be returned by this RNG stream. */
@@ -533,6 +604,12 @@ private:
  *   \f]
  *
  * where again \f$u\f$ is a uniform random variable on \f$[0,1)\f$.
+ *
+ * \par Buffering
+ *
+ * Setting the \c BufferSize attribute to a non-zero value makes this
+ * RNG generate its uniforms in blocks, which is faster when many
+ * values are drawn.  The values returned are unchanged.
  */
 class ExponentialRandomVariable : public RandomVariableStream
 {
@@ -585,6 +662,7 @@ public:
   // Inherited from RandomVariableStream
   virtual double GetValue (void);
   virtual uint32_t GetInteger (void);
+  virtual void GetValues (double *values, uint32_t count);
 
 private:
   /** The mean value of the unbounded exponential distribution. */
@@ -1055,6 +1133,10 @@ private:
  *   // normally distributed random variable is equal to mean.
  *   double value = x->GetValue ();
  * \endcode
+ *
+ * Setting the \c BufferSize attribute to a non-zero value makes this
+ * RNG generate its uniforms in blocks, which is faster when many
+ * values are drawn.  The values returned are unchanged.
  */
 class NormalRandomVariable : public RandomVariableStream
 {
@@ -1242,6 +1324,7 @@ public:
    * which now involves the distances \f$u1\f$ and \f$u2\f$ are from 1.
    */
   virtual uint32_t GetInteger (void);
+  virtual void GetValues (double *values, uint32_t count);
 
 private:
   /** The mean value for the normal distribution returned by this RNG stream. */
@@ -23,6 +23,7 @@
 #include <cstdlib>
 #include <iostream>
 #include "rng-stream.h"
+#include "assert.h"
 #include "fatal-error.h"
 #include "log.h"
 
@@ -61,6 +62,14 @@ const double m2   =       4294944443.0;
 /// Normalization to obtain randoms on [0,1).
 const double norm =       1.0 / (m1 + 1.0);
   
+/// \ingroup rngimpl
+/// Reciprocal of the first component modulus.
+const double m1inv = 1.0 / m1;
+
+/// \ingroup rngimpl
+/// Reciprocal of the second component modulus.
+const double m2inv = 1.0 / m2;
+
 /// \ingroup rngimpl
 /// First component multiplier of <i>n</i> - 2 value.
 const double a12  =       1403580.0;
@@ -328,6 +337,31 @@ void PowerOfTwoMatrix (int n, Matrix a1p, Matrix a2p)
     }
 }
 
+/**
+ * \ingroup rngimpl
+ * Reduce an integer value modulo \p m.
+ *
+ * The quotient is estimated with a multiplication by the reciprocal
+ * of \p m, which may be off by one either way, and the remainder is
+ * corrected accordingly.  The result is the exact residue, the same as
+ * with a division, but the reduction has no division or branch, so it
+ * pipelines and vectorizes well.
+ *
+ * \param [in] p The value to reduce, an integer with \f$|p| < 2^{53}\f$.
+ * \param [in] m The modulus.
+ * \param [in] minv The reciprocal of \p m.
+ * \returns \f$p \bmod m\f$, in \f$[0, m)\f$.
+ */
+inline double
+ModM (double p, double m, double minv)
+{
+  int32_t k = static_cast<int32_t> (p * minv);
+  p -= k * m;
+  p += (p < 0.0) ? m : 0.0;
+  p -= (p >= m) ? m : 0.0;
+  return p;
+}
+
 } // end of anonymous namespace
 
 
@@ -337,27 +371,14 @@ namespace ns3 {
 //
 double RngStream::RandU01 ()
 {
-  int32_t k;
   double p1, p2, u;
 
   /* Component 1 */
-  p1 = a12 * m_currentState[1] - a13n * m_currentState[0];
-  k = static_cast<int32_t> (p1 / m1);
-  p1 -= k * m1;
-  if (p1 < 0.0)
-    {
-      p1 += m1;
-    }
+  p1 = ModM (a12 * m_currentState[1] - a13n * m_currentState[0], m1, m1inv);
   m_currentState[0] = m_currentState[1]; m_currentState[1] = m_currentState[2]; m_currentState[2] = p1;
 
   /* Component 2 */
-  p2 = a21 * m_currentState[5] - a23n * m_currentState[3];
-  k = static_cast<int32_t> (p2 / m2);
-  p2 -= k * m2;
-  if (p2 < 0.0)
-    {
-      p2 += m2;
-    }
+  p2 = ModM (a21 * m_currentState[5] - a23n * m_currentState[3], m2, m2inv);
   m_currentState[3] = m_currentState[4]; m_currentState[4] = m_currentState[5]; m_currentState[5] = p2;
 
   /* Combination */
@@ -366,6 +387,31 @@ double RngStream::RandU01 ()
   return u;
 }
 
+void
+RngStream::RandU01 (double *u, uint32_t n)
+{
+  double s0 = m_currentState[0];
+  double s1 = m_currentState[1];
+  double s2 = m_currentState[2];
+  double s3 = m_currentState[3];
+  double s4 = m_currentState[4];
+  double s5 = m_currentState[5];
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      double p1 = ModM (a12 * s1 - a13n * s0, m1, m1inv);
+      s0 = s1; s1 = s2; s2 = p1;
+      double p2 = ModM (a21 * s5 - a23n * s3, m2, m2inv);
+      s3 = s4; s4 = s5; s5 = p2;
+      u[i] = ((p1 > p2) ? (p1 - p2) * norm : (p1 - p2 + m1) * norm);
+    }
+  m_currentState[0] = s0;
+  m_currentState[1] = s1;
+  m_currentState[2] = s2;
+  m_currentState[3] = s3;
+  m_currentState[4] = s4;
+  m_currentState[5] = s5;
+}
+
 RngStream::RngStream (uint32_t seedNumber, uint64_t stream, uint64_t substream)
 {
   if (seedNumber >= m1 || seedNumber >= m2 || seedNumber == 0)
@@ -405,4 +451,70 @@ RngStream::AdvanceNthBy (uint64_t nth, int by, double state[6])
     }
 }
 
+RngStreamLanes::RngStreamLanes (uint32_t seed, uint64_t stream, uint64_t substream)
+{
+  for (uint32_t lane = 0; lane < LANES; ++lane)
+    {
+      SetLane (lane, RngStream (seed, stream, substream + lane));
+    }
+}
+
+void
+RngStreamLanes::SetLane (uint32_t lane, const RngStream &stream)
+{
+  NS_ASSERT (lane < LANES);
+  for (int i = 0; i < 6; ++i)
+    {
+      m_state[i][lane] = stream.m_currentState[i];
+    }
+}
+
+void
+RngStreamLanes::GetLane (uint32_t lane, RngStream *stream) const
+{
+  NS_ASSERT (lane < LANES);
+  for (int i = 0; i < 6; ++i)
+    {
+      stream->m_currentState[i] = m_state[i][lane];
+    }
+}
+
+void
+RngStreamLanes::RandU01 (double *u, uint32_t rows)
+{
+  // Same recurrence as RngStream::RandU01 (double *, uint32_t), with
+  // each scalar replaced by a row of lanes.
+  double s0[LANES], s1[LANES], s2[LANES], s3[LANES], s4[LANES], s5[LANES];
+  for (uint32_t l = 0; l < LANES; ++l)
+    {
+      s0[l] = m_state[0][l];
+      s1[l] = m_state[1][l];
+      s2[l] = m_state[2][l];
+      s3[l] = m_state[3][l];
+      s4[l] = m_state[4][l];
+      s5[l] = m_state[5][l];
+    }
+  for (uint32_t i = 0; i < rows; ++i)
+    {
+      double *out = u + i * LANES;
+      for (uint32_t l = 0; l < LANES; ++l)
+        {
+          double p1 = ModM (a12 * s1[l] - a13n * s0[l], m1, m1inv);
+          s0[l] = s1[l]; s1[l] = s2[l]; s2[l] = p1;
+          double p2 = ModM (a21 * s5[l] - a23n * s3[l], m2, m2inv);
+          s3[l] = s4[l]; s4[l] = s5[l]; s5[l] = p2;
+          out[l] = (p1 - p2 + ((p1 > p2) ? 0.0 : m1)) * norm;
+        }
+    }
+  for (uint32_t l = 0; l < LANES; ++l)
+    {
+      m_state[0][l] = s0[l];
+      m_state[1][l] = s1[l];
+      m_state[2][l] = s2[l];
+      m_state[3][l] = s3[l];
+      m_state[4][l] = s4[l];
+      m_state[5][l] = s5[l];
+    }
+}
+
 } // namespace ns3
@@ -70,8 +70,20 @@ public:
    * \returns The next random.
    */
   double RandU01 (void);
+  /**
+   * Generate the next \p n random numbers for this stream.
+   *
+   * This is equivalent to, but faster than, \p n calls to RandU01(void):
+   * the generator state stays in registers for the whole block.
+   *
+   * \param [out] u The array to fill with uniforms on [0,1).
+   * \param [in] n The number of values to generate.
+   */
+  void RandU01 (double *u, uint32_t n);
 
 private:
+  friend class RngStreamLanes;
+
   /**
    * Advance \p state of the RNG by leaps and bounds.
    *
@@ -85,6 +97,73 @@ private:
   double m_currentState[6];
 };
 
+/**
+ * \ingroup rngimpl
+ *
+ * \brief Several MRG32k3a streams advanced together.
+ *
+ * The state of LANES independent RngStream instances is stored
+ * lane by lane, so that one step of all the streams is a sequence of
+ * identical operations on contiguous arrays which the compiler can
+ * map to SIMD instructions.  Each lane performs exactly the same
+ * double precision computation as RngStream::RandU01(), so lane \c i
+ * returns bit for bit the sequence of the scalar stream it was
+ * loaded from.
+ *
+ * A typical use is to draw the variates of several substreams (for
+ * example, several independent replications of a run) at once:
+ * \code
+ *   RngStreamLanes lanes (seed, stream, firstRun);
+ *   double u[16 * RngStreamLanes::LANES];
+ *   lanes.RandU01 (u, 16);   // u[i * LANES + l] is the i-th value of lane l
+ * \endcode
+ */
+class RngStreamLanes
+{
+public:
+  /** The number of streams advanced together. */
+  static const uint32_t LANES = 4;
+
+  /**
+   * Construct LANES consecutive substreams of a stream: lane \c i
+   * starts as <tt>RngStream (seed, stream, substream + i)</tt>.
+   *
+   * \param [in] seed The starting seed.
+   * \param [in] stream The stream number.
+   * \param [in] substream The sub-stream number of the first lane.
+   */
+  RngStreamLanes (uint32_t seed, uint64_t stream, uint64_t substream);
+
+  /**
+   * Load the current state of a scalar stream into a lane.
+   *
+   * \param [in] lane The lane index, less than LANES.
+   * \param [in] stream The stream to copy.
+   */
+  void SetLane (uint32_t lane, const RngStream &stream);
+  /**
+   * Store the current state of a lane into a scalar stream, for
+   * example to continue it with RngStream::RandU01().
+   *
+   * \param [in] lane The lane index, less than LANES.
+   * \param [out] stream The stream to overwrite.
+   */
+  void GetLane (uint32_t lane, RngStream *stream) const;
+
+  /**
+   * Generate the next \p rows random numbers of every lane.
+   *
+   * \param [out] u The array to fill, of size <tt>rows * LANES</tt>;
+   *             <tt>u[i * LANES + l]</tt> is the i-th value of lane \c l.
+   * \param [in] rows The number of values to generate per lane.
+   */
+  void RandU01 (double *u, uint32_t rows);
+
+private:
+  /** The RNG state vectors, one column per lane. */
+  double m_state[6][LANES];
+};
+
 } // namespace ns3
 
 #endif
@@ -106,6 +106,20 @@ NodePrinter (std::ostream &os)
     }
 }
 
+/**
+ * \ingroup logging
+ * Default binary log stamp implementation.
+ *
+ * \param [out] seconds The current simulation time, in seconds.
+ * \param [out] context The current simulation context.
+ */
+static void
+StampGetter (double *seconds, uint32_t *context)
+{
+  *seconds = Simulator::Now ().GetSeconds ();
+  *context = Simulator::GetContext ();
+}
+
 /**
  * \ingroup simulator
  * \brief Get the static SimulatorImpl instance.
@@ -156,6 +170,7 @@ static SimulatorImpl * GetImpl (void)
 //
       LogSetTimePrinter (&TimePrinter);
       LogSetNodePrinter (&NodePrinter);
+      LogSetStampGetter (&StampGetter);
     }
   return *pimpl;
 }
@@ -177,6 +192,8 @@ Simulator::Destroy (void)
    */
   LogSetTimePrinter (0);
   LogSetNodePrinter (0);
+  LogSetStampGetter (0);
+  LogBinaryFlush ();
   (*pimpl)->Destroy ();
   (*pimpl)->Unref ();
   *pimpl = 0;
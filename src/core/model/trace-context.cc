@@ -0,0 +1,127 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "trace-context.h"
+#include "assert.h"
+#include "log.h"
+
+#include <deque>
+#include <map>
+
+/**
+ * \file
+ * \ingroup tracing
+ * ns3::TraceContext implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TraceContext");
+
+namespace {
+
+/**
+ * \ingroup tracing
+ * The interned contexts.
+ */
+struct TraceContextTable
+{
+  /** Create the table with the empty context. */
+  TraceContextTable ()
+  {
+    m_strings.push_back ("");
+    m_ids[""] = 0;
+  }
+  /** The context strings, by id: a deque keeps references valid. */
+  std::deque<std::string> m_strings;
+  /** The context ids, by string. */
+  std::map<std::string, uint32_t> m_ids;
+};
+
+/**
+ * \ingroup tracing
+ * \returns The table of interned contexts.
+ */
+TraceContextTable &
+GetTable (void)
+{
+  static TraceContextTable table;
+  return table;
+}
+
+} // unnamed namespace
+
+TraceContext
+TraceContext::Intern (const std::string &context)
+{
+  NS_LOG_FUNCTION (context);
+  TraceContextTable &table = GetTable ();
+  std::pair<std::map<std::string, uint32_t>::iterator, bool> ret =
+    table.m_ids.insert (std::make_pair (context, uint32_t (table.m_strings.size ())));
+  if (ret.second)
+    {
+      table.m_strings.push_back (context);
+    }
+  return TraceContext (ret.first->second);
+}
+
+bool
+TraceContext::Lookup (const std::string &context, TraceContext *result)
+{
+  NS_LOG_FUNCTION (context << result);
+  TraceContextTable &table = GetTable ();
+  std::map<std::string, uint32_t>::const_iterator i = table.m_ids.find (context);
+  if (i == table.m_ids.end ())
+    {
+      return false;
+    }
+  *result = TraceContext (i->second);
+  return true;
+}
+
+void
+TraceContext::Print (std::ostream &os)
+{
+  NS_LOG_FUNCTION (&os);
+  TraceContextTable &table = GetTable ();
+  for (uint32_t i = 0; i < table.m_strings.size (); ++i)
+    {
+      os << i << " " << table.m_strings[i] << std::endl;
+    }
+}
+
+uint32_t
+TraceContext::GetN (void)
+{
+  return GetTable ().m_strings.size ();
+}
+
+const std::string &
+TraceContext::GetString (void) const
+{
+  TraceContextTable &table = GetTable ();
+  NS_ASSERT (m_id < table.m_strings.size ());
+  return table.m_strings[m_id];
+}
+
+std::ostream &
+operator << (std::ostream &os, TraceContext context)
+{
+  os << context.GetString ();
+  return os;
+}
+
+} // namespace ns3
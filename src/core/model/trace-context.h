@@ -0,0 +1,133 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TRACE_CONTEXT_H
+#define TRACE_CONTEXT_H
+
+#include <string>
+#include <ostream>
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup tracing
+ * ns3::TraceContext declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup tracing
+ * \brief An interned trace context.
+ *
+ * The context of a trace sink connected with Config::Connect or
+ * TracedCallback::Connect is the path of the trace source.  Each
+ * distinct path is interned once, when the sink is connected, and
+ * identified afterwards by a small integer id.  The context is
+ * delivered to the sink according to the type of its first argument:
+ *   - \c TraceContext: only the id is passed; the sink calls
+ *     GetString() if, and when, it needs the path.  Sinks which log
+ *     the id can map it back to the path offline with Print().
+ *   - <tt>const std::string &</tt>: a reference to the interned path,
+ *     without a copy.
+ *   - \c std::string: a copy of the interned path, as before.
+ *
+ * Interned contexts are never released.  Id 0 is the empty context.
+ */
+class TraceContext
+{
+public:
+  /** The empty context. */
+  TraceContext () : m_id (0) {}
+  /**
+   * Intern a context.
+   *
+   * \param [in] context The context string.
+   * \returns The TraceContext of \p context.
+   */
+  static TraceContext Intern (const std::string &context);
+  /**
+   * Find an interned context, without interning it.
+   *
+   * \param [in] context The context string.
+   * \param [out] result The TraceContext of \p context, if found.
+   * \returns \c true if \p context was interned.
+   */
+  static bool Lookup (const std::string &context, TraceContext *result);
+  /**
+   * Write the table of interned contexts, one "id path" line each.
+   *
+   * \param [in,out] os The output stream.
+   */
+  static void Print (std::ostream &os);
+  /** \returns The number of interned contexts. */
+  static uint32_t GetN (void);
+
+  /** \returns The context id. */
+  uint32_t GetId (void) const { return m_id; }
+  /** \returns The context string, valid for the rest of the program. */
+  const std::string &GetString (void) const;
+
+private:
+  /**
+   * Construct from an id.
+   *
+   * \param [in] id The context id.
+   */
+  explicit TraceContext (uint32_t id) : m_id (id) {}
+
+  uint32_t m_id;   //!< The context id
+};
+
+/**
+ * \ingroup tracing
+ * Compare two TraceContexts.
+ *
+ * \param [in] a The first TraceContext.
+ * \param [in] b The second TraceContext.
+ * \returns \c true if \p a and \p b have the same context string.
+ */
+inline bool operator == (TraceContext a, TraceContext b)
+{
+  return a.GetId () == b.GetId ();
+}
+
+/**
+ * \ingroup tracing
+ * Compare two TraceContexts.
+ *
+ * \param [in] a The first TraceContext.
+ * \param [in] b The second TraceContext.
+ * \returns \c true if \p a and \p b have different context strings.
+ */
+inline bool operator != (TraceContext a, TraceContext b)
+{
+  return a.GetId () != b.GetId ();
+}
+
+/**
+ * \ingroup tracing
+ * Output streamer: writes the context string.
+ *
+ * \param [in,out] os The output stream.
+ * \param [in] context The TraceContext.
+ * \returns The stream.
+ */
+std::ostream & operator << (std::ostream &os, TraceContext context);
+
+} // namespace ns3
+
+#endif /* TRACE_CONTEXT_H */
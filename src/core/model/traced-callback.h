@@ -21,8 +21,10 @@
 #ifndef TRACED_CALLBACK_H
 #define TRACED_CALLBACK_H
 
-#include <list>
+#include <new>
+#include <vector>
 #include "callback.h"
+#include "trace-context.h"
 
 /**
  * \file
@@ -46,6 +48,10 @@ namespace ns3 {
  * calling one of the \c operator() forms with the appropriate
  * number of arguments.
  *
+ * The chain is stored contiguously, and invoking a TracedCallback
+ * with no Callback connected costs a single test.  Contexts are
+ * interned when Callbacks are connected, see TraceContext.
+ *
  * \tparam T1 \explicit Type of the first argument to the functor.
  * \tparam T2 \explicit Type of the second argument to the functor.
  * \tparam T3 \explicit Type of the third argument to the functor.
@@ -74,7 +80,9 @@ public:
    * Append a Callback to the chain with a context.
    *
    * The context string will be provided as the first argument
-   * to the Callback.
+   * to the Callback, as a TraceContext, a <tt>const std::string &</tt>
+   * or a \c std::string, following the type of that argument.
+   * Only the last one copies the context at each invocation.
    *
    * \param [in] callback Callback to add to chain.
    * \param [in] path Context string to provide when invoking the Callback.
@@ -222,6 +230,253 @@ public:
 
   
 private:
+  /**
+   * A Callback in the chain, with its context.
+   *
+   * The Callback type depends on how the context is passed to it.  A
+   * single Callback, of the type given by the kind, is constructed in
+   * place in the storage of the Sink.
+   */
+  class Sink
+  {
+  public:
+    /** How the context is passed to the Callback. */
+    enum Kind
+    {
+      NONE,      //!< Connected without context: Plain()
+      ID,        //!< TraceContext: Id()
+      REFERENCE, //!< Reference to the interned string: Reference()
+      STRING     //!< Copy of the interned string: String()
+    };
+    /** Callback without context. */
+    typedef Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> PlainCallback;
+    /** Callback with a TraceContext. */
+    typedef Callback<void,TraceContext,T1,T2,T3,T4,T5,T6,T7,T8> IdCallback;
+    /** Callback with a context string reference. */
+    typedef Callback<void,const std::string &,T1,T2,T3,T4,T5,T6,T7,T8> ReferenceCallback;
+    /** Callback with a context string. */
+    typedef Callback<void,std::string,T1,T2,T3,T4,T5,T6,T7,T8> StringCallback;
+
+    /** Constructor: a null Callback without context. */
+    Sink ()
+      : m_kind (NONE)
+    {
+      new (m_storage.m_data) PlainCallback ();
+    }
+    /**
+     * Copy constructor.
+     * \param [in] o The Sink to copy.
+     */
+    Sink (const Sink &o)
+      : m_context (o.m_context),
+        m_kind (o.m_kind)
+    {
+      Construct (o);
+    }
+    /**
+     * Assignment.
+     * \param [in] o The Sink to copy.
+     * \returns This Sink.
+     */
+    Sink & operator = (const Sink &o)
+    {
+      if (this != &o)
+        {
+          Destroy ();
+          m_kind = o.m_kind;
+          m_context = o.m_context;
+          Construct (o);
+        }
+      return *this;
+    }
+    /** Destructor. */
+    ~Sink ()
+    {
+      Destroy ();
+    }
+    /**
+     * Replace the Callback by a null Callback of another kind.
+     * \param [in] kind The kind.
+     */
+    void SetKind (Kind kind)
+    {
+      Destroy ();
+      m_kind = kind;
+      switch (m_kind)
+        {
+        case NONE:      new (m_storage.m_data) PlainCallback (); break;
+        case ID:        new (m_storage.m_data) IdCallback (); break;
+        case REFERENCE: new (m_storage.m_data) ReferenceCallback (); break;
+        case STRING:    new (m_storage.m_data) StringCallback (); break;
+        }
+    }
+    /** \returns The kind of the Callback. */
+    Kind GetKind (void) const
+    {
+      return m_kind;
+    }
+    /**
+     * The Callback, by kind: only the accessor of the current kind
+     * may be used.
+     * \returns The Callback.
+     * @{
+     */
+    PlainCallback & Plain (void)
+    {
+      return *reinterpret_cast<PlainCallback *> (m_storage.m_data);
+    }
+    const PlainCallback & Plain (void) const
+    {
+      return *reinterpret_cast<const PlainCallback *> (m_storage.m_data);
+    }
+    IdCallback & Id (void)
+    {
+      return *reinterpret_cast<IdCallback *> (m_storage.m_data);
+    }
+    const IdCallback & Id (void) const
+    {
+      return *reinterpret_cast<const IdCallback *> (m_storage.m_data);
+    }
+    ReferenceCallback & Reference (void)
+    {
+      return *reinterpret_cast<ReferenceCallback *> (m_storage.m_data);
+    }
+    const ReferenceCallback & Reference (void) const
+    {
+      return *reinterpret_cast<const ReferenceCallback *> (m_storage.m_data);
+    }
+    StringCallback & String (void)
+    {
+      return *reinterpret_cast<StringCallback *> (m_storage.m_data);
+    }
+    const StringCallback & String (void) const
+    {
+      return *reinterpret_cast<const StringCallback *> (m_storage.m_data);
+    }
+    /**@}*/
+
+    TraceContext m_context;      //!< The context
+
+  private:
+    /**
+     * Construct a copy of the Callback of another Sink of the same kind.
+     * \param [in] o The Sink to copy.
+     */
+    void Construct (const Sink &o)
+    {
+      switch (m_kind)
+        {
+        case NONE:      new (m_storage.m_data) PlainCallback (o.Plain ()); break;
+        case ID:        new (m_storage.m_data) IdCallback (o.Id ()); break;
+        case REFERENCE: new (m_storage.m_data) ReferenceCallback (o.Reference ()); break;
+        case STRING:    new (m_storage.m_data) StringCallback (o.String ()); break;
+        }
+    }
+    /** Destroy the Callback. */
+    void Destroy (void)
+    {
+      switch (m_kind)
+        {
+        case NONE:      Plain ().~PlainCallback (); break;
+        case ID:        Id ().~IdCallback (); break;
+        case REFERENCE: Reference ().~ReferenceCallback (); break;
+        case STRING:    String ().~StringCallback (); break;
+        }
+    }
+
+    Kind m_kind;                 //!< Which Callback is constructed
+    /**
+     * Storage for the Callback.  A Callback adds no data member to
+     * CallbackBase, so all kinds have the same size.
+     */
+    union
+    {
+      char m_data[sizeof (CallbackBase)];  //!< The Callback
+      void *m_align;                       //!< Alignment
+    } m_storage;
+  };
+  /**
+   * Set the Callback of a Sink with a context, following the type
+   * of its first argument.
+   *
+   * \param [in,out] sink The Sink, with its context set.
+   * \param [in] callback The Callback.
+   * \returns \c true if the Callback type is compatible.
+   */
+  static bool DoAssign (Sink &sink, const CallbackBase &callback);
+  /**
+   * \param [in] a A Sink.
+   * \param [in] b Another Sink.
+   * \returns \c true if \p a and \p b have the same Callback and context.
+   */
+  static bool IsEqual (const Sink &a, const Sink &b);
+  /**
+   * Invoke the chain of Callbacks, with varying numbers of arguments,
+   * out of line so that operator() is inlined.
+   * @{
+   */
+  void DoInvoke (void) const;
+  /**
+   * \param [in] a1 The first argument.
+   */
+  void DoInvoke (T1 a1) const;
+  /**
+   * \param [in] a1 The first argument.
+   * \param [in] a2 The second argument.
+   */
+  void DoInvoke (T1 a1, T2 a2) const;
+  /**
+   * \param [in] a1 The first argument.
+   * \param [in] a2 The second argument.
+   * \param [in] a3 The third argument.
+   */
+  void DoInvoke (T1 a1, T2 a2, T3 a3) const;
+  /**
+   * \param [in] a1 The first argument.
+   * \param [in] a2 The second argument.
+   * \param [in] a3 The third argument.
+   * \param [in] a4 The fourth argument.
+   */
+  void DoInvoke (T1 a1, T2 a2, T3 a3, T4 a4) const;
+  /**
+   * \param [in] a1 The first argument.
+   * \param [in] a2 The second argument.
+   * \param [in] a3 The third argument.
+   * \param [in] a4 The fourth argument.
+   * \param [in] a5 The fifth argument.
+   */
+  void DoInvoke (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5) const;
+  /**
+   * \param [in] a1 The first argument.
+   * \param [in] a2 The second argument.
+   * \param [in] a3 The third argument.
+   * \param [in] a4 The fourth argument.
+   * \param [in] a5 The fifth argument.
+   * \param [in] a6 The sixth argument.
+   */
+  void DoInvoke (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6) const;
+  /**
+   * \param [in] a1 The first argument.
+   * \param [in] a2 The second argument.
+   * \param [in] a3 The third argument.
+   * \param [in] a4 The fourth argument.
+   * \param [in] a5 The fifth argument.
+   * \param [in] a6 The sixth argument.
+   * \param [in] a7 The seventh argument.
+   */
+  void DoInvoke (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7) const;
+  /**
+   * \param [in] a1 The first argument.
+   * \param [in] a2 The second argument.
+   * \param [in] a3 The third argument.
+   * \param [in] a4 The fourth argument.
+   * \param [in] a5 The fifth argument.
+   * \param [in] a6 The sixth argument.
+   * \param [in] a7 The seventh argument.
+   * \param [in] a8 The eighth argument.
+   */
+  void DoInvoke (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7, T8 a8) const;
+  /**@}*/
   /**
    * Container type for holding the chain of Callbacks.
    *
@@ -234,7 +489,7 @@ private:
    * \tparam T7 \deduced Type of the seventh argument to the functor.
    * \tparam T8 \deduced Type of the eighth argument to the functor.
    */
-  typedef std::list<Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> > CallbackList;
+  typedef std::vector<Sink> CallbackList;
   /** The chain of Callbacks. */
   CallbackList m_callbackList;
 };
@@ -263,23 +518,67 @@ template<typename T1, typename T2,
 void
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::ConnectWithoutContext (const CallbackBase & callback)
 {
-  Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> cb;
-  if (!cb.Assign (callback))
+  Sink sink;
+  if (!sink.Plain ().Assign (callback))
     NS_FATAL_ERROR_NO_MSG();
-  m_callbackList.push_back (cb);
+  m_callbackList.push_back (sink);
+}
+template<typename T1, typename T2, 
+         typename T3, typename T4,
+         typename T5, typename T6,
+         typename T7, typename T8>
+bool
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::DoAssign (Sink &sink, const CallbackBase & callback)
+{
+  sink.SetKind (Sink::ID);
+  if (sink.Id ().CheckType (callback))
+    {
+      return sink.Id ().Assign (callback);
+    }
+  sink.SetKind (Sink::REFERENCE);
+  if (sink.Reference ().CheckType (callback))
+    {
+      return sink.Reference ().Assign (callback);
+    }
+  sink.SetKind (Sink::STRING);
+  return sink.String ().Assign (callback);
 }
 template<typename T1, typename T2,
          typename T3, typename T4,
          typename T5, typename T6,
          typename T7, typename T8>
+bool
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::IsEqual (const Sink &a, const Sink &b)
+{
+  if (a.GetKind () != b.GetKind () || a.m_context != b.m_context)
+    {
+      return false;
+    }
+  switch (a.GetKind ())
+    {
+    case Sink::NONE:
+      return a.Plain ().IsEqual (b.Plain ());
+    case Sink::ID:
+      return a.Id ().IsEqual (b.Id ());
+    case Sink::REFERENCE:
+      return a.Reference ().IsEqual (b.Reference ());
+    case Sink::STRING:
+      return a.String ().IsEqual (b.String ());
+    }
+  return false;
+}
+template<typename T1, typename T2, 
+         typename T3, typename T4,
+         typename T5, typename T6,
+         typename T7, typename T8>
 void
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::Connect (const CallbackBase & callback, std::string path)
 {
-  Callback<void,std::string,T1,T2,T3,T4,T5,T6,T7,T8> cb;
-  if (!cb.Assign (callback))
+  Sink sink;
+  sink.m_context = TraceContext::Intern (path);
+  if (!DoAssign (sink, callback))
     NS_FATAL_ERROR ("when connecting to " << path);
-  Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> realCb = cb.Bind (path);
-  m_callbackList.push_back (realCb);
+  m_callbackList.push_back (sink);
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
@@ -288,10 +587,16 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::DisconnectWithoutContext (const CallbackBase & callback)
 {
+  Sink sink;
+  if (!sink.Plain ().CheckType (callback))
+    {
+      return;
+    }
+  sink.Plain ().Assign (callback);
   for (typename CallbackList::iterator i = m_callbackList.begin ();
        i != m_callbackList.end (); /* empty */)
     {
-      if ((*i).IsEqual (callback))
+      if (IsEqual (*i, sink))
         {
           i = m_callbackList.erase (i);
         }
@@ -308,23 +613,37 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::Disconnect (const CallbackBase & callback, std::string path)
 {
-  Callback<void,std::string,T1,T2,T3,T4,T5,T6,T7,T8> cb;
-  if (!cb.Assign (callback))
+  Sink sink;
+  if (!DoAssign (sink, callback))
     NS_FATAL_ERROR ("when disconnecting from " << path);
-  Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> realCb = cb.Bind (path);
-  DisconnectWithoutContext (realCb);
+  if (!TraceContext::Lookup (path, &sink.m_context))
+    {
+      // never connected
+      return;
+    }
+  for (typename CallbackList::iterator i = m_callbackList.begin ();
+       i != m_callbackList.end (); /* empty */)
+    {
+      if (IsEqual (*i, sink))
+        {
+          i = m_callbackList.erase (i);
+        }
+      else
+        {
+          i++;
+        }
+    }
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
          typename T5, typename T6,
          typename T7, typename T8>
-void 
+inline void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (void) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (!m_callbackList.empty ())
     {
-      (*i)();
+      DoInvoke ();
     }
 }
 template<typename T1, typename T2, 
@@ -332,12 +651,39 @@ template<typename T1, typename T2,
          typename T5, typename T6,
          typename T7, typename T8>
 void 
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::DoInvoke (void) const
+{
+  // by index: a sink may connect more sinks
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
+    {
+      const Sink &sink = m_callbackList[i];
+      switch (sink.GetKind ())
+        {
+        case Sink::NONE:
+          sink.Plain () ();
+          break;
+        case Sink::ID:
+          sink.Id () (sink.m_context);
+          break;
+        case Sink::REFERENCE:
+          sink.Reference () (sink.m_context.GetString ());
+          break;
+        case Sink::STRING:
+          sink.String () (sink.m_context.GetString ());
+          break;
+        }
+    }
+}
+template<typename T1, typename T2, 
+         typename T3, typename T4,
+         typename T5, typename T6,
+         typename T7, typename T8>
+inline void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (!m_callbackList.empty ())
     {
-      (*i)(a1);
+      DoInvoke (a1);
     }
 }
 template<typename T1, typename T2, 
@@ -345,12 +691,39 @@ template<typename T1, typename T2,
          typename T5, typename T6,
          typename T7, typename T8>
 void 
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::DoInvoke (T1 a1) const
+{
+  // by index: a sink may connect more sinks
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
+    {
+      const Sink &sink = m_callbackList[i];
+      switch (sink.GetKind ())
+        {
+        case Sink::NONE:
+          sink.Plain () (a1);
+          break;
+        case Sink::ID:
+          sink.Id () (sink.m_context, a1);
+          break;
+        case Sink::REFERENCE:
+          sink.Reference () (sink.m_context.GetString (), a1);
+          break;
+        case Sink::STRING:
+          sink.String () (sink.m_context.GetString (), a1);
+          break;
+        }
+    }
+}
+template<typename T1, typename T2, 
+         typename T3, typename T4,
+         typename T5, typename T6,
+         typename T7, typename T8>
+inline void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (!m_callbackList.empty ())
     {
-      (*i)(a1, a2);
+      DoInvoke (a1, a2);
     }
 }
 template<typename T1, typename T2, 
@@ -358,12 +731,39 @@ template<typename T1, typename T2,
          typename T5, typename T6,
          typename T7, typename T8>
 void 
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::DoInvoke (T1 a1, T2 a2) const
+{
+  // by index: a sink may connect more sinks
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
+    {
+      const Sink &sink = m_callbackList[i];
+      switch (sink.GetKind ())
+        {
+        case Sink::NONE:
+          sink.Plain () (a1, a2);
+          break;
+        case Sink::ID:
+          sink.Id () (sink.m_context, a1, a2);
+          break;
+        case Sink::REFERENCE:
+          sink.Reference () (sink.m_context.GetString (), a1, a2);
+          break;
+        case Sink::STRING:
+          sink.String () (sink.m_context.GetString (), a1, a2);
+          break;
+        }
+    }
+}
+template<typename T1, typename T2, 
+         typename T3, typename T4,
+         typename T5, typename T6,
+         typename T7, typename T8>
+inline void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (!m_callbackList.empty ())
     {
-      (*i)(a1, a2, a3);
+      DoInvoke (a1, a2, a3);
     }
 }
 template<typename T1, typename T2, 
@@ -371,12 +771,39 @@ template<typename T1, typename T2,
          typename T5, typename T6,
          typename T7, typename T8>
 void 
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::DoInvoke (T1 a1, T2 a2, T3 a3) const
+{
+  // by index: a sink may connect more sinks
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
+    {
+      const Sink &sink = m_callbackList[i];
+      switch (sink.GetKind ())
+        {
+        case Sink::NONE:
+          sink.Plain () (a1, a2, a3);
+          break;
+        case Sink::ID:
+          sink.Id () (sink.m_context, a1, a2, a3);
+          break;
+        case Sink::REFERENCE:
+          sink.Reference () (sink.m_context.GetString (), a1, a2, a3);
+          break;
+        case Sink::STRING:
+          sink.String () (sink.m_context.GetString (), a1, a2, a3);
+          break;
+        }
+    }
+}
+template<typename T1, typename T2, 
+         typename T3, typename T4,
+         typename T5, typename T6,
+         typename T7, typename T8>
+inline void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (!m_callbackList.empty ())
     {
-      (*i)(a1, a2, a3, a4);
+      DoInvoke (a1, a2, a3, a4);
     }
 }
 template<typename T1, typename T2, 
@@ -384,12 +811,39 @@ template<typename T1, typename T2,
          typename T5, typename T6,
          typename T7, typename T8>
 void 
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::DoInvoke (T1 a1, T2 a2, T3 a3, T4 a4) const
+{
+  // by index: a sink may connect more sinks
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
+    {
+      const Sink &sink = m_callbackList[i];
+      switch (sink.GetKind ())
+        {
+        case Sink::NONE:
+          sink.Plain () (a1, a2, a3, a4);
+          break;
+        case Sink::ID:
+          sink.Id () (sink.m_context, a1, a2, a3, a4);
+          break;
+        case Sink::REFERENCE:
+          sink.Reference () (sink.m_context.GetString (), a1, a2, a3, a4);
+          break;
+        case Sink::STRING:
+          sink.String () (sink.m_context.GetString (), a1, a2, a3, a4);
+          break;
+        }
+    }
+}
+template<typename T1, typename T2, 
+         typename T3, typename T4,
+         typename T5, typename T6,
+         typename T7, typename T8>
+inline void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (!m_callbackList.empty ())
     {
-      (*i)(a1, a2, a3, a4, a5);
+      DoInvoke (a1, a2, a3, a4, a5);
     }
 }
 template<typename T1, typename T2, 
@@ -397,12 +851,39 @@ template<typename T1, typename T2,
          typename T5, typename T6,
          typename T7, typename T8>
 void 
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::DoInvoke (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5) const
+{
+  // by index: a sink may connect more sinks
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
+    {
+      const Sink &sink = m_callbackList[i];
+      switch (sink.GetKind ())
+        {
+        case Sink::NONE:
+          sink.Plain () (a1, a2, a3, a4, a5);
+          break;
+        case Sink::ID:
+          sink.Id () (sink.m_context, a1, a2, a3, a4, a5);
+          break;
+        case Sink::REFERENCE:
+          sink.Reference () (sink.m_context.GetString (), a1, a2, a3, a4, a5);
+          break;
+        case Sink::STRING:
+          sink.String () (sink.m_context.GetString (), a1, a2, a3, a4, a5);
+          break;
+        }
+    }
+}
+template<typename T1, typename T2, 
+         typename T3, typename T4,
+         typename T5, typename T6,
+         typename T7, typename T8>
+inline void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (!m_callbackList.empty ())
     {
-      (*i)(a1, a2, a3, a4, a5, a6);
+      DoInvoke (a1, a2, a3, a4, a5, a6);
     }
 }
 template<typename T1, typename T2, 
@@ -410,12 +891,39 @@ template<typename T1, typename T2,
          typename T5, typename T6,
          typename T7, typename T8>
 void 
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::DoInvoke (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6) const
+{
+  // by index: a sink may connect more sinks
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
+    {
+      const Sink &sink = m_callbackList[i];
+      switch (sink.GetKind ())
+        {
+        case Sink::NONE:
+          sink.Plain () (a1, a2, a3, a4, a5, a6);
+          break;
+        case Sink::ID:
+          sink.Id () (sink.m_context, a1, a2, a3, a4, a5, a6);
+          break;
+        case Sink::REFERENCE:
+          sink.Reference () (sink.m_context.GetString (), a1, a2, a3, a4, a5, a6);
+          break;
+        case Sink::STRING:
+          sink.String () (sink.m_context.GetString (), a1, a2, a3, a4, a5, a6);
+          break;
+        }
+    }
+}
+template<typename T1, typename T2, 
+         typename T3, typename T4,
+         typename T5, typename T6,
+         typename T7, typename T8>
+inline void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (!m_callbackList.empty ())
     {
-      (*i)(a1, a2, a3, a4, a5, a6, a7);
+      DoInvoke (a1, a2, a3, a4, a5, a6, a7);
     }
 }
 template<typename T1, typename T2, 
@@ -423,12 +931,67 @@ template<typename T1, typename T2,
          typename T5, typename T6,
          typename T7, typename T8>
 void 
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::DoInvoke (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7) const
+{
+  // by index: a sink may connect more sinks
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
+    {
+      const Sink &sink = m_callbackList[i];
+      switch (sink.GetKind ())
+        {
+        case Sink::NONE:
+          sink.Plain () (a1, a2, a3, a4, a5, a6, a7);
+          break;
+        case Sink::ID:
+          sink.Id () (sink.m_context, a1, a2, a3, a4, a5, a6, a7);
+          break;
+        case Sink::REFERENCE:
+          sink.Reference () (sink.m_context.GetString (), a1, a2, a3, a4, a5, a6, a7);
+          break;
+        case Sink::STRING:
+          sink.String () (sink.m_context.GetString (), a1, a2, a3, a4, a5, a6, a7);
+          break;
+        }
+    }
+}
+template<typename T1, typename T2, 
+         typename T3, typename T4,
+         typename T5, typename T6,
+         typename T7, typename T8>
+inline void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7, T8 a8) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (!m_callbackList.empty ())
+    {
+      DoInvoke (a1, a2, a3, a4, a5, a6, a7, a8);
+    }
+}
+template<typename T1, typename T2, 
+         typename T3, typename T4,
+         typename T5, typename T6,
+         typename T7, typename T8>
+void 
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::DoInvoke (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7, T8 a8) const
+{
+  // by index: a sink may connect more sinks
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2, a3, a4, a5, a6, a7, a8);
+      const Sink &sink = m_callbackList[i];
+      switch (sink.GetKind ())
+        {
+        case Sink::NONE:
+          sink.Plain () (a1, a2, a3, a4, a5, a6, a7, a8);
+          break;
+        case Sink::ID:
+          sink.Id () (sink.m_context, a1, a2, a3, a4, a5, a6, a7, a8);
+          break;
+        case Sink::REFERENCE:
+          sink.Reference () (sink.m_context.GetString (), a1, a2, a3, a4, a5, a6, a7, a8);
+          break;
+        case Sink::STRING:
+          sink.String () (sink.m_context.GetString (), a1, a2, a3, a4, a5, a6, a7, a8);
+          break;
+        }
     }
 }
 
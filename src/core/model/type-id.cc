@@ -23,6 +23,7 @@
 #include "singleton.h"
 #include "trace-source-accessor.h"
 
+#include <algorithm>
 #include <map>
 #include <vector>
 #include <sstream>
@@ -51,7 +52,17 @@ NS_LOG_COMPONENT_DEFINE ("TypeId");
  * \brief TypeId information manager
  *
  * Information records are stored in a vector.  Name and hash lookup
- * are performed by maps to the vector index.
+ * are performed by maps to the vector index.  Name lookups hash the
+ * name and go through the by-hash index, so they compare integers
+ * instead of strings.
+ *
+ * Attribute and trace source lookups by name go through a flattened
+ * index kept for each type id.  The index maps the hash of every name
+ * declared by the type id or any of its ancestors to the declaring
+ * type id and position, so a lookup does not walk the parent chain.
+ * The indexes are updated eagerly, when a parent, an attribute or a
+ * trace source is registered, and only read by lookups: lookups may
+ * run from several threads at once, registrations may not.
  *
  * \internal
  * <b>Hash Chaining</b>
@@ -118,7 +129,7 @@ public:
    * \param [in] name The type id to find.
    * \returns The type id.  A type id of 0 means \p name wasn't found.
    */
-  uint16_t GetUid (std::string name) const;
+  uint16_t GetUid (const std::string &name) const;
   /**
    * Get a type id by hash value.
    * \param [in] hash The type id to find.
@@ -256,6 +267,22 @@ public:
    * \returns Detailed information about the requested trace source.
    */
   struct TypeId::TraceSourceInformation GetTraceSource(uint16_t uid, uint32_t i) const;
+  /**
+   * Find an Attribute by name, including those of the ancestors.
+   * \param [in] uid The id.
+   * \param [in] name The Attribute name.
+   * \param [out] info The Attribute information, if found.
+   * \returns \c true if the Attribute was found.
+   */
+  bool LookupAttributeByName (uint16_t uid, const std::string &name,
+                              struct TypeId::AttributeInformation *info) const;
+  /**
+   * Find a TraceSource by name, including those of the ancestors.
+   * \param [in] uid The id.
+   * \param [in] name The TraceSource name.
+   * \returns The TraceSource accessor, or 0 if not found.
+   */
+  Ptr<const TraceSourceAccessor> LookupTraceSourceByName (uint16_t uid, const std::string &name) const;
   /**
    * Check if this TypeId should not be listed in documentation.
    * \param [in] uid The id.
@@ -283,7 +310,15 @@ private:
    * \param [in] name The type id name.
    * \returns The hashed value of \p name.
    */
-  static TypeId::hash_t Hasher (const std::string name);
+  static TypeId::hash_t Hasher (const std::string &name);
+
+  /**
+   * Position of an Attribute or TraceSource in the flattened indexes:
+   * the declaring type id and the index in its container.
+   */
+  typedef std::pair<uint16_t, uint32_t> IndexEntry;
+  /** Flattened by-name-hash index of Attributes or TraceSources. */
+  typedef std::multimap<TypeId::hash_t, IndexEntry> NameIndex;
 
   /** The information record about a single type id. */
   struct IidInformation {
@@ -307,6 +342,12 @@ private:
     std::vector<struct TypeId::AttributeInformation> attributes;
     /** The container of TraceSources. */
     std::vector<struct TypeId::TraceSourceInformation> traceSources;
+    /** Attributes of this type id and its ancestors, by name hash. */
+    NameIndex attributeIndex;
+    /** TraceSources of this type id and its ancestors, by name hash. */
+    NameIndex traceSourceIndex;
+    /** The type ids which have this one as parent. */
+    std::vector<uint16_t> children;
   };
   /** Iterator type. */
   typedef std::vector<struct IidInformation>::const_iterator Iterator;
@@ -317,6 +358,32 @@ private:
    * \returns The information record.
    */
   struct IidManager::IidInformation *LookupInformation (uint16_t uid) const;
+  /**
+   * Rebuild the flattened Attribute and TraceSource indexes of a type
+   * and of all its descendants.
+   * \param [in] uid The id.
+   */
+  void BuildIndexes (uint16_t uid);
+  /**
+   * Add an entry to a flattened index of a type and of all its
+   * descendants.
+   * \param [in] uid The id.
+   * \param [in] attribute \c true to add to the Attribute index,
+   *            \c false to add to the TraceSource index.
+   * \param [in] hash The hash of the name.
+   * \param [in] entry The entry.
+   */
+  void AddIndexEntry (uint16_t uid, bool attribute,
+                      TypeId::hash_t hash, IndexEntry entry);
+  /**
+   * Choose between two index entries with the same name: the one
+   * declared nearest to a type wins, as when walking up the parent chain.
+   * \param [in] uid The id of the type looked up.
+   * \param [in] a The declaring type id of the first entry.
+   * \param [in] b The declaring type id of the second entry.
+   * \returns \c true if \p b is declared nearer to \p uid than \p a.
+   */
+  bool IsNearer (uint16_t uid, uint16_t a, uint16_t b) const;
 
   /** The container of all type id records. */
   std::vector<struct IidInformation> m_information;
@@ -346,10 +413,12 @@ private:
 
 //static
 TypeId::hash_t
-IidManager::Hasher (const std::string name)
+IidManager::Hasher (const std::string &name)
 {
-  static ns3::Hasher hasher ( Create<Hash::Function::Murmur3> () );
-  return hasher.clear ().GetHash32 (name);
+  // A fresh hash function for each name: a shared one would have to
+  // be cleared, and name lookups may run from several threads.
+  Hash::Function::Murmur3 murmur;
+  return murmur.GetHash32 (name.data (), name.size ());
 }
   
 uint16_t
@@ -437,7 +506,17 @@ IidManager::SetParent (uint16_t uid, uint16_t parent)
   NS_LOG_FUNCTION (this << uid << parent);
   NS_ASSERT (parent <= m_information.size ());
   struct IidInformation *information = LookupInformation (uid);
+  if (information->parent != 0 && information->parent != uid)
+    {
+      std::vector<uint16_t> &siblings = LookupInformation (information->parent)->children;
+      siblings.erase (std::find (siblings.begin (), siblings.end (), uid));
+    }
   information->parent = parent;
+  if (parent != 0 && parent != uid)
+    {
+      LookupInformation (parent)->children.push_back (uid);
+    }
+  BuildIndexes (uid);
 }
 void 
 IidManager::SetGroupName (uint16_t uid, std::string groupName)
@@ -475,18 +554,22 @@ IidManager::AddConstructor (uint16_t uid, Callback<ObjectBase *> callback)
 }
 
 uint16_t 
-IidManager::GetUid (std::string name) const
+IidManager::GetUid (const std::string &name) const
 {
   NS_LOG_FUNCTION (this << name);
-  namemap_t::const_iterator it = m_namemap.find (name);
-  if (it != m_namemap.end ())
+  // Look up by hash, then confirm the name to rule out a chained type.
+  TypeId::hash_t hash = Hasher (name) & (~HashChainFlag);
+  uint16_t uid = GetUid (hash);
+  if (uid != 0 && LookupInformation (uid)->name == name)
     {
-      return it->second;
+      return uid;
     }
-  else
+  uid = GetUid (hash | HashChainFlag);
+  if (uid != 0 && LookupInformation (uid)->name == name)
     {
-      return 0;
+      return uid;
     }
+  return 0;
 }
 uint16_t 
 IidManager::GetUid (TypeId::hash_t hash) const
@@ -623,6 +706,8 @@ IidManager::AddAttribute (uint16_t uid,
   info.accessor = accessor;
   info.checker = checker;
   information->attributes.push_back (info);
+  AddIndexEntry (uid, true, Hasher (name),
+                 IndexEntry (uid, information->attributes.size () - 1));
 }
 void 
 IidManager::SetAttributeInitialValue(uint16_t uid,
@@ -701,6 +786,8 @@ IidManager::AddTraceSource (uint16_t uid,
   source.accessor = accessor;
   source.callback = callback;
   information->traceSources.push_back (source);
+  AddIndexEntry (uid, false, Hasher (name),
+                 IndexEntry (uid, information->traceSources.size () - 1));
 }
 uint32_t 
 IidManager::GetTraceSourceN (uint16_t uid) const
@@ -717,6 +804,131 @@ IidManager::GetTraceSource(uint16_t uid, uint32_t i) const
   NS_ASSERT (i < information->traceSources.size ());
   return information->traceSources[i];
 }
+void
+IidManager::BuildIndexes (uint16_t uid)
+{
+  NS_LOG_FUNCTION (this << uid);
+  struct IidInformation *information = LookupInformation (uid);
+  information->attributeIndex.clear ();
+  information->traceSourceIndex.clear ();
+  uint16_t current = uid;
+  while (true)
+    {
+      struct IidInformation *declaring = LookupInformation (current);
+      for (uint32_t i = 0; i < declaring->attributes.size (); ++i)
+        {
+          information->attributeIndex.insert (std::make_pair (Hasher (declaring->attributes[i].name),
+                                                              IndexEntry (current, i)));
+        }
+      for (uint32_t i = 0; i < declaring->traceSources.size (); ++i)
+        {
+          information->traceSourceIndex.insert (std::make_pair (Hasher (declaring->traceSources[i].name),
+                                                                IndexEntry (current, i)));
+        }
+      if (declaring->parent == current || declaring->parent == 0)
+        {
+          // top of inheritance tree
+          break;
+        }
+      current = declaring->parent;
+    }
+  for (uint32_t i = 0; i < information->children.size (); ++i)
+    {
+      BuildIndexes (information->children[i]);
+    }
+}
+
+void
+IidManager::AddIndexEntry (uint16_t uid, bool attribute,
+                           TypeId::hash_t hash, IndexEntry entry)
+{
+  NS_LOG_FUNCTION (this << uid << attribute << hash);
+  struct IidInformation *information = LookupInformation (uid);
+  NameIndex &index = attribute ? information->attributeIndex : information->traceSourceIndex;
+  index.insert (std::make_pair (hash, entry));
+  for (uint32_t i = 0; i < information->children.size (); ++i)
+    {
+      AddIndexEntry (information->children[i], attribute, hash, entry);
+    }
+}
+
+bool
+IidManager::IsNearer (uint16_t uid, uint16_t a, uint16_t b) const
+{
+  NS_LOG_FUNCTION (this << uid << a << b);
+  uint16_t current = uid;
+  while (current != a)
+    {
+      if (current == b)
+        {
+          return true;
+        }
+      struct IidInformation *information = LookupInformation (current);
+      if (information->parent == current || information->parent == 0)
+        {
+          break;
+        }
+      current = information->parent;
+    }
+  return false;
+}
+
+bool
+IidManager::LookupAttributeByName (uint16_t uid, const std::string &name,
+                                   struct TypeId::AttributeInformation *info) const
+{
+  NS_LOG_FUNCTION (this << uid << name << info);
+  struct IidInformation *information = LookupInformation (uid);
+  std::pair<NameIndex::const_iterator, NameIndex::const_iterator> range =
+    information->attributeIndex.equal_range (Hasher (name));
+  const struct TypeId::AttributeInformation *found = 0;
+  uint16_t declaring = 0;
+  for (NameIndex::const_iterator i = range.first; i != range.second; ++i)
+    {
+      const struct TypeId::AttributeInformation &candidate =
+        LookupInformation (i->second.first)->attributes[i->second.second];
+      if (candidate.name == name
+          && (found == 0 || IsNearer (uid, declaring, i->second.first)))
+        {
+          found = &candidate;
+          declaring = i->second.first;
+        }
+    }
+  if (found == 0)
+    {
+      return false;
+    }
+  *info = *found;
+  return true;
+}
+
+Ptr<const TraceSourceAccessor>
+IidManager::LookupTraceSourceByName (uint16_t uid, const std::string &name) const
+{
+  NS_LOG_FUNCTION (this << uid << name);
+  struct IidInformation *information = LookupInformation (uid);
+  std::pair<NameIndex::const_iterator, NameIndex::const_iterator> range =
+    information->traceSourceIndex.equal_range (Hasher (name));
+  const struct TypeId::TraceSourceInformation *found = 0;
+  uint16_t declaring = 0;
+  for (NameIndex::const_iterator i = range.first; i != range.second; ++i)
+    {
+      const struct TypeId::TraceSourceInformation &candidate =
+        LookupInformation (i->second.first)->traceSources[i->second.second];
+      if (candidate.name == name
+          && (found == 0 || IsNearer (uid, declaring, i->second.first)))
+        {
+          found = &candidate;
+          declaring = i->second.first;
+        }
+    }
+  if (found == 0)
+    {
+      return 0;
+    }
+  return found->accessor;
+}
+
 bool 
 IidManager::MustHideFromDocumentation (uint16_t uid) const
 {
@@ -804,22 +1016,7 @@ bool
 TypeId::LookupAttributeByName (std::string name, struct TypeId::AttributeInformation *info) const
 {
   NS_LOG_FUNCTION (this << name << info);
-  TypeId tid;
-  TypeId nextTid = *this;
-  do {
-      tid = nextTid;
-      for (uint32_t i = 0; i < tid.GetAttributeN (); i++)
-        {
-          struct TypeId::AttributeInformation tmp = tid.GetAttribute(i);
-          if (tmp.name == name)
-            {
-              *info = tmp;
-              return true;
-            }
-        }
-      nextTid = tid.GetParent ();
-    } while (nextTid != tid);
-  return false;
+  return IidManager::Get ()->LookupAttributeByName (m_tid, name, info);
 }
 
 TypeId 
@@ -1030,21 +1227,7 @@ Ptr<const TraceSourceAccessor>
 TypeId::LookupTraceSourceByName (std::string name) const
 {
   NS_LOG_FUNCTION (this << name);
-  TypeId tid;
-  TypeId nextTid = *this;
-  do {
-      tid = nextTid;
-      for (uint32_t i = 0; i < tid.GetTraceSourceN (); i++)
-        {
-          struct TypeId::TraceSourceInformation info = tid.GetTraceSource (i);
-          if (info.name == name)
-            {
-              return info.accessor;
-            }
-        }
-      nextTid = tid.GetParent ();
-    } while (nextTid != tid);
-  return 0;
+  return IidManager::Get ()->LookupTraceSourceByName (m_tid, name);
 }
 
 uint16_t 
@@ -18,7 +18,11 @@
 
 #include "ns3/test.h"
 #include "ns3/callback.h"
+#include "ns3/traced-callback.h"
 #include <stdint.h>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
 
 using namespace ns3;
 
@@ -688,6 +692,88 @@ MakeCallbackTemplatesTestCase::DoRun (void)
   that.CheckParentalRights ();
 }
 
+// ===========================================================================
+// Test the Callbacks stored inline, and their equivalence with the
+// Callbacks built on a CallbackImpl
+// ===========================================================================
+class InlineCallbackTarget : public SimpleRefCount<InlineCallbackTarget>
+{
+public:
+  InlineCallbackTarget () : m_calls (0) {}
+  int Add (int &total, int value) { m_calls++; total += value; return total; }
+  int Get (void) const { return m_calls; }
+  void Count (int &total, int value) { m_calls++; total += value; }
+  void CountString (std::string context, int &total, int value) { Count (total, value); }
+  void CountContext (TraceContext context, int &total, int value) { Count (total, value); }
+
+  int m_calls;
+};
+
+int InlineCallbackTwice (int &total, int value) { total += 2 * value; return total; }
+
+class InlineCallbackTestCase : public TestCase
+{
+public:
+  InlineCallbackTestCase ();
+  virtual ~InlineCallbackTestCase () {}
+
+private:
+  virtual void DoRun (void);
+};
+
+InlineCallbackTestCase::InlineCallbackTestCase ()
+  : TestCase ("Check Callbacks stored inline")
+{
+}
+
+void
+InlineCallbackTestCase::DoRun (void)
+{
+  InlineCallbackTarget target;
+  InlineCallbackTarget other;
+  int total = 0;
+
+  Callback<int, int &, int> add = MakeCallback (&InlineCallbackTarget::Add, &target);
+  NS_TEST_ASSERT_MSG_EQ (add (total, 3), 3, "Inline Callback returned wrong value");
+  NS_TEST_ASSERT_MSG_EQ (total, 3, "Inline Callback did not pass the reference");
+  Callback<int> get = MakeCallback (&InlineCallbackTarget::Get, &target);
+  NS_TEST_ASSERT_MSG_EQ (get (), 1, "Inline Callback to const member failed");
+  Callback<int, int &, int> twice = MakeCallback (&InlineCallbackTwice);
+  NS_TEST_ASSERT_MSG_EQ (twice (total, 2), 7, "Inline function Callback failed");
+
+  // equality with inline and impl Callbacks
+  NS_TEST_ASSERT_MSG_EQ (add.IsEqual (MakeCallback (&InlineCallbackTarget::Add, &target)), true,
+                         "Equal inline Callbacks differ");
+  NS_TEST_ASSERT_MSG_EQ (add.IsEqual (MakeCallback (&InlineCallbackTarget::Add, &other)), false,
+                         "Callbacks on different objects are equal");
+  NS_TEST_ASSERT_MSG_EQ (twice.IsEqual (MakeCallback (&InlineCallbackTwice)), true,
+                         "Equal function Callbacks differ");
+  NS_TEST_ASSERT_MSG_EQ (twice.IsEqual (add), false, "Different Callbacks are equal");
+  NS_TEST_ASSERT_MSG_NE (add.GetImpl (), 0, "Inline Callback has no impl");
+  Ptr<InlineCallbackTarget> ptr = Create<InlineCallbackTarget> ();
+  Callback<int, int &, int> addPtr = MakeCallback (&InlineCallbackTarget::Add, ptr);
+  NS_TEST_ASSERT_MSG_EQ (addPtr (total, 1), 8, "Callback on a Ptr failed");
+  NS_TEST_ASSERT_MSG_EQ (addPtr.IsEqual (MakeCallback (&InlineCallbackTarget::Add, ptr)), true,
+                         "Equal Callbacks on a Ptr differ");
+
+  // type-erased copies keep working and keep their type
+  CallbackBase base = add;
+  Callback<int, int &, int> assigned;
+  NS_TEST_ASSERT_MSG_EQ (assigned.CheckType (base), true, "Compatible type rejected");
+  NS_TEST_ASSERT_MSG_EQ (assigned.Assign (base), true, "Assign failed");
+  NS_TEST_ASSERT_MSG_EQ (assigned (total, 1), 9, "Assigned Callback failed");
+  NS_TEST_ASSERT_MSG_EQ (assigned.IsEqual (add), true, "Assigned Callback differs");
+  NS_TEST_ASSERT_MSG_EQ (get.CheckType (base), false, "Incompatible type accepted");
+
+  Callback<int, int> bound = add.Bind (total);
+  NS_TEST_ASSERT_MSG_EQ (bound (10), 19, "Bound inline Callback failed");
+  NS_TEST_ASSERT_MSG_EQ (target.m_calls, 3, "Wrong number of calls");
+
+  add.Nullify ();
+  NS_TEST_ASSERT_MSG_EQ (add.IsNull (), true, "Nullified inline Callback is not null");
+  NS_TEST_ASSERT_MSG_EQ (assigned.IsNull (), false, "Copy of a nullified Callback is null");
+}
+
 // ===========================================================================
 // The Test Suite that glues all of the Test Cases together.
 // ===========================================================================
@@ -705,6 +791,115 @@ CallbackTestSuite::CallbackTestSuite ()
   AddTestCase (new MakeBoundCallbackTestCase, TestCase::QUICK);
   AddTestCase (new NullifyCallbackTestCase, TestCase::QUICK);
   AddTestCase (new MakeCallbackTemplatesTestCase, TestCase::QUICK);
+  AddTestCase (new InlineCallbackTestCase, TestCase::QUICK);
 }
 
 static CallbackTestSuite CallbackTestSuite;
+
+// ===========================================================================
+// Measure the cost of calling Callbacks and TracedCallbacks
+// ===========================================================================
+class CallbackPerfTestCase : public TestCase
+{
+public:
+  CallbackPerfTestCase ();
+  virtual ~CallbackPerfTestCase () {}
+
+private:
+  virtual void DoRun (void);
+  void Report (const std::string what, const std::clock_t ticks) const;
+
+  static const uint32_t CALLS = 10000000;
+};
+
+CallbackPerfTestCase::CallbackPerfTestCase ()
+  : TestCase ("Measure Callback and TracedCallback call time")
+{
+}
+
+void
+CallbackPerfTestCase::Report (const std::string what,
+                              const std::clock_t ticks) const
+{
+  double per = 1e9 * double (ticks) / (double (CALLS) * CLOCKS_PER_SEC);
+  std::cout << GetParent ()->GetName () << ": "
+            << std::left << std::setw (40) << what << std::right
+            << std::fixed << std::setprecision (2) << std::setw (8) << per
+            << " ns/call" << std::endl;
+}
+
+void
+CallbackPerfTestCase::DoRun (void)
+{
+  InlineCallbackTarget target;
+  Ptr<InlineCallbackTarget> ptr = Create<InlineCallbackTarget> ();
+  int total = 0;
+
+  Callback<int, int &, int> inlined = MakeCallback (&InlineCallbackTarget::Add, &target);
+  std::clock_t start = std::clock ();
+  for (uint32_t i = 0; i < CALLS; ++i)
+    {
+      inlined (total, 1);
+    }
+  Report ("member Callback on a raw pointer", std::clock () - start);
+
+  Callback<int, int &, int> impl = MakeCallback (&InlineCallbackTarget::Add, ptr);
+  start = std::clock ();
+  for (uint32_t i = 0; i < CALLS; ++i)
+    {
+      impl (total, 1);
+    }
+  Report ("member Callback on a Ptr", std::clock () - start);
+
+  TracedCallback<int &, int> traced;
+  start = std::clock ();
+  for (uint32_t i = 0; i < CALLS; ++i)
+    {
+      traced (total, 1);
+    }
+  Report ("TracedCallback, no sink", std::clock () - start);
+
+  traced.ConnectWithoutContext (MakeCallback (&InlineCallbackTarget::Count, &target));
+  start = std::clock ();
+  for (uint32_t i = 0; i < CALLS; ++i)
+    {
+      traced (total, 1);
+    }
+  Report ("TracedCallback, one sink", std::clock () - start);
+
+  std::string path = "/NodeList/999/DeviceList/0/$ns3::WifiNetDevice/Phy/PhyTxBegin";
+  TracedCallback<int &, int> tracedString;
+  tracedString.Connect (MakeCallback (&InlineCallbackTarget::CountString, &target), path);
+  start = std::clock ();
+  for (uint32_t i = 0; i < CALLS; ++i)
+    {
+      tracedString (total, 1);
+    }
+  Report ("TracedCallback, std::string context", std::clock () - start);
+
+  TracedCallback<int &, int> tracedContext;
+  tracedContext.Connect (MakeCallback (&InlineCallbackTarget::CountContext, &target), path);
+  start = std::clock ();
+  for (uint32_t i = 0; i < CALLS; ++i)
+    {
+      tracedContext (total, 1);
+    }
+  Report ("TracedCallback, TraceContext context", std::clock () - start);
+
+  NS_TEST_ASSERT_MSG_EQ (target.m_calls + ptr->m_calls, 5 * CALLS, "Callbacks did not fire");
+  NS_TEST_ASSERT_MSG_EQ (total, int (5 * CALLS), "Wrong total");
+}
+
+class CallbackPerfTestSuite : public TestSuite
+{
+public:
+  CallbackPerfTestSuite ();
+};
+
+CallbackPerfTestSuite::CallbackPerfTestSuite ()
+  : TestSuite ("callback-perf", PERFORMANCE)
+{
+  AddTestCase (new CallbackPerfTestCase, TestCase::QUICK);
+}
+
+static CallbackPerfTestSuite g_callbackPerfTestSuite;
@@ -721,6 +721,130 @@ SearchAttributesOfParentObjectsTestCase::DoRun (void)
 
 }
 
+// ===========================================================================
+// Test for compiled paths and batches of operations: they must match the
+// same objects as the string based functions, and a batch applied again
+// must only touch the objects added since.
+// ===========================================================================
+class CompiledPathConfigTestCase : public TestCase
+{
+public:
+  CompiledPathConfigTestCase ();
+  virtual ~CompiledPathConfigTestCase () {}
+
+  void Trace (int16_t oldValue, int16_t newValue) { m_count++; }
+  void TraceWithPath (std::string path, int16_t old, int16_t newValue) { m_path = path; }
+
+private:
+  virtual void DoRun (void);
+
+  uint32_t m_count;
+  std::string m_path;
+};
+
+CompiledPathConfigTestCase::CompiledPathConfigTestCase ()
+  : TestCase ("Check compiled paths and batched Config operations")
+{
+}
+
+void
+CompiledPathConfigTestCase::DoRun (void)
+{
+  IntegerValue iv;
+
+  Ptr<ConfigTestObject> root = CreateObject<ConfigTestObject> ();
+  Config::RegisterRootNamespaceObject (root);
+  Ptr<ConfigTestObject> a = CreateObject<ConfigTestObject> ();
+  root->SetNodeA (a);
+  std::vector<Ptr<ConfigTestObject> > objects;
+  for (uint32_t i = 0; i < 6; ++i)
+    {
+      Ptr<ConfigTestObject> obj = CreateObject<ConfigTestObject> ();
+      a->AddNodeA (obj);
+      objects.push_back (obj);
+    }
+  Names::Add ("/Names/Compiled", a);
+
+  const char *paths[] = {
+    "/NodeA/NodesA/*", "/NodeA/NodesA/[1-3]", "/NodeA/NodesA/0|[4-5]",
+    "/NodeA/NodesA/2|9", "/NodeA/NodesB/*", "/NodeA/NodesA", "/NodeA/*/*",
+    "/Names/Compiled/NodesA/[2-4]", "/NodeA/$ConfigTestObject/NodesA/5",
+    "/NodeA/NodesA/x"
+  };
+  for (uint32_t i = 0; i < sizeof (paths) / sizeof (paths[0]); ++i)
+    {
+      Config::MatchContainer expected = Config::LookupMatches (paths[i]);
+      Config::MatchContainer matched = Config::CompiledPath (std::string (paths[i]) + "/A").LookupMatches ();
+      NS_TEST_ASSERT_MSG_EQ (matched.GetN (), expected.GetN (), "Wrong number of matches for " << paths[i]);
+      for (uint32_t j = 0; j < matched.GetN () && j < expected.GetN (); ++j)
+        {
+          NS_TEST_ASSERT_MSG_EQ (matched.Get (j), expected.Get (j), "Wrong match for " << paths[i]);
+          NS_TEST_ASSERT_MSG_EQ (matched.GetMatchedPath (j), expected.GetMatchedPath (j),
+                                 "Wrong context for " << paths[i]);
+        }
+    }
+
+  //
+  // A compiled path can be applied several times.
+  //
+  Config::CompiledPath path ("/NodeA/NodesA/[1-2]/A");
+  path.Set (IntegerValue (3));
+  objects[1]->GetAttribute ("A", iv);
+  NS_TEST_ASSERT_MSG_EQ (iv.Get (), 3, "Compiled path did not set the attribute");
+  objects[3]->GetAttribute ("A", iv);
+  NS_TEST_ASSERT_MSG_EQ (iv.Get (), 10, "Compiled path set an attribute it does not match");
+  path.Set (IntegerValue (4));
+  objects[2]->GetAttribute ("A", iv);
+  NS_TEST_ASSERT_MSG_EQ (iv.Get (), 4, "Compiled path did not set the attribute again");
+
+  Config::CompiledPath source ("/NodeA/NodesA/4/Source");
+  source.Connect (MakeCallback (&CompiledPathConfigTestCase::TraceWithPath, this));
+  objects[4]->SetAttribute ("Source", IntegerValue (-2));
+  NS_TEST_ASSERT_MSG_EQ (m_path, "/NodeA/NodesA/4/Source", "Compiled path did not provide expected context");
+  source.Disconnect (MakeCallback (&CompiledPathConfigTestCase::TraceWithPath, this));
+  m_path = "";
+  objects[4]->SetAttribute ("Source", IntegerValue (-3));
+  NS_TEST_ASSERT_MSG_EQ (m_path, "", "Compiled path did not disconnect");
+
+  //
+  // A batch applies all its operations in one walk, each at most once
+  // per object.
+  //
+  Config::Batch batch;
+  batch.Set ("/NodeA/NodesA/*/B", IntegerValue (7));
+  batch.ConnectWithoutContext ("/NodeA/NodesA/*/Source",
+                               MakeCallback (&CompiledPathConfigTestCase::Trace, this));
+  batch.Connect ("/NodeA/NodesA/5/Source",
+                 MakeCallback (&CompiledPathConfigTestCase::TraceWithPath, this));
+  NS_TEST_ASSERT_MSG_EQ (batch.Apply (), 13, "Batch did not apply all its operations");
+  objects[0]->GetAttribute ("B", iv);
+  NS_TEST_ASSERT_MSG_EQ (iv.Get (), 7, "Batch did not set the attribute");
+  m_count = 0;
+  objects[5]->SetAttribute ("Source", IntegerValue (-4));
+  NS_TEST_ASSERT_MSG_EQ (m_count, 1, "Batch did not connect the trace source");
+  NS_TEST_ASSERT_MSG_EQ (m_path, "/NodeA/NodesA/5/Source", "Batch did not provide expected context");
+
+  NS_TEST_ASSERT_MSG_EQ (batch.Apply (), 0, "Batch applied an operation twice");
+  m_count = 0;
+  objects[5]->SetAttribute ("Source", IntegerValue (-5));
+  NS_TEST_ASSERT_MSG_EQ (m_count, 1, "Batch connected a trace source twice");
+
+  Ptr<ConfigTestObject> added = CreateObject<ConfigTestObject> ();
+  a->AddNodeA (added);
+  uint32_t references = added->GetReferenceCount ();
+  NS_TEST_ASSERT_MSG_EQ (batch.Update (), 2, "Batch did not apply its operations to the new object only");
+  NS_TEST_ASSERT_MSG_EQ (added->GetReferenceCount (), references, "Batch kept a reference to a matched object");
+  NS_TEST_ASSERT_MSG_EQ (batch.Update (), 0, "Batch update applied an operation twice");
+  NS_TEST_ASSERT_MSG_EQ (batch.Apply (), 0, "Batch applied an operation twice");
+  added->GetAttribute ("B", iv);
+  NS_TEST_ASSERT_MSG_EQ (iv.Get (), 7, "Batch did not set the attribute of the new object");
+  m_count = 0;
+  added->SetAttribute ("Source", IntegerValue (-6));
+  NS_TEST_ASSERT_MSG_EQ (m_count, 1, "Batch did not connect the trace source of the new object");
+
+  Config::UnregisterRootNamespaceObject (root);
+}
+
 // ===========================================================================
 // The Test Suite that glues all of the Test Cases together.
 // ===========================================================================
@@ -737,6 +861,7 @@ ConfigTestSuite::ConfigTestSuite ()
   AddTestCase (new UnderRootNamespaceConfigTestCase, TestCase::QUICK);
   AddTestCase (new ObjectVectorConfigTestCase, TestCase::QUICK);
   AddTestCase (new SearchAttributesOfParentObjectsTestCase, TestCase::QUICK);
+  AddTestCase (new CompiledPathConfigTestCase, TestCase::QUICK);
 }
 
 static ConfigTestSuite configTestSuite;
@@ -18,10 +18,13 @@
  */
 
 #include "ns3/int64x64.h"
+#include "ns3/nstime.h"
+#include "ns3/simulator.h"
 #include "ns3/test.h"
 #include "ns3/valgrind.h"  // Bug 1882
 
 #include <cmath>    // fabs
+#include <ctime>    // clock
 #include <iomanip>
 #include <limits>   // numeric_limits<>::epsilon ()
 
@@ -1244,6 +1247,163 @@ public:
   }
 }  g_int64x64TestSuite;
 
+
+/**
+ * Micro-benchmark of the int64x64_t primitives.
+ *
+ * Only one implementation is compiled in at a time, so to compare
+ * the 128-bit, cairo and long double implementations run the
+ * \c int64x64-perf suite once per configuration, e.g.
+ * \code
+ *   ./waf configure --int64x64=cairo
+ *   ./test.py -s int64x64-perf
+ * \endcode
+ */
+class Int64x64PerfTestCase : public TestCase
+{
+public:
+  Int64x64PerfTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Print the time per operation.
+   *
+   * \param [in] what The operation measured.
+   * \param [in] ticks The clock ticks used by all repetitions.
+   */
+  void Report (const std::string what, const std::clock_t ticks) const;
+  /** Number of repetitions of each operation. */
+  static const uint32_t REPETITIONS = 1000000;
+};
+
+Int64x64PerfTestCase::Int64x64PerfTestCase ()
+  : TestCase ("Measure int64x64_t operation time")
+{
+}
+
+void
+Int64x64PerfTestCase::Report (const std::string what,
+                              const std::clock_t ticks) const
+{
+  double per = 1e9 * double (ticks) / (double (REPETITIONS) * CLOCKS_PER_SEC);
+  std::cout << GetParent ()->GetName () << ": "
+            << std::left << std::setw (26) << what << std::right
+            << std::fixed << std::setprecision (2) << std::setw (8) << per
+            << " ns/op" << std::endl;
+}
+
+void
+Int64x64PerfTestCase::DoRun (void)
+{
+  std::cout << std::endl;
+  std::cout << GetParent ()->GetName () << ": implementation: ";
+  switch (int64x64_t::implementation)
+    {
+    case (int64x64_t::int128_impl) : std::cout << "int128_impl"; break;
+    case (int64x64_t::cairo_impl)  : std::cout << "cairo_impl";  break;
+    case (int64x64_t::ld_impl)     : std::cout << "ld_impl";     break;
+    default :                        std::cout << "unknown!";
+    }
+  std::cout << std::endl;
+
+  // Accumulate into volatile sinks, so the loops are not optimized away.
+  volatile double dsink = 0;
+  volatile int64_t isink = 0;
+  const int64x64_t step = int64x64_t (1, 0x4000000000000000ULL);  // 1.25
+  const int64x64_t factor = int64x64_t (1000000000);
+  const int64x64_t inverse = int64x64_t::Invert (1000000000);
+
+  int64x64_t x = int64x64_t (1);
+  std::clock_t start = std::clock ();
+  for (uint32_t i = 0; i < REPETITIONS; ++i)
+    {
+      x += step;
+    }
+  Report ("add", std::clock () - start);
+  isink = isink + x.GetHigh ();
+
+  start = std::clock ();
+  for (uint32_t i = 0; i < REPETITIONS; ++i)
+    {
+      isink = isink + (int64x64_t (i) * factor).GetHigh ();
+    }
+  Report ("multiply", std::clock () - start);
+
+  start = std::clock ();
+  for (uint32_t i = 0; i < REPETITIONS; ++i)
+    {
+      isink = isink + (int64x64_t (i) / factor).GetLow ();
+    }
+  Report ("divide", std::clock () - start);
+
+  start = std::clock ();
+  for (uint32_t i = 0; i < REPETITIONS; ++i)
+    {
+      int64x64_t y = int64x64_t (i);
+      y.MulByInvert (inverse);
+      isink = isink + y.GetLow ();
+    }
+  Report ("multiply by invert", std::clock () - start);
+
+  start = std::clock ();
+  for (uint32_t i = 0; i < REPETITIONS; ++i)
+    {
+      isink = isink + int64x64_t (i * 1e-3).GetLow ();
+    }
+  Report ("from double", std::clock () - start);
+
+  start = std::clock ();
+  for (uint32_t i = 0; i < REPETITIONS; ++i)
+    {
+      dsink = dsink + int64x64_t (int64_t (i), i).GetDouble ();
+    }
+  Report ("to double", std::clock () - start);
+
+  // The Time conversions built on int64x64_t, with their integer
+  // fast paths.  Run the (empty) simulator first, which stops the
+  // bookkeeping of Times created before the resolution is frozen,
+  // as in a running simulation.
+  Simulator::Run ();
+  start = std::clock ();
+  for (uint32_t i = 0; i < REPETITIONS; ++i)
+    {
+      dsink = dsink + NanoSeconds (i).GetSeconds ();
+    }
+  Report ("Time::GetSeconds", std::clock () - start);
+
+  start = std::clock ();
+  for (uint32_t i = 0; i < REPETITIONS; ++i)
+    {
+      isink = isink + Seconds (double (i & 0xff)).GetTimeStep ();
+    }
+  Report ("Seconds (integral double)", std::clock () - start);
+
+  start = std::clock ();
+  for (uint32_t i = 0; i < REPETITIONS; ++i)
+    {
+      isink = isink + Seconds (i * 1e-6).GetTimeStep ();
+    }
+  Report ("Seconds (double)", std::clock () - start);
+
+  start = std::clock ();
+  for (uint32_t i = 0; i < REPETITIONS; ++i)
+    {
+      isink = isink + (NanoSeconds (i) * int64_t (3)).GetTimeStep ();
+    }
+  Report ("Time * int64_t", std::clock () - start);
+  Simulator::Destroy ();
+}
+
+static class Int64x64PerfTestSuite : public TestSuite
+{
+public:
+  Int64x64PerfTestSuite ()
+    : TestSuite ("int64x64-perf", PERFORMANCE)
+  {
+    AddTestCase (new Int64x64PerfTestCase (), TestCase::QUICK);
+  }
+}  g_int64x64PerfTestSuite;
+
 }  // namespace test
 
 }  // namespace int64x64
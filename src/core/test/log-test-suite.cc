@@ -0,0 +1,292 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#endif
+
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup logbinary
+ * Binary logging backend tests.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LogTestSuite");
+
+} // namespace ns3
+
+using namespace ns3;
+
+/**
+ * \ingroup logbinary
+ * Check that decoding a binary log gives the text log output.
+ */
+class LogBinaryTestCase : public TestCase
+{
+public:
+  LogBinaryTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * Log one message of each kind.
+   * \param [in] object An object to log pointers to.
+   */
+  void LogMessages (Ptr<Object> object);
+};
+
+LogBinaryTestCase::LogBinaryTestCase ()
+  : TestCase ("Check binary log decoding against text logging")
+{
+}
+
+void
+LogBinaryTestCase::LogMessages (Ptr<Object> object)
+{
+  NS_LOG_FUNCTION (this << 1 << "two" << 3.5);
+  NS_LOG_FUNCTION (Seconds (1) << 2 << 'c');
+  NS_LOG_FUNCTION_NOARGS ();
+  NS_LOG_INFO ("int " << 42 << " neg " << -7 << " unsigned " << 7u
+               << " double " << 1.5 << " char " << 'x' << " bool " << true
+               << " string " << std::string ("abc"));
+  NS_LOG_DEBUG ("pointers " << PeekPointer (object) << " " << object
+                << " " << static_cast<void *> (0));
+  NS_LOG_LOGIC ("time " << Seconds (1.5) << " then " << 3);
+  NS_LOG_WARN ("hex " << std::hex << 255 << std::dec << " " << 255);
+  NS_LOG_ERROR ("long " << std::string (1000, 'y') << " " << 1);
+}
+
+void
+LogBinaryTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("log-test-suite.blog");
+  LogComponentEnable ("LogTestSuite", LogLevel (LOG_LEVEL_ALL | LOG_PREFIX_ALL));
+
+  Ptr<Object> object = CreateObject<Object> ();
+  std::ostringstream text;
+  std::streambuf *clog = std::clog.rdbuf (text.rdbuf ());
+  LogMessages (object);
+  LogBinaryEnable (filename, 512);
+  LogMessages (object);
+  LogBinaryDisable ();
+  std::clog.rdbuf (clog);
+  LogComponentDisable ("LogTestSuite", LOG_LEVEL_ALL);
+
+  std::ifstream is (filename.c_str (), std::ios::in | std::ios::binary);
+  std::ostringstream decoded;
+  bool ok = LogBinaryDecode (is, decoded);
+  NS_TEST_ASSERT_MSG_EQ (ok, true, "Decoding failed");
+  NS_TEST_ASSERT_MSG_EQ (decoded.str (), text.str (), "Decoded log differs from text log");
+
+  std::ifstream again (filename.c_str (), std::ios::in | std::ios::binary);
+  std::string bytes ((std::istreambuf_iterator<char> (again)),
+                     std::istreambuf_iterator<char> ());
+  std::istringstream truncated (bytes.substr (0, bytes.size () - 3));
+  std::ostringstream partial;
+  ok = LogBinaryDecode (truncated, partial);
+  NS_TEST_ASSERT_MSG_EQ (ok, false, "Truncated log decoded");
+  std::istringstream garbage ("not a binary log");
+  ok = LogBinaryDecode (garbage, partial);
+  NS_TEST_ASSERT_MSG_EQ (ok, false, "Garbage decoded");
+}
+
+#ifdef HAVE_PTHREAD_H
+/**
+ * \ingroup logbinary
+ * Check that the records of several threads all reach the binary log,
+ * while the main thread keeps flushing.
+ */
+class LogBinaryThreadTestCase : public TestCase
+{
+public:
+  LogBinaryThreadTestCase ();
+private:
+  virtual void DoRun (void);
+  /** Log MESSAGES messages. */
+  static void LogMessages (void);
+  /** Number of threads logging. */
+  static const uint32_t THREADS = 4;
+  /** Number of messages logged by each thread. */
+  static const uint32_t MESSAGES = 2000;
+};
+
+LogBinaryThreadTestCase::LogBinaryThreadTestCase ()
+  : TestCase ("Check binary logging from several threads")
+{
+}
+
+void
+LogBinaryThreadTestCase::LogMessages (void)
+{
+  for (uint32_t i = 0; i < MESSAGES; ++i)
+    {
+      NS_LOG_INFO ("message " << i);
+    }
+}
+
+void
+LogBinaryThreadTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("log-thread.blog");
+  LogComponentEnable ("LogTestSuite", LOG_LEVEL_INFO);
+  LogBinaryEnable (filename, 256);
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 0; i < THREADS; ++i)
+    {
+      threads.push_back (Create<SystemThread> (MakeCallback (&LogBinaryThreadTestCase::LogMessages)));
+      threads.back ()->Start ();
+    }
+  for (uint32_t i = 0; i < MESSAGES; ++i)
+    {
+      NS_LOG_INFO ("message " << i);
+      LogBinaryFlush ();
+    }
+  for (uint32_t i = 0; i < THREADS; ++i)
+    {
+      threads[i]->Join ();
+    }
+  LogBinaryDisable ();
+  LogComponentDisable ("LogTestSuite", LOG_LEVEL_ALL);
+
+  std::ifstream is (filename.c_str (), std::ios::in | std::ios::binary);
+  std::ostringstream decoded;
+  bool ok = LogBinaryDecode (is, decoded);
+  NS_TEST_ASSERT_MSG_EQ (ok, true, "Decoding failed");
+  std::string text = decoded.str ();
+  uint32_t lines = std::count (text.begin (), text.end (), '\n');
+  NS_TEST_ASSERT_MSG_EQ (lines, (THREADS + 1) * MESSAGES, "Lost or corrupt records");
+}
+#endif /* HAVE_PTHREAD_H */
+
+/**
+ * \ingroup logbinary
+ * Logging test suite.
+ */
+class LogTestSuite : public TestSuite
+{
+public:
+  LogTestSuite ();
+};
+
+LogTestSuite::LogTestSuite ()
+  : TestSuite ("log", UNIT)
+{
+  AddTestCase (new LogBinaryTestCase, TestCase::QUICK);
+#ifdef HAVE_PTHREAD_H
+  AddTestCase (new LogBinaryThreadTestCase, TestCase::QUICK);
+#endif
+}
+
+static LogTestSuite g_logTestSuite;
+
+
+/**
+ * \ingroup logbinary
+ * Compare the cost of text and binary logging.
+ */
+class LogPerfTestCase : public TestCase
+{
+public:
+  LogPerfTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * Print the time per message.
+   *
+   * \param [in] what The logging backend measured.
+   * \param [in] ticks The clock ticks used.
+   */
+  void Report (const std::string what, const std::clock_t ticks) const;
+  /** Number of messages logged with each backend. */
+  static const uint32_t MESSAGES = 200000;
+};
+
+LogPerfTestCase::LogPerfTestCase ()
+  : TestCase ("Measure text and binary logging time")
+{
+}
+
+void
+LogPerfTestCase::Report (const std::string what,
+                         const std::clock_t ticks) const
+{
+  double per = 1e9 * double (ticks) / (double (MESSAGES) * CLOCKS_PER_SEC);
+  std::cout << GetParent ()->GetName () << ": "
+            << std::left << std::setw (32) << what << std::right
+            << std::fixed << std::setprecision (2) << std::setw (8) << per
+            << " ns/message" << std::endl;
+}
+
+void
+LogPerfTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("log-perf.blog");
+  LogComponentEnable ("LogTestSuite", LogLevel (LOG_LEVEL_INFO | LOG_PREFIX_ALL));
+
+  std::ofstream sink (CreateTempDirFilename ("log-perf.txt").c_str ());
+  std::streambuf *clog = std::clog.rdbuf (sink.rdbuf ());
+  std::clock_t start = std::clock ();
+  for (uint32_t i = 0; i < MESSAGES; ++i)
+    {
+      NS_LOG_INFO ("packet " << i << " size " << 1500 << " ratio " << i * 0.5);
+    }
+  Report ("text NS_LOG_INFO", std::clock () - start);
+  std::clog.rdbuf (clog);
+
+  LogBinaryEnable (filename);
+  start = std::clock ();
+  for (uint32_t i = 0; i < MESSAGES; ++i)
+    {
+      NS_LOG_INFO ("packet " << i << " size " << 1500 << " ratio " << i * 0.5);
+    }
+  LogBinaryFlush ();
+  Report ("binary NS_LOG_INFO", std::clock () - start);
+  LogBinaryDisable ();
+  LogComponentDisable ("LogTestSuite", LOG_LEVEL_ALL);
+}
+
+/**
+ * \ingroup logbinary
+ * Logging performance suite.
+ */
+class LogPerfTestSuite : public TestSuite
+{
+public:
+  LogPerfTestSuite ();
+};
+
+LogPerfTestSuite::LogPerfTestSuite ()
+  : TestSuite ("log-perf", PERFORMANCE)
+{
+  AddTestCase (new LogPerfTestCase, TestCase::QUICK);
+}
+
+static LogPerfTestSuite g_logPerfTestSuite;
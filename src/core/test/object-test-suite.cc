@@ -23,6 +23,8 @@
 #include "ns3/object-factory.h"
 #include "ns3/assert.h"
 
+#include <vector>
+
 namespace {
 
 class BaseA : public ns3::Object
@@ -113,6 +115,14 @@ public:
   }
 };
 
+// A subclass without a TypeId of its own: its TypeId is the one of BaseB.
+class UntypedB : public BaseB
+{
+public:
+  UntypedB ()
+  {}
+};
+
 NS_OBJECT_ENSURE_REGISTERED (BaseA);
 NS_OBJECT_ENSURE_REGISTERED (DerivedA);
 NS_OBJECT_ENSURE_REGISTERED (BaseB);
@@ -359,6 +369,92 @@ AggregateObjectTestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_NE (baseA, 0, "Unable to GetObject on released object");
 }
 
+// ===========================================================================
+// Test case to make sure that GetObject finds aggregates through every
+// TypeId of their parent chain, and does not reorder the aggregates.
+// ===========================================================================
+class AggregateIndexTestCase : public TestCase
+{
+public:
+  AggregateIndexTestCase ();
+  virtual ~AggregateIndexTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AggregateIndexTestCase::AggregateIndexTestCase ()
+  : TestCase ("Check GetObject through the aggregate index")
+{
+}
+
+AggregateIndexTestCase::~AggregateIndexTestCase ()
+{
+}
+
+void
+AggregateIndexTestCase::DoRun (void)
+{
+  Ptr<DerivedA> derivedA = CreateObject<DerivedA> ();
+  Ptr<DerivedB> derivedB = CreateObject<DerivedB> ();
+
+  //
+  // A single object is found through its own TypeId and its parents.
+  //
+  NS_TEST_ASSERT_MSG_EQ (derivedA->GetObject<BaseA> (), derivedA, "Cannot GetObject for the parent TypeId");
+  NS_TEST_ASSERT_MSG_EQ (derivedA->GetObject<Object> (), derivedA, "Cannot GetObject for ns3::Object");
+  NS_TEST_ASSERT_MSG_EQ (derivedA->GetObject<BaseB> (), 0, "Unexpectedly found a BaseB");
+
+  derivedA->AggregateObject (derivedB);
+  NS_TEST_ASSERT_MSG_EQ (derivedB->GetObject<BaseA> (BaseA::GetTypeId ()), derivedA,
+                         "Cannot GetObject by TypeId for the parent TypeId");
+  NS_TEST_ASSERT_MSG_EQ (derivedB->GetObject<Object> (DerivedB::GetTypeId ()), derivedB,
+                         "Cannot GetObject by TypeId for the instance TypeId");
+  NS_TEST_ASSERT_MSG_EQ (derivedA->GetObject<BaseB> (), derivedB, "Cannot GetObject for the parent TypeId of an aggregate");
+  NS_TEST_ASSERT_MSG_EQ (derivedA->GetObject<Object> (), derivedA, "Cannot GetObject for ns3::Object");
+
+  //
+  // Looking objects up must not change the order of the aggregates.
+  //
+  std::vector<Ptr<const Object> > before;
+  Object::AggregateIterator i = derivedB->GetAggregateIterator ();
+  while (i.HasNext ())
+    {
+      before.push_back (i.Next ());
+    }
+  for (uint32_t j = 0; j < 10; ++j)
+    {
+      derivedA->GetObject<DerivedB> ();
+    }
+  i = derivedA->GetAggregateIterator ();
+  for (uint32_t j = 0; j < before.size (); ++j)
+    {
+      NS_TEST_ASSERT_MSG_EQ (i.HasNext (), true, "Aggregate disappeared");
+      NS_TEST_ASSERT_MSG_EQ (i.Next (), before[j], "Aggregates were reordered by GetObject");
+    }
+
+  //
+  // An object created without CreateObject only knows its TypeId as
+  // ns3::Object, but GetObject still finds it through its C++ type.
+  //
+  Ptr<BaseB> untyped = Ptr<BaseB> (new DerivedB (), false);
+  NS_TEST_ASSERT_MSG_EQ (untyped->GetObject<DerivedB> (), untyped, "Cannot GetObject on an untyped object");
+  NS_TEST_ASSERT_MSG_EQ (untyped->GetObject<BaseA> (), 0, "Unexpectedly found a BaseA on an untyped object");
+
+  //
+  // A subclass without a TypeId is indexed under the TypeId of its
+  // parent, and found through its C++ type when aggregated.
+  //
+  Ptr<UntypedB> untypedB = CreateObject<UntypedB> ();
+  Ptr<BaseA> baseA = CreateObject<BaseA> ();
+  NS_TEST_ASSERT_MSG_EQ (untypedB->GetObject<UntypedB> (), untypedB, "Cannot GetObject for a TypeId-less subclass");
+  untypedB->AggregateObject (baseA);
+  NS_TEST_ASSERT_MSG_EQ (baseA->GetObject<UntypedB> (), untypedB, "Cannot GetObject for an aggregated TypeId-less subclass");
+  NS_TEST_ASSERT_MSG_EQ (baseA->GetObject<BaseB> (), untypedB, "Cannot GetObject for the TypeId of a TypeId-less subclass");
+  NS_TEST_ASSERT_MSG_EQ (untypedB->GetObject<BaseA> (), baseA, "Cannot GetObject from a TypeId-less subclass");
+  NS_TEST_ASSERT_MSG_EQ (untypedB->GetObject<DerivedB> (), 0, "Unexpectedly found a DerivedB");
+}
+
 // ===========================================================================
 // Test case to make sure that an Object factory can create Objects
 // ===========================================================================
@@ -445,6 +541,7 @@ ObjectTestSuite::ObjectTestSuite ()
 {
   AddTestCase (new CreateObjectTestCase, TestCase::QUICK);
   AddTestCase (new AggregateObjectTestCase, TestCase::QUICK);
+  AddTestCase (new AggregateIndexTestCase, TestCase::QUICK);
   AddTestCase (new ObjectFactoryTestCase, TestCase::QUICK);
 }
 
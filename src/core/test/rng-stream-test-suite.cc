@@ -0,0 +1,400 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/rng-stream.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup rngimpl
+ * Block generation tests for RngStream, RngStreamLanes and
+ * RandomVariableStream.
+ */
+
+using namespace ns3;
+
+/**
+ * \ingroup rngimpl
+ * Check that block generation returns the scalar sequence.
+ */
+class RngStreamBlockTestCase : public TestCase
+{
+public:
+  RngStreamBlockTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+RngStreamBlockTestCase::RngStreamBlockTestCase ()
+  : TestCase ("Check RngStream block generation against scalar generation")
+{
+}
+
+void
+RngStreamBlockTestCase::DoRun (void)
+{
+  RngStream scalar (12345, 3, 7);
+  RngStream block (12345, 3, 7);
+  const uint32_t sizes[] = { 1, 0, 7, 1000, 2, 4096, 33 };
+  std::vector<double> u;
+  for (uint32_t i = 0; i < sizeof (sizes) / sizeof (sizes[0]); ++i)
+    {
+      u.resize (sizes[i] + 1);
+      block.RandU01 (&u[0], sizes[i]);
+      for (uint32_t j = 0; j < sizes[i]; ++j)
+        {
+          NS_TEST_ASSERT_MSG_EQ (u[j], scalar.RandU01 (), "Block value " << j << " of block " << i);
+        }
+      // Interleave scalar calls on the block stream.
+      NS_TEST_ASSERT_MSG_EQ (block.RandU01 (), scalar.RandU01 (), "Scalar value after block " << i);
+    }
+}
+
+/**
+ * \ingroup rngimpl
+ * Check that each lane of RngStreamLanes returns the sequence of its
+ * scalar substream.
+ */
+class RngStreamLanesTestCase : public TestCase
+{
+public:
+  RngStreamLanesTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+RngStreamLanesTestCase::RngStreamLanesTestCase ()
+  : TestCase ("Check RngStreamLanes against scalar substreams")
+{
+}
+
+void
+RngStreamLanesTestCase::DoRun (void)
+{
+  const uint32_t L = RngStreamLanes::LANES;
+  const uint32_t rows = 10000;
+  std::vector<RngStream> scalar;
+  for (uint32_t l = 0; l < L; ++l)
+    {
+      scalar.push_back (RngStream (1, 42, 5 + l));
+    }
+
+  RngStreamLanes lanes (1, 42, 5);
+  std::vector<double> u (rows * L);
+  lanes.RandU01 (&u[0], rows);
+  for (uint32_t i = 0; i < rows; ++i)
+    {
+      for (uint32_t l = 0; l < L; ++l)
+        {
+          NS_TEST_ASSERT_MSG_EQ (u[i * L + l], scalar[l].RandU01 (), "Row " << i << " lane " << l);
+        }
+    }
+
+  // Lanes can be loaded from and stored to arbitrary streams.
+  RngStream other (99, 1000, 0);
+  other.RandU01 ();
+  lanes.SetLane (2, other);
+  lanes.RandU01 (&u[0], 3);
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (u[i * L + 2], other.RandU01 (), "Loaded lane, row " << i);
+      NS_TEST_ASSERT_MSG_EQ (u[i * L + 1], scalar[1].RandU01 (), "Other lane, row " << i);
+    }
+  RngStream stored (1, 0, 0);
+  lanes.GetLane (1, &stored);
+  NS_TEST_ASSERT_MSG_EQ (stored.RandU01 (), scalar[1].RandU01 (), "Stored lane");
+}
+
+/**
+ * \ingroup randomvariable
+ * Check that GetValues() and buffered generation do not change the
+ * values returned by random variables.
+ */
+class RandomVariableBlockTestCase : public TestCase
+{
+public:
+  RandomVariableBlockTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * Compare two identically configured random variables, the second
+   * one being drawn with GetValues() in blocks of varying sizes.
+   *
+   * \param [in] what A description of the random variables.
+   * \param [in] a The reference random variable.
+   * \param [in] b The random variable drawn in blocks.
+   */
+  void Compare (std::string what, Ptr<RandomVariableStream> a, Ptr<RandomVariableStream> b);
+};
+
+RandomVariableBlockTestCase::RandomVariableBlockTestCase ()
+  : TestCase ("Check block and buffered RandomVariableStream generation")
+{
+}
+
+void
+RandomVariableBlockTestCase::Compare (std::string what,
+                                      Ptr<RandomVariableStream> a,
+                                      Ptr<RandomVariableStream> b)
+{
+  std::vector<double> values (512);
+  for (uint32_t round = 0; round < 20; ++round)
+    {
+      uint32_t n = (round * 97) % 512;
+      b->GetValues (&values[0], n);
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          NS_TEST_ASSERT_MSG_EQ (values[i], a->GetValue (), what << ", round " << round << ", value " << i);
+        }
+      NS_TEST_ASSERT_MSG_EQ (b->GetValue (), a->GetValue (), what << ", after round " << round);
+    }
+}
+
+void
+RandomVariableBlockTestCase::DoRun (void)
+{
+  for (uint32_t antithetic = 0; antithetic < 2; ++antithetic)
+    {
+      std::string suffix = antithetic ? " (antithetic)" : "";
+      Ptr<RandomVariableStream> a, b;
+
+      a = CreateObject<UniformRandomVariable> ();
+      b = CreateObject<UniformRandomVariable> ();
+      a->SetAttribute ("Min", DoubleValue (-2));
+      b->SetAttribute ("Min", DoubleValue (-2));
+      a->SetAttribute ("Max", DoubleValue (5));
+      b->SetAttribute ("Max", DoubleValue (5));
+      a->SetAntithetic (antithetic);
+      b->SetAntithetic (antithetic);
+      a->SetStream (10);
+      b->SetStream (10);
+      Compare ("uniform" + suffix, a, b);
+
+      double bounds[] = { 0.0, 2.0 };
+      for (uint32_t i = 0; i < 2; ++i)
+        {
+          a = CreateObject<ExponentialRandomVariable> ();
+          b = CreateObject<ExponentialRandomVariable> ();
+          a->SetAttribute ("Mean", DoubleValue (1.5));
+          b->SetAttribute ("Mean", DoubleValue (1.5));
+          a->SetAttribute ("Bound", DoubleValue (bounds[i]));
+          b->SetAttribute ("Bound", DoubleValue (bounds[i]));
+          b->SetAttribute ("BufferSize", UintegerValue (100));
+          a->SetAntithetic (antithetic);
+          b->SetAntithetic (antithetic);
+          a->SetStream (11);
+          b->SetStream (11);
+          Compare ("exponential" + suffix, a, b);
+
+          a = CreateObject<NormalRandomVariable> ();
+          b = CreateObject<NormalRandomVariable> ();
+          a->SetAttribute ("Variance", DoubleValue (4));
+          b->SetAttribute ("Variance", DoubleValue (4));
+          if (bounds[i] != 0)
+            {
+              a->SetAttribute ("Bound", DoubleValue (bounds[i]));
+              b->SetAttribute ("Bound", DoubleValue (bounds[i]));
+            }
+          b->SetAttribute ("BufferSize", UintegerValue (100));
+          a->SetAntithetic (antithetic);
+          b->SetAntithetic (antithetic);
+          a->SetStream (12);
+          b->SetStream (12);
+          Compare ("normal" + suffix, a, b);
+        }
+    }
+
+  // Resizing the buffer keeps the sequence; changing the stream
+  // discards the buffered values.
+  Ptr<ExponentialRandomVariable> a = CreateObject<ExponentialRandomVariable> ();
+  Ptr<ExponentialRandomVariable> b = CreateObject<ExponentialRandomVariable> ();
+  a->SetStream (13);
+  b->SetStream (13);
+  b->SetAttribute ("BufferSize", UintegerValue (1000));
+  for (uint32_t i = 0; i < 3000; ++i)
+    {
+      if (i == 500)
+        {
+          b->SetAttribute ("BufferSize", UintegerValue (7));
+        }
+      if (i == 2000)
+        {
+          a->SetStream (14);
+          b->SetStream (14);
+        }
+      NS_TEST_ASSERT_MSG_EQ (b->GetValue (), a->GetValue (), "Resized buffer, value " << i);
+    }
+}
+
+/**
+ * \ingroup rngimpl
+ * RNG generation test suite.
+ */
+class RngStreamTestSuite : public TestSuite
+{
+public:
+  RngStreamTestSuite ();
+};
+
+RngStreamTestSuite::RngStreamTestSuite ()
+  : TestSuite ("rng-stream", UNIT)
+{
+  AddTestCase (new RngStreamBlockTestCase, TestCase::QUICK);
+  AddTestCase (new RngStreamLanesTestCase, TestCase::QUICK);
+  AddTestCase (new RandomVariableBlockTestCase, TestCase::QUICK);
+}
+
+static RngStreamTestSuite g_rngStreamTestSuite;
+
+
+/**
+ * \ingroup rngimpl
+ * Compare the throughput of scalar, block, lane and buffered
+ * random number generation.
+ */
+class RngStreamPerfTestCase : public TestCase
+{
+public:
+  RngStreamPerfTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * Print the time per value.
+   *
+   * \param [in] what The generation method measured.
+   * \param [in] ticks The clock ticks used.
+   */
+  void Report (const std::string what, const std::clock_t ticks) const;
+  /** Number of values generated by each method. */
+  static const uint32_t VALUES = 4000000;
+};
+
+RngStreamPerfTestCase::RngStreamPerfTestCase ()
+  : TestCase ("Measure scalar and block generation time")
+{
+}
+
+void
+RngStreamPerfTestCase::Report (const std::string what,
+                               const std::clock_t ticks) const
+{
+  double per = 1e9 * double (ticks) / (double (VALUES) * CLOCKS_PER_SEC);
+  std::cout << GetParent ()->GetName () << ": "
+            << std::left << std::setw (32) << what << std::right
+            << std::fixed << std::setprecision (2) << std::setw (8) << per
+            << " ns/value" << std::endl;
+}
+
+void
+RngStreamPerfTestCase::DoRun (void)
+{
+  const uint32_t BLOCK = 256;
+  std::vector<double> u (BLOCK);
+  volatile double sink = 0;
+
+  RngStream scalar (1, 0, 0);
+  std::clock_t start = std::clock ();
+  for (uint32_t i = 0; i < VALUES; ++i)
+    {
+      sink = sink + scalar.RandU01 ();
+    }
+  Report ("RngStream::RandU01", std::clock () - start);
+
+  start = std::clock ();
+  for (uint32_t i = 0; i < VALUES; i += BLOCK)
+    {
+      scalar.RandU01 (&u[0], BLOCK);
+      sink = sink + u[BLOCK - 1];
+    }
+  Report ("RngStream::RandU01 (block)", std::clock () - start);
+
+  RngStreamLanes lanes (1, 0, 0);
+  const uint32_t rows = BLOCK / RngStreamLanes::LANES;
+  start = std::clock ();
+  for (uint32_t i = 0; i < VALUES; i += BLOCK)
+    {
+      lanes.RandU01 (&u[0], rows);
+      sink = sink + u[BLOCK - 1];
+    }
+  Report ("RngStreamLanes::RandU01", std::clock () - start);
+
+  Ptr<ExponentialRandomVariable> exponential = CreateObject<ExponentialRandomVariable> ();
+  start = std::clock ();
+  for (uint32_t i = 0; i < VALUES; ++i)
+    {
+      sink = sink + exponential->GetValue ();
+    }
+  Report ("Exponential GetValue", std::clock () - start);
+
+  exponential->SetAttribute ("BufferSize", UintegerValue (BLOCK));
+  start = std::clock ();
+  for (uint32_t i = 0; i < VALUES; ++i)
+    {
+      sink = sink + exponential->GetValue ();
+    }
+  Report ("Exponential GetValue (buffered)", std::clock () - start);
+
+  start = std::clock ();
+  for (uint32_t i = 0; i < VALUES; i += BLOCK)
+    {
+      exponential->GetValues (&u[0], BLOCK);
+      sink = sink + u[BLOCK - 1];
+    }
+  Report ("Exponential GetValues", std::clock () - start);
+
+  Ptr<NormalRandomVariable> normal = CreateObject<NormalRandomVariable> ();
+  start = std::clock ();
+  for (uint32_t i = 0; i < VALUES; ++i)
+    {
+      sink = sink + normal->GetValue ();
+    }
+  Report ("Normal GetValue", std::clock () - start);
+
+  normal->SetAttribute ("BufferSize", UintegerValue (BLOCK));
+  start = std::clock ();
+  for (uint32_t i = 0; i < VALUES; ++i)
+    {
+      sink = sink + normal->GetValue ();
+    }
+  Report ("Normal GetValue (buffered)", std::clock () - start);
+}
+
+/**
+ * \ingroup rngimpl
+ * RNG generation performance suite.
+ */
+class RngStreamPerfTestSuite : public TestSuite
+{
+public:
+  RngStreamPerfTestSuite ();
+};
+
+RngStreamPerfTestSuite::RngStreamPerfTestSuite ()
+  : TestSuite ("rng-stream-perf", PERFORMANCE)
+{
+  AddTestCase (new RngStreamPerfTestCase, TestCase::QUICK);
+}
+
+static RngStreamPerfTestSuite g_rngStreamPerfTestSuite;
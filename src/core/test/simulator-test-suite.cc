@@ -23,6 +23,11 @@
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+
+#include <fstream>
+#include <sstream>
 
 using namespace ns3;
 
@@ -459,6 +464,63 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+class SimulatorProfileTestCase : public TestCase
+{
+public:
+  SimulatorProfileTestCase ();
+private:
+  virtual void DoRun (void);
+  void Fork (int depth);
+};
+
+SimulatorProfileTestCase::SimulatorProfileTestCase ()
+  : TestCase ("Check that the event profiler attributes events to their targets")
+{
+}
+
+void
+SimulatorProfileTestCase::Fork (int depth)
+{
+  if (depth > 0)
+    {
+      Simulator::Schedule (Seconds (1.0), &SimulatorProfileTestCase::Fork, this, depth - 1);
+      Simulator::Schedule (Seconds (1.0), &SimulatorProfileTestCase::Fork, this, depth - 1);
+    }
+}
+
+void
+SimulatorProfileTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("event-profile.txt");
+  Config::SetDefault ("ns3::DefaultSimulatorImpl::ProfileFile", StringValue (filename));
+  Simulator::ScheduleWithContext (7, Seconds (0.5), &SimulatorProfileTestCase::Fork, this, 3);
+  // A lone event far ahead: the timeline must not grow with simulated time
+  Simulator::ScheduleWithContext (7, Seconds (1e9), &SimulatorProfileTestCase::Fork, this, 0);
+  Simulator::Run ();
+  Simulator::Destroy ();
+  Config::SetDefault ("ns3::DefaultSimulatorImpl::ProfileFile", StringValue (""));
+
+  std::ifstream is (filename.c_str ());
+  NS_TEST_ASSERT_MSG_EQ (is.is_open (), true, "Profile file was not written");
+  std::stringstream contents;
+  contents << is.rdbuf ();
+  std::string profile = contents.str ();
+
+  // 1 + 2 + 4 + 8 + 1 events, of which the first 7 scheduled two events each.
+  NS_TEST_EXPECT_MSG_NE (profile.find ("# events 16,"), std::string::npos,
+                         "Wrong event count in profile");
+  NS_TEST_EXPECT_MSG_NE (profile.find ("events scheduled 14,"), std::string::npos,
+                         "Wrong fan-out in profile");
+  NS_TEST_EXPECT_MSG_NE (profile.find ("SimulatorProfileTestCase::*"), std::string::npos,
+                         "Event target missing from profile");
+  NS_TEST_EXPECT_MSG_NE (profile.find ("simulated seconds 1000000001"), std::string::npos,
+                         "Wrong timeline length in profile");
+  NS_TEST_EXPECT_MSG_NE (profile.find ("\n1000000000           1"), std::string::npos,
+                         "Last second missing from timeline");
+  NS_TEST_EXPECT_MSG_EQ (profile.find (" 999999999 "), std::string::npos,
+                         "Empty second in timeline");
+}
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
@@ -475,5 +537,6 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    AddTestCase (new SimulatorProfileTestCase (), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
@@ -102,6 +102,47 @@ TimeSimpleTestCase::DoTeardown (void)
 {
 }
 
+class TimeIntegerConversionTestCase : public TestCase
+{
+public:
+  TimeIntegerConversionTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TimeIntegerConversionTestCase::TimeIntegerConversionTestCase ()
+  : TestCase ("Checks integer fast paths of unit conversions")
+{
+}
+
+void
+TimeIntegerConversionTestCase::DoRun (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (Seconds (10.0), MilliSeconds (10000),
+                         "integral double seconds");
+  NS_TEST_ASSERT_MSG_EQ (Seconds (-3.0).GetTimeStep (), -3000000000LL,
+                         "negative integral double seconds");
+  NS_TEST_ASSERT_MSG_EQ (Seconds (int64x64_t (7)), MilliSeconds (7000),
+                         "integral int64x64_t seconds");
+  NS_TEST_ASSERT_MSG_EQ (MilliSeconds (int64x64_t (-2)), MicroSeconds (-2000),
+                         "negative integral int64x64_t milliseconds");
+  NS_TEST_ASSERT_MSG_EQ (Seconds (1.5), MilliSeconds (1500),
+                         "fractional double seconds");
+  NS_TEST_ASSERT_MSG_EQ (Seconds (int64x64_t (2.25)), MilliSeconds (2250),
+                         "fractional int64x64_t seconds");
+
+  NS_TEST_ASSERT_MSG_EQ (NanoSeconds (1500000000).GetSeconds (), 1.5,
+                         "seconds from nanoseconds");
+  NS_TEST_ASSERT_MSG_EQ (NanoSeconds (-250).ToDouble (Time::US), -0.25,
+                         "negative microseconds from nanoseconds");
+  NS_TEST_ASSERT_MSG_EQ (NanoSeconds (1).ToDouble (Time::MS), 1e-6,
+                         "milliseconds from one nanosecond");
+  NS_TEST_ASSERT_MSG_EQ (NanoSeconds (7).ToDouble (Time::NS), 7.0,
+                         "nanoseconds as double");
+  NS_TEST_ASSERT_MSG_EQ (NanoSeconds (3).ToDouble (Time::PS), 3000.0,
+                         "picoseconds as double");
+}
+
 class TimeWithSignTestCase : public TestCase
 {
 public:
@@ -237,6 +278,7 @@ public:
     : TestSuite ("time", UNIT)
   {
     AddTestCase (new TimeWithSignTestCase (), TestCase::QUICK);
+    AddTestCase (new TimeIntegerConversionTestCase (), TestCase::QUICK);
     AddTestCase (new TimeInputOutputTestCase (), TestCase::QUICK);
     // This should be last, since it changes the resolution
     AddTestCase (new TimeSimpleTestCase (), TestCase::QUICK);
@@ -18,6 +18,11 @@
 
 #include "ns3/test.h"
 #include "ns3/traced-callback.h"
+#include "ns3/trace-context.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
 
 using namespace ns3;
 
@@ -108,6 +113,114 @@ BasicTracedCallbackTestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (m_two, true, "Callback CbTwo not called");
 }
 
+class ContextTracedCallbackTestCase : public TestCase
+{
+public:
+  ContextTracedCallbackTestCase ();
+  virtual ~ContextTracedCallbackTestCase () {}
+
+private:
+  virtual void DoRun (void);
+
+  void CbPlain (int a);
+  void CbId (TraceContext context, int a);
+  void CbReference (const std::string &context, int a);
+  void CbString (std::string context, int a);
+
+  std::vector<std::string> m_calls;
+};
+
+ContextTracedCallbackTestCase::ContextTracedCallbackTestCase ()
+  : TestCase ("Check TracedCallback contexts")
+{
+}
+
+void
+ContextTracedCallbackTestCase::CbPlain (int a)
+{
+  std::ostringstream oss;
+  oss << "plain " << a;
+  m_calls.push_back (oss.str ());
+}
+
+void
+ContextTracedCallbackTestCase::CbId (TraceContext context, int a)
+{
+  std::ostringstream oss;
+  oss << "id " << context << " " << a;
+  m_calls.push_back (oss.str ());
+}
+
+void
+ContextTracedCallbackTestCase::CbReference (const std::string &context, int a)
+{
+  std::ostringstream oss;
+  oss << "reference " << context << " " << a;
+  m_calls.push_back (oss.str ());
+}
+
+void
+ContextTracedCallbackTestCase::CbString (std::string context, int a)
+{
+  std::ostringstream oss;
+  oss << "string " << context << " " << a;
+  m_calls.push_back (oss.str ());
+}
+
+void
+ContextTracedCallbackTestCase::DoRun (void)
+{
+  TraceContext one = TraceContext::Intern ("/Context/One");
+  TraceContext two = TraceContext::Intern ("/Context/Two");
+  NS_TEST_ASSERT_MSG_EQ ((one != two), true, "Different contexts have the same id");
+  NS_TEST_ASSERT_MSG_EQ ((TraceContext::Intern ("/Context/One") == one), true,
+                         "Context interned twice");
+  NS_TEST_ASSERT_MSG_EQ (two.GetString (), "/Context/Two", "Wrong context string");
+  TraceContext found;
+  NS_TEST_ASSERT_MSG_EQ (TraceContext::Lookup ("/Context/Two", &found), true, "Context not found");
+  NS_TEST_ASSERT_MSG_EQ (found.GetId (), two.GetId (), "Wrong context found");
+  NS_TEST_ASSERT_MSG_EQ (TraceContext::Lookup ("/Context/None", &found), false,
+                         "Unknown context found");
+  std::ostringstream table;
+  TraceContext::Print (table);
+  std::ostringstream line;
+  line << two.GetId () << " /Context/Two\n";
+  NS_TEST_ASSERT_MSG_NE (table.str ().find (line.str ()), std::string::npos,
+                         "Context missing from the table");
+
+  // the sinks are called in order, each with its kind of context
+  TracedCallback<int> trace;
+  trace.Connect (MakeCallback (&ContextTracedCallbackTestCase::CbId, this), "/Context/One");
+  trace.ConnectWithoutContext (MakeCallback (&ContextTracedCallbackTestCase::CbPlain, this));
+  trace.Connect (MakeCallback (&ContextTracedCallbackTestCase::CbReference, this), "/Context/Two");
+  trace.Connect (MakeCallback (&ContextTracedCallbackTestCase::CbString, this), "/Context/One");
+  trace.Connect (MakeCallback (&ContextTracedCallbackTestCase::CbString, this), "/Context/Two");
+  trace (7);
+  NS_TEST_ASSERT_MSG_EQ (m_calls.size (), 5, "Wrong number of calls");
+  NS_TEST_ASSERT_MSG_EQ (m_calls[0], "id /Context/One 7", "Wrong call");
+  NS_TEST_ASSERT_MSG_EQ (m_calls[1], "plain 7", "Wrong call");
+  NS_TEST_ASSERT_MSG_EQ (m_calls[2], "reference /Context/Two 7", "Wrong call");
+  NS_TEST_ASSERT_MSG_EQ (m_calls[3], "string /Context/One 7", "Wrong call");
+  NS_TEST_ASSERT_MSG_EQ (m_calls[4], "string /Context/Two 7", "Wrong call");
+
+  // disconnect by callback and context
+  trace.Disconnect (MakeCallback (&ContextTracedCallbackTestCase::CbString, this), "/Context/One");
+  trace.Disconnect (MakeCallback (&ContextTracedCallbackTestCase::CbId, this), "/Context/Two");
+  trace.Disconnect (MakeCallback (&ContextTracedCallbackTestCase::CbId, this), "/Context/None");
+  trace.DisconnectWithoutContext (MakeCallback (&ContextTracedCallbackTestCase::CbId, this));
+  m_calls.clear ();
+  trace (8);
+  NS_TEST_ASSERT_MSG_EQ (m_calls.size (), 4, "Wrong number of calls after Disconnect");
+  NS_TEST_ASSERT_MSG_EQ (m_calls[0], "id /Context/One 8", "Wrong call");
+  NS_TEST_ASSERT_MSG_EQ (m_calls[3], "string /Context/Two 8", "Wrong call");
+  trace.DisconnectWithoutContext (MakeCallback (&ContextTracedCallbackTestCase::CbPlain, this));
+  trace.Disconnect (MakeCallback (&ContextTracedCallbackTestCase::CbId, this), "/Context/One");
+  m_calls.clear ();
+  trace (9);
+  NS_TEST_ASSERT_MSG_EQ (m_calls.size (), 2, "Wrong number of calls after Disconnect");
+  NS_TEST_ASSERT_MSG_EQ (m_calls[0], "reference /Context/Two 9", "Wrong call");
+}
+
 class TracedCallbackTestSuite : public TestSuite
 {
 public:
@@ -118,6 +231,7 @@ TracedCallbackTestSuite::TracedCallbackTestSuite ()
   : TestSuite ("traced-callback", UNIT)
 {
   AddTestCase (new BasicTracedCallbackTestCase, TestCase::QUICK);
+  AddTestCase (new ContextTracedCallbackTestCase, TestCase::QUICK);
 }
 
 static TracedCallbackTestSuite tracedCallbackTestSuite;
@@ -23,6 +23,10 @@
 #include <ctime>
 
 #include "ns3/type-id.h"
+#include "ns3/object-base.h"
+#include "ns3/traced-value.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/uinteger.h"
 #include "ns3/test.h"
 #include "ns3/log.h"
 
@@ -180,6 +184,13 @@ CollisionTestCase::DoRun (void)
                           "Second and lesser TypeId has HashChainFlag set");
   cout << suite << "collision: second,lesser not chained: OK" << endl;
 
+  // Check that name lookups resolve chained types
+  NS_TEST_ASSERT_MSG_EQ (TypeId::LookupByName (t1Name), t1, "Lookup of " << t1Name);
+  NS_TEST_ASSERT_MSG_EQ (TypeId::LookupByName (t2Name), t2, "Lookup of " << t2Name);
+  NS_TEST_ASSERT_MSG_EQ (TypeId::LookupByName (t3Name), t3, "Lookup of " << t3Name);
+  NS_TEST_ASSERT_MSG_EQ (TypeId::LookupByName (t4Name), t4, "Lookup of " << t4Name);
+  cout << suite << "collision: lookup by name:       OK" << endl;
+
   /** TODO Extra credit:  register three types whose hashes collide
    *
    *  None found in /usr/share/dict/web2
@@ -188,6 +199,88 @@ CollisionTestCase::DoRun (void)
 }
   
   
+//----------------------------
+//
+// Attribute and trace source lookup test
+
+class LookupAttributeTestCase : public TestCase
+{
+public:
+  LookupAttributeTestCase ();
+  virtual ~LookupAttributeTestCase ();
+private:
+  virtual void DoRun (void);
+
+  /** A holder for the attributes and trace sources registered by the test. */
+  class Holder : public ObjectBase
+  {
+  public:
+    virtual TypeId GetInstanceTypeId (void) const
+    {
+      return ObjectBase::GetTypeId ();
+    }
+    uint32_t m_value;
+    TracedValue<uint32_t> m_trace;
+  };
+};
+
+LookupAttributeTestCase::LookupAttributeTestCase ()
+  : TestCase ("Check attribute and trace source lookup through the parent chain")
+{
+}
+
+LookupAttributeTestCase::~LookupAttributeTestCase ()
+{
+}
+
+void
+LookupAttributeTestCase::DoRun (void)
+{
+  TypeId parent ("ns3::TypeIdTestParent");
+  parent.SetParent (ObjectBase::GetTypeId ());
+  TypeId child ("ns3::TypeIdTestChild");
+  child.SetParent (parent);
+
+  parent.AddAttribute ("ParentValue", "help", UintegerValue (1),
+                       MakeUintegerAccessor (&Holder::m_value),
+                       MakeUintegerChecker<uint32_t> ());
+  child.AddAttribute ("ChildValue", "help", UintegerValue (2),
+                      MakeUintegerAccessor (&Holder::m_value),
+                      MakeUintegerChecker<uint32_t> ());
+  parent.AddTraceSource ("ParentTrace", "help",
+                         MakeTraceSourceAccessor (&Holder::m_trace),
+                         "ns3::TracedValueCallback::Uint32");
+
+  struct TypeId::AttributeInformation info;
+  NS_TEST_ASSERT_MSG_EQ (child.LookupAttributeByName ("ChildValue", &info), true,
+                         "Own attribute not found");
+  NS_TEST_ASSERT_MSG_EQ (info.name, "ChildValue", "Wrong attribute found");
+  NS_TEST_ASSERT_MSG_EQ (child.LookupAttributeByName ("ParentValue", &info), true,
+                         "Inherited attribute not found");
+  NS_TEST_ASSERT_MSG_EQ (info.name, "ParentValue", "Wrong attribute found");
+  NS_TEST_ASSERT_MSG_EQ (parent.LookupAttributeByName ("ChildValue", &info), false,
+                         "Attribute of a derived type found");
+  NS_TEST_ASSERT_MSG_EQ (child.LookupAttributeByName ("Missing", &info), false,
+                         "Unknown attribute found");
+  NS_TEST_ASSERT_MSG_NE (child.LookupTraceSourceByName ("ParentTrace"), 0,
+                         "Inherited trace source not found");
+  NS_TEST_ASSERT_MSG_EQ (child.LookupTraceSourceByName ("Missing"), 0,
+                         "Unknown trace source found");
+
+  // Registering after a lookup must be visible to later lookups
+  parent.AddAttribute ("LateValue", "help", UintegerValue (3),
+                       MakeUintegerAccessor (&Holder::m_value),
+                       MakeUintegerChecker<uint32_t> ());
+  child.AddTraceSource ("LateTrace", "help",
+                        MakeTraceSourceAccessor (&Holder::m_trace),
+                        "ns3::TracedValueCallback::Uint32");
+  NS_TEST_ASSERT_MSG_EQ (child.LookupAttributeByName ("LateValue", &info), true,
+                         "Late inherited attribute not found");
+  NS_TEST_ASSERT_MSG_NE (child.LookupTraceSourceByName ("LateTrace"), 0,
+                         "Late trace source not found");
+}
+
+
 //----------------------------
 //
 // Performance test
@@ -298,6 +391,7 @@ TypeIdTestSuite::TypeIdTestSuite ()
   // as chained.
   AddTestCase (new UniqueTypeIdTestCase, QUICK);
   AddTestCase (new CollisionTestCase, QUICK);
+  AddTestCase (new LookupAttributeTestCase, QUICK);
 }
 
 static TypeIdTestSuite g_TypeIdTestSuite;  
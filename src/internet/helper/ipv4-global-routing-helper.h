@@ -82,6 +82,20 @@ public:
    *
    */
   static void RecomputeRoutingTables (void);
+  /**
+   * \brief Update the routes installed in a prior call to
+   * PopulateRoutingTables(), RecomputeRoutingTables() or
+   * UpdateRoutingTables() after a change of the topology.
+   *
+   * This gives the same routes as RecomputeRoutingTables(), but when the
+   * change is limited to some point-to-point links, such as a link going
+   * down or up, only the routers whose shortest paths may have changed
+   * run the SPF computation again; the others only have the routes to the
+   * addresses of the changed links replaced.
+   *
+   * \see GlobalRouteManager::UpdateGlobalRoutes
+   */
+  static void UpdateRoutingTables (void);
 private:
   /**
    * \brief Assignment operator declared private and not implemented to disallow
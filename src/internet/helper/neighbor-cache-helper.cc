@@ -0,0 +1,124 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <vector>
+
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/channel.h"
+#include "ns3/channel-list.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/ipv6-l3-protocol.h"
+#include "ns3/ipv6-interface.h"
+#include "ns3/arp-cache.h"
+#include "ns3/ndisc-cache.h"
+#include "neighbor-cache-helper.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("NeighborCacheHelper");
+
+NeighborCacheHelper::NeighborCacheHelper ()
+{
+}
+
+void
+NeighborCacheHelper::PopulateNeighborCache (void) const
+{
+  NS_LOG_FUNCTION (this);
+  for (ChannelList::Iterator i = ChannelList::Begin (); i != ChannelList::End (); ++i)
+    {
+      PopulateNeighborCache (*i);
+    }
+}
+
+void
+NeighborCacheHelper::PopulateNeighborCache (Ptr<Channel> channel) const
+{
+  NS_LOG_FUNCTION (this << channel);
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < channel->GetNDevices (); i++)
+    {
+      devices.Add (channel->GetDevice (i));
+    }
+  PopulateNeighborCache (devices);
+}
+
+void
+NeighborCacheHelper::PopulateNeighborCache (const NetDeviceContainer &devices) const
+{
+  NS_LOG_FUNCTION (this);
+  Ptr<ArpCache::StaticNeighbors> arpNeighbors = Create<ArpCache::StaticNeighbors> ();
+  Ptr<NdiscCache::StaticNeighbors> ndiscNeighbors = Create<NdiscCache::StaticNeighbors> ();
+  std::vector<Ptr<Ipv4Interface> > ipv4Interfaces;
+  std::vector<Ptr<Ipv6Interface> > ipv6Interfaces;
+
+  for (NetDeviceContainer::Iterator i = devices.Begin (); i != devices.End (); ++i)
+    {
+      Ptr<NetDevice> device = *i;
+      Ptr<Node> node = device->GetNode ();
+      if (node == 0)
+        {
+          continue;
+        }
+      Ptr<Ipv4L3Protocol> ipv4 = node->GetObject<Ipv4L3Protocol> ();
+      int32_t interface = ipv4 != 0 ? ipv4->GetInterfaceForDevice (device) : -1;
+      if (interface != -1)
+        {
+          Ptr<Ipv4Interface> ipv4Interface = ipv4->GetInterface (interface);
+          for (uint32_t j = 0; j < ipv4Interface->GetNAddresses (); j++)
+            {
+              arpNeighbors->Add (ipv4Interface->GetAddress (j).GetLocal (), device->GetAddress ());
+            }
+          ipv4Interfaces.push_back (ipv4Interface);
+        }
+      Ptr<Ipv6L3Protocol> ipv6 = node->GetObject<Ipv6L3Protocol> ();
+      interface = ipv6 != 0 ? ipv6->GetInterfaceForDevice (device) : -1;
+      if (interface != -1)
+        {
+          Ptr<Ipv6Interface> ipv6Interface = ipv6->GetInterface (interface);
+          for (uint32_t j = 0; j < ipv6Interface->GetNAddresses (); j++)
+            {
+              ndiscNeighbors->Add (ipv6Interface->GetAddress (j).GetAddress (), device->GetAddress ());
+            }
+          ipv6Interfaces.push_back (ipv6Interface);
+        }
+    }
+
+  NS_LOG_LOGIC (arpNeighbors->GetN () << " IPv4 and " << ndiscNeighbors->GetN () << " IPv6 neighbors");
+  for (std::vector<Ptr<Ipv4Interface> >::const_iterator i = ipv4Interfaces.begin ();
+       i != ipv4Interfaces.end (); ++i)
+    {
+      Ptr<ArpCache> cache = (*i)->GetArpCache ();
+      if (cache != 0)
+        {
+          cache->SetStaticNeighbors (arpNeighbors);
+        }
+    }
+  for (std::vector<Ptr<Ipv6Interface> >::const_iterator i = ipv6Interfaces.begin ();
+       i != ipv6Interfaces.end (); ++i)
+    {
+      Ptr<NdiscCache> cache = (*i)->GetNdiscCache ();
+      if (cache != 0)
+        {
+          cache->SetStaticNeighbors (ndiscNeighbors);
+        }
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,74 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef NEIGHBOR_CACHE_HELPER_H
+#define NEIGHBOR_CACHE_HELPER_H
+
+#include "ns3/ptr.h"
+#include "ns3/net-device-container.h"
+
+namespace ns3 {
+
+class Channel;
+
+/**
+ * \brief Resolve the neighbors of static topologies without ARP or
+ * Neighbor Discovery
+ *
+ * Once the addresses are assigned, the helper collects the IPv4 and IPv6
+ * addresses of every device of a link into a table shared by the ARP and
+ * NDisc caches of the link. The first packet to a neighbor in the table
+ * adds a PERMANENT entry to the cache of the sender, so that no request
+ * is broadcast and no timer is scheduled: large topologies forward from
+ * the start. The table takes memory in proportion to the number of hosts
+ * on the link, whatever the number of caches resolving through it.
+ *
+ * Addresses assigned after the helper runs are resolved the usual way,
+ * until the helper runs again. The helper does not make Duplicate Address
+ * Detection unnecessary; disable it with the "DAD" attribute of
+ * ns3::Icmpv6L4Protocol.
+ */
+class NeighborCacheHelper
+{
+public:
+  NeighborCacheHelper ();
+
+  /**
+   * \brief Populate the neighbor caches of all the channels
+   */
+  void PopulateNeighborCache (void) const;
+
+  /**
+   * \brief Populate the neighbor caches of the devices of a channel
+   * \param channel the channel
+   */
+  void PopulateNeighborCache (Ptr<Channel> channel) const;
+
+  /**
+   * \brief Populate the neighbor caches of some devices
+   *
+   * The devices resolve each other, whatever the channels they are
+   * attached to.
+   *
+   * \param devices the devices
+   */
+  void PopulateNeighborCache (const NetDeviceContainer &devices) const;
+};
+
+} // namespace ns3
+
+#endif /* NEIGHBOR_CACHE_HELPER_H */
@@ -102,6 +102,7 @@ ArpCache::DoDispose (void)
   Flush ();
   m_device = 0;
   m_interface = 0;
+  m_staticNeighbors = 0;
   if (!m_waitReplyTimer.IsRunning ())
     {
       Simulator::Remove (m_waitReplyTimer);
@@ -297,9 +298,18 @@ ArpCache::Entry *
 ArpCache::Lookup (Ipv4Address to)
 {
   NS_LOG_FUNCTION (this << to);
-  if (m_arpCache.find (to) != m_arpCache.end ()) 
+  CacheI i = m_arpCache.find (to);
+  if (i != m_arpCache.end ()) 
     {
-      ArpCache::Entry *entry = m_arpCache[to];
+      return i->second;
+    }
+  Address macAddress;
+  if (m_staticNeighbors != 0 && m_staticNeighbors->Lookup (to, macAddress))
+    {
+      NS_LOG_LOGIC ("Static neighbor " << to << " at " << macAddress);
+      ArpCache::Entry *entry = Add (to);
+      entry->SetMacAddresss (macAddress);
+      entry->MarkPermanent ();
       return entry;
     }
   return 0;
@@ -335,6 +345,43 @@ ArpCache::Remove (ArpCache::Entry *entry)
   NS_LOG_WARN ("Entry not found in this ARP Cache");
 }
 
+void
+ArpCache::SetStaticNeighbors (Ptr<StaticNeighbors> neighbors)
+{
+  NS_LOG_FUNCTION (this << neighbors);
+  m_staticNeighbors = neighbors;
+}
+
+Ptr<ArpCache::StaticNeighbors>
+ArpCache::GetStaticNeighbors (void) const
+{
+  return m_staticNeighbors;
+}
+
+void
+ArpCache::StaticNeighbors::Add (Ipv4Address ipv4Address, Address macAddress)
+{
+  m_neighbors[ipv4Address] = macAddress;
+}
+
+bool
+ArpCache::StaticNeighbors::Lookup (Ipv4Address ipv4Address, Address &macAddress) const
+{
+  Neighbors::const_iterator i = m_neighbors.find (ipv4Address);
+  if (i == m_neighbors.end ())
+    {
+      return false;
+    }
+  macAddress = i->second;
+  return true;
+}
+
+uint32_t
+ArpCache::StaticNeighbors::GetN (void) const
+{
+  return m_neighbors.size ();
+}
+
 ArpCache::Entry::Entry (ArpCache *arp)
   : m_arp (arp),
     m_state (ALIVE),
@@ -31,6 +31,7 @@
 #include "ns3/address.h"
 #include "ns3/ptr.h"
 #include "ns3/object.h"
+#include "ns3/simple-ref-count.h"
 #include "ns3/traced-callback.h"
 #include "ns3/sgi-hashmap.h"
 #include "ns3/output-stream-wrapper.h"
@@ -160,6 +161,54 @@ public:
    */
   void Flush (void);
 
+  /**
+   * \brief The addresses of a link that are resolved without ARP.
+   *
+   * A table is shared by the ARP caches of all the interfaces on a link,
+   * so that it takes memory in proportion to the number of hosts rather
+   * than to its square.
+   */
+  class StaticNeighbors : public SimpleRefCount<StaticNeighbors>
+  {
+public:
+    /**
+     * \brief Add or replace a neighbor
+     * \param ipv4Address the IPv4 address of the neighbor
+     * \param macAddress its MAC address
+     */
+    void Add (Ipv4Address ipv4Address, Address macAddress);
+    /**
+     * \brief Look a neighbor up
+     * \param ipv4Address the IPv4 address of the neighbor
+     * \param macAddress set to its MAC address, if found
+     * \return true if the neighbor is in the table
+     */
+    bool Lookup (Ipv4Address ipv4Address, Address &macAddress) const;
+    /**
+     * \return the number of neighbors in the table
+     */
+    uint32_t GetN (void) const;
+
+private:
+    /// Neighbors container
+    typedef sgi::hash_map<Ipv4Address, Address, Ipv4AddressHash> Neighbors;
+    Neighbors m_neighbors; //!< MAC addresses, by IPv4 address
+  };
+
+  /**
+   * \brief Set the static neighbors of the link of this cache
+   *
+   * A lookup that misses the cache but hits the table adds a PERMANENT
+   * entry to the cache, which needs no ARP exchange and runs no timer.
+   *
+   * \param neighbors the static neighbors, or 0 to use ARP only
+   */
+  void SetStaticNeighbors (Ptr<StaticNeighbors> neighbors);
+  /**
+   * \return the static neighbors of the link of this cache, if any
+   */
+  Ptr<StaticNeighbors> GetStaticNeighbors (void) const;
+
   /**
    * \brief Print the ARP cache entries
    *
@@ -323,6 +372,7 @@ private:
   void HandleWaitReplyTimeout (void);
   uint32_t m_pendingQueueSize; //!< number of packets waiting for a resolution
   Cache m_arpCache; //!< the ARP cache
+  Ptr<StaticNeighbors> m_staticNeighbors; //!< the static neighbors of the link
   TracedCallback<Ptr<const Packet> > m_dropTrace; //!< trace for packets dropped by the ARP cache queue
 };
 
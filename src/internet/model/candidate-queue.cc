@@ -51,22 +51,25 @@ operator<< (std::ostream& os, const CandidateQueue& q)
 {
   typedef CandidateQueue::CandidateList_t List_t;
   typedef List_t::const_iterator CIter_t;
-  const CandidateQueue::CandidateList_t& list = q.m_candidates;
+  List_t list = q.m_candidates;
+  std::sort (list.begin (), list.end (), &CandidateQueue::IsBefore);
 
   os << "*** CandidateQueue Begin (<id, distance, LSA-type>) ***" << std::endl;
   for (CIter_t iter = list.begin (); iter != list.end (); iter++)
     {
       os << "<" 
-      << (*iter)->GetVertexId () << ", "
-      << (*iter)->GetDistanceFromRoot () << ", "
-      << (*iter)->GetVertexType () << ">" << std::endl;
+      << iter->m_vertex->GetVertexId () << ", "
+      << iter->m_vertex->GetDistanceFromRoot () << ", "
+      << iter->m_vertex->GetVertexType () << ">" << std::endl;
     }
   os << "*** CandidateQueue End ***";
   return os;
 }
 
 CandidateQueue::CandidateQueue()
-  : m_candidates ()
+  : m_candidates (),
+    m_index (),
+    m_order (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -94,11 +97,13 @@ CandidateQueue::Push (SPFVertex *vNew)
 {
   NS_LOG_FUNCTION (this << vNew);
 
-  CandidateList_t::iterator i = std::upper_bound (
-      m_candidates.begin (), m_candidates.end (), vNew,
-      &CandidateQueue::CompareSPFVertex
-      );
-  m_candidates.insert (i, vNew);
+  Candidate c;
+  c.m_vertex = vNew;
+  c.m_order = m_order++;
+  m_candidates.push_back (c);
+  vNew->m_candidateIndex = m_candidates.size () - 1;
+  m_index.insert (std::make_pair (vNew->GetVertexId (), vNew));
+  SiftUp (m_candidates.size () - 1);
 }
 
 SPFVertex *
@@ -110,8 +115,25 @@ CandidateQueue::Pop (void)
       return 0;
     }
 
-  SPFVertex *v = m_candidates.front ();
-  m_candidates.pop_front ();
+  SPFVertex *v = m_candidates.front ().m_vertex;
+  Candidate last = m_candidates.back ();
+  m_candidates.pop_back ();
+  if (!m_candidates.empty ())
+    {
+      Place (0, last);
+      SiftDown (0);
+    }
+
+  std::pair<CandidateIndex_t::iterator, CandidateIndex_t::iterator> range =
+    m_index.equal_range (v->GetVertexId ());
+  for (CandidateIndex_t::iterator i = range.first; i != range.second; i++)
+    {
+      if (i->second == v)
+        {
+          m_index.erase (i);
+          break;
+        }
+    }
   return v;
 }
 
@@ -124,7 +146,7 @@ CandidateQueue::Top (void) const
       return 0;
     }
 
-  return m_candidates.front ();
+  return m_candidates.front ().m_vertex;
 }
 
 bool
@@ -145,18 +167,12 @@ SPFVertex *
 CandidateQueue::Find (const Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this);
-  CandidateList_t::const_iterator i = m_candidates.begin ();
-
-  for (; i != m_candidates.end (); i++)
+  CandidateIndex_t::const_iterator i = m_index.find (addr);
+  if (i == m_index.end ())
     {
-      SPFVertex *v = *i;
-      if (v->GetVertexId () == addr)
-        {
-          return v;
-        }
+      return 0;
     }
-
-  return 0;
+  return i->second;
 }
 
 void
@@ -164,11 +180,89 @@ CandidateQueue::Reorder (void)
 {
   NS_LOG_FUNCTION (this);
 
-  m_candidates.sort (&CandidateQueue::CompareSPFVertex);
+  for (uint32_t i = m_candidates.size () / 2; i > 0; i--)
+    {
+      SiftDown (i - 1);
+    }
   NS_LOG_LOGIC ("After reordering the CandidateQueue");
   NS_LOG_LOGIC (*this);
 }
 
+void
+CandidateQueue::Update (SPFVertex *v)
+{
+  NS_LOG_FUNCTION (this << v);
+
+  uint32_t index = v->m_candidateIndex;
+  NS_ASSERT (index < m_candidates.size () && m_candidates[index].m_vertex == v);
+  m_candidates[index].m_order = m_order++;
+  SiftUp (index);
+}
+
+void
+CandidateQueue::Place (uint32_t index, const Candidate &c)
+{
+  m_candidates[index] = c;
+  c.m_vertex->m_candidateIndex = index;
+}
+
+void
+CandidateQueue::SiftUp (uint32_t index)
+{
+  Candidate c = m_candidates[index];
+  while (index > 0)
+    {
+      uint32_t parent = (index - 1) / 2;
+      if (!IsBefore (c, m_candidates[parent]))
+        {
+          break;
+        }
+      Place (index, m_candidates[parent]);
+      index = parent;
+    }
+  Place (index, c);
+}
+
+void
+CandidateQueue::SiftDown (uint32_t index)
+{
+  uint32_t n = m_candidates.size ();
+  Candidate c = m_candidates[index];
+  for (;;)
+    {
+      uint32_t child = 2 * index + 1;
+      if (child >= n)
+        {
+          break;
+        }
+      if (child + 1 < n && IsBefore (m_candidates[child + 1], m_candidates[child]))
+        {
+          child++;
+        }
+      if (!IsBefore (m_candidates[child], c))
+        {
+          break;
+        }
+      Place (index, m_candidates[child]);
+      index = child;
+    }
+  Place (index, c);
+}
+
+bool
+CandidateQueue::IsBefore (const Candidate &a, const Candidate &b)
+{
+  if (CompareSPFVertex (a.m_vertex, b.m_vertex))
+    {
+      return true;
+    }
+  if (CompareSPFVertex (b.m_vertex, a.m_vertex))
+    {
+      return false;
+    }
+  return a.m_order < b.m_order;
+}
+
 /*
  * In this implementation, SPFVertex follows the ordering where
  * a vertex is ranked first if its GetDistanceFromRoot () is smaller;
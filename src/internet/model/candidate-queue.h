@@ -22,7 +22,8 @@
 #define CANDIDATE_QUEUE_H
 
 #include <stdint.h>
-#include <list>
+#include <map>
+#include <vector>
 #include "ns3/ipv4-address.h"
 
 namespace ns3 {
@@ -45,6 +46,13 @@ class SPFVertex;
  * for a Find () operation, the dynamic nature of the data and the derived
  * requirement for a Reorder () operation led us to implement this simple 
  * enhanced priority queue.
+ *
+ * The queue is an indexed binary heap: each vertex records its position in
+ * the heap, and vertices are indexed by vertex ID for Find ().  Push (),
+ * Pop () and Update () take logarithmic time.  Vertices at the same
+ * distance and of the same type leave the queue in the order they were
+ * pushed or last updated, as they did from the sorted list this class
+ * used to keep.
  */
 class CandidateQueue
 {
@@ -152,6 +160,18 @@ public:
  */
   void Reorder (void);
 
+/**
+ * @brief Restores the priority order after the distance of one vertex
+ * has decreased.
+ *
+ * The vertex is placed after the vertices that already have the same
+ * priority.
+ *
+ * @see SPFVertex
+ * @param v The Shortest Path First Vertex, which must be in the queue.
+ */
+  void Update (SPFVertex *v);
+
 private:
 /**
  * Candidate Queue copy construction is disallowed (not implemented) to 
@@ -182,8 +202,41 @@ private:
  */
   static bool CompareSPFVertex (const SPFVertex* v1, const SPFVertex* v2);
 
-  typedef std::list<SPFVertex*> CandidateList_t; //!< container of SPFVertex pointers
+  /// A vertex in the heap, with the sequence number breaking priority ties.
+  struct Candidate
+  {
+    SPFVertex *m_vertex; //!< The vertex
+    uint32_t m_order;    //!< Push or update sequence number
+  };
+
+  /**
+   * \param a first candidate
+   * \param b second candidate
+   * \return True if a should be popped before b
+   */
+  static bool IsBefore (const Candidate &a, const Candidate &b);
+  /**
+   * Move a candidate towards the top of the heap.
+   * \param index the candidate position
+   */
+  void SiftUp (uint32_t index);
+  /**
+   * Move a candidate towards the bottom of the heap.
+   * \param index the candidate position
+   */
+  void SiftDown (uint32_t index);
+  /**
+   * Store a candidate at a heap position.
+   * \param index the position
+   * \param c the candidate
+   */
+  void Place (uint32_t index, const Candidate &c);
+
+  typedef std::vector<Candidate> CandidateList_t; //!< heap of SPFVertex candidates
   CandidateList_t m_candidates;  //!< SPFVertex candidates
+  typedef std::multimap<Ipv4Address, SPFVertex*> CandidateIndex_t; //!< candidates by vertex ID
+  CandidateIndex_t m_index; //!< SPFVertex candidates by vertex ID
+  uint32_t m_order; //!< next sequence number
 
   /**
    * \brief Stream insertion operator.
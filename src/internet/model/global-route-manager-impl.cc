@@ -25,11 +25,22 @@
 #include <utility>
 #include <vector>
 #include <queue>
+#include <set>
+#include <limits>
+#include <iterator>
+#include <functional>
 #include <algorithm>
 #include <iostream>
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+# include "ns3/system-thread.h"
+# include "ns3/system-mutex.h"
+#endif
 #include "ns3/node-list.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
@@ -44,6 +55,15 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("GlobalRouteManagerImpl");
 
+/**
+ * \brief The number of threads running the SPF calculations.
+ */
+static GlobalValue g_globalRoutingThreads = GlobalValue ("GlobalRoutingThreads",
+                                                         "Number of threads computing the global routes "
+                                                         "(logging is not thread safe)",
+                                                         UintegerValue (1),
+                                                         MakeUintegerChecker<uint32_t> (1));
+
 /**
  * \brief Stream insertion operator.
  *
@@ -94,7 +114,8 @@ SPFVertex::SPFVertex () :
   m_nextHop ("0.0.0.0"),
   m_parents (),
   m_children (),
-  m_vertexProcessed (false)
+  m_vertexProcessed (false),
+  m_candidateIndex (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -107,7 +128,8 @@ SPFVertex::SPFVertex (GlobalRoutingLSA* lsa) :
   m_nextHop ("0.0.0.0"),
   m_parents (),
   m_children (),
-  m_vertexProcessed (false)
+  m_vertexProcessed (false),
+  m_candidateIndex (0)
 {
   NS_LOG_FUNCTION (this << lsa);
 
@@ -265,12 +287,17 @@ SPFVertex::MergeParent (const SPFVertex* v)
   NS_LOG_FUNCTION (this << v);
 
   NS_LOG_LOGIC ("Before merge, list of parents = " << m_parents);
-  // combine the two lists first, and then remove any duplicated after
-  m_parents.insert (m_parents.end (), 
-                    v->m_parents.begin (), v->m_parents.end ());
-  // remove duplication
-  m_parents.sort ();
-  m_parents.unique ();
+  // append the parents not yet in the list.  The list keeps the order the
+  // parents were found in, rather than their addresses, since the first
+  // parent of a network decides the next hops through it.
+  for (ListOfSPFVertex_t::const_iterator i = v->m_parents.begin ();
+       i != v->m_parents.end (); i++)
+    {
+      if (std::find (m_parents.begin (), m_parents.end (), *i) == m_parents.end ())
+        {
+          m_parents.push_back (*i);
+        }
+    }
   NS_LOG_LOGIC ("After merge, list of parents = " << m_parents);
 }
 
@@ -424,7 +451,8 @@ SPFVertex::ClearVertexProcessed (void)
 GlobalRouteManagerLSDB::GlobalRouteManagerLSDB ()
   :
     m_database (),
-    m_extdatabase ()
+    m_extdatabase (),
+    m_linkData ()
 {
   NS_LOG_FUNCTION (this);
 }
@@ -469,9 +497,31 @@ GlobalRouteManagerLSDB::Insert (Ipv4Address addr, GlobalRoutingLSA* lsa)
     {
       m_extdatabase.push_back (lsa);
     } 
-  else
+  else if (m_database.insert (LSDBPair_t (addr, lsa)).second)
     {
-      m_database.insert (LSDBPair_t (addr, lsa));
+//
+// Index the TransitNetwork link records.  When several LSAs have a record
+// with the same link data, the one with the lowest address is found, as
+// it would be by a walk of the database.
+//
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+          if (lr->GetLinkType () != GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              continue;
+            }
+          std::map<Ipv4Address, Ipv4Address>::iterator i = 
+            m_linkData.find (lr->GetLinkData ());
+          if (i == m_linkData.end ())
+            {
+              m_linkData.insert (std::make_pair (lr->GetLinkData (), addr));
+            }
+          else if (addr < i->second)
+            {
+              i->second = addr;
+            }
+        }
     }
 }
 
@@ -496,13 +546,10 @@ GlobalRouteManagerLSDB::GetLSA (Ipv4Address addr) const
 //
 // Look up an LSA by its address.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LSDBMap_t::const_iterator i = m_database.find (addr);
+  if (i != m_database.end ())
     {
-      if (i->first == addr)
-        {
-          return i->second;
-        }
+      return i->second;
     }
   return 0;
 }
@@ -512,26 +559,44 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this << addr);
 //
-// Look up an LSA by its address.
+// Look up an LSA by the link data of one of its TransitNetwork records.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  std::map<Ipv4Address, Ipv4Address>::const_iterator i = m_linkData.find (addr);
+  if (i != m_linkData.end ())
     {
-      GlobalRoutingLSA* temp = i->second;
-// Iterate among temp's Link Records
-      for (uint32_t j = 0; j < temp->GetNLinkRecords (); j++)
-        {
-          GlobalRoutingLinkRecord *lr = temp->GetLinkRecord (j);
-          if ( lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork &&
-               lr->GetLinkData () == addr)
-            {
-              return temp;
-            }
-        }
+      return GetLSA (i->second);
     }
   return 0;
 }
 
+void
+GlobalRouteManagerLSDB::GetLSAs (std::vector<GlobalRoutingLSA*> &lsas) const
+{
+  NS_LOG_FUNCTION (this);
+  lsas.clear ();
+  for (LSDBMap_t::const_iterator i = m_database.begin (); i != m_database.end (); i++)
+    {
+      lsas.push_back (i->second);
+    }
+}
+
+GlobalRouteManagerLSDB*
+GlobalRouteManagerLSDB::Copy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  GlobalRouteManagerLSDB *lsdb = new GlobalRouteManagerLSDB ();
+  for (LSDBMap_t::const_iterator i = m_database.begin (); i != m_database.end (); i++)
+    {
+      lsdb->Insert (i->first, new GlobalRoutingLSA (*i->second));
+    }
+  for (uint32_t j = 0; j < m_extdatabase.size (); j++)
+    {
+      lsdb->Insert (m_extdatabase[j]->GetLinkStateId (), 
+                    new GlobalRoutingLSA (*m_extdatabase[j]));
+    }
+  return lsdb;
+}
+
 // ---------------------------------------------------------------------------
 //
 // GlobalRouteManagerImpl Implementation
@@ -580,18 +645,8 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
           continue;
         }
       Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-      uint32_t j = 0;
-      uint32_t nRoutes = gr->GetNRoutes ();
       NS_LOG_LOGIC ("Deleting " << gr->GetNRoutes ()<< " routes from node " << node->GetId ());
-      // Each time we delete route 0, the route index shifts downward
-      // We can delete all routes if we delete the route numbered 0
-      // nRoutes times
-      for (j = 0; j < nRoutes; j++)
-        {
-          NS_LOG_LOGIC ("Deleting global route " << j << " from node " << node->GetId ());
-          gr->RemoveRoute (0);
-        }
-      NS_LOG_LOGIC ("Deleted " << j << " global routes from node "<< node->GetId ());
+      gr->RemoveAllRoutes ();
     }
   if (m_lsdb)
     {
@@ -614,6 +669,13 @@ void
 GlobalRouteManagerImpl::BuildGlobalRoutingDatabase () 
 {
   NS_LOG_FUNCTION (this);
+  BuildLSDB (m_lsdb);
+}
+
+void
+GlobalRouteManagerImpl::BuildLSDB (GlobalRouteManagerLSDB *lsdb)
+{
+  NS_LOG_FUNCTION (this << lsdb);
 //
 // Walk the list of nodes looking for the GlobalRouter Interface.  Nodes with
 // global router interfaces are, not too surprisingly, our routers.
@@ -655,7 +717,7 @@ GlobalRouteManagerImpl::BuildGlobalRoutingDatabase ()
 //
 // Write the newly discovered link state advertisement to the database.
 //
-          m_lsdb->Insert (lsa->GetLinkStateId (), lsa); 
+          lsdb->Insert (lsa->GetLinkStateId (), lsa); 
         }
     }
 }
@@ -695,12 +757,23 @@ GlobalRouteManagerImpl::BuildGlobalRoutingDatabase ()
 //
 void
 GlobalRouteManagerImpl::InitializeRoutes ()
+{
+  NS_LOG_FUNCTION (this);
+  NS_LOG_INFO ("About to start SPF calculation");
+  std::vector<SPFRoot> roots;
+  GetSPFRoots (roots);
+  SPFCalculateAll (roots);
+  NS_LOG_INFO ("Finished SPF calculation");
+}
+
+void
+GlobalRouteManagerImpl::GetSPFRoots (std::vector<SPFRoot> &roots) const
 {
   NS_LOG_FUNCTION (this);
 //
 // Walk the list of nodes in the system.
 //
-  NS_LOG_INFO ("About to start SPF calculation");
+  uint32_t systemId = MpiInterface::GetSystemId ();
   NodeList::Iterator listEnd = NodeList::End ();
   for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
     {
@@ -712,23 +785,794 @@ GlobalRouteManagerImpl::InitializeRoutes ()
       Ptr<GlobalRouter> rtr = 
         node->GetObject<GlobalRouter> ();
 
-      uint32_t systemId = MpiInterface::GetSystemId ();
       // Ignore nodes that are not assigned to our systemId (distributed sim)
       if (node->GetSystemId () != systemId) 
         {
           continue;
         }
-
+
+//
+// if the node has a global router interface, then run the global routing
+// algorithms.
+//
+      if (rtr && rtr->GetNumLSAs () )
+        {
+          SPFRoot root;
+          root.m_routerId = rtr->GetRouterId ();
+          root.m_ipv4 = node->GetObject<Ipv4> ();
+          NS_ASSERT_MSG (root.m_ipv4, 
+                         "GlobalRouteManagerImpl::GetSPFRoots (): "
+                         "GetObject for <Ipv4> interface failed");
+          root.m_routing = rtr->GetRoutingProtocol ();
+          roots.push_back (root);
+        }
+    }
+}
+
+#ifdef HAVE_PTHREAD_H
+/**
+ * \brief Runs the SPF calculations of routers taken from a shared list, on
+ * a private copy of the Link State Database.
+ */
+class GlobalRouteManagerImpl::SPFWorker
+{
+public:
+  /**
+   * \param lsdb the database to copy
+   * \param roots the routers to compute routes for
+   * \param next the index of the next router to take
+   * \param mutex the mutex protecting next
+   */
+  SPFWorker (const GlobalRouteManagerLSDB *lsdb,
+             const std::vector<SPFRoot> *roots,
+             uint32_t *next, SystemMutex *mutex)
+    : m_roots (roots),
+      m_next (next),
+      m_mutex (mutex)
+  {
+    m_impl.DebugUseLsdb (lsdb->Copy ());
+  }
+  /** Take routers until there are none left. */
+  void Run (void)
+  {
+    for (;;)
+      {
+        uint32_t i;
+        {
+          CriticalSection cs (*m_mutex);
+          i = (*m_next)++;
+        }
+        if (i >= m_roots->size ())
+          {
+            return;
+          }
+        m_impl.SPFCalculate ((*m_roots)[i]);
+      }
+  }
+private:
+  GlobalRouteManagerImpl m_impl; //!< the worker SPF state and LSDB
+  const std::vector<SPFRoot> *m_roots; //!< the routers
+  uint32_t *m_next; //!< the index of the next router
+  SystemMutex *m_mutex; //!< the mutex protecting m_next
+};
+#endif /* HAVE_PTHREAD_H */
+
+void
+GlobalRouteManagerImpl::SPFCalculateAll (const std::vector<SPFRoot> &roots)
+{
+  NS_LOG_FUNCTION (this << roots.size ());
+  UintegerValue value;
+  g_globalRoutingThreads.GetValue (value);
+  uint32_t nThreads = std::min<uint32_t> (value.Get (), roots.size ());
+#ifdef HAVE_PTHREAD_H
+  if (nThreads > 1)
+    {
+//
+// The calculations only read the LSDB, but they keep their state in its
+// LSAs, so each thread works on its own copy.  Each root is computed by one
+// thread, which writes only to the tables of the root node.
+//
+      NS_LOG_INFO ("Running SPF calculations on " << nThreads << " threads");
+      SystemMutex mutex;
+      uint32_t next = 0;
+      std::vector<SPFWorker *> workers;
+      std::vector<Ptr<SystemThread> > threads;
+      for (uint32_t i = 0; i < nThreads; i++)
+        {
+          SPFWorker *worker = new SPFWorker (m_lsdb, &roots, &next, &mutex);
+          workers.push_back (worker);
+          threads.push_back (Create<SystemThread> (MakeCallback (&SPFWorker::Run, worker)));
+        }
+      for (uint32_t i = 0; i < nThreads; i++)
+        {
+          threads[i]->Start ();
+        }
+      for (uint32_t i = 0; i < nThreads; i++)
+        {
+          threads[i]->Join ();
+          delete workers[i];
+        }
+      return;
+    }
+#endif /* HAVE_PTHREAD_H */
+  for (uint32_t i = 0; i < roots.size (); i++)
+    {
+      SPFCalculate (roots[i]);
+    }
+}
+
+//
+// Helpers of UpdateGlobalRoutes ().
+//
+
+/**
+ * \brief Compare two Global Router Link Records.
+ * \param a the first record
+ * \param b the second record
+ * \returns true if the records are the same
+ */
+static bool
+IsSameLinkRecord (const GlobalRoutingLinkRecord *a, const GlobalRoutingLinkRecord *b)
+{
+  return a->GetLinkType () == b->GetLinkType ()
+         && a->GetLinkId () == b->GetLinkId ()
+         && a->GetLinkData () == b->GetLinkData ()
+         && a->GetMetric () == b->GetMetric ();
+}
+
+/**
+ * \brief Compare two Link State Advertisements, ignoring their SPF status.
+ * \param a the first LSA
+ * \param b the second LSA
+ * \returns true if the advertisements are the same
+ */
+static bool
+IsSameLSA (const GlobalRoutingLSA *a, const GlobalRoutingLSA *b)
+{
+  if (a->GetLSType () != b->GetLSType ()
+      || a->GetLinkStateId () != b->GetLinkStateId ()
+      || a->GetAdvertisingRouter () != b->GetAdvertisingRouter ()
+      || a->GetNetworkLSANetworkMask () != b->GetNetworkLSANetworkMask ()
+      || a->GetNLinkRecords () != b->GetNLinkRecords ()
+      || a->GetNAttachedRouters () != b->GetNAttachedRouters ())
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < a->GetNLinkRecords (); i++)
+    {
+      if (!IsSameLinkRecord (a->GetLinkRecord (i), b->GetLinkRecord (i)))
+        {
+          return false;
+        }
+    }
+  for (uint32_t i = 0; i < a->GetNAttachedRouters (); i++)
+    {
+      if (a->GetAttachedRouter (i) != b->GetAttachedRouter (i))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+/**
+ * \brief Get the link records of one type of a router LSA.
+ * \param lsa the LSA
+ * \param type the link type
+ * \param records the records, in LSA order
+ */
+static void
+GetLinkRecords (const GlobalRoutingLSA *lsa, GlobalRoutingLinkRecord::LinkType type,
+                std::vector<GlobalRoutingLinkRecord *> &records)
+{
+  records.clear ();
+  for (uint32_t i = 0; i < lsa->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord *l = lsa->GetLinkRecord (i);
+      if (l->GetLinkType () == type)
+        {
+          records.push_back (l);
+        }
+    }
+}
+
+/**
+ * \brief Count the links of a router LSA to other routers and networks.
+ * \param lsa the LSA
+ * \returns the number of point-to-point and transit records
+ */
+static uint32_t
+GetNLinks (const GlobalRoutingLSA *lsa)
+{
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < lsa->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord::LinkType type = lsa->GetLinkRecord (i)->GetLinkType ();
+      if (type == GlobalRoutingLinkRecord::PointToPoint
+          || type == GlobalRoutingLinkRecord::TransitNetwork)
+        {
+          n++;
+        }
+    }
+  return n;
+}
+
+/**
+ * \brief Test whether the SPF calculation of a router stops in
+ * CheckForStubNode ().
+ * \param lsdb the Link State Database
+ * \param root the router ID
+ * \param neighbor set to the router at the other end of the single
+ * point-to-point link of the router, or to the router itself
+ * \returns true if the router is a stub
+ */
+static bool
+IsStubRouter (const GlobalRouteManagerLSDB *lsdb, Ipv4Address root, Ipv4Address &neighbor)
+{
+  GlobalRoutingLSA *rlsa = lsdb->GetLSA (root);
+  NS_ASSERT (rlsa);
+  neighbor = root;
+  int transits = 0;
+  GlobalRoutingLinkRecord *transitLink = 0;
+  for (uint32_t i = 0; i < rlsa->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord *l = rlsa->GetLinkRecord (i);
+      if (l->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork
+          || l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint)
+        {
+          transits++;
+          transitLink = l;
+        }
+    }
+  if (transits == 0)
+    {
+      return true;
+    }
+  if (transits > 1 || transitLink->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
+    {
+      return false;
+    }
+  neighbor = transitLink->GetLinkId ();
+  GlobalRoutingLSA *w_lsa = lsdb->GetLSA (neighbor);
+  if (w_lsa == 0)
+    {
+      return false;
+    }
+  for (uint32_t j = 0; j < w_lsa->GetNLinkRecords (); ++j)
+    {
+      GlobalRoutingLinkRecord *lr = w_lsa->GetLinkRecord (j);
+      if (lr->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint
+          && lr->GetLinkId () == root)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+/// Links of the SPF graph, reversed: for each vertex, the vertices having a
+/// link to it, and the cost of the link.
+typedef std::vector<std::vector<std::pair<uint32_t, uint32_t> > > ReverseGraph_t;
+
+/// Distance of the vertices without a path.
+static const uint64_t SPF_UNREACHABLE = std::numeric_limits<uint64_t>::max ();
+
+/**
+ * \brief Compute the distances from every vertex of the SPF graph to one
+ * vertex, with a Dijkstra calculation on the reversed links.
+ * \param graph the reversed graph
+ * \param target the vertex
+ * \param distances the distance of each vertex, or SPF_UNREACHABLE
+ */
+static void
+GetDistancesTo (const ReverseGraph_t &graph, uint32_t target, std::vector<uint64_t> &distances)
+{
+  typedef std::pair<uint64_t, uint32_t> Item;
+  std::priority_queue<Item, std::vector<Item>, std::greater<Item> > queue;
+  distances.assign (graph.size (), SPF_UNREACHABLE);
+  distances[target] = 0;
+  queue.push (Item (0, target));
+  while (!queue.empty ())
+    {
+      Item item = queue.top ();
+      queue.pop ();
+      if (item.first != distances[item.second])
+        {
+          continue;
+        }
+      const std::vector<std::pair<uint32_t, uint32_t> > &links = graph[item.second];
+      for (uint32_t i = 0; i < links.size (); i++)
+        {
+          uint64_t distance = item.first + links[i].second;
+          if (distance < distances[links[i].first])
+            {
+              distances[links[i].first] = distance;
+              queue.push (Item (distance, links[i].first));
+            }
+        }
+    }
+}
+
+/// A point-to-point link of the SPF graph that was added or removed.
+struct SPFLinkChange
+{
+  uint32_t m_from; //!< the vertex advertising the link
+  uint32_t m_to; //!< the vertex at the other end
+  uint32_t m_cost; //!< the link cost
+  bool m_added; //!< true if the link was added, false if removed
+  bool m_leaf; //!< true if the link is the only link of one of its ends
+};
+
+/// The changes of the point-to-point and stub records of a router LSA that
+/// show in the routes to the router.
+struct SPFRouterChange
+{
+  std::vector<Ipv4Address> m_removedHosts; //!< addresses no longer advertised
+  std::vector<Ipv4Address> m_addedHosts; //!< addresses newly advertised
+  std::vector<std::pair<uint32_t, uint32_t> > m_removedStubs; //!< stub networks and masks no longer advertised
+  std::vector<std::pair<uint32_t, uint32_t> > m_addedStubs; //!< stub networks and masks newly advertised
+  std::vector<Ipv4Address> m_keptHosts; //!< addresses still advertised
+  std::vector<std::pair<uint32_t, uint32_t> > m_keptStubs; //!< stub networks and masks still advertised
+  Ipv4Address m_exitHost; //!< an address whose old routes have the exits to the router
+  bool m_hasExitHost; //!< true if m_exitHost is set
+};
+
+/**
+ * \brief Compare the point-to-point and stub records of a router LSA.
+ * \param o the old LSA
+ * \param n the new LSA
+ * \param change the address and stub network changes
+ * \param removed the removed links, as neighbor and cost
+ * \param added the added links, as neighbor and cost
+ */
+static void
+GetRouterChange (const GlobalRoutingLSA *o, const GlobalRoutingLSA *n,
+                 SPFRouterChange &change,
+                 std::vector<std::pair<Ipv4Address, uint16_t> > &removed,
+                 std::vector<std::pair<Ipv4Address, uint16_t> > &added)
+{
+  const GlobalRoutingLSA *lsas[2] = { o, n };
+  std::vector<Ipv4Address> hosts[2];
+  std::vector<std::pair<uint32_t, uint32_t> > stubs[2];
+  std::vector<std::pair<Ipv4Address, uint16_t> > links[2];
+  std::vector<GlobalRoutingLinkRecord *> records;
+  for (uint32_t k = 0; k < 2; k++)
+    {
+      GetLinkRecords (lsas[k], GlobalRoutingLinkRecord::PointToPoint, records);
+      for (uint32_t i = 0; i < records.size (); i++)
+        {
+          hosts[k].push_back (records[i]->GetLinkData ());
+          links[k].push_back (std::make_pair (records[i]->GetLinkId (), records[i]->GetMetric ()));
+        }
+      GetLinkRecords (lsas[k], GlobalRoutingLinkRecord::StubNetwork, records);
+      for (uint32_t i = 0; i < records.size (); i++)
+        {
+          Ipv4Mask mask (records[i]->GetLinkData ().Get ());
+          Ipv4Address network = records[i]->GetLinkId ().CombineMask (mask);
+          stubs[k].push_back (std::make_pair (network.Get (), mask.Get ()));
+        }
+      std::sort (hosts[k].begin (), hosts[k].end ());
+      std::sort (stubs[k].begin (), stubs[k].end ());
+      std::sort (links[k].begin (), links[k].end ());
+    }
+  std::set_difference (hosts[0].begin (), hosts[0].end (), hosts[1].begin (), hosts[1].end (),
+                       std::back_inserter (change.m_removedHosts));
+  std::set_difference (hosts[1].begin (), hosts[1].end (), hosts[0].begin (), hosts[0].end (),
+                       std::back_inserter (change.m_addedHosts));
+  std::set_intersection (hosts[0].begin (), hosts[0].end (), hosts[1].begin (), hosts[1].end (),
+                         std::back_inserter (change.m_keptHosts));
+  std::set_difference (stubs[0].begin (), stubs[0].end (), stubs[1].begin (), stubs[1].end (),
+                       std::back_inserter (change.m_removedStubs));
+  std::set_difference (stubs[1].begin (), stubs[1].end (), stubs[0].begin (), stubs[0].end (),
+                       std::back_inserter (change.m_addedStubs));
+  std::set_intersection (stubs[0].begin (), stubs[0].end (), stubs[1].begin (), stubs[1].end (),
+                         std::back_inserter (change.m_keptStubs));
+  std::set_difference (links[0].begin (), links[0].end (), links[1].begin (), links[1].end (),
+                       std::back_inserter (removed));
+  std::set_difference (links[1].begin (), links[1].end (), links[0].begin (), links[0].end (),
+                       std::back_inserter (added));
+}
+
+void
+GlobalRouteManagerImpl::UpdateGlobalRoutes ()
+{
+  NS_LOG_FUNCTION (this);
+  GlobalRouteManagerLSDB *lsdb = new GlobalRouteManagerLSDB ();
+  BuildLSDB (lsdb);
+  std::vector<SPFRoot> roots;
+  GetSPFRoots (roots);
+
+  std::vector<SPFRoot> recompute;
+  std::vector<RoutePatch> patches;
+  if (!PlanUpdate (lsdb, roots, recompute, patches))
+    {
+      NS_LOG_INFO ("Recomputing all routes");
+      DeleteGlobalRoutes ();
+      DebugUseLsdb (lsdb);
+      InitializeRoutes ();
+      return;
+    }
+  NS_LOG_INFO ("Recomputing the routes of " << recompute.size () << 
+               " routers, patching " << patches.size () << " routers");
+
+  for (uint32_t i = 0; i < patches.size (); i++)
+    {
+      RoutePatch &patch = patches[i];
+      patch.m_routing->RemoveRoutes (patch.m_removed);
+      for (uint32_t j = 0; j < patch.m_hostRoutes.size (); j++)
+        {
+          const Ipv4RoutingTableEntry &route = patch.m_hostRoutes[j];
+          patch.m_routing->AddHostRouteTo (route.GetDest (), route.GetGateway (),
+                                           route.GetInterface ());
+        }
+      for (uint32_t j = 0; j < patch.m_networkRoutes.size (); j++)
+        {
+          const Ipv4RoutingTableEntry &route = patch.m_networkRoutes[j];
+          patch.m_routing->AddNetworkRouteTo (route.GetDestNetwork (), route.GetDestNetworkMask (),
+                                              route.GetGateway (), route.GetInterface ());
+        }
+    }
+  for (uint32_t i = 0; i < recompute.size (); i++)
+    {
+      recompute[i].m_routing->RemoveAllRoutes ();
+    }
+  DebugUseLsdb (lsdb);
+  SPFCalculateAll (recompute);
+}
+
+bool
+GlobalRouteManagerImpl::PlanUpdate (GlobalRouteManagerLSDB *lsdb,
+                                    const std::vector<SPFRoot> &roots,
+                                    std::vector<SPFRoot> &recompute,
+                                    std::vector<RoutePatch> &patches) const
+{
+  NS_LOG_FUNCTION (this << lsdb);
+//
+// Find the routers whose LSAs changed.  Anything but a change of the point-
+// to-point and stub records of router LSAs needs a full recomputation.
+//
+  std::vector<GlobalRoutingLSA*> oldLsas;
+  std::vector<GlobalRoutingLSA*> newLsas;
+  m_lsdb->GetLSAs (oldLsas);
+  lsdb->GetLSAs (newLsas);
+  if (oldLsas.empty () || oldLsas.size () != newLsas.size ()
+      || m_lsdb->GetNumExtLSAs () != lsdb->GetNumExtLSAs ())
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < m_lsdb->GetNumExtLSAs (); i++)
+    {
+      if (!IsSameLSA (m_lsdb->GetExtLSA (i), lsdb->GetExtLSA (i)))
+        {
+          return false;
+        }
+    }
+
+  std::map<Ipv4Address, uint32_t> index;
+  std::vector<uint32_t> changed;
+  std::vector<GlobalRoutingLinkRecord *> oldTransits;
+  std::vector<GlobalRoutingLinkRecord *> newTransits;
+  for (uint32_t i = 0; i < oldLsas.size (); i++)
+    {
+      GlobalRoutingLSA *o = oldLsas[i];
+      GlobalRoutingLSA *n = newLsas[i];
+      if (o->GetLinkStateId () != n->GetLinkStateId ())
+        {
+          return false;
+        }
+      index[o->GetLinkStateId ()] = i;
+      if (IsSameLSA (o, n))
+        {
+          continue;
+        }
+      if (o->GetLSType () != GlobalRoutingLSA::RouterLSA
+          || n->GetLSType () != GlobalRoutingLSA::RouterLSA)
+        {
+          return false;
+        }
+      GetLinkRecords (o, GlobalRoutingLinkRecord::TransitNetwork, oldTransits);
+      GetLinkRecords (n, GlobalRoutingLinkRecord::TransitNetwork, newTransits);
+      if (oldTransits.size () != newTransits.size ())
+        {
+          return false;
+        }
+      for (uint32_t j = 0; j < oldTransits.size (); j++)
+        {
+          if (!IsSameLinkRecord (oldTransits[j], newTransits[j]))
+            {
+              return false;
+            }
+        }
+      changed.push_back (i);
+    }
+  if (changed.empty ())
+    {
+      return true;
+    }
+
+//
+// Collect the changes of the routers, and the routers next to them.
+//
+// A router going from no link to a single link, or back, is a leaf: no
+// shortest path goes through it, and the exits to it are the exits to its
+// neighbor.
+//
+  std::set<uint32_t> leaves;
+  for (uint32_t i = 0; i < changed.size (); i++)
+    {
+      if (GetNLinks (oldLsas[changed[i]]) + GetNLinks (newLsas[changed[i]]) == 1)
+        {
+          leaves.insert (changed[i]);
+        }
+    }
+  std::vector<SPFRouterChange> changes (changed.size ());
+  std::vector<SPFLinkChange> links;
+  std::set<Ipv4Address> changedIds;
+  std::set<Ipv4Address> neighbors;
+  for (uint32_t i = 0; i < changed.size (); i++)
+    {
+      std::vector<std::pair<Ipv4Address, uint16_t> > removed;
+      std::vector<std::pair<Ipv4Address, uint16_t> > added;
+      SPFRouterChange &change = changes[i];
+      GetRouterChange (oldLsas[changed[i]], newLsas[changed[i]], change, removed, added);
+      changedIds.insert (oldLsas[changed[i]]->GetLinkStateId ());
+      if (leaves.count (changed[i]) && !removed.empty ())
+        {
+          // The router is no longer reachable: remove all its routes.
+          change.m_removedHosts.insert (change.m_removedHosts.end (),
+                                        change.m_keptHosts.begin (), change.m_keptHosts.end ());
+          change.m_removedStubs.insert (change.m_removedStubs.end (),
+                                        change.m_keptStubs.begin (), change.m_keptStubs.end ());
+          change.m_addedHosts.clear ();
+          change.m_addedStubs.clear ();
+          change.m_hasExitHost = !change.m_removedHosts.empty ();
+          if (change.m_hasExitHost)
+            {
+              change.m_exitHost = change.m_removedHosts.front ();
+            }
+        }
+      else if (leaves.count (changed[i]) && !added.empty ())
+        {
+          // The router was not reachable: add all its routes, if the
+          // neighbor links back to it.
+          std::map<Ipv4Address, uint32_t>::const_iterator to = index.find (added.front ().first);
+          if (to == index.end ())
+            {
+              return false;
+            }
+          change.m_addedHosts.insert (change.m_addedHosts.end (),
+                                      change.m_keptHosts.begin (), change.m_keptHosts.end ());
+          change.m_addedStubs.insert (change.m_addedStubs.end (),
+                                      change.m_keptStubs.begin (), change.m_keptStubs.end ());
+          change.m_removedHosts.clear ();
+          change.m_removedStubs.clear ();
+          std::vector<GlobalRoutingLinkRecord *> records;
+          GetLinkRecords (newLsas[to->second], GlobalRoutingLinkRecord::PointToPoint, records);
+          bool linked = false;
+          for (uint32_t j = 0; j < records.size (); j++)
+            {
+              linked = linked || records[j]->GetLinkId () == oldLsas[changed[i]]->GetLinkStateId ();
+            }
+          if (!linked)
+            {
+              change.m_addedHosts.clear ();
+              change.m_addedStubs.clear ();
+            }
+          SPFRouterChange neighbor;
+          std::vector<std::pair<Ipv4Address, uint16_t> > unused;
+          GetRouterChange (oldLsas[to->second], newLsas[to->second], neighbor, unused, unused);
+          change.m_hasExitHost = !neighbor.m_keptHosts.empty ();
+          if (change.m_hasExitHost)
+            {
+              change.m_exitHost = neighbor.m_keptHosts.front ();
+            }
+        }
+      else
+        {
+          change.m_hasExitHost = !change.m_keptHosts.empty ();
+          if (change.m_hasExitHost)
+            {
+              change.m_exitHost = change.m_keptHosts.front ();
+            }
+        }
+      for (uint32_t k = 0; k < 2; k++)
+        {
+          std::vector<std::pair<Ipv4Address, uint16_t> > &list = k == 0 ? removed : added;
+          for (uint32_t j = 0; j < list.size (); j++)
+            {
+              std::map<Ipv4Address, uint32_t>::const_iterator to = index.find (list[j].first);
+              if (to == index.end ())
+                {
+                  return false;
+                }
+              SPFLinkChange link;
+              link.m_from = changed[i];
+              link.m_to = to->second;
+              link.m_cost = list[j].second;
+              link.m_added = k == 1;
+              link.m_leaf = leaves.count (link.m_from) || leaves.count (link.m_to);
+              links.push_back (link);
+            }
+        }
+      std::vector<GlobalRoutingLinkRecord *> records;
+      for (uint32_t k = 0; k < 2; k++)
+        {
+          GetLinkRecords (k == 0 ? oldLsas[changed[i]] : newLsas[changed[i]],
+                          GlobalRoutingLinkRecord::PointToPoint, records);
+          for (uint32_t j = 0; j < records.size (); j++)
+            {
+              neighbors.insert (records[j]->GetLinkId ());
+            }
+        }
+    }
+
+//
+// A router has a new shortest path tree if one of the links removed was on
+// a shortest path, or if a link added makes a path as short as the shortest
+// one.  This is found with the distances, in the old graph, from each router
+// to the ends of the links.
+//
+  ReverseGraph_t graph (oldLsas.size ());
+  for (uint32_t i = 0; i < oldLsas.size (); i++)
+    {
+      GlobalRoutingLSA *lsa = oldLsas[i];
+      if (lsa->GetLSType () == GlobalRoutingLSA::RouterLSA)
+        {
+          for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+            {
+              GlobalRoutingLinkRecord *l = lsa->GetLinkRecord (j);
+              if (l->GetLinkType () == GlobalRoutingLinkRecord::StubNetwork)
+                {
+                  continue;
+                }
+              std::map<Ipv4Address, uint32_t>::const_iterator w = index.find (l->GetLinkId ());
+              if (w != index.end ())
+                {
+                  graph[w->second].push_back (std::make_pair (i, l->GetMetric ()));
+                }
+            }
+        }
+      else if (lsa->GetLSType () == GlobalRoutingLSA::NetworkLSA)
+        {
+          for (uint32_t j = 0; j < lsa->GetNAttachedRouters (); j++)
+            {
+              GlobalRoutingLSA *w_lsa = m_lsdb->GetLSAByLinkData (lsa->GetAttachedRouter (j));
+              if (w_lsa != 0)
+                {
+                  graph[index[w_lsa->GetLinkStateId ()]].push_back (std::make_pair (i, 0));
+                }
+            }
+        }
+    }
+  std::map<uint32_t, std::vector<uint64_t> > distances;
+  for (uint32_t i = 0; i < links.size (); i++)
+    {
+      if (links[i].m_leaf)
+        {
+          continue;
+        }
+      uint32_t ends[2] = { links[i].m_from, links[i].m_to };
+      for (uint32_t k = 0; k < 2; k++)
+        {
+          if (distances.find (ends[k]) == distances.end ())
+            {
+              GetDistancesTo (graph, ends[k], distances[ends[k]]);
+            }
+        }
+    }
+
+  for (uint32_t r = 0; r < roots.size (); r++)
+    {
+      const SPFRoot &root = roots[r];
+      Ipv4Address id = root.m_routerId;
+      std::map<Ipv4Address, uint32_t>::const_iterator ri = index.find (id);
+      if (ri == index.end ())
+        {
+          return false;
+        }
+//
+// The routes of a stub router only depend on its link to its neighbor.
+//
+      Ipv4Address oldNeighbor;
+      Ipv4Address newNeighbor;
+      bool oldStub = IsStubRouter (m_lsdb, id, oldNeighbor);
+      bool newStub = IsStubRouter (lsdb, id, newNeighbor);
+      if (oldStub || newStub)
+        {
+          if (!oldStub || !newStub || changedIds.count (id)
+              || changedIds.count (oldNeighbor) || changedIds.count (newNeighbor))
+            {
+              recompute.push_back (root);
+            }
+          continue;
+        }
 //
-// if the node has a global router interface, then run the global routing
-// algorithms.
+// The next hops of a router come from the LSAs of its neighbors.
 //
-      if (rtr && rtr->GetNumLSAs () )
+      bool full = changedIds.count (id) || neighbors.count (id);
+      std::vector<GlobalRoutingLinkRecord *> records;
+      GetLinkRecords (oldLsas[ri->second], GlobalRoutingLinkRecord::PointToPoint, records);
+      for (uint32_t j = 0; !full && j < records.size (); j++)
+        {
+          full = changedIds.count (records[j]->GetLinkId ());
+        }
+      for (uint32_t j = 0; !full && j < links.size (); j++)
+        {
+          if (links[j].m_leaf)
+            {
+              continue;
+            }
+          uint64_t from = distances[links[j].m_from][ri->second];
+          uint64_t to = distances[links[j].m_to][ri->second];
+          if (from == SPF_UNREACHABLE)
+            {
+              continue;
+            }
+          full = links[j].m_added ? from + links[j].m_cost <= to : from + links[j].m_cost == to;
+        }
+//
+// Otherwise, the routes to the addresses and stub networks of a changed
+// router use the exits of the routes to its other addresses, or to the
+// neighbor of a leaf.
+//
+      RoutePatch patch;
+      patch.m_routing = root.m_routing;
+      for (uint32_t i = 0; !full && i < changes.size (); i++)
+        {
+          const SPFRouterChange &change = changes[i];
+          if (change.m_removedHosts.empty () && change.m_addedHosts.empty ()
+              && change.m_removedStubs.empty () && change.m_addedStubs.empty ())
+            {
+              continue;
+            }
+          if (!change.m_hasExitHost)
+            {
+              full = true;
+              break;
+            }
+          std::vector<Ipv4RoutingTableEntry> exits;
+          root.m_routing->GetHostRoutesTo (change.m_exitHost, exits);
+          for (uint32_t j = 0; j < exits.size (); j++)
+            {
+              Ipv4Address nextHop = exits[j].GetGateway ();
+              uint32_t outIf = exits[j].GetInterface ();
+              for (uint32_t k = 0; k < change.m_removedHosts.size (); k++)
+                {
+                  patch.m_removed.push_back (Ipv4RoutingTableEntry::CreateHostRouteTo (
+                                               change.m_removedHosts[k], nextHop, outIf));
+                }
+              for (uint32_t k = 0; k < change.m_removedStubs.size (); k++)
+                {
+                  patch.m_removed.push_back (Ipv4RoutingTableEntry::CreateNetworkRouteTo (
+                                               Ipv4Address (change.m_removedStubs[k].first),
+                                               Ipv4Mask (change.m_removedStubs[k].second),
+                                               nextHop, outIf));
+                }
+              for (uint32_t k = 0; k < change.m_addedHosts.size (); k++)
+                {
+                  patch.m_hostRoutes.push_back (Ipv4RoutingTableEntry::CreateHostRouteTo (
+                                                  change.m_addedHosts[k], nextHop, outIf));
+                }
+              for (uint32_t k = 0; k < change.m_addedStubs.size (); k++)
+                {
+                  patch.m_networkRoutes.push_back (Ipv4RoutingTableEntry::CreateNetworkRouteTo (
+                                                     Ipv4Address (change.m_addedStubs[k].first),
+                                                     Ipv4Mask (change.m_addedStubs[k].second),
+                                                     nextHop, outIf));
+                }
+            }
+        }
+      if (full)
+        {
+          recompute.push_back (root);
+        }
+      else if (!patch.m_removed.empty () || !patch.m_hostRoutes.empty ()
+               || !patch.m_networkRoutes.empty ())
         {
-          SPFCalculate (rtr->GetRouterId ());
+          patches.push_back (patch);
         }
     }
-  NS_LOG_INFO ("Finished SPF calculation");
+  return true;
 }
 
 //
@@ -961,7 +1805,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 // If we've changed the cost to get to the vertex represented by <w>, we 
 // must reorder the priority queue keyed to that cost.
 //
-                  candidate.Reorder ();
+                  candidate.Update (cw);
                 }
             } // new lower cost path found
         } // end W is already on the candidate list
@@ -1321,9 +2165,7 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
               if (lr->GetLinkId () == myRouterId)
                 {
                   // Next hop is stored in the LinkID field of lr
-                  Ptr<GlobalRouter> router = rlsa->GetNode ()->GetObject<GlobalRouter> ();
-                  NS_ASSERT (router);
-                  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+                  Ptr<Ipv4GlobalRouting> gr = m_spfrootRouting;
                   NS_ASSERT (gr);
                   gr->AddNetworkRouteTo (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"), lr->GetLinkData (), 
                                          FindOutgoingInterfaceId (transitLink->GetLinkData ()));
@@ -1338,14 +2180,44 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
   return false;
 }
 
-// quagga ospf_spf_calculate
 void
 GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 {
   NS_LOG_FUNCTION (this << root);
+//
+// Walk the list of nodes looking for the one that has the router ID of the
+// root.  This is the one we're going to write the routing information to.
+//
+  SPFRoot spfRoot;
+  spfRoot.m_routerId = root;
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<GlobalRouter> rtr = (*i)->GetObject<GlobalRouter> ();
+      if (rtr != 0 && rtr->GetRouterId () == root)
+        {
+          spfRoot.m_ipv4 = (*i)->GetObject<Ipv4> ();
+          spfRoot.m_routing = rtr->GetRoutingProtocol ();
+          break;
+        }
+    }
+  SPFCalculate (spfRoot);
+}
+
+// quagga ospf_spf_calculate
+void
+GlobalRouteManagerImpl::SPFCalculate (const SPFRoot &spfRoot)
+{
+  Ipv4Address root = spfRoot.m_routerId;
+  NS_LOG_FUNCTION (this << root);
 
   SPFVertex *v;
 //
+// Remember the objects of the root node, to which the routes are written.
+//
+  m_spfrootIpv4 = spfRoot.m_ipv4;
+  m_spfrootRouting = spfRoot.m_routing;
+//
 // Initialize the Link State Database.
 //
   m_lsdb->Initialize ();
@@ -1378,10 +2250,13 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // reached.  Instead, short-circuit this computation and just install
 // a default route in the CheckForStubNode() method.
 //
-  if (NodeList::GetNNodes () > 0 && CheckForStubNode (root))
+  if (m_spfrootRouting != 0 && CheckForStubNode (root))
     {
       NS_LOG_LOGIC ("SPFCalculate truncated for stub node " << root);
       delete m_spfroot;
+      m_spfroot = 0;
+      m_spfrootIpv4 = 0;
+      m_spfrootRouting = 0;
       return;
     }
 
@@ -1503,6 +2378,8 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 //
   delete m_spfroot;
   m_spfroot = 0;
+  m_spfrootIpv4 = 0;
+  m_spfrootRouting = 0;
 }
 
 void
@@ -1561,105 +2438,50 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The routing information is written to the router at the root of the SPF
+// tree, found when the calculation started.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Ipv4GlobalRouting> gr = m_spfrootRouting;
+  if (gr == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("No node for router " << routerId);
+      return;
+    }
 //
 // Get the Global Router Link State Advertisement from the vertex we're
-// adding the routes to.  The LSA will have a number of attached Global Router
-// Link Records corresponding to links off of that vertex / node.  We're going
-// to be interested in the records corresponding to point-to-point links.
+// adding the routes to.
 //
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = extlsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
-
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFAddASExternal (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = extlsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
 //
-// Here's why we did all of that work.  We're going to add a host route to the
-// host address found in the m_linkData field of the point-to-point link
-// record.  In the case of a point-to-point link, this is the local IP address
-// of the node connected to the link.  Each of these point-to-point links
-// will correspond to a local interface that has an IP address to which
-// the node at the root of the SPF tree can send packets.  The vertex <v> 
-// (corresponding to the node that has these links and interfaces) has 
-// an m_nextHop address precalculated for us that is the address to which the
-// root node should send packets to be forwarded to these IP addresses.
-// Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
-// which the packets should be send for forwarding.
+// Add a route to the external network through each of the exits the root
+// uses to reach the advertising router <v>.
 //
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add external network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
+        {
+          gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                        " add external network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 
@@ -1730,107 +2552,46 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The routing information is written to the router at the root of the SPF
+// tree, found when the calculation started.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Ipv4GlobalRouting> gr = m_spfrootRouting;
+  if (gr == 0)
     {
-      Ptr<Node> node = *i;
+      NS_LOG_LOGIC ("No node for router " << routerId);
+      return;
+    }
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFIntraAddStub (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask (l->GetLinkData ().Get ());
+  Ipv4Address tempip = l->GetLinkId ();
+  tempip = tempip.CombineMask (tempmask);
 //
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
+// The stub network is reached through the same next hops and outgoing
+// interfaces as the router <v> advertising it.
+//
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
         {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
+          gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
+      else
         {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
-//
-// Get the Global Router Link State Advertisement from the vertex we're
-// adding the routes to.  The LSA will have a number of attached Global Router
-// Link Records corresponding to links off of that vertex / node.  We're going
-// to be interested in the records corresponding to point-to-point links.
-//
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask (l->GetLinkData ().Get ());
-          Ipv4Address tempip = l->GetLinkId ();
-          tempip = tempip.CombineMask (tempmask);
-//
-// Here's why we did all of that work.  We're going to add a host route to the
-// host address found in the m_linkData field of the point-to-point link
-// record.  In the case of a point-to-point link, this is the local IP address
-// of the node connected to the link.  Each of these point-to-point links
-// will correspond to a local interface that has an IP address to which
-// the node at the root of the SPF tree can send packets.  The vertex <v> 
-// (corresponding to the node that has these links and interfaces) has 
-// an m_nextHop address precalculated for us that is the address to which the
-// root node should send packets to be forwarded to these IP addresses.
-// Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
-// which the packets should be send for forwarding.
-//
-
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+          NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 //
@@ -1852,63 +2613,18 @@ GlobalRouteManagerImpl::FindOutgoingInterfaceId (Ipv4Address a, Ipv4Mask amask)
 // node in order to iterate the interfaces and find the one corresponding to
 // the address in question.
 //
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-//
-// Walk the list of nodes in the system looking for the one corresponding to
-// the node at the root of the SPF tree.  This is the node for which we are
-// building the routing table.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  if (m_spfrootIpv4 == 0)
     {
-      Ptr<Node> node = *i;
-
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-//
-// If the node doesn't have a GlobalRouter interface it can't be the one
-// we're interested in.
-//
-      if (rtr == 0)
-        {
-          continue;
-        }
-
-      if (rtr->GetRouterId () == routerId)
-        {
-//
-// This is the node we're building the routing table for.  We're going to need
-// the Ipv4 interface to look for the ipv4 interface index.  Since this node
-// is participating in routing IP version 4 packets, it certainly must have 
-// an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): "
-                         "GetObject for <Ipv4> interface failed");
-//
-// Look through the interfaces on this node for one that has the IP address
-// we're looking for.  If we find one, return the corresponding interface
-// index, or -1 if not found.
-//
-          int32_t interface = ipv4->GetInterfaceForPrefix (a, amask);
-
-#if 0
-          if (interface < 0)
-            {
-              NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
-                              "Expected an interface associated with address a:" << a);
-            }
-#endif 
-          return interface;
-        }
+      NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << 
+                    m_spfroot->GetVertexId ());
+      return -1;
     }
 //
-// Couldn't find it.
+// Look through the interfaces on the root node for one that has the IP
+// address we're looking for.  If we find one, return the corresponding
+// interface index, or -1 if not found.
 //
-  NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << routerId);
-  return -1;
+  return m_spfrootIpv4->GetInterfaceForPrefix (a, amask);
 }
 
 //
@@ -1945,60 +2661,27 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The routing information is written to the router at the root of the SPF
+// tree, found when the calculation started.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Ipv4GlobalRouting> gr = m_spfrootRouting;
+  if (gr == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to 
-// GetObject for that interface.  If the node is acting as an IP version 4 
-// router, it should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "GetObject for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("No node for router " << routerId);
+      return;
+    }
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
 
-          uint32_t nLinkRecords = lsa->GetNLinkRecords ();
+  uint32_t nLinkRecords = lsa->GetNLinkRecords ();
 //
 // Iterate through the link records on the vertex to which we're going to add
 // routes.  To make sure we're being clear, we're going to add routing table
@@ -2007,18 +2690,18 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // the local side of the point-to-point links found on the node described by
 // the vertex <v>.
 //
-          NS_LOG_LOGIC (" Node " << node->GetId () <<
-                        " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
-          for (uint32_t j = 0; j < nLinkRecords; ++j)
-            {
+  NS_LOG_LOGIC (" Router " << routerId <<
+                " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
+  for (uint32_t j = 0; j < nLinkRecords; ++j)
+    {
 //
 // We are only concerned about point-to-point links
 //
-              GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
-              if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
-                {
-                  continue;
-                }
+      GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+      if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
+        {
+          continue;
+        }
 //
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
@@ -2032,46 +2715,34 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-              Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-              if (router == 0)
-                {
-                  continue;
-                }
-              Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-              NS_ASSERT (gr);
-              // walk through all available exit directions due to ECMP,
-              // and add host route for each of the exit direction toward
-              // the vertex 'v'
-              for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-                {
-                  SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-                  Ipv4Address nextHop = exit.first;
-                  int32_t outIf = exit.second;
-                  if (outIf >= 0)
-                    {
-                      gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
-                                          outIf);
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " adding host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " and outgoing interface " << outIf);
-                    }
-                  else
-                    {
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " NOT able to add host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " since outgoing interface id is negative " << outIf);
-                    }
-                } // for all routes from the root the vertex 'v'
-            }
-//
-// Done adding the routes for the selected node.
+// Walk through all available exit directions due to ECMP, and add host
+// route for each of the exit direction toward the vertex 'v'
 //
-          return;
-        }
+      for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+        {
+          SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+          Ipv4Address nextHop = exit.first;
+          int32_t outIf = exit.second;
+          if (outIf >= 0)
+            {
+              gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
+                                  outIf);
+              NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                            " adding host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " and outgoing interface " << outIf);
+            }
+          else
+            {
+              NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                            " NOT able to add host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " since outgoing interface id is negative " << outIf);
+            }
+        } // for all routes from the root the vertex 'v'
     }
 }
+
 void
 GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
 {
@@ -2090,95 +2761,52 @@ GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The routing information is written to the router at the root of the SPF
+// tree, found when the calculation started.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Ipv4GlobalRouting> gr = m_spfrootRouting;
+  if (gr == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("setting routes for node " << node->GetId ());
+      NS_LOG_LOGIC ("No node for router " << routerId);
+      return;
+    }
 //
-// Routing information is updated using the Ipv4 interface.  We need to 
-// GetObject for that interface.  If the node is acting as an IP version 4 
-// router, it should absolutely have an Ipv4 interface.
+// Get the Global Router Link State Advertisement from the vertex we're
+// adding the routes to.  This is the network LSA of the transit network.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "GetObject for <Ipv4> interface failed");
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = lsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
 //
-// Get the Global Router Link State Advertisement from the vertex we're
-// adding the routes to.  The LSA will have a number of attached Global Router
-// Link Records corresponding to links off of that vertex / node.  We're going
-// to be interested in the records corresponding to point-to-point links.
+// Walk through all available exit directions due to ECMP, and add a
+// network route for each of the exit direction toward the vertex 'v'
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = lsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all available exit directions due to ECMP,
-          // and add host route for each of the exit direction toward
-          // the vertex 'v'
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
 
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative " << outIf);
-                }
-            }
+      if (outIf >= 0)
+        {
+          gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-    } 
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative " << outIf);
+        }
+    }
 }
 
 // Derived from quagga ospf_vertex_add_parents ()
@@ -31,12 +31,14 @@
 #include "ns3/ptr.h"
 #include "ns3/ipv4-address.h"
 #include "global-router-interface.h"
+#include "ipv4-routing-table-entry.h"
 
 namespace ns3 {
 
 const uint32_t SPF_INFINITY = 0xffffffff; //!< "infinite" distance between nodes
 
 class CandidateQueue;
+class Ipv4;
 class Ipv4GlobalRouting;
 
 /**
@@ -536,6 +538,9 @@ private:
   ListOfSPFVertex_t m_parents; //!< parent list
   ListOfSPFVertex_t m_children; //!< Children list
   bool m_vertexProcessed; //!< Flag to note whether vertex has been processed in stage two of SPF computation
+  uint32_t m_candidateIndex; //!< Position in the CandidateQueue heap
+
+  friend class CandidateQueue;
 
 /**
  * @brief The SPFVertex copy construction is disallowed.  There's no need for
@@ -672,6 +677,23 @@ public:
    */
   uint32_t GetNumExtLSAs () const;
 
+  /**
+   * @brief Get the Link State Advertisements other than the External ones.
+   *
+   * @param lsas The Link State Advertisements, by increasing address.
+   */
+  void GetLSAs (std::vector<GlobalRoutingLSA*> &lsas) const;
+
+  /**
+   * @brief Make a deep copy of the database.
+   *
+   * The copy can be used by an SPF computation running concurrently with
+   * computations on this database, since the SPF computation keeps its
+   * state in the Link State Advertisements.
+   *
+   * @returns A new Link State Database, owned by the caller.
+   */
+  GlobalRouteManagerLSDB* Copy (void) const;
 
 private:
   typedef std::map<Ipv4Address, GlobalRoutingLSA*> LSDBMap_t; //!< container of IPv4 addresses / Link State Advertisements
@@ -679,6 +701,8 @@ private:
 
   LSDBMap_t m_database; //!< database of IPv4 addresses / Link State Advertisements
   std::vector<GlobalRoutingLSA*> m_extdatabase; //!< database of External Link State Advertisements
+  /// TransitNetwork link data addresses, and the address of the LSA found by GetLSAByLinkData ()
+  std::map<Ipv4Address, Ipv4Address> m_linkData;
 
 /**
  * @brief GlobalRouteManagerLSDB copy construction is disallowed.  There's no 
@@ -730,9 +754,36 @@ public:
 /**
  * @brief Compute routes using a Dijkstra SPF computation and populate
  * per-node forwarding tables
+ *
+ * The SPF computations of the routers are independent of each other.  When
+ * the "GlobalRoutingThreads" global value is more than one, they are run
+ * on that many threads, each working on its own copy of the LSDB.  Logging
+ * is not thread safe, so it should be disabled for this component when
+ * threads are used.
  */
   virtual void InitializeRoutes ();
 
+/**
+ * @brief Update the per-node forwarding tables after a change of the
+ * topology, such as a link going down or up.
+ *
+ * A new routing database is built and compared with the one the current
+ * routes were computed from.  When the only changes are point-to-point
+ * links and stub networks of some routers, the SPF computation is run
+ * again only for the routers whose shortest path trees may have changed:
+ * the routers that advertise a change, their neighbors, and the routers
+ * having a shortest path through a link that went down or that a new link
+ * would shorten or tie.  The other routers keep their routes, adding or
+ * removing only the routes to the addresses and stub networks that the
+ * changed routers advertise, through the exits they already use to reach
+ * those routers.  Any other change falls back to recomputing all of the
+ * routes.
+ *
+ * The routes obtained are the same as those of a full recomputation,
+ * possibly in a different order.
+ */
+  virtual void UpdateGlobalRoutes ();
+
 /**
  * @brief Debugging routine; allow client code to supply a pre-built LSDB
  */
@@ -766,6 +817,60 @@ private:
 
   SPFVertex* m_spfroot; //!< the root node
   GlobalRouteManagerLSDB* m_lsdb; //!< the Link State DataBase (LSDB) of the Global Route Manager
+  Ptr<Ipv4> m_spfrootIpv4; //!< the Ipv4 of the root node, if any
+  Ptr<Ipv4GlobalRouting> m_spfrootRouting; //!< the routing protocol of the root node, if any
+
+  /// A router for which routes are computed.
+  struct SPFRoot
+  {
+    Ipv4Address m_routerId; //!< the router ID
+    Ptr<Ipv4> m_ipv4; //!< the Ipv4 of the router node
+    Ptr<Ipv4GlobalRouting> m_routing; //!< the routing protocol written to
+  };
+
+  /// Route changes computed by UpdateGlobalRoutes () for a router.
+  struct RoutePatch
+  {
+    Ptr<Ipv4GlobalRouting> m_routing; //!< the routing protocol to change
+    std::vector<Ipv4RoutingTableEntry> m_removed; //!< routes to remove
+    std::vector<Ipv4RoutingTableEntry> m_hostRoutes; //!< host routes to add
+    std::vector<Ipv4RoutingTableEntry> m_networkRoutes; //!< network routes to add
+  };
+
+  class SPFWorker;
+  friend class SPFWorker;
+
+  /**
+   * \brief Gather the Link State Advertisements of the routers.
+   * \param lsdb the database to write them to
+   */
+  void BuildLSDB (GlobalRouteManagerLSDB *lsdb);
+
+  /**
+   * \brief Find the routers for which this system computes routes.
+   * \param roots the routers found
+   */
+  void GetSPFRoots (std::vector<SPFRoot> &roots) const;
+
+  /**
+   * \brief Run the SPF calculation of a list of routers, sequentially or
+   * on the number of threads set by the "GlobalRoutingThreads" global value.
+   * \param roots the routers
+   */
+  void SPFCalculateAll (const std::vector<SPFRoot> &roots);
+
+  /**
+   * \brief Find the changes to make for UpdateGlobalRoutes ().
+   * \param lsdb the new Link State Database
+   * \param roots the routers
+   * \param recompute the routers whose routes must be recomputed
+   * \param patches the route changes of the other routers
+   * \returns false if all of the routes must be recomputed
+   */
+  bool PlanUpdate (GlobalRouteManagerLSDB *lsdb,
+                   const std::vector<SPFRoot> &roots,
+                   std::vector<SPFRoot> &recompute,
+                   std::vector<RoutePatch> &patches) const;
 
   /**
    * \brief Test if a node is a stub, from an OSPF sense.
@@ -787,6 +892,17 @@ private:
    */
   void SPFCalculate (Ipv4Address root);
 
+  /**
+   * \brief Calculate the shortest path first (SPF) tree
+   *
+   * This version is given the root node objects, and does not use the
+   * node list, so that calculations for different roots can run
+   * concurrently.
+   *
+   * \param root the root node
+   */
+  void SPFCalculate (const SPFRoot &root);
+
   /**
    * \brief Process Stub nodes
    *
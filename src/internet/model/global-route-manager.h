@@ -62,6 +62,15 @@ public:
  */
   static void InitializeRoutes ();
 
+/**
+ * @brief Update the per-node forwarding tables after a change of the
+ * topology, recomputing only the routes that may have changed.
+ *
+ * This replaces calling DeleteGlobalRoutes (), BuildGlobalRoutingDatabase ()
+ * and InitializeRoutes () again.
+ */
+  static void UpdateGlobalRoutes ();
+
 private:
 /**
  * @brief Global Route Manager copy construction is disallowed.  There's no 
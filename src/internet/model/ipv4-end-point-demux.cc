@@ -18,6 +18,8 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 
+#include <algorithm>
+#include <iterator>
 #include "ipv4-end-point-demux.h"
 #include "ipv4-end-point.h"
 #include "ns3/log.h"
@@ -26,8 +28,26 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Ipv4EndPointDemux");
 
+size_t
+Ipv4EndPointDemux::PeerKeyHash::operator () (const PeerKey &key) const
+{
+  uint32_t h = key.m_peerAddr.Get () * 2654435761U;
+  h ^= (static_cast<uint32_t> (key.m_localPort) << 16) | key.m_peerPort;
+  h *= 2246822519U;
+  return h ^ (h >> 15);
+}
+
+bool
+Ipv4EndPointDemux::PeerKeyEqual::operator () (const PeerKey &a, const PeerKey &b) const
+{
+  return a.m_peerAddr == b.m_peerAddr
+    && a.m_localPort == b.m_localPort
+    && a.m_peerPort == b.m_peerPort;
+}
+
 Ipv4EndPointDemux::Ipv4EndPointDemux ()
-  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152)
+  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152),
+    m_order (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -35,36 +55,162 @@ Ipv4EndPointDemux::Ipv4EndPointDemux ()
 Ipv4EndPointDemux::~Ipv4EndPointDemux ()
 {
   NS_LOG_FUNCTION (this);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  for (Ordered::iterator i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
     {
-      Ipv4EndPoint *endPoint = *i;
+      Ipv4EndPoint *endPoint = i->second;
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_ports.clear ();
+  m_peers.clear ();
+}
+
+Ipv4EndPointDemux::PeerKey
+Ipv4EndPointDemux::MakeKey (uint16_t localPort, Ipv4Address peerAddress,
+                            uint16_t peerPort)
+{
+  PeerKey key;
+  key.m_peerAddr = peerAddress;
+  key.m_localPort = localPort;
+  key.m_peerPort = peerPort;
+  return key;
 }
 
 bool
-Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+Ipv4EndPointDemux::IsPeerKnown (Ipv4Address peerAddress, uint16_t peerPort)
 {
-  NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  return peerPort != 0 && peerAddress != Ipv4Address::GetAny ();
+}
+
+bool
+Ipv4EndPointDemux::IsBefore (const Ipv4EndPoint *a, const Ipv4EndPoint *b)
+{
+  return a->m_order < b->m_order;
+}
+
+void
+Ipv4EndPointDemux::BucketInsert (Bucket &bucket, Ipv4EndPoint *endPoint)
+{
+  bucket.insert (std::upper_bound (bucket.begin (), bucket.end (), endPoint, &IsBefore),
+                 endPoint);
+}
+
+void
+Ipv4EndPointDemux::BucketRemove (Bucket &bucket, Ipv4EndPoint *endPoint)
+{
+  Bucket::iterator i = std::lower_bound (bucket.begin (), bucket.end (), endPoint, &IsBefore);
+  NS_ASSERT (i != bucket.end () && *i == endPoint);
+  bucket.erase (i);
+}
+
+Ipv4EndPoint *
+Ipv4EndPointDemux::Insert (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  endPoint->m_demux = this;
+  endPoint->m_order = m_order++;
+  m_endPoints[endPoint->m_order] = endPoint;
+  m_ports[endPoint->GetLocalPort ()].m_all[endPoint->m_order] = endPoint;
+  IndexPeer (endPoint);
+  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  return endPoint;
+}
+
+void
+Ipv4EndPointDemux::IndexPeer (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  if (IsPeerKnown (endPoint->GetPeerAddress (), endPoint->GetPeerPort ()))
+    {
+      PeerKey key = MakeKey (endPoint->GetLocalPort (), endPoint->GetPeerAddress (),
+                             endPoint->GetPeerPort ());
+      BucketInsert (m_peers[key], endPoint);
+    }
+  else
+    {
+      BucketInsert (m_ports[endPoint->GetLocalPort ()].m_wild, endPoint);
+    }
+}
+
+void
+Ipv4EndPointDemux::UnindexPeer (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  if (IsPeerKnown (endPoint->GetPeerAddress (), endPoint->GetPeerPort ()))
     {
-      if ((*i)->GetLocalPort  () == port) 
+      PeerKey key = MakeKey (endPoint->GetLocalPort (), endPoint->GetPeerAddress (),
+                             endPoint->GetPeerPort ());
+      Peers::iterator i = m_peers.find (key);
+      NS_ASSERT (i != m_peers.end ());
+      BucketRemove (i->second, endPoint);
+      if (i->second.empty ())
         {
-          return true;
+          m_peers.erase (i);
         }
     }
-  return false;
+  else
+    {
+      BucketRemove (m_ports[endPoint->GetLocalPort ()].m_wild, endPoint);
+    }
+}
+
+Ipv4EndPoint *
+Ipv4EndPointDemux::FindExact (Ipv4Address localAddress, uint16_t localPort,
+                              Ipv4Address peerAddress, uint16_t peerPort)
+{
+  NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
+  const Bucket *bucket = 0;
+  if (IsPeerKnown (peerAddress, peerPort))
+    {
+      Peers::const_iterator i = m_peers.find (MakeKey (localPort, peerAddress, peerPort));
+      if (i != m_peers.end ())
+        {
+          bucket = &i->second;
+        }
+    }
+  else
+    {
+      Ports::const_iterator i = m_ports.find (localPort);
+      if (i != m_ports.end ())
+        {
+          bucket = &i->second.m_wild;
+        }
+    }
+  if (bucket == 0)
+    {
+      return 0;
+    }
+  for (Bucket::const_iterator i = bucket->begin (); i != bucket->end (); i++)
+    {
+      if ((*i)->GetLocalAddress () == localAddress &&
+          (*i)->GetPeerPort () == peerPort &&
+          (*i)->GetPeerAddress () == peerAddress)
+        {
+          return *i;
+        }
+    }
+  return 0;
+}
+
+bool
+Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool
 Ipv4EndPointDemux::LookupLocal (Ipv4Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  Ports::const_iterator p = m_ports.find (port);
+  if (p == m_ports.end ())
+    {
+      return false;
+    }
+  for (Ordered::const_iterator i = p->second.m_all.begin (); i != p->second.m_all.end (); i++) 
     {
-      if ((*i)->GetLocalPort () == port &&
-          (*i)->GetLocalAddress () == addr) 
+      if (i->second->GetLocalAddress () == addr) 
         {
           return true;
         }
@@ -82,10 +228,7 @@ Ipv4EndPointDemux::Allocate (void)
       NS_LOG_WARN ("Ephemeral port allocation failed.");
       return 0;
     }
-  Ipv4EndPoint *endPoint = new Ipv4EndPoint (Ipv4Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv4EndPoint (Ipv4Address::GetAny (), port));
 }
 
 Ipv4EndPoint *
@@ -98,10 +241,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address)
       NS_LOG_WARN ("Ephemeral port allocation failed.");
       return 0;
     }
-  Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv4EndPoint (address, port));
 }
 
 Ipv4EndPoint *
@@ -121,10 +261,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address, uint16_t port)
       NS_LOG_WARN ("Duplicate address/port; failing.");
       return 0;
     }
-  Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv4EndPoint (address, port));
 }
 
 Ipv4EndPoint *
@@ -132,40 +269,34 @@ Ipv4EndPointDemux::Allocate (Ipv4Address localAddress, uint16_t localPort,
                              Ipv4Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  if (FindExact (localAddress, localPort, peerAddress, peerPort) != 0)
     {
-      if ((*i)->GetLocalPort () == localPort &&
-          (*i)->GetLocalAddress () == localAddress &&
-          (*i)->GetPeerPort () == peerPort &&
-          (*i)->GetPeerAddress () == peerAddress) 
-        {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
-        }
+      NS_LOG_WARN ("No way we can allocate this end-point.");
+      /* no way we can allocate this end-point. */
+      return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
-
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-
-  return endPoint;
+  return Insert (endPoint);
 }
 
 void 
 Ipv4EndPointDemux::DeAllocate (Ipv4EndPoint *endPoint)
 {
   NS_LOG_FUNCTION (this << endPoint);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  if (endPoint->m_demux != this)
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      return;
+    }
+  UnindexPeer (endPoint);
+  Ports::iterator p = m_ports.find (endPoint->GetLocalPort ());
+  p->second.m_all.erase (endPoint->m_order);
+  if (p->second.m_all.empty ())
+    {
+      m_ports.erase (p);
     }
+  m_endPoints.erase (endPoint->m_order);
+  delete endPoint;
 }
 
 /*
@@ -177,9 +308,9 @@ Ipv4EndPointDemux::GetAllEndPoints (void)
   NS_LOG_FUNCTION (this);
   EndPoints ret;
 
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  for (Ordered::iterator i = m_endPoints.begin (); i != m_endPoints.end (); i++)
     {
-      Ipv4EndPoint* endP = *i;
+      Ipv4EndPoint* endP = i->second;
       ret.push_back (endP);
     }
   return ret;
@@ -204,7 +335,52 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
   EndPoints retval4; // Exact match on all 4
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  Ports::const_iterator port = m_ports.find (dport);
+  if (port == m_ports.end ())
+    {
+      return retval1;
+    }
+  // Only the endpoints without a known peer, and those connected to
+  // exactly the source of the packet, can match.  Merge them back in
+  // allocation order so that the result lists keep their order.
+  Bucket candidates;
+  Peers::const_iterator peers = m_peers.end ();
+  if (IsPeerKnown (saddr, sport))
+    {
+      peers = m_peers.find (MakeKey (dport, saddr, sport));
+    }
+  if (peers == m_peers.end ())
+    {
+      candidates = port->second.m_wild;
+    }
+  else
+    {
+      candidates.reserve (port->second.m_wild.size () + peers->second.size ());
+      std::merge (port->second.m_wild.begin (), port->second.m_wild.end (),
+                  peers->second.begin (), peers->second.end (),
+                  std::back_inserter (candidates), &IsBefore);
+    }
+  if (candidates.empty ())
+    {
+      return retval1;
+    }
+
+  bool subnetDirected = false;
+  Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
+  for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
+    {
+      Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
+      if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
+          daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
+        {
+          subnetDirected = true;
+          incomingInterfaceAddr = addr.GetLocal ();
+        }
+    }
+  bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
+  NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
+
+  for (Bucket::const_iterator i = candidates.begin (); i != candidates.end (); i++) 
     {
       Ipv4EndPoint* endP = *i;
 
@@ -220,14 +396,6 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
           continue;
         }
 
-      if (endP->GetLocalPort () != dport) 
-        {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                             << " because endpoint dport "
-                                             << endP->GetLocalPort ()
-                                             << " does not match packet dport " << dport);
-          continue;
-        }
       if (endP->GetBoundNetDevice ())
         {
           if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
@@ -239,20 +407,6 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
               continue;
             }
         }
-      bool subnetDirected = false;
-      Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
-      for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
-        {
-          Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
-          if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
-              daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
-            {
-              subnetDirected = true;
-              incomingInterfaceAddr = addr.GetLocal ();
-            }
-        }
-      bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
-      NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
       bool localAddressMatchesWildCard = 
         endP->GetLocalAddress () == Ipv4Address::GetAny ();
       bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
@@ -328,31 +482,33 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
   // function.
   uint32_t genericity = 3;
   Ipv4EndPoint *generic = 0;
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  Ports::const_iterator port = m_ports.find (dport);
+  if (port == m_ports.end ())
     {
-      if ((*i)->GetLocalPort () != dport) 
-        {
-          continue;
-        }
-      if ((*i)->GetLocalAddress () == daddr &&
-          (*i)->GetPeerPort () == sport &&
-          (*i)->GetPeerAddress () == saddr) 
+      return 0;
+    }
+  for (Ordered::const_iterator i = port->second.m_all.begin (); i != port->second.m_all.end (); i++) 
+    {
+      Ipv4EndPoint *endP = i->second;
+      if (endP->GetLocalAddress () == daddr &&
+          endP->GetPeerPort () == sport &&
+          endP->GetPeerAddress () == saddr) 
         {
           /* this is an exact match. */
-          return *i;
+          return endP;
         }
       uint32_t tmp = 0;
-      if ((*i)->GetLocalAddress () == Ipv4Address::GetAny ()) 
+      if (endP->GetLocalAddress () == Ipv4Address::GetAny ()) 
         {
           tmp++;
         }
-      if ((*i)->GetPeerAddress () == Ipv4Address::GetAny ()) 
+      if (endP->GetPeerAddress () == Ipv4Address::GetAny ()) 
         {
           tmp++;
         }
       if (tmp < genericity) 
         {
-          generic = (*i);
+          generic = endP;
           genericity = tmp;
         }
     }
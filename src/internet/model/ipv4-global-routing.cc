@@ -17,7 +17,10 @@
 //
 
 #include <vector>
+#include <set>
 #include <iomanip>
+#include <algorithm>
+#include <cstring>
 #include "ns3/names.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
@@ -27,8 +30,13 @@
 #include "ns3/ipv4-route.h"
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/node.h"
 #include "ipv4-global-routing.h"
 #include "global-route-manager.h"
+#include "tcp-l4-protocol.h"
+#include "udp-l4-protocol.h"
 
 namespace ns3 {
 
@@ -52,13 +60,43 @@ Ipv4GlobalRouting::GetTypeId (void)
                    BooleanValue (false),
                    MakeBooleanAccessor (&Ipv4GlobalRouting::m_respondToInterfaceEvents),
                    MakeBooleanChecker ())
+    .AddAttribute ("EcmpMode",
+                   "How packets are spread among equal cost routes; RandomEcmpRouting, when set, overrides it with Random",
+                   EnumValue (ECMP_NONE),
+                   MakeEnumAccessor (&Ipv4GlobalRouting::m_ecmpMode),
+                   MakeEnumChecker (ECMP_NONE, "None",
+                                    ECMP_RANDOM, "Random",
+                                    ECMP_FLOW_HASH, "FlowHash",
+                                    ECMP_CONSISTENT_HASH, "ConsistentHash",
+                                    ECMP_FLOWLET, "Flowlet"))
+    .AddAttribute ("EcmpHashFunction",
+                   "The hash function of the 5-tuple of a flow",
+                   EnumValue (FNV1A),
+                   MakeEnumAccessor (&Ipv4GlobalRouting::SetEcmpHashFunction),
+                   MakeEnumChecker (FNV1A, "Fnv1a",
+                                    MURMUR3, "Murmur3"))
+    .AddAttribute ("EcmpHashSeed",
+                   "A seed mixed into the hash of the 5-tuple of a flow",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&Ipv4GlobalRouting::m_ecmpHashSeed),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("FlowletTimeout",
+                   "The idle time after which a flow may change route, in Flowlet mode",
+                   TimeValue (MicroSeconds (500)),
+                   MakeTimeAccessor (&Ipv4GlobalRouting::m_flowletTimeout),
+                   MakeTimeChecker ())
   ;
   return tid;
 }
 
 Ipv4GlobalRouting::Ipv4GlobalRouting () 
   : m_randomEcmpRouting (false),
-    m_respondToInterfaceEvents (false)
+    m_respondToInterfaceEvents (false),
+    m_ecmpMode (ECMP_NONE),
+    m_hasher (Create<Hash::Function::Fnv1a> ()),
+    m_ecmpHashSeed (0),
+    m_ecmpSalt (0),
+    m_flowletSweep (1024)
 {
   NS_LOG_FUNCTION (this);
 
@@ -79,6 +117,8 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, nextHop, interface);
   m_hostRoutes.push_back (route);
+  m_hostTrie.Insert (route);
+  FlushNextHopGroups ();
 }
 
 void 
@@ -89,6 +129,8 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, interface);
   m_hostRoutes.push_back (route);
+  m_hostTrie.Insert (route);
+  FlushNextHopGroups ();
 }
 
 void 
@@ -104,6 +146,8 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_networkTrie.Insert (route);
+  FlushNextHopGroups ();
 }
 
 void 
@@ -117,6 +161,8 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_networkTrie.Insert (route);
+  FlushNextHopGroups ();
 }
 
 void 
@@ -132,104 +178,238 @@ Ipv4GlobalRouting::AddASExternalRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_ASexternalRoutes.push_back (route);
+  m_ASexternalTrie.Insert (route);
+  FlushNextHopGroups ();
 }
 
+bool
+Ipv4GlobalRouting::IsAddedBefore (const Ipv4RouteTrie::Route *a,
+                                  const Ipv4RouteTrie::Route *b)
+{
+  return a->m_order < b->m_order;
+}
 
-Ptr<Ipv4Route>
-Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
+void
+Ipv4GlobalRouting::CollectRoutes (Ipv4Address dest, Ptr<NetDevice> oif, RouteVec &allRoutes)
 {
   NS_LOG_FUNCTION (this << dest << oif);
   NS_LOG_LOGIC ("Looking for route for destination " << dest);
-  Ptr<Ipv4Route> rtentry = 0;
-  // store all available routes that bring packets to their destination
-  typedef std::vector<Ipv4RoutingTableEntry*> RouteVec_t;
-  RouteVec_t allRoutes;
+  allRoutes.clear ();
 
   NS_LOG_LOGIC ("Number of m_hostRoutes = " << m_hostRoutes.size ());
-  for (HostRoutesCI i = m_hostRoutes.begin (); 
-       i != m_hostRoutes.end (); 
+  m_hostTrie.Lookup (dest, m_matches);
+  for (Ipv4RouteTrie::Matches::const_iterator i = m_matches.begin (); 
+       i != m_matches.end (); 
        i++) 
     {
-      NS_ASSERT ((*i)->IsHost ());
-      if ((*i)->GetDest ().IsEqual (dest)) 
+      Ipv4RoutingTableEntry *route = (*i)->m_entry;
+      NS_ASSERT (route->IsHost ());
+      if (oif != 0)
         {
-          if (oif != 0)
+          if (oif != m_ipv4->GetNetDevice (route->GetInterface ()))
             {
-              if (oif != m_ipv4->GetNetDevice ((*i)->GetInterface ()))
-                {
-                  NS_LOG_LOGIC ("Not on requested interface, skipping");
-                  continue;
-                }
+              NS_LOG_LOGIC ("Not on requested interface, skipping");
+              continue;
             }
-          allRoutes.push_back (*i);
-          NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << *i); 
         }
+      allRoutes.push_back (route);
+      NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << route); 
     }
   if (allRoutes.size () == 0) // if no host route is found
     {
       NS_LOG_LOGIC ("Number of m_networkRoutes" << m_networkRoutes.size ());
-      for (NetworkRoutesI j = m_networkRoutes.begin (); 
-           j != m_networkRoutes.end (); 
+      // all matching network routes are candidates, whatever their
+      // prefix length, in the order they were added
+      m_networkTrie.Lookup (dest, m_matches);
+      std::sort (m_matches.begin (), m_matches.end (), &Ipv4GlobalRouting::IsAddedBefore);
+      for (Ipv4RouteTrie::Matches::const_iterator j = m_matches.begin (); 
+           j != m_matches.end (); 
            j++) 
         {
-          Ipv4Mask mask = (*j)->GetDestNetworkMask ();
-          Ipv4Address entry = (*j)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry)) 
+          Ipv4RoutingTableEntry *route = (*j)->m_entry;
+          if (oif != 0)
             {
-              if (oif != 0)
+              if (oif != m_ipv4->GetNetDevice (route->GetInterface ()))
                 {
-                  if (oif != m_ipv4->GetNetDevice ((*j)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
+                  NS_LOG_LOGIC ("Not on requested interface, skipping");
+                  continue;
                 }
-              allRoutes.push_back (*j);
-              NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << *j);
             }
+          allRoutes.push_back (route);
+          NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << route);
         }
     }
   if (allRoutes.size () == 0)  // consider external if no host/network found
     {
-      for (ASExternalRoutesI k = m_ASexternalRoutes.begin ();
-           k != m_ASexternalRoutes.end ();
+      m_ASexternalTrie.Lookup (dest, m_matches);
+      std::sort (m_matches.begin (), m_matches.end (), &Ipv4GlobalRouting::IsAddedBefore);
+      for (Ipv4RouteTrie::Matches::const_iterator k = m_matches.begin ();
+           k != m_matches.end ();
            k++)
         {
-          Ipv4Mask mask = (*k)->GetDestNetworkMask ();
-          Ipv4Address entry = (*k)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry))
+          Ipv4RoutingTableEntry *route = (*k)->m_entry;
+          NS_LOG_LOGIC ("Found external route" << route);
+          if (oif != 0)
             {
-              NS_LOG_LOGIC ("Found external route" << *k);
-              if (oif != 0)
+              if (oif != m_ipv4->GetNetDevice (route->GetInterface ()))
                 {
-                  if (oif != m_ipv4->GetNetDevice ((*k)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
+                  NS_LOG_LOGIC ("Not on requested interface, skipping");
+                  continue;
                 }
-              allRoutes.push_back (*k);
-              break;
             }
+          allRoutes.push_back (route);
+          break;
         }
     }
-  if (allRoutes.size () > 0 ) // if route(s) is found
+}
+
+/**
+ * \brief Mix two 32 bit integers into a hash.
+ *
+ * This is the finalizer of Murmur3, cheap enough to score every route
+ * of a next-hop group for each packet.
+ *
+ * \param a The first integer.
+ * \param b The second integer.
+ * \return The hash.
+ */
+static inline uint32_t
+Mix (uint32_t a, uint32_t b)
+{
+  uint32_t h = a ^ (b * 0x9e3779b9U);
+  h ^= h >> 16;
+  h *= 0x85ebca6bU;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35U;
+  h ^= h >> 16;
+  return h;
+}
+
+bool
+Ipv4GlobalRouting::IsFlowEcmp (void) const
+{
+  return !m_randomEcmpRouting
+         && (m_ecmpMode == ECMP_FLOW_HASH
+             || m_ecmpMode == ECMP_CONSISTENT_HASH
+             || m_ecmpMode == ECMP_FLOWLET);
+}
+
+uint32_t
+Ipv4GlobalRouting::SelectRoute (const RouteVec &routes, uint32_t flow)
+{
+  NS_LOG_FUNCTION (this << routes.size () << flow);
+  uint32_t n = routes.size ();
+  if (n == 1)
     {
-      // pick up one of the routes uniformly at random if random
-      // ECMP routing is enabled, or always select the first route
-      // consistently if random ECMP routing is disabled
-      uint32_t selectIndex;
-      if (m_randomEcmpRouting)
-        {
-          selectIndex = m_rand->GetInteger (0, allRoutes.size ()-1);
-        }
-      else 
+      return 0;
+    }
+  if (m_randomEcmpRouting || m_ecmpMode == ECMP_RANDOM)
+    {
+      return m_rand->GetInteger (0, n - 1);
+    }
+  switch (m_ecmpMode)
+    {
+    case ECMP_FLOW_HASH:
+      return flow % n;
+    case ECMP_CONSISTENT_HASH:
+      {
+        // Rendezvous hashing: the route with the highest score for the
+        // flow, where the score of a route depends on its next hop only
+        uint32_t best = 0;
+        uint32_t bestScore = 0;
+        for (uint32_t i = 0; i < n; i++)
+          {
+            uint32_t hop = Mix (routes[i]->GetGateway ().Get (), routes[i]->GetInterface ());
+            uint32_t score = Mix (flow, hop);
+            if (i == 0 || score > bestScore)
+              {
+                best = i;
+                bestScore = score;
+              }
+          }
+        return best;
+      }
+    case ECMP_FLOWLET:
+      {
+        Time now = Simulator::Now ();
+        if (m_flowlets.size () >= m_flowletSweep)
+          {
+            for (Flowlets::iterator i = m_flowlets.begin (); i != m_flowlets.end (); )
+              {
+                if (now - i->second.m_lastSeen > m_flowletTimeout)
+                  {
+                    m_flowlets.erase (i++);
+                  }
+                else
+                  {
+                    ++i;
+                  }
+              }
+            m_flowletSweep = std::max<uint32_t> (1024, 2 * m_flowlets.size ());
+          }
+        std::pair<Flowlets::iterator, bool> inserted = m_flowlets.insert (std::make_pair (flow, Flowlet ()));
+        Flowlet &flowlet = inserted.first->second;
+        if (inserted.second || now - flowlet.m_lastSeen > m_flowletTimeout || flowlet.m_index >= n)
+          {
+            flowlet.m_index = m_rand->GetInteger (0, n - 1);
+            NS_LOG_LOGIC ("New flowlet of flow " << flow << " on route " << flowlet.m_index);
+          }
+        flowlet.m_lastSeen = now;
+        return flowlet.m_index;
+      }
+    default:
+      return 0;
+    }
+}
+
+uint32_t
+Ipv4GlobalRouting::HashFlow (const Ipv4Header &header, Ptr<const Packet> p, bool ports)
+{
+  uint8_t buffer[21];
+  uint32_t values[3] = { m_ecmpHashSeed, m_ecmpSalt, 0 };
+  std::memcpy (buffer, values, 8);
+  header.GetSource ().Serialize (buffer + 8);
+  header.GetDestination ().Serialize (buffer + 12);
+  buffer[16] = header.GetProtocol ();
+  uint32_t size = 17;
+  if (ports && p != 0 && p->GetSize () >= 4
+      && header.GetFragmentOffset () == 0 && header.IsLastFragment ()
+      && (header.GetProtocol () == TcpL4Protocol::PROT_NUMBER
+          || header.GetProtocol () == UdpL4Protocol::PROT_NUMBER))
+    {
+      // The source and destination ports lead both TCP and UDP headers
+      p->CopyData (buffer + size, 4);
+      size += 4;
+    }
+  return m_hasher.clear ().GetHash32 (reinterpret_cast<const char *> (buffer), size);
+}
+
+Ptr<Ipv4Route>
+Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif, uint32_t flow)
+{
+  NS_LOG_FUNCTION (this << dest << oif << flow);
+  RouteVec candidates;
+  const RouteVec *routes = &candidates;
+  if (oif == 0 && IsFlowEcmp ())
+    {
+      std::pair<NextHopGroups::iterator, bool> group = m_nextHopGroups.insert (std::make_pair (dest, RouteVec ()));
+      if (group.second)
         {
-          selectIndex = 0;
+          CollectRoutes (dest, oif, group.first->second);
         }
-      Ipv4RoutingTableEntry* route = allRoutes.at (selectIndex); 
+      routes = &group.first->second;
+    }
+  else
+    {
+      CollectRoutes (dest, oif, candidates);
+    }
+  if (routes->size () > 0 ) // if route(s) is found
+    {
+      // pick up one of the routes as the ECMP mode says, or always
+      // the first route if ECMP is disabled
+      Ipv4RoutingTableEntry* route = routes->at (SelectRoute (*routes, flow));
       // create a Ipv4Route object from the selected routing table entry
-      rtentry = Create<Ipv4Route> ();
+      Ptr<Ipv4Route> rtentry = Create<Ipv4Route> ();
       rtentry->SetDestination (route->GetDest ());
       /// \todo handle multi-address case
       rtentry->SetSource (m_ipv4->GetAddress (route->GetInterface (), 0).GetLocal ());
@@ -244,6 +424,34 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
     }
 }
 
+void
+Ipv4GlobalRouting::FlushNextHopGroups (void)
+{
+  m_nextHopGroups.clear ();
+}
+
+uint32_t
+Ipv4GlobalRouting::GetNNextHopGroups (void) const
+{
+  return m_nextHopGroups.size ();
+}
+
+void
+Ipv4GlobalRouting::SetEcmpHashFunction (enum EcmpHashFunction function)
+{
+  NS_LOG_FUNCTION (this << function);
+  switch (function)
+    {
+    case MURMUR3:
+      m_hasher = Hasher (Create<Hash::Function::Murmur3> ());
+      break;
+    case FNV1A:
+    default:
+      m_hasher = Hasher (Create<Hash::Function::Fnv1a> ());
+      break;
+    }
+}
+
 uint32_t 
 Ipv4GlobalRouting::GetNRoutes (void) const
 {
@@ -318,8 +526,10 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
           if (tmp  == index)
             {
               NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_hostRoutes.size ());
+              m_hostTrie.Remove (*i);
               delete *i;
               m_hostRoutes.erase (i);
+              FlushNextHopGroups ();
               NS_LOG_LOGIC ("Done removing host route " << index << "; host route remaining size = " << m_hostRoutes.size ());
               return;
             }
@@ -335,8 +545,10 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
       if (tmp == index)
         {
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_networkRoutes.size ());
+          m_networkTrie.Remove (*j);
           delete *j;
           m_networkRoutes.erase (j);
+          FlushNextHopGroups ();
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
           return;
         }
@@ -351,8 +563,10 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
       if (tmp == index)
         {
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_ASexternalRoutes.size ());
+          m_ASexternalTrie.Remove (*k);
           delete *k;
           m_ASexternalRoutes.erase (k);
+          FlushNextHopGroups ();
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
           return;
         }
@@ -361,6 +575,154 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
   NS_ASSERT (false);
 }
 
+void
+Ipv4GlobalRouting::GetHostRoutesTo (Ipv4Address dest, std::vector<Ipv4RoutingTableEntry> &routes) const
+{
+  NS_LOG_FUNCTION (this << dest);
+  routes.clear ();
+  Ipv4RouteTrie::Matches matches;
+  m_hostTrie.Lookup (dest, matches);
+  for (Ipv4RouteTrie::Matches::const_iterator i = matches.begin (); i != matches.end (); i++)
+    {
+      if ((*i)->m_entry->GetDest () == dest)
+        {
+          routes.push_back (*(*i)->m_entry);
+        }
+    }
+}
+
+/**
+ * \brief Find a route of a trie not yet found.
+ * \param trie The trie.
+ * \param route The route to look for.
+ * \param found The routes already found.
+ * \return The route, or 0.
+ */
+static Ipv4RoutingTableEntry *
+FindRoute (const Ipv4RouteTrie &trie, const Ipv4RoutingTableEntry &route,
+           const std::set<Ipv4RoutingTableEntry *> &found)
+{
+  Ipv4RouteTrie::Matches matches;
+  trie.Lookup (route.GetDestNetwork (), matches);
+  for (Ipv4RouteTrie::Matches::const_iterator i = matches.begin (); i != matches.end (); i++)
+    {
+      Ipv4RoutingTableEntry *entry = (*i)->m_entry;
+      if (entry->GetDestNetwork () == route.GetDestNetwork ()
+          && entry->GetDestNetworkMask () == route.GetDestNetworkMask ()
+          && entry->GetGateway () == route.GetGateway ()
+          && entry->GetInterface () == route.GetInterface ()
+          && found.find (entry) == found.end ())
+        {
+          return entry;
+        }
+    }
+  return 0;
+}
+
+void
+Ipv4GlobalRouting::RemoveRoutes (const std::vector<Ipv4RoutingTableEntry> &routes)
+{
+  NS_LOG_FUNCTION (this << routes.size ());
+  std::set<Ipv4RoutingTableEntry *> found;
+  uint32_t nHost = 0;
+  uint32_t nNetwork = 0;
+  uint32_t nExternal = 0;
+  for (std::vector<Ipv4RoutingTableEntry>::const_iterator i = routes.begin (); i != routes.end (); i++)
+    {
+      Ipv4RoutingTableEntry *entry = FindRoute (m_hostTrie, *i, found);
+      if (entry != 0)
+        {
+          nHost++;
+        }
+      else if ((entry = FindRoute (m_networkTrie, *i, found)) != 0)
+        {
+          nNetwork++;
+        }
+      else if ((entry = FindRoute (m_ASexternalTrie, *i, found)) != 0)
+        {
+          nExternal++;
+        }
+      else
+        {
+          NS_LOG_LOGIC ("No route " << *i);
+          continue;
+        }
+      found.insert (entry);
+    }
+  if (!found.empty ())
+    {
+      FlushNextHopGroups ();
+    }
+  // Each list is walked until its last route to remove.
+  for (HostRoutesI i = m_hostRoutes.begin (); nHost > 0; )
+    {
+      if (found.find (*i) != found.end ())
+        {
+          m_hostTrie.Remove (*i);
+          delete *i;
+          i = m_hostRoutes.erase (i);
+          nHost--;
+        }
+      else
+        {
+          i++;
+        }
+    }
+  for (NetworkRoutesI j = m_networkRoutes.begin (); nNetwork > 0; )
+    {
+      if (found.find (*j) != found.end ())
+        {
+          m_networkTrie.Remove (*j);
+          delete *j;
+          j = m_networkRoutes.erase (j);
+          nNetwork--;
+        }
+      else
+        {
+          j++;
+        }
+    }
+  for (ASExternalRoutesI k = m_ASexternalRoutes.begin (); nExternal > 0; )
+    {
+      if (found.find (*k) != found.end ())
+        {
+          m_ASexternalTrie.Remove (*k);
+          delete *k;
+          k = m_ASexternalRoutes.erase (k);
+          nExternal--;
+        }
+      else
+        {
+          k++;
+        }
+    }
+}
+
+void
+Ipv4GlobalRouting::RemoveAllRoutes (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (HostRoutesI i = m_hostRoutes.begin (); i != m_hostRoutes.end (); i++)
+    {
+      delete *i;
+    }
+  for (NetworkRoutesI j = m_networkRoutes.begin (); j != m_networkRoutes.end (); j++)
+    {
+      delete *j;
+    }
+  for (ASExternalRoutesI k = m_ASexternalRoutes.begin (); k != m_ASexternalRoutes.end (); k++)
+    {
+      delete *k;
+    }
+  m_hostRoutes.clear ();
+  m_networkRoutes.clear ();
+  m_ASexternalRoutes.clear ();
+  m_hostTrie.Clear ();
+  m_networkTrie.Clear ();
+  m_ASexternalTrie.Clear ();
+  FlushNextHopGroups ();
+}
+
 int64_t
 Ipv4GlobalRouting::AssignStreams (int64_t stream)
 {
@@ -373,6 +735,11 @@ void
 Ipv4GlobalRouting::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_hostTrie.Clear ();
+  m_networkTrie.Clear ();
+  m_ASexternalTrie.Clear ();
+  FlushNextHopGroups ();
+  m_flowlets.clear ();
   for (HostRoutesI i = m_hostRoutes.begin (); 
        i != m_hostRoutes.end (); 
        i = m_hostRoutes.erase (i)) 
@@ -395,6 +762,21 @@ Ipv4GlobalRouting::DoDispose (void)
   Ipv4RoutingProtocol::DoDispose ();
 }
 
+bool
+Ipv4GlobalRouting::IsFlowDeterministic (void) const
+{
+  NS_LOG_FUNCTION (this);
+  // Random ECMP picks a route per packet, and flowlet ECMP keeps the
+  // time of every packet of a flow.
+  if (m_randomEcmpRouting)
+    {
+      return false;
+    }
+  return m_ecmpMode == ECMP_NONE
+         || m_ecmpMode == ECMP_FLOW_HASH
+         || m_ecmpMode == ECMP_CONSISTENT_HASH;
+}
+
 // Formatted like output of "route -n" command
 void
 Ipv4GlobalRouting::PrintRoutingTable (Ptr<OutputStreamWrapper> stream) const
@@ -460,7 +842,9 @@ Ipv4GlobalRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<Net
 // See if this is a unicast packet we have a route for.
 //
   NS_LOG_LOGIC ("Unicast destination- looking up");
-  Ptr<Ipv4Route> rtentry = LookupGlobal (header.GetDestination (), oif);
+  // Only TCP adds its header before looking a route up
+  uint32_t flow = IsFlowEcmp () ? HashFlow (header, p, header.GetProtocol () == TcpL4Protocol::PROT_NUMBER) : 0;
+  Ptr<Ipv4Route> rtentry = LookupGlobal (header.GetDestination (), oif, flow);
   if (rtentry)
     {
       sockerr = Socket::ERROR_NOTERROR;
@@ -537,7 +921,8 @@ Ipv4GlobalRouting::RouteInput  (Ptr<const Packet> p, const Ipv4Header &header, P
     }
   // Next, try to find a route
   NS_LOG_LOGIC ("Unicast destination- looking up global route");
-  Ptr<Ipv4Route> rtentry = LookupGlobal (header.GetDestination ());
+  uint32_t flow = IsFlowEcmp () ? HashFlow (header, p, true) : 0;
+  Ptr<Ipv4Route> rtentry = LookupGlobal (header.GetDestination (), 0, flow);
   if (rtentry != 0)
     {
       NS_LOG_LOGIC ("Found unicast destination- calling unicast callback");
@@ -605,6 +990,10 @@ Ipv4GlobalRouting::SetIpv4 (Ptr<Ipv4> ipv4)
   NS_LOG_FUNCTION (this << ipv4);
   NS_ASSERT (m_ipv4 == 0 && ipv4 != 0);
   m_ipv4 = ipv4;
+  // Routers hashing flows alike would make the same choices at every
+  // hop, and leave some paths unused
+  Ptr<Node> node = ipv4->GetObject<Node> ();
+  m_ecmpSalt = node != 0 ? Mix (node->GetId (), 0) : 0;
 }
 
 
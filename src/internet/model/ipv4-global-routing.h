@@ -21,6 +21,7 @@
 #define IPV4_GLOBAL_ROUTING_H
 
 #include <list>
+#include <vector>
 #include <stdint.h>
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv4-header.h"
@@ -28,6 +29,10 @@
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/ipv4-route-trie.h"
+#include "ns3/nstime.h"
+#include "ns3/hash.h"
+#include "ns3/sgi-hashmap.h"
 
 namespace ns3 {
 
@@ -63,6 +68,23 @@ class Node;
  *
  * This class deals with Ipv4 unicast routes only.
  *
+ * When several routes of equal cost lead to a destination, the EcmpMode
+ * attribute selects how packets are spread among them.  The hashed modes
+ * keep the packets of a flow, identified by its 5-tuple, on one path so
+ * that TCP does not see them reordered:
+ *
+ * - ECMP_FLOW_HASH picks the route of a flow from the hash of its
+ *   5-tuple, modulo the number of routes.
+ * - ECMP_CONSISTENT_HASH pins a flow to a route by rendezvous hashing of
+ *   the flow and of each next hop: when a route comes or goes, only the
+ *   flows through that route move.
+ * - ECMP_FLOWLET pins a flow to a random route, and moves it to another
+ *   random route when it has been idle for FlowletTimeout, which is when
+ *   it can change path without reordering (flowlet switching).
+ *
+ * The hashed modes look the routes up once per destination, in a table
+ * of next-hop groups which is flushed whenever the routes change.
+ *
  * \see Ipv4RoutingProtocol
  * \see GlobalRouteManager
  */
@@ -85,6 +107,23 @@ public:
   Ipv4GlobalRouting ();
   virtual ~Ipv4GlobalRouting ();
 
+  /// How packets are spread among equal cost routes
+  enum EcmpMode
+  {
+    ECMP_NONE,            //!< Always the first route
+    ECMP_RANDOM,          //!< A random route per packet
+    ECMP_FLOW_HASH,       //!< A route per flow, by hash of the 5-tuple
+    ECMP_CONSISTENT_HASH, //!< A route per flow, by rendezvous hashing
+    ECMP_FLOWLET          //!< A random route per burst of a flow
+  };
+
+  /// The hash function of the 5-tuple of a flow
+  enum EcmpHashFunction
+  {
+    FNV1A,   //!< Hash::Function::Fnv1a
+    MURMUR3  //!< Hash::Function::Murmur3
+  };
+
   // These methods inherited from base class
   virtual Ptr<Ipv4Route> RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<NetDevice> oif, Socket::SocketErrno &sockerr);
 
@@ -97,6 +136,7 @@ public:
   virtual void NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address);
   virtual void SetIpv4 (Ptr<Ipv4> ipv4);
   virtual void PrintRoutingTable (Ptr<OutputStreamWrapper> stream) const;
+  virtual bool IsFlowDeterministic (void) const;
 
   /**
    * \brief Add a host route to the global routing table.
@@ -216,6 +256,37 @@ public:
    */
   void RemoveRoute (uint32_t i);
 
+  /**
+   * \brief Get the host routes to a destination.
+   *
+   * \param dest The destination address.
+   * \param routes The host routes to dest, in routing table order.
+   */
+  void GetHostRoutesTo (Ipv4Address dest, std::vector<Ipv4RoutingTableEntry> &routes) const;
+
+  /**
+   * \brief Remove a set of routes from the global unicast routing table.
+   *
+   * Each route given removes one route of the table with the same
+   * destination, mask, gateway and interface, if there is one.  Host
+   * routes are searched first, then network routes, then external routes.
+   * Unlike repeated calls to RemoveRoute (), this walks the table once.
+   *
+   * \param routes The routes to remove.
+   *
+   * \see Ipv4GlobalRouting::RemoveRoute
+   */
+  void RemoveRoutes (const std::vector<Ipv4RoutingTableEntry> &routes);
+
+  /**
+   * \brief Remove all the routes from the global unicast routing table.
+   *
+   * This is faster than removing route 0 GetNRoutes () times.
+   *
+   * \see Ipv4GlobalRouting::RemoveRoute
+   */
+  void RemoveAllRoutes (void);
+
   /**
    * Assign a fixed random variable stream number to the random variables
    * used by this model.  Return the number of streams (possibly zero) that
@@ -226,6 +297,22 @@ public:
    */
   int64_t AssignStreams (int64_t stream);
 
+  /**
+   * \brief Set the hash function of the 5-tuple of a flow.
+   *
+   * \param function The hash function.
+   */
+  void SetEcmpHashFunction (enum EcmpHashFunction function);
+
+  /**
+   * \brief Get the number of next-hop groups in the table of the hashed
+   * ECMP modes.
+   *
+   * \return The number of destinations looked up since the routes last
+   * changed.
+   */
+  uint32_t GetNNextHopGroups (void) const;
+
 protected:
   void DoDispose (void);
 
@@ -236,6 +323,16 @@ private:
   bool m_respondToInterfaceEvents;
   /// A uniform random number generator for randomly routing packets among ECMP 
   Ptr<UniformRandomVariable> m_rand;
+  /// How packets are spread among equal cost routes
+  enum EcmpMode m_ecmpMode;
+  /// The hash function of the 5-tuple of a flow
+  Hasher m_hasher;
+  /// A seed mixed into the hash of the 5-tuple of a flow
+  uint32_t m_ecmpHashSeed;
+  /// A salt mixed into the hash of the 5-tuple of a flow, different on each node
+  uint32_t m_ecmpSalt;
+  /// The idle time after which a flow may change route, in ECMP_FLOWLET mode
+  Time m_flowletTimeout;
 
   /// container of Ipv4RoutingTableEntry (routes to hosts)
   typedef std::list<Ipv4RoutingTableEntry *> HostRoutes;
@@ -258,12 +355,96 @@ private:
   /// iterator of container of Ipv4RoutingTableEntry (routes to external AS)
   typedef std::list<Ipv4RoutingTableEntry *>::iterator ASExternalRoutesI;
 
-  Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif = 0);
+  /// container of the equal cost routes to a destination
+  typedef std::vector<Ipv4RoutingTableEntry *> RouteVec;
+
+  /// The next-hop groups, by destination
+  typedef sgi::hash_map<Ipv4Address, RouteVec, Ipv4AddressHash> NextHopGroups;
+
+  /// A flow pinned to a route, in ECMP_FLOWLET mode
+  struct Flowlet
+  {
+    uint32_t m_index; //!< Index of the route in the next-hop group
+    Time m_lastSeen;  //!< Time the flow last sent a packet
+  };
+
+  /// The flowlets, by hash of their flow
+  typedef sgi::hash_map<uint32_t, Flowlet> Flowlets;
+
+  /**
+   * \brief Lookup a route to a destination.
+   *
+   * \param dest The destination.
+   * \param oif The output interface, or 0 for any.
+   * \param flow The hash of the flow, used by the hashed ECMP modes.
+   * \return The route, or 0 if none.
+   */
+  Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif = 0, uint32_t flow = 0);
+
+  /**
+   * \brief Collect the routes to a destination.
+   *
+   * \param dest The destination.
+   * \param oif The output interface, or 0 for any.
+   * \param routes The routes, in order of preference.
+   */
+  void CollectRoutes (Ipv4Address dest, Ptr<NetDevice> oif, RouteVec &routes);
+
+  /**
+   * \brief Select one of the routes to a destination.
+   *
+   * \param routes The routes.
+   * \param flow The hash of the flow.
+   * \return The index of the route.
+   */
+  uint32_t SelectRoute (const RouteVec &routes, uint32_t flow);
+
+  /**
+   * \return true if the ECMP mode keeps the packets of a flow on a route.
+   */
+  bool IsFlowEcmp (void) const;
+
+  /**
+   * \brief Hash the 5-tuple of a packet.
+   *
+   * The ports are left out of the hash of a fragment, of a packet
+   * which is not TCP or UDP, and of a packet whose transport header is
+   * not yet added.
+   *
+   * \param header The IPv4 header of the packet.
+   * \param p The packet, starting with the transport header.
+   * \param ports true if the packet has its transport header.
+   * \return The hash.
+   */
+  uint32_t HashFlow (const Ipv4Header &header, Ptr<const Packet> p, bool ports);
+
+  /**
+   * \brief Flush the next-hop groups, when the routes change.
+   */
+  void FlushNextHopGroups (void);
+
+  /**
+   * Compare trie matches by the order the routes were added.
+   * \param [in] a The first route.
+   * \param [in] b The second route.
+   * \returns true if a was added before b.
+   */
+  static bool IsAddedBefore (const Ipv4RouteTrie::Route *a,
+                             const Ipv4RouteTrie::Route *b);
 
   HostRoutes m_hostRoutes;             //!< Routes to hosts
   NetworkRoutes m_networkRoutes;       //!< Routes to networks
   ASExternalRoutes m_ASexternalRoutes; //!< External routes imported
 
+  Ipv4RouteTrie m_hostTrie;            //!< Prefix index of m_hostRoutes
+  Ipv4RouteTrie m_networkTrie;         //!< Prefix index of m_networkRoutes
+  Ipv4RouteTrie m_ASexternalTrie;      //!< Prefix index of m_ASexternalRoutes
+  Ipv4RouteTrie::Matches m_matches;    //!< Lookup scratch space
+
+  NextHopGroups m_nextHopGroups;       //!< Routes by destination, for the hashed ECMP modes
+  Flowlets m_flowlets;                 //!< Flowlets, in ECMP_FLOWLET mode
+  uint32_t m_flowletSweep;             //!< Number of flowlets that triggers an idle sweep
+
   Ptr<Ipv4> m_ipv4; //!< associated IPv4 instance
 };
 
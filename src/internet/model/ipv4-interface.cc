@@ -24,6 +24,7 @@
 #include "ipv4-l3-protocol.h"
 #include "arp-l3-protocol.h"
 #include "arp-cache.h"
+#include "tcp-segmentation-offload.h"
 #include "ns3/net-device.h"
 #include "ns3/log.h"
 #include "ns3/packet.h"
@@ -273,16 +274,32 @@ Ipv4Interface::Send (Ptr<Packet> p, Ipv4Address dest)
       if (found)
         {
           NS_LOG_LOGIC ("Address Resolved.  Send.");
-          m_device->Send (p, hardwareDestination,
-                          Ipv4L3Protocol::PROT_NUMBER);
+          SendToDevice (p, hardwareDestination);
         }
     }
   else
     {
       NS_LOG_LOGIC ("Doesn't need ARP");
-      m_device->Send (p, m_device->GetBroadcast (), 
-                      Ipv4L3Protocol::PROT_NUMBER);
+      SendToDevice (p, m_device->GetBroadcast ());
+    }
+}
+
+void
+Ipv4Interface::SendToDevice (Ptr<Packet> p, const Address &dest)
+{
+  NS_LOG_FUNCTION (this << p << dest);
+  TcpSegmentationTag tag;
+  if (p->GetSize () > m_device->GetMtu () && p->PeekPacketTag (tag))
+    {
+      std::list<Ptr<Packet> > segments;
+      TcpSegmentationOffload::Segment (p, tag.GetSegmentSize (), segments);
+      for (std::list<Ptr<Packet> >::iterator i = segments.begin (); i != segments.end (); ++i)
+        {
+          m_device->Send (*i, dest, Ipv4L3Protocol::PROT_NUMBER);
+        }
+      return;
     }
+  m_device->Send (p, dest, Ipv4L3Protocol::PROT_NUMBER);
 }
 
 uint32_t
@@ -143,6 +143,9 @@ public:
    *
    * This method will eventually call the private
    * SendTo method which must be implemented by subclasses.
+   *
+   * A TCP super-segment (see TcpSegmentationTag) larger than the device
+   * MTU is cut into segments here, after the next hop is resolved.
    */ 
   void Send (Ptr<Packet> p, Ipv4Address dest);
 
@@ -186,6 +189,13 @@ private:
    */
   void DoSetup (void);
 
+  /**
+   * \brief Hand a packet to the device, cutting it first if it is a TCP
+   * super-segment larger than the device MTU.
+   * \param p packet to send
+   * \param dest hardware destination
+   */
+  void SendToDevice (Ptr<Packet> p, const Address &dest);
 
   /**
    * \brief Container for the Ipv4InterfaceAddresses.
@@ -39,6 +39,7 @@
 #include "icmpv4-l4-protocol.h"
 #include "ipv4-interface.h"
 #include "ipv4-raw-socket-impl.h"
+#include "tcp-segmentation-offload.h"
 
 namespace ns3 {
 
@@ -73,6 +74,18 @@ Ipv4L3Protocol::GetTypeId (void)
                    TimeValue (Seconds (30)),
                    MakeTimeAccessor (&Ipv4L3Protocol::m_fragmentExpirationTimeout),
                    MakeTimeChecker ())
+    .AddAttribute ("FragmentsMaxBytes",
+                   "The maximum number of fragment bytes held for reassembly. "
+                   "Beyond it, the oldest incomplete packets are dropped.",
+                   UintegerValue (4 << 20),
+                   MakeUintegerAccessor (&Ipv4L3Protocol::m_fragmentsMaxBytes),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("IdentificationLifetime",
+                   "The time after which the identification counter of an idle "
+                   "{source, destination, protocol} tuple may be forgotten.",
+                   TimeValue (Seconds (120)),
+                   MakeTimeAccessor (&Ipv4L3Protocol::m_identificationLifetime),
+                   MakeTimeChecker ())
     .AddTraceSource ("Tx",
                      "Send ipv4 packet to outgoing interface.",
                      MakeTraceSourceAccessor (&Ipv4L3Protocol::m_txTrace),
@@ -111,7 +124,27 @@ Ipv4L3Protocol::GetTypeId (void)
   return tid;
 }
 
+// The identification counters are aged when there are this many of them
+static const uint32_t IDENTIFICATION_SWEEP_MIN = 1024;
+
+size_t
+Ipv4L3Protocol::FragmentKeyHash::operator () (const FragmentKey &key) const
+{
+  uint64_t h = key.m_addresses * 0x9e3779b97f4a7c15ULL;
+  h ^= key.m_idProto * 2246822519U;
+  h *= 0xc2b2ae3d27d4eb4fULL;
+  return static_cast<size_t> (h ^ (h >> 29));
+}
+
+bool
+Ipv4L3Protocol::FragmentKeyEqual::operator () (const FragmentKey &a, const FragmentKey &b) const
+{
+  return a.m_addresses == b.m_addresses && a.m_idProto == b.m_idProto;
+}
+
 Ipv4L3Protocol::Ipv4L3Protocol()
+  : m_identificationSweep (IDENTIFICATION_SWEEP_MIN),
+    m_fragmentsBytes (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -237,19 +270,13 @@ Ipv4L3Protocol::DoDispose (void)
 
   for (MapFragments_t::iterator it = m_fragments.begin (); it != m_fragments.end (); it++)
     {
-      it->second = 0;
-    }
-
-  for (MapFragmentsTimers_t::iterator it = m_fragmentsTimers.begin (); it != m_fragmentsTimers.end (); it++)
-    {
-      if (it->second.IsRunning ())
-        {
-          it->second.Cancel ();
-        }
+      it->second.m_timeout.Cancel ();
     }
 
   m_fragments.clear ();
-  m_fragmentsTimers.clear ();
+  m_fragmentsAge.clear ();
+  m_fragmentsBytes = 0;
+  m_identification.clear ();
 
   Object::DoDispose ();
 }
@@ -635,6 +662,15 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
       tos = ipTosTag.GetTos ();
     }
 
+  // A TCP super-segment takes an identification for each segment it is
+  // cut into
+  uint16_t identifications = 1;
+  TcpSegmentationTag segmentationTag;
+  if (packet->PeekPacketTag (segmentationTag))
+    {
+      identifications = TcpSegmentationOffload::GetSegmentCount (packet, segmentationTag.GetSegmentSize ());
+    }
+
   // Handle a few cases:
   // 1) packet is destined to limited broadcast address
   // 2) packet is destined to a subnet-directed broadcast address
@@ -646,7 +682,7 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
   if (destination.IsBroadcast () || destination.IsLocalMulticast ())
     {
       NS_LOG_LOGIC ("Ipv4L3Protocol::Send case 1:  limited broadcast");
-      ipHeader = BuildHeader (source, destination, protocol, packet->GetSize (), ttl, tos, mayFragment);
+      ipHeader = BuildHeader (source, destination, protocol, packet->GetSize (), ttl, tos, mayFragment, identifications);
       uint32_t ifaceIndex = 0;
       for (Ipv4InterfaceList::iterator ifaceIter = m_interfaces.begin ();
            ifaceIter != m_interfaces.end (); ifaceIter++, ifaceIndex++)
@@ -678,7 +714,7 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
               destination.CombineMask (ifAddr.GetMask ()) == ifAddr.GetLocal ().CombineMask (ifAddr.GetMask ())   )
             {
               NS_LOG_LOGIC ("Ipv4L3Protocol::Send case 2:  subnet directed bcast to " << ifAddr.GetLocal ());
-              ipHeader = BuildHeader (source, destination, protocol, packet->GetSize (), ttl, tos, mayFragment);
+              ipHeader = BuildHeader (source, destination, protocol, packet->GetSize (), ttl, tos, mayFragment, identifications);
               Ptr<Packet> packetCopy = packet->Copy ();
               m_sendOutgoingTrace (ipHeader, packetCopy, ifaceIndex);
               packetCopy->AddHeader (ipHeader);
@@ -694,7 +730,7 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
   if (route && route->GetGateway () != Ipv4Address ())
     {
       NS_LOG_LOGIC ("Ipv4L3Protocol::Send case 3:  passed in with route");
-      ipHeader = BuildHeader (source, destination, protocol, packet->GetSize (), ttl, tos, mayFragment);
+      ipHeader = BuildHeader (source, destination, protocol, packet->GetSize (), ttl, tos, mayFragment, identifications);
       int32_t interface = GetInterfaceForDevice (route->GetOutputDevice ());
       m_sendOutgoingTrace (ipHeader, packet, interface);
       SendRealOut (route, packet->Copy (), ipHeader);
@@ -713,7 +749,7 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
   NS_LOG_LOGIC ("Ipv4L3Protocol::Send case 5:  passed in with no route " << destination);
   Socket::SocketErrno errno_; 
   Ptr<NetDevice> oif (0); // unused for now
-  ipHeader = BuildHeader (source, destination, protocol, packet->GetSize (), ttl, tos, mayFragment);
+  ipHeader = BuildHeader (source, destination, protocol, packet->GetSize (), ttl, tos, mayFragment, identifications);
   Ptr<Ipv4Route> newRoute;
   if (m_routingProtocol != 0)
     {
@@ -747,9 +783,10 @@ Ipv4L3Protocol::BuildHeader (
   uint16_t payloadSize,
   uint8_t ttl,
   uint8_t tos,
-  bool mayFragment)
+  bool mayFragment,
+  uint16_t identifications)
 {
-  NS_LOG_FUNCTION (this << source << destination << (uint16_t)protocol << payloadSize << (uint16_t)ttl << (uint16_t)tos << mayFragment);
+  NS_LOG_FUNCTION (this << source << destination << (uint16_t)protocol << payloadSize << (uint16_t)ttl << (uint16_t)tos << mayFragment << identifications);
   Ipv4Header ipHeader;
   ipHeader.SetSource (source);
   ipHeader.SetDestination (destination);
@@ -758,16 +795,26 @@ Ipv4L3Protocol::BuildHeader (
   ipHeader.SetTtl (ttl);
   ipHeader.SetTos (tos);
 
-  uint64_t src = source.Get ();
-  uint64_t dst = destination.Get ();
-  uint64_t srcDst = dst | (src << 32);
-  std::pair<uint64_t, uint8_t> key = std::make_pair (srcDst, protocol);
+  FragmentKey key;
+  key.m_addresses = uint64_t (source.Get ()) << 32 | uint64_t (destination.Get ());
+  key.m_idProto = protocol;
+
+  MapIdentification_t::iterator it = m_identification.find (key);
+  if (it == m_identification.end ())
+    {
+      if (m_identification.size () >= m_identificationSweep)
+        {
+          AgeIdentifications ();
+        }
+      Identification identification;
+      identification.m_next = 0;
+      it = m_identification.insert (std::make_pair (key, identification)).first;
+    }
+  it->second.m_lastUsed = Simulator::Now ();
 
   if (mayFragment == true)
     {
       ipHeader.SetMayFragment ();
-      ipHeader.SetIdentification (m_identification[key]);
-      m_identification[key]++;
     }
   else
     {
@@ -776,9 +823,9 @@ Ipv4L3Protocol::BuildHeader (
       // identification requirement:
       // >> Originating sources MAY set the IPv4 ID field of atomic datagrams
       //    to any value.
-      ipHeader.SetIdentification (m_identification[key]);
-      m_identification[key]++;
     }
+  ipHeader.SetIdentification (it->second.m_next);
+  it->second.m_next += identifications;
   if (Node::ChecksumEnabled ())
     {
       ipHeader.EnableChecksum ();
@@ -799,6 +846,8 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
       return;
     }
   packet->AddHeader (ipHeader);
+  // TCP super-segments are cut by the interface, not fragmented
+  TcpSegmentationTag segmentationTag;
   Ptr<NetDevice> outDev = route->GetOutputDevice ();
   int32_t interface = GetInterfaceForDevice (outDev);
   NS_ASSERT (interface >= 0);
@@ -810,7 +859,8 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
       if (outInterface->IsUp ())
         {
           NS_LOG_LOGIC ("Send to gateway " << route->GetGateway ());
-          if ( packet->GetSize () > outInterface->GetDevice ()->GetMtu () )
+          if ( packet->GetSize () > outInterface->GetDevice ()->GetMtu ()
+               && !packet->PeekPacketTag (segmentationTag) )
             {
               std::list<Ptr<Packet> > listFragments;
               DoFragmentation (packet, outInterface->GetDevice ()->GetMtu (), listFragments);
@@ -839,7 +889,8 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
       if (outInterface->IsUp ())
         {
           NS_LOG_LOGIC ("Send to destination " << ipHeader.GetDestination ());
-          if ( packet->GetSize () > outInterface->GetDevice ()->GetMtu () )
+          if ( packet->GetSize () > outInterface->GetDevice ()->GetMtu ()
+               && !packet->PeekPacketTag (segmentationTag) )
             {
               std::list<Ptr<Packet> > listFragments;
               DoFragmentation (packet, outInterface->GetDevice ()->GetMtu (), listFragments);
@@ -1342,59 +1393,88 @@ Ipv4L3Protocol::DoFragmentation (Ptr<Packet> packet, uint32_t outIfaceMtu, std::
   return;
 }
 
+void
+Ipv4L3Protocol::AgeIdentifications (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // RFC 6864: an identification only has to be unique for the maximum
+  // datagram lifetime, so the counter of an idle tuple can start over
+  Time now = Simulator::Now ();
+  for (MapIdentification_t::iterator it = m_identification.begin (); it != m_identification.end (); )
+    {
+      if (now - it->second.m_lastUsed > m_identificationLifetime)
+        {
+          m_identification.erase (it++);
+        }
+      else
+        {
+          ++it;
+        }
+    }
+  m_identificationSweep = std::max (IDENTIFICATION_SWEEP_MIN, 2 * uint32_t (m_identification.size ()));
+}
+
+uint32_t
+Ipv4L3Protocol::GetFragmentsBytes (void) const
+{
+  return m_fragmentsBytes;
+}
+
 bool
 Ipv4L3Protocol::ProcessFragment (Ptr<Packet>& packet, Ipv4Header& ipHeader, uint32_t iif)
 {
   NS_LOG_FUNCTION (this << packet << ipHeader << iif);
 
-  uint64_t addressCombination = uint64_t (ipHeader.GetSource ().Get ()) << 32 | uint64_t (ipHeader.GetDestination ().Get ());
-  uint32_t idProto = uint32_t (ipHeader.GetIdentification ()) << 16 | uint32_t (ipHeader.GetProtocol ());
-  std::pair<uint64_t, uint32_t> key;
-  bool ret = false;
-  Ptr<Packet> p = packet->Copy ();
-
-  key.first = addressCombination;
-  key.second = idProto;
-
-  Ptr<Fragments> fragments;
+  FragmentKey key;
+  key.m_addresses = uint64_t (ipHeader.GetSource ().Get ()) << 32 | uint64_t (ipHeader.GetDestination ().Get ());
+  key.m_idProto = uint32_t (ipHeader.GetIdentification ()) << 16 | uint32_t (ipHeader.GetProtocol ());
 
   MapFragments_t::iterator it = m_fragments.find (key);
   if (it == m_fragments.end ())
     {
-      fragments = Create<Fragments> ();
-      m_fragments.insert (std::make_pair (key, fragments));
-      m_fragmentsTimers[key] = Simulator::Schedule (m_fragmentExpirationTimeout,
-                                                    &Ipv4L3Protocol::HandleFragmentsTimeout, this,
-                                                    key, ipHeader, iif);
-    }
-  else
-    {
-      fragments = it->second;
+      FragmentsEntry entry;
+      entry.m_fragments = Create<Fragments> ();
+      entry.m_header = ipHeader;
+      entry.m_iif = iif;
+      entry.m_timeout = Simulator::Schedule (m_fragmentExpirationTimeout,
+                                             &Ipv4L3Protocol::HandleFragmentsTimeout, this, key);
+      entry.m_age = m_fragmentsAge.insert (m_fragmentsAge.end (), key);
+      it = m_fragments.insert (std::make_pair (key, entry)).first;
     }
+  Ptr<Fragments> fragments = it->second.m_fragments;
 
   NS_LOG_LOGIC ("Adding fragment - Size: " << packet->GetSize ( ) << " - Offset: " << (ipHeader.GetFragmentOffset ()) );
 
-  fragments->AddFragment (p, ipHeader.GetFragmentOffset (), !ipHeader.IsLastFragment () );
+  m_fragmentsBytes += fragments->AddFragment (packet, ipHeader.GetFragmentOffset (), !ipHeader.IsLastFragment () );
 
   if ( fragments->IsEntire () )
     {
       packet = fragments->GetPacket ();
-      fragments = 0;
-      m_fragments.erase (key);
-      if (m_fragmentsTimers[key].IsRunning ())
+      m_fragmentsBytes -= fragments->GetSize ();
+      it->second.m_timeout.Cancel ();
+      m_fragmentsAge.erase (it->second.m_age);
+      m_fragments.erase (it);
+      return true;
+    }
+
+  // Make room by dropping the oldest packets, this one included if need be
+  while (m_fragmentsBytes > m_fragmentsMaxBytes)
+    {
+      FragmentKey oldest = m_fragmentsAge.front ();
+      DropFragments (oldest, DROP_FRAGMENT_MEMORY);
+      if (FragmentKeyEqual () (oldest, key))
         {
-          NS_LOG_LOGIC ("Stopping WaitFragmentsTimer at " << Simulator::Now ().GetSeconds () << " due to complete packet");
-          m_fragmentsTimers[key].Cancel ();
+          break;
         }
-      m_fragmentsTimers.erase (key);
-      ret = true;
     }
-
-  return ret;
+  return false;
 }
 
 Ipv4L3Protocol::Fragments::Fragments ()
-  : m_moreFragment (0)
+  : m_lastFragment (false),
+    m_packetSize (0),
+    m_size (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -1404,27 +1484,82 @@ Ipv4L3Protocol::Fragments::~Fragments ()
   NS_LOG_FUNCTION (this);
 }
 
-void
+uint32_t
 Ipv4L3Protocol::Fragments::AddFragment (Ptr<Packet> fragment, uint16_t fragmentOffset, bool moreFragment)
 {
   NS_LOG_FUNCTION (this << fragment << fragmentOffset << moreFragment);
 
-  std::list<std::pair<Ptr<Packet>, uint16_t> >::iterator it;
+  uint32_t start = fragmentOffset;
+  uint32_t end = start + fragment->GetSize ();
 
-  for (it = m_fragments.begin (); it != m_fragments.end (); it++)
+  if (!moreFragment)
+    {
+      m_lastFragment = true;
+      m_packetSize = end;
+    }
+
+  // Insert the parts of the fragment not received yet: we do not overwrite
+  // the "old" with the "new" because we do not know when each arrived.
+  // This is different from what Linux does.
+  // It is not possible to emulate a fragmentation attack.
+  typedef std::map<uint32_t, Ptr<Packet> >::iterator Iterator;
+  Iterator next = m_fragments.upper_bound (start);
+  Iterator previous = m_fragments.end ();
+  uint32_t position = start;
+  if (next != m_fragments.begin ())
+    {
+      previous = next;
+      --previous;
+      position = std::max (position, previous->first + previous->second->GetSize ());
+    }
+  uint32_t added = 0;
+  while (position < end)
     {
-      if (it->second > fragmentOffset)
+      uint32_t gapEnd = end;
+      if (next != m_fragments.end () && next->first < end)
+        {
+          gapEnd = next->first;
+        }
+      if (position < gapEnd)
+        {
+          Ptr<Packet> part = fragment;
+          if (position != start || gapEnd != end)
+            {
+              part = fragment->CreateFragment (position - start, gapEnd - position);
+            }
+          m_fragments.insert (next, std::make_pair (position, part));
+          added += gapEnd - position;
+        }
+      if (next == m_fragments.end () || next->first >= end)
         {
           break;
         }
+      position = next->first + next->second->GetSize ();
+      ++next;
     }
+  m_size += added;
 
-  if (it == m_fragments.end ())
+  // Merge the adjacent intervals around the fragment. The packets held
+  // are not shared with anyone, so they can grow in place.
+  if (added > 0)
     {
-      m_moreFragment = moreFragment;
+      Iterator current = previous != m_fragments.end () ? previous : m_fragments.begin ();
+      Iterator following = current;
+      ++following;
+      while (following != m_fragments.end () && current->first <= end)
+        {
+          if (following->first == current->first + current->second->GetSize ())
+            {
+              current->second->AddAtEnd (following->second);
+              m_fragments.erase (following++);
+            }
+          else
+            {
+              current = following++;
+            }
+        }
     }
-
-  m_fragments.insert (it, std::pair<Ptr<Packet>, uint16_t> (fragment, fragmentOffset));
+  return added;
 }
 
 bool
@@ -1432,29 +1567,8 @@ Ipv4L3Protocol::Fragments::IsEntire () const
 {
   NS_LOG_FUNCTION (this);
 
-  bool ret = !m_moreFragment && m_fragments.size () > 0;
-
-  if (ret)
-    {
-      uint16_t lastEndOffset = 0;
-
-      for (std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_fragments.begin (); it != m_fragments.end (); it++)
-        {
-          // overlapping fragments do exist
-          NS_LOG_LOGIC ("Checking overlaps " << lastEndOffset << " - " << it->second );
-
-          if (lastEndOffset < it->second)
-            {
-              ret = false;
-              break;
-            }
-          // fragments might overlap in strange ways
-          uint16_t fragmentEnd = it->first->GetSize () + it->second;
-          lastEndOffset = std::max ( lastEndOffset, fragmentEnd );
-        }
-    }
-
-  return ret;
+  return m_lastFragment && m_fragments.size () == 1
+         && m_fragments.begin ()->first == 0 && m_size == m_packetSize;
 }
 
 Ptr<Packet>
@@ -1462,94 +1576,61 @@ Ipv4L3Protocol::Fragments::GetPacket () const
 {
   NS_LOG_FUNCTION (this);
 
-  std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_fragments.begin ();
-
-  Ptr<Packet> p = it->first->Copy ();
-  uint16_t lastEndOffset = p->GetSize ();
-  it++;
-
-  for ( ; it != m_fragments.end (); it++)
-    {
-      if ( lastEndOffset > it->second )
-        {
-          // The fragments are overlapping.
-          // We do not overwrite the "old" with the "new" because we do not know when each arrived.
-          // This is different from what Linux does.
-          // It is not possible to emulate a fragmentation attack.
-          uint32_t newStart = lastEndOffset - it->second;
-          if ( it->first->GetSize () > newStart )
-            {
-              uint32_t newSize = it->first->GetSize () - newStart;
-              Ptr<Packet> tempFragment = it->first->CreateFragment (newStart, newSize);
-              p->AddAtEnd (tempFragment);
-            }
-        }
-      else
-        {
-          NS_LOG_LOGIC ("Adding: " << *(it->first) );
-          p->AddAtEnd (it->first);
-        }
-      lastEndOffset = p->GetSize ();
-    }
-
-  return p;
+  return m_fragments.begin ()->second;
 }
 
 Ptr<Packet>
 Ipv4L3Protocol::Fragments::GetPartialPacket () const
 {
   NS_LOG_FUNCTION (this);
-  
-  std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_fragments.begin ();
-
-  Ptr<Packet> p = Create<Packet> ();
-  uint16_t lastEndOffset = 0;
-
-  if ( m_fragments.begin ()->second > 0 )
-    {
-      return p;
-    }
 
-  for ( it = m_fragments.begin (); it != m_fragments.end (); it++)
+  if (m_fragments.empty () || m_fragments.begin ()->first > 0)
     {
-      if ( lastEndOffset > it->second )
-        {
-          uint32_t newStart = lastEndOffset - it->second;
-          uint32_t newSize = it->first->GetSize () - newStart;
-          Ptr<Packet> tempFragment = it->first->CreateFragment (newStart, newSize);
-          p->AddAtEnd (tempFragment);
-        }
-      else if ( lastEndOffset == it->second )
-        {
-          NS_LOG_LOGIC ("Adding: " << *(it->first) );
-          p->AddAtEnd (it->first);
-        }
-      lastEndOffset = p->GetSize ();
+      return Create<Packet> ();
     }
+  return m_fragments.begin ()->second->Copy ();
+}
 
-  return p;
+uint32_t
+Ipv4L3Protocol::Fragments::GetSize () const
+{
+  return m_size;
 }
 
 void
-Ipv4L3Protocol::HandleFragmentsTimeout (std::pair<uint64_t, uint32_t> key, Ipv4Header & ipHeader, uint32_t iif)
+Ipv4L3Protocol::HandleFragmentsTimeout (FragmentKey key)
 {
-  NS_LOG_FUNCTION (this << &key << &ipHeader << iif);
+  NS_LOG_FUNCTION (this);
 
   MapFragments_t::iterator it = m_fragments.find (key);
-  Ptr<Packet> packet = it->second->GetPartialPacket ();
+  Ptr<Packet> packet = it->second.m_fragments->GetPartialPacket ();
 
   // if we have at least 8 bytes, we can send an ICMP.
   if ( packet->GetSize () > 8 )
     {
       Ptr<Icmpv4L4Protocol> icmp = GetIcmp ();
-      icmp->SendTimeExceededTtl (ipHeader, packet);
+      icmp->SendTimeExceededTtl (it->second.m_header, packet);
     }
-  m_dropTrace (ipHeader, packet, DROP_FRAGMENT_TIMEOUT, m_node->GetObject<Ipv4> (), iif);
+  DropFragments (key, DROP_FRAGMENT_TIMEOUT);
+}
+
+void
+Ipv4L3Protocol::DropFragments (FragmentKey key, DropReason reason)
+{
+  NS_LOG_FUNCTION (this << reason);
+
+  MapFragments_t::iterator it = m_fragments.find (key);
+  FragmentsEntry& entry = it->second;
+  Ptr<Packet> packet = entry.m_fragments->GetPartialPacket ();
+  m_fragmentsBytes -= entry.m_fragments->GetSize ();
+  entry.m_timeout.Cancel ();
+  m_fragmentsAge.erase (entry.m_age);
+  Ipv4Header ipHeader = entry.m_header;
+  uint32_t iif = entry.m_iif;
 
   // clear the buffers
-  it->second = 0;
+  m_fragments.erase (it);
 
-  m_fragments.erase (key);
-  m_fragmentsTimers.erase (key);
+  m_dropTrace (ipHeader, packet, reason, m_node->GetObject<Ipv4> (), iif);
 }
 } // namespace ns3
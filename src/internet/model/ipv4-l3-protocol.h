@@ -34,6 +34,7 @@
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/nstime.h"
 #include "ns3/simulator.h"
+#include "ns3/sgi-hashmap.h"
 
 class Ipv4L3ProtocolTestCase;
 
@@ -100,7 +101,8 @@ public:
     DROP_BAD_CHECKSUM,   /**< Bad checksum */
     DROP_INTERFACE_DOWN,   /**< Interface is down so can not send packet */
     DROP_ROUTE_ERROR,   /**< Route error */
-    DROP_FRAGMENT_TIMEOUT /**< Fragment timeout exceeded */
+    DROP_FRAGMENT_TIMEOUT, /**< Fragment timeout exceeded */
+    DROP_FRAGMENT_MEMORY /**< Fragments evicted to bound the reassembly memory */
   };
 
   /**
@@ -237,6 +239,17 @@ public:
    */
   bool IsUnicast (Ipv4Address ad) const;
 
+  /**
+   * \brief Get the memory taken by the packets waiting for reassembly.
+   *
+   * When it would exceed the FragmentsMaxBytes attribute, the oldest
+   * incomplete packets are dropped, through the Drop trace source with
+   * DROP_FRAGMENT_MEMORY as the reason.
+   *
+   * \return the number of fragment bytes held
+   */
+  uint32_t GetFragmentsBytes (void) const;
+
   /**
    * TracedCallback signature for packet send, forward, or local deliver events.
    *
@@ -316,6 +329,8 @@ private:
    * \param ttl Time to Live
    * \param tos Type of Service
    * \param mayFragment true if the packet can be fragmented
+   * \param identifications number of identifications the packet takes:
+   *        more than one for a TCP super-segment, one per segment
    * \return newly created IPv4 header
    */
   Ipv4Header BuildHeader (
@@ -325,7 +340,8 @@ private:
     uint16_t payloadSize,
     uint8_t ttl,
     uint8_t tos,
-    bool mayFragment);
+    bool mayFragment,
+    uint16_t identifications);
 
   /**
    * \brief Send packet with route.
@@ -412,20 +428,67 @@ private:
 
   /**
    * \brief Process a packet fragment
-   * \param packet the packet
+   * \param packet the packet, which is kept until the packet is complete;
+   *        on completion, it is replaced by the complete packet
    * \param ipHeader the IP header
    * \param iif Input Interface
    * \return true is the fragment completed the packet
    */
   bool ProcessFragment (Ptr<Packet>& packet, Ipv4Header & ipHeader, uint32_t iif);
 
+  /**
+   * \brief Key of the reassembly state of a packet, and of the
+   * identification counter of a {src, dst, proto} tuple.
+   */
+  struct FragmentKey
+  {
+    uint64_t m_addresses; //!< Source and destination addresses.
+    uint32_t m_idProto;   //!< Identification and protocol (protocol only for the counters).
+  };
+
+  /**
+   * \brief Hash function of FragmentKey.
+   */
+  struct FragmentKeyHash
+  {
+    /**
+     * \param key the key
+     * \return the hash of the key
+     */
+    size_t operator () (const FragmentKey &key) const;
+  };
+
+  /**
+   * \brief Equality of FragmentKey.
+   */
+  struct FragmentKeyEqual
+  {
+    /**
+     * \param a the first key
+     * \param b the second key
+     * \return true if the keys are equal
+     */
+    bool operator () (const FragmentKey &a, const FragmentKey &b) const;
+  };
+
   /**
    * \brief Process the timeout for packet fragments
    * \param key representing the packet fragments
-   * \param ipHeader the IP header of the original packet
-   * \param iif Input Interface
    */
-  void HandleFragmentsTimeout ( std::pair<uint64_t, uint32_t> key, Ipv4Header & ipHeader, uint32_t iif);
+  void HandleFragmentsTimeout (FragmentKey key);
+
+  /**
+   * \brief Drop the fragments of a packet, and report it on the Drop trace
+   * \param key representing the packet fragments
+   * \param reason the reason of the drop
+   */
+  void DropFragments (FragmentKey key, DropReason reason);
+
+  /**
+   * \brief Forget the identification counters that have not been used
+   * for IdentificationLifetime.
+   */
+  void AgeIdentifications (void);
   
   /**
    * \brief Container of the IPv4 Interfaces.
@@ -446,7 +509,21 @@ private:
   Ipv4InterfaceList m_interfaces; //!< List of IPv4 interfaces.
   uint8_t m_defaultTos;  //!< Default TOS
   uint8_t m_defaultTtl;  //!< Default TTL
-  std::map<std::pair<uint64_t, uint8_t>, uint16_t> m_identification; //!< Identification (for each {src, dst, proto} tuple)
+
+  /**
+   * \brief Identification counter of a {src, dst, proto} tuple.
+   */
+  struct Identification
+  {
+    uint16_t m_next;  //!< Next identification.
+    Time m_lastUsed;  //!< Last time the counter was used.
+  };
+  /// Identification counters, by {src, dst, proto} tuple
+  typedef sgi::hash_map<FragmentKey, Identification, FragmentKeyHash, FragmentKeyEqual> MapIdentification_t;
+
+  MapIdentification_t m_identification; //!< Identification (for each {src, dst, proto} tuple)
+  Time m_identificationLifetime; //!< Idle time after which a counter is forgotten
+  uint32_t m_identificationSweep; //!< Number of counters that triggers the next aging sweep
   Ptr<Node> m_node; //!< Node attached to stack.
 
   /// Trace of sent packets
@@ -478,6 +555,10 @@ private:
   /**
    * \class Fragments
    * \brief A Set of Fragment belonging to the same packet (src, dst, identification and proto)
+   *
+   * The fragments are kept as disjoint byte intervals of the original
+   * packet, adjacent intervals being merged as they arrive. Where fragments
+   * overlap, the bytes received first are kept.
    */
   class Fragments : public SimpleRefCount<Fragments>
   {
@@ -494,11 +575,12 @@ public:
 
     /**
      * \brief Add a fragment.
-     * \param fragment the fragment
+     * \param fragment the fragment, which is kept and may be modified
      * \param fragmentOffset the offset of the fragment
      * \param moreFragment the bit "More Fragment"
+     * \return the number of bytes the fragment added to the held ones
      */
-    void AddFragment (Ptr<Packet> fragment, uint16_t fragmentOffset, bool moreFragment);
+    uint32_t AddFragment (Ptr<Packet> fragment, uint16_t fragmentOffset, bool moreFragment);
 
     /**
      * \brief If all fragments have been added.
@@ -518,27 +600,58 @@ public:
      */
     Ptr<Packet> GetPartialPacket () const;
 
+    /**
+     * \brief Get the number of bytes held.
+     * \return the size of all the fragments, without overlaps
+     */
+    uint32_t GetSize () const;
+
 private:
     /**
-     * \brief True if other fragments will be sent.
+     * \brief True if the last fragment has been received.
+     */
+    bool m_lastFragment;
+
+    /**
+     * \brief Size of the packet, known once its last fragment is received.
+     */
+    uint32_t m_packetSize;
+
+    /**
+     * \brief Number of bytes held.
      */
-    bool m_moreFragment;
+    uint32_t m_size;
 
     /**
-     * \brief The current fragments.
+     * \brief The received intervals, by offset.
      */
-    std::list<std::pair<Ptr<Packet>, uint16_t> > m_fragments;
+    std::map<uint32_t, Ptr<Packet> > m_fragments;
 
   };
 
-  /// Container of fragments, stored as pairs(src+dst addr, src+dst port) / fragment
-  typedef std::map< std::pair<uint64_t, uint32_t>, Ptr<Fragments> > MapFragments_t;
-  /// Container of fragment timeout event, stored as pairs(src+dst addr, src+dst port) / EventId
-  typedef std::map< std::pair<uint64_t, uint32_t>, EventId > MapFragmentsTimers_t;
+  /// Reassembly order of the packets, oldest first
+  typedef std::list<FragmentKey> FragmentsAge_t;
+
+  /**
+   * \brief Reassembly state of a packet.
+   */
+  struct FragmentsEntry
+  {
+    Ptr<Fragments> m_fragments;     //!< Fragments received so far.
+    Ipv4Header m_header;            //!< IP header of the first fragment received.
+    uint32_t m_iif;                 //!< Interface of the first fragment received.
+    EventId m_timeout;              //!< Expiration event.
+    FragmentsAge_t::iterator m_age; //!< Position in the reassembly order.
+  };
+
+  /// Container of fragments, by {src, dst, identification, proto}
+  typedef sgi::hash_map<FragmentKey, FragmentsEntry, FragmentKeyHash, FragmentKeyEqual> MapFragments_t;
 
   MapFragments_t       m_fragments; //!< Fragmented packets.
+  FragmentsAge_t       m_fragmentsAge; //!< Fragmented packets, oldest first.
+  uint32_t             m_fragmentsBytes; //!< Bytes held for reassembly.
+  uint32_t             m_fragmentsMaxBytes; //!< Bound on the bytes held for reassembly.
   Time                 m_fragmentExpirationTimeout; //!< Expiration timeout
-  MapFragmentsTimers_t m_fragmentsTimers; //!< Expiration events.
 
 };
 
@@ -85,6 +85,21 @@ Ipv4ListRouting::PrintRoutingTable (Ptr<OutputStreamWrapper> stream) const
   *stream->GetStream () << std::endl;
 }
 
+bool
+Ipv4ListRouting::IsFlowDeterministic (void) const
+{
+  NS_LOG_FUNCTION (this);
+  for (Ipv4RoutingProtocolList::const_iterator i = m_routingProtocols.begin ();
+       i != m_routingProtocols.end (); i++)
+    {
+      if (!(*i).second->IsFlowDeterministic ())
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
 void
 Ipv4ListRouting::DoInitialize (void)
 {
@@ -91,6 +91,7 @@ public:
   virtual void NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address);
   virtual void SetIpv4 (Ptr<Ipv4> ipv4);
   virtual void PrintRoutingTable (Ptr<OutputStreamWrapper> stream) const;
+  virtual bool IsFlowDeterministic (void) const;
 
 protected:
   virtual void DoDispose (void);
@@ -0,0 +1,296 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ipv4-route-trie.h"
+#include "ipv4-routing-table-entry.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4RouteTrie");
+
+Ipv4RouteTrie::Ipv4RouteTrie ()
+  : m_root (0),
+    m_order (0),
+    m_n (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+Ipv4RouteTrie::~Ipv4RouteTrie ()
+{
+  NS_LOG_FUNCTION (this);
+  Delete (m_root);
+}
+
+uint32_t
+Ipv4RouteTrie::MaskOf (uint16_t length)
+{
+  return length == 0 ? 0 : 0xffffffffU << (32 - length);
+}
+
+uint32_t
+Ipv4RouteTrie::BitOf (uint32_t address, uint16_t index)
+{
+  NS_ASSERT (index < 32);
+  return (address >> (31 - index)) & 1;
+}
+
+bool
+Ipv4RouteTrie::IsContiguous (uint32_t mask)
+{
+  uint32_t inverse = ~mask;
+  return (inverse & (inverse + 1)) == 0;
+}
+
+bool
+Ipv4RouteTrie::IsBefore (const Route *a, const Route *b)
+{
+  if (a->m_length != b->m_length)
+    {
+      return a->m_length > b->m_length;
+    }
+  return a->m_order < b->m_order;
+}
+
+void
+Ipv4RouteTrie::Delete (Node *node)
+{
+  if (node != 0)
+    {
+      Delete (node->m_child[0]);
+      Delete (node->m_child[1]);
+      delete node;
+    }
+}
+
+void
+Ipv4RouteTrie::Prune (Node **link)
+{
+  Node *node = *link;
+  if (!node->m_routes.empty ()
+      || (node->m_child[0] != 0 && node->m_child[1] != 0))
+    {
+      return;
+    }
+  *link = node->m_child[0] != 0 ? node->m_child[0] : node->m_child[1];
+  delete node;
+}
+
+void
+Ipv4RouteTrie::Insert (Ipv4RoutingTableEntry *entry, uint32_t metric)
+{
+  NS_LOG_FUNCTION (this << entry << metric);
+  Ipv4Mask mask = entry->GetDestNetworkMask ();
+  Route route;
+  route.m_entry = entry;
+  route.m_metric = metric;
+  route.m_order = m_order++;
+  route.m_length = mask.GetPrefixLength ();
+  m_n++;
+  if (!IsContiguous (mask.Get ()))
+    {
+      NS_LOG_LOGIC ("Non-contiguous mask " << mask);
+      m_irregular.push_back (route);
+      return;
+    }
+
+  uint32_t prefix = entry->GetDestNetwork ().Get () & mask.Get ();
+  uint16_t length = route.m_length;
+  Node **link = &m_root;
+  while (*link != 0)
+    {
+      Node *node = *link;
+      uint16_t common = std::min (node->m_length, length);
+      uint32_t diff = (node->m_prefix ^ prefix) & MaskOf (common);
+      if (diff != 0)
+        {
+          // The prefixes diverge above both nodes: join them under a
+          // new node holding their common prefix.
+          uint16_t split = 0;
+          while (BitOf (diff, split) == 0)
+            {
+              split++;
+            }
+          Node *fork = new Node ();
+          fork->m_prefix = prefix & MaskOf (split);
+          fork->m_length = split;
+          fork->m_child[0] = fork->m_child[1] = 0;
+          Node *leaf = new Node ();
+          leaf->m_prefix = prefix;
+          leaf->m_length = length;
+          leaf->m_child[0] = leaf->m_child[1] = 0;
+          leaf->m_routes.push_back (route);
+          fork->m_child[BitOf (prefix, split)] = leaf;
+          fork->m_child[BitOf (node->m_prefix, split)] = node;
+          *link = fork;
+          return;
+        }
+      if (node->m_length == length)
+        {
+          node->m_routes.push_back (route);
+          return;
+        }
+      if (node->m_length > length)
+        {
+          // The new prefix covers this node.
+          Node *parent = new Node ();
+          parent->m_prefix = prefix;
+          parent->m_length = length;
+          parent->m_child[0] = parent->m_child[1] = 0;
+          parent->m_child[BitOf (node->m_prefix, length)] = node;
+          parent->m_routes.push_back (route);
+          *link = parent;
+          return;
+        }
+      link = &node->m_child[BitOf (prefix, node->m_length)];
+    }
+  Node *leaf = new Node ();
+  leaf->m_prefix = prefix;
+  leaf->m_length = length;
+  leaf->m_child[0] = leaf->m_child[1] = 0;
+  leaf->m_routes.push_back (route);
+  *link = leaf;
+}
+
+bool
+Ipv4RouteTrie::Remove (Ipv4RoutingTableEntry *entry)
+{
+  NS_LOG_FUNCTION (this << entry);
+  uint32_t mask = entry->GetDestNetworkMask ().Get ();
+  if (!IsContiguous (mask))
+    {
+      for (std::vector<Route>::iterator i = m_irregular.begin ();
+           i != m_irregular.end (); i++)
+        {
+          if (i->m_entry == entry)
+            {
+              m_irregular.erase (i);
+              m_n--;
+              return true;
+            }
+        }
+      return false;
+    }
+
+  uint32_t prefix = entry->GetDestNetwork ().Get () & mask;
+  uint16_t length = entry->GetDestNetworkMask ().GetPrefixLength ();
+  Node **parentLink = 0;
+  Node **link = &m_root;
+  while (*link != 0 && (*link)->m_length < length)
+    {
+      Node *node = *link;
+      if (((node->m_prefix ^ prefix) & MaskOf (node->m_length)) != 0)
+        {
+          return false;
+        }
+      parentLink = link;
+      link = &node->m_child[BitOf (prefix, node->m_length)];
+    }
+  Node *node = *link;
+  if (node == 0 || node->m_length != length || node->m_prefix != prefix)
+    {
+      return false;
+    }
+  for (std::vector<Route>::iterator i = node->m_routes.begin ();
+       i != node->m_routes.end (); i++)
+    {
+      if (i->m_entry == entry)
+        {
+          node->m_routes.erase (i);
+          m_n--;
+          Prune (link);
+          if (parentLink != 0)
+            {
+              Prune (parentLink);
+            }
+          return true;
+        }
+    }
+  return false;
+}
+
+void
+Ipv4RouteTrie::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  Delete (m_root);
+  m_root = 0;
+  m_irregular.clear ();
+  m_n = 0;
+}
+
+uint32_t
+Ipv4RouteTrie::GetN (void) const
+{
+  return m_n;
+}
+
+void
+Ipv4RouteTrie::Lookup (Ipv4Address dest, Matches &matches) const
+{
+  matches.clear ();
+  uint32_t address = dest.Get ();
+  // Nodes on the path have increasing prefix lengths, 0 to 32.
+  const Node *path[33];
+  uint32_t n = 0;
+  const Node *node = m_root;
+  while (node != 0
+         && ((address ^ node->m_prefix) & MaskOf (node->m_length)) == 0)
+    {
+      if (!node->m_routes.empty ())
+        {
+          path[n++] = node;
+        }
+      if (node->m_length == 32)
+        {
+          break;
+        }
+      node = node->m_child[BitOf (address, node->m_length)];
+    }
+  while (n > 0)
+    {
+      const std::vector<Route> &routes = path[--n]->m_routes;
+      for (std::vector<Route>::const_iterator i = routes.begin ();
+           i != routes.end (); i++)
+        {
+          matches.push_back (&*i);
+        }
+    }
+
+  if (!m_irregular.empty ())
+    {
+      bool found = false;
+      for (std::vector<Route>::const_iterator i = m_irregular.begin ();
+           i != m_irregular.end (); i++)
+        {
+          Ipv4Mask mask = i->m_entry->GetDestNetworkMask ();
+          if (mask.IsMatch (dest, i->m_entry->GetDestNetwork ()))
+            {
+              matches.push_back (&*i);
+              found = true;
+            }
+        }
+      if (found)
+        {
+          std::sort (matches.begin (), matches.end (), &Ipv4RouteTrie::IsBefore);
+        }
+    }
+}
+
+} // namespace ns3
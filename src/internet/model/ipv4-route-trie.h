@@ -0,0 +1,156 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV4_ROUTE_TRIE_H
+#define IPV4_ROUTE_TRIE_H
+
+#include <vector>
+#include <stdint.h>
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+
+class Ipv4RoutingTableEntry;
+
+/**
+ * \ingroup ipv4Routing
+ *
+ * \brief Longest prefix match index over Ipv4RoutingTableEntry objects.
+ *
+ * The routing protocols keep their routes in lists, which define the
+ * route indices seen through GetRoute() and RemoveRoute().  This class
+ * indexes the same entries in a path-compressed binary trie keyed by
+ * destination network and mask, so that a lookup visits at most one
+ * node per distinct prefix length on the path to the destination
+ * instead of every route in the table.
+ *
+ * Each route carries the sequence number of its insertion, so callers
+ * can reproduce the tie-breaking of a linear scan of their lists.
+ * Routes with a non-contiguous mask can't be placed in the trie; they
+ * are kept aside and checked on every lookup.
+ *
+ * The trie does not own the entries.
+ */
+class Ipv4RouteTrie
+{
+public:
+  /** A route stored in the trie. */
+  struct Route
+  {
+    Ipv4RoutingTableEntry *m_entry;  //!< The routing table entry.
+    uint32_t m_metric;               //!< Metric given at insertion.
+    uint32_t m_order;                //!< Insertion sequence number.
+    uint16_t m_length;               //!< Mask prefix length.
+  };
+  /** Lookup result: matching routes. */
+  typedef std::vector<const Route *> Matches;
+
+  Ipv4RouteTrie ();
+  ~Ipv4RouteTrie ();
+
+  /**
+   * Index a route.
+   * \param [in] entry The routing table entry.
+   * \param [in] metric The route metric.
+   */
+  void Insert (Ipv4RoutingTableEntry *entry, uint32_t metric = 0);
+  /**
+   * Remove a route, before the entry is deleted.
+   * \param [in] entry The routing table entry.
+   * \returns true if the entry was found.
+   */
+  bool Remove (Ipv4RoutingTableEntry *entry);
+  /** Remove all routes. */
+  void Clear (void);
+  /** \returns the number of routes indexed. */
+  uint32_t GetN (void) const;
+  /**
+   * Find the routes matching a destination.
+   *
+   * Matches are sorted by decreasing prefix length, and by insertion
+   * order among routes with the same prefix length.
+   *
+   * \param [in] dest The destination address.
+   * \param [out] matches The matching routes; cleared first.
+   */
+  void Lookup (Ipv4Address dest, Matches &matches) const;
+
+private:
+  /**
+   * Copy constructor, not implemented: the trie owns its nodes.
+   * \param [in] o The trie to copy.
+   */
+  Ipv4RouteTrie (const Ipv4RouteTrie &o);
+  /**
+   * Assignment, not implemented.
+   * \param [in] o The trie to copy.
+   * \returns this trie.
+   */
+  Ipv4RouteTrie & operator = (const Ipv4RouteTrie &o);
+
+  /** Trie node: a prefix, and the routes to exactly that prefix. */
+  struct Node
+  {
+    uint32_t m_prefix;           //!< Prefix bits, masked.
+    uint16_t m_length;           //!< Prefix length.
+    Node *m_child[2];            //!< Subtries by the next bit.
+    std::vector<Route> m_routes; //!< Routes, in insertion order.
+  };
+
+  /**
+   * Delete a subtrie.
+   * \param [in] node The subtrie root.
+   */
+  static void Delete (Node *node);
+  /**
+   * Remove a node that no longer holds routes, if it is not needed
+   * to join two subtries.
+   * \param [in,out] link The link to the node.
+   */
+  static void Prune (Node **link);
+  /**
+   * \param [in] mask A mask.
+   * \returns true if the mask is a prefix mask.
+   */
+  static bool IsContiguous (uint32_t mask);
+  /**
+   * \param [in] length A prefix length.
+   * \returns the mask of length bits.
+   */
+  static uint32_t MaskOf (uint16_t length);
+  /**
+   * \param [in] address An address.
+   * \param [in] index A bit index, 0 is the most significant.
+   * \returns the bit.
+   */
+  static uint32_t BitOf (uint32_t address, uint16_t index);
+  /**
+   * Compare two routes for Lookup() order.
+   * \param [in] a The first route.
+   * \param [in] b The second route.
+   * \returns true if a sorts before b.
+   */
+  static bool IsBefore (const Route *a, const Route *b);
+
+  Node *m_root;                   //!< Trie root.
+  std::vector<Route> m_irregular; //!< Routes with non-contiguous masks.
+  uint32_t m_order;               //!< Next insertion sequence number.
+  uint32_t m_n;                   //!< Number of routes.
+};
+
+} // namespace ns3
+
+#endif /* IPV4_ROUTE_TRIE_H */
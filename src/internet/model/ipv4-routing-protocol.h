@@ -163,6 +163,19 @@ public:
    * \param stream the ostream the Routing table is printed to
    */
   virtual void PrintRoutingTable (Ptr<OutputStreamWrapper> stream) const = 0;
+
+  /**
+   * \brief Whether RouteOutput returns the same route for all the packets
+   * of a flow sent at the same time.
+   *
+   * Sockets may then look the route up once for a batch of packets of
+   * a flow, see Socket::SendMany.  Protocols which spread the packets of
+   * a flow on several routes, or keep per-packet state in RouteOutput,
+   * must return false, which is the default.
+   *
+   * \returns true if the output route only depends on the flow
+   */
+  virtual bool IsFlowDeterministic (void) const;
 };
 
 } // namespace ns3
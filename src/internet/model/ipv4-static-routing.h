@@ -31,6 +31,7 @@
 #include "ns3/ptr.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-route-trie.h"
 
 namespace ns3 {
 
@@ -90,6 +91,7 @@ public:
   virtual void NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address);
   virtual void SetIpv4 (Ptr<Ipv4> ipv4);
   virtual void PrintRoutingTable (Ptr<OutputStreamWrapper> stream) const;
+  virtual bool IsFlowDeterministic (void) const;
 
 /**
  * \brief Add a network route to the static routing table.
@@ -430,6 +432,16 @@ private:
    */
   NetworkRoutes m_networkRoutes;
 
+  /**
+   * \brief prefix index of m_networkRoutes.
+   */
+  Ipv4RouteTrie m_networkTrie;
+
+  /**
+   * \brief scratch space for m_networkTrie lookups.
+   */
+  Ipv4RouteTrie::Matches m_matches;
+
   /**
    * \brief the forwarding table for multicast.
    */
@@ -18,6 +18,8 @@
  * Author: Sebastien Vincent <vincent@clarinet.u-strasbg.fr>
  */
 
+#include <algorithm>
+#include <iterator>
 #include "ipv6-end-point-demux.h"
 #include "ipv6-end-point.h"
 #include "ns3/log.h"
@@ -26,10 +28,26 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Ipv6EndPointDemux");
 
+size_t Ipv6EndPointDemux::PeerKeyHash::operator () (const PeerKey &key) const
+{
+  uint32_t h = Ipv6AddressHash () (key.m_peerAddr) * 2654435761U;
+  h ^= (static_cast<uint32_t> (key.m_localPort) << 16) | key.m_peerPort;
+  h *= 2246822519U;
+  return h ^ (h >> 15);
+}
+
+bool Ipv6EndPointDemux::PeerKeyEqual::operator () (const PeerKey &a, const PeerKey &b) const
+{
+  return a.m_peerAddr == b.m_peerAddr
+         && a.m_localPort == b.m_localPort
+         && a.m_peerPort == b.m_peerPort;
+}
+
 Ipv6EndPointDemux::Ipv6EndPointDemux ()
   : m_ephemeral (49152),
     m_portFirst (49152),
-    m_portLast (65535)
+    m_portLast (65535),
+    m_order (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -37,34 +55,151 @@ Ipv6EndPointDemux::Ipv6EndPointDemux ()
 Ipv6EndPointDemux::~Ipv6EndPointDemux ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  for (Ordered::iterator i = m_endPoints.begin (); i != m_endPoints.end (); i++)
     {
-      Ipv6EndPoint *endPoint = *i;
+      Ipv6EndPoint *endPoint = i->second;
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_ports.clear ();
+  m_peers.clear ();
 }
 
-bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
+Ipv6EndPointDemux::PeerKey Ipv6EndPointDemux::MakeKey (uint16_t localPort, Ipv6Address peerAddress,
+                                                       uint16_t peerPort)
 {
-  NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  PeerKey key;
+  key.m_peerAddr = peerAddress;
+  key.m_localPort = localPort;
+  key.m_peerPort = peerPort;
+  return key;
+}
+
+bool Ipv6EndPointDemux::IsPeerKnown (Ipv6Address peerAddress, uint16_t peerPort)
+{
+  return peerPort != 0 && peerAddress != Ipv6Address::GetAny ();
+}
+
+bool Ipv6EndPointDemux::IsBefore (const Ipv6EndPoint *a, const Ipv6EndPoint *b)
+{
+  return a->m_order < b->m_order;
+}
+
+void Ipv6EndPointDemux::BucketInsert (Bucket &bucket, Ipv6EndPoint *endPoint)
+{
+  bucket.insert (std::upper_bound (bucket.begin (), bucket.end (), endPoint, &IsBefore),
+                 endPoint);
+}
+
+void Ipv6EndPointDemux::BucketRemove (Bucket &bucket, Ipv6EndPoint *endPoint)
+{
+  Bucket::iterator i = std::lower_bound (bucket.begin (), bucket.end (), endPoint, &IsBefore);
+  NS_ASSERT (i != bucket.end () && *i == endPoint);
+  bucket.erase (i);
+}
+
+Ipv6EndPoint* Ipv6EndPointDemux::Insert (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  endPoint->m_demux = this;
+  endPoint->m_order = m_order++;
+  m_endPoints[endPoint->m_order] = endPoint;
+  m_ports[endPoint->GetLocalPort ()].m_all[endPoint->m_order] = endPoint;
+  IndexPeer (endPoint);
+  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  return endPoint;
+}
+
+void Ipv6EndPointDemux::IndexPeer (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  if (IsPeerKnown (endPoint->GetPeerAddress (), endPoint->GetPeerPort ()))
     {
-      if ((*i)->GetLocalPort  () == port)
+      PeerKey key = MakeKey (endPoint->GetLocalPort (), endPoint->GetPeerAddress (),
+                             endPoint->GetPeerPort ());
+      BucketInsert (m_peers[key], endPoint);
+    }
+  else
+    {
+      BucketInsert (m_ports[endPoint->GetLocalPort ()].m_wild, endPoint);
+    }
+}
+
+void Ipv6EndPointDemux::UnindexPeer (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  if (IsPeerKnown (endPoint->GetPeerAddress (), endPoint->GetPeerPort ()))
+    {
+      PeerKey key = MakeKey (endPoint->GetLocalPort (), endPoint->GetPeerAddress (),
+                             endPoint->GetPeerPort ());
+      Peers::iterator i = m_peers.find (key);
+      NS_ASSERT (i != m_peers.end ());
+      BucketRemove (i->second, endPoint);
+      if (i->second.empty ())
         {
-          return true;
+          m_peers.erase (i);
         }
     }
-  return false;
+  else
+    {
+      BucketRemove (m_ports[endPoint->GetLocalPort ()].m_wild, endPoint);
+    }
+}
+
+Ipv6EndPoint* Ipv6EndPointDemux::FindExact (Ipv6Address localAddress, uint16_t localPort,
+                                            Ipv6Address peerAddress, uint16_t peerPort)
+{
+  NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
+  const Bucket *bucket = 0;
+  if (IsPeerKnown (peerAddress, peerPort))
+    {
+      Peers::const_iterator i = m_peers.find (MakeKey (localPort, peerAddress, peerPort));
+      if (i != m_peers.end ())
+        {
+          bucket = &i->second;
+        }
+    }
+  else
+    {
+      Ports::const_iterator i = m_ports.find (localPort);
+      if (i != m_ports.end ())
+        {
+          bucket = &i->second.m_wild;
+        }
+    }
+  if (bucket == 0)
+    {
+      return 0;
+    }
+  for (Bucket::const_iterator i = bucket->begin (); i != bucket->end (); i++)
+    {
+      if ((*i)->GetLocalAddress () == localAddress
+          && (*i)->GetPeerPort () == peerPort
+          && (*i)->GetPeerAddress () == peerAddress)
+        {
+          return *i;
+        }
+    }
+  return 0;
+}
+
+bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool Ipv6EndPointDemux::LookupLocal (Ipv6Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  Ports::const_iterator p = m_ports.find (port);
+  if (p == m_ports.end ())
     {
-      if ((*i)->GetLocalPort () == port
-          && (*i)->GetLocalAddress () == addr)
+      return false;
+    }
+  for (Ordered::const_iterator i = p->second.m_all.begin (); i != p->second.m_all.end (); i++)
+    {
+      if (i->second->GetLocalAddress () == addr)
         {
           return true;
         }
@@ -81,10 +216,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate ()
       NS_LOG_WARN ("Ephemeral port allocation failed.");
       return 0;
     }
-  Ipv6EndPoint *endPoint = new Ipv6EndPoint (Ipv6Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv6EndPoint (Ipv6Address::GetAny (), port));
 }
 
 Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address)
@@ -96,10 +228,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address)
       NS_LOG_WARN ("Ephemeral port allocation failed.");
       return 0;
     }
-  Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv6EndPoint (address, port));
 }
 
 Ipv6EndPoint* Ipv6EndPointDemux::Allocate (uint16_t port)
@@ -117,49 +246,40 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address, uint16_t port)
       NS_LOG_WARN ("Duplicate address/port; failing.");
       return 0;
     }
-  Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv6EndPoint (address, port));
 }
 
 Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address localAddress, uint16_t localPort,
                                            Ipv6Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  if (FindExact (localAddress, localPort, peerAddress, peerPort) != 0)
     {
-      if ((*i)->GetLocalPort () == localPort
-          && (*i)->GetLocalAddress () == localAddress
-          && (*i)->GetPeerPort () == peerPort
-          && (*i)->GetPeerAddress () == peerAddress)
-        {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
-        }
+      NS_LOG_WARN ("No way we can allocate this end-point.");
+      /* no way we can allocate this end-point. */
+      return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
-
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-
-  return endPoint;
+  return Insert (endPoint);
 }
 
 void Ipv6EndPointDemux::DeAllocate (Ipv6EndPoint *endPoint)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  if (endPoint->m_demux != this)
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      return;
+    }
+  UnindexPeer (endPoint);
+  Ports::iterator p = m_ports.find (endPoint->GetLocalPort ());
+  p->second.m_all.erase (endPoint->m_order);
+  if (p->second.m_all.empty ())
+    {
+      m_ports.erase (p);
     }
+  m_endPoints.erase (endPoint->m_order);
+  delete endPoint;
 }
 
 /*
@@ -179,7 +299,33 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
   EndPoints retval4; /* Exact match on all 4 */
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  Ports::const_iterator port = m_ports.find (dport);
+  if (port == m_ports.end ())
+    {
+      return retval1;
+    }
+  /* Only the endpoints without a known peer, and those connected to
+     exactly the source of the packet, can match.  Merge them back in
+     allocation order so that the result lists keep their order. */
+  Bucket candidates;
+  Peers::const_iterator peers = m_peers.end ();
+  if (IsPeerKnown (saddr, sport))
+    {
+      peers = m_peers.find (MakeKey (dport, saddr, sport));
+    }
+  if (peers == m_peers.end ())
+    {
+      candidates = port->second.m_wild;
+    }
+  else
+    {
+      candidates.reserve (port->second.m_wild.size () + peers->second.size ());
+      std::merge (port->second.m_wild.begin (), port->second.m_wild.end (),
+                  peers->second.begin (), peers->second.end (),
+                  std::back_inserter (candidates), &IsBefore);
+    }
+
+  for (Bucket::const_iterator i = candidates.begin (); i != candidates.end (); i++)
     {
       Ipv6EndPoint* endP = *i;
 
@@ -195,15 +341,6 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
           continue;
         }
 
-      if (endP->GetLocalPort () != dport)
-        {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                             << " because endpoint dport "
-                                             << endP->GetLocalPort ()
-                                             << " does not match packet dport " << dport);
-          continue;
-        }
-
       if (endP->GetBoundNetDevice ())
         {
           if (!incomingInterface)
@@ -296,35 +433,36 @@ Ipv6EndPoint* Ipv6EndPointDemux::SimpleLookup (Ipv6Address dst, uint16_t dport,
   uint32_t genericity = 3;
   Ipv6EndPoint *generic = 0;
 
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  Ports::const_iterator port = m_ports.find (dport);
+  if (port == m_ports.end ())
+    {
+      return 0;
+    }
+  for (Ordered::const_iterator i = port->second.m_all.begin (); i != port->second.m_all.end (); i++)
     {
+      Ipv6EndPoint *endP = i->second;
       uint32_t tmp = 0;
 
-      if ((*i)->GetLocalPort () != dport)
-        {
-          continue;
-        }
-
-      if ((*i)->GetLocalAddress () == dst && (*i)->GetPeerPort () == sport
-          && (*i)->GetPeerAddress () == src)
+      if (endP->GetLocalAddress () == dst && endP->GetPeerPort () == sport
+          && endP->GetPeerAddress () == src)
         {
           /* this is an exact match. */
-          return *i;
+          return endP;
         }
 
-      if ((*i)->GetLocalAddress () == Ipv6Address::GetAny ())
+      if (endP->GetLocalAddress () == Ipv6Address::GetAny ())
         {
           tmp++;
         }
 
-      if ((*i)->GetPeerAddress () == Ipv6Address::GetAny ())
+      if (endP->GetPeerAddress () == Ipv6Address::GetAny ())
         {
           tmp++;
         }
 
       if (tmp < genericity)
         {
-          generic = (*i);
+          generic = endP;
           genericity = tmp;
         }
     }
@@ -355,7 +493,12 @@ uint16_t Ipv6EndPointDemux::AllocateEphemeralPort ()
 
 Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::GetEndPoints () const
 {
-  return m_endPoints;
+  EndPoints ret;
+  for (Ordered::const_iterator i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+    {
+      ret.push_back (i->second);
+    }
+  return ret;
 }
 
 } /* namespace ns3 */
@@ -23,8 +23,11 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
+#include <vector>
 #include "ns3/ipv6-address.h"
-#include "ipv6-interface.h"
+#include "ns3/sgi-hashmap.h"
+#include "ns3/ipv6-interface.h"
 
 namespace ns3 {
 
@@ -33,6 +36,11 @@ class Ipv6EndPoint;
 /**
  * \class Ipv6EndPointDemux
  * \brief Demultiplexor for end points.
+ *
+ * As in Ipv4EndPointDemux, the end points are indexed by local port, and
+ * those with a known peer are hashed by local port, peer address and peer
+ * port, so that a lookup does not scan the connected end points of other
+ * peers.
  */
 class Ipv6EndPointDemux
 {
@@ -146,6 +154,142 @@ public:
   EndPoints GetEndPoints () const;
 
 private:
+  friend class Ipv6EndPoint;
+
+  /**
+   * \brief Key of the endpoints with a known peer.
+   */
+  struct PeerKey
+  {
+    Ipv6Address m_peerAddr; //!< Peer address.
+    uint16_t m_localPort;   //!< Local port.
+    uint16_t m_peerPort;    //!< Peer port.
+  };
+
+  /**
+   * \brief Hash function of PeerKey.
+   */
+  struct PeerKeyHash
+  {
+    /**
+     * \param key the key
+     * \return the hash of the key
+     */
+    size_t operator () (const PeerKey &key) const;
+  };
+
+  /**
+   * \brief Equality of PeerKey.
+   */
+  struct PeerKeyEqual
+  {
+    /**
+     * \param a the first key
+     * \param b the second key
+     * \return true if the keys are equal
+     */
+    bool operator () (const PeerKey &a, const PeerKey &b) const;
+  };
+
+  /**
+   * \brief Endpoints sorted by allocation order.
+   */
+  typedef std::map<uint64_t, Ipv6EndPoint *> Ordered;
+
+  /**
+   * \brief A few endpoints, sorted by allocation order.
+   */
+  typedef std::vector<Ipv6EndPoint *> Bucket;
+
+  /**
+   * \brief Endpoints bound to a local port.
+   */
+  struct Port
+  {
+    Ordered m_all;  //!< All the endpoints.
+    Bucket m_wild;  //!< The endpoints without a known peer.
+  };
+
+  /**
+   * \brief Endpoints by local port.
+   */
+  typedef std::map<uint16_t, Port> Ports;
+
+  /**
+   * \brief Endpoints with a known peer, by PeerKey.
+   */
+  typedef sgi::hash_map<PeerKey, Bucket, PeerKeyHash, PeerKeyEqual> Peers;
+
+  /**
+   * \brief Build the key of a peer.
+   * \param localPort local port
+   * \param peerAddress peer address
+   * \param peerPort peer port
+   * \return the key
+   */
+  static PeerKey MakeKey (uint16_t localPort, Ipv6Address peerAddress,
+                          uint16_t peerPort);
+
+  /**
+   * \brief Check if a peer is fully specified.
+   * \param peerAddress peer address
+   * \param peerPort peer port
+   * \return true if neither the address nor the port is a wildcard
+   */
+  static bool IsPeerKnown (Ipv6Address peerAddress, uint16_t peerPort);
+
+  /**
+   * \brief Compare endpoints by allocation order.
+   * \param a the first endpoint
+   * \param b the second endpoint
+   * \return true if a was allocated before b
+   */
+  static bool IsBefore (const Ipv6EndPoint *a, const Ipv6EndPoint *b);
+
+  /**
+   * \brief Insert an endpoint in a bucket, keeping the allocation order.
+   * \param bucket the bucket
+   * \param endPoint the endpoint
+   */
+  static void BucketInsert (Bucket &bucket, Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Remove an endpoint from a bucket.
+   * \param bucket the bucket
+   * \param endPoint the endpoint
+   */
+  static void BucketRemove (Bucket &bucket, Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Add a new endpoint to the demux.
+   * \param endPoint the endpoint
+   * \return the endpoint
+   */
+  Ipv6EndPoint *Insert (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Index an endpoint by its peer.
+   * \param endPoint the endpoint
+   */
+  void IndexPeer (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Remove an endpoint from the peer index, before its peer changes.
+   * \param endPoint the endpoint
+   */
+  void UnindexPeer (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Find an endpoint matching exactly a four-tuple.
+   * \param localAddress local address
+   * \param localPort local port
+   * \param peerAddress peer address
+   * \param peerPort peer port
+   * \return the endpoint, or 0 if not found
+   */
+  Ipv6EndPoint *FindExact (Ipv6Address localAddress, uint16_t localPort,
+                           Ipv6Address peerAddress, uint16_t peerPort);
+
   /**
    * \brief Allocate a ephemeral port.
    * \return a port
@@ -168,9 +312,24 @@ private:
   uint16_t m_portLast;
 
   /**
-   * \brief A list of IPv6 end points.
+   * \brief The allocation order of the next end point.
+   */
+  uint64_t m_order;
+
+  /**
+   * \brief All the IPv6 end points, in allocation order.
+   */
+  Ordered m_endPoints;
+
+  /**
+   * \brief The end points by local port.
+   */
+  Ports m_ports;
+
+  /**
+   * \brief The end points with a known peer.
    */
-  EndPoints m_endPoints;
+  Peers m_peers;
 };
 
 } /* namespace ns3 */
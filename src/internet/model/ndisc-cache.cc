@@ -66,6 +66,7 @@ void NdiscCache::DoDispose ()
   Flush ();
   m_device = 0;
   m_interface = 0;
+  m_staticNeighbors = 0;
   Object::DoDispose ();
 }
 
@@ -92,9 +93,17 @@ NdiscCache::Entry* NdiscCache::Lookup (Ipv6Address dst)
 {
   NS_LOG_FUNCTION (this << dst);
 
-  if (m_ndCache.find (dst) != m_ndCache.end ())
+  CacheI i = m_ndCache.find (dst);
+  if (i != m_ndCache.end ())
     {
-      NdiscCache::Entry* entry = m_ndCache[dst];
+      return i->second;
+    }
+  Address mac;
+  if (m_staticNeighbors != 0 && m_staticNeighbors->Lookup (dst, mac))
+    {
+      NS_LOG_LOGIC ("Static neighbor " << dst << " at " << mac);
+      NdiscCache::Entry* entry = Add (dst);
+      entry->MarkPermanent (mac);
       return entry;
     }
   return 0;
@@ -139,6 +148,38 @@ void NdiscCache::Flush ()
   m_ndCache.erase (m_ndCache.begin (), m_ndCache.end ());
 }
 
+void NdiscCache::SetStaticNeighbors (Ptr<StaticNeighbors> neighbors)
+{
+  NS_LOG_FUNCTION (this << neighbors);
+  m_staticNeighbors = neighbors;
+}
+
+Ptr<NdiscCache::StaticNeighbors> NdiscCache::GetStaticNeighbors (void) const
+{
+  return m_staticNeighbors;
+}
+
+void NdiscCache::StaticNeighbors::Add (Ipv6Address ipv6Address, Address macAddress)
+{
+  m_neighbors[ipv6Address] = macAddress;
+}
+
+bool NdiscCache::StaticNeighbors::Lookup (Ipv6Address ipv6Address, Address &macAddress) const
+{
+  Neighbors::const_iterator i = m_neighbors.find (ipv6Address);
+  if (i == m_neighbors.end ())
+    {
+      return false;
+    }
+  macAddress = i->second;
+  return true;
+}
+
+uint32_t NdiscCache::StaticNeighbors::GetN (void) const
+{
+  return m_neighbors.size ();
+}
+
 void NdiscCache::SetUnresQlen (uint32_t unresQlen)
 {
   NS_LOG_FUNCTION (this << unresQlen);
@@ -187,6 +228,10 @@ void NdiscCache::PrintNdiscCache (Ptr<OutputStreamWrapper> stream)
         {
           *os << " PROBE\n";
         }
+      else if (i->second->IsPermanent ())
+        {
+          *os << " PERMANENT\n";
+        }
       else
         {
           *os << " STALE\n";
@@ -495,6 +540,14 @@ void NdiscCache::Entry::MarkDelay ()
   m_state = DELAY;
 }
 
+void NdiscCache::Entry::MarkPermanent (Address mac)
+{
+  NS_LOG_FUNCTION (this << mac);
+  StopNudTimer ();
+  m_state = PERMANENT;
+  m_macAddress = mac;
+}
+
 bool NdiscCache::Entry::IsStale () const
 {
   NS_LOG_FUNCTION_NOARGS ();
@@ -525,6 +578,12 @@ bool NdiscCache::Entry::IsProbe () const
   return (m_state == PROBE);
 }
 
+bool NdiscCache::Entry::IsPermanent () const
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return (m_state == PERMANENT);
+}
+
 Address NdiscCache::Entry::GetMacAddress () const
 {
   NS_LOG_FUNCTION_NOARGS ();
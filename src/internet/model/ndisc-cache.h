@@ -29,6 +29,7 @@
 #include "ns3/net-device.h"
 #include "ns3/ipv6-address.h"
 #include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
 #include "ns3/timer.h"
 #include "ns3/sgi-hashmap.h"
 #include "ns3/output-stream-wrapper.h"
@@ -105,6 +106,65 @@ public:
    */
   void Flush ();
 
+  /**
+   * \class StaticNeighbors
+   * \brief The addresses of a link that are resolved without Neighbor Discovery.
+   *
+   * A table is shared by the caches of all the interfaces on a link.
+   */
+  class StaticNeighbors : public SimpleRefCount<StaticNeighbors>
+  {
+public:
+    /**
+     * \brief Add or replace a neighbor.
+     * \param ipv6Address the IPv6 address of the neighbor
+     * \param macAddress its MAC address
+     */
+    void Add (Ipv6Address ipv6Address, Address macAddress);
+
+    /**
+     * \brief Look a neighbor up.
+     * \param ipv6Address the IPv6 address of the neighbor
+     * \param macAddress set to its MAC address, if found
+     * \return true if the neighbor is in the table
+     */
+    bool Lookup (Ipv6Address ipv6Address, Address &macAddress) const;
+
+    /**
+     * \brief Get the number of neighbors.
+     * \return the number of neighbors in the table
+     */
+    uint32_t GetN (void) const;
+
+private:
+    /**
+     * \brief Neighbors container.
+     */
+    typedef sgi::hash_map<Ipv6Address, Address, Ipv6AddressHash> Neighbors;
+
+    /**
+     * \brief MAC addresses, by IPv6 address.
+     */
+    Neighbors m_neighbors;
+  };
+
+  /**
+   * \brief Set the static neighbors of the link of this cache.
+   *
+   * A lookup that misses the cache but hits the table adds a PERMANENT
+   * entry to the cache, which Neighbor Discovery never changes and which
+   * runs no timer.
+   *
+   * \param neighbors the static neighbors, or 0 to use Neighbor Discovery only
+   */
+  void SetStaticNeighbors (Ptr<StaticNeighbors> neighbors);
+
+  /**
+   * \brief Get the static neighbors of the link of this cache.
+   * \return the static neighbors, if any
+   */
+  Ptr<StaticNeighbors> GetStaticNeighbors (void) const;
+
   /**
    * \brief Set the max number of waiting packet.
    * \param unresQlen value to set
@@ -184,6 +244,12 @@ public:
      */
     void MarkDelay ();
 
+    /**
+     * \brief Change the state to this entry to PERMANENT.
+     * \param mac MAC address
+     */
+    void MarkPermanent (Address mac);
+
     /**
      * \brief Add a packet (or replace old value) in the queue.
      * \param p packet to add
@@ -225,6 +291,12 @@ public:
      */
     bool IsProbe () const;
 
+    /**
+     * \brief Is the entry PERMANENT
+     * \return true if the entry is in PERMANENT state, false otherwise
+     */
+    bool IsPermanent () const;
+
     /**
      * \brief Get the MAC address of this entry.
      * \return the L2 address
@@ -328,7 +400,8 @@ private:
       REACHABLE, /**< Mapping exists between IPv6 and L2 addresses */
       STALE, /**< Mapping is stale */
       DELAY, /**< Try to wait contact from remote host */
-      PROBE /**< Try to contact IPv6 address to know again its L2 address */
+      PROBE, /**< Try to contact IPv6 address to know again its L2 address */
+      PERMANENT /**< Static mapping, not subject to Neighbor Unreachability Detection */
     };
 
     /**
@@ -417,6 +490,11 @@ private:
    */
   Cache m_ndCache;
 
+  /**
+   * \brief The static neighbors of the link.
+   */
+  Ptr<StaticNeighbors> m_staticNeighbors;
+
   /**
    * \brief Max number of packet stored in m_waiting.
    */
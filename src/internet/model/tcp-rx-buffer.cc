@@ -18,6 +18,8 @@
  * Author: Adrian Sai-wah Tam <adrian.sw.tam@gmail.com>
  */
 
+#include <algorithm>
+
 #include "ns3/packet.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
@@ -52,7 +54,8 @@ TcpRxBuffer::GetTypeId (void)
  * initialized below is insignificant.
  */
 TcpRxBuffer::TcpRxBuffer (uint32_t n)
-  : m_nextRxSeq (n), m_gotFin (false), m_size (0), m_maxBuffer (32768), m_availBytes (0)
+  : m_nextRxSeq (n), m_gotFin (false), m_size (0), m_maxBuffer (32768), m_availBytes (0),
+    m_headSeq (n)
 {
 }
 
@@ -114,9 +117,13 @@ TcpRxBuffer::MaxRxSequence (void) const
     { // No data allowed beyond FIN
       return m_finSeq;
     }
-  else if (m_data.size ())
+  else if (m_availBytes > 0)
     { // No data allowed beyond Rx window allowed
-      return m_data.begin ()->first + SequenceNumber32 (m_maxBuffer);
+      return m_headSeq + SequenceNumber32 (m_maxBuffer);
+    }
+  else if (!m_blocks.empty ())
+    {
+      return m_blocks.begin ()->first + SequenceNumber32 (m_maxBuffer);
     }
   return m_nextRxSeq + SequenceNumber32 (m_maxBuffer);
 }
@@ -150,74 +157,169 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
 
   // Trim packet to fit Rx window specification
   if (headSeq < m_nextRxSeq) headSeq = m_nextRxSeq;
-  if (m_data.size ())
+  if (m_size > 0)
     {
-      SequenceNumber32 maxSeq = m_data.begin ()->first + SequenceNumber32 (m_maxBuffer);
+      SequenceNumber32 firstSeq = m_availBytes > 0 ? m_headSeq : m_blocks.begin ()->first;
+      SequenceNumber32 maxSeq = firstSeq + SequenceNumber32 (m_maxBuffer);
       if (maxSeq < tailSeq) tailSeq = maxSeq;
       if (tailSeq < headSeq) headSeq = tailSeq;
     }
-  // Remove overlapped bytes from packet
-  BufIterator i = m_data.begin ();
-  while (i != m_data.end () && i->first <= tailSeq)
+  // Store the parts of the packet in the gaps between the buffered blocks.
+  // The data before m_nextRxSeq is already there.
+  bool added = false;
+  SequenceNumber32 seq = headSeq;
+  while (seq < tailSeq)
     {
-      SequenceNumber32 lastByteSeq = i->first + SequenceNumber32 (i->second->GetSize ());
-      if (lastByteSeq > headSeq)
+      if (seq < m_nextRxSeq)
+        { // Absorbed by the in-sequence data when a gap was filled
+          seq = m_nextRxSeq;
+          continue;
+        }
+      Blocks::iterator next = m_blocks.upper_bound (seq);
+      if (next != m_blocks.begin ())
         {
-          if (i->first > headSeq && lastByteSeq < tailSeq)
-            { // Rare case: Existing packet is embedded fully in the new packet
-              m_size -= i->second->GetSize ();
-              m_data.erase (i++);
+          Blocks::iterator prev = next;
+          --prev;
+          if (prev->second.m_end > seq)
+            { // Already buffered
+              seq = prev->second.m_end;
               continue;
             }
-          if (i->first <= headSeq)
-            { // Incoming head is overlapped
-              headSeq = lastByteSeq;
-            }
-          if (lastByteSeq >= tailSeq)
-            { // Incoming tail is overlapped
-              tailSeq = i->first;
-            }
         }
-      ++i;
+      SequenceNumber32 end = tailSeq;
+      if (next != m_blocks.end () && next->first < end)
+        {
+          end = next->first;
+        }
+      uint32_t start = seq - tcph.GetSequenceNumber ();
+      uint32_t length = end - seq;
+      Insert (seq, (start == 0 && length == pktSize) ? p : p->CreateFragment (start, length));
+      NS_LOG_LOGIC ("Buffered packet of seqno=" << seq << " len=" << length);
+      added = true;
+      seq = end;
     }
-  // We now know how much we are going to store, trim the packet
-  if (headSeq >= tailSeq)
+  UpdateSackList (headSeq);
+  if (!added)
     {
       NS_LOG_LOGIC ("Nothing to buffer");
       return false; // Nothing to buffer anyway
     }
-  else
+  NS_LOG_LOGIC ("Updated buffer occupancy=" << m_size << " nextRxSeq=" << m_nextRxSeq);
+  if (m_gotFin && m_nextRxSeq == m_finSeq)
+    { // Account for the FIN packet
+      ++m_nextRxSeq;
+    };
+  return true;
+}
+
+void
+TcpRxBuffer::Insert (const SequenceNumber32& seq, Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << seq << p);
+  uint32_t length = p->GetSize ();
+  SequenceNumber32 end = seq + SequenceNumber32 (length);
+  m_size += length;
+  if (seq == m_nextRxSeq)
+    { // In sequence: available to read, with the block it joins, if any
+      if (m_availBytes == 0)
+        {
+          m_headSeq = seq;
+        }
+      m_ready.push_back (p);
+      m_availBytes += length;
+      Blocks::iterator next = m_blocks.begin ();
+      if (next != m_blocks.end () && next->first == end)
+        {
+          m_ready.splice (m_ready.end (), next->second.m_data);
+          m_availBytes += next->second.m_end - next->first;
+          end = next->second.m_end;
+          m_blocks.erase (next);
+        }
+      m_nextRxSeq = end;
+      return;
+    }
+  Blocks::iterator next = m_blocks.lower_bound (seq);
+  Blocks::iterator prev = m_blocks.end ();
+  if (next != m_blocks.begin ())
+    {
+      prev = next;
+      --prev;
+      if (prev->second.m_end != seq)
+        {
+          prev = m_blocks.end ();
+        }
+    }
+  if (next != m_blocks.end () && next->first != end)
     {
-      uint32_t start = headSeq - tcph.GetSequenceNumber ();
-      uint32_t length = tailSeq - headSeq;
-      p = p->CreateFragment (start, length);
-      NS_ASSERT (length == p->GetSize ());
+      next = m_blocks.end ();
+    }
+  if (prev != m_blocks.end ())
+    { // Extends the previous block, and joins the next one if the gap is filled
+      prev->second.m_data.push_back (p);
+      prev->second.m_end = end;
+      if (next != m_blocks.end ())
+        {
+          prev->second.m_data.splice (prev->second.m_data.end (), next->second.m_data);
+          prev->second.m_end = next->second.m_end;
+          m_blocks.erase (next);
+        }
+    }
+  else
+    { // Starts a block, the next one if they are adjacent
+      Block &block = m_blocks[seq];
+      block.m_data.push_back (p);
+      block.m_end = end;
+      if (next != m_blocks.end ())
+        {
+          block.m_data.splice (block.m_data.end (), next->second.m_data);
+          block.m_end = next->second.m_end;
+          m_blocks.erase (next);
+        }
     }
-  // Insert packet into buffer
-  NS_ASSERT (m_data.find (headSeq) == m_data.end ()); // Shouldn't be there yet
-  m_data [ headSeq ] = p;
-  NS_LOG_LOGIC ("Buffered packet of seqno=" << headSeq << " len=" << p->GetSize ());
-  // Update variables
-  m_size += p->GetSize ();      // Occupancy
-  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
+}
+
+void
+TcpRxBuffer::UpdateSackList (const SequenceNumber32& seq)
+{
+  NS_LOG_FUNCTION (this << seq);
+  // The block of the most recently received segment comes first, followed
+  // by the blocks already reported, as they stand now (RFC 2018, 4)
+  SackList sackList;
+  SequenceNumber32 first = seq;
+  for (SackList::const_iterator i = m_sackList.begin (); ; ++i)
     {
-      if (i->first < m_nextRxSeq)
+      Blocks::const_iterator b = m_blocks.upper_bound (first);
+      if (b != m_blocks.begin ())
         {
-          continue;
+          --b;
+          if (b->second.m_end > first)
+            {
+              SackBlock block (b->first, b->second.m_end);
+              if (std::find (sackList.begin (), sackList.end (), block) == sackList.end ())
+                {
+                  sackList.push_back (block);
+                }
+            }
         }
-      else if (i->first > m_nextRxSeq)
+      if (i == m_sackList.end ())
         {
           break;
-        };
-      m_nextRxSeq = i->first + SequenceNumber32 (i->second->GetSize ());
-      m_availBytes += i->second->GetSize ();
+        }
+      first = i->first;
     }
-  NS_LOG_LOGIC ("Updated buffer occupancy=" << m_size << " nextRxSeq=" << m_nextRxSeq);
-  if (m_gotFin && m_nextRxSeq == m_finSeq)
-    { // Account for the FIN packet
-      ++m_nextRxSeq;
-    };
-  return true;
+  m_sackList.swap (sackList);
+}
+
+TcpRxBuffer::SackList
+TcpRxBuffer::GetSackList (void) const
+{
+  return m_sackList;
+}
+
+uint32_t
+TcpRxBuffer::GetSackListSize (void) const
+{
+  return m_sackList.size ();
 }
 
 Ptr<Packet>
@@ -228,30 +330,29 @@ TcpRxBuffer::Extract (uint32_t maxSize)
   uint32_t extractSize = std::min (maxSize, m_availBytes);
   NS_LOG_LOGIC ("Requested to extract " << extractSize << " bytes from TcpRxBuffer of size=" << m_size);
   if (extractSize == 0) return 0;  // No contiguous block to return
-  NS_ASSERT (m_data.size ()); // At least we have something to extract
+  NS_ASSERT (m_ready.size ()); // At least we have something to extract
   Ptr<Packet> outPkt = Create<Packet> (); // The packet that contains all the data to return
-  BufIterator i;
   while (extractSize)
     { // Check the buffered data for delivery
-      i = m_data.begin ();
-      NS_ASSERT (i->first <= m_nextRxSeq); // in-sequence data expected
+      Ptr<Packet> &front = m_ready.front ();
       // Check if we send the whole pkt or just a partial
-      uint32_t pktSize = i->second->GetSize ();
+      uint32_t pktSize = front->GetSize ();
       if (pktSize <= extractSize)
         { // Whole packet is extracted
-          outPkt->AddAtEnd (i->second);
-          m_data.erase (i);
+          outPkt->AddAtEnd (front);
+          m_ready.pop_front ();
           m_size -= pktSize;
           m_availBytes -= pktSize;
+          m_headSeq += pktSize;
           extractSize -= pktSize;
         }
       else
         { // Partial is extracted and done
-          outPkt->AddAtEnd (i->second->CreateFragment (0, extractSize));
-          m_data[i->first + SequenceNumber32 (extractSize)] = i->second->CreateFragment (extractSize, pktSize - extractSize);
-          m_data.erase (i);
+          outPkt->AddAtEnd (front->CreateFragment (0, extractSize));
+          front = front->CreateFragment (extractSize, pktSize - extractSize);
           m_size -= extractSize;
           m_availBytes -= extractSize;
+          m_headSeq += extractSize;
           extractSize = 0;
         }
     }
@@ -261,7 +362,7 @@ TcpRxBuffer::Extract (uint32_t maxSize)
       return 0;
     }
   NS_LOG_LOGIC ("Extracted " << outPkt->GetSize ( ) << " bytes, bufsize=" << m_size
-                             << ", num pkts in buffer=" << m_data.size ());
+                             << ", num pkts in buffer=" << m_ready.size () + m_blocks.size ());
   return outPkt;
 }
 
@@ -21,12 +21,14 @@
 #ifndef TCP_RX_BUFFER_H
 #define TCP_RX_BUFFER_H
 
+#include <list>
 #include <map>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/sequence-number.h"
 #include "ns3/ptr.h"
 #include "ns3/tcp-header.h"
+#include "ns3/tcp-option-sack.h"
 
 namespace ns3 {
 class Packet;
@@ -36,6 +38,13 @@ class Packet;
  *
  * \brief class for the reordering buffer that keeps the data from lower layer, i.e.
  *        TcpL4Protocol, sent to the application
+ *
+ * The data ready for the application is a list of packets in sequence.
+ * Out-of-order data is kept as a map of disjoint blocks of contiguous
+ * data, merged as segments fill the gaps between them, so that placing a
+ * segment costs a lookup among the blocks rather than a scan of all the
+ * buffered segments.  The blocks are reported in SACK order, the block of
+ * the most recently received segment first (RFC 2018).
  */
 class TcpRxBuffer : public Object
 {
@@ -124,16 +133,63 @@ public:
    * \returns a packet
    */
   Ptr<Packet> Extract (uint32_t maxSize);
-public:
-  /// container for data stored in the buffer
-  typedef std::map<SequenceNumber32, Ptr<Packet> >::iterator BufIterator;
+
+  /// A block of out-of-order data: the sequence numbers of its first byte and of the byte after its last
+  typedef TcpOptionSack::SackBlock SackBlock;
+  /// SACK blocks, the one of the most recently received segment first
+  typedef TcpOptionSack::SackList SackList;
+
+  /**
+   * \brief Get the blocks of out-of-order data, in the order they should be
+   * reported in a SACK option
+   * \returns the list of blocks
+   */
+  SackList GetSackList (void) const;
+
+  /**
+   * \brief Get the number of blocks of out-of-order data
+   * \returns the number of blocks
+   */
+  uint32_t GetSackListSize (void) const;
+
+private:
+  /// Contiguous data, in sequence order
+  typedef std::list<Ptr<Packet> > Segments;
+
+  /// A block of out-of-order data
+  struct Block
+  {
+    SequenceNumber32 m_end; //!< Seqnum of the byte after the block
+    Segments m_data;        //!< The data of the block
+  };
+
+  /// Out-of-order blocks, by seqnum of their first byte
+  typedef std::map<SequenceNumber32, Block> Blocks;
+
+  /**
+   * \brief Store data that is not buffered yet, merging it with the
+   * adjacent data
+   * \param seq sequence number of the first byte
+   * \param p the data
+   */
+  void Insert (const SequenceNumber32& seq, Ptr<Packet> p);
+
+  /**
+   * \brief Update the SACK list after a segment is received
+   * \param seq sequence number of the first new byte of the segment
+   */
+  void UpdateSackList (const SequenceNumber32& seq);
+
   TracedValue<SequenceNumber32> m_nextRxSeq; //!< Seqnum of the first missing byte in data (RCV.NXT)
   SequenceNumber32 m_finSeq;                 //!< Seqnum of the FIN packet
   bool m_gotFin;                             //!< Did I received FIN packet?
   uint32_t m_size;                           //!< Number of total data bytes in the buffer, not necessarily contiguous
   uint32_t m_maxBuffer;                      //!< Upper bound of the number of data bytes in buffer (RCV.WND)
   uint32_t m_availBytes;                     //!< Number of bytes available to read, i.e. contiguous block at head
-  std::map<SequenceNumber32, Ptr<Packet> > m_data; //!< Corresponding data (may be null)
+  SequenceNumber32 m_headSeq;                //!< Seqnum of the first byte available to read
+  Segments m_ready;                          //!< Data available to read
+  Blocks m_blocks;                           //!< Out-of-order data
+  SackList m_sackList;                       //!< Out-of-order blocks, in SACK order
 };
 
 } //namepsace ns3
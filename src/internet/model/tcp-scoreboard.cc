@@ -0,0 +1,451 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <algorithm>
+#include "tcp-scoreboard.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpScoreboard");
+
+TcpScoreboard::TcpScoreboard ()
+  : m_segmentSize (536),
+    m_dupThresh (3),
+    m_rackEnabled (true),
+    m_pipe (0),
+    m_sackedBytes (0),
+    m_rackXmit (Seconds (-1)),
+    m_rackRtt (Seconds (0)),
+    m_minRtt (Seconds (0))
+{
+}
+
+void
+TcpScoreboard::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_segments.clear ();
+  m_pipe = 0;
+  m_sackedBytes = 0;
+  m_rackXmit = Seconds (-1);
+  m_rackRtt = Seconds (0);
+  m_minRtt = Seconds (0);
+}
+
+void
+TcpScoreboard::SetSegmentSize (uint32_t size)
+{
+  m_segmentSize = size;
+}
+
+void
+TcpScoreboard::SetDupThresh (uint32_t dupThresh)
+{
+  m_dupThresh = dupThresh;
+}
+
+void
+TcpScoreboard::SetRack (bool enabled)
+{
+  m_rackEnabled = enabled;
+}
+
+void
+TcpScoreboard::Split (SequenceNumber32 seq)
+{
+  Segments::iterator i = m_segments.upper_bound (seq);
+  if (i == m_segments.begin ())
+    {
+      return;
+    }
+  --i;
+  if (i->first < seq && seq < i->second.m_end)
+    {
+      Segment tail = i->second;
+      i->second.m_end = seq;
+      m_segments.insert (i, std::make_pair (seq, tail));
+    }
+}
+
+uint32_t
+TcpScoreboard::InPipe (Segments::const_iterator i)
+{
+  const Segment& s = i->second;
+  if (s.m_sacked)
+    {
+      return 0;
+    }
+  uint32_t size = s.m_end - i->first;
+  return (s.m_lost ? 0 : size) + (s.m_retx ? size : 0);
+}
+
+void
+TcpScoreboard::MarkLost (Segments::iterator i)
+{
+  NS_LOG_LOGIC ("Lost [" << i->first << ";" << i->second.m_end << ")");
+  m_pipe -= InPipe (i);
+  i->second.m_lost = true;
+  i->second.m_retx = false;
+  m_pipe += InPipe (i);
+  if (i->first < m_retxHint)
+    {
+      m_retxHint = i->first;
+    }
+}
+
+void
+TcpScoreboard::Delivered (Segments::const_iterator i, Time now)
+{
+  const Segment& s = i->second;
+  Time rtt = now - s.m_sent;
+  if (s.m_retx && rtt < m_minRtt)
+    { // Likely the delivery of an earlier transmission
+      return;
+    }
+  if (m_minRtt.IsZero () || rtt < m_minRtt)
+    {
+      m_minRtt = rtt;
+    }
+  if (m_rackXmit.IsNegative () || s.m_sent > m_rackXmit
+      || (s.m_sent == m_rackXmit && s.m_end > m_rackEnd))
+    {
+      m_rackXmit = s.m_sent;
+      m_rackEnd = s.m_end;
+      m_rackRtt = rtt;
+    }
+}
+
+void
+TcpScoreboard::Sent (SequenceNumber32 seq, uint32_t size, Time now)
+{
+  NS_LOG_FUNCTION (this << seq << size);
+  if (size == 0)
+    {
+      return;
+    }
+  SequenceNumber32 end = seq + SequenceNumber32 (size);
+  if (m_segments.empty ())
+    {
+      m_highSacked = seq;
+      m_highLost = seq;
+      m_retxHint = seq;
+    }
+  else
+    {
+      SequenceNumber32 high = m_segments.rbegin ()->second.m_end;
+      if (seq < high)
+        { // Retransmission, possibly followed by new data
+          SequenceNumber32 last = std::min (end, high);
+          Split (seq);
+          Split (last);
+          for (Segments::iterator i = m_segments.lower_bound (seq);
+               i != m_segments.end () && i->first < last; ++i)
+            {
+              if (i->second.m_sacked)
+                {
+                  continue;
+                }
+              m_pipe -= InPipe (i);
+              i->second.m_sent = now;
+              i->second.m_retx = true;
+              m_pipe += InPipe (i);
+            }
+          if (end <= high)
+            {
+              return;
+            }
+          seq = high;
+        }
+    }
+  Segment s;
+  s.m_end = end;
+  s.m_sent = now;
+  s.m_sacked = false;
+  s.m_lost = false;
+  s.m_retx = false;
+  m_segments.insert (m_segments.end (), std::make_pair (seq, s));
+  m_pipe += end - seq;
+}
+
+void
+TcpScoreboard::Ack (SequenceNumber32 ack, Time now)
+{
+  NS_LOG_FUNCTION (this << ack);
+  while (!m_segments.empty () && m_segments.begin ()->first < ack)
+    {
+      Split (ack);
+      Segments::iterator i = m_segments.begin ();
+      if (i->second.m_sacked)
+        {
+          m_sackedBytes -= i->second.m_end - i->first;
+        }
+      else
+        {
+          Delivered (i, now);
+        }
+      m_pipe -= InPipe (i);
+      m_segments.erase (i);
+    }
+  if (m_highSacked < ack)
+    {
+      m_highSacked = ack;
+    }
+  if (m_highLost < ack)
+    {
+      m_highLost = ack;
+    }
+  if (m_retxHint < ack)
+    {
+      m_retxHint = ack;
+    }
+}
+
+uint32_t
+TcpScoreboard::Sack (const TcpOptionSack::SackList& blocks, Time now)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_segments.empty ())
+    {
+      return 0;
+    }
+  SequenceNumber32 low = m_segments.begin ()->first;
+  SequenceNumber32 high = m_segments.rbegin ()->second.m_end;
+  uint32_t sacked = 0;
+  for (TcpOptionSack::SackList::const_iterator b = blocks.begin (); b != blocks.end (); ++b)
+    {
+      SequenceNumber32 start = std::max (b->first, low);
+      SequenceNumber32 end = std::min (b->second, high);
+      if (end <= start)
+        { // Already acknowledged, or bogus
+          continue;
+        }
+      Split (start);
+      Split (end);
+      for (Segments::iterator i = m_segments.lower_bound (start);
+           i != m_segments.end () && i->first < end; ++i)
+        {
+          if (i->second.m_sacked)
+            {
+              continue;
+            }
+          m_pipe -= InPipe (i);
+          i->second.m_sacked = true;
+          uint32_t size = i->second.m_end - i->first;
+          m_sackedBytes += size;
+          sacked += size;
+          Delivered (i, now);
+        }
+      if (m_highSacked < end)
+        {
+          m_highSacked = end;
+        }
+    }
+  return sacked;
+}
+
+bool
+TcpScoreboard::DetectLosses (Time now, Time& timeout)
+{
+  NS_LOG_FUNCTION (this);
+  bool lost = false;
+  timeout = Seconds (0);
+
+  // RFC 6675 IsLost (): walk down from the highest SACKed data, counting the
+  // SACKed data above, down to the data already deemed lost
+  if (m_sackedBytes > 0)
+    {
+      uint32_t count = 0;
+      uint32_t bytes = 0;
+      SequenceNumber32 highLost = m_highLost;
+      Segments::iterator i = m_segments.lower_bound (m_highSacked);
+      while (i != m_segments.begin ())
+        {
+          --i;
+          if (i->second.m_end <= m_highLost)
+            {
+              break;
+            }
+          if (i->second.m_sacked)
+            {
+              ++count;
+              bytes += i->second.m_end - i->first;
+            }
+          else if (count >= m_dupThresh || bytes > (m_dupThresh - 1) * m_segmentSize)
+            {
+              if (!i->second.m_lost)
+                {
+                  MarkLost (i);
+                  lost = true;
+                }
+              if (highLost < i->second.m_end)
+                {
+                  highLost = i->second.m_end;
+                }
+            }
+        }
+      m_highLost = highLost;
+    }
+
+  // RACK: data sent a reordering window more than an RTT before the most
+  // recently sent data delivered is lost. The original transmissions are
+  // in sequence order, so the first one sent after that data ends the walk.
+  if (m_rackEnabled && !m_rackXmit.IsNegative ())
+    {
+      Time reorderingWindow = m_minRtt / 4;
+      for (Segments::iterator i = m_segments.begin (); i != m_segments.end (); ++i)
+        {
+          const Segment& s = i->second;
+          if (s.m_sacked || (s.m_lost && !s.m_retx))
+            {
+              continue;
+            }
+          if (s.m_sent > m_rackXmit || (s.m_sent == m_rackXmit && s.m_end > m_rackEnd))
+            {
+              if (!s.m_retx)
+                {
+                  break;
+                }
+              continue;
+            }
+          Time remaining = s.m_sent + m_rackRtt + reorderingWindow - now;
+          if (remaining.IsStrictlyPositive ())
+            {
+              timeout = std::max (timeout, remaining);
+            }
+          else
+            {
+              MarkLost (i);
+              lost = true;
+            }
+        }
+    }
+  return lost;
+}
+
+void
+TcpScoreboard::MarkAllLost (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (Segments::iterator i = m_segments.begin (); i != m_segments.end (); ++i)
+    {
+      if (!i->second.m_sacked && (!i->second.m_lost || i->second.m_retx))
+        {
+          MarkLost (i);
+        }
+    }
+  if (!m_segments.empty ())
+    {
+      m_highLost = m_segments.rbegin ()->second.m_end;
+      m_retxHint = m_segments.begin ()->first;
+    }
+}
+
+bool
+TcpScoreboard::GetNextLost (SequenceNumber32& seq, uint32_t& length)
+{
+  Segments::iterator i = m_segments.upper_bound (m_retxHint);
+  if (i != m_segments.begin ())
+    {
+      --i;
+    }
+  for (; i != m_segments.end (); ++i)
+    {
+      const Segment& s = i->second;
+      if (s.m_lost && !s.m_retx && !s.m_sacked)
+        {
+          seq = i->first;
+          m_retxHint = seq;
+          SequenceNumber32 end = s.m_end;
+          for (Segments::const_iterator j = ++i; j != m_segments.end (); ++j)
+            {
+              if (j->first != end || !j->second.m_lost || j->second.m_retx || j->second.m_sacked)
+                {
+                  break;
+                }
+              end = j->second.m_end;
+            }
+          length = end - seq;
+          return true;
+        }
+    }
+  if (!m_segments.empty ())
+    {
+      m_retxHint = m_segments.rbegin ()->second.m_end;
+    }
+  return false;
+}
+
+SequenceNumber32
+TcpScoreboard::SkipSacked (SequenceNumber32 seq) const
+{
+  Segments::const_iterator i = m_segments.upper_bound (seq);
+  if (i == m_segments.begin ())
+    {
+      return seq;
+    }
+  --i;
+  while (i != m_segments.end () && i->first <= seq && seq < i->second.m_end && i->second.m_sacked)
+    {
+      seq = i->second.m_end;
+      ++i;
+    }
+  return seq;
+}
+
+uint32_t
+TcpScoreboard::UnsackedLength (SequenceNumber32 seq, uint32_t maxSize) const
+{
+  Segments::const_iterator i = m_segments.upper_bound (seq);
+  if (i != m_segments.begin ())
+    {
+      Segments::const_iterator prev = i;
+      --prev;
+      if (seq < prev->second.m_end && prev->second.m_sacked)
+        {
+          return 0;
+        }
+    }
+  for (; i != m_segments.end () && static_cast<uint32_t> (i->first - seq) < maxSize; ++i)
+    {
+      if (i->second.m_sacked)
+        {
+          return i->first - seq;
+        }
+    }
+  return maxSize;
+}
+
+uint32_t
+TcpScoreboard::GetPipe (void) const
+{
+  return m_pipe;
+}
+
+uint32_t
+TcpScoreboard::GetSackedBytes (void) const
+{
+  return m_sackedBytes;
+}
+
+Time
+TcpScoreboard::GetMinRtt (void) const
+{
+  return m_minRtt;
+}
+
+} // namespace ns3
@@ -0,0 +1,212 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef TCP_SCOREBOARD_H
+#define TCP_SCOREBOARD_H
+
+#include <map>
+#include "ns3/nstime.h"
+#include "ns3/sequence-number.h"
+#include "ns3/tcp-option-sack.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Sender-side record of the data in flight, for SACK-based loss
+ * recovery.
+ *
+ * The scoreboard keeps, for every range of data sent and not cumulatively
+ * acknowledged, when it was last sent and whether it was SACKed, deemed
+ * lost or retransmitted. Ranges are split as ACKs, SACK blocks and
+ * retransmissions cut them.
+ *
+ * Two loss detectors mark the ranges lost:
+ * - the IsLost() rule of \RFC{6675}: data with DupThresh SACKed segments,
+ *   or more than (DupThresh - 1) * SMSS SACKed bytes, above it;
+ * - RACK (\RFC{8985}): data sent more than one RTT plus a reordering window
+ *   before the most recently sent data that was delivered.
+ *
+ * The pipe (\RFC{6675}) counts the bytes neither SACKed nor lost, plus the
+ * bytes retransmitted, and is updated as the ranges change.
+ */
+class TcpScoreboard
+{
+public:
+  TcpScoreboard ();
+
+  /**
+   * \brief Forget all the data and measurements.
+   */
+  void Clear (void);
+
+  /**
+   * \brief Set the sender maximum segment size
+   * \param size the segment size, in bytes
+   */
+  void SetSegmentSize (uint32_t size);
+
+  /**
+   * \brief Set the number of SACKed segments above a hole to deem it lost
+   * \param dupThresh the threshold (3 in \RFC{6675})
+   */
+  void SetDupThresh (uint32_t dupThresh);
+
+  /**
+   * \brief Enable or disable RACK loss detection
+   * \param enabled true to enable RACK
+   */
+  void SetRack (bool enabled);
+
+  /**
+   * \brief Record a transmission or a retransmission
+   * \param seq the first sequence number sent
+   * \param size the number of bytes sent
+   * \param now the current time
+   */
+  void Sent (SequenceNumber32 seq, uint32_t size, Time now);
+
+  /**
+   * \brief Forget the data below a cumulative acknowledgment
+   * \param ack the acknowledgment number
+   * \param now the current time
+   */
+  void Ack (SequenceNumber32 ack, Time now);
+
+  /**
+   * \brief Mark the data of SACK blocks as received
+   * \param blocks the blocks of a SACK option
+   * \param now the current time
+   * \returns the number of bytes newly SACKed
+   */
+  uint32_t Sack (const TcpOptionSack::SackList& blocks, Time now);
+
+  /**
+   * \brief Run the loss detectors
+   * \param now the current time
+   * \param [out] timeout the delay after which RACK deems more data lost
+   *        unless it is delivered first, or zero
+   * \returns true if some data was newly deemed lost
+   */
+  bool DetectLosses (Time now, Time& timeout);
+
+  /**
+   * \brief Deem lost all the data not SACKed, upon a retransmission timeout
+   */
+  void MarkAllLost (void);
+
+  /**
+   * \brief Find the first range deemed lost and not retransmitted since,
+   * as NextSeg() rule 1 of \RFC{6675}
+   * \param [out] seq the first sequence number of the range
+   * \param [out] length the length of the range
+   * \returns true if there is such a range
+   */
+  bool GetNextLost (SequenceNumber32& seq, uint32_t& length);
+
+  /**
+   * \brief Skip the SACKed data at a sequence number
+   * \param seq the sequence number
+   * \returns the first sequence number from seq that is not SACKed
+   */
+  SequenceNumber32 SkipSacked (SequenceNumber32 seq) const;
+
+  /**
+   * \brief Get the length of the data from a sequence number up to the
+   * next SACKed data
+   * \param seq the sequence number
+   * \param maxSize the largest length of interest
+   * \returns the length, at most maxSize
+   */
+  uint32_t UnsackedLength (SequenceNumber32 seq, uint32_t maxSize) const;
+
+  /**
+   * \brief Get the estimate of the bytes in the network
+   * \returns the pipe of \RFC{6675}
+   */
+  uint32_t GetPipe (void) const;
+
+  /**
+   * \brief Get the number of bytes SACKed above the cumulative acknowledgment
+   * \returns the number of bytes SACKed
+   */
+  uint32_t GetSackedBytes (void) const;
+
+  /**
+   * \brief Get the lowest RTT measured on delivered data
+   * \returns the minimum RTT, or zero if none was measured
+   */
+  Time GetMinRtt (void) const;
+
+private:
+  /// A range of data sent together
+  struct Segment
+  {
+    SequenceNumber32 m_end; //!< Sequence number after the last byte
+    Time m_sent;            //!< Time of the last transmission
+    bool m_sacked;          //!< SACKed by the receiver
+    bool m_lost;            //!< Deemed lost
+    bool m_retx;            //!< Retransmitted since it was deemed lost
+  };
+  /// Segments, by their first sequence number
+  typedef std::map<SequenceNumber32, Segment> Segments;
+
+  /**
+   * \brief Split the segment holding a sequence number so that a segment
+   * starts there
+   * \param seq the sequence number
+   */
+  void Split (SequenceNumber32 seq);
+
+  /**
+   * \param i a segment
+   * \returns the bytes it counts in the pipe
+   */
+  static uint32_t InPipe (Segments::const_iterator i);
+
+  /**
+   * \brief Mark a segment lost, or a retransmission lost again
+   * \param i the segment
+   */
+  void MarkLost (Segments::iterator i);
+
+  /**
+   * \brief Take a segment delivered into account for RACK
+   * \param i the segment
+   * \param now the current time
+   */
+  void Delivered (Segments::const_iterator i, Time now);
+
+  Segments m_segments;           //!< The data in flight
+  uint32_t m_segmentSize;        //!< SMSS
+  uint32_t m_dupThresh;          //!< DupThresh
+  bool m_rackEnabled;            //!< RACK loss detection enabled
+  uint32_t m_pipe;               //!< Bytes in the network
+  uint32_t m_sackedBytes;        //!< Bytes SACKed
+  SequenceNumber32 m_highSacked; //!< Sequence number after the highest SACKed byte
+  SequenceNumber32 m_highLost;   //!< Data below it and not SACKed is deemed lost
+  SequenceNumber32 m_retxHint;   //!< No unretransmitted loss below it
+  Time m_rackXmit;               //!< Send time of the most recently sent data delivered
+  SequenceNumber32 m_rackEnd;    //!< End of the most recently sent data delivered
+  Time m_rackRtt;                //!< RTT of the most recently sent data delivered
+  Time m_minRtt;                 //!< Lowest RTT measured
+};
+
+} // namespace ns3
+
+#endif /* TCP_SCOREBOARD_H */
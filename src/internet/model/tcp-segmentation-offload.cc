@@ -0,0 +1,160 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <algorithm>
+#include "tcp-segmentation-offload.h"
+#include "tcp-header.h"
+#include "tcp-l4-protocol.h"
+#include "ipv4-header.h"
+#include "ns3/node.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpSegmentationOffload");
+
+TcpSegmentationTag::TcpSegmentationTag ()
+  : m_segmentSize (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TcpSegmentationTag::SetSegmentSize (uint16_t segmentSize)
+{
+  NS_LOG_FUNCTION (this << segmentSize);
+  m_segmentSize = segmentSize;
+}
+
+uint16_t
+TcpSegmentationTag::GetSegmentSize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_segmentSize;
+}
+
+NS_OBJECT_ENSURE_REGISTERED (TcpSegmentationTag);
+
+TypeId
+TcpSegmentationTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpSegmentationTag")
+    .SetParent<Tag> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<TcpSegmentationTag> ()
+  ;
+  return tid;
+}
+
+TypeId
+TcpSegmentationTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+TcpSegmentationTag::GetSerializedSize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return 2;
+}
+
+void
+TcpSegmentationTag::Serialize (TagBuffer i) const
+{
+  NS_LOG_FUNCTION (this << &i);
+  i.WriteU16 (m_segmentSize);
+}
+
+void
+TcpSegmentationTag::Deserialize (TagBuffer i)
+{
+  NS_LOG_FUNCTION (this << &i);
+  m_segmentSize = i.ReadU16 ();
+}
+
+void
+TcpSegmentationTag::Print (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this << &os);
+  os << "SegmentSize=" << m_segmentSize;
+}
+
+const uint32_t TcpSegmentationOffload::MAX_SIZE;
+
+uint32_t
+TcpSegmentationOffload::GetSegmentCount (Ptr<const Packet> packet, uint16_t segmentSize)
+{
+  NS_LOG_FUNCTION (packet << segmentSize);
+  NS_ASSERT (segmentSize > 0);
+
+  TcpHeader tcpHeader;
+  uint32_t size = packet->GetSize () - packet->PeekHeader (tcpHeader);
+  return std::max<uint32_t> (1, (size + segmentSize - 1) / segmentSize);
+}
+
+void
+TcpSegmentationOffload::Segment (Ptr<const Packet> packet, uint16_t segmentSize,
+                                 std::list<Ptr<Packet> >& segments)
+{
+  NS_LOG_FUNCTION (packet << segmentSize);
+  NS_ASSERT (segmentSize > 0);
+
+  Ptr<Packet> p = packet->Copy ();
+  TcpSegmentationTag tag;
+  p->RemovePacketTag (tag);
+  Ipv4Header ipHeader;
+  p->RemoveHeader (ipHeader);
+  NS_ASSERT (ipHeader.GetProtocol () == TcpL4Protocol::PROT_NUMBER);
+  TcpHeader tcpHeader;
+  p->RemoveHeader (tcpHeader);
+
+  uint32_t size = p->GetSize ();
+  uint8_t lastFlags = tcpHeader.GetFlags ();
+  uint8_t flags = lastFlags & ~(TcpHeader::FIN | TcpHeader::PSH);
+  uint16_t identification = ipHeader.GetIdentification ();
+  bool checksum = Node::ChecksumEnabled ();
+  for (uint32_t offset = 0; offset < size; offset += segmentSize)
+    {
+      uint32_t length = std::min<uint32_t> (segmentSize, size - offset);
+      Ptr<Packet> segment = p->CreateFragment (offset, length);
+
+      TcpHeader h = tcpHeader;
+      h.SetSequenceNumber (tcpHeader.GetSequenceNumber () + SequenceNumber32 (offset));
+      h.SetFlags (offset + length < size ? flags : lastFlags);
+      if (checksum)
+        {
+          h.EnableChecksums ();
+        }
+      h.InitializeChecksum (ipHeader.GetSource (), ipHeader.GetDestination (),
+                            TcpL4Protocol::PROT_NUMBER);
+      segment->AddHeader (h);
+
+      Ipv4Header ih = ipHeader;
+      ih.SetIdentification (identification++);
+      ih.SetPayloadSize (segment->GetSize ());
+      if (checksum)
+        {
+          ih.EnableChecksum ();
+        }
+      segment->AddHeader (ih);
+      segments.push_back (segment);
+    }
+  NS_LOG_LOGIC ("Cut " << size << " bytes into " << segments.size () << " segments");
+}
+
+} // namespace ns3
@@ -0,0 +1,125 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef TCP_SEGMENTATION_OFFLOAD_H
+#define TCP_SEGMENTATION_OFFLOAD_H
+
+#include <list>
+#include "ns3/tag.h"
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Tag of a TCP super-segment, carrying the segment size it must be
+ * cut to.
+ *
+ * A TcpSocketBase with the Tso attribute set hands segments of several
+ * times its segment size to the IPv4 layer, with this tag. The IPv4 layer
+ * does not fragment them: the outgoing Ipv4Interface cuts them with
+ * TcpSegmentationOffload::Segment just before the device, unless the
+ * device MTU holds them whole, in which case the device serializes the
+ * super-segment at once.
+ */
+class TcpSegmentationTag : public Tag
+{
+public:
+  TcpSegmentationTag ();
+
+  /**
+   * \brief Set the size of the segments
+   * \param segmentSize the TCP payload of each segment, in bytes
+   */
+  void SetSegmentSize (uint16_t segmentSize);
+
+  /**
+   * \brief Get the size of the segments
+   * \returns the TCP payload of each segment, in bytes
+   */
+  uint16_t GetSegmentSize (void) const;
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  // inherited function, no need to doc.
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  // inherited function, no need to doc.
+  virtual uint32_t GetSerializedSize (void) const;
+
+  // inherited function, no need to doc.
+  virtual void Serialize (TagBuffer i) const;
+
+  // inherited function, no need to doc.
+  virtual void Deserialize (TagBuffer i);
+
+  // inherited function, no need to doc.
+  virtual void Print (std::ostream &os) const;
+
+private:
+  uint16_t m_segmentSize; //!< the segment size carried by the tag
+};
+
+/**
+ * \ingroup tcp
+ *
+ * \brief TCP segmentation of IPv4 super-segments, as a NIC does it in
+ * hardware.
+ */
+class TcpSegmentationOffload
+{
+public:
+  /**
+   * The largest TCP payload of a super-segment, so that the datagram
+   * fits the IPv4 total length with the largest IPv4 and TCP headers.
+   */
+  static const uint32_t MAX_SIZE = 65535 - 60 - 60;
+
+  /**
+   * \brief Get the number of segments a TCP super-segment is cut into
+   *
+   * \param packet the super-segment, starting with its TCP header
+   * \param segmentSize the TCP payload of each segment
+   * \returns the number of segments, at least one
+   */
+  static uint32_t GetSegmentCount (Ptr<const Packet> packet, uint16_t segmentSize);
+
+  /**
+   * \brief Cut an IPv4 datagram holding a TCP super-segment into segments
+   *
+   * Each segment gets a copy of the TCP header with its own sequence
+   * number, FIN and PSH only on the last one, and a copy of the IPv4
+   * header with its own payload size and consecutive identifications.
+   * The checksums are computed if they are enabled.
+   *
+   * \param packet the datagram, starting with its IPv4 header
+   * \param segmentSize the TCP payload of each segment
+   * \param [out] segments the datagrams to send, in order
+   */
+  static void Segment (Ptr<const Packet> packet, uint16_t segmentSize,
+                       std::list<Ptr<Packet> >& segments);
+};
+
+} // namespace ns3
+
+#endif /* TCP_SEGMENTATION_OFFLOAD_H */
@@ -49,6 +49,9 @@
 #include "tcp-header.h"
 #include "tcp-option-winscale.h"
 #include "tcp-option-ts.h"
+#include "tcp-option-sack-permitted.h"
+#include "tcp-option-sack.h"
+#include "tcp-segmentation-offload.h"
 #include "rtt-estimator.h"
 
 #include <math.h>
@@ -96,6 +99,26 @@ TcpSocketBase::GetTypeId (void)
                    BooleanValue (true),
                    MakeBooleanAccessor (&TcpSocketBase::m_timestampEnabled),
                    MakeBooleanChecker ())
+    .AddAttribute ("Sack", "Enable or disable the SACK option and SACK-based loss recovery",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_sackEnabled),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Rack", "Enable or disable RACK time-based loss detection, when SACK is in use",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&TcpSocketBase::m_rackEnabled),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Tso", "Hand super-segments of several segments to IPv4, cut below it",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_tsoEnabled),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Gro", "Coalesce in-order data segments before processing them",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_groEnabled),
+                   MakeBooleanChecker ())
+    .AddAttribute ("GroTimeout", "Longest time an in-order segment is held to be coalesced",
+                   TimeValue (MicroSeconds (20)),
+                   MakeTimeAccessor (&TcpSocketBase::m_groTimeout),
+                   MakeTimeChecker ())
     .AddAttribute ("MinRto",
                    "Minimum retransmit timeout value",
                    TimeValue (Seconds (1.0)), // RFC 6298 says min RTO=1 sec, but Linux uses 200ms. See http://www.postel.org/pipermail/end2end-interest/2004-November/004402.html
@@ -190,7 +213,15 @@ TcpSocketBase::TcpSocketBase (void)
     m_sndScaleFactor (0),
     m_rcvScaleFactor (0),
     m_timestampEnabled (true),
-    m_timestampToEcho (0)
+    m_timestampToEcho (0),
+    m_sackEnabled (false),
+    m_rackEnabled (true),
+    m_sackRecovery (false),
+    m_recoveryPoint (0),
+    m_tsoEnabled (false),
+    m_groEnabled (false),
+    m_groTimeout (MicroSeconds (20)),
+    m_groPacket (0)
 
 {
   NS_LOG_FUNCTION (this);
@@ -237,7 +268,16 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
     m_sndScaleFactor (sock.m_sndScaleFactor),
     m_rcvScaleFactor (sock.m_rcvScaleFactor),
     m_timestampEnabled (sock.m_timestampEnabled),
-    m_timestampToEcho (sock.m_timestampToEcho)
+    m_timestampToEcho (sock.m_timestampToEcho),
+    m_sackEnabled (sock.m_sackEnabled),
+    m_rackEnabled (sock.m_rackEnabled),
+    m_scoreboard (sock.m_scoreboard),
+    m_sackRecovery (false),
+    m_recoveryPoint (sock.m_recoveryPoint),
+    m_tsoEnabled (sock.m_tsoEnabled),
+    m_groEnabled (sock.m_groEnabled),
+    m_groTimeout (sock.m_groTimeout),
+    m_groPacket (0)
 
 {
   NS_LOG_FUNCTION (this);
@@ -1014,6 +1054,93 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
       return; // Discard invalid packet
     }
 
+  if (m_groEnabled)
+    {
+      if (m_groPacket != 0)
+        {
+          if (Coalesce (packet, tcpHeader))
+            {
+              return;
+            }
+          FlushGro ();
+        }
+      if (IsCoalescable (packet, tcpHeader)
+          && tcpHeader.GetSequenceNumber () == m_rxBuffer->NextRxSequence ())
+        { // Hold the segment for the ones that may follow it
+          TcpSegmentationTag segmentationTag;
+          if (!packet->PeekPacketTag (segmentationTag))
+            { // The segments coalesced count as segments of this size
+              segmentationTag.SetSegmentSize (packet->GetSize ());
+              packet->AddPacketTag (segmentationTag);
+            }
+          m_groPacket = packet;
+          m_groHeader = tcpHeader;
+          m_groFromAddress = fromAddress;
+          m_groToAddress = toAddress;
+          m_groEvent = Simulator::Schedule (m_groTimeout, &TcpSocketBase::FlushGro, this);
+          return;
+        }
+    }
+  ProcessSegment (packet, tcpHeader, fromAddress, toAddress);
+}
+
+bool
+TcpSocketBase::IsCoalescable (Ptr<const Packet> packet, const TcpHeader& tcpHeader) const
+{
+  return m_state == ESTABLISHED && packet->GetSize () > 0
+         && (tcpHeader.GetFlags () & ~TcpHeader::PSH) == TcpHeader::ACK
+         && (tcpHeader.GetLength () == 5
+             || (tcpHeader.GetLength () == 8 && tcpHeader.HasOption (TcpOption::TS)))
+         && !OutOfRange (tcpHeader.GetSequenceNumber (),
+                         tcpHeader.GetSequenceNumber () + packet->GetSize ());
+}
+
+bool
+TcpSocketBase::Coalesce (Ptr<Packet> packet, const TcpHeader& tcpHeader)
+{
+  if (!IsCoalescable (packet, tcpHeader)
+      || tcpHeader.GetSequenceNumber () != m_groHeader.GetSequenceNumber () + m_groPacket->GetSize ()
+      || tcpHeader.GetAckNumber () != m_groHeader.GetAckNumber ()
+      || tcpHeader.GetWindowSize () != m_groHeader.GetWindowSize ()
+      || tcpHeader.GetLength () != m_groHeader.GetLength ()
+      || m_groPacket->GetSize () + packet->GetSize () > TcpSegmentationOffload::MAX_SIZE)
+    {
+      return false;
+    }
+  if (tcpHeader.GetLength () == 8)
+    {
+      Ptr<const TcpOptionTS> ts = DynamicCast<const TcpOptionTS> (tcpHeader.GetOption (TcpOption::TS));
+      Ptr<const TcpOptionTS> groTs = DynamicCast<const TcpOptionTS> (m_groHeader.GetOption (TcpOption::TS));
+      if (ts->GetTimestamp () != groTs->GetTimestamp () || ts->GetEcho () != groTs->GetEcho ())
+        {
+          return false;
+        }
+    }
+  NS_LOG_LOGIC ("GRO appends seq " << tcpHeader.GetSequenceNumber () << " to " <<
+                m_groPacket->GetSize () << " bytes");
+  m_groPacket->AddAtEnd (packet);
+  return true;
+}
+
+void
+TcpSocketBase::FlushGro (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_groEvent.Cancel ();
+  Ptr<Packet> packet = m_groPacket;
+  m_groPacket = 0;
+  if (packet == 0)
+    {
+      return;
+    }
+  ProcessSegment (packet, m_groHeader, m_groFromAddress, m_groToAddress);
+}
+
+void
+TcpSocketBase::ProcessSegment (Ptr<Packet> packet, const TcpHeader& tcpHeader,
+                               const Address &fromAddress, const Address &toAddress)
+{
+  NS_LOG_FUNCTION (this << tcpHeader);
   ReadOptions (tcpHeader);
 
   if (tcpHeader.GetFlags () & TcpHeader::ACK)
@@ -1172,7 +1299,15 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
       if (tcpHeader.GetAckNumber () < m_nextTxSequence && packet->GetSize() == 0)
         {
           NS_LOG_LOGIC ("Dupack of " << tcpHeader.GetAckNumber ());
-          DupAck (tcpHeader, ++m_dupAckCount);
+          if (m_sackEnabled)
+            {
+              ++m_dupAckCount;
+              ProcessSack (tcpHeader);
+            }
+          else
+            {
+              DupAck (tcpHeader, ++m_dupAckCount);
+            }
         }
       // otherwise, the ACK is precisely equal to the nextTxSequence
       NS_ASSERT (tcpHeader.GetAckNumber () <= m_nextTxSequence);
@@ -1180,8 +1315,35 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
   else if (tcpHeader.GetAckNumber () > m_txBuffer->HeadSequence ())
     { // Case 3: New ACK, reset m_dupAckCount and update m_txBuffer
       NS_LOG_LOGIC ("New ack of " << tcpHeader.GetAckNumber ());
-      NewAck (tcpHeader.GetAckNumber ());
-      m_dupAckCount = 0;
+      if (m_sackEnabled)
+        {
+          SequenceNumber32 ack = tcpHeader.GetAckNumber ();
+          m_scoreboard.Ack (ack, Simulator::Now ());
+          if (m_sackRecovery && ack < m_recoveryPoint)
+            { // Partial ACK: the window stays at ssthresh during recovery
+              TcpSocketBase::NewAck (ack);
+            }
+          else
+            {
+              if (m_sackRecovery)
+                {
+                  NS_LOG_INFO ("Leaving SACK recovery at " << ack << " with cwnd " << m_cWnd);
+                  m_sackRecovery = false;
+                }
+              if (m_recoveryPoint < ack)
+                {
+                  m_recoveryPoint = ack;
+                }
+              NewAck (ack);
+            }
+          m_dupAckCount = 0;
+          ProcessSack (tcpHeader);
+        }
+      else
+        {
+          NewAck (tcpHeader.GetAckNumber ());
+          m_dupAckCount = 0;
+        }
     }
   // If there is any data piggybacked, store it into m_rxBuffer
   if (packet->GetSize () > 0)
@@ -1888,7 +2050,7 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
   NS_LOG_FUNCTION (this << seq << maxSize << withAck);
 
   bool isRetransmission = false;
-  if ( seq == m_txBuffer->HeadSequence () )
+  if ( seq == m_txBuffer->HeadSequence () || (m_sackEnabled && seq < m_highTxMark))
     {
       isRetransmission = true;
     }
@@ -1938,6 +2100,13 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
       p->AddPacketTag (ipHopLimitTag);
     }
 
+  if (sz > m_segmentSize)
+    {
+      TcpSegmentationTag segmentationTag;
+      segmentationTag.SetSegmentSize (m_segmentSize);
+      p->AddPacketTag (segmentationTag);
+    }
+
   if (m_closeOnEmpty && (remainingData == 0))
     {
       flags |= TcpHeader::FIN;
@@ -1995,6 +2164,11 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
                          m_endPoint6->GetPeerAddress (), m_boundnetdevice);
     }
 
+  if (m_sackEnabled)
+    {
+      m_scoreboard.Sent (seq, sz, Simulator::Now ());
+    }
+
   // update the history of sequence numbers used to calculate the RTT
   if (isRetransmission == false)
     { // This is the next expected one, just log at end
@@ -2039,9 +2213,21 @@ TcpSocketBase::SendPendingData (bool withAck)
       NS_LOG_INFO ("TcpSocketBase::SendPendingData: No endpoint; m_shutdownSend=" << m_shutdownSend);
       return false; // Is this the right way to handle this condition?
     }
+  if (m_sackRecovery)
+    {
+      return (SendRecoveryData (withAck) > 0);
+    }
   uint32_t nPacketsSent = 0;
   while (m_txBuffer->SizeFromSequence (m_nextTxSequence))
     {
+      if (m_sackEnabled && m_nextTxSequence < m_highTxMark)
+        { // Resending after a timeout: skip the data the receiver holds
+          m_nextTxSequence = m_scoreboard.SkipSacked (m_nextTxSequence);
+          if (m_txBuffer->SizeFromSequence (m_nextTxSequence) == 0)
+            {
+              break;
+            }
+        }
       uint32_t w = AvailableWindow (); // Get available window size
       // Stop sending if we need to wait for a larger Tx window (prevent silly window syndrome)
       if (w < m_segmentSize && m_txBuffer->SizeFromSequence (m_nextTxSequence) > w)
@@ -2066,6 +2252,15 @@ TcpSocketBase::SendPendingData (bool withAck)
                     " pd->Size " << m_txBuffer->Size () <<
                     " pd->SFS " << m_txBuffer->SizeFromSequence (m_nextTxSequence));
       uint32_t s = std::min (w, m_segmentSize);  // Send no more than window
+      if (m_tsoEnabled && m_endPoint != 0 && w > m_segmentSize)
+        { // A super-segment of whole segments, cut below IPv4
+          s = std::min (w, TcpSegmentationOffload::MAX_SIZE);
+          s -= s % m_segmentSize;
+        }
+      if (m_sackEnabled && m_nextTxSequence < m_highTxMark)
+        {
+          s = m_scoreboard.UnsackedLength (m_nextTxSequence, s);
+        }
       uint32_t sz = SendDataPacket (m_nextTxSequence, s, withAck);
       nPacketsSent++;                             // Count sent this loop
       m_nextTxSequence += sz;                     // Advance next tx sequence
@@ -2130,6 +2325,15 @@ TcpSocketBase::ReceivedData (Ptr<Packet> p, const TcpHeader& tcpHeader)
                 " ack " << tcpHeader.GetAckNumber () <<
                 " pkt size " << p->GetSize () );
 
+  // A super-segment, sent whole by the peer or coalesced by GRO, counts
+  // for all its segments towards the delayed ACK
+  uint32_t segments = 1;
+  TcpSegmentationTag segmentationTag;
+  if (p->RemovePacketTag (segmentationTag))
+    {
+      segments = (p->GetSize () + segmentationTag.GetSegmentSize () - 1) / segmentationTag.GetSegmentSize ();
+    }
+
   // Put into Rx buffer
   SequenceNumber32 expectedSeq = m_rxBuffer->NextRxSequence ();
   if (!m_rxBuffer->Add (p, tcpHeader))
@@ -2144,7 +2348,8 @@ TcpSocketBase::ReceivedData (Ptr<Packet> p, const TcpHeader& tcpHeader)
     }
   else
     { // In-sequence packet: ACK if delayed ack count allows
-      if (++m_delAckCount >= m_delAckMaxCount)
+      m_delAckCount += segments;
+      if (m_delAckCount >= m_delAckMaxCount)
         {
           m_delAckEvent.Cancel ();
           m_delAckCount = 0;
@@ -2306,9 +2511,112 @@ TcpSocketBase::ReTxTimeout ()
       return;
     }
 
+  if (m_sackEnabled)
+    { // RFC 6675 sec. 5.1: end the recovery and resend all but the SACKed data
+      m_rackEvent.Cancel ();
+      m_scoreboard.MarkAllLost ();
+      m_sackRecovery = false;
+      m_recoveryPoint = m_highTxMark;
+    }
   Retransmit ();
 }
 
+void
+TcpSocketBase::ProcessSack (const TcpHeader& tcpHeader)
+{
+  NS_LOG_FUNCTION (this << tcpHeader);
+  if (tcpHeader.HasOption (TcpOption::SACK))
+    {
+      Ptr<const TcpOptionSack> sack = DynamicCast<const TcpOptionSack> (tcpHeader.GetOption (TcpOption::SACK));
+      m_scoreboard.Sack (sack->GetSackList (), Simulator::Now ());
+    }
+  Time timeout;
+  m_scoreboard.DetectLosses (Simulator::Now (), timeout);
+  m_rackEvent.Cancel ();
+  if (timeout.IsStrictlyPositive ())
+    {
+      m_rackEvent = Simulator::Schedule (timeout, &TcpSocketBase::RackTimeout, this);
+    }
+  SequenceNumber32 seq;
+  uint32_t length;
+  if (!m_sackRecovery && m_recoveryPoint <= m_txBuffer->HeadSequence ()
+      && m_scoreboard.GetNextLost (seq, length))
+    {
+      EnterRecovery ();
+    }
+  if (m_sackRecovery)
+    {
+      SendRecoveryData (m_connected);
+    }
+}
+
+void
+TcpSocketBase::EnterRecovery (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_sackRecovery = true;
+  m_recoveryPoint = m_highTxMark;
+  m_ssThresh = std::max (2 * m_segmentSize, BytesInFlight () / 2);
+  m_cWnd = m_ssThresh;
+  NS_LOG_INFO ("Enter SACK recovery until " << m_recoveryPoint << ". Reset cwnd to " <<
+               m_cWnd << ", pipe " << m_scoreboard.GetPipe ());
+}
+
+uint32_t
+TcpSocketBase::SendRecoveryData (bool withAck)
+{
+  NS_LOG_FUNCTION (this << withAck);
+  if (m_endPoint == 0 && m_endPoint6 == 0)
+    {
+      return 0;
+    }
+  uint32_t nPacketsSent = 0;
+  while (m_scoreboard.GetPipe () + m_segmentSize <= m_cWnd)
+    {
+      SequenceNumber32 seq;
+      uint32_t length;
+      if (m_scoreboard.GetNextLost (seq, length))
+        { // NextSeg () rule 1: the first loss not retransmitted yet
+          SendDataPacket (seq, std::min (length, m_segmentSize), withAck);
+        }
+      else
+        { // Rule 2: new data, if the receiver window allows
+          seq = std::max (m_nextTxSequence.Get (), m_highTxMark.Get ());
+          uint32_t s = std::min (m_txBuffer->SizeFromSequence (seq), m_segmentSize);
+          if (s == 0 || static_cast<uint32_t> ((seq + SequenceNumber32 (s)) - m_txBuffer->HeadSequence ()) > m_rWnd.Get ())
+            {
+              break;
+            }
+          m_nextTxSequence = seq + SequenceNumber32 (SendDataPacket (seq, s, withAck));
+        }
+      ++nPacketsSent;
+    }
+  NS_LOG_LOGIC ("SendRecoveryData sent " << nPacketsSent << " packets, pipe " << m_scoreboard.GetPipe ());
+  return nPacketsSent;
+}
+
+void
+TcpSocketBase::RackTimeout (void)
+{
+  NS_LOG_FUNCTION (this);
+  Time timeout;
+  if (m_scoreboard.DetectLosses (Simulator::Now (), timeout))
+    {
+      if (!m_sackRecovery && m_recoveryPoint <= m_txBuffer->HeadSequence ())
+        {
+          EnterRecovery ();
+        }
+      if (m_sackRecovery)
+        {
+          SendRecoveryData (m_connected);
+        }
+    }
+  if (timeout.IsStrictlyPositive ())
+    {
+      m_rackEvent = Simulator::Schedule (timeout, &TcpSocketBase::RackTimeout, this);
+    }
+}
+
 void
 TcpSocketBase::DelAckTimeout (void)
 {
@@ -2424,6 +2732,9 @@ TcpSocketBase::CancelAllTimers ()
   m_lastAckEvent.Cancel ();
   m_timewaitEvent.Cancel ();
   m_sendPendingDataEvent.Cancel ();
+  m_rackEvent.Cancel ();
+  m_groEvent.Cancel ();
+  m_groPacket = 0;
 }
 
 /* Move TCP to Time_Wait state and schedule a transition to Closed state */
@@ -2581,6 +2892,13 @@ TcpSocketBase::ReadOptions (const TcpHeader& header)
               ScaleSsThresh (m_sndScaleFactor);
             }
         }
+
+      if (m_sackEnabled)
+        {
+          m_sackEnabled = header.HasOption (TcpOption::SACKPERMITTED);
+          m_scoreboard.SetSegmentSize (m_segmentSize);
+          m_scoreboard.SetRack (m_rackEnabled);
+        }
     }
 
   bool timestampAttribute = m_timestampEnabled;
@@ -2608,6 +2926,16 @@ TcpSocketBase::AddOptions (TcpHeader& header)
     {
       AddOptionTimestamp (header);
     }
+
+  // SACK-permitted is set only on SYN packets, SACK blocks on the others
+  if (m_sackEnabled && (header.GetFlags () & TcpHeader::SYN))
+    {
+      header.AppendOption (CreateObject<TcpOptionSackPermitted> ());
+    }
+  else if (m_sackEnabled && m_rxBuffer->GetSackListSize () > 0)
+    {
+      AddOptionSack (header);
+    }
 }
 
 void
@@ -2702,6 +3030,28 @@ TcpSocketBase::AddOptionTimestamp (TcpHeader& header)
                option->GetTimestamp () << " echo=" << m_timestampToEcho);
 }
 
+void
+TcpSocketBase::AddOptionSack (TcpHeader& header)
+{
+  NS_LOG_FUNCTION (this << header);
+
+  // Option space left, from the header length in 32-bit words
+  uint32_t room = 40 - (header.GetLength () * 4 - 20);
+  if (room < 10)
+    {
+      return;
+    }
+  Ptr<TcpOptionSack> option = CreateObject<TcpOptionSack> ();
+  TcpRxBuffer::SackList sackList = m_rxBuffer->GetSackList ();
+  for (TcpRxBuffer::SackList::const_iterator i = sackList.begin ();
+       i != sackList.end () && option->GetSerializedSize () + 8 <= room; ++i)
+    {
+      option->AddSackBlock (*i);
+    }
+  header.AppendOption (option);
+  NS_LOG_INFO (m_node->GetId () << " Add option SACK, " << option->GetNumSackBlocks () << " blocks");
+}
+
 void TcpSocketBase::UpdateWindowSize (const TcpHeader &header)
 {
   NS_LOG_FUNCTION (this << header);
@@ -35,6 +35,7 @@
 #include "ns3/event-id.h"
 #include "tcp-tx-buffer.h"
 #include "tcp-rx-buffer.h"
+#include "tcp-scoreboard.h"
 #include "rtt-estimator.h"
 
 namespace ns3 {
@@ -87,6 +88,22 @@ typedef std::deque<RttHistory> RttHistory_t;
  * provides connection orientation and sliding window flow control. Part of
  * this class is modified from the original NS-3 TCP socket implementation
  * (TcpSocketImpl) by Raj Bhattacharjea <raj.b@gatech.edu> of Georgia Tech.
+ *
+ * When both ends enable the Sack attribute, the receiver reports its
+ * out-of-order blocks (\RFC{2018}) and this class runs the loss recovery of
+ * \RFC{6675} itself: the lost data is found on a TcpScoreboard, by the
+ * SACKed data above it and, if the Rack attribute is set, by time as in
+ * \RFC{8985}, and sent while the pipe is below the congestion window. The
+ * subclasses then only grow the window outside recovery and handle the
+ * retransmission timeouts; DupAck() is not called.
+ *
+ * The Tso attribute lets the socket send, over IPv4, super-segments of up
+ * to 64 KB in whole segments (see TcpSegmentationTag): the outgoing
+ * interface cuts them if the device MTU is smaller. The Gro attribute
+ * makes the socket hold in-order data segments for up to GroTimeout and
+ * coalesce the ones that follow them, to process them at once. A
+ * super-segment received, coalesced or sent whole by the peer, counts for
+ * all its segments towards the delayed ACK.
  */
 class TcpSocketBase : public TcpSocket
 {
@@ -307,6 +324,43 @@ protected:
   virtual void DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
                             const Address &toAddress);
 
+  /**
+   * \brief Process a segment, its TCP header removed, in the current state.
+   *
+   * \param packet the segment payload
+   * \param tcpHeader the segment TCP header
+   * \param fromAddress the address of the sender of packet
+   * \param toAddress the address of the receiver of packet
+   */
+  void ProcessSegment (Ptr<Packet> packet, const TcpHeader& tcpHeader,
+                       const Address &fromAddress, const Address &toAddress);
+
+  /**
+   * \brief Check that a segment may be coalesced by GRO: in-window data,
+   * with no flag but ACK and PSH and no option but a timestamp, in the
+   * ESTABLISHED state.
+   *
+   * \param packet the segment payload
+   * \param tcpHeader the segment TCP header
+   * \returns true if the segment may be coalesced
+   */
+  bool IsCoalescable (Ptr<const Packet> packet, const TcpHeader& tcpHeader) const;
+
+  /**
+   * \brief Append a segment to the segment held by GRO, if it follows it
+   * and carries the same ACK, window and timestamp.
+   *
+   * \param packet the segment payload
+   * \param tcpHeader the segment TCP header
+   * \returns true if the segment was appended
+   */
+  bool Coalesce (Ptr<Packet> packet, const TcpHeader& tcpHeader);
+
+  /**
+   * \brief Process the segment held by GRO.
+   */
+  void FlushGro (void);
+
   /**
    * \brief Called by the L3 protocol when it received an ICMP packet to pass on to TCP.
    *
@@ -584,6 +638,31 @@ protected:
    */
   virtual void DupAck (const TcpHeader& tcpHeader, uint32_t count) = 0;
 
+  /**
+   * \brief Update the scoreboard with the SACK blocks of an ACK, detect
+   * losses and start or continue the loss recovery
+   * \param tcpHeader the packet's TCP header
+   */
+  void ProcessSack (const TcpHeader& tcpHeader);
+
+  /**
+   * \brief Enter SACK-based loss recovery (\RFC{6675} sec. 5 step 4)
+   */
+  void EnterRecovery (void);
+
+  /**
+   * \brief Send lost data, then new data, while the pipe is below the
+   * congestion window (\RFC{6675} sec. 5 step 4.3 and C)
+   * \param withAck forces an ACK to be sent
+   * \returns the number of packets sent
+   */
+  uint32_t SendRecoveryData (bool withAck);
+
+  /**
+   * \brief Run the RACK loss detection when its reordering timer expires
+   */
+  void RackTimeout (void);
+
   /**
    * \brief Call Retransmit() upon RTO event
    */
@@ -685,6 +764,16 @@ protected:
    */
   void AddOptionTimestamp (TcpHeader& header);
 
+  /**
+   * \brief Add the SACK option to the header
+   *
+   * Report as many blocks of the receive buffer as fit in the option
+   * space left, the most recent first.
+   *
+   * \param header TcpHeader to which add the option to
+   */
+  void AddOptionSack (TcpHeader& header);
+
   /**
    * \brief Scale the initial SsThresh value to the correct one
    *
@@ -711,6 +800,7 @@ protected:
   EventId           m_delAckEvent;     //!< Delayed ACK timeout event
   EventId           m_persistEvent;    //!< Persist event: Send 1 byte to probe for a non-zero Rx window
   EventId           m_timewaitEvent;   //!< TIME_WAIT expiration event: Move this socket to CLOSED state
+  EventId           m_rackEvent;       //!< RACK reordering timer
   uint32_t          m_dupAckCount;     //!< Dupack counter
   uint32_t          m_delAckCount;     //!< Delayed ACK counter
   uint32_t          m_delAckMaxCount;  //!< Number of packet to fire an ACK before delay timeout
@@ -773,6 +863,24 @@ protected:
   bool     m_timestampEnabled;    //!< Timestamp option enabled
   uint32_t m_timestampToEcho;     //!< Timestamp to echo
 
+  bool     m_sackEnabled;         //!< SACK option enabled
+  bool     m_rackEnabled;         //!< RACK loss detection enabled
+
+  // SACK-based loss recovery
+  TcpScoreboard    m_scoreboard;    //!< Data in flight
+  bool             m_sackRecovery;  //!< In SACK-based loss recovery
+  SequenceNumber32 m_recoveryPoint; //!< No new recovery before it is acknowledged
+
+  // Segmentation and receive offloads
+  bool      m_tsoEnabled;         //!< Super-segments handed to IPv4
+  bool      m_groEnabled;         //!< In-order segments coalesced on receive
+  Time      m_groTimeout;         //!< Longest time a segment is held by GRO
+  EventId   m_groEvent;           //!< GRO flush event
+  Ptr<Packet> m_groPacket;        //!< Payload held by GRO, or 0
+  TcpHeader m_groHeader;          //!< TCP header of the first segment held
+  Address   m_groFromAddress;     //!< Sender of the segments held
+  Address   m_groToAddress;       //!< Receiver of the segments held
+
   EventId m_sendPendingDataEvent; //!< micro-delay event to send pending data
 };
 
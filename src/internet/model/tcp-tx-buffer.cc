@@ -57,7 +57,8 @@ TcpTxBuffer::GetTypeId (void)
  * initialized below is insignificant.
  */
 TcpTxBuffer::TcpTxBuffer (uint32_t n)
-  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_data (0)
+  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_headOffset (0),
+    m_cursor (0)
 {
 }
 
@@ -111,7 +112,10 @@ TcpTxBuffer::Add (Ptr<Packet> p)
     {
       if (p->GetSize () > 0)
         {
-          m_data.push_back (p);
+          Chunk chunk;
+          chunk.m_packet = p;
+          chunk.m_offset = m_headOffset + m_size;
+          m_data.push_back (chunk);
           m_size += p->GetSize ();
           NS_LOG_LOGIC ("Updated size=" << m_size << ", lastSeq=" << m_firstByteSeq + SequenceNumber32 (m_size));
         }
@@ -133,6 +137,39 @@ TcpTxBuffer::SizeFromSequence (const SequenceNumber32& seq) const
   return lastSeq - seq;
 }
 
+uint32_t
+TcpTxBuffer::FindChunk (uint64_t offset)
+{
+  NS_ASSERT (offset >= m_headOffset && offset < m_headOffset + m_size);
+  // Sequential extraction: the chunk is the one after the last extraction,
+  // or the one before if the last segment ended within a chunk
+  for (uint32_t i = (m_cursor > 0 ? m_cursor - 1 : 0);
+       i < m_data.size () && i <= m_cursor; ++i)
+    {
+      if (m_data[i].m_offset <= offset
+          && offset < m_data[i].m_offset + m_data[i].m_packet->GetSize ())
+        {
+          return i;
+        }
+    }
+  // Retransmission: binary search for the last chunk starting at or before offset
+  uint32_t lo = 0;
+  uint32_t hi = m_data.size ();
+  while (hi - lo > 1)
+    {
+      uint32_t mid = lo + (hi - lo) / 2;
+      if (m_data[mid].m_offset <= offset)
+        {
+          lo = mid;
+        }
+      else
+        {
+          hi = mid;
+        }
+    }
+  return lo;
+}
+
 Ptr<Packet>
 TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
 {
@@ -148,55 +185,43 @@ TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
     }
 
   // Extract data from the buffer and return
-  uint32_t offset = seq - m_firstByteSeq.Get ();
-  uint32_t count = 0;      // Offset of the first byte of a packet in the buffer
-  uint32_t pktSize = 0;
-  bool beginFound = false;
-  int pktCount = 0;
+  uint64_t offset = m_headOffset + (seq - m_firstByteSeq.Get ());
+  uint64_t end = offset + s;
+  uint32_t i = FindChunk (offset);
+  NS_LOG_LOGIC ("First byte found in packet #" << i << " of " << m_data.size ()
+                                               << " at stream offset " << m_data[i].m_offset);
   Ptr<Packet> outPacket;
-  NS_LOG_LOGIC ("There are " << m_data.size () << " number of packets in buffer");
-  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
+  for (; offset < end; ++i)
     {
-      pktCount++;
-      pktSize = (*i)->GetSize ();
-      if (!beginFound)
-        { // Look for first fragment
-          if (count + pktSize > offset)
+      const Chunk &chunk = m_data[i];
+      uint32_t pktSize = chunk.m_packet->GetSize ();
+      uint32_t packetOffset = offset - chunk.m_offset;
+      uint32_t fragmentLength = std::min<uint64_t> (pktSize - packetOffset, end - offset);
+      if (packetOffset > 0 || fragmentLength < pktSize)
+        {
+          Ptr<Packet> fragment = chunk.m_packet->CreateFragment (packetOffset, fragmentLength);
+          if (outPacket == 0)
+            {
+              outPacket = fragment;
+            }
+          else
             {
-              NS_LOG_LOGIC ("First byte found in packet #" << pktCount << " at buffer offset " << count
-                                                           << ", packet len=" << pktSize);
-              beginFound = true;
-              uint32_t packetOffset = offset - count;
-              uint32_t fragmentLength = count + pktSize - offset;
-              if (fragmentLength >= s)
-                { // Data to be copied falls entirely in this packet
-                  return (*i)->CreateFragment (packetOffset, s);
-                }
-              else
-                { // This packet only fulfills part of the request
-                  outPacket = (*i)->CreateFragment (packetOffset, fragmentLength);
-                }
-              NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
+              outPacket->AddAtEnd (fragment);
             }
         }
-      else if (count + pktSize >= offset + s)
-        { // Last packet fragment found
-          NS_LOG_LOGIC ("Last byte found in packet #" << pktCount << " at buffer offset " << count
-                                                      << ", packet len=" << pktSize);
-          uint32_t fragmentLength = offset + s - count;
-          Ptr<Packet> endFragment = (*i)->CreateFragment (0, fragmentLength);
-          outPacket->AddAtEnd (endFragment);
-          NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
-          break;
+      else if (outPacket == 0)
+        {
+          outPacket = chunk.m_packet->Copy ();
         }
       else
         {
-          NS_LOG_LOGIC ("Appending to output the packet #" << pktCount << " of offset " << count << " len=" << pktSize);
-          outPacket->AddAtEnd (*i);
-          NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
+          outPacket->AddAtEnd (chunk.m_packet);
         }
-      count += pktSize;
+      offset += fragmentLength;
+      NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
     }
+  // Remember where this extraction ended: the next one is likely to start there
+  m_cursor = (offset < m_data[i - 1].m_offset + m_data[i - 1].m_packet->GetSize ()) ? i - 1 : i;
   NS_ASSERT (outPacket->GetSize () == s);
   return outPacket;
 }
@@ -217,32 +242,35 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
   // Cases do not need to scan the buffer
   if (m_firstByteSeq >= seq) return;
 
-  // Scan the buffer and discard packets
-  uint32_t offset = seq - m_firstByteSeq.Get ();  // Number of bytes to remove
-  uint32_t pktSize;
+  // Discard the packets behind the seqnum from the head of the ring
+  uint32_t offset = std::min<uint32_t> (seq - m_firstByteSeq.Get (), m_size); // Number of bytes to remove
+  uint64_t newHead = m_headOffset + offset;
   NS_LOG_LOGIC ("Offset=" << offset);
-  BufIterator i = m_data.begin ();
-  while (i != m_data.end ())
+  while (!m_data.empty ())
     {
-      if (offset > (*i)->GetSize ())
+      Chunk &chunk = m_data.front ();
+      uint32_t pktSize = chunk.m_packet->GetSize ();
+      if (chunk.m_offset + pktSize <= newHead)
         { // This packet is behind the seqnum. Remove this packet from the buffer
-          pktSize = (*i)->GetSize ();
-          m_size -= pktSize;
-          offset -= pktSize;
-          m_firstByteSeq += pktSize;
-          i = m_data.erase (i);
-          NS_LOG_LOGIC ("Removed one packet of size " << pktSize << ", offset=" << offset);
+          m_data.pop_front ();
+          m_cursor = m_cursor > 0 ? m_cursor - 1 : 0;
+          NS_LOG_LOGIC ("Removed one packet of size " << pktSize);
         }
-      else if (offset > 0)
-        { // Part of the packet is behind the seqnum. Fragment
-          pktSize = (*i)->GetSize () - offset;
-          *i = (*i)->CreateFragment (offset, pktSize);
-          m_size -= offset;
-          m_firstByteSeq += offset;
-          NS_LOG_LOGIC ("Fragmented one packet by size " << offset << ", new size=" << pktSize);
+      else
+        {
+          if (chunk.m_offset < newHead)
+            { // Part of the packet is behind the seqnum. Fragment
+              uint32_t cut = newHead - chunk.m_offset;
+              chunk.m_packet = chunk.m_packet->CreateFragment (cut, pktSize - cut);
+              chunk.m_offset = newHead;
+              NS_LOG_LOGIC ("Fragmented one packet by size " << cut << ", new size=" << pktSize - cut);
+            }
           break;
         }
     }
+  m_size -= offset;
+  m_headOffset = newHead;
+  m_firstByteSeq += offset;
   // Catching the case of ACKing a FIN
   if (m_size == 0)
     {
@@ -21,7 +21,7 @@
 #ifndef TCP_TX_BUFFER_H
 #define TCP_TX_BUFFER_H
 
-#include <list>
+#include <deque>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/object.h"
@@ -36,6 +36,12 @@ class Packet;
  *
  * \brief class for keeping the data sent by the application to the TCP socket, i.e.
  *        the sending buffer.
+ *
+ * The packets written by the application are kept in a ring, each with its
+ * offset in the byte stream, so that the packet holding a sequence number
+ * is found by a binary search instead of a walk from the head.  Segments
+ * are usually extracted in sequence, so the buffer remembers where the
+ * last extraction ended and starts the next one from there.
  */
 class TcpTxBuffer : public Object
 {
@@ -128,13 +134,26 @@ public:
   void DiscardUpTo (const SequenceNumber32& seq);
 
 private:
-  /// container for data stored in the buffer
-  typedef std::list<Ptr<Packet> >::iterator BufIterator;
+  /// A packet written by the application, and its offset in the byte stream
+  struct Chunk
+  {
+    Ptr<Packet> m_packet; //!< The data
+    uint64_t m_offset;    //!< Stream offset of the first byte
+  };
+
+  /**
+   * Find the chunk holding a byte.
+   * \param offset stream offset of the byte, within the buffer
+   * \returns the index of the chunk in m_data
+   */
+  uint32_t FindChunk (uint64_t offset);
 
   TracedValue<SequenceNumber32> m_firstByteSeq; //!< Sequence number of the first byte in data (SND.UNA)
   uint32_t m_size;                              //!< Number of data bytes
   uint32_t m_maxBuffer;                         //!< Max number of data bytes in buffer (SND.WND)
-  std::list<Ptr<Packet> > m_data;               //!< Corresponding data (may be null)
+  uint64_t m_headOffset;                        //!< Stream offset of the first byte in data
+  std::deque<Chunk> m_data;                     //!< Corresponding data, in stream order
+  uint32_t m_cursor;                            //!< Index of the chunk after the last extraction
 };
 
 } // namepsace ns3
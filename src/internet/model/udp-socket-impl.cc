@@ -508,51 +508,10 @@ UdpSocketImpl::DoSendTo (Ptr<Packet> p, Ipv4Address dest, uint16_t port)
       return -1;
     }
 
-  if (IsManualIpTos ())
-    {
-      SocketIpTosTag ipTosTag;
-      ipTosTag.SetTos (GetIpTos ());
-      p->AddPacketTag (ipTosTag);
-    }
+  AddIpv4SendTags (p, dest);
 
   Ptr<Ipv4> ipv4 = m_node->GetObject<Ipv4> ();
 
-  // Locally override the IP TTL for this socket
-  // We cannot directly modify the TTL at this stage, so we set a Packet tag
-  // The destination can be either multicast, unicast/anycast, or
-  // either all-hosts broadcast or limited (subnet-directed) broadcast.
-  // For the latter two broadcast types, the TTL will later be set to one
-  // irrespective of what is set in these socket options.  So, this tagging
-  // may end up setting the TTL of a limited broadcast packet to be
-  // the same as a unicast, but it will be fixed further down the stack
-  if (m_ipMulticastTtl != 0 && dest.IsMulticast ())
-    {
-      SocketIpTtlTag tag;
-      tag.SetTtl (m_ipMulticastTtl);
-      p->AddPacketTag (tag);
-    }
-  else if (IsManualIpTtl () && GetIpTtl () != 0 && !dest.IsMulticast () && !dest.IsBroadcast ())
-    {
-      SocketIpTtlTag tag;
-      tag.SetTtl (GetIpTtl ());
-      p->AddPacketTag (tag);
-    }
-  {
-    SocketSetDontFragmentTag tag;
-    bool found = p->RemovePacketTag (tag);
-    if (!found)
-      {
-        if (m_mtuDiscover)
-          {
-            tag.Enable ();
-          }
-        else
-          {
-            tag.Disable ();
-          }
-        p->AddPacketTag (tag);
-      }
-  }
   //
   // If dest is set to the limited broadcast address (all ones),
   // convert it to send a copy of the packet out of every 
@@ -669,6 +628,157 @@ UdpSocketImpl::DoSendTo (Ptr<Packet> p, Ipv4Address dest, uint16_t port)
   return 0;
 }
 
+void
+UdpSocketImpl::AddIpv4SendTags (Ptr<Packet> p, Ipv4Address dest) const
+{
+  NS_LOG_FUNCTION (this << p << dest);
+  if (IsManualIpTos ())
+    {
+      SocketIpTosTag ipTosTag;
+      ipTosTag.SetTos (GetIpTos ());
+      p->AddPacketTag (ipTosTag);
+    }
+
+  // Locally override the IP TTL for this socket
+  // We cannot directly modify the TTL at this stage, so we set a Packet tag
+  // The destination can be either multicast, unicast/anycast, or
+  // either all-hosts broadcast or limited (subnet-directed) broadcast.
+  // For the latter two broadcast types, the TTL will later be set to one
+  // irrespective of what is set in these socket options.  So, this tagging
+  // may end up setting the TTL of a limited broadcast packet to be
+  // the same as a unicast, but it will be fixed further down the stack
+  if (m_ipMulticastTtl != 0 && dest.IsMulticast ())
+    {
+      SocketIpTtlTag tag;
+      tag.SetTtl (m_ipMulticastTtl);
+      p->AddPacketTag (tag);
+    }
+  else if (IsManualIpTtl () && GetIpTtl () != 0 && !dest.IsMulticast () && !dest.IsBroadcast ())
+    {
+      SocketIpTtlTag tag;
+      tag.SetTtl (GetIpTtl ());
+      p->AddPacketTag (tag);
+    }
+  {
+    SocketSetDontFragmentTag tag;
+    bool found = p->RemovePacketTag (tag);
+    if (!found)
+      {
+        if (m_mtuDiscover)
+          {
+            tag.Enable ();
+          }
+        else
+          {
+            tag.Disable ();
+          }
+        p->AddPacketTag (tag);
+      }
+  }
+}
+
+int
+UdpSocketImpl::DoSendManyTo (const std::vector<Ptr<Packet> > &packets, Ipv4Address dest, uint16_t port)
+{
+  NS_LOG_FUNCTION (this << packets.size () << dest << port);
+  if (packets.empty ())
+    {
+      return 0;
+    }
+  if (m_endPoint == 0)
+    {
+      if (Bind () == -1)
+        {
+          NS_ASSERT (m_endPoint == 0);
+          return -1;
+        }
+      NS_ASSERT (m_endPoint != 0);
+    }
+
+  Ptr<Ipv4> ipv4 = m_node->GetObject<Ipv4> ();
+  if (dest.IsBroadcast () || m_endPoint->GetLocalAddress () != Ipv4Address::GetAny ()
+      || ipv4->GetRoutingProtocol () == 0
+      || !ipv4->GetRoutingProtocol ()->IsFlowDeterministic ())
+    {
+      // Only the routed path has a per-packet lookup worth sharing, and
+      // only if the route of every packet of the flow is the same one:
+      // random ECMP, for one, picks a route per packet.
+      int sent = 0;
+      for (std::vector<Ptr<Packet> >::const_iterator i = packets.begin (); i != packets.end (); ++i)
+        {
+          if (DoSendTo (*i, dest, port) < 0)
+            {
+              return sent == 0 ? -1 : sent;
+            }
+          sent++;
+        }
+      return sent;
+    }
+  if (m_shutdownSend)
+    {
+      m_errno = ERROR_SHUTDOWN;
+      return -1;
+    }
+
+  // The batch stops at the first packet too large to be sent
+  uint32_t n = 0;
+  while (n < packets.size () && packets[n]->GetSize () <= GetTxAvailable ())
+    {
+      n++;
+    }
+  if (n == 0)
+    {
+      m_errno = ERROR_MSGSIZE;
+      return -1;
+    }
+
+  // All the packets of the batch have the same addresses and ports, so
+  // that the route found for the first one is good for all of them
+  AddIpv4SendTags (packets[0], dest);
+  Ipv4Header header;
+  header.SetDestination (dest);
+  header.SetProtocol (UdpL4Protocol::PROT_NUMBER);
+  Socket::SocketErrno errno_;
+  Ptr<NetDevice> oif = m_boundnetdevice;
+  Ptr<Ipv4Route> route = ipv4->GetRoutingProtocol ()->RouteOutput (packets[0], header, oif, errno_);
+  if (route == 0)
+    {
+      NS_LOG_LOGIC ("No route to destination");
+      NS_LOG_ERROR (errno_);
+      m_errno = errno_;
+      return -1;
+    }
+  if (!m_allowBroadcast)
+    {
+      uint32_t outputIfIndex = ipv4->GetInterfaceForDevice (route->GetOutputDevice ());
+      uint32_t ifNAddr = ipv4->GetNAddresses (outputIfIndex);
+      for (uint32_t addrI = 0; addrI < ifNAddr; ++addrI)
+        {
+          Ipv4InterfaceAddress ifAddr = ipv4->GetAddress (outputIfIndex, addrI);
+          if (dest == ifAddr.GetBroadcast ())
+            {
+              m_errno = ERROR_OPNOTSUPP;
+              return -1;
+            }
+        }
+    }
+
+  Ipv4Address source = route->GetSource ();
+  uint16_t sport = m_endPoint->GetLocalPort ();
+  NS_LOG_LOGIC ("Sending " << n << " packets from " << source << " to " << dest);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = packets[i];
+      if (i > 0)
+        {
+          AddIpv4SendTags (p, dest);
+        }
+      m_udp->Send (p->Copy (), source, dest, sport, port, route);
+      NotifyDataSent (p->GetSize ());
+    }
+  return n;
+}
+
 int
 UdpSocketImpl::DoSendTo (Ptr<Packet> p, Ipv6Address dest, uint16_t port)
 {
@@ -831,6 +941,36 @@ UdpSocketImpl::SendTo (Ptr<Packet> p, uint32_t flags, const Address &address)
   return -1;
 }
 
+int
+UdpSocketImpl::SendMany (const std::vector<Ptr<Packet> > &packets, uint32_t flags)
+{
+  NS_LOG_FUNCTION (this << packets.size () << flags);
+
+  if (!m_connected)
+    {
+      m_errno = ERROR_NOTCONN;
+      return -1;
+    }
+  if (Ipv4Address::IsMatchingType (m_defaultAddress))
+    {
+      return DoSendManyTo (packets, Ipv4Address::ConvertFrom (m_defaultAddress), m_defaultPort);
+    }
+  return Socket::SendMany (packets, flags);
+}
+
+int
+UdpSocketImpl::SendManyTo (const std::vector<Ptr<Packet> > &packets, uint32_t flags,
+                           const Address &address)
+{
+  NS_LOG_FUNCTION (this << packets.size () << flags << address);
+  if (InetSocketAddress::IsMatchingType (address))
+    {
+      InetSocketAddress transport = InetSocketAddress::ConvertFrom (address);
+      return DoSendManyTo (packets, transport.GetIpv4 (), transport.GetPort ());
+    }
+  return Socket::SendManyTo (packets, flags, address);
+}
+
 uint32_t
 UdpSocketImpl::GetRxAvailable (void) const
 {
@@ -862,6 +1002,27 @@ UdpSocketImpl::Recv (uint32_t maxSize, uint32_t flags)
   return p;
 }
 
+uint32_t
+UdpSocketImpl::RecvMany (std::vector<Ptr<Packet> > &packets, uint32_t maxPackets,
+                         uint32_t flags)
+{
+  NS_LOG_FUNCTION (this << maxPackets << flags);
+  uint32_t received = 0;
+  while (received < maxPackets && !m_deliveryQueue.empty ())
+    {
+      Ptr<Packet> p = m_deliveryQueue.front ();
+      m_deliveryQueue.pop ();
+      m_rxAvailable -= p->GetSize ();
+      packets.push_back (p);
+      received++;
+    }
+  if (received == 0)
+    {
+      m_errno = ERROR_AGAIN;
+    }
+  return received;
+}
+
 Ptr<Packet>
 UdpSocketImpl::RecvFrom (uint32_t maxSize, uint32_t flags, 
                          Address &fromAddress)
@@ -22,6 +22,7 @@
 
 #include <stdint.h>
 #include <queue>
+#include <vector>
 #include "ns3/callback.h"
 #include "ns3/traced-callback.h"
 #include "ns3/socket.h"
@@ -92,6 +93,11 @@ public:
   virtual Ptr<Packet> Recv (uint32_t maxSize, uint32_t flags);
   virtual Ptr<Packet> RecvFrom (uint32_t maxSize, uint32_t flags,
                                 Address &fromAddress);
+  virtual int SendMany (const std::vector<Ptr<Packet> > &packets, uint32_t flags);
+  virtual int SendManyTo (const std::vector<Ptr<Packet> > &packets, uint32_t flags,
+                          const Address &address);
+  virtual uint32_t RecvMany (std::vector<Ptr<Packet> > &packets, uint32_t maxPackets,
+                             uint32_t flags);
   virtual int GetSockName (Address &address) const; 
   virtual int MulticastJoinGroup (uint32_t interfaceIndex, const Address &groupAddress);
   virtual int MulticastLeaveGroup (uint32_t interfaceIndex, const Address &groupAddress);
@@ -192,6 +198,25 @@ private:
    * \returns 0 on success, -1 on failure
    */
   int DoSendTo (Ptr<Packet> p, Ipv6Address daddr, uint16_t dport);
+  /**
+   * \brief Send several packets to a specific destination and port (IPv4)
+   *
+   * Routed unicast packets share a single route lookup when the routing
+   * protocol is flow-deterministic (Ipv4RoutingProtocol::IsFlowDeterministic);
+   * the other packets are sent one at a time by DoSendTo ().
+   *
+   * \param packets the packets
+   * \param daddr destination address
+   * \param dport destination port
+   * \returns the number of packets sent, -1 if none could be sent
+   */
+  int DoSendManyTo (const std::vector<Ptr<Packet> > &packets, Ipv4Address daddr, uint16_t dport);
+  /**
+   * \brief Add the packet tags requested by the socket options (IPv4)
+   * \param p packet
+   * \param daddr destination address
+   */
+  void AddIpv4SendTags (Ptr<Packet> p, Ipv4Address daddr) const;
 
   /**
    * \brief Called by the L3 protocol when it received an ICMP packet to pass on to TCP.
@@ -0,0 +1,728 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Tests of the indexed Ipv4EndPointDemux and Ipv6EndPointDemux against
+// a scan of all the end points, and lookup benchmarks with many
+// connections
+
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/ipv6-interface.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simulator.h"
+#include "ns3/private/ipv4-end-point.h"
+#include "ns3/private/ipv4-end-point-demux.h"
+#include "ns3/private/ipv6-end-point.h"
+#include "ns3/private/ipv6-end-point-demux.h"
+
+using namespace ns3;
+
+namespace {
+
+/**
+ * IPv4 types and reference lookups for the demux tests.
+ */
+struct Ipv4Family
+{
+  typedef Ipv4Address Address;          //!< Address type.
+  typedef Ipv4EndPoint EndPoint;        //!< End point type.
+  typedef Ipv4EndPointDemux Demux;      //!< Demux type.
+  typedef Ipv4EndPointDemux::EndPoints EndPoints; //!< End point list type.
+  typedef Ipv4Interface Interface;      //!< Interface type.
+
+  /** \returns the family name. */
+  static std::string Name (void)
+  {
+    return "IPv4";
+  }
+  /** \returns local addresses to draw from, the wildcard included. */
+  static std::vector<Address> LocalAddresses (void)
+  {
+    std::vector<Address> a;
+    a.push_back (Ipv4Address::GetAny ());
+    a.push_back (Ipv4Address ("10.0.0.1"));
+    a.push_back (Ipv4Address ("10.0.1.1"));
+    return a;
+  }
+  /** \returns destination addresses of the packets, broadcasts included. */
+  static std::vector<Address> DestinationAddresses (void)
+  {
+    std::vector<Address> a;
+    a.push_back (Ipv4Address ("10.0.0.1"));
+    a.push_back (Ipv4Address ("10.0.1.1"));
+    a.push_back (Ipv4Address ("10.0.0.255"));
+    a.push_back (Ipv4Address::GetBroadcast ());
+    return a;
+  }
+  /** \returns peer addresses to draw from, the wildcard included. */
+  static std::vector<Address> PeerAddresses (void)
+  {
+    std::vector<Address> a;
+    a.push_back (Ipv4Address::GetAny ());
+    a.push_back (Ipv4Address ("10.0.0.2"));
+    a.push_back (Ipv4Address ("10.0.0.3"));
+    a.push_back (Ipv4Address ("10.0.2.9"));
+    return a;
+  }
+  /**
+   * \param [in] i An index.
+   * \returns a distinct client address for each index.
+   */
+  static Address Client (uint32_t i)
+  {
+    return Ipv4Address (0x0b000000 + i);
+  }
+  /**
+   * \param [in] demux A demux.
+   * \returns all its end points.
+   */
+  static EndPoints GetEndPoints (Demux &demux)
+  {
+    return demux.GetAllEndPoints ();
+  }
+  /** \returns the interface the packets come from. */
+  static Ptr<Interface> CreateInterface (void)
+  {
+    Ptr<Ipv4Interface> interface = CreateObject<Ipv4Interface> ();
+    interface->AddAddress (Ipv4InterfaceAddress (Ipv4Address ("10.0.0.1"),
+                                                 Ipv4Mask ("/24")));
+    return interface;
+  }
+
+  /**
+   * Lookup as the demux did with a scan of all its end points.
+   * \param [in] endPoints All the end points, in allocation order.
+   * \param [in] daddr Destination address.
+   * \param [in] dport Destination port.
+   * \param [in] saddr Source address.
+   * \param [in] sport Source port.
+   * \param [in] incomingInterface Incoming interface.
+   * \returns the matching end points.
+   */
+  static EndPoints Lookup (const EndPoints &endPoints,
+                           Address daddr, uint16_t dport,
+                           Address saddr, uint16_t sport,
+                           Ptr<Interface> incomingInterface)
+  {
+    EndPoints retval1, retval2, retval3, retval4;
+    for (EndPoints::const_iterator i = endPoints.begin (); i != endPoints.end (); i++)
+      {
+        Ipv4EndPoint *endP = *i;
+        if (!endP->IsRxEnabled () || endP->GetLocalPort () != dport)
+          {
+            continue;
+          }
+        if (endP->GetBoundNetDevice ()
+            && endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
+          {
+            continue;
+          }
+        bool subnetDirected = false;
+        Ipv4Address incomingInterfaceAddr = daddr;
+        for (uint32_t j = 0; j < incomingInterface->GetNAddresses (); j++)
+          {
+            Ipv4InterfaceAddress addr = incomingInterface->GetAddress (j);
+            if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ())
+                && daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
+              {
+                subnetDirected = true;
+                incomingInterfaceAddr = addr.GetLocal ();
+              }
+          }
+        bool isBroadcast = daddr.IsBroadcast () || subnetDirected;
+        bool localWild = endP->GetLocalAddress () == Ipv4Address::GetAny ();
+        bool localExact = endP->GetLocalAddress () == daddr;
+        if (isBroadcast && !localWild)
+          {
+            localExact = endP->GetLocalAddress () == incomingInterfaceAddr;
+          }
+        if (!(localExact || localWild))
+          {
+            continue;
+          }
+        bool portExact = endP->GetPeerPort () == sport;
+        bool portWild = endP->GetPeerPort () == 0;
+        bool addrExact = endP->GetPeerAddress () == saddr;
+        bool addrWild = endP->GetPeerAddress () == Ipv4Address::GetAny ();
+        if (!(portExact || portWild) || !(addrExact || addrWild))
+          {
+            continue;
+          }
+        if (localWild && portWild && addrWild)
+          {
+            retval1.push_back (endP);
+          }
+        if ((localExact || (isBroadcast && localWild)) && portWild && addrWild)
+          {
+            retval2.push_back (endP);
+          }
+        if (localWild && portExact && addrExact)
+          {
+            retval3.push_back (endP);
+          }
+        if (localExact && portExact && addrExact)
+          {
+            retval4.push_back (endP);
+          }
+      }
+    if (!retval4.empty ())
+      {
+        return retval4;
+      }
+    if (!retval3.empty ())
+      {
+        return retval3;
+      }
+    if (!retval2.empty ())
+      {
+        return retval2;
+      }
+    return retval1;
+  }
+};
+
+/**
+ * IPv6 types and reference lookups for the demux tests.
+ */
+struct Ipv6Family
+{
+  typedef Ipv6Address Address;          //!< Address type.
+  typedef Ipv6EndPoint EndPoint;        //!< End point type.
+  typedef Ipv6EndPointDemux Demux;      //!< Demux type.
+  typedef Ipv6EndPointDemux::EndPoints EndPoints; //!< End point list type.
+  typedef Ipv6Interface Interface;      //!< Interface type.
+
+  /** \returns the family name. */
+  static std::string Name (void)
+  {
+    return "IPv6";
+  }
+  /** \returns local addresses to draw from, the wildcard included. */
+  static std::vector<Address> LocalAddresses (void)
+  {
+    std::vector<Address> a;
+    a.push_back (Ipv6Address::GetAny ());
+    a.push_back (Ipv6Address ("2001:1::1"));
+    a.push_back (Ipv6Address ("2001:2::1"));
+    a.push_back (Ipv6Address::GetAllRoutersMulticast ());
+    return a;
+  }
+  /** \returns destination addresses of the packets, multicast included. */
+  static std::vector<Address> DestinationAddresses (void)
+  {
+    std::vector<Address> a;
+    a.push_back (Ipv6Address ("2001:1::1"));
+    a.push_back (Ipv6Address ("2001:2::1"));
+    a.push_back (Ipv6Address::GetAllRoutersMulticast ());
+    return a;
+  }
+  /** \returns peer addresses to draw from, the wildcard included. */
+  static std::vector<Address> PeerAddresses (void)
+  {
+    std::vector<Address> a;
+    a.push_back (Ipv6Address::GetAny ());
+    a.push_back (Ipv6Address ("2001:1::2"));
+    a.push_back (Ipv6Address ("2001:1::3"));
+    a.push_back (Ipv6Address ("2001:3::9"));
+    return a;
+  }
+  /**
+   * \param [in] i An index.
+   * \returns a distinct client address for each index.
+   */
+  static Address Client (uint32_t i)
+  {
+    uint8_t buf[16] = { 0x20, 0x01, 0x0b };
+    buf[12] = (i >> 24) & 0xff;
+    buf[13] = (i >> 16) & 0xff;
+    buf[14] = (i >> 8) & 0xff;
+    buf[15] = i & 0xff;
+    return Ipv6Address (buf);
+  }
+  /**
+   * \param [in] demux A demux.
+   * \returns all its end points.
+   */
+  static EndPoints GetEndPoints (Demux &demux)
+  {
+    return demux.GetEndPoints ();
+  }
+  /** \returns the interface the packets come from. */
+  static Ptr<Interface> CreateInterface (void)
+  {
+    return CreateObject<Ipv6Interface> ();
+  }
+
+  /**
+   * Lookup as the demux did with a scan of all its end points.
+   * \param [in] endPoints All the end points, in allocation order.
+   * \param [in] daddr Destination address.
+   * \param [in] dport Destination port.
+   * \param [in] saddr Source address.
+   * \param [in] sport Source port.
+   * \param [in] incomingInterface Incoming interface.
+   * \returns the matching end points.
+   */
+  static EndPoints Lookup (const EndPoints &endPoints,
+                           Address daddr, uint16_t dport,
+                           Address saddr, uint16_t sport,
+                           Ptr<Interface> incomingInterface)
+  {
+    EndPoints retval1, retval2, retval3, retval4;
+    for (EndPoints::const_iterator i = endPoints.begin (); i != endPoints.end (); i++)
+      {
+        Ipv6EndPoint *endP = *i;
+        if (!endP->IsRxEnabled () || endP->GetLocalPort () != dport)
+          {
+            continue;
+          }
+        if (endP->GetBoundNetDevice ()
+            && (!incomingInterface
+                || endP->GetBoundNetDevice () != incomingInterface->GetDevice ()))
+          {
+            continue;
+          }
+        bool localWild = endP->GetLocalAddress () == Ipv6Address::GetAny ();
+        bool localExact = endP->GetLocalAddress () == daddr;
+        bool localAllRouters = endP->GetLocalAddress () == Ipv6Address::GetAllRoutersMulticast ();
+        if (!(localExact || localWild))
+          {
+            continue;
+          }
+        bool portExact = endP->GetPeerPort () == sport;
+        bool portWild = endP->GetPeerPort () == 0;
+        bool addrExact = endP->GetPeerAddress () == saddr;
+        bool addrWild = endP->GetPeerAddress () == Ipv6Address::GetAny ();
+        if (!(portExact || portWild) || !(addrExact || addrWild))
+          {
+            continue;
+          }
+        if (localWild && portWild && addrWild)
+          {
+            retval1.push_back (endP);
+          }
+        if ((localExact || localAllRouters) && portWild && addrWild)
+          {
+            retval2.push_back (endP);
+          }
+        if (localWild && portExact && addrExact)
+          {
+            retval3.push_back (endP);
+          }
+        if (localExact && portExact && addrExact)
+          {
+            retval4.push_back (endP);
+          }
+      }
+    if (!retval4.empty ())
+      {
+        return retval4;
+      }
+    if (!retval3.empty ())
+      {
+        return retval3;
+      }
+    if (!retval2.empty ())
+      {
+        return retval2;
+      }
+    return retval1;
+  }
+};
+
+/**
+ * SimpleLookup as the demux did with a scan of all its end points.
+ * \param [in] endPoints All the end points, in allocation order.
+ * \param [in] daddr Destination address.
+ * \param [in] dport Destination port.
+ * \param [in] saddr Source address.
+ * \param [in] sport Source port.
+ * \returns the best match, or 0.
+ */
+template <typename F>
+typename F::EndPoint *
+ReferenceSimpleLookup (const typename F::EndPoints &endPoints,
+                       typename F::Address daddr, uint16_t dport,
+                       typename F::Address saddr, uint16_t sport)
+{
+  uint32_t genericity = 3;
+  typename F::EndPoint *generic = 0;
+  for (typename F::EndPoints::const_iterator i = endPoints.begin (); i != endPoints.end (); i++)
+    {
+      if ((*i)->GetLocalPort () != dport)
+        {
+          continue;
+        }
+      if ((*i)->GetLocalAddress () == daddr
+          && (*i)->GetPeerPort () == sport
+          && (*i)->GetPeerAddress () == saddr)
+        {
+          return *i;
+        }
+      uint32_t tmp = 0;
+      if ((*i)->GetLocalAddress () == F::Address::GetAny ())
+        {
+          tmp++;
+        }
+      if ((*i)->GetPeerAddress () == F::Address::GetAny ())
+        {
+          tmp++;
+        }
+      if (tmp < genericity)
+        {
+          generic = *i;
+          genericity = tmp;
+        }
+    }
+  return generic;
+}
+
+/**
+ * \param [in] endPoints End points.
+ * \param [in] address Local address.
+ * \param [in] port Local port.
+ * \returns true if an end point is bound to the address and port.
+ */
+template <typename F>
+bool
+ReferenceLookupLocal (const typename F::EndPoints &endPoints,
+                      typename F::Address address, uint16_t port)
+{
+  for (typename F::EndPoints::const_iterator i = endPoints.begin (); i != endPoints.end (); i++)
+    {
+      if ((*i)->GetLocalPort () == port && (*i)->GetLocalAddress () == address)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+/**
+ * \param [in] endPoints End points.
+ * \param [in] local Local address.
+ * \param [in] localPort Local port.
+ * \param [in] peer Peer address.
+ * \param [in] peerPort Peer port.
+ * \returns true if an end point has exactly this four-tuple.
+ */
+template <typename F>
+bool
+ReferenceLookupExact (const typename F::EndPoints &endPoints,
+                      typename F::Address local, uint16_t localPort,
+                      typename F::Address peer, uint16_t peerPort)
+{
+  for (typename F::EndPoints::const_iterator i = endPoints.begin (); i != endPoints.end (); i++)
+    {
+      if ((*i)->GetLocalPort () == localPort && (*i)->GetLocalAddress () == local
+          && (*i)->GetPeerPort () == peerPort && (*i)->GetPeerAddress () == peer)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+} // anonymous namespace
+
+
+/**
+ * \ingroup internet-test
+ * Compare the lookups of an end point demux with a scan of all its end
+ * points, through random allocations, peer changes and deallocations.
+ */
+template <typename F>
+class EndPointDemuxTestCase : public TestCase
+{
+public:
+  EndPointDemuxTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * Check random lookups against the reference scans.
+   * \param [in] demux The demux.
+   * \param [in] endPoints The live end points, in allocation order.
+   */
+  void Check (typename F::Demux &demux, const typename F::EndPoints &endPoints);
+
+  Ptr<UniformRandomVariable> m_rng;        //!< Random stream.
+  Ptr<typename F::Interface> m_interface;  //!< Incoming interface.
+};
+
+template <typename F>
+EndPointDemuxTestCase<F>::EndPointDemuxTestCase ()
+  : TestCase ("Check " + F::Name () + " end point lookups against a scan")
+{
+}
+
+template <typename F>
+void
+EndPointDemuxTestCase<F>::Check (typename F::Demux &demux,
+                                 const typename F::EndPoints &endPoints)
+{
+  static const uint16_t ports[] = { 80, 81, 1000, 1001, 49153 };
+  static const uint16_t peerPorts[] = { 0, 1000, 1001 };
+  std::vector<typename F::Address> daddrs = F::DestinationAddresses ();
+  std::vector<typename F::Address> saddrs = F::PeerAddresses ();
+  std::vector<typename F::Address> locals = F::LocalAddresses ();
+
+  NS_TEST_ASSERT_MSG_EQ ((F::GetEndPoints (demux) == endPoints), true,
+                         "End points differ");
+  for (uint32_t k = 0; k < 20; k++)
+    {
+      typename F::Address daddr = daddrs[m_rng->GetInteger (0, daddrs.size () - 1)];
+      typename F::Address saddr = saddrs[m_rng->GetInteger (0, saddrs.size () - 1)];
+      uint16_t dport = ports[m_rng->GetInteger (0, 4)];
+      uint16_t sport = peerPorts[m_rng->GetInteger (0, 2)];
+      typename F::EndPoints expected = F::Lookup (endPoints, daddr, dport, saddr, sport, m_interface);
+      typename F::EndPoints found = demux.Lookup (daddr, dport, saddr, sport, m_interface);
+      NS_TEST_ASSERT_MSG_EQ ((found == expected), true,
+                             "Lookup " << daddr << ":" << dport << " from "
+                                       << saddr << ":" << sport << " differs");
+      NS_TEST_ASSERT_MSG_EQ (demux.SimpleLookup (daddr, dport, saddr, sport),
+                             ReferenceSimpleLookup<F> (endPoints, daddr, dport, saddr, sport),
+                             "SimpleLookup differs");
+      typename F::Address local = locals[m_rng->GetInteger (0, locals.size () - 1)];
+      NS_TEST_ASSERT_MSG_EQ (demux.LookupLocal (local, dport),
+                             ReferenceLookupLocal<F> (endPoints, local, dport),
+                             "LookupLocal differs");
+      bool used = false;
+      for (typename F::EndPoints::const_iterator i = endPoints.begin (); i != endPoints.end (); i++)
+        {
+          used = used || (*i)->GetLocalPort () == dport;
+        }
+      NS_TEST_ASSERT_MSG_EQ (demux.LookupPortLocal (dport), used, "LookupPortLocal differs");
+    }
+}
+
+template <typename F>
+void
+EndPointDemuxTestCase<F>::DoRun (void)
+{
+  m_rng = CreateObject<UniformRandomVariable> ();
+  m_interface = F::CreateInterface ();
+  static const uint16_t ports[] = { 80, 81, 1000, 1001 };
+  static const uint16_t peerPorts[] = { 0, 1000, 1001 };
+  std::vector<typename F::Address> locals = F::LocalAddresses ();
+  std::vector<typename F::Address> peers = F::PeerAddresses ();
+
+  typename F::Demux demux;
+  typename F::EndPoints endPoints;
+  for (uint32_t step = 0; step < 400; step++)
+    {
+      typename F::Address local = locals[m_rng->GetInteger (0, locals.size () - 1)];
+      typename F::Address peer = peers[m_rng->GetInteger (0, peers.size () - 1)];
+      uint16_t port = ports[m_rng->GetInteger (0, 3)];
+      uint16_t peerPort = peerPorts[m_rng->GetInteger (0, 2)];
+      typename F::EndPoint *endPoint = 0;
+      uint32_t op = m_rng->GetInteger (0, 9);
+      if (op == 0)
+        {
+          endPoint = demux.Allocate ();
+          NS_TEST_ASSERT_MSG_NE (endPoint, 0, "Ephemeral allocation failed");
+        }
+      else if (op == 1)
+        {
+          bool duplicate = ReferenceLookupLocal<F> (endPoints, local, port);
+          endPoint = demux.Allocate (local, port);
+          NS_TEST_ASSERT_MSG_EQ ((endPoint == 0), duplicate, "Bind allocation differs");
+        }
+      else if (op <= 3)
+        {
+          bool duplicate = ReferenceLookupExact<F> (endPoints, local, port, peer, peerPort);
+          endPoint = demux.Allocate (local, port, peer, peerPort);
+          NS_TEST_ASSERT_MSG_EQ ((endPoint == 0), duplicate, "Connection allocation differs");
+        }
+      else if (op <= 5 && !endPoints.empty ())
+        {
+          typename F::EndPoints::iterator i = endPoints.begin ();
+          std::advance (i, m_rng->GetInteger (0, endPoints.size () - 1));
+          (*i)->SetPeer (peer, peerPort);
+        }
+      else if (op == 6 && !endPoints.empty ())
+        {
+          typename F::EndPoints::iterator i = endPoints.begin ();
+          std::advance (i, m_rng->GetInteger (0, endPoints.size () - 1));
+          (*i)->SetRxEnabled (m_rng->GetInteger (0, 3) != 0);
+        }
+      else if (!endPoints.empty ())
+        {
+          typename F::EndPoints::iterator i = endPoints.begin ();
+          std::advance (i, m_rng->GetInteger (0, endPoints.size () - 1));
+          demux.DeAllocate (*i);
+          endPoints.erase (i);
+        }
+      if (endPoint != 0)
+        {
+          endPoints.push_back (endPoint);
+        }
+      Check (demux, endPoints);
+    }
+  m_interface = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * End point demux test suite.
+ */
+class EndPointDemuxTestSuite : public TestSuite
+{
+public:
+  EndPointDemuxTestSuite ();
+};
+
+EndPointDemuxTestSuite::EndPointDemuxTestSuite ()
+  : TestSuite ("end-point-demux", UNIT)
+{
+  AddTestCase (new EndPointDemuxTestCase<Ipv4Family>, TestCase::QUICK);
+  AddTestCase (new EndPointDemuxTestCase<Ipv6Family>, TestCase::QUICK);
+}
+
+static EndPointDemuxTestSuite g_endPointDemuxTestSuite;
+
+
+/**
+ * \ingroup internet-test
+ * Measure the end point demux costs of a server with many connections
+ * to one listening port.
+ */
+template <typename F>
+class EndPointDemuxPerfTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] connections The number of connections.
+   */
+  EndPointDemuxPerfTestCase (uint32_t connections);
+private:
+  virtual void DoRun (void);
+  /**
+   * Print a measurement.
+   * \param [in] what The operation measured.
+   * \param [in] start The clock at the start of the operations.
+   * \param [in] n The number of operations.
+   */
+  void Report (const std::string what, std::clock_t start, uint32_t n);
+  uint32_t m_connections; //!< Number of connections.
+};
+
+template <typename F>
+EndPointDemuxPerfTestCase<F>::EndPointDemuxPerfTestCase (uint32_t connections)
+  : TestCase ("Measure " + F::Name () + " end point demux costs"),
+    m_connections (connections)
+{
+}
+
+template <typename F>
+void
+EndPointDemuxPerfTestCase<F>::Report (const std::string what, std::clock_t start, uint32_t n)
+{
+  double per = 1e9 * double (std::clock () - start) / (double (n) * CLOCKS_PER_SEC);
+  std::cout << GetParent ()->GetName () << ": "
+            << F::Name () << " " << std::left << std::setw (20) << what << std::right
+            << std::setw (8) << m_connections << " connections "
+            << std::fixed << std::setprecision (1) << std::setw (10) << per
+            << " ns/op" << std::endl;
+}
+
+template <typename F>
+void
+EndPointDemuxPerfTestCase<F>::DoRun (void)
+{
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (2);
+  Ptr<typename F::Interface> interface = F::CreateInterface ();
+  typename F::Address server = F::LocalAddresses ()[1];
+  const uint16_t port = 80;
+  const uint32_t perClient = 1000;
+
+  // The accepted connections of a listening socket, as TcpL4Protocol
+  // allocates them: many clients with a few ports each.
+  typename F::Demux demux;
+  NS_TEST_ASSERT_MSG_NE (demux.Allocate (port), 0, "Listener allocation failed");
+  std::vector<typename F::EndPoint *> connections;
+  std::clock_t start = std::clock ();
+  for (uint32_t i = 0; i < m_connections; i++)
+    {
+      connections.push_back (demux.Allocate (server, port, F::Client (i / perClient),
+                                             49152 + i % perClient));
+    }
+  Report ("allocate", start, m_connections);
+
+  const uint32_t lookups = 20000;
+  uint32_t found = 0;
+  start = std::clock ();
+  for (uint32_t k = 0; k < lookups; k++)
+    {
+      uint32_t i = rng->GetInteger (0, m_connections - 1);
+      typename F::EndPoints endPoints = demux.Lookup (server, port, F::Client (i / perClient),
+                                                      49152 + i % perClient, interface);
+      if (endPoints.size () == 1 && endPoints.front () == connections[i])
+        {
+          found++;
+        }
+    }
+  Report ("lookup connection", start, lookups);
+  NS_TEST_ASSERT_MSG_EQ (found, lookups, "Connection lookups failed");
+
+  found = 0;
+  start = std::clock ();
+  for (uint32_t k = 0; k < lookups; k++)
+    {
+      typename F::EndPoints endPoints = demux.Lookup (server, port, F::Client (k), 1000, interface);
+      found += endPoints.size ();
+    }
+  Report ("lookup listener", start, lookups);
+  NS_TEST_ASSERT_MSG_EQ (found, lookups, "Listener lookups failed");
+
+  start = std::clock ();
+  for (uint32_t i = 0; i < m_connections; i++)
+    {
+      demux.DeAllocate (connections[i]);
+    }
+  Report ("deallocate", start, m_connections);
+  interface = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * End point demux performance suite.
+ */
+class EndPointDemuxPerfTestSuite : public TestSuite
+{
+public:
+  EndPointDemuxPerfTestSuite ();
+};
+
+EndPointDemuxPerfTestSuite::EndPointDemuxPerfTestSuite ()
+  : TestSuite ("end-point-demux-perf", PERFORMANCE)
+{
+  AddTestCase (new EndPointDemuxPerfTestCase<Ipv4Family> (1000), TestCase::QUICK);
+  AddTestCase (new EndPointDemuxPerfTestCase<Ipv4Family> (10000), TestCase::QUICK);
+  AddTestCase (new EndPointDemuxPerfTestCase<Ipv4Family> (50000), TestCase::QUICK);
+  AddTestCase (new EndPointDemuxPerfTestCase<Ipv6Family> (50000), TestCase::QUICK);
+}
+
+static EndPointDemuxPerfTestSuite g_endPointDemuxPerfTestSuite;
@@ -27,6 +27,7 @@
 #include "ns3/candidate-queue.h"
 #include "ns3/simulator.h"
 #include <cstdlib> // for rand()
+#include <vector>
 
 using namespace ns3;
 
@@ -53,13 +54,43 @@ GlobalRouteManagerImplTestCase::DoRun (void)
       candidate.Push (v);
     }
 
+  uint32_t last = 0;
   for (int i = 0; i < 100; ++i)
     {
       SPFVertex *v = candidate.Pop ();
+      NS_TEST_ASSERT_MSG_EQ ((v->GetDistanceFromRoot () >= last), true,
+                             "Candidates out of order");
+      last = v->GetDistanceFromRoot ();
       delete v;
       v = 0;
     }
 
+  // Lower the distance of queued candidates
+  std::vector<SPFVertex *> vertices;
+  for (int i = 0; i < 50; ++i)
+    {
+      SPFVertex *v = new SPFVertex;
+      v->SetDistanceFromRoot (100 + std::rand () % 100);
+      candidate.Push (v);
+      vertices.push_back (v);
+    }
+  for (int i = 0; i < 50; i += 2)
+    {
+      vertices[i]->SetDistanceFromRoot (std::rand () % 100);
+      candidate.Update (vertices[i]);
+    }
+  last = 0;
+  for (int i = 0; i < 50; ++i)
+    {
+      SPFVertex *v = candidate.Pop ();
+      NS_TEST_ASSERT_MSG_EQ ((v->GetDistanceFromRoot () >= last), true,
+                             "Updated candidates out of order");
+      NS_TEST_ASSERT_MSG_EQ ((v->GetDistanceFromRoot () < 100), (i < 25),
+                             "Updated candidate not moved");
+      last = v->GetDistanceFromRoot ();
+      delete v;
+    }
+
   // Build fake link state database; four routers (0-3), 3 point-to-point
   // links
   //
@@ -0,0 +1,465 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ns3/global-router-interface.h"
+#include "ns3/global-value.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/ipv4-interface-container.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/node-container.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+#include "ns3/uinteger.h"
+
+using namespace ns3;
+
+namespace {
+
+/** Both ends of a link: the Ipv4 objects and interface indices. */
+typedef std::vector<std::pair<Ptr<Ipv4>, uint32_t> > GridLink;
+
+/**
+ * Build a grid of routers joined by point-to-point links.
+ *
+ * Router 0 also gets a stub node hanging off it, and routers 0, 1 and
+ * the one below 0 share a broadcast network when asked for.
+ *
+ * \param [in] rows The number of rows.
+ * \param [in] cols The number of columns.
+ * \param [in] shared Whether to add the shared network.
+ * \param [out] nodes The nodes, routers first.
+ * \param [out] links The grid links, then the stub link, then the
+ *              shared network.
+ */
+void
+BuildGrid (uint32_t rows, uint32_t cols, bool shared,
+           NodeContainer &nodes, std::vector<GridLink> &links)
+{
+  nodes.Create (rows * cols + 1);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+
+  SimpleNetDeviceHelper devHelper;
+  devHelper.SetNetDevicePointToPointMode (true);
+  Ipv4AddressHelper address;
+  address.SetBase ("10.0.0.0", "255.255.255.252");
+
+  std::vector<std::pair<uint32_t, uint32_t> > pairs;
+  for (uint32_t r = 0; r < rows; r++)
+    {
+      for (uint32_t c = 0; c < cols; c++)
+        {
+          uint32_t n = r * cols + c;
+          if (c + 1 < cols)
+            {
+              pairs.push_back (std::make_pair (n, n + 1));
+            }
+          if (r + 1 < rows)
+            {
+              pairs.push_back (std::make_pair (n, n + cols));
+            }
+        }
+    }
+  pairs.push_back (std::make_pair (0, rows * cols));
+
+  for (uint32_t i = 0; i < pairs.size (); i++)
+    {
+      NetDeviceContainer devices =
+        devHelper.Install (NodeContainer (nodes.Get (pairs[i].first),
+                                          nodes.Get (pairs[i].second)));
+      Ipv4InterfaceContainer interfaces = address.Assign (devices);
+      address.NewNetwork ();
+      links.push_back (GridLink (interfaces.Begin (), interfaces.End ()));
+    }
+
+  if (shared)
+    {
+      devHelper.SetNetDevicePointToPointMode (false);
+      NetDeviceContainer devices =
+        devHelper.Install (NodeContainer (nodes.Get (0), nodes.Get (1),
+                                          nodes.Get (cols)));
+      address.SetBase ("172.16.0.0", "255.255.255.0");
+      Ipv4InterfaceContainer interfaces = address.Assign (devices);
+      links.push_back (GridLink (interfaces.Begin (), interfaces.End ()));
+    }
+}
+
+/**
+ * Set the state of both ends of a link.
+ * \param [in] link The link.
+ * \param [in] up Whether to bring the link up or down.
+ */
+void
+SetLinkUp (const GridLink &link, bool up)
+{
+  for (uint32_t i = 0; i < link.size (); i++)
+    {
+      if (up)
+        {
+          link[i].first->SetUp (link[i].second);
+        }
+      else
+        {
+          link[i].first->SetDown (link[i].second);
+        }
+    }
+}
+
+/**
+ * Count the global routes of some nodes.
+ * \param [in] nodes The nodes.
+ * \returns the number of routes.
+ */
+uint32_t
+CountRoutes (const NodeContainer &nodes)
+{
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      n += nodes.Get (i)->GetObject<GlobalRouter> ()->GetRoutingProtocol ()->GetNRoutes ();
+    }
+  return n;
+}
+
+/**
+ * Describe the global routes of some nodes.
+ * \param [in] nodes The nodes.
+ * \param [in] sorted Whether to sort the routes of each node.
+ * \returns one string per route.
+ */
+std::vector<std::string>
+DumpRoutes (const NodeContainer &nodes, bool sorted)
+{
+  std::vector<std::string> dump;
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      Ptr<Ipv4GlobalRouting> routing =
+        nodes.Get (i)->GetObject<GlobalRouter> ()->GetRoutingProtocol ();
+      std::vector<std::string> routes;
+      for (uint32_t j = 0; j < routing->GetNRoutes (); j++)
+        {
+          std::ostringstream oss;
+          oss << "node " << i << ": " << *routing->GetRoute (j);
+          routes.push_back (oss.str ());
+        }
+      if (sorted)
+        {
+          std::sort (routes.begin (), routes.end ());
+        }
+      dump.insert (dump.end (), routes.begin (), routes.end ());
+    }
+  return dump;
+}
+
+} // anonymous namespace
+
+
+/**
+ * \ingroup internet-test
+ * Check that incremental route updates match a full recomputation,
+ * across random link failures, repairs and metric changes.
+ */
+class GlobalRoutingUpdateTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] shared Whether the grid includes a shared network.
+   */
+  GlobalRoutingUpdateTestCase (bool shared);
+private:
+  virtual void DoRun (void);
+  /**
+   * Compare the current routes with a full recomputation.
+   * \param [in] nodes The nodes.
+   * \param [in] step The step checked.
+   */
+  void Check (const NodeContainer &nodes, uint32_t step);
+  bool m_shared; //!< Whether the grid includes a shared network.
+};
+
+GlobalRoutingUpdateTestCase::GlobalRoutingUpdateTestCase (bool shared)
+  : TestCase (shared ? "Update routes with a shared network"
+                     : "Update routes of point-to-point links"),
+    m_shared (shared)
+{
+}
+
+void
+GlobalRoutingUpdateTestCase::Check (const NodeContainer &nodes, uint32_t step)
+{
+  std::vector<std::string> updated = DumpRoutes (nodes, true);
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  std::vector<std::string> computed = DumpRoutes (nodes, true);
+  std::sort (updated.begin (), updated.end ());
+  std::sort (computed.begin (), computed.end ());
+  std::vector<std::string> extra;
+  std::vector<std::string> missing;
+  std::set_difference (updated.begin (), updated.end (), computed.begin (), computed.end (),
+                       std::back_inserter (extra));
+  std::set_difference (computed.begin (), computed.end (), updated.begin (), updated.end (),
+                       std::back_inserter (missing));
+  NS_TEST_EXPECT_MSG_EQ (extra.size (), 0, "Extra routes at step " << step
+                         << (extra.empty () ? "" : ", " + extra.front ()));
+  NS_TEST_EXPECT_MSG_EQ (missing.size (), 0, "Missing routes at step " << step
+                         << (missing.empty () ? "" : ", " + missing.front ()));
+}
+
+void
+GlobalRoutingUpdateTestCase::DoRun (void)
+{
+  const uint32_t rows = 4;
+  const uint32_t cols = 5;
+  NodeContainer nodes;
+  std::vector<GridLink> links;
+  BuildGrid (rows, cols, m_shared, nodes, links);
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (1);
+  std::vector<bool> up (links.size (), true);
+  for (uint32_t step = 0; step < 40; step++)
+    {
+      uint32_t i = rng->GetInteger (0, links.size () - 1);
+      switch (rng->GetInteger (0, 2))
+        {
+        case 0:
+          up[i] = !up[i];
+          SetLinkUp (links[i], up[i]);
+          break;
+        case 1:
+          {
+            // One end only: the other end still advertises the link.
+            uint32_t end = rng->GetInteger (0, links[i].size () - 1);
+            links[i][end].first->SetDown (links[i][end].second);
+            up[i] = false;
+            break;
+          }
+        default:
+          links[i][0].first->SetMetric (links[i][0].second,
+                                        rng->GetInteger (1, 4));
+          break;
+        }
+      Ipv4GlobalRoutingHelper::UpdateRoutingTables ();
+      // Chain some updates before checking, and check the others
+      // against the state left by a full computation.
+      if (step % 3 != 0)
+        {
+          Check (nodes, step);
+        }
+    }
+
+  // Detach and attach again the stub node.
+  const GridLink &stub = links[(rows - 1) * cols + rows * (cols - 1)];
+  for (uint32_t step = 40; step < 43; step++)
+    {
+      SetLinkUp (stub, step % 2 == 0);
+      Ipv4GlobalRoutingHelper::UpdateRoutingTables ();
+      Check (nodes, step);
+    }
+
+  Simulator::Destroy ();
+}
+
+
+/**
+ * \ingroup internet-test
+ * Check that routes computed by several threads are the routes
+ * computed by one.
+ */
+class GlobalRoutingThreadsTestCase : public TestCase
+{
+public:
+  GlobalRoutingThreadsTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+GlobalRoutingThreadsTestCase::GlobalRoutingThreadsTestCase ()
+  : TestCase ("Compute routes on several threads")
+{
+}
+
+void
+GlobalRoutingThreadsTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  std::vector<GridLink> links;
+  BuildGrid (4, 5, true, nodes, links);
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  std::vector<std::string> single = DumpRoutes (nodes, false);
+
+  GlobalValue::Bind ("GlobalRoutingThreads", UintegerValue (3));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  std::vector<std::string> threaded = DumpRoutes (nodes, false);
+  NS_TEST_EXPECT_MSG_EQ ((single == threaded), true,
+                         "Threads computed different routes");
+
+  SetLinkUp (links[3], false);
+  Ipv4GlobalRoutingHelper::UpdateRoutingTables ();
+  threaded = DumpRoutes (nodes, true);
+  GlobalValue::Bind ("GlobalRoutingThreads", UintegerValue (1));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  single = DumpRoutes (nodes, true);
+  NS_TEST_EXPECT_MSG_EQ ((single == threaded), true,
+                         "Threads updated different routes");
+
+  Simulator::Destroy ();
+}
+
+
+/**
+ * \ingroup internet-test
+ * Global routing update test suite.
+ */
+class GlobalRoutingUpdateTestSuite : public TestSuite
+{
+public:
+  GlobalRoutingUpdateTestSuite ();
+};
+
+GlobalRoutingUpdateTestSuite::GlobalRoutingUpdateTestSuite ()
+  : TestSuite ("global-routing-update", UNIT)
+{
+  AddTestCase (new GlobalRoutingUpdateTestCase (false), TestCase::QUICK);
+  AddTestCase (new GlobalRoutingUpdateTestCase (true), TestCase::QUICK);
+  AddTestCase (new GlobalRoutingThreadsTestCase, TestCase::QUICK);
+}
+
+static GlobalRoutingUpdateTestSuite g_globalRoutingUpdateTestSuite;
+
+
+/**
+ * \ingroup internet-test
+ * Measure the time to compute the global routes of a grid, and to
+ * update them after a link failure.
+ */
+class GlobalRoutingPerfTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] side The number of routers on a side of the grid.
+   */
+  GlobalRoutingPerfTestCase (uint32_t side);
+private:
+  virtual void DoRun (void);
+  /**
+   * Print a measure.
+   * \param [in] what The operation measured.
+   * \param [in] start The clock at the start of the operation.
+   */
+  void Report (const std::string what, std::clock_t start);
+  uint32_t m_side; //!< Number of routers on a side of the grid.
+};
+
+GlobalRoutingPerfTestCase::GlobalRoutingPerfTestCase (uint32_t side)
+  : TestCase ("Measure global route computation time"),
+    m_side (side)
+{
+}
+
+void
+GlobalRoutingPerfTestCase::Report (const std::string what, std::clock_t start)
+{
+  double ms = 1e3 * double (std::clock () - start) / CLOCKS_PER_SEC;
+  std::cout << GetParent ()->GetName () << ": "
+            << std::left << std::setw (32) << what << std::right
+            << std::setw (6) << m_side * m_side << " routers "
+            << std::fixed << std::setprecision (1) << std::setw (10) << ms
+            << " ms" << std::endl;
+}
+
+void
+GlobalRoutingPerfTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  std::vector<GridLink> links;
+  BuildGrid (m_side, m_side, false, nodes, links);
+
+  std::clock_t start = std::clock ();
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  Report ("Populate", start);
+
+  // A link in the middle of the grid.
+  const GridLink &link = links[links.size () / 2];
+  SetLinkUp (link, false);
+  start = std::clock ();
+  Ipv4GlobalRoutingHelper::UpdateRoutingTables ();
+  Report ("Update after a link failure", start);
+  uint32_t updated = CountRoutes (nodes);
+
+  start = std::clock ();
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  Report ("Recompute after a link failure", start);
+  NS_TEST_EXPECT_MSG_EQ (updated, CountRoutes (nodes),
+                         "Update and recompute differ");
+
+  // The link to the stub node: only the routes to the node change.
+  SetLinkUp (links[links.size () - 1], false);
+  start = std::clock ();
+  Ipv4GlobalRoutingHelper::UpdateRoutingTables ();
+  Report ("Update after a stub link failure", start);
+  updated = CountRoutes (nodes);
+
+  start = std::clock ();
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  Report ("Recompute after a stub link failure", start);
+  NS_TEST_EXPECT_MSG_EQ (updated, CountRoutes (nodes),
+                         "Update and recompute differ");
+
+  GlobalValue::Bind ("GlobalRoutingThreads", UintegerValue (4));
+  start = std::clock ();
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  Report ("Recompute on 4 threads (cpu)", start);
+  GlobalValue::Bind ("GlobalRoutingThreads", UintegerValue (1));
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * Global route computation performance suite.
+ */
+class GlobalRoutingPerfTestSuite : public TestSuite
+{
+public:
+  GlobalRoutingPerfTestSuite ();
+};
+
+GlobalRoutingPerfTestSuite::GlobalRoutingPerfTestSuite ()
+  : TestSuite ("global-routing-perf", PERFORMANCE)
+{
+  AddTestCase (new GlobalRoutingPerfTestCase (10), TestCase::QUICK);
+  AddTestCase (new GlobalRoutingPerfTestCase (20), TestCase::QUICK);
+  AddTestCase (new GlobalRoutingPerfTestCase (30), TestCase::QUICK);
+}
+
+static GlobalRoutingPerfTestSuite g_globalRoutingPerfTestSuite;
@@ -31,6 +31,7 @@
 #include "error-channel.h"
 #include "ns3/simple-net-device.h"
 #include "ns3/simple-net-device-helper.h"
+#include "ns3/simple-channel.h"
 #include "ns3/drop-tail-queue.h"
 #include "ns3/socket.h"
 #include "ns3/udp-socket.h"
@@ -50,6 +51,11 @@
 
 #include <string>
 #include <limits>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <vector>
 #include <netinet/in.h>
 
 using namespace ns3;
@@ -452,6 +458,318 @@ Ipv4FragmentationTest::DoRun (void)
 
   Simulator::Destroy ();
 }
+//-----------------------------------------------------------------------------
+// Feeds hand-made fragments straight into Ipv4L3Protocol::Receive, so the
+// order, overlaps and losses of the fragments are under the test's control.
+class Ipv4ReassemblyHarness
+{
+public:
+  Ipv4ReassemblyHarness ();
+  ~Ipv4ReassemblyHarness ();
+
+  // Build the fragment [offset, offset + size) of datagram id from source,
+  // the datagram being totalSize bytes long
+  Ptr<Packet> MakeFragment (Ipv4Address source, uint16_t id, uint32_t offset, uint32_t size, uint32_t totalSize);
+  // Build a fragment and deliver it
+  void Receive (Ipv4Address source, uint16_t id, uint32_t offset, uint32_t size, uint32_t totalSize);
+  // Deliver a fragment
+  void Receive (Ptr<const Packet> fragment);
+
+  void LocalDeliver (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t iif);
+  void Drop (const Ipv4Header &header, Ptr<const Packet> packet,
+             Ipv4L3Protocol::DropReason reason, Ptr<Ipv4> ipv4, uint32_t iif);
+  void SendOutgoing (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t iif);
+
+  // Send a packet to destination, and return its IP identification
+  uint16_t Send (Ipv4Address destination);
+
+  Ptr<Node> m_node;
+  Ptr<Ipv4L3Protocol> m_ipv4;
+  Ptr<SimpleNetDevice> m_device;
+  uint8_t m_data[65536];
+  uint32_t m_delivered;
+  uint32_t m_deliveredBytes;
+  bool m_deliveredOk;
+  bool m_verify;
+  uint32_t m_drops[8];
+  uint16_t m_sentIdentification;
+};
+
+Ipv4ReassemblyHarness::Ipv4ReassemblyHarness ()
+  : m_delivered (0),
+    m_deliveredBytes (0),
+    m_deliveredOk (true),
+    m_verify (true)
+{
+  for (uint32_t i = 0; i < sizeof (m_data); i++)
+    {
+      m_data[i] = i * 7 + (i >> 8);
+    }
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      m_drops[i] = 0;
+    }
+  m_node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (m_node);
+  m_device = CreateObject<SimpleNetDevice> ();
+  m_device->SetAddress (Mac48Address::ConvertFrom (Mac48Address::Allocate ()));
+  m_device->SetAttribute ("PointToPointMode", BooleanValue (true));
+  m_device->SetChannel (CreateObject<SimpleChannel> ());
+  m_node->AddDevice (m_device);
+  m_ipv4 = m_node->GetObject<Ipv4L3Protocol> ();
+  uint32_t interface = m_ipv4->AddInterface (m_device);
+  m_ipv4->AddAddress (interface, Ipv4InterfaceAddress (Ipv4Address ("10.0.0.1"), Ipv4Mask ("255.0.0.0")));
+  m_ipv4->SetUp (interface);
+  m_ipv4->TraceConnectWithoutContext ("LocalDeliver", MakeCallback (&Ipv4ReassemblyHarness::LocalDeliver, this));
+  m_ipv4->TraceConnectWithoutContext ("Drop", MakeCallback (&Ipv4ReassemblyHarness::Drop, this));
+  m_ipv4->TraceConnectWithoutContext ("SendOutgoing", MakeCallback (&Ipv4ReassemblyHarness::SendOutgoing, this));
+}
+
+Ipv4ReassemblyHarness::~Ipv4ReassemblyHarness ()
+{
+  m_node->Dispose ();
+}
+
+Ptr<Packet>
+Ipv4ReassemblyHarness::MakeFragment (Ipv4Address source, uint16_t id, uint32_t offset, uint32_t size, uint32_t totalSize)
+{
+  // The first two bytes of a datagram are its identification, so that
+  // mixed up datagrams are caught
+  uint8_t buffer[65536];
+  memcpy (buffer, m_data + offset, size);
+  if (offset == 0)
+    {
+      buffer[0] = id >> 8;
+      buffer[1] = id & 0xff;
+    }
+  Ptr<Packet> packet = Create<Packet> (buffer, size);
+  Ipv4Header header;
+  header.SetSource (source);
+  header.SetDestination (Ipv4Address ("10.0.0.1"));
+  header.SetProtocol (253);
+  header.SetTtl (64);
+  header.SetIdentification (id);
+  header.SetFragmentOffset (offset);
+  header.SetPayloadSize (size);
+  if (offset + size < totalSize)
+    {
+      header.SetMoreFragments ();
+    }
+  else
+    {
+      header.SetLastFragment ();
+    }
+  packet->AddHeader (header);
+  return packet;
+}
+
+void
+Ipv4ReassemblyHarness::Receive (Ipv4Address source, uint16_t id, uint32_t offset, uint32_t size, uint32_t totalSize)
+{
+  Receive (MakeFragment (source, id, offset, size, totalSize));
+}
+
+void
+Ipv4ReassemblyHarness::Receive (Ptr<const Packet> fragment)
+{
+  m_ipv4->Receive (m_device, fragment, Ipv4L3Protocol::PROT_NUMBER, m_device->GetBroadcast (),
+                   m_device->GetAddress (), NetDevice::PACKET_HOST);
+}
+
+void
+Ipv4ReassemblyHarness::LocalDeliver (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t iif)
+{
+  m_delivered++;
+  m_deliveredBytes += packet->GetSize ();
+  if (!m_verify)
+    {
+      return;
+    }
+  uint8_t buffer[65536];
+  uint32_t size = packet->CopyData (buffer, sizeof (buffer));
+  uint16_t id = header.GetIdentification ();
+  if (size < 2 || buffer[0] != (id >> 8) || buffer[1] != (id & 0xff)
+      || memcmp (buffer + 2, m_data + 2, size - 2) != 0)
+    {
+      m_deliveredOk = false;
+    }
+}
+
+void
+Ipv4ReassemblyHarness::Drop (const Ipv4Header &header, Ptr<const Packet> packet,
+                             Ipv4L3Protocol::DropReason reason, Ptr<Ipv4> ipv4, uint32_t iif)
+{
+  m_drops[reason]++;
+}
+
+void
+Ipv4ReassemblyHarness::SendOutgoing (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t iif)
+{
+  m_sentIdentification = header.GetIdentification ();
+}
+
+uint16_t
+Ipv4ReassemblyHarness::Send (Ipv4Address destination)
+{
+  m_ipv4->Send (Create<Packet> (100), Ipv4Address ("10.0.0.1"), destination, 253, 0);
+  return m_sentIdentification;
+}
+
+//-----------------------------------------------------------------------------
+class Ipv4ReassemblyTest : public TestCase
+{
+public:
+  Ipv4ReassemblyTest ();
+private:
+  virtual void DoRun (void);
+  void CheckAging (Ipv4ReassemblyHarness *harness, uint32_t others, uint16_t expected);
+};
+
+Ipv4ReassemblyTest::Ipv4ReassemblyTest ()
+  : TestCase ("Verify the IPv4 reassembly of overlapping fragments, its memory bound and the identification aging")
+{
+}
+
+void
+Ipv4ReassemblyTest::CheckAging (Ipv4ReassemblyHarness *harness, uint32_t others, uint16_t expected)
+{
+  // Enough new destinations to trigger an aging sweep
+  for (uint32_t i = 0; i < 1100; i++)
+    {
+      harness->Send (Ipv4Address (others + i));
+    }
+  NS_TEST_EXPECT_MSG_EQ (harness->Send (Ipv4Address ("10.0.0.2")), expected, "Wrong identification after the sweep");
+}
+
+void
+Ipv4ReassemblyTest::DoRun (void)
+{
+  Ipv4ReassemblyHarness harness;
+  Ipv4Address a ("11.0.0.1");
+  Ipv4Address b ("11.0.0.2");
+  Ipv4Address c ("11.0.0.3");
+
+  // Out of order, overlapping and duplicated fragments
+  harness.Receive (a, 1, 2000, 1000, 5000);
+  harness.Receive (a, 1, 0, 1000, 5000);
+  NS_TEST_EXPECT_MSG_EQ (harness.m_ipv4->GetFragmentsBytes (), 2000, "Wrong held bytes");
+  harness.Receive (a, 1, 496, 2000, 5000);
+  NS_TEST_EXPECT_MSG_EQ (harness.m_ipv4->GetFragmentsBytes (), 3000, "Overlaps are not held once");
+  harness.Receive (a, 1, 0, 1000, 5000);
+  harness.Receive (a, 1, 4000, 1000, 5000);
+  NS_TEST_EXPECT_MSG_EQ (harness.m_delivered, 0, "Packet delivered with a hole");
+  harness.Receive (a, 1, 2800, 1500, 5000);
+  NS_TEST_EXPECT_MSG_EQ (harness.m_delivered, 1, "Packet not reassembled");
+  NS_TEST_EXPECT_MSG_EQ (harness.m_deliveredBytes, 5000, "Wrong reassembled size");
+  NS_TEST_EXPECT_MSG_EQ (harness.m_deliveredOk, true, "Wrong reassembled content");
+  NS_TEST_EXPECT_MSG_EQ (harness.m_ipv4->GetFragmentsBytes (), 0, "Bytes held after reassembly");
+
+  // Bounded memory: the oldest incomplete packets are dropped
+  harness.m_ipv4->SetAttribute ("FragmentsMaxBytes", UintegerValue (10000));
+  harness.Receive (a, 2, 0, 4000, 8000);
+  harness.Receive (b, 2, 0, 4000, 8000);
+  harness.Receive (c, 2, 0, 4000, 8000);
+  NS_TEST_EXPECT_MSG_EQ (harness.m_drops[Ipv4L3Protocol::DROP_FRAGMENT_MEMORY], 1, "Oldest packet not dropped");
+  NS_TEST_EXPECT_MSG_EQ (harness.m_ipv4->GetFragmentsBytes (), 8000, "Wrong held bytes");
+  harness.Receive (a, 2, 4000, 4000, 8000);
+  NS_TEST_EXPECT_MSG_EQ (harness.m_drops[Ipv4L3Protocol::DROP_FRAGMENT_MEMORY], 2, "Oldest packet not dropped");
+  harness.Receive (c, 2, 4000, 4000, 8000);
+  NS_TEST_EXPECT_MSG_EQ (harness.m_delivered, 2, "Packet not reassembled");
+  NS_TEST_EXPECT_MSG_EQ (harness.m_deliveredOk, true, "Wrong reassembled content");
+
+  // The rest expires
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (harness.m_drops[Ipv4L3Protocol::DROP_FRAGMENT_TIMEOUT], 1, "Fragments did not expire");
+  NS_TEST_EXPECT_MSG_EQ (harness.m_ipv4->GetFragmentsBytes (), 0, "Bytes held after expiration");
+
+  // Identifications go on while the tuple is in use, and start over
+  // once it has been idle for IdentificationLifetime
+  NS_TEST_EXPECT_MSG_EQ (harness.Send (Ipv4Address ("10.0.0.2")), 0, "Wrong first identification");
+  NS_TEST_EXPECT_MSG_EQ (harness.Send (Ipv4Address ("10.0.0.2")), 1, "Wrong identification");
+  Simulator::Schedule (Seconds (60), &Ipv4ReassemblyTest::CheckAging, this, &harness, 0x0a010000, 2);
+  Simulator::Schedule (Seconds (300), &Ipv4ReassemblyTest::CheckAging, this, &harness, 0x0a020000, 0);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+//-----------------------------------------------------------------------------
+class Ipv4ReassemblyPerfTest : public TestCase
+{
+public:
+  Ipv4ReassemblyPerfTest ();
+private:
+  virtual void DoRun (void);
+  // Reassemble datagrams of the given size, sent by many sources at once
+  void Measure (uint32_t datagramSize, uint32_t sources, uint32_t datagrams);
+};
+
+Ipv4ReassemblyPerfTest::Ipv4ReassemblyPerfTest ()
+  : TestCase ("Measure the IPv4 reassembly cost")
+{
+}
+
+void
+Ipv4ReassemblyPerfTest::Measure (uint32_t datagramSize, uint32_t sources, uint32_t datagrams)
+{
+  const uint32_t fragmentSize = 1480;
+  uint32_t fragments = (datagramSize + fragmentSize - 1) / fragmentSize;
+  Ipv4ReassemblyHarness harness;
+  harness.m_verify = false;
+  std::clock_t elapsed = 0;
+  for (uint32_t round = 0; round < datagrams / sources; round++)
+    {
+      // Each source has a datagram in flight; their fragments are
+      // interleaved, and every fourth datagram arrives back to front.
+      // Only their reception is timed.
+      std::vector<Ptr<Packet> > arrivals;
+      for (uint32_t f = 0; f < fragments; f++)
+        {
+          for (uint32_t s = 0; s < sources; s++)
+            {
+              uint32_t k = (s + round) % 4 == 0 ? fragments - 1 - f : f;
+              uint32_t offset = k * fragmentSize;
+              uint32_t size = std::min (fragmentSize, datagramSize - offset);
+              arrivals.push_back (harness.MakeFragment (Ipv4Address (0x0b000000 + s), round, offset, size, datagramSize));
+            }
+        }
+      std::clock_t start = std::clock ();
+      for (std::vector<Ptr<Packet> >::const_iterator i = arrivals.begin (); i != arrivals.end (); ++i)
+        {
+          harness.Receive (*i);
+        }
+      elapsed += std::clock () - start;
+    }
+  double seconds = double (elapsed) / CLOCKS_PER_SEC;
+  uint32_t total = datagrams / sources * sources;
+  NS_TEST_ASSERT_MSG_EQ (harness.m_delivered, total, "Not all the datagrams were reassembled");
+  std::cout << GetParent ()->GetName () << ": "
+            << std::setw (6) << datagramSize << " byte datagrams, "
+            << std::setw (4) << sources << " sources "
+            << std::fixed << std::setprecision (1)
+            << std::setw (10) << 1e9 * seconds / total << " ns/datagram "
+            << std::setw (8) << 1e9 * seconds / (total * fragments) << " ns/fragment" << std::endl;
+  Simulator::Destroy ();
+}
+
+void
+Ipv4ReassemblyPerfTest::DoRun (void)
+{
+  Measure (8000, 16, 100000);
+  Measure (8000, 256, 100000);
+  Measure (65000, 16, 10000);
+  Measure (65000, 48, 10000);
+}
+
+class Ipv4FragmentationPerfTestSuite : public TestSuite
+{
+public:
+  Ipv4FragmentationPerfTestSuite () : TestSuite ("ipv4-fragmentation-perf", PERFORMANCE)
+  {
+    AddTestCase (new Ipv4ReassemblyPerfTest, TestCase::QUICK);
+  }
+} g_ipv4fragmentationPerfTestSuite;
+
 //-----------------------------------------------------------------------------
 class Ipv4FragmentationTestSuite : public TestSuite
 {
@@ -459,5 +777,6 @@ public:
   Ipv4FragmentationTestSuite () : TestSuite ("ipv4-fragmentation", UNIT)
   {
     AddTestCase (new Ipv4FragmentationTest, TestCase::QUICK);
+    AddTestCase (new Ipv4ReassemblyTest, TestCase::QUICK);
   }
 } g_ipv4fragmentationTestSuite;
@@ -14,6 +14,9 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <ctime>
+#include <iomanip>
+#include <map>
 #include <vector>
 #include "ns3/boolean.h"
 #include "ns3/config.h"
@@ -21,6 +24,9 @@
 #include "ns3/internet-stack-helper.h"
 #include "ns3/ipv4-address-helper.h"
 #include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/ipv4-static-routing-helper.h"
 #include "ns3/node.h"
 #include "ns3/node-container.h"
@@ -36,6 +42,8 @@
 #include "ns3/simple-channel.h"
 #include "ns3/socket-factory.h"
 #include "ns3/udp-socket-factory.h"
+#include "ns3/udp-header.h"
+#include "ns3/udp-l4-protocol.h"
 
 using namespace ns3;
 
@@ -419,6 +427,263 @@ Ipv4GlobalRoutingSlash32TestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * A router with four equal cost routes to a network, whose forwarding
+ * decisions are observed through RouteInput.
+ */
+class Ipv4EcmpRouter
+{
+public:
+  Ipv4EcmpRouter (std::string mode, std::string hashFunction, uint32_t paths);
+  /**
+   * Route a packet of a flow.
+   * \param [in] flow The flow: its source port, and the last byte of its source.
+   * \param [in] fragment true to route a non-first fragment of the flow.
+   * \returns the gateway of the route.
+   */
+  Ipv4Address Route (uint32_t flow, bool fragment = false);
+  /**
+   * Remove the route through a gateway.
+   * \param [in] gateway The gateway.
+   */
+  void RemoveRoute (Ipv4Address gateway);
+  /**
+   * \param [in] i The index of a path.
+   * \returns the gateway of the path.
+   */
+  static Ipv4Address GetGateway (uint32_t i);
+
+  Ptr<Ipv4GlobalRouting> m_routing; //!< The routing protocol of the router.
+
+private:
+  /**
+   * Receive a packet forwarded by the router.
+   * \param [in] route The route.
+   * \param [in] p The packet.
+   * \param [in] header The IPv4 header.
+   */
+  void Forward (Ptr<Ipv4Route> route, Ptr<const Packet> p, const Ipv4Header &header);
+
+  Ptr<Node> m_node;          //!< The router.
+  Ptr<NetDevice> m_input;    //!< The device packets arrive on.
+  Ipv4Address m_gateway;     //!< The gateway of the last route.
+};
+
+Ipv4EcmpRouter::Ipv4EcmpRouter (std::string mode, std::string hashFunction, uint32_t paths)
+{
+  m_node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.SetRoutingHelper (Ipv4GlobalRoutingHelper ());
+  internet.Install (m_node);
+  Ptr<Ipv4> ipv4 = m_node->GetObject<Ipv4> ();
+  m_routing = DynamicCast<Ipv4GlobalRouting> (ipv4->GetRoutingProtocol ());
+  m_routing->SetAttribute ("EcmpMode", StringValue (mode));
+  m_routing->SetAttribute ("EcmpHashFunction", StringValue (hashFunction));
+
+  SimpleNetDeviceHelper simple;
+  NetDeviceContainer devices = simple.Install (NodeContainer (m_node, m_node));
+  for (uint32_t i = 1; i < paths; i++)
+    {
+      devices.Add (simple.Install (m_node));
+    }
+  m_input = devices.Get (0);
+  for (uint32_t i = 0; i < devices.GetN (); i++)
+    {
+      int32_t interface = ipv4->AddInterface (devices.Get (i));
+      Ipv4Address address (0x0a000001 + (i << 8));
+      ipv4->AddAddress (interface, Ipv4InterfaceAddress (address, Ipv4Mask ("/24")));
+      ipv4->SetUp (interface);
+      if (i > 0)
+        {
+          m_routing->AddNetworkRouteTo (Ipv4Address ("10.9.0.0"), Ipv4Mask ("/16"),
+                                        GetGateway (i - 1), interface);
+        }
+    }
+}
+
+Ipv4Address
+Ipv4EcmpRouter::GetGateway (uint32_t i)
+{
+  return Ipv4Address (0x0a000102 + (i << 8));
+}
+
+Ipv4Address
+Ipv4EcmpRouter::Route (uint32_t flow, bool fragment)
+{
+  Ptr<Packet> p = Create<Packet> (100);
+  UdpHeader udp;
+  udp.SetSourcePort (1024 + flow / 256);
+  udp.SetDestinationPort (fragment ? flow : 80);
+  p->AddHeader (udp);
+  Ipv4Header header;
+  header.SetSource (Ipv4Address (0x0a010000 + flow % 256));
+  header.SetDestination (Ipv4Address ("10.9.0.1"));
+  header.SetProtocol (UdpL4Protocol::PROT_NUMBER);
+  if (fragment)
+    {
+      header.SetFragmentOffset (1480);
+    }
+  m_gateway = Ipv4Address ();
+  m_routing->RouteInput (p, header, m_input,
+                         MakeCallback (&Ipv4EcmpRouter::Forward, this),
+                         Ipv4RoutingProtocol::MulticastForwardCallback (),
+                         Ipv4RoutingProtocol::LocalDeliverCallback (),
+                         Ipv4RoutingProtocol::ErrorCallback ());
+  return m_gateway;
+}
+
+void
+Ipv4EcmpRouter::Forward (Ptr<Ipv4Route> route, Ptr<const Packet> p, const Ipv4Header &header)
+{
+  m_gateway = route->GetGateway ();
+}
+
+void
+Ipv4EcmpRouter::RemoveRoute (Ipv4Address gateway)
+{
+  for (uint32_t i = 0; i < m_routing->GetNRoutes (); i++)
+    {
+      if (m_routing->GetRoute (i)->GetGateway () == gateway)
+        {
+          m_routing->RemoveRoute (i);
+          return;
+        }
+    }
+}
+
+/**
+ * Check that the hashed ECMP modes keep flows on their path, spread them
+ * among the paths, and move as few of them as they should when a path
+ * goes away or a flow pauses.
+ */
+class Ipv4GlobalRoutingEcmpTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] mode The EcmpMode.
+   * \param [in] hashFunction The EcmpHashFunction.
+   */
+  Ipv4GlobalRoutingEcmpTestCase (std::string mode, std::string hashFunction);
+private:
+  virtual void DoRun (void);
+  /**
+   * Route the flows again, after a pause.
+   * \param [in] router The router.
+   */
+  void CheckFlowlets (Ipv4EcmpRouter *router);
+
+  std::string m_mode;                 //!< The EcmpMode.
+  std::string m_hashFunction;         //!< The EcmpHashFunction.
+  std::vector<Ipv4Address> m_paths;   //!< The gateway of each flow.
+  static const uint32_t FLOWS = 1000; //!< Number of flows.
+};
+
+Ipv4GlobalRoutingEcmpTestCase::Ipv4GlobalRoutingEcmpTestCase (std::string mode, std::string hashFunction)
+  : TestCase ("ECMP " + mode + " with " + hashFunction),
+    m_mode (mode),
+    m_hashFunction (hashFunction)
+{
+}
+
+void
+Ipv4GlobalRoutingEcmpTestCase::CheckFlowlets (Ipv4EcmpRouter *router)
+{
+  uint32_t moved = 0;
+  for (uint32_t flow = 0; flow < FLOWS; flow++)
+    {
+      Ipv4Address gateway = router->Route (flow);
+      if (gateway != m_paths[flow])
+        {
+          moved++;
+        }
+      NS_TEST_EXPECT_MSG_EQ (router->Route (flow), gateway, "A flowlet changed path");
+    }
+  // Three quarters of the flowlets should start on another path
+  NS_TEST_EXPECT_MSG_GT (moved, FLOWS / 2, "Flowlets do not switch path");
+  NS_TEST_EXPECT_MSG_LT (moved, FLOWS, "Flowlets always switch path");
+}
+
+void
+Ipv4GlobalRoutingEcmpTestCase::DoRun (void)
+{
+  Ipv4EcmpRouter router (m_mode, m_hashFunction, 4);
+  std::map<Ipv4Address, uint32_t> load;
+  m_paths.clear ();
+  for (uint32_t flow = 0; flow < FLOWS; flow++)
+    {
+      Ipv4Address gateway = router.Route (flow);
+      m_paths.push_back (gateway);
+      load[gateway]++;
+      NS_TEST_EXPECT_MSG_EQ (router.Route (flow), gateway, "A flow changed path");
+    }
+  NS_TEST_EXPECT_MSG_EQ (router.m_routing->GetNNextHopGroups (), 1, "Wrong number of next-hop groups");
+  NS_TEST_EXPECT_MSG_EQ (load.size (), 4, "Flows do not use all the paths");
+  for (std::map<Ipv4Address, uint32_t>::const_iterator i = load.begin (); i != load.end (); ++i)
+    {
+      NS_TEST_EXPECT_MSG_GT (i->second, FLOWS / 8, "Unbalanced load on " << i->first);
+    }
+
+  // The fragments of a datagram follow one path, whatever they carry
+  Ipv4Address gateway = router.Route (0, true);
+  for (uint32_t flow = 1; flow < 100; flow++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (router.Route (flow * 256, true), gateway, "Fragments of a datagram split");
+    }
+
+  if (m_mode == "ConsistentHash")
+    {
+      // Only the flows of the path removed move
+      Ipv4Address removed = Ipv4EcmpRouter::GetGateway (1);
+      router.RemoveRoute (removed);
+      NS_TEST_EXPECT_MSG_EQ (router.m_routing->GetNNextHopGroups (), 0, "Next-hop groups not flushed");
+      for (uint32_t flow = 0; flow < FLOWS; flow++)
+        {
+          gateway = router.Route (flow);
+          NS_TEST_EXPECT_MSG_NE (gateway, removed, "A flow uses a removed route");
+          if (m_paths[flow] != removed)
+            {
+              NS_TEST_EXPECT_MSG_EQ (gateway, m_paths[flow], "A flow moved off a remaining path");
+            }
+        }
+    }
+  else if (m_mode == "Flowlet")
+    {
+      // After a pause longer than FlowletTimeout, flows start new flowlets
+      Simulator::Schedule (MilliSeconds (1), &Ipv4GlobalRoutingEcmpTestCase::CheckFlowlets, this, &router);
+      Simulator::Run ();
+    }
+  Simulator::Destroy ();
+}
+
+/**
+ * Check that the routes are selected as before with ECMP disabled.
+ */
+class Ipv4GlobalRoutingNoEcmpTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingNoEcmpTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4GlobalRoutingNoEcmpTestCase::Ipv4GlobalRoutingNoEcmpTestCase ()
+  : TestCase ("ECMP disabled")
+{
+}
+
+void
+Ipv4GlobalRoutingNoEcmpTestCase::DoRun (void)
+{
+  Ipv4EcmpRouter router ("None", "Fnv1a", 4);
+  for (uint32_t flow = 0; flow < 100; flow++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (router.Route (flow), Ipv4EcmpRouter::GetGateway (0), "Not the first route");
+    }
+  NS_TEST_EXPECT_MSG_EQ (router.m_routing->GetNNextHopGroups (), 0, "Next-hop groups without hashed ECMP");
+  Simulator::Destroy ();
+}
+
 
 class Ipv4GlobalRoutingTestSuite : public TestSuite
 {
@@ -431,7 +696,101 @@ Ipv4GlobalRoutingTestSuite::Ipv4GlobalRoutingTestSuite ()
 {
   AddTestCase (new Ipv4DynamicGlobalRoutingTestCase, TestCase::QUICK);
   AddTestCase (new Ipv4GlobalRoutingSlash32TestCase, TestCase::QUICK);
+  AddTestCase (new Ipv4GlobalRoutingNoEcmpTestCase, TestCase::QUICK);
+  AddTestCase (new Ipv4GlobalRoutingEcmpTestCase ("FlowHash", "Fnv1a"), TestCase::QUICK);
+  AddTestCase (new Ipv4GlobalRoutingEcmpTestCase ("FlowHash", "Murmur3"), TestCase::QUICK);
+  AddTestCase (new Ipv4GlobalRoutingEcmpTestCase ("ConsistentHash", "Fnv1a"), TestCase::QUICK);
+  AddTestCase (new Ipv4GlobalRoutingEcmpTestCase ("Flowlet", "Murmur3"), TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
 static Ipv4GlobalRoutingTestSuite globalRoutingTestSuite;
+
+
+/**
+ * Measure the forwarding decisions of each ECMP mode.
+ */
+class Ipv4GlobalRoutingEcmpPerfTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingEcmpPerfTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * Route packets of many flows.
+   * \param [in] mode The EcmpMode.
+   * \param [in] hashFunction The EcmpHashFunction.
+   * \param [in] paths The number of equal cost paths.
+   */
+  void Measure (std::string mode, std::string hashFunction, uint32_t paths);
+  /**
+   * Route packets of many flows, from a simulation event.
+   * \param [in] router The router.
+   * \param [in] packets The number of packets.
+   */
+  static void RoutePackets (Ipv4EcmpRouter *router, uint32_t packets);
+};
+
+Ipv4GlobalRoutingEcmpPerfTestCase::Ipv4GlobalRoutingEcmpPerfTestCase ()
+  : TestCase ("Measure the ECMP route selection")
+{
+}
+
+void
+Ipv4GlobalRoutingEcmpPerfTestCase::Measure (std::string mode, std::string hashFunction, uint32_t paths)
+{
+  const uint32_t packets = 200000;
+  Ipv4EcmpRouter router (mode, hashFunction, paths);
+  Simulator::Schedule (Seconds (0), &Ipv4GlobalRoutingEcmpPerfTestCase::RoutePackets, &router, packets);
+  std::clock_t start = std::clock ();
+  Simulator::Run ();
+  double seconds = double (std::clock () - start) / CLOCKS_PER_SEC;
+  std::cout << GetParent ()->GetName () << ": "
+            << std::left << std::setw (16) << mode << std::setw (8) << hashFunction << std::right
+            << std::setw (4) << paths << " paths "
+            << std::fixed << std::setprecision (1)
+            << std::setw (8) << 1e9 * seconds / packets << " ns/packet" << std::endl;
+  Simulator::Destroy ();
+}
+
+void
+Ipv4GlobalRoutingEcmpPerfTestCase::RoutePackets (Ipv4EcmpRouter *router, uint32_t packets)
+{
+  for (uint32_t i = 0; i < packets; i++)
+    {
+      router->Route (i % 4096);
+    }
+}
+
+void
+Ipv4GlobalRoutingEcmpPerfTestCase::DoRun (void)
+{
+  uint32_t paths[] = { 4, 16 };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Measure ("None", "Fnv1a", paths[i]);
+      Measure ("Random", "Fnv1a", paths[i]);
+      Measure ("FlowHash", "Fnv1a", paths[i]);
+      Measure ("FlowHash", "Murmur3", paths[i]);
+      Measure ("ConsistentHash", "Murmur3", paths[i]);
+      Measure ("Flowlet", "Murmur3", paths[i]);
+    }
+}
+
+/**
+ * \ingroup internet-test
+ * ECMP route selection performance suite.
+ */
+class Ipv4GlobalRoutingEcmpPerfTestSuite : public TestSuite
+{
+public:
+  Ipv4GlobalRoutingEcmpPerfTestSuite ();
+};
+
+Ipv4GlobalRoutingEcmpPerfTestSuite::Ipv4GlobalRoutingEcmpPerfTestSuite ()
+  : TestSuite ("ipv4-global-routing-ecmp-perf", PERFORMANCE)
+{
+  AddTestCase (new Ipv4GlobalRoutingEcmpPerfTestCase, TestCase::QUICK);
+}
+
+static Ipv4GlobalRoutingEcmpPerfTestSuite g_ipv4GlobalRoutingEcmpPerfTestSuite;
@@ -0,0 +1,416 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Tests of the longest prefix match index behind Ipv4StaticRouting and
+// Ipv4GlobalRouting, and forwarding lookup benchmarks
+
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-route-trie.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simulator.h"
+
+using namespace ns3;
+
+namespace {
+
+/**
+ * Create a node with an IPv4 stack and n interfaces on SimpleNetDevices,
+ * interface i having address 10.0.i.1/24.
+ * \param [in] n The number of interfaces.
+ * \returns the Ipv4 object of the node.
+ */
+Ptr<Ipv4>
+CreateRouter (uint32_t n)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (node);
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      device->SetChannel (channel);
+      node->AddDevice (device);
+      uint32_t interface = ipv4->AddInterface (device);
+      Ipv4Address address (0x0a000001 | (i << 8));
+      ipv4->AddAddress (interface, Ipv4InterfaceAddress (address, Ipv4Mask ("/24")));
+      ipv4->SetUp (interface);
+    }
+  return ipv4;
+}
+
+/**
+ * Look up a route through a routing protocol.
+ * \param [in] routing The routing protocol.
+ * \param [in] dest The destination.
+ * \param [in] oif The output device, or 0.
+ * \returns the gateway of the route, or 255.255.255.255 if there is none.
+ */
+Ipv4Address
+LookupGateway (Ptr<Ipv4RoutingProtocol> routing, Ipv4Address dest,
+               Ptr<NetDevice> oif = 0)
+{
+  Ipv4Header header;
+  header.SetDestination (dest);
+  Socket::SocketErrno error;
+  Ptr<Ipv4Route> route = routing->RouteOutput (Create<Packet> (), header, oif, error);
+  if (route == 0)
+    {
+      return Ipv4Address::GetBroadcast ();
+    }
+  return route->GetGateway ();
+}
+
+} // anonymous namespace
+
+
+/**
+ * \ingroup internet-test
+ * Compare Ipv4RouteTrie lookups with a linear scan of the same routes.
+ */
+class Ipv4RouteTrieTestCase : public TestCase
+{
+public:
+  Ipv4RouteTrieTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * Check lookups of random destinations against a linear scan.
+   * \param [in] trie The trie.
+   * \param [in] routes The routes in the trie, in insertion order.
+   * \param [in] rng The random stream.
+   */
+  void Check (const Ipv4RouteTrie &trie,
+              const std::vector<Ipv4RoutingTableEntry *> &routes,
+              Ptr<UniformRandomVariable> rng);
+};
+
+Ipv4RouteTrieTestCase::Ipv4RouteTrieTestCase ()
+  : TestCase ("Check prefix trie lookups against a linear scan")
+{
+}
+
+void
+Ipv4RouteTrieTestCase::Check (const Ipv4RouteTrie &trie,
+                              const std::vector<Ipv4RoutingTableEntry *> &routes,
+                              Ptr<UniformRandomVariable> rng)
+{
+  NS_TEST_ASSERT_MSG_EQ (trie.GetN (), routes.size (), "Wrong route count");
+  Ipv4RouteTrie::Matches matches;
+  for (uint32_t k = 0; k < 2000; k++)
+    {
+      // Half of the destinations are taken close to a route, so that
+      // most lookups match something.
+      uint32_t address = rng->GetInteger (0, 0xffffffff);
+      if (k % 2 == 0 && !routes.empty ())
+        {
+          Ipv4RoutingTableEntry *near = routes[rng->GetInteger (0, routes.size () - 1)];
+          address = (near->GetDestNetwork ().Get () & 0xffffff00) | (address & 0xff);
+        }
+      Ipv4Address dest (address);
+
+      // The expected order: longest mask first, then insertion order.
+      std::vector<Ipv4RoutingTableEntry *> expected;
+      for (uint16_t length = 33; length-- > 0; )
+        {
+          for (uint32_t i = 0; i < routes.size (); i++)
+            {
+              Ipv4Mask mask = routes[i]->GetDestNetworkMask ();
+              if (mask.GetPrefixLength () == length
+                  && mask.IsMatch (dest, routes[i]->GetDestNetwork ()))
+                {
+                  expected.push_back (routes[i]);
+                }
+            }
+        }
+      trie.Lookup (dest, matches);
+      NS_TEST_ASSERT_MSG_EQ (matches.size (), expected.size (), "Wrong match count for " << dest);
+      for (uint32_t i = 0; i < matches.size (); i++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (matches[i]->m_entry, expected[i], "Wrong match " << i << " for " << dest);
+        }
+    }
+}
+
+void
+Ipv4RouteTrieTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (1);
+
+  Ipv4RouteTrie trie;
+  std::vector<Ipv4RoutingTableEntry *> routes;
+  for (uint32_t i = 0; i < 600; i++)
+    {
+      // Prefixes are drawn from a small space so that they nest and
+      // repeat.
+      uint32_t length = rng->GetInteger (0, 32);
+      uint32_t mask = length == 0 ? 0 : 0xffffffffU << (32 - length);
+      if (i % 50 == 49)
+        {
+          mask = 0xff00ff00;
+        }
+      uint32_t network = 0x0a000000 | (rng->GetInteger (0, 3) << 16) | (rng->GetInteger (0, 3) << 8) | rng->GetInteger (0, 3);
+      Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
+      *route = Ipv4RoutingTableEntry::CreateNetworkRouteTo (Ipv4Address (network), Ipv4Mask (mask), i % 4);
+      trie.Insert (route, i % 3);
+      routes.push_back (route);
+    }
+  Check (trie, routes, rng);
+
+  // Remove a random half, including some routes that share a prefix.
+  for (uint32_t i = 0; i < 300; i++)
+    {
+      uint32_t index = rng->GetInteger (0, routes.size () - 1);
+      NS_TEST_ASSERT_MSG_EQ (trie.Remove (routes[index]), true, "Route not found");
+      delete routes[index];
+      routes.erase (routes.begin () + index);
+    }
+  Check (trie, routes, rng);
+
+  Ipv4RoutingTableEntry missing = Ipv4RoutingTableEntry::CreateHostRouteTo (Ipv4Address ("10.0.0.1"), 0);
+  NS_TEST_ASSERT_MSG_EQ (trie.Remove (&missing), false, "Removed a route not in the trie");
+
+  for (uint32_t i = 0; i < routes.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (trie.Remove (routes[i]), true, "Route not found");
+      delete routes[i];
+    }
+  routes.clear ();
+  Check (trie, routes, rng);
+}
+
+
+/**
+ * \ingroup internet-test
+ * Check the route choice of the static and global routing protocols
+ * among overlapping routes.
+ */
+class Ipv4RouteChoiceTestCase : public TestCase
+{
+public:
+  Ipv4RouteChoiceTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4RouteChoiceTestCase::Ipv4RouteChoiceTestCase ()
+  : TestCase ("Check route choice among overlapping routes")
+{
+}
+
+void
+Ipv4RouteChoiceTestCase::DoRun (void)
+{
+  Ptr<Ipv4> ipv4 = CreateRouter (3);
+  Ptr<NetDevice> dev1 = ipv4->GetNetDevice (1);
+  Ptr<NetDevice> dev2 = ipv4->GetNetDevice (2);
+
+  // Static routing: longest mask, then lowest metric, then the last
+  // route added.
+  Ptr<Ipv4StaticRouting> stat = CreateObject<Ipv4StaticRouting> ();
+  stat->SetIpv4 (ipv4);
+  stat->SetDefaultRoute (Ipv4Address ("10.0.0.2"), 1, 5);
+  stat->AddNetworkRouteTo (Ipv4Address ("192.168.0.0"), Ipv4Mask ("/16"), Ipv4Address ("10.0.0.3"), 1, 5);
+  stat->AddNetworkRouteTo (Ipv4Address ("192.168.1.0"), Ipv4Mask ("/24"), Ipv4Address ("10.0.0.4"), 1, 7);
+  stat->AddNetworkRouteTo (Ipv4Address ("192.168.1.0"), Ipv4Mask ("/24"), Ipv4Address ("10.0.1.4"), 2, 3);
+  stat->AddNetworkRouteTo (Ipv4Address ("192.168.1.0"), Ipv4Mask ("/24"), Ipv4Address ("10.0.1.5"), 2, 3);
+  stat->AddHostRouteTo (Ipv4Address ("192.168.1.9"), Ipv4Address ("10.0.1.9"), 2, 9);
+
+  NS_TEST_ASSERT_MSG_EQ (LookupGateway (stat, Ipv4Address ("172.16.0.1")), Ipv4Address ("10.0.0.2"), "Default route");
+  NS_TEST_ASSERT_MSG_EQ (LookupGateway (stat, Ipv4Address ("192.168.2.1")), Ipv4Address ("10.0.0.3"), "/16 route");
+  NS_TEST_ASSERT_MSG_EQ (LookupGateway (stat, Ipv4Address ("192.168.1.1")), Ipv4Address ("10.0.1.5"), "Lowest metric, last added");
+  NS_TEST_ASSERT_MSG_EQ (LookupGateway (stat, Ipv4Address ("192.168.1.9")), Ipv4Address ("10.0.1.9"), "Host route");
+  NS_TEST_ASSERT_MSG_EQ (LookupGateway (stat, Ipv4Address ("192.168.1.9"), dev1), Ipv4Address ("10.0.0.4"), "Longest usable mask on interface 1");
+  NS_TEST_ASSERT_MSG_EQ (LookupGateway (stat, Ipv4Address ("192.168.2.1"), dev2), Ipv4Address::GetBroadcast (), "No route on interface 2");
+
+  stat->RemoveRoute (stat->GetNRoutes () - 1);
+  NS_TEST_ASSERT_MSG_EQ (LookupGateway (stat, Ipv4Address ("192.168.1.9")), Ipv4Address ("10.0.1.5"), "Host route removed");
+  stat->NotifyInterfaceDown (2);
+  NS_TEST_ASSERT_MSG_EQ (LookupGateway (stat, Ipv4Address ("192.168.1.1")), Ipv4Address ("10.0.0.4"), "Interface 2 routes removed");
+
+  // Global routing: host routes first, then all matching network
+  // routes in the order they were added, then the first external route.
+  Ptr<Ipv4GlobalRouting> global = CreateObject<Ipv4GlobalRouting> ();
+  global->SetIpv4 (ipv4);
+  global->AddASExternalRouteTo (Ipv4Address ("0.0.0.0"), Ipv4Mask ("/0"), Ipv4Address ("10.0.0.6"), 1);
+  global->AddASExternalRouteTo (Ipv4Address ("172.16.0.0"), Ipv4Mask ("/12"), Ipv4Address ("10.0.1.6"), 2);
+  global->AddNetworkRouteTo (Ipv4Address ("192.168.0.0"), Ipv4Mask ("/16"), Ipv4Address ("10.0.0.7"), 1);
+  global->AddNetworkRouteTo (Ipv4Address ("192.168.1.0"), Ipv4Mask ("/24"), Ipv4Address ("10.0.1.7"), 2);
+  global->AddHostRouteTo (Ipv4Address ("192.168.1.9"), Ipv4Address ("10.0.1.8"), 2);
+
+  NS_TEST_ASSERT_MSG_EQ (LookupGateway (global, Ipv4Address ("192.168.1.1")), Ipv4Address ("10.0.0.7"), "First network route added");
+  NS_TEST_ASSERT_MSG_EQ (LookupGateway (global, Ipv4Address ("192.168.1.1"), dev2), Ipv4Address ("10.0.1.7"), "Network route on interface 2");
+  NS_TEST_ASSERT_MSG_EQ (LookupGateway (global, Ipv4Address ("192.168.1.9")), Ipv4Address ("10.0.1.8"), "Host route");
+  NS_TEST_ASSERT_MSG_EQ (LookupGateway (global, Ipv4Address ("192.168.1.9"), dev1), Ipv4Address ("10.0.0.7"), "Network route on interface 1");
+  NS_TEST_ASSERT_MSG_EQ (LookupGateway (global, Ipv4Address ("172.16.0.1")), Ipv4Address ("10.0.0.6"), "First external route added");
+  NS_TEST_ASSERT_MSG_EQ (LookupGateway (global, Ipv4Address ("172.16.0.1"), dev2), Ipv4Address ("10.0.1.6"), "External route on interface 2");
+
+  global->RemoveRoute (0);
+  NS_TEST_ASSERT_MSG_EQ (LookupGateway (global, Ipv4Address ("192.168.1.9")), Ipv4Address ("10.0.0.7"), "Host route removed");
+  global->RemoveRoute (0);
+  NS_TEST_ASSERT_MSG_EQ (LookupGateway (global, Ipv4Address ("192.168.1.1")), Ipv4Address ("10.0.1.7"), "Network route removed");
+
+  stat->Dispose ();
+  global->Dispose ();
+  Simulator::Destroy ();
+}
+
+
+/**
+ * \ingroup internet-test
+ * Ipv4RouteTrie test suite.
+ */
+class Ipv4RouteTrieTestSuite : public TestSuite
+{
+public:
+  Ipv4RouteTrieTestSuite ();
+};
+
+Ipv4RouteTrieTestSuite::Ipv4RouteTrieTestSuite ()
+  : TestSuite ("ipv4-route-trie", UNIT)
+{
+  AddTestCase (new Ipv4RouteTrieTestCase, TestCase::QUICK);
+  AddTestCase (new Ipv4RouteChoiceTestCase, TestCase::QUICK);
+}
+
+static Ipv4RouteTrieTestSuite g_ipv4RouteTrieTestSuite;
+
+
+/**
+ * \ingroup internet-test
+ * Measure the forwarding lookup time of the static and global routing
+ * protocols with large tables.
+ */
+class Ipv4RouteLookupPerfTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] routes The number of routes in the table.
+   */
+  Ipv4RouteLookupPerfTestCase (uint32_t routes);
+private:
+  virtual void DoRun (void);
+  /**
+   * Time lookups of random routed destinations.
+   * \param [in] what The routing protocol measured.
+   * \param [in] routing The routing protocol.
+   */
+  void Measure (const std::string what, Ptr<Ipv4RoutingProtocol> routing);
+  uint32_t m_routes; //!< Number of routes in the table.
+};
+
+Ipv4RouteLookupPerfTestCase::Ipv4RouteLookupPerfTestCase (uint32_t routes)
+  : TestCase ("Measure route lookup time"),
+    m_routes (routes)
+{
+}
+
+void
+Ipv4RouteLookupPerfTestCase::Measure (const std::string what,
+                                      Ptr<Ipv4RoutingProtocol> routing)
+{
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (2);
+  Ipv4Header header;
+  Ptr<Packet> packet = Create<Packet> ();
+  Socket::SocketErrno error;
+  const uint32_t lookups = 200000;
+  uint32_t found = 0;
+  std::clock_t start = std::clock ();
+  for (uint32_t i = 0; i < lookups; i++)
+    {
+      header.SetDestination (Ipv4Address (0x14000000 + rng->GetInteger (0, m_routes - 1)));
+      if (routing->RouteOutput (packet, header, 0, error) != 0)
+        {
+          found++;
+        }
+    }
+  std::clock_t ticks = std::clock () - start;
+  NS_TEST_ASSERT_MSG_EQ (found, lookups, "Lookups failed");
+  double per = 1e9 * double (ticks) / (double (lookups) * CLOCKS_PER_SEC);
+  std::cout << GetParent ()->GetName () << ": "
+            << std::left << std::setw (32) << what << std::right
+            << std::setw (8) << m_routes << " routes "
+            << std::fixed << std::setprecision (1) << std::setw (10) << per
+            << " ns/lookup" << std::endl;
+}
+
+void
+Ipv4RouteLookupPerfTestCase::DoRun (void)
+{
+  Ptr<Ipv4> ipv4 = CreateRouter (4);
+
+  // Host routes to 20.0.0.0 onwards, as global routing sets up one per
+  // interface of every other node.
+  Ptr<Ipv4GlobalRouting> global = CreateObject<Ipv4GlobalRouting> ();
+  global->SetIpv4 (ipv4);
+  Ptr<Ipv4StaticRouting> stat = CreateObject<Ipv4StaticRouting> ();
+  stat->SetIpv4 (ipv4);
+  for (uint32_t i = 0; i < m_routes; i++)
+    {
+      Ipv4Address dest (0x14000000 + i);
+      Ipv4Address gateway (0x0a000002 | ((i % 4) << 8));
+      global->AddHostRouteTo (dest, gateway, i % 4);
+      stat->AddHostRouteTo (dest, gateway, i % 4);
+    }
+  stat->SetDefaultRoute (Ipv4Address ("10.0.0.2"), 0);
+  Measure ("Ipv4GlobalRouting host routes", global);
+  Measure ("Ipv4StaticRouting host routes", stat);
+
+  stat->Dispose ();
+  global->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * Route lookup performance suite.
+ */
+class Ipv4RouteLookupPerfTestSuite : public TestSuite
+{
+public:
+  Ipv4RouteLookupPerfTestSuite ();
+};
+
+Ipv4RouteLookupPerfTestSuite::Ipv4RouteLookupPerfTestSuite ()
+  : TestSuite ("ipv4-route-lookup-perf", PERFORMANCE)
+{
+  AddTestCase (new Ipv4RouteLookupPerfTestCase (1000), TestCase::QUICK);
+  AddTestCase (new Ipv4RouteLookupPerfTestCase (10000), TestCase::QUICK);
+  AddTestCase (new Ipv4RouteLookupPerfTestCase (50000), TestCase::QUICK);
+}
+
+static Ipv4RouteLookupPerfTestSuite g_ipv4RouteLookupPerfTestSuite;
@@ -0,0 +1,341 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/socket.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/inet6-socket-address.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv6-address-helper.h"
+#include "ns3/neighbor-cache-helper.h"
+#include "ns3/arp-l3-protocol.h"
+#include "ns3/arp-cache.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/ipv6-l3-protocol.h"
+#include "ns3/ipv6-interface.h"
+#include "ns3/ipv6-header.h"
+#include "ns3/icmpv6-header.h"
+#include "ns3/icmpv6-l4-protocol.h"
+#include "ns3/ndisc-cache.h"
+
+#include <ctime>
+#include <iomanip>
+#include <limits>
+
+using namespace ns3;
+
+/**
+ * A LAN of hosts on a SimpleChannel, with IPv4 and IPv6 addresses, which
+ * counts the address resolution messages on the link.
+ */
+class NeighborCacheLan
+{
+public:
+  NeighborCacheLan (uint32_t hosts);
+  // Resolve the neighbors of the link without ARP or Neighbor Discovery
+  void Populate (void);
+  // Open a UDP socket on every host, for each address family
+  void Listen (void);
+  // Send a datagram from one host to another one
+  void Send (uint32_t from, uint32_t to, bool ipv6);
+
+  NodeContainer m_nodes;
+  NetDeviceContainer m_devices;
+  Ipv4InterfaceContainer m_ipv4Interfaces;
+  Ipv6InterfaceContainer m_ipv6Interfaces;
+  std::vector<Ptr<Socket> > m_sockets;
+  uint32_t m_arp;             //!< ARP frames received
+  uint32_t m_ns;              //!< Neighbor Solicitations received
+  uint32_t m_received;        //!< datagrams received
+  Time m_lastReceived;        //!< last time a datagram was received
+
+private:
+  void ReceiveArp (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                   const Address &from, const Address &to, NetDevice::PacketType packetType);
+  void ReceiveIpv6 (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                    const Address &from, const Address &to, NetDevice::PacketType packetType);
+  void ReceiveDatagram (Ptr<Socket> socket);
+};
+
+NeighborCacheLan::NeighborCacheLan (uint32_t hosts)
+  : m_arp (0),
+    m_ns (0),
+    m_received (0)
+{
+  m_nodes.Create (hosts);
+  InternetStackHelper internet;
+  internet.Install (m_nodes);
+  for (NodeContainer::Iterator i = m_nodes.Begin (); i != m_nodes.End (); ++i)
+    {
+      (*i)->GetObject<Icmpv6L4Protocol> ()->SetAttribute ("DAD", BooleanValue (false));
+      (*i)->RegisterProtocolHandler (MakeCallback (&NeighborCacheLan::ReceiveArp, this),
+                                     ArpL3Protocol::PROT_NUMBER, 0);
+      (*i)->RegisterProtocolHandler (MakeCallback (&NeighborCacheLan::ReceiveIpv6, this),
+                                     Ipv6L3Protocol::PROT_NUMBER, 0);
+    }
+  SimpleNetDeviceHelper simple;
+  simple.SetQueue ("ns3::DropTailQueue", "MaxPackets", UintegerValue (100000));
+  m_devices = simple.Install (m_nodes);
+
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.0.0.0", "255.0.0.0");
+  m_ipv4Interfaces = ipv4.Assign (m_devices);
+  Ipv6AddressHelper ipv6;
+  ipv6.SetBase (Ipv6Address ("2001:db8::"), Ipv6Prefix (64));
+  m_ipv6Interfaces = ipv6.Assign (m_devices);
+}
+
+void
+NeighborCacheLan::Populate (void)
+{
+  NeighborCacheHelper neighbors;
+  neighbors.PopulateNeighborCache (m_devices.Get (0)->GetChannel ());
+}
+
+void
+NeighborCacheLan::Listen (void)
+{
+  for (NodeContainer::Iterator i = m_nodes.Begin (); i != m_nodes.End (); ++i)
+    {
+      Ptr<Socket> socket = Socket::CreateSocket (*i, UdpSocketFactory::GetTypeId ());
+      socket->Bind (InetSocketAddress (Ipv4Address::GetAny (), 1234));
+      socket->SetRecvCallback (MakeCallback (&NeighborCacheLan::ReceiveDatagram, this));
+      m_sockets.push_back (socket);
+      socket = Socket::CreateSocket (*i, UdpSocketFactory::GetTypeId ());
+      socket->Bind (Inet6SocketAddress (Ipv6Address::GetAny (), 1234));
+      socket->SetRecvCallback (MakeCallback (&NeighborCacheLan::ReceiveDatagram, this));
+      m_sockets.push_back (socket);
+    }
+}
+
+void
+NeighborCacheLan::Send (uint32_t from, uint32_t to, bool ipv6)
+{
+  Ptr<Socket> socket = m_sockets[2 * from + (ipv6 ? 1 : 0)];
+  if (ipv6)
+    {
+      socket->SendTo (Create<Packet> (100), 0, Inet6SocketAddress (m_ipv6Interfaces.GetAddress (to, 1), 1234));
+    }
+  else
+    {
+      socket->SendTo (Create<Packet> (100), 0, InetSocketAddress (m_ipv4Interfaces.GetAddress (to), 1234));
+    }
+}
+
+void
+NeighborCacheLan::ReceiveArp (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                              const Address &from, const Address &to, NetDevice::PacketType packetType)
+{
+  m_arp++;
+}
+
+void
+NeighborCacheLan::ReceiveIpv6 (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                               const Address &from, const Address &to, NetDevice::PacketType packetType)
+{
+  Ptr<Packet> p = packet->Copy ();
+  Ipv6Header ipv6Header;
+  p->RemoveHeader (ipv6Header);
+  if (ipv6Header.GetNextHeader () == Icmpv6L4Protocol::PROT_NUMBER)
+    {
+      Icmpv6Header icmpv6Header;
+      p->PeekHeader (icmpv6Header);
+      if (icmpv6Header.GetType () == Icmpv6Header::ICMPV6_ND_NEIGHBOR_SOLICITATION)
+        {
+          m_ns++;
+        }
+    }
+}
+
+void
+NeighborCacheLan::ReceiveDatagram (Ptr<Socket> socket)
+{
+  Ptr<Packet> packet;
+  while ((packet = socket->Recv (std::numeric_limits<uint32_t>::max (), 0)))
+    {
+      m_received++;
+      m_lastReceived = Simulator::Now ();
+    }
+}
+
+/**
+ * Check that the neighbors of a populated link are resolved at once, by
+ * PERMANENT entries, and that those of a link which is not are resolved
+ * by ARP and Neighbor Discovery.
+ */
+class NeighborCacheTest : public TestCase
+{
+public:
+  NeighborCacheTest (bool populate);
+private:
+  virtual void DoRun (void);
+  bool m_populate;
+};
+
+NeighborCacheTest::NeighborCacheTest (bool populate)
+  : TestCase (populate ? "Static neighbors resolve without ARP or NDisc" : "Dynamic neighbors resolve with ARP and NDisc"),
+    m_populate (populate)
+{
+}
+
+void
+NeighborCacheTest::DoRun (void)
+{
+  NeighborCacheLan lan (3);
+  if (m_populate)
+    {
+      lan.Populate ();
+    }
+  lan.Listen ();
+  Simulator::Schedule (Seconds (1), &NeighborCacheLan::Send, &lan, 0, 2, false);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (lan.m_received, 1, "The IPv4 datagram was not received");
+
+  Ptr<Ipv4L3Protocol> ipv4 = lan.m_nodes.Get (0)->GetObject<Ipv4L3Protocol> ();
+  Ptr<ArpCache> arpCache = ipv4->GetInterface (1)->GetArpCache ();
+  ArpCache::Entry *arpEntry = arpCache->Lookup (lan.m_ipv4Interfaces.GetAddress (2));
+  NS_TEST_ASSERT_MSG_NE (arpEntry, 0, "No ARP cache entry for the destination");
+  NS_TEST_EXPECT_MSG_EQ (arpEntry->IsPermanent (), m_populate, "Wrong ARP cache entry state");
+  NS_TEST_EXPECT_MSG_EQ (arpEntry->GetMacAddress (), lan.m_devices.Get (2)->GetAddress (),
+                         "Wrong ARP cache entry address");
+  if (m_populate)
+    {
+      NS_TEST_EXPECT_MSG_EQ (lan.m_arp, 0, "ARP frames on a populated link");
+      NS_TEST_EXPECT_MSG_EQ (lan.m_lastReceived, Seconds (1), "The IPv4 datagram waited for a resolution");
+      NS_TEST_EXPECT_MSG_EQ (arpCache->GetStaticNeighbors ()->GetN (), 3, "Wrong number of IPv4 neighbors");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_GT (lan.m_arp, 0, "No ARP frame on a dynamic link");
+    }
+
+  Time sent = Simulator::Now () + Seconds (1);
+  Simulator::Schedule (Seconds (1), &NeighborCacheLan::Send, &lan, 0, 2, true);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (lan.m_received, 2, "The IPv6 datagram was not received");
+
+  Ptr<Ipv6L3Protocol> ipv6 = lan.m_nodes.Get (0)->GetObject<Ipv6L3Protocol> ();
+  Ptr<NdiscCache> ndiscCache = ipv6->GetInterface (1)->GetNdiscCache ();
+  NdiscCache::Entry *ndiscEntry = ndiscCache->Lookup (lan.m_ipv6Interfaces.GetAddress (2, 1));
+  NS_TEST_ASSERT_MSG_NE (ndiscEntry, 0, "No NDisc cache entry for the destination");
+  NS_TEST_EXPECT_MSG_EQ (ndiscEntry->IsPermanent (), m_populate, "Wrong NDisc cache entry state");
+  NS_TEST_EXPECT_MSG_EQ (ndiscEntry->GetMacAddress (), lan.m_devices.Get (2)->GetAddress (),
+                         "Wrong NDisc cache entry address");
+  if (m_populate)
+    {
+      NS_TEST_EXPECT_MSG_EQ (lan.m_ns, 0, "Neighbor Solicitations on a populated link");
+      NS_TEST_EXPECT_MSG_EQ (lan.m_lastReceived, sent, "The IPv6 datagram waited for a resolution");
+      // A global and a link-local address per host
+      NS_TEST_EXPECT_MSG_EQ (ndiscCache->GetStaticNeighbors ()->GetN (), 6, "Wrong number of IPv6 neighbors");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_GT (lan.m_ns, 0, "No Neighbor Solicitation on a dynamic link");
+    }
+
+  // Neighbor Discovery does not change a PERMANENT entry
+  if (m_populate)
+    {
+      Simulator::Schedule (Seconds (100), &NeighborCacheLan::Send, &lan, 0, 2, true);
+      Simulator::Run ();
+      NS_TEST_EXPECT_MSG_EQ (ndiscEntry->IsPermanent (), true, "The PERMANENT entry has aged");
+      NS_TEST_EXPECT_MSG_EQ (lan.m_ns, 0, "Neighbor Solicitations on a populated link");
+    }
+  Simulator::Destroy ();
+}
+
+//-----------------------------------------------------------------------------
+class NeighborCacheTestSuite : public TestSuite
+{
+public:
+  NeighborCacheTestSuite () : TestSuite ("neighbor-cache", UNIT)
+  {
+    AddTestCase (new NeighborCacheTest (false), TestCase::QUICK);
+    AddTestCase (new NeighborCacheTest (true), TestCase::QUICK);
+  }
+} g_neighborCacheTestSuite;
+
+//-----------------------------------------------------------------------------
+class NeighborCachePerfTest : public TestCase
+{
+public:
+  NeighborCachePerfTest ();
+private:
+  virtual void DoRun (void);
+  // Start a LAN where every host sends a datagram to the next one
+  void Measure (uint32_t hosts, bool populate);
+};
+
+NeighborCachePerfTest::NeighborCachePerfTest ()
+  : TestCase ("Measure the start-up of a LAN")
+{
+}
+
+void
+NeighborCachePerfTest::Measure (uint32_t hosts, bool populate)
+{
+  NeighborCacheLan lan (hosts);
+  std::clock_t start = std::clock ();
+  if (populate)
+    {
+      lan.Populate ();
+    }
+  lan.Listen ();
+  for (uint32_t i = 0; i < hosts; i++)
+    {
+      Simulator::Schedule (Seconds (1), &NeighborCacheLan::Send, &lan, i, (i + 1) % hosts, false);
+    }
+  Simulator::Run ();
+  double seconds = double (std::clock () - start) / CLOCKS_PER_SEC;
+  NS_TEST_ASSERT_MSG_EQ (lan.m_received, hosts, "Not all the datagrams were received");
+  std::cout << GetParent ()->GetName () << ": "
+            << std::setw (6) << hosts << " hosts, "
+            << (populate ? "static " : "ARP    ")
+            << std::setw (9) << lan.m_arp << " ARP frames "
+            << std::fixed << std::setprecision (1)
+            << std::setw (10) << 1e3 * seconds << " ms "
+            << std::setprecision (3)
+            << (lan.m_lastReceived - Seconds (1)).GetSeconds () * 1e3 << " ms to converge" << std::endl;
+  Simulator::Destroy ();
+}
+
+void
+NeighborCachePerfTest::DoRun (void)
+{
+  Measure (1000, false);
+  Measure (1000, true);
+  Measure (2000, false);
+  Measure (2000, true);
+}
+
+class NeighborCachePerfTestSuite : public TestSuite
+{
+public:
+  NeighborCachePerfTestSuite () : TestSuite ("neighbor-cache-perf", PERFORMANCE)
+  {
+    AddTestCase (new NeighborCachePerfTest, TestCase::QUICK);
+  }
+} g_neighborCachePerfTestSuite;
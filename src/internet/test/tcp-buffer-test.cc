@@ -0,0 +1,477 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Tests of TcpTxBuffer and TcpRxBuffer against a byte model of the
+// stream, and benchmarks of large windows
+
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simulator.h"
+#include "ns3/tcp-header.h"
+#include "ns3/tcp-rx-buffer.h"
+#include "ns3/tcp-tx-buffer.h"
+
+using namespace ns3;
+
+namespace {
+
+/**
+ * \param [in] offset A stream offset.
+ * \returns the byte of the test stream at this offset.
+ */
+uint8_t
+StreamByte (uint32_t offset)
+{
+  return (offset * 7 + offset / 251) & 0xff;
+}
+
+/**
+ * Create a packet of the test stream.
+ * \param [in] offset Stream offset of the first byte.
+ * \param [in] size Number of bytes.
+ * \returns the packet.
+ */
+Ptr<Packet>
+CreateStreamPacket (uint32_t offset, uint32_t size)
+{
+  std::vector<uint8_t> data (size);
+  for (uint32_t i = 0; i < size; i++)
+    {
+      data[i] = StreamByte (offset + i);
+    }
+  return Create<Packet> (size > 0 ? &data[0] : 0, size);
+}
+
+/**
+ * Check that a packet holds the test stream.
+ * \param [in] p The packet.
+ * \param [in] offset Stream offset of the first byte.
+ * \returns true if all the bytes match.
+ */
+bool
+IsStream (Ptr<const Packet> p, uint32_t offset)
+{
+  std::vector<uint8_t> data (p->GetSize () + 1);
+  p->CopyData (&data[0], p->GetSize ());
+  for (uint32_t i = 0; i < p->GetSize (); i++)
+    {
+      if (data[i] != StreamByte (offset + i))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+} // anonymous namespace
+
+
+/**
+ * \ingroup internet-test
+ * Add, extract and discard random ranges of a TcpTxBuffer, and check the
+ * extracted bytes.
+ */
+class TcpTxBufferTestCase : public TestCase
+{
+public:
+  TcpTxBufferTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TcpTxBufferTestCase::TcpTxBufferTestCase ()
+  : TestCase ("Check TcpTxBuffer extraction against the byte stream")
+{
+}
+
+void
+TcpTxBufferTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  // Start close to the wrap around of the sequence numbers
+  const uint32_t isn = 0xffff0000;
+  Ptr<TcpTxBuffer> buffer = CreateObject<TcpTxBuffer> (isn);
+  buffer->SetMaxBufferSize (200000);
+  uint32_t head = 0;    // Stream offset of the head of the buffer
+  uint32_t tail = 0;    // Stream offset of the tail of the buffer
+  uint32_t next = 0;    // Stream offset of the next segment sent in sequence
+  for (uint32_t step = 0; step < 3000; step++)
+    {
+      uint32_t op = rng->GetInteger (0, 9);
+      if (op < 3)
+        {
+          uint32_t size = rng->GetInteger (1, 3000);
+          bool room = size <= buffer->Available ();
+          NS_TEST_ASSERT_MSG_EQ (buffer->Add (CreateStreamPacket (tail, size)), room,
+                                 "Add does not follow the available room");
+          if (room)
+            {
+              tail += size;
+            }
+        }
+      else if (op < 7 && next < tail)
+        { // Send the next segment
+          uint32_t size = std::min<uint32_t> (1448, tail - next);
+          Ptr<Packet> p = buffer->CopyFromSequence (1448, SequenceNumber32 (isn + next));
+          NS_TEST_ASSERT_MSG_EQ (p->GetSize (), size, "Wrong segment size");
+          NS_TEST_ASSERT_MSG_EQ (IsStream (p, next), true, "Wrong segment data at " << next);
+          next += size;
+        }
+      else if (op < 8 && head < tail)
+        { // Retransmit a random range
+          uint32_t from = rng->GetInteger (head, tail - 1);
+          uint32_t size = rng->GetInteger (1, 5000);
+          Ptr<Packet> p = buffer->CopyFromSequence (size, SequenceNumber32 (isn + from));
+          NS_TEST_ASSERT_MSG_EQ (p->GetSize (), std::min (size, tail - from), "Wrong range size");
+          NS_TEST_ASSERT_MSG_EQ (IsStream (p, from), true, "Wrong range data at " << from);
+        }
+      else if (head < next)
+        { // Acknowledge some of the data sent
+          head = rng->GetInteger (head + 1, next);
+          buffer->DiscardUpTo (SequenceNumber32 (isn + head));
+        }
+      NS_TEST_ASSERT_MSG_EQ (buffer->HeadSequence (), SequenceNumber32 (isn + head), "Wrong head");
+      NS_TEST_ASSERT_MSG_EQ (buffer->Size (), tail - head, "Wrong size");
+      NS_TEST_ASSERT_MSG_EQ (buffer->SizeFromSequence (SequenceNumber32 (isn + next)), tail - next,
+                             "Wrong size from sequence");
+    }
+}
+
+
+/**
+ * \ingroup internet-test
+ * Receive random, overlapping and out-of-order segments in a TcpRxBuffer,
+ * and check the data read, the buffer occupancy and the SACK blocks.
+ */
+class TcpRxBufferTestCase : public TestCase
+{
+public:
+  TcpRxBufferTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TcpRxBufferTestCase::TcpRxBufferTestCase ()
+  : TestCase ("Check TcpRxBuffer reassembly and SACK blocks against the byte stream")
+{
+}
+
+void
+TcpRxBufferTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  const uint32_t isn = 0xfffff000;
+  const uint32_t length = 40000;
+  Ptr<TcpRxBuffer> buffer = CreateObject<TcpRxBuffer> (isn);
+  buffer->SetMaxBufferSize (1 << 20);
+  std::vector<bool> received (length, false);
+  uint32_t nextRx = 0;  // Stream offset of the first missing byte
+  uint32_t read = 0;    // Stream offset of the first byte not read
+  for (uint32_t step = 0; step < 2000 && read < length; step++)
+    {
+      if (rng->GetInteger (0, 4) == 0)
+        {
+          uint32_t size = rng->GetInteger (1, 4000);
+          Ptr<Packet> p = buffer->Extract (size);
+          uint32_t expected = std::min (size, nextRx - read);
+          if (expected == 0)
+            {
+              NS_TEST_ASSERT_MSG_EQ (p, 0, "Extracted data that is not available");
+              continue;
+            }
+          NS_TEST_ASSERT_MSG_EQ (p->GetSize (), expected, "Wrong extracted size");
+          NS_TEST_ASSERT_MSG_EQ (IsStream (p, read), true, "Wrong extracted data at " << read);
+          read += expected;
+        }
+      else
+        {
+          // Retransmissions that fill the first gap and may cover the
+          // blocks after it, or small segments around the first gap, some
+          // of them duplicates
+          uint32_t from;
+          uint32_t size;
+          if (nextRx < length && rng->GetInteger (0, 3) == 0)
+            {
+              from = nextRx;
+              size = rng->GetInteger (1, 4000);
+            }
+          else
+            {
+              from = rng->GetInteger (read, std::min (length - 1, nextRx + 10000));
+              size = rng->GetInteger (1, 600);
+            }
+          size = std::min (size, length - from);
+          TcpHeader header;
+          header.SetSequenceNumber (SequenceNumber32 (isn + from));
+          bool fresh = false;
+          for (uint32_t i = from; i < from + size; i++)
+            {
+              fresh = fresh || !received[i];
+              received[i] = true;
+            }
+          NS_TEST_ASSERT_MSG_EQ (buffer->Add (CreateStreamPacket (from, size), header), fresh,
+                                 "Add does not report new data");
+          while (nextRx < length && received[nextRx])
+            {
+              nextRx++;
+            }
+          // The SACK blocks are the runs of data after the first gap, the
+          // one of this segment first
+          TcpRxBuffer::SackList sackList = buffer->GetSackList ();
+          uint32_t blocks = 0;
+          uint32_t held = 0;
+          for (uint32_t i = nextRx; i < length; i++)
+            {
+              if (received[i])
+                {
+                  held++;
+                  if (!received[i - 1])
+                    {
+                      blocks++;
+                    }
+                }
+            }
+          NS_TEST_ASSERT_MSG_EQ (sackList.size (), blocks, "Wrong number of SACK blocks");
+          NS_TEST_ASSERT_MSG_EQ (buffer->GetSackListSize (), blocks, "Wrong SACK list size");
+          for (TcpRxBuffer::SackList::const_iterator i = sackList.begin (); i != sackList.end (); ++i)
+            {
+              uint32_t start = i->first - SequenceNumber32 (isn);
+              uint32_t end = i->second - SequenceNumber32 (isn);
+              NS_TEST_ASSERT_MSG_EQ ((start > nextRx && start < end && end <= length), true,
+                                     "SACK block out of range");
+              if (start > nextRx && start < end && end <= length)
+                {
+                  NS_TEST_ASSERT_MSG_EQ ((received[start] && !received[start - 1]
+                                          && received[end - 1] && (end == length || !received[end])),
+                                         true, "SACK block is not a run of data");
+                }
+            }
+          if (from >= nextRx)
+            {
+              NS_TEST_ASSERT_MSG_EQ (sackList.empty (), false, "Missing SACK block");
+              if (!sackList.empty ())
+                {
+                  NS_TEST_ASSERT_MSG_EQ ((SequenceNumber32 (isn + from) >= sackList.front ().first
+                                          && SequenceNumber32 (isn + from) < sackList.front ().second),
+                                         true, "First SACK block is not the last segment's");
+                }
+            }
+          NS_TEST_ASSERT_MSG_EQ (buffer->Size (), nextRx - read + held, "Wrong occupancy");
+        }
+      NS_TEST_ASSERT_MSG_EQ (buffer->NextRxSequence (), SequenceNumber32 (isn + nextRx),
+                             "Wrong next sequence");
+      NS_TEST_ASSERT_MSG_EQ (buffer->Available (), nextRx - read, "Wrong available bytes");
+    }
+}
+
+
+/**
+ * \ingroup internet-test
+ * Check the receive window limits of TcpRxBuffer.
+ */
+class TcpRxBufferWindowTestCase : public TestCase
+{
+public:
+  TcpRxBufferWindowTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TcpRxBufferWindowTestCase::TcpRxBufferWindowTestCase ()
+  : TestCase ("Check the TcpRxBuffer window and FIN")
+{
+}
+
+void
+TcpRxBufferWindowTestCase::DoRun (void)
+{
+  Ptr<TcpRxBuffer> buffer = CreateObject<TcpRxBuffer> (1000);
+  buffer->SetMaxBufferSize (3000);
+  TcpHeader header;
+  NS_TEST_ASSERT_MSG_EQ (buffer->MaxRxSequence (), SequenceNumber32 (4000), "Wrong empty window");
+
+  // Out-of-order data: the window starts at the first buffered byte
+  header.SetSequenceNumber (SequenceNumber32 (2000));
+  NS_TEST_ASSERT_MSG_EQ (buffer->Add (CreateStreamPacket (1000, 1000), header), true, "Add failed");
+  NS_TEST_ASSERT_MSG_EQ (buffer->MaxRxSequence (), SequenceNumber32 (5000), "Wrong window");
+  NS_TEST_ASSERT_MSG_EQ (buffer->Available (), 0, "Out-of-order data available");
+
+  // Data beyond the window is trimmed
+  header.SetSequenceNumber (SequenceNumber32 (4000));
+  NS_TEST_ASSERT_MSG_EQ (buffer->Add (CreateStreamPacket (3000, 2000), header), true, "Add failed");
+  NS_TEST_ASSERT_MSG_EQ (buffer->Size (), 2000, "Data beyond the window kept");
+  header.SetSequenceNumber (SequenceNumber32 (5000));
+  NS_TEST_ASSERT_MSG_EQ (buffer->Add (CreateStreamPacket (4000, 100), header), false,
+                         "Data beyond the window added");
+  NS_TEST_ASSERT_MSG_EQ (buffer->GetSackListSize (), 2, "Wrong SACK blocks");
+  NS_TEST_ASSERT_MSG_EQ (buffer->GetSackList ().front ().first, SequenceNumber32 (4000),
+                         "Wrong most recent SACK block");
+
+  // Fill the gaps and read it all
+  header.SetSequenceNumber (SequenceNumber32 (1000));
+  NS_TEST_ASSERT_MSG_EQ (buffer->Add (CreateStreamPacket (0, 3000), header), true, "Add failed");
+  NS_TEST_ASSERT_MSG_EQ (buffer->NextRxSequence (), SequenceNumber32 (5000), "Wrong next sequence");
+  NS_TEST_ASSERT_MSG_EQ (buffer->GetSackListSize (), 0, "SACK blocks left");
+  NS_TEST_ASSERT_MSG_EQ (buffer->MaxRxSequence (), SequenceNumber32 (4000), "Wrong window");
+  buffer->SetFinSequence (SequenceNumber32 (5000));
+  NS_TEST_ASSERT_MSG_EQ (buffer->NextRxSequence (), SequenceNumber32 (5001), "FIN not accounted");
+  Ptr<Packet> p = buffer->Extract (10000);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 4000, "Wrong extracted size");
+  NS_TEST_ASSERT_MSG_EQ (IsStream (p, 0), true, "Wrong extracted data");
+  NS_TEST_ASSERT_MSG_EQ (buffer->Finished (), true, "Not finished");
+}
+
+
+/**
+ * \ingroup internet-test
+ * TCP buffer test suite.
+ */
+class TcpBufferTestSuite : public TestSuite
+{
+public:
+  TcpBufferTestSuite ();
+};
+
+TcpBufferTestSuite::TcpBufferTestSuite ()
+  : TestSuite ("tcp-buffer", UNIT)
+{
+  AddTestCase (new TcpTxBufferTestCase, TestCase::QUICK);
+  AddTestCase (new TcpRxBufferTestCase, TestCase::QUICK);
+  AddTestCase (new TcpRxBufferWindowTestCase, TestCase::QUICK);
+}
+
+static TcpBufferTestSuite g_tcpBufferTestSuite;
+
+
+/**
+ * \ingroup internet-test
+ * Measure the TCP buffer costs with a large window.
+ */
+class TcpBufferPerfTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] segments The window, in segments.
+   */
+  TcpBufferPerfTestCase (uint32_t segments);
+private:
+  virtual void DoRun (void);
+  /**
+   * Print a measurement.
+   * \param [in] what The operation measured.
+   * \param [in] start The clock at the start of the operations.
+   * \param [in] n The number of segments.
+   */
+  void Report (const std::string what, std::clock_t start, uint32_t n);
+  uint32_t m_segments; //!< The window, in segments.
+};
+
+TcpBufferPerfTestCase::TcpBufferPerfTestCase (uint32_t segments)
+  : TestCase ("Measure TCP buffer costs"),
+    m_segments (segments)
+{
+}
+
+void
+TcpBufferPerfTestCase::Report (const std::string what, std::clock_t start, uint32_t n)
+{
+  double per = 1e9 * double (std::clock () - start) / (double (n) * CLOCKS_PER_SEC);
+  std::cout << GetParent ()->GetName () << ": "
+            << std::left << std::setw (36) << what << std::right
+            << std::setw (8) << m_segments << " segments "
+            << std::fixed << std::setprecision (1) << std::setw (10) << per
+            << " ns/segment" << std::endl;
+}
+
+void
+TcpBufferPerfTestCase::DoRun (void)
+{
+  const uint32_t mss = 1448;
+  const uint32_t window = m_segments * mss;
+
+  // Sender: the application writes 512 byte packets, as BulkSendApplication
+  // does by default, and a window of segments is sent then acknowledged
+  Ptr<TcpTxBuffer> tx = CreateObject<TcpTxBuffer> ();
+  tx->SetMaxBufferSize (window);
+  while (tx->Available () >= 512)
+    {
+      tx->Add (Create<Packet> (512));
+    }
+  uint32_t sent = 0;
+  std::clock_t start = std::clock ();
+  for (uint32_t seq = 0; seq + mss <= tx->Size (); seq += mss)
+    {
+      sent += tx->CopyFromSequence (mss, SequenceNumber32 (seq))->GetSize ();
+    }
+  Report ("TcpTxBuffer send window", start, m_segments);
+  NS_TEST_ASSERT_MSG_EQ (sent, (window / 512 * 512) / mss * mss, "Wrong amount sent");
+  start = std::clock ();
+  for (uint32_t seq = 2 * mss; seq <= sent; seq += 2 * mss)
+    {
+      tx->DiscardUpTo (SequenceNumber32 (seq));
+    }
+  Report ("TcpTxBuffer acknowledge window", start, m_segments);
+
+  // Receiver: the first segment of the window is lost, the others arrive
+  // out of order until it is retransmitted
+  Ptr<TcpRxBuffer> rx = CreateObject<TcpRxBuffer> ();
+  rx->SetMaxBufferSize (window);
+  TcpHeader header;
+  start = std::clock ();
+  for (uint32_t i = 1; i < m_segments; i++)
+    {
+      header.SetSequenceNumber (SequenceNumber32 (i * mss));
+      rx->Add (Create<Packet> (mss), header);
+    }
+  Report ("TcpRxBuffer receive out of order", start, m_segments);
+  start = std::clock ();
+  header.SetSequenceNumber (SequenceNumber32 (0));
+  rx->Add (Create<Packet> (mss), header);
+  uint32_t read = 0;
+  while (rx->Available () > 0)
+    {
+      read += rx->Extract (16384)->GetSize ();
+    }
+  Report ("TcpRxBuffer recover and read", start, m_segments);
+  NS_TEST_ASSERT_MSG_EQ (read, window, "Wrong amount read");
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * TCP buffer performance suite.
+ */
+class TcpBufferPerfTestSuite : public TestSuite
+{
+public:
+  TcpBufferPerfTestSuite ();
+};
+
+TcpBufferPerfTestSuite::TcpBufferPerfTestSuite ()
+  : TestSuite ("tcp-buffer-perf", PERFORMANCE)
+{
+  AddTestCase (new TcpBufferPerfTestCase (1000), TestCase::QUICK);
+  AddTestCase (new TcpBufferPerfTestCase (10000), TestCase::QUICK);
+}
+
+static TcpBufferPerfTestSuite g_tcpBufferPerfTestSuite;
@@ -0,0 +1,557 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Tests of TCP segmentation offload and receive coalescing
+
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <string>
+
+#include "ns3/test.h"
+#include "ns3/boolean.h"
+#include "ns3/error-model.h"
+#include "ns3/simulator.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/tcp-segmentation-offload.h"
+#include "ns3/tcp-header.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv4-list-routing.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/node.h"
+#include "ns3/uinteger.h"
+#include "ns3/data-rate.h"
+#include "ns3/drop-tail-queue.h"
+#include "ns3/arp-l3-protocol.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/icmpv4-l4-protocol.h"
+#include "ns3/udp-l4-protocol.h"
+#include "ns3/tcp-l4-protocol.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * Check the cutting of a TCP super-segment.
+ */
+class TcpSegmentationTestCase : public TestCase
+{
+public:
+  TcpSegmentationTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TcpSegmentationTestCase::TcpSegmentationTestCase ()
+  : TestCase ("Check the cutting of a TCP super-segment")
+{
+}
+
+void
+TcpSegmentationTestCase::DoRun (void)
+{
+  const uint32_t size = 10500;
+  uint8_t data[size];
+  for (uint32_t i = 0; i < size; i++)
+    {
+      data[i] = i % 251;
+    }
+  Ptr<Packet> p = Create<Packet> (data, size);
+  TcpHeader tcpHeader;
+  tcpHeader.SetSourcePort (1234);
+  tcpHeader.SetDestinationPort (80);
+  tcpHeader.SetSequenceNumber (SequenceNumber32 (1000));
+  tcpHeader.SetAckNumber (SequenceNumber32 (5));
+  tcpHeader.SetFlags (TcpHeader::ACK | TcpHeader::PSH | TcpHeader::FIN);
+  tcpHeader.SetWindowSize (4000);
+  p->AddHeader (tcpHeader);
+  NS_TEST_ASSERT_MSG_EQ (TcpSegmentationOffload::GetSegmentCount (p, 1000), 11, "Wrong segment count");
+  NS_TEST_ASSERT_MSG_EQ (TcpSegmentationOffload::GetSegmentCount (p, 1050), 10, "Wrong segment count");
+  NS_TEST_ASSERT_MSG_EQ (TcpSegmentationOffload::GetSegmentCount (p, 10500), 1, "Wrong segment count");
+  Ipv4Header ipHeader;
+  ipHeader.SetSource (Ipv4Address ("10.1.1.1"));
+  ipHeader.SetDestination (Ipv4Address ("10.1.1.2"));
+  ipHeader.SetProtocol (TcpL4Protocol::PROT_NUMBER);
+  ipHeader.SetPayloadSize (p->GetSize ());
+  ipHeader.SetIdentification (100);
+  p->AddHeader (ipHeader);
+  TcpSegmentationTag tag;
+  tag.SetSegmentSize (1000);
+  p->AddPacketTag (tag);
+
+  std::list<Ptr<Packet> > segments;
+  TcpSegmentationOffload::Segment (p, 1000, segments);
+  NS_TEST_ASSERT_MSG_EQ (segments.size (), 11, "Wrong number of segments");
+
+  uint32_t offset = 0;
+  for (std::list<Ptr<Packet> >::iterator i = segments.begin (); i != segments.end (); ++i)
+    {
+      Ptr<Packet> segment = *i;
+      NS_TEST_ASSERT_MSG_EQ (segment->PeekPacketTag (tag), false, "Segment still tagged");
+      Ipv4Header ih;
+      segment->RemoveHeader (ih);
+      TcpHeader th;
+      segment->RemoveHeader (th);
+      uint32_t length = std::min<uint32_t> (1000, size - offset);
+      bool last = offset + length == size;
+      NS_TEST_ASSERT_MSG_EQ (segment->GetSize (), length, "Wrong segment size");
+      NS_TEST_ASSERT_MSG_EQ (ih.GetPayloadSize (), length + 20, "Wrong IPv4 payload size");
+      NS_TEST_ASSERT_MSG_EQ (ih.GetIdentification (), 100 + offset / 1000, "Wrong identification");
+      NS_TEST_ASSERT_MSG_EQ (ih.GetSource (), Ipv4Address ("10.1.1.1"), "Wrong source");
+      NS_TEST_ASSERT_MSG_EQ (th.GetSequenceNumber (), SequenceNumber32 (1000 + offset), "Wrong sequence number");
+      NS_TEST_ASSERT_MSG_EQ (th.GetAckNumber (), SequenceNumber32 (5), "Wrong ACK number");
+      NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (th.GetFlags ()),
+                             static_cast<uint32_t> (last ? (TcpHeader::ACK | TcpHeader::PSH | TcpHeader::FIN)
+                                                    : TcpHeader::ACK), "Wrong flags");
+      uint8_t buffer[1000];
+      segment->CopyData (buffer, length);
+      NS_TEST_ASSERT_MSG_EQ (memcmp (buffer, data + offset, length), 0, "Wrong data");
+      offset += length;
+    }
+}
+
+
+/**
+ * \ingroup internet-test
+ * Count the packets that reach a device, and the largest.
+ */
+class TcpOffloadPacketCounter : public ErrorModel
+{
+public:
+  TcpOffloadPacketCounter ()
+    : m_packets (0),
+      m_largest (0)
+  {
+  }
+  uint32_t m_packets;  //!< Packets received
+  uint32_t m_largest;  //!< Size of the largest packet received
+private:
+  virtual bool DoCorrupt (Ptr<Packet> p)
+  {
+    m_packets++;
+    m_largest = std::max (m_largest, p->GetSize ());
+    return false;
+  }
+  virtual void DoReset (void)
+  {
+    m_packets = 0;
+    m_largest = 0;
+  }
+};
+
+
+/**
+ * \ingroup internet-test
+ * A TCP transfer between two nodes over a fast link, with the offloads
+ * configured.
+ */
+class TcpOffloadTransfer
+{
+public:
+  /**
+   * Constructor.
+   * \param totalBytes bytes to transfer
+   * \param tso enable TSO on the sender
+   * \param gro enable GRO on the receiver
+   * \param mtu the device MTU
+   */
+  TcpOffloadTransfer (uint32_t totalBytes, bool tso, bool gro, uint16_t mtu);
+  /**
+   * \brief Run the transfer until it completes
+   */
+  void Run (void);
+
+  uint32_t m_received;       //!< Bytes read by the server
+  bool m_intact;             //!< The data read is the data written
+  uint32_t m_senderIpTx;     //!< Packets the sender IPv4 layer sent
+  uint32_t m_receiverIpTx;   //!< Packets the receiver IPv4 layer sent
+  Time m_done;               //!< Time the last byte was read
+  Ptr<TcpOffloadPacketCounter> m_deviceRx; //!< Packets at the receiver device
+
+private:
+  /**
+   * \brief Create a node with the IPv4 stack
+   * \returns the node
+   */
+  Ptr<Node> CreateInternetNode (void);
+  /**
+   * \brief Add a device on a channel, with an address
+   * \param node the node
+   * \param channel the channel
+   * \param address the IPv4 address
+   * \returns the device
+   */
+  Ptr<SimpleNetDevice> AddDevice (Ptr<Node> node, Ptr<SimpleChannel> channel, Ipv4Address address);
+  /**
+   * \brief Write the data the socket has room for
+   * \param socket the source socket
+   * \param available the room in the buffer
+   */
+  void SourceSend (Ptr<Socket> socket, uint32_t available);
+  /**
+   * \brief Read and check the data received
+   * \param socket the server socket
+   */
+  void ServerRecv (Ptr<Socket> socket);
+  /**
+   * \brief Accept a connection
+   * \param socket the new socket
+   * \param from the address of the peer
+   */
+  void ServerAccept (Ptr<Socket> socket, const Address& from);
+  /**
+   * \brief Count the packets sent by the sender IPv4 layer
+   * \param p the packet
+   * \param ipv4 the IPv4 layer
+   * \param interface the interface
+   */
+  void SenderIpTx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface);
+  /**
+   * \brief Count the packets sent by the receiver IPv4 layer
+   * \param p the packet
+   * \param ipv4 the IPv4 layer
+   * \param interface the interface
+   */
+  void ReceiverIpTx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface);
+
+  uint32_t m_totalBytes;     //!< Bytes to transfer
+  bool m_tso;                //!< TSO on the sender
+  bool m_gro;                //!< GRO on the receiver
+  uint16_t m_mtu;            //!< Device MTU
+  uint32_t m_sent;           //!< Bytes written by the source
+};
+
+TcpOffloadTransfer::TcpOffloadTransfer (uint32_t totalBytes, bool tso, bool gro, uint16_t mtu)
+  : m_received (0),
+    m_intact (true),
+    m_senderIpTx (0),
+    m_receiverIpTx (0),
+    m_totalBytes (totalBytes),
+    m_tso (tso),
+    m_gro (gro),
+    m_mtu (mtu),
+    m_sent (0)
+{
+}
+
+Ptr<Node>
+TcpOffloadTransfer::CreateInternetNode (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  node->AggregateObject (CreateObject<ArpL3Protocol> ());
+  Ptr<Ipv4L3Protocol> ipv4 = CreateObject<Ipv4L3Protocol> ();
+  Ptr<Ipv4ListRouting> ipv4Routing = CreateObject<Ipv4ListRouting> ();
+  ipv4->SetRoutingProtocol (ipv4Routing);
+  ipv4Routing->AddRoutingProtocol (CreateObject<Ipv4StaticRouting> (), 0);
+  node->AggregateObject (ipv4);
+  node->AggregateObject (CreateObject<Icmpv4L4Protocol> ());
+  node->AggregateObject (CreateObject<UdpL4Protocol> ());
+  node->AggregateObject (CreateObject<TcpL4Protocol> ());
+  return node;
+}
+
+Ptr<SimpleNetDevice>
+TcpOffloadTransfer::AddDevice (Ptr<Node> node, Ptr<SimpleChannel> channel, Ipv4Address address)
+{
+  Ptr<SimpleNetDevice> dev = CreateObject<SimpleNetDevice> ();
+  dev->SetAddress (Mac48Address::ConvertFrom (Mac48Address::Allocate ()));
+  dev->SetMtu (m_mtu);
+  dev->SetAttribute ("DataRate", DataRateValue (DataRate ("10Gbps")));
+  // SimpleNetDevice bypasses the data rate for packets its queue can not
+  // hold, so the queue has to be deep enough for the whole window
+  Ptr<DropTailQueue> queue = CreateObject<DropTailQueue> ();
+  queue->SetAttribute ("MaxPackets", UintegerValue (10000));
+  dev->SetQueue (queue);
+  node->AddDevice (dev);
+  dev->SetChannel (channel);
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  uint32_t interface = ipv4->AddInterface (dev);
+  ipv4->AddAddress (interface, Ipv4InterfaceAddress (address, Ipv4Mask ("255.255.255.0")));
+  ipv4->SetUp (interface);
+  return dev;
+}
+
+void
+TcpOffloadTransfer::SourceSend (Ptr<Socket> socket, uint32_t available)
+{
+  uint8_t data[8192];
+  while (m_sent < m_totalBytes && socket->GetTxAvailable () > 0)
+    {
+      uint32_t size = std::min (std::min (socket->GetTxAvailable (), m_totalBytes - m_sent), 8192U);
+      for (uint32_t i = 0; i < size; i++)
+        {
+          data[i] = (m_sent + i) % 251;
+        }
+      int sent = socket->Send (data, size, 0);
+      if (sent < 0)
+        {
+          return;
+        }
+      m_sent += sent;
+    }
+}
+
+void
+TcpOffloadTransfer::ServerRecv (Ptr<Socket> socket)
+{
+  Ptr<Packet> p;
+  uint8_t data[8192];
+  while ((p = socket->Recv ()) && p->GetSize () > 0)
+    {
+      while (p->GetSize () > 0)
+        {
+          uint32_t size = std::min (p->GetSize (), 8192U);
+          p->CopyData (data, size);
+          p->RemoveAtStart (size);
+          for (uint32_t i = 0; i < size && m_intact; i++)
+            {
+              m_intact = data[i] == (m_received + i) % 251;
+            }
+          m_received += size;
+        }
+    }
+  if (m_received == m_totalBytes)
+    {
+      m_done = Simulator::Now ();
+    }
+}
+
+void
+TcpOffloadTransfer::ServerAccept (Ptr<Socket> socket, const Address& from)
+{
+  socket->SetRecvCallback (MakeCallback (&TcpOffloadTransfer::ServerRecv, this));
+}
+
+void
+TcpOffloadTransfer::SenderIpTx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  m_senderIpTx++;
+}
+
+void
+TcpOffloadTransfer::ReceiverIpTx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  m_receiverIpTx++;
+}
+
+void
+TcpOffloadTransfer::Run (void)
+{
+  Ptr<Node> server = CreateInternetNode ();
+  Ptr<Node> source = CreateInternetNode ();
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (MicroSeconds (10)));
+  Ptr<SimpleNetDevice> serverDevice = AddDevice (server, channel, Ipv4Address ("10.1.1.1"));
+  AddDevice (source, channel, Ipv4Address ("10.1.1.2"));
+  m_deviceRx = CreateObject<TcpOffloadPacketCounter> ();
+  serverDevice->SetReceiveErrorModel (m_deviceRx);
+  source->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext (
+    "Tx", MakeCallback (&TcpOffloadTransfer::SenderIpTx, this));
+  server->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext (
+    "Tx", MakeCallback (&TcpOffloadTransfer::ReceiverIpTx, this));
+
+  Ptr<Socket> listener = server->GetObject<TcpSocketFactory> ()->CreateSocket ();
+  listener->SetAttribute ("Gro", BooleanValue (m_gro));
+  listener->SetAttribute ("RcvBufSize", UintegerValue (1 << 20));
+  listener->Bind (InetSocketAddress (Ipv4Address::GetAny (), 50000));
+  listener->Listen ();
+  listener->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                               MakeCallback (&TcpOffloadTransfer::ServerAccept, this));
+
+  Ptr<Socket> sender = source->GetObject<TcpSocketFactory> ()->CreateSocket ();
+  sender->SetAttribute ("Tso", BooleanValue (m_tso));
+  sender->SetAttribute ("SegmentSize", UintegerValue (1448));
+  sender->SetAttribute ("SndBufSize", UintegerValue (1 << 20));
+  sender->SetAttribute ("InitialCwnd", UintegerValue (10));
+  sender->SetSendCallback (MakeCallback (&TcpOffloadTransfer::SourceSend, this));
+  sender->Connect (InetSocketAddress (Ipv4Address ("10.1.1.1"), 50000));
+
+  Simulator::Stop (Seconds (30));
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+
+/**
+ * \ingroup internet-test
+ * Transfer data with the offloads on and off, and check the packets seen
+ * at each layer.
+ */
+class TcpOffloadTransferTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param tso enable TSO on the sender
+   * \param gro enable GRO on the receiver
+   * \param mtu the device MTU
+   */
+  TcpOffloadTransferTestCase (bool tso, bool gro, uint16_t mtu);
+private:
+  virtual void DoRun (void);
+  bool m_tso;     //!< TSO on the sender
+  bool m_gro;     //!< GRO on the receiver
+  uint16_t m_mtu; //!< Device MTU
+};
+
+TcpOffloadTransferTestCase::TcpOffloadTransferTestCase (bool tso, bool gro, uint16_t mtu)
+  : TestCase (std::string ("Check a transfer with TSO ") + (tso ? "on" : "off")
+              + ", GRO " + (gro ? "on" : "off") + " and a "
+              + (mtu > 1500 ? "64 KB" : "1500 byte") + " MTU"),
+    m_tso (tso),
+    m_gro (gro),
+    m_mtu (mtu)
+{
+}
+
+void
+TcpOffloadTransferTestCase::DoRun (void)
+{
+  const uint32_t totalBytes = 2000000;
+  const uint32_t segments = (totalBytes + 1447) / 1448;
+  TcpOffloadTransfer transfer (totalBytes, m_tso, m_gro, m_mtu);
+  transfer.Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (transfer.m_received, totalBytes, "Not all the data was received");
+  NS_TEST_ASSERT_MSG_EQ (transfer.m_intact, true, "The data received differs from the data sent");
+  NS_TEST_ASSERT_MSG_LT (transfer.m_done, MilliSeconds (100), "The transfer stalled");
+  NS_TEST_ASSERT_MSG_LT_OR_EQ (transfer.m_deviceRx->m_largest, m_mtu, "Packet larger than the MTU");
+  if (m_tso)
+    { // Fewer super-segments than segments cross IPv4
+      NS_TEST_ASSERT_MSG_LT (transfer.m_senderIpTx, segments * 3 / 4, "Too few super-segments");
+    }
+  else
+    {
+      NS_TEST_ASSERT_MSG_GT (transfer.m_senderIpTx, segments, "Super-segments without TSO");
+    }
+  if (m_tso && m_mtu > 1500)
+    { // The device sends the super-segments whole
+      NS_TEST_ASSERT_MSG_GT (transfer.m_deviceRx->m_largest, 1500, "Super-segments were cut");
+      NS_TEST_ASSERT_MSG_LT (transfer.m_deviceRx->m_packets, segments / 2, "Super-segments were cut");
+    }
+  else
+    {
+      NS_TEST_ASSERT_MSG_GT_OR_EQ (transfer.m_deviceRx->m_packets, segments, "Segments missing");
+    }
+  if (m_gro && m_mtu <= 1500)
+    { // The segments of a burst are acknowledged together
+      NS_TEST_ASSERT_MSG_LT (transfer.m_receiverIpTx, segments / 4, "Too many ACKs with GRO");
+    }
+  else if (!m_gro && m_mtu <= 1500)
+    { // Delayed ACKs: one for every other segment
+      NS_TEST_ASSERT_MSG_GT (transfer.m_receiverIpTx, segments / 3, "Too few ACKs without GRO");
+    }
+}
+
+
+/**
+ * \ingroup internet-test
+ * TCP offload test suite.
+ */
+class TcpOffloadTestSuite : public TestSuite
+{
+public:
+  TcpOffloadTestSuite ();
+};
+
+TcpOffloadTestSuite::TcpOffloadTestSuite ()
+  : TestSuite ("tcp-offload", UNIT)
+{
+  AddTestCase (new TcpSegmentationTestCase, TestCase::QUICK);
+  AddTestCase (new TcpOffloadTransferTestCase (false, false, 1500), TestCase::QUICK);
+  AddTestCase (new TcpOffloadTransferTestCase (true, false, 1500), TestCase::QUICK);
+  AddTestCase (new TcpOffloadTransferTestCase (false, true, 1500), TestCase::QUICK);
+  AddTestCase (new TcpOffloadTransferTestCase (true, true, 1500), TestCase::QUICK);
+  AddTestCase (new TcpOffloadTransferTestCase (true, false, 65535), TestCase::QUICK);
+}
+
+static TcpOffloadTestSuite g_tcpOffloadTestSuite;
+
+
+/**
+ * \ingroup internet-test
+ * Measure the simulation cost of a fast TCP transfer with the offloads.
+ */
+class TcpOffloadPerfTestCase : public TestCase
+{
+public:
+  TcpOffloadPerfTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * Run a transfer and print its cost.
+   * \param what the configuration
+   * \param tso enable TSO on the sender
+   * \param gro enable GRO on the receiver
+   * \param mtu the device MTU
+   */
+  void Measure (const std::string what, bool tso, bool gro, uint16_t mtu);
+};
+
+TcpOffloadPerfTestCase::TcpOffloadPerfTestCase ()
+  : TestCase ("Measure TCP offload costs")
+{
+}
+
+void
+TcpOffloadPerfTestCase::Measure (const std::string what, bool tso, bool gro, uint16_t mtu)
+{
+  const uint32_t totalBytes = 50000000;
+  TcpOffloadTransfer transfer (totalBytes, tso, gro, mtu);
+  std::clock_t start = std::clock ();
+  transfer.Run ();
+  double seconds = double (std::clock () - start) / CLOCKS_PER_SEC;
+  NS_TEST_ASSERT_MSG_EQ (transfer.m_received, totalBytes, "Not all the data was received");
+  std::cout << GetParent ()->GetName () << ": "
+            << std::left << std::setw (24) << what << std::right
+            << std::fixed << std::setprecision (1)
+            << std::setw (10) << 1e9 * seconds / (totalBytes / 1000000) << " ns/MB "
+            << std::setw (8) << totalBytes * 8e-9 / transfer.m_done.GetSeconds () << " Gb/s simulated "
+            << std::setw (8) << transfer.m_deviceRx->m_packets << " data packets "
+            << std::setw (8) << transfer.m_receiverIpTx << " ACKs" << std::endl;
+}
+
+void
+TcpOffloadPerfTestCase::DoRun (void)
+{
+  Measure ("no offload", false, false, 1500);
+  Measure ("TSO", true, false, 1500);
+  Measure ("GRO", false, true, 1500);
+  Measure ("TSO and GRO", true, true, 1500);
+  Measure ("TSO, 64 KB MTU", true, false, 65535);
+}
+
+/**
+ * \ingroup internet-test
+ * TCP offload performance suite.
+ */
+class TcpOffloadPerfTestSuite : public TestSuite
+{
+public:
+  TcpOffloadPerfTestSuite ();
+};
+
+TcpOffloadPerfTestSuite::TcpOffloadPerfTestSuite ()
+  : TestSuite ("tcp-offload-perf", PERFORMANCE)
+{
+  AddTestCase (new TcpOffloadPerfTestCase, TestCase::QUICK);
+}
+
+static TcpOffloadPerfTestSuite g_tcpOffloadPerfTestSuite;
@@ -22,6 +22,8 @@
 #include "ns3/tcp-option.h"
 #include "ns3/private/tcp-option-winscale.h"
 #include "ns3/private/tcp-option-ts.h"
+#include "ns3/tcp-option-sack.h"
+#include "ns3/tcp-option-sack-permitted.h"
 
 #include <string.h>
 
@@ -164,6 +166,92 @@ TcpOptionTSTestCase::DoTeardown ()
 {
 }
 
+class TcpOptionSackTestCase : public TestCase
+{
+public:
+  TcpOptionSackTestCase (std::string name, uint32_t blocks);
+
+  void TestSerialize ();
+  void TestDeserialize ();
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  uint32_t m_blocks;
+  TcpOptionSack::SackList m_list;
+  Buffer m_buffer;
+};
+
+
+TcpOptionSackTestCase::TcpOptionSackTestCase (std::string name, uint32_t blocks)
+  : TestCase (name)
+{
+  m_blocks = blocks;
+}
+
+void
+TcpOptionSackTestCase::DoRun ()
+{
+  Ptr<UniformRandomVariable> x = CreateObject<UniformRandomVariable> ();
+
+  for (uint32_t i = 0; i < 100; ++i)
+    {
+      m_list.clear ();
+      for (uint32_t j = 0; j < m_blocks; ++j)
+        {
+          SequenceNumber32 first (x->GetInteger ());
+          m_list.push_back (std::make_pair (first, first + SequenceNumber32 (x->GetInteger (1, 65535))));
+        }
+      TestSerialize ();
+      TestDeserialize ();
+    }
+
+  TcpOptionSackPermitted permitted;
+  NS_TEST_EXPECT_MSG_EQ (permitted.GetSerializedSize (), 2, "Wrong SACK-permitted size");
+  m_buffer.AddAtStart (permitted.GetSerializedSize ());
+  permitted.Serialize (m_buffer.Begin ());
+  NS_TEST_EXPECT_MSG_EQ (m_buffer.Begin ().PeekU8 (), TcpOption::SACKPERMITTED, "Different kind found");
+  NS_TEST_EXPECT_MSG_EQ (permitted.Deserialize (m_buffer.Begin ()), 2, "SACK-permitted not read");
+}
+
+void
+TcpOptionSackTestCase::TestSerialize ()
+{
+  TcpOptionSack opt;
+
+  for (TcpOptionSack::SackList::const_iterator it = m_list.begin (); it != m_list.end (); ++it)
+    {
+      opt.AddSackBlock (*it);
+    }
+  NS_TEST_EXPECT_MSG_EQ (opt.GetNumSackBlocks (), m_blocks, "Blocks aren't saved correctly");
+  NS_TEST_EXPECT_MSG_EQ (opt.GetSerializedSize (), 2 + 8 * m_blocks, "Wrong size");
+
+  m_buffer.AddAtStart (opt.GetSerializedSize ());
+
+  opt.Serialize (m_buffer.Begin ());
+}
+
+void
+TcpOptionSackTestCase::TestDeserialize ()
+{
+  TcpOptionSack opt;
+
+  Buffer::Iterator start = m_buffer.Begin ();
+  uint8_t kind = start.PeekU8 ();
+
+  NS_TEST_EXPECT_MSG_EQ (kind, TcpOption::SACK, "Different kind found");
+
+  opt.Deserialize (start);
+
+  NS_TEST_EXPECT_MSG_EQ ((opt.GetSackList () == m_list), true, "Different blocks found");
+}
+
+void
+TcpOptionSackTestCase::DoTeardown ()
+{
+}
+
 static class TcpOptionTestSuite : public TestSuite
 {
 public:
@@ -176,6 +264,11 @@ public:
                                               "scale value", i), TestCase::QUICK);
       }
     AddTestCase (new TcpOptionTSTestCase ("Testing serialization of random values for timestamp"), TestCase::QUICK);
+    for (uint32_t i = 1; i <= 4; ++i)
+      {
+        AddTestCase (new TcpOptionSackTestCase ("Testing serialization of random SACK "
+                                                "blocks", i), TestCase::QUICK);
+      }
   }
 
 } g_TcpOptionTestSuite;
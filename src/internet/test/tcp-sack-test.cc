@@ -0,0 +1,518 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Tests of the TCP scoreboard and of SACK-based loss recovery
+
+#include <map>
+#include <set>
+#include <string>
+
+#include "ns3/test.h"
+#include "ns3/boolean.h"
+#include "ns3/error-model.h"
+#include "ns3/simulator.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/socket-factory.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/tcp-scoreboard.h"
+#include "ns3/tcp-header.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv4-list-routing.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/node.h"
+#include "ns3/uinteger.h"
+#include "ns3/arp-l3-protocol.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/icmpv4-l4-protocol.h"
+#include "ns3/udp-l4-protocol.h"
+#include "ns3/tcp-l4-protocol.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * Check the RFC 6675 loss marking, the pipe and the SACKed ranges of
+ * TcpScoreboard.
+ */
+class TcpScoreboardSackTestCase : public TestCase
+{
+public:
+  TcpScoreboardSackTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TcpScoreboardSackTestCase::TcpScoreboardSackTestCase ()
+  : TestCase ("Check the scoreboard SACK loss marking and pipe")
+{
+}
+
+void
+TcpScoreboardSackTestCase::DoRun (void)
+{
+  TcpScoreboard sb;
+  sb.SetSegmentSize (1000);
+  sb.SetRack (false);
+  for (uint32_t k = 0; k < 10; k++)
+    {
+      sb.Sent (SequenceNumber32 (1000 * k), 1000, MilliSeconds (k));
+    }
+  NS_TEST_ASSERT_MSG_EQ (sb.GetPipe (), 10000, "Wrong pipe after sending");
+
+  // The first two segments are lost, the next three arrive
+  TcpOptionSack::SackList blocks;
+  blocks.push_back (std::make_pair (SequenceNumber32 (2000), SequenceNumber32 (5000)));
+  NS_TEST_ASSERT_MSG_EQ (sb.Sack (blocks, MilliSeconds (100)), 3000, "Wrong SACKed bytes");
+  NS_TEST_ASSERT_MSG_EQ (sb.GetPipe (), 7000, "Wrong pipe after SACK");
+  NS_TEST_ASSERT_MSG_EQ (sb.Sack (blocks, MilliSeconds (101)), 0, "SACKed twice");
+
+  Time timeout;
+  NS_TEST_ASSERT_MSG_EQ (sb.DetectLosses (MilliSeconds (101), timeout), true, "No loss detected");
+  NS_TEST_ASSERT_MSG_EQ (sb.GetPipe (), 5000, "Wrong pipe after loss");
+  NS_TEST_ASSERT_MSG_EQ (sb.DetectLosses (MilliSeconds (101), timeout), false, "Loss detected twice");
+
+  SequenceNumber32 seq;
+  uint32_t length;
+  NS_TEST_ASSERT_MSG_EQ (sb.GetNextLost (seq, length), true, "No loss to retransmit");
+  NS_TEST_ASSERT_MSG_EQ (seq, SequenceNumber32 (0), "Wrong loss");
+  NS_TEST_ASSERT_MSG_EQ (length, 2000, "Wrong loss length");
+  sb.Sent (seq, 1000, MilliSeconds (102));
+  NS_TEST_ASSERT_MSG_EQ (sb.GetPipe (), 6000, "Wrong pipe after retransmission");
+  NS_TEST_ASSERT_MSG_EQ (sb.GetNextLost (seq, length), true, "No loss to retransmit");
+  NS_TEST_ASSERT_MSG_EQ (seq, SequenceNumber32 (1000), "Wrong loss");
+  NS_TEST_ASSERT_MSG_EQ (length, 1000, "Wrong loss length");
+  sb.Sent (seq, 1000, MilliSeconds (102));
+  NS_TEST_ASSERT_MSG_EQ (sb.GetNextLost (seq, length), false, "Loss retransmitted twice");
+
+  NS_TEST_ASSERT_MSG_EQ (sb.SkipSacked (SequenceNumber32 (2000)), SequenceNumber32 (5000), "SACKed data not skipped");
+  NS_TEST_ASSERT_MSG_EQ (sb.SkipSacked (SequenceNumber32 (1500)), SequenceNumber32 (1500), "Data not SACKed skipped");
+  NS_TEST_ASSERT_MSG_EQ (sb.UnsackedLength (SequenceNumber32 (1500), 1000), 500, "Wrong length to the SACKed data");
+  NS_TEST_ASSERT_MSG_EQ (sb.UnsackedLength (SequenceNumber32 (5000), 1000), 1000, "Wrong length after the SACKed data");
+  NS_TEST_ASSERT_MSG_EQ (sb.UnsackedLength (SequenceNumber32 (3000), 1000), 0, "Wrong length in the SACKed data");
+
+  // A partial SACK block splits a segment
+  blocks.clear ();
+  blocks.push_back (std::make_pair (SequenceNumber32 (5000), SequenceNumber32 (5500)));
+  NS_TEST_ASSERT_MSG_EQ (sb.Sack (blocks, MilliSeconds (110)), 500, "Wrong SACKed bytes");
+  NS_TEST_ASSERT_MSG_EQ (sb.GetSackedBytes (), 3500, "Wrong SACKed total");
+
+  sb.Ack (SequenceNumber32 (5000), MilliSeconds (150));
+  NS_TEST_ASSERT_MSG_EQ (sb.GetSackedBytes (), 500, "SACKed data below the ACK kept");
+  NS_TEST_ASSERT_MSG_EQ (sb.GetPipe (), 4500, "Wrong pipe after ACK");
+
+  // A timeout deems all the data not SACKed lost
+  sb.MarkAllLost ();
+  NS_TEST_ASSERT_MSG_EQ (sb.GetPipe (), 0, "Wrong pipe after timeout");
+  NS_TEST_ASSERT_MSG_EQ (sb.GetNextLost (seq, length), true, "No loss after timeout");
+  NS_TEST_ASSERT_MSG_EQ (seq, SequenceNumber32 (5500), "Wrong loss after timeout");
+  NS_TEST_ASSERT_MSG_EQ (length, 4500, "Wrong loss length after timeout");
+
+  sb.Ack (SequenceNumber32 (10000), MilliSeconds (200));
+  NS_TEST_ASSERT_MSG_EQ (sb.GetPipe (), 0, "Data left in flight");
+  NS_TEST_ASSERT_MSG_EQ (sb.GetSackedBytes (), 0, "SACKed data left");
+}
+
+
+/**
+ * \ingroup internet-test
+ * Check the RACK loss detection of TcpScoreboard, including a lost
+ * retransmission.
+ */
+class TcpScoreboardRackTestCase : public TestCase
+{
+public:
+  TcpScoreboardRackTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TcpScoreboardRackTestCase::TcpScoreboardRackTestCase ()
+  : TestCase ("Check the scoreboard RACK loss detection")
+{
+}
+
+void
+TcpScoreboardRackTestCase::DoRun (void)
+{
+  TcpScoreboard sb;
+  sb.SetSegmentSize (1000);
+  sb.Sent (SequenceNumber32 (0), 1000, MilliSeconds (0));
+  sb.Sent (SequenceNumber32 (1000), 1000, MilliSeconds (10));
+  sb.Sent (SequenceNumber32 (2000), 1000, MilliSeconds (20));
+
+  // The second segment is delivered 50 ms after it was sent: the first is
+  // lost once sent 50 ms plus a quarter of the minimum RTT before it
+  TcpOptionSack::SackList blocks;
+  blocks.push_back (std::make_pair (SequenceNumber32 (1000), SequenceNumber32 (2000)));
+  sb.Sack (blocks, MilliSeconds (60));
+  NS_TEST_ASSERT_MSG_EQ (sb.GetMinRtt (), MilliSeconds (50), "Wrong minimum RTT");
+  Time timeout;
+  NS_TEST_ASSERT_MSG_EQ (sb.DetectLosses (MilliSeconds (60), timeout), false, "Loss detected too early");
+  NS_TEST_ASSERT_MSG_EQ (timeout, MicroSeconds (2500), "Wrong reordering timeout");
+  NS_TEST_ASSERT_MSG_EQ (sb.DetectLosses (MilliSeconds (63), timeout), true, "No loss detected");
+  NS_TEST_ASSERT_MSG_EQ (timeout, Seconds (0), "Timeout left");
+  NS_TEST_ASSERT_MSG_EQ (sb.GetPipe (), 1000, "Wrong pipe after loss");
+
+  SequenceNumber32 seq;
+  uint32_t length;
+  NS_TEST_ASSERT_MSG_EQ (sb.GetNextLost (seq, length), true, "No loss to retransmit");
+  NS_TEST_ASSERT_MSG_EQ (seq, SequenceNumber32 (0), "Wrong loss");
+  sb.Sent (seq, 1000, MilliSeconds (63));
+  sb.Sent (SequenceNumber32 (3000), 1000, MilliSeconds (64));
+
+  // Data sent after the retransmission is delivered, the retransmission is
+  // not: it is lost again
+  blocks.clear ();
+  blocks.push_back (std::make_pair (SequenceNumber32 (3000), SequenceNumber32 (4000)));
+  blocks.push_back (std::make_pair (SequenceNumber32 (1000), SequenceNumber32 (3000)));
+  sb.Sack (blocks, MilliSeconds (114));
+  NS_TEST_ASSERT_MSG_EQ (sb.DetectLosses (MilliSeconds (114), timeout), false, "Retransmission lost too early");
+  NS_TEST_ASSERT_MSG_EQ (timeout, MicroSeconds (11500), "Wrong reordering timeout");
+  NS_TEST_ASSERT_MSG_EQ (sb.DetectLosses (MilliSeconds (126), timeout), true, "Retransmission not lost");
+  NS_TEST_ASSERT_MSG_EQ (sb.GetNextLost (seq, length), true, "No loss to retransmit");
+  NS_TEST_ASSERT_MSG_EQ (seq, SequenceNumber32 (0), "Wrong loss");
+  NS_TEST_ASSERT_MSG_EQ (sb.GetPipe (), 0, "Wrong pipe");
+}
+
+
+/**
+ * \ingroup internet-test
+ * Drop chosen TCP data segments, by sequence number and transmission, and
+ * count the transmissions of every segment.
+ */
+class TcpSegmentDropModel : public ErrorModel
+{
+public:
+  /**
+   * \brief Drop a transmission of a segment
+   * \param seq the sequence number of the segment
+   * \param transmission the transmission to drop, 1 for the first
+   */
+  void Drop (uint32_t seq, uint32_t transmission)
+  {
+    m_drops.insert (std::make_pair (seq, transmission));
+  }
+  /**
+   * \param seq the sequence number of a segment
+   * \returns the number of times it reached the device
+   */
+  uint32_t GetTransmissions (uint32_t seq) const
+  {
+    std::map<uint32_t, uint32_t>::const_iterator i = m_transmissions.find (seq);
+    return i == m_transmissions.end () ? 0 : i->second;
+  }
+  /**
+   * \returns the number of data segments that reached the device
+   */
+  uint32_t GetTotal (void) const
+  {
+    uint32_t total = 0;
+    for (std::map<uint32_t, uint32_t>::const_iterator i = m_transmissions.begin ();
+         i != m_transmissions.end (); ++i)
+      {
+        total += i->second;
+      }
+    return total;
+  }
+private:
+  virtual bool DoCorrupt (Ptr<Packet> p)
+  {
+    uint8_t version;
+    if (p->GetSize () < 40 || p->CopyData (&version, 1) != 1 || (version >> 4) != 4)
+      { // Not an IPv4 packet with a TCP header, e.g. ARP
+        return false;
+      }
+    Ptr<Packet> copy = p->Copy ();
+    Ipv4Header ipHeader;
+    copy->RemoveHeader (ipHeader);
+    if (ipHeader.GetProtocol () != TcpL4Protocol::PROT_NUMBER)
+      {
+        return false;
+      }
+    TcpHeader tcpHeader;
+    copy->RemoveHeader (tcpHeader);
+    if (copy->GetSize () == 0)
+      {
+        return false;
+      }
+    uint32_t seq = tcpHeader.GetSequenceNumber ().GetValue ();
+    uint32_t transmission = ++m_transmissions[seq];
+    return m_drops.count (std::make_pair (seq, transmission)) > 0;
+  }
+  virtual void DoReset (void)
+  {
+    m_transmissions.clear ();
+  }
+  std::set<std::pair<uint32_t, uint32_t> > m_drops;  //!< Transmissions to drop
+  std::map<uint32_t, uint32_t> m_transmissions;     //!< Transmissions by sequence number
+};
+
+
+/**
+ * \ingroup internet-test
+ * Transfer data over a link that drops several segments of a window and a
+ * retransmission, with and without SACK and RACK.
+ */
+class TcpSackTransferTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param sack enable SACK on both ends
+   * \param rack enable RACK on the sender
+   */
+  TcpSackTransferTestCase (bool sack, bool rack);
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+  /**
+   * \brief Create a node with the IPv4 stack
+   * \returns the node
+   */
+  Ptr<Node> CreateInternetNode (void);
+  /**
+   * \brief Add a device on a channel, with an address
+   * \param node the node
+   * \param channel the channel
+   * \param address the IPv4 address
+   * \returns the device
+   */
+  Ptr<SimpleNetDevice> AddDevice (Ptr<Node> node, Ptr<SimpleChannel> channel, Ipv4Address address);
+  /**
+   * \brief Write the data the socket has room for
+   * \param socket the source socket
+   * \param available the room in the buffer
+   */
+  void SourceSend (Ptr<Socket> socket, uint32_t available);
+  /**
+   * \brief Read and check the data received
+   * \param socket the server socket
+   */
+  void ServerRecv (Ptr<Socket> socket);
+  /**
+   * \brief Accept a connection
+   * \param socket the new socket
+   * \param from the address of the peer
+   */
+  void ServerAccept (Ptr<Socket> socket, const Address& from);
+  /**
+   * \brief Count the retransmission timeouts from the window resets
+   * \param oldValue the former window
+   * \param newValue the new window
+   */
+  void CwndChange (uint32_t oldValue, uint32_t newValue);
+
+  bool m_sack;            //!< SACK enabled
+  bool m_rack;            //!< RACK enabled
+  uint32_t m_sent;        //!< Bytes written by the source
+  uint32_t m_received;    //!< Bytes read by the server
+  bool m_intact;          //!< The data read is the data written
+  uint32_t m_timeouts;    //!< Retransmission timeouts
+  Time m_done;            //!< Time the last byte was read
+};
+
+static const uint32_t g_segmentSize = 1000;   //!< Segment size of the transfers
+static const uint32_t g_totalBytes = 200000;  //!< Bytes of the transfers
+
+TcpSackTransferTestCase::TcpSackTransferTestCase (bool sack, bool rack)
+  : TestCase (std::string ("Check a lossy transfer with SACK ") + (sack ? "on" : "off")
+              + " and RACK " + (rack ? "on" : "off")),
+    m_sack (sack),
+    m_rack (rack)
+{
+}
+
+Ptr<Node>
+TcpSackTransferTestCase::CreateInternetNode (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  node->AggregateObject (CreateObject<ArpL3Protocol> ());
+  Ptr<Ipv4L3Protocol> ipv4 = CreateObject<Ipv4L3Protocol> ();
+  Ptr<Ipv4ListRouting> ipv4Routing = CreateObject<Ipv4ListRouting> ();
+  ipv4->SetRoutingProtocol (ipv4Routing);
+  ipv4Routing->AddRoutingProtocol (CreateObject<Ipv4StaticRouting> (), 0);
+  node->AggregateObject (ipv4);
+  node->AggregateObject (CreateObject<Icmpv4L4Protocol> ());
+  node->AggregateObject (CreateObject<UdpL4Protocol> ());
+  node->AggregateObject (CreateObject<TcpL4Protocol> ());
+  return node;
+}
+
+Ptr<SimpleNetDevice>
+TcpSackTransferTestCase::AddDevice (Ptr<Node> node, Ptr<SimpleChannel> channel, Ipv4Address address)
+{
+  Ptr<SimpleNetDevice> dev = CreateObject<SimpleNetDevice> ();
+  dev->SetAddress (Mac48Address::ConvertFrom (Mac48Address::Allocate ()));
+  node->AddDevice (dev);
+  dev->SetChannel (channel);
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  uint32_t interface = ipv4->AddInterface (dev);
+  ipv4->AddAddress (interface, Ipv4InterfaceAddress (address, Ipv4Mask ("255.255.255.0")));
+  ipv4->SetUp (interface);
+  return dev;
+}
+
+void
+TcpSackTransferTestCase::SourceSend (Ptr<Socket> socket, uint32_t available)
+{
+  while (m_sent < g_totalBytes && socket->GetTxAvailable () > 0)
+    {
+      uint32_t size = std::min (std::min (socket->GetTxAvailable (), g_totalBytes - m_sent), 1400U);
+      uint8_t data[1400];
+      for (uint32_t i = 0; i < size; i++)
+        {
+          data[i] = (m_sent + i) % 251;
+        }
+      int sent = socket->Send (data, size, 0);
+      NS_TEST_ASSERT_MSG_EQ (sent, static_cast<int> (size), "Send failed");
+      m_sent += size;
+    }
+}
+
+void
+TcpSackTransferTestCase::ServerRecv (Ptr<Socket> socket)
+{
+  Ptr<Packet> p;
+  while ((p = socket->Recv ()) && p->GetSize () > 0)
+    {
+      uint8_t data[4096];
+      while (p->GetSize () > 0)
+        {
+          uint32_t size = std::min (p->GetSize (), 4096U);
+          p->CopyData (data, size);
+          p->RemoveAtStart (size);
+          for (uint32_t i = 0; i < size; i++)
+            {
+              m_intact = m_intact && data[i] == (m_received + i) % 251;
+            }
+          m_received += size;
+        }
+    }
+  if (m_received == g_totalBytes)
+    {
+      m_done = Simulator::Now ();
+    }
+}
+
+void
+TcpSackTransferTestCase::ServerAccept (Ptr<Socket> socket, const Address& from)
+{
+  socket->SetRecvCallback (MakeCallback (&TcpSackTransferTestCase::ServerRecv, this));
+}
+
+void
+TcpSackTransferTestCase::CwndChange (uint32_t oldValue, uint32_t newValue)
+{
+  if (newValue == g_segmentSize && oldValue > g_segmentSize)
+    {
+      m_timeouts++;
+    }
+}
+
+void
+TcpSackTransferTestCase::DoRun (void)
+{
+  m_sent = 0;
+  m_received = 0;
+  m_intact = true;
+  m_timeouts = 0;
+
+  Ptr<Node> server = CreateInternetNode ();
+  Ptr<Node> source = CreateInternetNode ();
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (MilliSeconds (10)));
+  Ptr<SimpleNetDevice> serverDevice = AddDevice (server, channel, Ipv4Address ("10.1.1.1"));
+  AddDevice (source, channel, Ipv4Address ("10.1.1.2"));
+
+  // Lose three segments of a window, one of them twice. The data starts
+  // at sequence number 1.
+  Ptr<TcpSegmentDropModel> drops = CreateObject<TcpSegmentDropModel> ();
+  const uint32_t lost[] = { 40, 41, 45 };
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      drops->Drop (1 + lost[i] * g_segmentSize, 1);
+    }
+  drops->Drop (1 + 45 * g_segmentSize, 2);
+  serverDevice->SetReceiveErrorModel (drops);
+
+  Ptr<Socket> listener = server->GetObject<TcpSocketFactory> ()->CreateSocket ();
+  listener->SetAttribute ("Sack", BooleanValue (m_sack));
+  listener->Bind (InetSocketAddress (Ipv4Address::GetAny (), 50000));
+  listener->Listen ();
+  listener->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                               MakeCallback (&TcpSackTransferTestCase::ServerAccept, this));
+
+  Ptr<Socket> sender = source->GetObject<TcpSocketFactory> ()->CreateSocket ();
+  sender->SetAttribute ("Sack", BooleanValue (m_sack));
+  sender->SetAttribute ("Rack", BooleanValue (m_rack));
+  sender->SetAttribute ("SegmentSize", UintegerValue (g_segmentSize));
+  sender->TraceConnectWithoutContext ("CongestionWindow",
+                                      MakeCallback (&TcpSackTransferTestCase::CwndChange, this));
+  sender->SetSendCallback (MakeCallback (&TcpSackTransferTestCase::SourceSend, this));
+  sender->Connect (InetSocketAddress (Ipv4Address ("10.1.1.1"), 50000));
+
+  Simulator::Stop (Seconds (60));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_received, g_totalBytes, "Not all the data was received");
+  NS_TEST_ASSERT_MSG_EQ (m_intact, true, "The data received differs from the data sent");
+  if (m_sack && m_rack)
+    { // All the losses are repaired without a timeout, and the SACKed data
+      // is not sent again
+      NS_TEST_ASSERT_MSG_EQ (m_timeouts, 0, "Retransmission timeout with SACK and RACK");
+      for (uint32_t i = 0; i < 3; i++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (drops->GetTransmissions (1 + lost[i] * g_segmentSize),
+                                 (lost[i] == 45 ? 3 : 2), "Wrong retransmissions of segment " << lost[i]);
+        }
+      NS_TEST_ASSERT_MSG_EQ (drops->GetTotal (), g_totalBytes / g_segmentSize + 4, "Spurious retransmissions");
+    }
+  else if (m_sack)
+    { // Without RACK, the lost retransmission takes a timeout
+      NS_TEST_ASSERT_MSG_EQ (m_timeouts, 1, "Wrong number of timeouts with SACK only");
+    }
+}
+
+void
+TcpSackTransferTestCase::DoTeardown (void)
+{
+  Simulator::Destroy ();
+}
+
+
+/**
+ * \ingroup internet-test
+ * TCP SACK and RACK test suite.
+ */
+class TcpSackTestSuite : public TestSuite
+{
+public:
+  TcpSackTestSuite ();
+};
+
+TcpSackTestSuite::TcpSackTestSuite ()
+  : TestSuite ("tcp-sack", UNIT)
+{
+  AddTestCase (new TcpScoreboardSackTestCase, TestCase::QUICK);
+  AddTestCase (new TcpScoreboardRackTestCase, TestCase::QUICK);
+  AddTestCase (new TcpSackTransferTestCase (false, false), TestCase::QUICK);
+  AddTestCase (new TcpSackTransferTestCase (true, false), TestCase::QUICK);
+  AddTestCase (new TcpSackTransferTestCase (true, true), TestCase::QUICK);
+}
+
+static TcpSackTestSuite g_tcpSackTestSuite;
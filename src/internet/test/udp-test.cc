@@ -53,6 +53,7 @@
 #include "ns3/ipv6-address-helper.h"
 
 #include <string>
+#include <vector>
 #include <limits>
 
 using namespace ns3;
@@ -100,6 +101,128 @@ UdpSocketLoopbackTest::DoRun ()
   NS_TEST_EXPECT_MSG_EQ (m_receivedPacket->GetSize (), 246, "first socket should not receive it (it is bound specifically to the second interface's address");
 }
 
+// Static routing which counts its output lookups, and may claim not to
+// be flow-deterministic
+class CountingStaticRouting : public Ipv4StaticRouting
+{
+public:
+  CountingStaticRouting ()
+    : m_lookups (0),
+      m_flowDeterministic (true)
+  {
+  }
+  virtual Ptr<Ipv4Route> RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<NetDevice> oif, Socket::SocketErrno &sockerr)
+  {
+    m_lookups++;
+    return Ipv4StaticRouting::RouteOutput (p, header, oif, sockerr);
+  }
+  virtual bool IsFlowDeterministic (void) const
+  {
+    return m_flowDeterministic;
+  }
+  uint32_t m_lookups;
+  bool m_flowDeterministic;
+};
+
+class UdpSocketBatchTest : public TestCase
+{
+public:
+  UdpSocketBatchTest ();
+  virtual void DoRun (void);
+
+  // Check the number of route lookups of a batch
+  void CheckLookups (bool flowDeterministic, uint32_t expected);
+
+  // Send the batch of packets of the given sizes to the loopback address
+  int SendBatch (Ptr<Socket> socket, uint32_t first, uint32_t n, uint32_t size);
+};
+
+UdpSocketBatchTest::UdpSocketBatchTest ()
+  : TestCase ("UDP batch send and receive test")
+{
+}
+
+int
+UdpSocketBatchTest::SendBatch (Ptr<Socket> socket, uint32_t first, uint32_t n, uint32_t size)
+{
+  std::vector<Ptr<Packet> > packets;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      packets.push_back (Create<Packet> (i == first ? size : 100 + i));
+    }
+  return socket->SendManyTo (packets, 0, InetSocketAddress ("127.0.0.1", 80));
+}
+
+void
+UdpSocketBatchTest::DoRun ()
+{
+  Ptr<Node> rxNode = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (rxNode);
+
+  Ptr<SocketFactory> rxSocketFactory = rxNode->GetObject<UdpSocketFactory> ();
+  Ptr<Socket> rxSocket = rxSocketFactory->CreateSocket ();
+  rxSocket->Bind (InetSocketAddress (Ipv4Address::GetAny (), 80));
+
+  Ptr<Socket> txSocket = rxSocketFactory->CreateSocket ();
+  NS_TEST_EXPECT_MSG_EQ (SendBatch (txSocket, 8, 8, 0), 8, "the whole batch should be sent");
+  NS_TEST_EXPECT_MSG_EQ (SendBatch (txSocket, 2, 4, 70000), 2, "the batch should stop at the packet too large");
+  NS_TEST_EXPECT_MSG_EQ (SendBatch (txSocket, 0, 4, 70000), -1, "no packet should be sent");
+  NS_TEST_EXPECT_MSG_EQ (txSocket->GetErrno (), Socket::ERROR_MSGSIZE, "the error should be reported");
+
+  Ptr<Socket> connected = rxSocketFactory->CreateSocket ();
+  std::vector<Ptr<Packet> > packets;
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      packets.push_back (Create<Packet> (200));
+    }
+  NS_TEST_EXPECT_MSG_EQ (connected->SendMany (packets, 0), -1, "an unconnected socket should not send");
+  connected->Connect (InetSocketAddress ("127.0.0.1", 80));
+  NS_TEST_EXPECT_MSG_EQ (connected->SendMany (packets, 0), 3, "the whole batch should be sent");
+  Simulator::Run ();
+
+  std::vector<Ptr<Packet> > received;
+  NS_TEST_EXPECT_MSG_EQ (rxSocket->RecvMany (received, 5, 0), 5, "the first packets should be read");
+  NS_TEST_EXPECT_MSG_EQ (rxSocket->RecvMany (received, 100, 0), 8, "the other packets should be read");
+  NS_TEST_EXPECT_MSG_EQ (rxSocket->RecvMany (received, 100, 0), 0, "no packet should be left");
+  NS_TEST_EXPECT_MSG_EQ (rxSocket->GetRxAvailable (), 0, "no byte should be left");
+  NS_TEST_ASSERT_MSG_EQ (received.size (), 13, "the packets should be appended");
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (received[i]->GetSize (), 100 + i, "the packets should be read in order");
+    }
+  NS_TEST_EXPECT_MSG_EQ (received[8]->GetSize (), 100, "the packets should be read in order");
+  NS_TEST_EXPECT_MSG_EQ (received[9]->GetSize (), 101, "the packets should be read in order");
+  NS_TEST_EXPECT_MSG_EQ (received[10]->GetSize (), 200, "the packets should be read in order");
+  Simulator::Destroy ();
+
+  CheckLookups (true, 1);
+  CheckLookups (false, 8);
+}
+
+void
+UdpSocketBatchTest::CheckLookups (bool flowDeterministic, uint32_t expected)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (node);
+  Ptr<CountingStaticRouting> routing = CreateObject<CountingStaticRouting> ();
+  routing->m_flowDeterministic = flowDeterministic;
+  node->GetObject<Ipv4> ()->SetRoutingProtocol (routing);
+
+  Ptr<SocketFactory> socketFactory = node->GetObject<UdpSocketFactory> ();
+  Ptr<Socket> rxSocket = socketFactory->CreateSocket ();
+  rxSocket->Bind (InetSocketAddress (Ipv4Address::GetAny (), 80));
+  Ptr<Socket> txSocket = socketFactory->CreateSocket ();
+  NS_TEST_EXPECT_MSG_EQ (SendBatch (txSocket, 8, 8, 0), 8, "the whole batch should be sent");
+  NS_TEST_EXPECT_MSG_EQ (routing->m_lookups, expected, "wrong number of route lookups");
+  Simulator::Run ();
+  std::vector<Ptr<Packet> > received;
+  NS_TEST_EXPECT_MSG_EQ (rxSocket->RecvMany (received, 100, 0), 8, "the batch should be received");
+  Simulator::Destroy ();
+}
+
+
 class Udp6SocketLoopbackTest : public TestCase
 {
 public:
@@ -513,6 +636,7 @@ public:
   {
     AddTestCase (new UdpSocketImplTest, TestCase::QUICK);
     AddTestCase (new UdpSocketLoopbackTest, TestCase::QUICK);
+    AddTestCase (new UdpSocketBatchTest, TestCase::QUICK);
     AddTestCase (new Udp6SocketImplTest, TestCase::QUICK);
     AddTestCase (new Udp6SocketLoopbackTest, TestCase::QUICK);
   }
@@ -27,6 +27,7 @@
 #include "ns3/node.h"
 #include "ns3/names.h"
 #include "ns3/net-device.h"
+#include "ns3/packet.h"
 #include "ns3/pcap-file-wrapper.h"
 
 #include "trace-helper.h"
@@ -194,6 +195,13 @@ AsciiTraceHelper::CreateFileStream (std::string filename, std::ios::openmode fil
 
   Ptr<OutputStreamWrapper> StreamWrapper = Create<OutputStreamWrapper> (filename, filemode);
 
+  //
+  // Ascii traces print the packet headers, so they need the packet
+  // metadata.  Packets sent from now on record it; earlier packets
+  // are printed without their headers.
+  //
+  Packet::EnablePrinting ();
+
   //
   // Note that the ascii trace helper promptly forgets all about the trace file.
   // We rely on the reference count of the file object which will soon be owned
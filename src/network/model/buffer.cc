@@ -20,6 +20,8 @@
 #include "buffer.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#include <algorithm>
+#include <vector>
 
 #define LOG_INTERNAL_STATE(y)                                                                    \
   NS_LOG_LOGIC (y << "start="<<m_start<<", end="<<m_end<<", zero start="<<m_zeroAreaStart<<              \
@@ -28,6 +30,12 @@
 
 namespace {
 
+/**
+ * \ingroup packet
+ * \brief Size of the blocks in which virtual bytes are copied out.
+ */
+static const uint32_t ZEROES_SIZE = 1000;
+
 /**
  * \ingroup packet
  * \brief Zero-filled buffer.
@@ -35,11 +43,11 @@ namespace {
 static struct Zeroes
 {
   Zeroes ()
-    : size (1000)
+    : size (ZEROES_SIZE)
   {
     memset (buffer, 0, size);
   }
-  char buffer[1000];    //!< buffer containing zero values
+  char buffer[ZEROES_SIZE];    //!< buffer containing zero values
   const uint32_t size;  //!< buffer size
 } g_zeroes; //!< Zero-filled buffer
 
@@ -49,8 +57,162 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Buffer");
 
+/**
+ * Appending at least this number of bytes to a buffer with
+ * Buffer::AddAtEnd chains them instead of copying them.
+ */
+#define BUFFER_CHAIN_THRESHOLD 512
+
+struct Buffer::Chain
+{
+  /** The number of buffers which reference this chain. */
+  uint32_t m_count;
+  /**
+   * The slices: each one holds either only real bytes, or only
+   * virtual zero bytes.
+   */
+  std::vector<Buffer> m_slices;
+  /** The offset of the end of each slice in the chain. */
+  std::vector<uint32_t> m_ends;
+
+  /** \returns the number of bytes in the chain. */
+  uint32_t GetSize (void) const
+  {
+    return m_ends.empty () ? 0 : m_ends.back ();
+  }
+};
+
+void
+Buffer::ChainRef (struct Buffer::Chain *chain)
+{
+  chain->m_count++;
+}
+
+void
+Buffer::ChainUnref (struct Buffer::Chain *chain)
+{
+  chain->m_count--;
+  if (chain->m_count == 0)
+    {
+      delete chain;
+    }
+}
+
+void
+Buffer::ChainPush (struct Buffer::Chain *chain, const Buffer &slice)
+{
+  NS_LOG_FUNCTION (chain << &slice);
+  NS_ASSERT (slice.m_chain == 0);
+  uint32_t size = slice.GetSize ();
+  if (size == 0)
+    {
+      return;
+    }
+  bool zeroes = slice.m_zeroAreaStart != slice.m_zeroAreaEnd;
+  NS_ASSERT (!zeroes || slice.m_zeroAreaEnd - slice.m_zeroAreaStart == size);
+  if (!chain->m_slices.empty ())
+    {
+      Buffer &last = chain->m_slices.back ();
+      bool lastZeroes = last.m_zeroAreaStart != last.m_zeroAreaEnd;
+      if (zeroes && lastZeroes)
+        {
+          last.m_zeroAreaEnd += size;
+          last.m_end += size;
+          chain->m_ends.back () += size;
+          return;
+        }
+      if (!zeroes && !lastZeroes &&
+          last.m_data == slice.m_data && last.m_end == slice.m_start)
+        {
+          /* two adjacent fragments of the same buffer: merge them back. */
+          last.m_end = slice.m_end;
+          chain->m_ends.back () += size;
+          return;
+        }
+    }
+  chain->m_slices.push_back (slice);
+  chain->m_ends.push_back (chain->GetSize () + size);
+}
+
+void
+Buffer::ChainAppendRange (struct Buffer::Chain *chain, const struct Buffer::Chain *from,
+                          uint32_t offset, uint32_t size)
+{
+  NS_LOG_FUNCTION (chain << from << offset << size);
+  NS_ASSERT (offset + size <= from->GetSize ());
+  uint32_t i = std::upper_bound (from->m_ends.begin (), from->m_ends.end (), offset)
+    - from->m_ends.begin ();
+  while (size > 0)
+    {
+      uint32_t sliceStart = (i == 0) ? 0 : from->m_ends[i - 1];
+      uint32_t skip = offset - sliceStart;
+      uint32_t n = std::min (size, from->m_ends[i] - offset);
+      ChainPush (chain, from->m_slices[i].CreateFragment (skip, n));
+      offset += n;
+      size -= n;
+      i++;
+    }
+}
+
+void
+Buffer::ChainAppend (struct Buffer::Chain *chain, const Buffer &o)
+{
+  NS_LOG_FUNCTION (chain << &o);
+  uint32_t head = o.m_zeroAreaStart - o.m_start;
+  uint32_t zero = o.m_zeroAreaEnd - o.m_zeroAreaStart;
+  uint32_t tail = o.m_end - o.m_zeroAreaEnd;
+  if (head > 0)
+    {
+      ChainPush (chain, o.CreateFragment (0, head));
+    }
+  if (zero > 0)
+    {
+      if (o.m_chain == 0)
+        {
+          ChainPush (chain, Buffer (zero));
+        }
+      else
+        {
+          ChainAppendRange (chain, o.m_chain, o.m_chainOffset, zero);
+        }
+    }
+  if (tail > 0)
+    {
+      ChainPush (chain, o.CreateFragment (head + zero, tail));
+    }
+}
+
+void
+Buffer::ChainRead (const struct Buffer::Chain *chain, uint32_t offset,
+                   uint8_t *buffer, uint32_t size)
+{
+  NS_LOG_FUNCTION (chain << offset << &buffer << size);
+  NS_ASSERT (offset + size <= chain->GetSize ());
+  uint32_t i = std::upper_bound (chain->m_ends.begin (), chain->m_ends.end (), offset)
+    - chain->m_ends.begin ();
+  while (size > 0)
+    {
+      const Buffer &slice = chain->m_slices[i];
+      uint32_t sliceStart = (i == 0) ? 0 : chain->m_ends[i - 1];
+      uint32_t n = std::min (size, chain->m_ends[i] - offset);
+      if (slice.m_zeroAreaStart != slice.m_zeroAreaEnd)
+        {
+          memset (buffer, 0, n);
+        }
+      else
+        {
+          memcpy (buffer, slice.m_data->m_data + slice.m_start + (offset - sliceStart), n);
+        }
+      buffer += n;
+      offset += n;
+      size -= n;
+      i++;
+    }
+}
+
 
 uint32_t Buffer::g_recommendedStart = 0;
+static uint64_t g_allocations = 0; //!< Number of data buffers allocated
 #ifdef BUFFER_FREE_LIST
 /* The following macros are pretty evil but they are needed to allow us to
  * keep track of 3 possible states for the g_freeList variable:
@@ -170,12 +332,19 @@ Buffer::Allocate (uint32_t reqSize)
   NS_ASSERT (reqSize >= 1);
   uint32_t size = reqSize - 1 + sizeof (struct Buffer::Data);
   uint8_t *b = new uint8_t [size];
+  g_allocations++;
   struct Buffer::Data *data = reinterpret_cast<struct Buffer::Data*>(b);
   data->m_size = reqSize;
   data->m_count = 1;
   return data;
 }
 
+uint64_t
+Buffer::GetAllocations (void)
+{
+  return g_allocations;
+}
+
 void
 Buffer::Deallocate (struct Buffer::Data *data)
 {
@@ -200,6 +369,8 @@ Buffer::Buffer (uint32_t dataSize)
 Buffer::Buffer (uint32_t dataSize, bool initialize)
 {
   NS_LOG_FUNCTION (this << dataSize << initialize);
+  m_chain = 0;
+  m_chainOffset = 0;
   if (initialize == true)
     {
       Initialize (dataSize);
@@ -252,6 +423,8 @@ Buffer::Initialize (uint32_t zeroSize)
   m_end = m_zeroAreaEnd;
   m_data->m_dirtyStart = m_start;
   m_data->m_dirtyEnd = m_end;
+  m_chain = 0;
+  m_chainOffset = 0;
   NS_ASSERT (CheckInternalState ());
 }
 
@@ -270,6 +443,19 @@ Buffer::operator = (Buffer const&o)
       m_data = o.m_data;
       m_data->m_count++;
     }
+  if (m_chain != o.m_chain)
+    {
+      if (o.m_chain != 0)
+        {
+          ChainRef (o.m_chain);
+        }
+      if (m_chain != 0)
+        {
+          ChainUnref (m_chain);
+        }
+      m_chain = o.m_chain;
+    }
+  m_chainOffset = o.m_chainOffset;
   g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
   m_maxZeroAreaStart = o.m_maxZeroAreaStart;
   m_zeroAreaStart = o.m_zeroAreaStart;
@@ -290,6 +476,10 @@ Buffer::~Buffer ()
     {
       Recycle (m_data);
     }
+  if (m_chain != 0)
+    {
+      ChainUnref (m_chain);
+    }
 }
 
 uint32_t
@@ -400,7 +590,8 @@ void
 Buffer::AddAtEnd (const Buffer &o)
 {
   NS_LOG_FUNCTION (this << &o);
-  if (m_data->m_count == 1 &&
+  if (m_chain == 0 && o.m_chain == 0 &&
+      m_data->m_count == 1 &&
       m_end == m_zeroAreaEnd &&
       m_end == m_data->m_dirtyEnd &&
       o.m_start == o.m_zeroAreaStart &&
@@ -425,6 +616,11 @@ Buffer::AddAtEnd (const Buffer &o)
       NS_ASSERT (CheckInternalState ());
       return;
     }
+  if (m_end - m_zeroAreaStart + o.GetSize () >= BUFFER_CHAIN_THRESHOLD)
+    {
+      AddAtEndChained (o);
+      return;
+    }
 
   Buffer dst = CreateFullCopy ();
   Buffer src = o.CreateFullCopy ();
@@ -437,6 +633,65 @@ Buffer::AddAtEnd (const Buffer &o)
   NS_ASSERT (CheckInternalState ());
 }
 
+void
+Buffer::AddAtEndChained (const Buffer &o)
+{
+  NS_LOG_FUNCTION (this << &o);
+  NS_ASSERT (CheckInternalState ());
+  // o might be this buffer.
+  Buffer other = o;
+  if (m_chain != 0 && m_chain->m_count == 1 && m_end == m_zeroAreaEnd &&
+      m_chainOffset + (m_zeroAreaEnd - m_zeroAreaStart) == m_chain->GetSize ())
+    {
+      /* we are the only user of a chain which ends with our virtual
+       * area: extend it in place.
+       */
+      ChainAppend (m_chain, other);
+    }
+  else
+    {
+      struct Chain *chain = new Chain ();
+      chain->m_count = 1;
+      Buffer end = *this;
+      end.RemoveAtStart (m_zeroAreaStart - m_start);
+      ChainAppend (chain, end);
+      ChainAppend (chain, other);
+      if (m_chain != 0)
+        {
+          ChainUnref (m_chain);
+        }
+      m_chain = chain;
+      m_chainOffset = 0;
+    }
+  m_zeroAreaEnd = m_zeroAreaStart + m_chain->GetSize () - m_chainOffset;
+  m_end = m_zeroAreaEnd;
+  if (m_data->m_count > 1)
+    {
+      /* the chain, or the buffers we were copied from, still own the
+       * bytes of the data past our head: move the head to data of its
+       * own so that the bytes added at the end later do not overwrite
+       * them.
+       */
+      uint32_t head = m_zeroAreaStart - m_start;
+      struct Buffer::Data *newData = Buffer::Create (head);
+      memcpy (newData->m_data, m_data->m_data + m_start, head);
+      m_data->m_count--;
+      m_data = newData;
+
+      int32_t delta = -m_start;
+      m_start += delta;
+      m_zeroAreaStart += delta;
+      m_zeroAreaEnd += delta;
+      m_end += delta;
+      m_data->m_dirtyStart = m_start;
+    }
+  // update dirty area
+  m_data->m_dirtyEnd = m_end;
+  m_maxZeroAreaStart = std::max (m_maxZeroAreaStart, m_zeroAreaStart);
+  LOG_INTERNAL_STATE ("add chained=" << o.GetSize () << ", ");
+  NS_ASSERT (CheckInternalState ());
+}
+
 void 
 Buffer::RemoveAtStart (uint32_t start)
 {
@@ -457,6 +712,7 @@ Buffer::RemoveAtStart (uint32_t start)
       m_start = m_zeroAreaStart;
       m_zeroAreaEnd -= delta;
       m_end -= delta;
+      m_chainOffset += delta;
     } 
   else if (newStart <= m_end)
     {
@@ -478,6 +734,12 @@ Buffer::RemoveAtStart (uint32_t start)
       m_zeroAreaEnd = m_end;
       m_zeroAreaStart = m_end;
     }
+  if (m_chain != 0 && m_zeroAreaStart == m_zeroAreaEnd)
+    {
+      ChainUnref (m_chain);
+      m_chain = 0;
+      m_chainOffset = 0;
+    }
   m_maxZeroAreaStart = std::max (m_maxZeroAreaStart, m_zeroAreaStart);
   LOG_INTERNAL_STATE ("rem start=" << start << ", ");
   NS_ASSERT (CheckInternalState ());
@@ -513,6 +775,12 @@ Buffer::RemoveAtEnd (uint32_t end)
       m_zeroAreaEnd = m_start;
       m_zeroAreaStart = m_start;
     }
+  if (m_chain != 0 && m_zeroAreaStart == m_zeroAreaEnd)
+    {
+      ChainUnref (m_chain);
+      m_chain = 0;
+      m_chainOffset = 0;
+    }
   m_maxZeroAreaStart = std::max (m_maxZeroAreaStart, m_zeroAreaStart);
   LOG_INTERNAL_STATE ("rem end=" << end << ", ");
   NS_ASSERT (CheckInternalState ());
@@ -539,7 +807,15 @@ Buffer::CreateFullCopy (void) const
     {
       Buffer tmp;
       tmp.AddAtStart (m_zeroAreaEnd - m_zeroAreaStart);
-      tmp.Begin ().WriteU8 (0, m_zeroAreaEnd - m_zeroAreaStart);
+      if (m_chain == 0)
+        {
+          tmp.Begin ().WriteU8 (0, m_zeroAreaEnd - m_zeroAreaStart);
+        }
+      else
+        {
+          ChainRead (m_chain, m_chainOffset, tmp.m_data->m_data + tmp.m_start,
+                     m_zeroAreaEnd - m_zeroAreaStart);
+        }
       uint32_t dataStart = m_zeroAreaStart - m_start;
       tmp.AddAtStart (dataStart);
       tmp.Begin ().Write (m_data->m_data+m_start, dataStart);
@@ -559,6 +835,10 @@ uint32_t
 Buffer::GetSerializedSize (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_chain != 0)
+    {
+      return CreateFullCopy ().GetSerializedSize ();
+    }
   uint32_t dataStart = (m_zeroAreaStart - m_start + 3) & (~0x3);
   uint32_t dataEnd = (m_end - m_zeroAreaEnd + 3) & (~0x3);
 
@@ -579,6 +859,10 @@ uint32_t
 Buffer::Serialize (uint8_t* buffer, uint32_t maxSize) const
 {
   NS_LOG_FUNCTION (this << &buffer << maxSize);
+  if (m_chain != 0)
+    {
+      return CreateFullCopy ().Serialize (buffer, maxSize);
+    }
   uint32_t* p = reinterpret_cast<uint32_t *> (buffer);
   uint32_t size = 0;
 
@@ -724,10 +1008,20 @@ Buffer::CopyData (std::ostream *os, uint32_t size) const
           size -= m_zeroAreaStart-m_start;
           tmpsize = std::min (m_zeroAreaEnd - m_zeroAreaStart, size);
           uint32_t left = tmpsize;
+          char chained[ZEROES_SIZE];
           while (left > 0)
             {
               uint32_t toWrite = std::min (left, g_zeroes.size);
-              os->write (g_zeroes.buffer, toWrite);
+              if (m_chain == 0)
+                {
+                  os->write (g_zeroes.buffer, toWrite);
+                }
+              else
+                {
+                  ChainRead (m_chain, m_chainOffset + tmpsize - left,
+                             reinterpret_cast<uint8_t *> (chained), toWrite);
+                  os->write (chained, toWrite);
+                }
               left -= toWrite;
             }
           if (size > tmpsize)
@@ -754,7 +1048,12 @@ Buffer::CopyData (uint8_t *buffer, uint32_t size) const
       if (size > 0) 
         { 
           tmpsize = std::min (m_zeroAreaEnd - m_zeroAreaStart, size);
-          uint32_t left = tmpsize;
+          if (m_chain != 0)
+            {
+              ChainRead (m_chain, m_chainOffset, buffer, tmpsize);
+              buffer += tmpsize;
+            }
+          uint32_t left = (m_chain == 0) ? tmpsize : 0;
           while (left > 0)
             {
               uint32_t toWrite = std::min (left, g_zeroes.size);
@@ -854,7 +1153,16 @@ Buffer::Iterator::Write (Iterator start, Iterator end)
   if (start.m_current <= start.m_zeroEnd)
     {
       uint32_t toCopy = std::min (size, start.m_zeroEnd - start.m_current);
-      memset (&m_data[m_current], 0, toCopy);
+      if (start.m_chain == 0)
+        {
+          memset (&m_data[m_current], 0, toCopy);
+        }
+      else
+        {
+          Buffer::ChainRead (start.m_chain,
+                             start.m_chainOffset + start.m_current - start.m_zeroStart,
+                             &m_data[m_current], toCopy);
+        }
       start.m_current += toCopy;
       m_current += toCopy;
       size -= toCopy;
@@ -1123,10 +1431,47 @@ void
 Buffer::Iterator::Read (uint8_t *buffer, uint32_t size)
 {
   NS_LOG_FUNCTION (this << &buffer << size);
-  for (uint32_t i = 0; i < size; i++)
+  NS_ASSERT_MSG (m_current >= m_dataStart &&
+                 m_current + size <= m_dataEnd,
+                 GetReadErrorMessage ());
+  if (m_current < m_zeroStart)
     {
-      buffer[i] = ReadU8 ();
+      uint32_t toCopy = std::min (size, m_zeroStart - m_current);
+      memcpy (buffer, &m_data[m_current], toCopy);
+      m_current += toCopy;
+      buffer += toCopy;
+      size -= toCopy;
+    }
+  if (size > 0 && m_current < m_zeroEnd)
+    {
+      uint32_t toCopy = std::min (size, m_zeroEnd - m_current);
+      if (m_chain == 0)
+        {
+          memset (buffer, 0, toCopy);
+        }
+      else
+        {
+          Buffer::ChainRead (m_chain, m_chainOffset + m_current - m_zeroStart,
+                             buffer, toCopy);
+        }
+      m_current += toCopy;
+      buffer += toCopy;
+      size -= toCopy;
     }
+  if (size > 0)
+    {
+      memcpy (buffer, &m_data[m_current - (m_zeroEnd - m_zeroStart)], size);
+      m_current += size;
+    }
+}
+
+uint8_t
+Buffer::Iterator::PeekChain (void) const
+{
+  NS_LOG_FUNCTION (this);
+  uint8_t data;
+  Buffer::ChainRead (m_chain, m_chainOffset + m_current - m_zeroStart, &data, 1);
+  return data;
 }
 
 uint16_t
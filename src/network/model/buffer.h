@@ -88,9 +88,25 @@ namespace ns3 {
  * \endverbatim
  *
  * A simple state invariant is that m_start <= m_zeroStart <= m_zeroEnd <= m_end
+ *
+ * The virtual area does not always hold zeroes: when a large buffer is
+ * appended to another one with Buffer::AddAtEnd, the bytes which would
+ * have to be copied are instead described by a Buffer::Chain, a shared
+ * list of slices of the original buffers, and the virtual area holds
+ * the content of the chain. Concatenating and fragmenting packets thus
+ * copies no payload bytes: only the headers and trailers added around
+ * the virtual area are real bytes. As with virtual zero bytes, the
+ * chained bytes can be read but not written.
  */
 class Buffer 
 {
+  /**
+   * A shared, immutable list of buffer slices which holds the content
+   * of the virtual area of the buffers which reference it. It is
+   * defined in buffer.cc.
+   */
+  struct Chain;
+
 public:
   /**
    * \brief iterator in a Buffer instance
@@ -432,6 +448,11 @@ private:
      * \warning this is the slow version, please use ReadNtohU32 (void)
      */
     uint32_t SlowReadNtohU32 (void);
+    /**
+     * \return the byte at the current position of the virtual area,
+     * read from the chain of slices.
+     */
+    uint8_t PeekChain (void) const;
     /**
      * \brief Returns an appropriate message indicating a read error
      * \returns the error message
@@ -476,6 +497,15 @@ private:
      * to this pointer.
      */
     uint8_t *m_data;
+    /**
+     * the chain which holds the content of the virtual area, or zero
+     * if the virtual area holds zeroes.
+     */
+    const struct Buffer::Chain *m_chain;
+    /**
+     * offset in the chain of the start of the virtual area.
+     */
+    uint32_t m_chainOffset;
   };
 
   /**
@@ -605,6 +635,12 @@ private:
    */
   uint32_t CopyData (uint8_t *buffer, uint32_t size) const;
 
+  /**
+   * \returns the number of data buffers allocated from the heap
+   * since the start of the program.
+   */
+  static uint64_t GetAllocations (void);
+
   /**
    * \brief Copy constructor
    * \param o the buffer to copy
@@ -687,6 +723,60 @@ private:
    */
   Buffer CreateFullCopy (void) const;
 
+  /**
+   * \brief Append a buffer to this one without copying its bytes
+   *
+   * The virtual area and the end of this buffer, followed by the
+   * whole of o, become the content of a chain of slices.
+   *
+   * \param o the buffer to append
+   */
+  void AddAtEndChained (const Buffer &o);
+  /**
+   * \brief Append the content of a buffer to a chain
+   * \param chain the chain to append to
+   * \param o the buffer whose content is appended
+   */
+  static void ChainAppend (struct Chain *chain, const Buffer &o);
+  /**
+   * \brief Append a range of a chain to another chain
+   * \param chain the chain to append to
+   * \param from the chain to read from
+   * \param offset the start of the range in from
+   * \param size the size of the range
+   */
+  static void ChainAppendRange (struct Chain *chain, const struct Chain *from,
+                                uint32_t offset, uint32_t size);
+  /**
+   * \brief Append a slice to a chain
+   *
+   * The slice is merged with the last slice of the chain when both
+   * are adjacent parts of the same data buffer.
+   *
+   * \param chain the chain to append to
+   * \param slice a buffer without virtual area
+   */
+  static void ChainPush (struct Chain *chain, const Buffer &slice);
+  /**
+   * \brief Copy bytes out of a chain
+   * \param chain the chain to read from
+   * \param offset the offset of the first byte to read
+   * \param buffer the destination
+   * \param size the number of bytes to read
+   */
+  static void ChainRead (const struct Chain *chain, uint32_t offset,
+                         uint8_t *buffer, uint32_t size);
+  /**
+   * \brief Add a reference to a chain
+   * \param chain the chain
+   */
+  static void ChainRef (struct Chain *chain);
+  /**
+   * \brief Remove a reference to a chain, deleting it if it was the last one
+   * \param chain the chain
+   */
+  static void ChainUnref (struct Chain *chain);
+
   /**
    * \brief Transform a "Virtual byte buffer" into a "Real byte buffer"
    */
@@ -783,6 +873,15 @@ private:
    * instance from the start of m_data->m_data
    */
   uint32_t m_end;
+  /**
+   * the chain which holds the content of the virtual area, or zero
+   * if the virtual area holds zeroes.
+   */
+  struct Chain *m_chain;
+  /**
+   * offset in the chain of the start of the virtual area.
+   */
+  uint32_t m_chainOffset;
 
 #ifdef BUFFER_FREE_LIST
   /// Container for buffer data
@@ -811,7 +910,9 @@ Buffer::Iterator::Iterator ()
     m_dataStart (0),
     m_dataEnd (0),
     m_current (0),
-    m_data (0)
+    m_data (0),
+    m_chain (0),
+    m_chainOffset (0)
 {
 }
 Buffer::Iterator::Iterator (Buffer const*buffer)
@@ -833,6 +934,8 @@ Buffer::Iterator::Construct (const Buffer *buffer)
   m_dataStart = buffer->m_start;
   m_dataEnd = buffer->m_end;
   m_data = buffer->m_data->m_data;
+  m_chain = buffer->m_chain;
+  m_chainOffset = buffer->m_chainOffset;
 }
 
 void 
@@ -1002,7 +1105,11 @@ Buffer::Iterator::PeekU8 (void)
     }
   else if (m_current < m_zeroEnd)
     {
-      return 0;
+      if (m_chain == 0)
+        {
+          return 0;
+        }
+      return PeekChain ();
     }
   else
     {
@@ -1047,9 +1154,15 @@ Buffer::Buffer (Buffer const&o)
     m_zeroAreaStart (o.m_zeroAreaStart),
     m_zeroAreaEnd (o.m_zeroAreaEnd),
     m_start (o.m_start),
-    m_end (o.m_end)
+    m_end (o.m_end),
+    m_chain (o.m_chain),
+    m_chainOffset (o.m_chainOffset)
 {
   m_data->m_count++;
+  if (m_chain != 0)
+    {
+      ChainRef (m_chain);
+    }
   NS_ASSERT (CheckInternalState ());
 }
 
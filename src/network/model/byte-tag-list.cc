@@ -44,6 +44,8 @@ struct ByteTagListData {
   uint8_t data[4]; //!< data
 };
 
+static uint64_t g_allocations = 0; //!< Number of lists allocated from the heap
+
 #ifdef USE_FREE_LIST
 /**
  * \ingroup packet
@@ -358,6 +360,7 @@ ByteTagList::Allocate (uint32_t size)
       uint8_t *buffer = (uint8_t *)data;
       delete [] buffer;
     }
+  g_allocations++;
   uint8_t *buffer = new uint8_t [std::max (size, g_maxSize) + sizeof (struct ByteTagListData) - 4];
   struct ByteTagListData *data = (struct ByteTagListData *)buffer;
   data->count = 1;
@@ -397,6 +400,7 @@ struct ByteTagListData *
 ByteTagList::Allocate (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
+  g_allocations++;
   uint8_t *buffer = new uint8_t [size + sizeof (struct ByteTagListData) - 4];
   struct ByteTagListData *data = (struct ByteTagListData *)buffer;
   data->count = 1;
@@ -423,5 +427,10 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
 
 #endif /* USE_FREE_LIST */
 
+uint64_t
+ByteTagList::GetAllocations (void)
+{
+  return g_allocations;
+}
 
 } // namespace ns3
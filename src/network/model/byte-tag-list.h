@@ -225,6 +225,12 @@ private:
    */
   void AddAtStart (int32_t prependOffset);
 
+  /**
+   * \returns the number of tag lists allocated from the heap since the
+   * start of the program.
+   */
+  static uint64_t GetAllocations (void);
+
 private:
   /**
    * \brief Returns an iterator pointing to the very first tag in this list.
@@ -33,10 +33,10 @@ NS_LOG_COMPONENT_DEFINE ("PacketMetadata");
 
 bool PacketMetadata::m_enable = false;
 bool PacketMetadata::m_enableChecking = false;
-bool PacketMetadata::m_metadataSkipped = false;
 uint32_t PacketMetadata::m_maxSize = 0;
 uint16_t PacketMetadata::m_chunkUid = 0;
 PacketMetadata::DataFreeList PacketMetadata::m_freeList;
+static uint64_t g_allocations = 0; //!< Number of data buffers allocated
 
 PacketMetadata::DataFreeList::~DataFreeList ()
 {
@@ -52,13 +52,6 @@ void
 PacketMetadata::Enable (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  NS_ASSERT_MSG (!m_metadataSkipped,
-                 "Error: attempting to enable the packet metadata "
-                 "subsystem too late in the simulation, which is not allowed.\n"
-                 "A common cause for this problem is to enable ASCII tracing "
-                 "after sending any packets.  One way to fix this problem is "
-                 "to call ns3::PacketMetadata::Enable () near the beginning of"
-                 " the program, before any packets are sent.");
   m_enable = true;
 }
 
@@ -626,12 +619,19 @@ PacketMetadata::Allocate (uint32_t n)
     }
   size += n - PACKET_METADATA_DATA_M_DATA_SIZE;
   uint8_t *buf = new uint8_t [size];
+  g_allocations++;
   struct PacketMetadata::Data *data = (struct PacketMetadata::Data *)buf;
   data->m_size = n;
   data->m_count = 1;
   data->m_dirtyEnd = 0;
   return data;
 }
+uint64_t
+PacketMetadata::GetAllocations (void)
+{
+  return g_allocations;
+}
+
 void 
 PacketMetadata::Deallocate (struct PacketMetadata::Data *data)
 {
@@ -651,24 +651,11 @@ PacketMetadata::CreateFragment (uint32_t start, uint32_t end) const
   return fragment;
 }
 
-void 
-PacketMetadata::AddHeader (const Header &header, uint32_t size)
-{
-  NS_LOG_FUNCTION (this << &header << size);
-  NS_ASSERT (IsStateOk ());
-  uint32_t uid = header.GetInstanceTypeId ().GetUid () << 1;
-  DoAddHeader (uid, size);
-  NS_ASSERT (IsStateOk ());
-}
 void
 PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size)
 {
   NS_LOG_FUNCTION (this << uid << size);
-  if (!m_enable)
-    {
-      m_metadataSkipped = true;
-      return;
-    }
+  NS_ASSERT (IsStateOk ());
 
   struct PacketMetadata::SmallItem item;
   item.next = m_head;
@@ -679,18 +666,13 @@ PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size)
   m_chunkUid++;
   uint16_t written = AddSmall (&item);
   UpdateHead (written);
+  NS_ASSERT (IsStateOk ());
 }
 void 
-PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
+PacketMetadata::DoRemoveHeader (uint32_t uid, uint32_t size)
 {
-  uint32_t uid = header.GetInstanceTypeId ().GetUid () << 1;
-  NS_LOG_FUNCTION (this << &header << size);
+  NS_LOG_FUNCTION (this << uid << size);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
-    {
-      m_metadataSkipped = true;
-      return;
-    }
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_head, &item, &extraItem);
@@ -729,16 +711,10 @@ PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
   NS_ASSERT (IsStateOk ());
 }
 void 
-PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
+PacketMetadata::DoAddTrailer (uint32_t uid, uint32_t size)
 {
-  uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
-  NS_LOG_FUNCTION (this << &trailer << size);
+  NS_LOG_FUNCTION (this << uid << size);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable)
-    {
-      m_metadataSkipped = true;
-      return;
-    }
   struct PacketMetadata::SmallItem item;
   item.next = 0xffff;
   item.prev = m_tail;
@@ -751,16 +727,10 @@ PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
   NS_ASSERT (IsStateOk ());
 }
 void 
-PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
+PacketMetadata::DoRemoveTrailer (uint32_t uid, uint32_t size)
 {
-  uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
-  NS_LOG_FUNCTION (this << &trailer << size);
+  NS_LOG_FUNCTION (this << uid << size);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
-    {
-      m_metadataSkipped = true;
-      return;
-    }
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_tail, &item, &extraItem);
@@ -799,13 +769,15 @@ PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
   NS_ASSERT (IsStateOk ());
 }
 void
-PacketMetadata::AddAtEnd (PacketMetadata const&o)
+PacketMetadata::DoAddAtEnd (PacketMetadata const&o)
 {
   NS_LOG_FUNCTION (this << &o);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
+  if (o.m_data == 0)
     {
-      m_metadataSkipped = true;
+      // The appended bytes were created before the metadata was
+      // enabled: we can't describe them.
+      Discard ();
       return;
     }
   if (m_tail == 0xffff)
@@ -877,25 +849,25 @@ PacketMetadata::AddAtEnd (PacketMetadata const&o)
   NS_ASSERT (IsStateOk ());
 }
 void
-PacketMetadata::AddPaddingAtEnd (uint32_t end)
+PacketMetadata::Discard (void)
 {
-  NS_LOG_FUNCTION (this << end);
-  if (!m_enable)
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_data != 0);
+  m_data->m_count--;
+  if (m_data->m_count == 0)
     {
-      m_metadataSkipped = true;
-      return;
+      PacketMetadata::Recycle (m_data);
     }
+  m_data = 0;
+  m_head = 0xffff;
+  m_tail = 0xffff;
+  m_used = 0;
 }
 void 
-PacketMetadata::RemoveAtStart (uint32_t start)
+PacketMetadata::DoRemoveAtStart (uint32_t start)
 {
   NS_LOG_FUNCTION (this << start);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
-    {
-      m_metadataSkipped = true;
-      return;
-    }
   NS_ASSERT (m_data != 0);
   uint32_t leftToRemove = start;
   uint16_t current = m_head;
@@ -950,15 +922,10 @@ PacketMetadata::RemoveAtStart (uint32_t start)
   NS_ASSERT (IsStateOk ());
 }
 void 
-PacketMetadata::RemoveAtEnd (uint32_t end)
+PacketMetadata::DoRemoveAtEnd (uint32_t end)
 {
   NS_LOG_FUNCTION (this << end);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
-    {
-      m_metadataSkipped = true;
-      return;
-    }
   NS_ASSERT (m_data != 0);
 
   uint32_t leftToRemove = end;
@@ -1146,7 +1113,7 @@ PacketMetadata::GetSerializedSize (void) const
   // if packet-metadata not enabled, total size
   // is simply 4-bytes for itself plus 8-bytes 
   // for packet uid
-  if (!m_enable)
+  if (m_data == 0)
     {
       return totalSize;
     }
@@ -1289,6 +1256,11 @@ PacketMetadata::Deserialize (const uint8_t* buffer, uint32_t size)
 
   buffer = ReadFromRawU64 (m_packetUid, start, buffer, size);
   desSize -= 8;
+  if (m_data == 0)
+    {
+      // metadata disabled here: keep only the uid.
+      return 1;
+    }
 
   struct PacketMetadata::SmallItem item = {0};
   struct PacketMetadata::ExtraItem extraItem = {0};
@@ -27,13 +27,13 @@
 #include "ns3/assert.h"
 #include "ns3/type-id.h"
 #include "buffer.h"
+#include "header.h"
+#include "trailer.h"
 
 namespace ns3 {
 
 class Chunk;
 class Buffer;
-class Header;
-class Trailer;
 
 /**
  * \ingroup packet
@@ -74,6 +74,13 @@ class Trailer;
  * integers, and some others as variable-size 32-bit integers.
  * The variable-size 32 bit integers are stored using the uleb128
  * encoding.
+ *
+ * Packets created while the metadata is disabled only record their
+ * uid: they own no data buffer (#m_data is null), and the methods which
+ * maintain the item list return before doing any work.  The metadata
+ * can be enabled at any time, typically by the first consumer of
+ * packet printing such as an ascii trace; packets created earlier keep
+ * no metadata, and packets made of them lose theirs.
  */
 class PacketMetadata 
 {
@@ -153,12 +160,19 @@ private:
 
   /**
    * \brief Enable the packet metadata
+   *
+   * Packets created from now on record their headers and trailers.
    */
   static void Enable (void);
   /**
    * \brief Enable the packet metadata checking
    */
   static void EnableChecking (void);
+  /**
+   * \returns the number of metadata buffers allocated from the heap
+   * since the start of the program.
+   */
+  static uint64_t GetAllocations (void);
 
   /**
    * \brief Constructor
@@ -184,26 +198,26 @@ private:
    * \param header header to add
    * \param size header serialized size
    */
-  void AddHeader (Header const &header, uint32_t size);
+  inline void AddHeader (Header const &header, uint32_t size);
   /**
    * \brief Remove an header
    * \param header header to remove
    * \param size header serialized size
    */
-  void RemoveHeader (Header const &header, uint32_t size);
+  inline void RemoveHeader (Header const &header, uint32_t size);
 
   /**
    * Add a trailer
    * \param trailer trailer to add
    * \param size trailer serialized size
    */
-  void AddTrailer (Trailer const &trailer, uint32_t size);
+  inline void AddTrailer (Trailer const &trailer, uint32_t size);
   /**
    * Remove a trailer
    * \param trailer trailer to remove
    * \param size trailer serialized size
    */
-  void RemoveTrailer (Trailer const &trailer, uint32_t size);
+  inline void RemoveTrailer (Trailer const &trailer, uint32_t size);
 
   /**
    * \brief Creates a fragment.
@@ -221,22 +235,22 @@ private:
    * \brief Add a metadata at the metadata start
    * \param o the metadata to add
    */
-  void AddAtEnd (PacketMetadata const&o);
+  inline void AddAtEnd (PacketMetadata const&o);
   /**
    * \brief Add some padding at the end
    * \param end size of padding
    */
-  void AddPaddingAtEnd (uint32_t end);
+  inline void AddPaddingAtEnd (uint32_t end);
   /**
    * \brief Remove a chunk of metadata at the metadata start
    * \param start the size of metadata to remove
    */
-  void RemoveAtStart (uint32_t start);
+  inline void RemoveAtStart (uint32_t start);
   /**
    * \brief Remove a chunk of metadata at the metadata end
    * \param end the size of metadata to remove
    */
-  void RemoveAtEnd (uint32_t end);
+  inline void RemoveAtEnd (uint32_t end);
 
   /**
    * \brief Get the packet Uid
@@ -615,6 +629,43 @@ public:
    * \param size header serialized size
    */
   void DoAddHeader (uint32_t uid, uint32_t size);
+  /**
+   * \brief Remove an header
+   * \param uid header's uid to remove
+   * \param size header serialized size
+   */
+  void DoRemoveHeader (uint32_t uid, uint32_t size);
+  /**
+   * \brief Add a trailer
+   * \param uid trailer's uid to add
+   * \param size trailer serialized size
+   */
+  void DoAddTrailer (uint32_t uid, uint32_t size);
+  /**
+   * \brief Remove a trailer
+   * \param uid trailer's uid to remove
+   * \param size trailer serialized size
+   */
+  void DoRemoveTrailer (uint32_t uid, uint32_t size);
+  /**
+   * \brief Add a metadata at the metadata start
+   * \param o the metadata to add
+   */
+  void DoAddAtEnd (PacketMetadata const&o);
+  /**
+   * \brief Remove a chunk of metadata at the metadata start
+   * \param start the size of metadata to remove
+   */
+  void DoRemoveAtStart (uint32_t start);
+  /**
+   * \brief Remove a chunk of metadata at the metadata end
+   * \param end the size of metadata to remove
+   */
+  void DoRemoveAtEnd (uint32_t end);
+  /**
+   * \brief Forget the metadata, keeping only the packet uid
+   */
+  void Discard (void);
   /**
    * \brief Check if the metadata state is ok
    * \returns true if the internal state is ok
@@ -660,17 +711,10 @@ public:
   static bool m_enable; //!< Enable the packet metadata
   static bool m_enableChecking; //!< Enable the packet metadata checking
 
-  /**
-   * Set to true when adding metadata to a packet is skipped because
-   * m_enable is false; used to detect enabling of metadata in the
-   * middle of a simulation, which isn't allowed.
-   */
-  static bool m_metadataSkipped;
-
   static uint32_t m_maxSize; //!< maximum metadata size
   static uint16_t m_chunkUid; //!< Chunk Uid
 
-  struct Data *m_data; //!< Metadata storage
+  struct Data *m_data; //!< Metadata storage, or 0 if the metadata is disabled
   /*
      head -(next)-> tail
        ^             |
@@ -687,12 +731,17 @@ public:
 namespace ns3 {
 
 PacketMetadata::PacketMetadata (uint64_t uid, uint32_t size)
-  : m_data (PacketMetadata::Create (10)),
+  : m_data (0),
     m_head (0xffff),
     m_tail (0xffff),
     m_used (0),
     m_packetUid (uid)
 {
+  if (!m_enable)
+    {
+      return;
+    }
+  m_data = PacketMetadata::Create (10);
   memset (m_data->m_data, 0xff, 4);
   if (size > 0)
     {
@@ -706,9 +755,11 @@ PacketMetadata::PacketMetadata (PacketMetadata const &o)
     m_used (o.m_used),
     m_packetUid (o.m_packetUid)
 {
-  NS_ASSERT (m_data != 0);
-  NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
-  m_data->m_count++;
+  if (m_data != 0)
+    {
+      NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
+      m_data->m_count++;
+    }
 }
 PacketMetadata &
 PacketMetadata::operator = (PacketMetadata const& o)
@@ -716,15 +767,19 @@ PacketMetadata::operator = (PacketMetadata const& o)
   if (m_data != o.m_data) 
     {
       // not self assignment
-      NS_ASSERT (m_data != 0);
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      if (m_data != 0)
         {
-          PacketMetadata::Recycle (m_data);
+          m_data->m_count--;
+          if (m_data->m_count == 0) 
+            {
+              PacketMetadata::Recycle (m_data);
+            }
         }
       m_data = o.m_data;
-      NS_ASSERT (m_data != 0);
-      m_data->m_count++;
+      if (m_data != 0)
+        {
+          m_data->m_count++;
+        }
     }
   m_head = o.m_head;
   m_tail = o.m_tail;
@@ -734,11 +789,75 @@ PacketMetadata::operator = (PacketMetadata const& o)
 }
 PacketMetadata::~PacketMetadata ()
 {
-  NS_ASSERT (m_data != 0);
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
+  if (m_data != 0)
+    {
+      m_data->m_count--;
+      if (m_data->m_count == 0) 
+        {
+          PacketMetadata::Recycle (m_data);
+        }
+    }
+}
+
+void
+PacketMetadata::AddHeader (Header const &header, uint32_t size)
+{
+  if (m_data != 0)
+    {
+      DoAddHeader (header.GetInstanceTypeId ().GetUid () << 1, size);
+    }
+}
+void
+PacketMetadata::RemoveHeader (Header const &header, uint32_t size)
+{
+  if (m_data != 0)
+    {
+      DoRemoveHeader (header.GetInstanceTypeId ().GetUid () << 1, size);
+    }
+}
+void
+PacketMetadata::AddTrailer (Trailer const &trailer, uint32_t size)
+{
+  if (m_data != 0)
+    {
+      DoAddTrailer (trailer.GetInstanceTypeId ().GetUid () << 1, size);
+    }
+}
+void
+PacketMetadata::RemoveTrailer (Trailer const &trailer, uint32_t size)
+{
+  if (m_data != 0)
+    {
+      DoRemoveTrailer (trailer.GetInstanceTypeId ().GetUid () << 1, size);
+    }
+}
+void
+PacketMetadata::AddAtEnd (PacketMetadata const&o)
+{
+  if (m_data != 0)
+    {
+      DoAddAtEnd (o);
+    }
+}
+void
+PacketMetadata::AddPaddingAtEnd (uint32_t end)
+{
+  // padding is not recorded in the metadata.
+}
+void
+PacketMetadata::RemoveAtStart (uint32_t start)
+{
+  if (m_data != 0)
+    {
+      DoRemoveAtStart (start);
+    }
+}
+void
+PacketMetadata::RemoveAtEnd (uint32_t end)
+{
+  if (m_data != 0)
     {
-      PacketMetadata::Recycle (m_data);
+      DoRemoveAtEnd (end);
     }
 }
 
@@ -20,7 +20,7 @@
 
 /**
 \file   packet-tag-list.cc
-\brief  Implements a linked list of Packet tags, including copy-on-write semantics.
+\brief  Implements a list of Packet tags, including copy-on-write semantics.
 */
 
 #include "packet-tag-list.h"
@@ -28,216 +28,195 @@
 #include "tag.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include <algorithm>
 #include <cstring>
+#include <vector>
+
+#define INLINE_CAPACITY 4
+#define POOL_CLASSES 4
+#define FREE_LIST_SIZE 1000
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("PacketTagList");
 
-bool
-PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
+/**
+ * \ingroup packet
+ *
+ * \brief Pool of free PacketTagList blocks, one free list per capacity.
+ *
+ * Block capacities are INLINE_CAPACITY times a power of two; the
+ * POOL_CLASSES smallest capacities are pooled.  Internal use only.
+ */
+static class PacketTagListFreeList
 {
-  TypeId tid = tag.GetInstanceTypeId ();
-  NS_LOG_FUNCTION (this << tid);
-  NS_LOG_INFO     ("looking for " << tid);
-
-  // trivial case when list is empty
-  if (m_next == 0)
-    {
-      return false;
-    }
-
-  bool found = false;
+public:
+  ~PacketTagListFreeList ();
+  /** Free blocks, by capacity class. */
+  std::vector<uint8_t *> m_blocks[POOL_CLASSES];
+} g_freeList; //!< Pool of free blocks
 
-  struct TagData ** prevNext = &m_next; // previous node's next pointer
-  struct TagData  * cur      =  m_next; // cursor to current node
-  struct TagData  * it = 0;             // utility
+static uint64_t g_allocations = 0; //!< Number of blocks allocated from the heap
 
-  // Search from the head of the list until we find tid or a merge
-  while (cur != 0)
+PacketTagListFreeList::~PacketTagListFreeList ()
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t c = 0; c < POOL_CLASSES; ++c)
     {
-      if (cur->count > 1)
+      for (std::vector<uint8_t *>::iterator i = m_blocks[c].begin ();
+           i != m_blocks[c].end (); ++i)
         {
-          // found merge
-          NS_LOG_INFO ("found initial merge before tid");
-          break;
+          delete [] *i;
         }
-      else if (cur->tid == tid)
-        {
-          NS_LOG_INFO ("found tid before initial merge, calling writer");
-          found = (this->*Writer)(tag, true, cur, prevNext);
-          break;
-        }
-      else
-        {
-          // no merge or tid found yet, move on
-          prevNext = &cur->next;
-          cur      =  cur->next;
-        }
-    }  // while !found && !cow
+    }
+}
 
-  // did we find it or run out of tags?
-  if (cur == 0 || found)
+/**
+ * \param [in] capacity A block capacity.
+ * \returns the pool class of blocks of this capacity, or POOL_CLASSES
+ *          if such blocks are not pooled.
+ */
+static uint32_t
+CapacityClass (uint32_t capacity)
+{
+  uint32_t c = 0;
+  while (c < POOL_CLASSES && (uint32_t (INLINE_CAPACITY) << c) != capacity)
     {
-      NS_LOG_INFO ("returning after header with found: " << found);
-      return found;
+      ++c;
     }
+  return c;
+}
 
-  // From here on out, we have to copy the list
-  // until we find tid, then link past it
-
-  // Before we do all that work, let's make sure tid really exists
-  for (it = cur; it != 0; it = it->next)
+struct PacketTagList::TagBlock *
+PacketTagList::Allocate (uint32_t capacity)
+{
+  NS_LOG_FUNCTION (capacity);
+  uint32_t c = CapacityClass (capacity);
+  uint8_t *buffer;
+  if (c < POOL_CLASSES && !g_freeList.m_blocks[c].empty ())
     {
-      if (it->tid == tid)
-        {
-          break;
-        }
+      buffer = g_freeList.m_blocks[c].back ();
+      g_freeList.m_blocks[c].pop_back ();
     }
-  if (it == 0)
+  else
     {
-      // got to end of list without finding tid
-      NS_LOG_INFO ("tid not found after first merge");
-      return found;
+      buffer = new uint8_t [sizeof (struct TagBlock)
+                            + (capacity - 1) * sizeof (struct TagData)];
+      g_allocations++;
     }
+  struct TagBlock *block = (struct TagBlock *)buffer;
+  block->count = 1;
+  block->size = 0;
+  block->capacity = capacity;
+  return block;
+}
 
-  // At this point cur is a merge, but untested for tid
-  NS_ASSERT (cur != 0);
-  NS_ASSERT (cur->count > 1);
-
-  /*
-     Walk the remainder of the list, copying, until we find tid
-     As we put a copy of the cur node onto our list,
-     we move the merge point down the list.
-
-     Starting position                  End position
-       T1 is a merge                     T1.count decremented
-                                         T2 is a merge
-                                         T1' is a copy of T1
-
-          other                             other
-               \                                 \
-      Prev  ->  T1  ->  T2  -> ...                T1  ->  T2  -> ...
-           /   /                                         /|
-      pNext cur                         Prev  ->  T1' --/ |
-                                                     /    |
-                                                pNext   cur
-
-     When we reach tid, we link past it, decrement count, and we're done.
-  */
+uint64_t
+PacketTagList::GetAllocations (void)
+{
+  return g_allocations;
+}
 
-  // Should normally check for null cur pointer,
-  // but since we know tid exists, we'll skip this test
-  while ( /* cur && */ cur->tid != tid)
+void
+PacketTagList::Deallocate (struct TagBlock *block)
+{
+  NS_LOG_FUNCTION (block);
+  uint32_t c = CapacityClass (block->capacity);
+  uint8_t *buffer = (uint8_t *)block;
+  if (c < POOL_CLASSES && g_freeList.m_blocks[c].size () < FREE_LIST_SIZE)
     {
-      NS_ASSERT (cur != 0);
-      NS_ASSERT (cur->count > 1);
-      cur->count--;                       // unmerge cur
-      struct TagData * copy = new struct TagData ();
-      copy->tid = cur->tid;
-      copy->count = 1;
-      memcpy (copy->data, cur->data, TagData::MAX_SIZE);
-      copy->next = cur->next;             // merge into tail
-      copy->next->count++;                // mark new merge
-      *prevNext = copy;                   // point prior list at copy
-      prevNext = &copy->next;             // advance
-      cur      =  copy->next;
+      g_freeList.m_blocks[c].push_back (buffer);
+    }
+  else
+    {
+      delete [] buffer;
     }
-  // Sanity check:
-  NS_ASSERT (cur != 0);                 // cur should be non-zero
-  NS_ASSERT (cur->tid == tid);          // cur->tid should be tid
-  NS_ASSERT (cur->count > 1);           // cur should be a merge
-
-  // link around tid, removing it from our list
-  found = (this->*Writer)(tag, false, cur, prevNext);
-  return found;
-
 }
 
-bool
-PacketTagList::Remove (Tag & tag)
+struct PacketTagList::TagBlock *
+PacketTagList::Writable (uint32_t size)
 {
-  return COWTraverse (tag, &PacketTagList::RemoveWriter);
+  NS_LOG_FUNCTION (this << size);
+  if (m_block != 0 && m_block->count == 1 && m_block->capacity >= size)
+    {
+      return m_block;
+    }
+  // A copy keeps the capacity of the block it copies, so that a list
+  // which has grown does not grow again after each copy-on-write
+  uint32_t capacity = m_block != 0 ? m_block->capacity : INLINE_CAPACITY;
+  while (capacity < size)
+    {
+      capacity <<= 1;
+    }
+  struct TagBlock *block = Allocate (capacity);
+  if (m_block != 0)
+    {
+      NS_LOG_INFO ("copying " << m_block->size << " tags");
+      std::copy (m_block->tags, m_block->tags + m_block->size, block->tags);
+      block->size = m_block->size;
+      RemoveAll ();
+    }
+  m_block = block;
+  return block;
 }
 
-// COWWriter implementing Remove
-bool
-PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
-                             struct PacketTagList::TagData  * cur,
-                             struct PacketTagList::TagData ** prevNext)
+int32_t
+PacketTagList::Find (TypeId tid) const
 {
-  NS_LOG_FUNCTION_NOARGS ();
-
-  // found tid
-  bool found = true;
-  tag.Deserialize (TagBuffer (cur->data,
-                              cur->data + TagData::MAX_SIZE));
-  *prevNext = cur->next;            // link around cur
-
-  if (preMerge)
+  if (m_block == 0)
     {
-      // found tid before first merge, so delete cur
-      delete cur;
+      return -1;
     }
-  else
+  for (int32_t i = m_block->size - 1; i >= 0; --i)
     {
-      // cur is always a merge at this point
-      // unmerge cur, since we linked around it already
-      cur->count--;
-      if (cur->next != 0)
+      if (m_block->tags[i].tid == tid)
         {
-          // there's a next, so make it a merge
-          cur->next->count++;
+          return i;
         }
     }
-  return found;
+  return -1;
 }
 
 bool
-PacketTagList::Replace (Tag & tag)
+PacketTagList::Remove (Tag & tag)
 {
-  bool found = COWTraverse (tag, &PacketTagList::ReplaceWriter);
-  if (!found)
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
+  int32_t i = Find (tid);
+  if (i < 0)
     {
-      Add (tag);
+      return false;
+    }
+  tag.Deserialize (TagBuffer (m_block->tags[i].data,
+                              m_block->tags[i].data + TagData::MAX_SIZE));
+  if (m_block->size == 1)
+    {
+      RemoveAll ();
+      return true;
     }
-  return found;
+  struct TagBlock *block = Writable (m_block->size);
+  std::copy (block->tags + i + 1, block->tags + block->size, block->tags + i);
+  block->size--;
+  return true;
 }
 
-// COWWriter implementing Replace
 bool
-PacketTagList::ReplaceWriter (Tag & tag, bool preMerge,
-                              struct PacketTagList::TagData  * cur,
-                              struct PacketTagList::TagData ** prevNext)
+PacketTagList::Replace (Tag & tag)
 {
-  NS_LOG_FUNCTION_NOARGS ();
-
-  // found tid
-  bool found = true;
-  if (preMerge)
-    {
-      // found tid before first merge, so just rewrite
-      tag.Serialize (TagBuffer (cur->data,
-                                cur->data + tag.GetSerializedSize ()));
-    }
-  else
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
+  int32_t i = Find (tid);
+  if (i < 0)
     {
-      // cur is always a merge at this point
-      // need to copy, replace, and link past cur
-      cur->count--;                     // unmerge cur
-      struct TagData * copy = new struct TagData ();
-      copy->tid = tag.GetInstanceTypeId ();
-      copy->count = 1;
-      tag.Serialize (TagBuffer (copy->data,
-                                copy->data + tag.GetSerializedSize ()));
-      copy->next = cur->next;           // merge into tail
-      if (copy->next != 0)
-        {
-          copy->next->count++;          // mark new merge
-        }
-      *prevNext = copy;                 // point prior list at copy
+      Add (tag);
+      return false;
     }
-  return found;
+  struct TagBlock *block = Writable (m_block->size);
+  struct TagData *cur = &block->tags[i];
+  NS_ASSERT (tag.GetSerializedSize () <= TagData::MAX_SIZE);
+  std::memset (cur->data, 0, TagData::MAX_SIZE);
+  tag.Serialize (TagBuffer (cur->data, cur->data + tag.GetSerializedSize ()));
+  return true;
 }
 
 void 
@@ -245,44 +224,30 @@ PacketTagList::Add (const Tag &tag) const
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   // ensure this id was not yet added
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
-    {
-      NS_ASSERT (cur->tid != tag.GetInstanceTypeId ());
-    }
-  struct TagData * head = new struct TagData ();
-  head->count = 1;
-  head->next = 0;
-  head->tid = tag.GetInstanceTypeId ();
-  head->next = m_next;
+  NS_ASSERT (Find (tag.GetInstanceTypeId ()) < 0);
+  PacketTagList *self = const_cast<PacketTagList *> (this);
+  struct TagBlock *block = self->Writable ((m_block != 0 ? m_block->size : 0) + 1);
+  struct TagData *cur = &block->tags[block->size];
+  cur->tid = tag.GetInstanceTypeId ();
   NS_ASSERT (tag.GetSerializedSize () <= TagData::MAX_SIZE);
-  tag.Serialize (TagBuffer (head->data, head->data + tag.GetSerializedSize ()));
-
-  const_cast<PacketTagList *> (this)->m_next = head;
+  std::memset (cur->data, 0, TagData::MAX_SIZE);
+  tag.Serialize (TagBuffer (cur->data, cur->data + tag.GetSerializedSize ()));
+  block->size++;
 }
 
 bool
 PacketTagList::Peek (Tag &tag) const
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
-  TypeId tid = tag.GetInstanceTypeId ();
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
+  int32_t i = Find (tag.GetInstanceTypeId ());
+  if (i < 0)
     {
-      if (cur->tid == tid) 
-        {
-          /* found tag */
-          tag.Deserialize (TagBuffer (cur->data, cur->data + TagData::MAX_SIZE));
-          return true;
-        }
+      /* no tag found */
+      return false;
     }
-  /* no tag found */
-  return false;
-}
-
-const struct PacketTagList::TagData *
-PacketTagList::Head (void) const
-{
-  return m_next;
+  tag.Deserialize (TagBuffer (m_block->tags[i].data,
+                              m_block->tags[i].data + TagData::MAX_SIZE));
+  return true;
 }
 
 } /* namespace ns3 */
-
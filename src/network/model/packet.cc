@@ -23,12 +23,102 @@
 #include "ns3/simulator.h"
 #include <string>
 #include <cstdarg>
+#include <vector>
+
+/** Maximum number of packets kept in the packet pool. */
+#define PACKET_FREE_LIST_SIZE 4096
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Packet");
 
 uint32_t Packet::m_globalUid = 0;
+uint64_t Packet::m_packets = 0;
+uint64_t Packet::m_packetAllocs = 0;
+PacketAllocationStats Packet::m_statsBase;
+
+/**
+ * \ingroup packet
+ *
+ * \brief Pool of the memory of destroyed packets.
+ *
+ * Internal use only.
+ */
+static class PacketFreeList
+{
+public:
+  ~PacketFreeList ();
+  /** The free packets. */
+  std::vector<void *> m_packets;
+  /**
+   * Set when the pool is destroyed, so that packets which outlive it
+   * go back to the heap. Being static, it is false before the
+   * constructor runs.
+   */
+  bool m_destroyed;
+} g_packetFreeList; //!< Pool of free packets
+
+PacketFreeList::~PacketFreeList ()
+{
+  for (std::vector<void *>::iterator i = m_packets.begin ();
+       i != m_packets.end (); ++i)
+    {
+      ::operator delete (*i);
+    }
+  m_packets.clear ();
+  m_destroyed = true;
+}
+
+void *
+Packet::operator new (size_t size)
+{
+  NS_ASSERT (size == sizeof (Packet));
+  m_packets++;
+  if (!g_packetFreeList.m_packets.empty ())
+    {
+      void *p = g_packetFreeList.m_packets.back ();
+      g_packetFreeList.m_packets.pop_back ();
+      return p;
+    }
+  m_packetAllocs++;
+  return ::operator new (size);
+}
+
+void
+Packet::operator delete (void *p)
+{
+  if (g_packetFreeList.m_destroyed ||
+      g_packetFreeList.m_packets.size () >= PACKET_FREE_LIST_SIZE)
+    {
+      ::operator delete (p);
+      return;
+    }
+  g_packetFreeList.m_packets.push_back (p);
+}
+
+PacketAllocationStats
+Packet::GetAllocationStats (void)
+{
+  PacketAllocationStats stats;
+  stats.packets = m_packets - m_statsBase.packets;
+  stats.packetAllocs = m_packetAllocs - m_statsBase.packetAllocs;
+  stats.bufferAllocs = Buffer::GetAllocations () - m_statsBase.bufferAllocs;
+  stats.byteTagAllocs = ByteTagList::GetAllocations () - m_statsBase.byteTagAllocs;
+  stats.packetTagAllocs = PacketTagList::GetAllocations () - m_statsBase.packetTagAllocs;
+  stats.metadataAllocs = PacketMetadata::GetAllocations () - m_statsBase.metadataAllocs;
+  return stats;
+}
+
+void
+Packet::ResetAllocationStats (void)
+{
+  m_statsBase.packets = m_packets;
+  m_statsBase.packetAllocs = m_packetAllocs;
+  m_statsBase.bufferAllocs = Buffer::GetAllocations ();
+  m_statsBase.byteTagAllocs = ByteTagList::GetAllocations ();
+  m_statsBase.packetTagAllocs = PacketTagList::GetAllocations ();
+  m_statsBase.metadataAllocs = PacketMetadata::GetAllocations ();
+}
 
 TypeId 
 ByteTagIterator::Item::GetTypeId (void) const
@@ -81,22 +171,23 @@ ByteTagIterator::ByteTagIterator (ByteTagList::Iterator i)
 }
 
 
-PacketTagIterator::PacketTagIterator (const struct PacketTagList::TagData *head)
-  : m_current (head)
+PacketTagIterator::PacketTagIterator (const struct PacketTagList::TagData *begin,
+                                      const struct PacketTagList::TagData *end)
+  : m_begin (begin),
+    m_current (end)
 {
 }
 bool
 PacketTagIterator::HasNext (void) const
 {
-  return m_current != 0;
+  return m_current != m_begin;
 }
 PacketTagIterator::Item
 PacketTagIterator::Next (void)
 {
   NS_ASSERT (HasNext ());
-  const struct PacketTagList::TagData *prev = m_current;
-  m_current = m_current->next;
-  return PacketTagIterator::Item (prev);
+  m_current--;
+  return PacketTagIterator::Item (m_current);
 }
 
 PacketTagIterator::Item::Item (const struct PacketTagList::TagData *data)
@@ -879,7 +970,7 @@ Packet::PrintPacketTags (std::ostream &os) const
 PacketTagIterator 
 Packet::GetPacketTagIterator (void) const
 {
-  return PacketTagIterator (m_packetTagList.Head ());
+  return PacketTagIterator (m_packetTagList.Begin (), m_packetTagList.End ());
 }
 
 std::ostream& operator<< (std::ostream& os, const Packet &packet)
@@ -169,10 +169,33 @@ private:
   friend class Packet;
   /**
    * Constructor
-   * \param head head of the items
+   * \param begin the oldest of the items
+   * \param end past the most recent of the items
    */
-  PacketTagIterator (const struct PacketTagList::TagData *head);
-  const struct PacketTagList::TagData *m_current;  //!< actual position over the set of tags in a packet
+  PacketTagIterator (const struct PacketTagList::TagData *begin,
+                     const struct PacketTagList::TagData *end);
+  const struct PacketTagList::TagData *m_begin;    //!< oldest tag in the packet
+  const struct PacketTagList::TagData *m_current;  //!< past the next tag to return; tags are returned most recent first
+};
+
+/**
+ * \ingroup packet
+ * \brief Counters of the heap allocations made for packets.
+ *
+ * Packets, and the storage of their buffers, tags and metadata, are
+ * recycled through free lists: a simulation which forwards packets in
+ * steady state should see these counters stay constant.
+ *
+ * \see Packet::GetAllocationStats
+ */
+struct PacketAllocationStats
+{
+  uint64_t packets;         //!< Packets created
+  uint64_t packetAllocs;    //!< Packets allocated from the heap rather than the pool
+  uint64_t bufferAllocs;    //!< Buffer data allocated from the heap
+  uint64_t byteTagAllocs;   //!< Byte tag lists allocated from the heap
+  uint64_t packetTagAllocs; //!< Packet tag blocks allocated from the heap
+  uint64_t metadataAllocs;  //!< Packet metadata allocated from the heap
 };
 
 /**
@@ -195,7 +218,9 @@ private:
  * output from Packet::Print. If you wish to only enable
  * checking of metadata, and do not need any printing capability, you can
  * call Packet::EnableChecking: its runtime cost is lower than
- * Packet::EnablePrinting.
+ * Packet::EnablePrinting. While the metadata is disabled, packets only
+ * record their uid, so adding and removing headers costs nothing more.
+ * Creating an ascii trace file enables the metadata.
  *
  * - The set of tags contain simulation-specific information which cannot
  * be stored in the packet byte buffer because the protocol headers or trailers
@@ -223,6 +248,11 @@ private:
  *
  * The performance aspects copy-on-write semantics of the
  * Packet API are discussed in \ref packetperf
+ *
+ * Packet objects are allocated from a pool: the memory of destroyed
+ * packets is kept in a free list and reused by the next packets, so
+ * that Create<Packet> and Packet::Copy do not reach the heap in steady
+ * state. Packet::GetAllocationStats reports the allocations which did.
  */
 class Packet : public SimpleRefCount<Packet>
 {
@@ -487,7 +517,9 @@ public:
    * perform the operations requested by the Print methods. If you
    * want to be able the Packet::Print method, 
    * you need to invoke this method at least once during the 
-   * simulation setup and before any packet is created.
+   * simulation. Only the packets created afterwards record their
+   * headers and trailers, so it is best called during the simulation
+   * setup, before any packet is created.
    */
   static void EnablePrinting (void);
   /**
@@ -502,6 +534,30 @@ public:
    */
   static void EnableChecking (void);
 
+  /**
+   * \brief Get the packet allocation counters.
+   *
+   * \returns the allocations made since the start of the program or
+   * the last call to ResetAllocationStats.
+   */
+  static PacketAllocationStats GetAllocationStats (void);
+  /**
+   * \brief Reset the packet allocation counters.
+   */
+  static void ResetAllocationStats (void);
+
+  /**
+   * \brief Allocate a packet from the packet pool.
+   * \param size the size of a Packet
+   * \returns the memory of a Packet
+   */
+  static void *operator new (size_t size);
+  /**
+   * \brief Return a packet to the packet pool.
+   * \param p the memory of a Packet
+   */
+  static void operator delete (void *p);
+
   /**
    * \brief Returns number of bytes required for packet
    * serialization.
@@ -722,6 +778,9 @@ private:
   Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
 
   static uint32_t m_globalUid; //!< Global counter of packets Uid
+  static uint64_t m_packets;      //!< Number of packets created
+  static uint64_t m_packetAllocs; //!< Number of packets allocated from the heap
+  static PacketAllocationStats m_statsBase; //!< Counters at the last reset
 };
 
 /**
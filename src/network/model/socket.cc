@@ -171,6 +171,57 @@ Socket::SendTo (const uint8_t* buf, uint32_t size, uint32_t flags,
   return SendTo (p, flags, toAddress);
 }
 
+int
+Socket::SendMany (const std::vector<Ptr<Packet> > &packets, uint32_t flags)
+{
+  NS_LOG_FUNCTION (this << packets.size () << flags);
+  int sent = 0;
+  for (std::vector<Ptr<Packet> >::const_iterator i = packets.begin (); i != packets.end (); ++i)
+    {
+      if (Send (*i, flags) < 0)
+        {
+          return sent == 0 ? -1 : sent;
+        }
+      sent++;
+    }
+  return sent;
+}
+
+int
+Socket::SendManyTo (const std::vector<Ptr<Packet> > &packets, uint32_t flags,
+                    const Address &toAddress)
+{
+  NS_LOG_FUNCTION (this << packets.size () << flags << toAddress);
+  int sent = 0;
+  for (std::vector<Ptr<Packet> >::const_iterator i = packets.begin (); i != packets.end (); ++i)
+    {
+      if (SendTo (*i, flags, toAddress) < 0)
+        {
+          return sent == 0 ? -1 : sent;
+        }
+      sent++;
+    }
+  return sent;
+}
+
+uint32_t
+Socket::RecvMany (std::vector<Ptr<Packet> > &packets, uint32_t maxPackets, uint32_t flags)
+{
+  NS_LOG_FUNCTION (this << maxPackets << flags);
+  uint32_t received = 0;
+  while (received < maxPackets)
+    {
+      Ptr<Packet> p = Recv (std::numeric_limits<uint32_t>::max (), flags);
+      if (p == 0)
+        {
+          break;
+        }
+      packets.push_back (p);
+      received++;
+    }
+  return received;
+}
+
 Ptr<Packet>
 Socket::Recv (void)
 {
@@ -30,6 +30,7 @@
 #include "ns3/net-device.h"
 #include "address.h"
 #include <stdint.h>
+#include <vector>
 #include "ns3/inet-socket-address.h"
 #include "ns3/inet6-socket-address.h"
 
@@ -440,6 +441,55 @@ public:
   virtual Ptr<Packet> RecvFrom (uint32_t maxSize, uint32_t flags,
                                 Address &fromAddress) = 0;
 
+  /**
+   * \brief Send several datagrams to the remote host
+   *
+   * This function matches in semantics the sendmmsg() function call
+   * of Linux: the packets are sent in order, as many calls to Send ()
+   * would, and the sending stops at the first packet that cannot be
+   * sent.  Subclasses may process the whole batch at once, for instance
+   * with a single route lookup; this implementation calls Send () for
+   * each packet.
+   *
+   * \param packets the packets to send
+   * \param flags Socket control flags
+   * \returns the number of packets accepted for transmission, or -1 if
+   *          the first packet could not be sent (SocketErrno is then set
+   *          as by Send ()).
+   */
+  virtual int SendMany (const std::vector<Ptr<Packet> > &packets, uint32_t flags);
+
+  /**
+   * \brief Send several datagrams to a specified peer.
+   *
+   * This method has similar semantics to SendMany (); this
+   * implementation calls SendTo () for each packet.
+   *
+   * \param packets the packets to send
+   * \param flags Socket control flags
+   * \param toAddress IP Address of remote host
+   * \returns the number of packets accepted for transmission, or -1 if
+   *          the first packet could not be sent.
+   */
+  virtual int SendManyTo (const std::vector<Ptr<Packet> > &packets, uint32_t flags,
+                          const Address &toAddress);
+
+  /**
+   * \brief Read several packets from the socket
+   *
+   * This function matches in semantics the recvmmsg() function call
+   * of Linux: the packets available are appended to the vector, up to
+   * maxPackets of them, and the call returns immediately.  This
+   * implementation calls Recv () until it returns 0.
+   *
+   * \param packets the vector to which the packets are appended
+   * \param maxPackets the maximum number of packets to read
+   * \param flags Socket control flags
+   * \returns the number of packets appended to the vector
+   */
+  virtual uint32_t RecvMany (std::vector<Ptr<Packet> > &packets, uint32_t maxPackets,
+                             uint32_t flags);
+
   /////////////////////////////////////////////////////////////////////
   //   The remainder of these public methods are overloaded methods  //
   //   or variants of Send() and Recv(), and they are non-virtual    //
@@ -22,6 +22,8 @@
 #include "ns3/random-variable-stream.h"
 #include "ns3/double.h"
 #include "ns3/test.h"
+#include <sstream>
+#include <vector>
 
 using namespace ns3;
 
@@ -361,6 +363,280 @@ BufferTest::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (val1, val2, "Bad ReadNtohU16()");
 }
 //-----------------------------------------------------------------------------
+/**
+ * Check buffers whose content is held in a chain of slices.
+ */
+class BufferChainTest : public TestCase {
+private:
+  /**
+   * Check the content of a buffer with all the ways to read it.
+   * \param b the buffer
+   * \param expected the expected content
+   * \param what a description of the check
+   */
+  void Check (const Buffer &b, const std::vector<uint8_t> &expected, std::string what);
+  /**
+   * Create a buffer of real bytes.
+   * \param size the buffer size
+   * \param seed the value of the first byte
+   * \param content the content of the buffer is appended to this vector
+   * \returns the buffer
+   */
+  Buffer Make (uint32_t size, uint8_t seed, std::vector<uint8_t> &content);
+public:
+  virtual void DoRun (void);
+  BufferChainTest ();
+};
+
+BufferChainTest::BufferChainTest ()
+  : TestCase ("Chained buffers") {
+}
+
+Buffer
+BufferChainTest::Make (uint32_t size, uint8_t seed, std::vector<uint8_t> &content)
+{
+  Buffer b;
+  b.AddAtStart (size);
+  Buffer::Iterator i = b.Begin ();
+  for (uint32_t j = 0; j < size; j++)
+    {
+      uint8_t v = seed + j * 7;
+      i.WriteU8 (v);
+      content.push_back (v);
+    }
+  return b;
+}
+
+void
+BufferChainTest::Check (const Buffer &b, const std::vector<uint8_t> &expected, std::string what)
+{
+  NS_TEST_ASSERT_MSG_EQ (b.GetSize (), expected.size (), what << ": bad size");
+  std::vector<uint8_t> copied (b.GetSize () + 1);
+  uint32_t n = b.CopyData (&copied[0], b.GetSize ());
+  NS_TEST_ASSERT_MSG_EQ (n, b.GetSize (), what << ": bad CopyData size");
+  std::ostringstream os;
+  b.CopyData (&os, b.GetSize ());
+  std::string streamed = os.str ();
+  Buffer::Iterator i = b.Begin ();
+  std::vector<uint8_t> read (b.GetSize () + 1);
+  i.Read (&read[0], b.GetSize ());
+  NS_TEST_ASSERT_MSG_EQ (i.IsEnd (), true, what << ": Read did not reach the end");
+  i = b.Begin ();
+  Buffer real = b;
+  uint8_t const *peeked = real.PeekData ();
+  for (uint32_t j = 0; j < expected.size (); j++)
+    {
+      NS_TEST_ASSERT_MSG_EQ ((uint32_t)i.ReadU8 (), (uint32_t)expected[j], what << ": ReadU8 at " << j);
+      NS_TEST_ASSERT_MSG_EQ ((uint32_t)copied[j], (uint32_t)expected[j], what << ": CopyData at " << j);
+      NS_TEST_ASSERT_MSG_EQ ((uint32_t)(uint8_t)streamed[j], (uint32_t)expected[j], what << ": CopyData stream at " << j);
+      NS_TEST_ASSERT_MSG_EQ ((uint32_t)read[j], (uint32_t)expected[j], what << ": Read at " << j);
+      NS_TEST_ASSERT_MSG_EQ ((uint32_t)peeked[j], (uint32_t)expected[j], what << ": PeekData at " << j);
+    }
+  if (expected.size () >= 2)
+    {
+      i = b.Begin ();
+      i.Next (expected.size () / 2 - 1);
+      uint16_t v = i.ReadNtohU16 ();
+      uint16_t e = (expected[expected.size () / 2 - 1] << 8) | expected[expected.size () / 2];
+      NS_TEST_ASSERT_MSG_EQ (v, e, what << ": ReadNtohU16");
+    }
+}
+
+void
+BufferChainTest::DoRun (void)
+{
+  std::vector<uint8_t> a;
+  std::vector<uint8_t> b;
+  Buffer bufA = Make (1000, 1, a);
+  Buffer bufB = Make (600, 2, b);
+
+  // concatenate two real buffers
+  Buffer c = bufA;
+  c.AddAtEnd (bufB);
+  std::vector<uint8_t> expected = a;
+  expected.insert (expected.end (), b.begin (), b.end ());
+  Check (c, expected, "concatenation");
+  Check (bufA, a, "first buffer after concatenation");
+  Check (bufB, b, "second buffer after concatenation");
+
+  // add a header and a trailer around the chain
+  c.AddAtStart (4);
+  c.Begin ().WriteHtonU32 (0x01020304);
+  c.AddAtEnd (2);
+  Buffer::Iterator i = c.End ();
+  i.Prev (2);
+  i.WriteHtonU16 (0x0506);
+  uint8_t header[] = { 1, 2, 3, 4 };
+  expected.insert (expected.begin (), header, header + 4);
+  expected.push_back (5);
+  expected.push_back (6);
+  Check (c, expected, "header and trailer");
+
+  // append a buffer with a zero area, a header and a trailer
+  Buffer z (700);
+  z.AddAtStart (3);
+  z.Begin ().WriteU8 (9, 3);
+  z.AddAtEnd (1);
+  i = z.End ();
+  i.Prev (1);
+  i.WriteU8 (8);
+  c.AddAtEnd (z);
+  expected.insert (expected.end (), 3, 9);
+  expected.insert (expected.end (), 700, 0);
+  expected.push_back (8);
+  Check (c, expected, "zero area");
+
+  // fragments of the chain
+  Buffer f = c.CreateFragment (500, 1500);
+  Check (f, std::vector<uint8_t> (expected.begin () + 500, expected.begin () + 2000), "fragment");
+  f.RemoveAtStart (700);
+  f.RemoveAtEnd (100);
+  Check (f, std::vector<uint8_t> (expected.begin () + 1200, expected.begin () + 1900), "trimmed fragment");
+
+  // reassemble fragments of one buffer
+  Buffer r = bufA.CreateFragment (0, 300);
+  r.AddAtEnd (bufA.CreateFragment (300, 400));
+  r.AddAtEnd (bufA.CreateFragment (700, 300));
+  Check (r, a, "reassembly");
+
+  // append a chained buffer to itself
+  Buffer self = c;
+  self.AddAtEnd (self);
+  std::vector<uint8_t> doubled = expected;
+  doubled.insert (doubled.end (), expected.begin (), expected.end ());
+  Check (self, doubled, "self concatenation");
+
+  // serialization
+  std::vector<uint8_t> serialized (c.GetSerializedSize ());
+  NS_TEST_ASSERT_MSG_EQ (c.Serialize (&serialized[0], serialized.size ()), 1u, "Serialize failed");
+  Buffer d (0, false);
+  // the size given to Deserialize includes the 4-byte length field of
+  // the packet serialization format.
+  d.Deserialize (&serialized[0], serialized.size () + 4);
+  Check (d, expected, "deserialization");
+
+  // copy from a chained buffer with an iterator
+  Buffer w;
+  w.AddAtStart (c.GetSize ());
+  w.Begin ().Write (c.Begin (), c.End ());
+  Check (w, expected, "iterator copy");
+
+  // pad each subframe of an aggregate: the padding added after a chained
+  // append must not overwrite the padding of the previous subframe, which
+  // the chain still holds
+  Buffer agg;
+  std::vector<uint8_t> aggExpected;
+  std::vector<Buffer> aggCopies;
+  std::vector<std::vector<uint8_t> > aggCopiesExpected;
+  for (uint8_t k = 0; k < 3; k++)
+    {
+      agg.AddAtEnd (Buffer (1502));
+      agg.AddAtEnd (2);
+      i = agg.End ();
+      i.Prev (2);
+      i.WriteU8 (0xa0 + k, 2);
+      aggExpected.insert (aggExpected.end (), 1502, 0);
+      aggExpected.insert (aggExpected.end (), 2, 0xa0 + k);
+      aggCopies.push_back (agg);
+      aggCopiesExpected.push_back (aggExpected);
+    }
+  Check (agg, aggExpected, "padded aggregate");
+  for (uint32_t k = 0; k < aggCopies.size (); k++)
+    {
+      Check (aggCopies[k], aggCopiesExpected[k], "copy of a padded aggregate");
+    }
+
+  // trailer, chained append, trailer
+  std::vector<uint8_t> t = b;
+  Buffer trailed = bufB;
+  trailed.AddAtEnd (2);
+  i = trailed.End ();
+  i.Prev (2);
+  i.WriteHtonU16 (0x0b0c);
+  t.push_back (0x0b);
+  t.push_back (0x0c);
+  Buffer firstTrailer = trailed;
+  std::vector<uint8_t> firstTrailerExpected = t;
+  trailed.AddAtEnd (bufA);
+  trailed.AddAtEnd (2);
+  i = trailed.End ();
+  i.Prev (2);
+  i.WriteHtonU16 (0x0d0e);
+  t.insert (t.end (), a.begin (), a.end ());
+  t.push_back (0x0d);
+  t.push_back (0x0e);
+  Check (trailed, t, "trailers around a chained append");
+  Check (firstTrailer, firstTrailerExpected, "copy before the chained append");
+
+  // chained append to a buffer whose head is shared with a copy
+  std::vector<uint8_t> h;
+  Buffer head = Make (100, 3, h);
+  Buffer headCopy = head;
+  head.AddAtEnd (bufA);
+  head.AddAtStart (2);
+  head.Begin ().WriteHtonU16 (0x1112);
+  head.AddAtEnd (2);
+  i = head.End ();
+  i.Prev (2);
+  i.WriteHtonU16 (0x1314);
+  headCopy.AddAtEnd (2);
+  i = headCopy.End ();
+  i.Prev (2);
+  i.WriteHtonU16 (0x1516);
+  std::vector<uint8_t> headExpected;
+  headExpected.push_back (0x11);
+  headExpected.push_back (0x12);
+  headExpected.insert (headExpected.end (), h.begin (), h.end ());
+  headExpected.insert (headExpected.end (), a.begin (), a.end ());
+  headExpected.push_back (0x13);
+  headExpected.push_back (0x14);
+  Check (head, headExpected, "chained append to a shared head");
+  h.push_back (0x15);
+  h.push_back (0x16);
+  Check (headCopy, h, "copy of a shared head");
+
+  // chained append to a buffer whose data has a dirty end: a copy of it
+  // already added bytes at the end of the shared data
+  std::vector<uint8_t> e;
+  Buffer dirty = Make (50, 4, e);
+  Buffer dirtyCopy = dirty;
+  dirtyCopy.AddAtEnd (4);
+  i = dirtyCopy.End ();
+  i.Prev (4);
+  i.WriteHtonU32 (0x21222324);
+  std::vector<uint8_t> dirtyCopyExpected = e;
+  dirtyCopyExpected.push_back (0x21);
+  dirtyCopyExpected.push_back (0x22);
+  dirtyCopyExpected.push_back (0x23);
+  dirtyCopyExpected.push_back (0x24);
+  dirty.AddAtEnd (bufB);
+  dirty.AddAtEnd (3);
+  i = dirty.End ();
+  i.Prev (3);
+  i.WriteU8 (0x25, 3);
+  e.insert (e.end (), b.begin (), b.end ());
+  e.insert (e.end (), 3, 0x25);
+  Check (dirty, e, "chained append to a dirty end");
+  Check (dirtyCopy, dirtyCopyExpected, "copy with the dirty end");
+
+  // read across virtual areas larger than the block CopyData uses to
+  // copy them, made of zeroes and of real bytes
+  std::vector<uint8_t> l;
+  Buffer large = Make (10, 5, l);
+  large.AddAtEnd (Buffer (5000));
+  l.insert (l.end (), 5000, 0);
+  large.AddAtEnd (Make (3000, 6, l));
+  large.AddAtEnd (2);
+  i = large.End ();
+  i.Prev (2);
+  i.WriteHtonU16 (0x2627);
+  l.push_back (0x26);
+  l.push_back (0x27);
+  Check (large, l, "large virtual area");
+  Check (large.CreateFragment (7, 7000),
+         std::vector<uint8_t> (l.begin () + 7, l.begin () + 7007), "large virtual area fragment");
+}
+//-----------------------------------------------------------------------------
 class BufferTestSuite : public TestSuite
 {
 public:
@@ -371,6 +647,7 @@ BufferTestSuite::BufferTestSuite ()
   : TestSuite ("buffer", UNIT)
 {
   AddTestCase (new BufferTest, TestCase::QUICK);
+  AddTestCase (new BufferChainTest, TestCase::QUICK);
 }
 
 static BufferTestSuite g_bufferTestSuite;
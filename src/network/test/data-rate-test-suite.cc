@@ -0,0 +1,190 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/core-config.h"
+#include "ns3/data-rate.h"
+#include "ns3/nstime.h"
+#include "ns3/test.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Check DataRate transmission times against exact integer arithmetic.
+ */
+class DataRateTxTimeTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   *
+   * \param [in] frames The number of frames to check at each rate.
+   */
+  DataRateTxTimeTestCase (uint64_t frames);
+private:
+  virtual void DoRun (void);
+  /**
+   * \param [in] n A number of bits.
+   * \param [in] bps A data rate.
+   * \returns the transmission time of n bits in nanoseconds, rounded down.
+   */
+  static uint64_t Reference (uint64_t n, uint64_t bps);
+  uint64_t m_frames; //!< Number of frames to check at each rate
+};
+
+DataRateTxTimeTestCase::DataRateTxTimeTestCase (uint64_t frames)
+  : TestCase ("Check exact DataRate transmission times"),
+    m_frames (frames)
+{
+}
+
+uint64_t
+DataRateTxTimeTestCase::Reference (uint64_t n, uint64_t bps)
+{
+#ifdef HAVE___UINT128_T
+  return static_cast<uint64_t> (static_cast<__uint128_t> (n) * 1000000000 / bps);
+#else
+  // n * 1e9 / bps with the 1e9 split in two factors that cannot overflow
+  // for the rates and sizes used here.
+  uint64_t q = (n * 100000) / bps;
+  uint64_t r = (n * 100000) % bps;
+  return q * 10000 + (r * 10000) / bps;
+#endif
+}
+
+void
+DataRateTxTimeTestCase::DoRun (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (Time::GetResolution (), Time::NS, "Unexpected resolution");
+  const uint64_t rates[] = { 1, 3, 56000, 7000000, 10000000000ULL,
+                             100000000000ULL, 1234567891ULL, 999999937ULL };
+  const uint32_t sizes[] = { 0, 1, 42, 64, 576, 1500, 1502, 1518, 9000 };
+  for (uint32_t i = 0; i < sizeof (rates) / sizeof (rates[0]); i++)
+    {
+      DataRate rate (rates[i]);
+      // Frame sizes from a fixed table and a linear congruential
+      // generator; sum the exact times of all frames.
+      uint64_t sum = 0;
+      uint64_t expected = 0;
+      uint32_t lcg = 12345;
+      for (uint64_t frame = 0; frame < m_frames; frame++)
+        {
+          uint32_t bytes;
+          if (frame % 2 == 0)
+            {
+              bytes = sizes[(frame / 2) % (sizeof (sizes) / sizeof (sizes[0]))];
+            }
+          else
+            {
+              lcg = lcg * 1103515245 + 12345;
+              bytes = (lcg >> 16) % 65536;
+            }
+          uint64_t exact = Reference (8ULL * bytes, rates[i]);
+          uint64_t steps = rate.CalculateBytesTxTime (bytes).GetTimeStep ();
+          if (steps != exact)
+            {
+              NS_TEST_ASSERT_MSG_EQ (steps, exact, "Wrong time of " << bytes
+                                     << " bytes at " << rates[i] << "bps");
+            }
+          sum += steps;
+          expected += exact;
+        }
+      NS_TEST_ASSERT_MSG_EQ (sum, expected, "Accumulated time differs at "
+                             << rates[i] << "bps");
+
+      for (uint32_t bits = 0; bits < 100000; bits += 7)
+        {
+          uint64_t steps = rate.CalculateBitsTxTime (bits).GetTimeStep ();
+          if (steps != Reference (bits, rates[i]))
+            {
+              NS_TEST_ASSERT_MSG_EQ (steps, Reference (bits, rates[i]),
+                                     "Wrong time of " << bits << " bits at "
+                                     << rates[i] << "bps");
+            }
+        }
+    }
+
+  // Rounding down, and no drift: 1500 bytes at 7Mbps are 1714285.71 ns.
+  DataRate rate ("7Mbps");
+  NS_TEST_ASSERT_MSG_EQ (rate.CalculateBytesTxTime (1500), NanoSeconds (1714285),
+                         "Wrong 1500 bytes time at 7Mbps");
+  NS_TEST_ASSERT_MSG_EQ (rate.CalculateBytesTxTime (7000000), Seconds (8),
+                         "Wrong 7000000 bytes time at 7Mbps");
+  NS_TEST_ASSERT_MSG_EQ (DataRate ("10Gbps").CalculateBytesTxTime (1500),
+                         NanoSeconds (1200), "Wrong 1500 bytes time at 10Gbps");
+  NS_TEST_ASSERT_MSG_EQ (DataRate (1).CalculateBytesTxTime (1000000),
+                         Seconds (8000000), "Wrong 1000000 bytes time at 1bps");
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Check the DataRate transmission times computed from an integer
+ * number of Time steps per byte.
+ */
+class DataRateStepsPerByteTestCase : public TestCase
+{
+public:
+  DataRateStepsPerByteTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+DataRateStepsPerByteTestCase::DataRateStepsPerByteTestCase ()
+  : TestCase ("Check DataRate transmission times in integer Time steps")
+{
+}
+
+void
+DataRateStepsPerByteTestCase::DoRun (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (Time::GetResolution (), Time::NS, "Unexpected resolution");
+  // Exact, where the double computation gave 11999 ns.
+  NS_TEST_ASSERT_MSG_EQ (DataRate ("1Gbps").CalculateBytesTxTime (1500),
+                         NanoSeconds (12000), "Wrong 1500 bytes time at 1Gbps");
+  NS_TEST_ASSERT_MSG_EQ (DataRate ("1Gbps").CalculateBitsTxTime (12000),
+                         NanoSeconds (12000), "Wrong 12000 bits time at 1Gbps");
+  NS_TEST_ASSERT_MSG_EQ (DataRate ("100Mbps").CalculateBytesTxTime (1500),
+                         NanoSeconds (120000), "Wrong 1500 bytes time at 100Mbps");
+  NS_TEST_ASSERT_MSG_EQ (DataRate (8).CalculateBytesTxTime (3),
+                         Seconds (3), "Wrong 3 bytes time at 8bps");
+  NS_TEST_ASSERT_MSG_EQ (DataRate ("1Gbps").CalculateBytesTxTime (0),
+                         Time (0), "Wrong empty frame time at 1Gbps");
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * DataRate test suite.
+ */
+class DataRateTestSuite : public TestSuite
+{
+public:
+  DataRateTestSuite ();
+};
+
+DataRateTestSuite::DataRateTestSuite ()
+  : TestSuite ("data-rate", UNIT)
+{
+  AddTestCase (new DataRateStepsPerByteTestCase, TestCase::QUICK);
+  AddTestCase (new DataRateTxTimeTestCase (125000), TestCase::QUICK);
+}
+
+static DataRateTestSuite g_dataRateTestSuite; //!< Static variable for test initialization
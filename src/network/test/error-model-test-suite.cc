@@ -38,6 +38,7 @@
 #include "ns3/pointer.h"
 #include "ns3/double.h"
 #include "ns3/string.h"
+#include "ns3/uinteger.h"
 #include "ns3/rng-seed-manager.h"
 
 using namespace ns3;
@@ -142,6 +143,53 @@ ErrorModelSimple::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (m_drops, 9, "Wrong number of drops.");
 }
 
+class RateErrorModelBuffered : public TestCase
+{
+public:
+  RateErrorModelBuffered ();
+
+private:
+  virtual void DoRun (void);
+};
+
+RateErrorModelBuffered::RateErrorModelBuffered ()
+  : TestCase ("RateErrorModel buffered decisions match unbuffered ones")
+{
+}
+
+void
+RateErrorModelBuffered::DoRun (void)
+{
+  RngSeedManager::SetSeed (7);
+  RngSeedManager::SetRun (2);
+
+  Ptr<RateErrorModel> models[2];
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      models[i] = CreateObject<RateErrorModel> ();
+      models[i]->SetAttribute ("ErrorRate", DoubleValue (0.0001));
+      models[i]->SetAttribute ("ErrorUnit", StringValue ("ERROR_UNIT_BYTE"));
+      models[i]->AssignStreams (50);
+    }
+  models[1]->SetAttribute ("BufferSize", UintegerValue (64));
+
+  uint32_t drops = 0;
+  for (uint32_t i = 0; i < 10000; ++i)
+    {
+      Ptr<Packet> p = Create<Packet> (40 + (i * 37) % 1460);
+      bool corrupt = models[0]->IsCorrupt (p);
+      NS_TEST_ASSERT_MSG_EQ (models[1]->IsCorrupt (p), corrupt, "Different decision for packet " << i);
+      drops += corrupt;
+      if (i == 5000)
+        {
+          // Reassigning the stream must discard the buffered values.
+          models[0]->AssignStreams (51);
+          models[1]->AssignStreams (51);
+        }
+    }
+  NS_TEST_ASSERT_MSG_GT (drops, 0, "Expected some drops");
+}
+
 class BurstErrorModelSimple : public TestCase
 {
 public:
@@ -237,6 +285,7 @@ ErrorModelTestSuite::ErrorModelTestSuite ()
   : TestSuite ("error-model", UNIT)
 {
   AddTestCase (new ErrorModelSimple, TestCase::QUICK);
+  AddTestCase (new RateErrorModelBuffered, TestCase::QUICK);
   AddTestCase (new BurstErrorModelSimple, TestCase::QUICK);
 }
 
@@ -20,6 +20,7 @@
 #include "ns3/packet.h"
 #include "ns3/packet-tag-list.h"
 #include "ns3/test.h"
+#include "ns3/log.h"
 #include "ns3/unused.h"
 #include <limits>     // std:numeric_limits
 #include <string>
@@ -71,9 +72,7 @@ public:
    * \return The TypeId.
    */
   static TypeId GetTypeId (void) {
-    std::ostringstream oss;
-    oss << "anon::ATestTag<" << N << ">";
-    static TypeId tid = TypeId (oss.str ().c_str ())
+    static TypeId tid = TypeId (GetName ().c_str ())
       .SetParent<ATestTagBase> ()
       .SetGroupName ("Network")
       .HideFromDocumentation ()
@@ -81,6 +80,14 @@ public:
     ;
     return tid;
   }
+  /**
+   * \return The name of this type.
+   */
+  static std::string GetName (void) {
+    std::ostringstream oss;
+    oss << "anon::ATestTag<" << N << ">";
+    return oss.str ();
+  }
   virtual TypeId GetInstanceTypeId (void) const {
     return GetTypeId ();
   }
@@ -847,6 +854,149 @@ PacketTagListTest::DoRun (void)
     
 }
 
+//-----------------------------------------------------------------------------
+/**
+ * Measure the per-packet cost of packet tags.
+ *
+ * Each packet carries a flow tag, like FlowMonitor's, and crosses several
+ * hops.  On each hop it is copied, as queues and channels do, and a
+ * per-hop tag, like GbnNetDevice's, is added, peeked and removed.
+ */
+class PacketTagPerfTest : public TestCase
+{
+public:
+  PacketTagPerfTest ();
+private:
+  void DoRun (void);
+};
+
+PacketTagPerfTest::PacketTagPerfTest ()
+  : TestCase ("Measure the cost of packet tags along a multi-hop path")
+{
+}
+
+void
+PacketTagPerfTest::DoRun (void)
+{
+  const uint32_t packets = 100000;
+  const uint32_t hops = 8;
+  ATestTag<8> flow (1);
+  ATestTag<16> frame (2);
+  ATestTag<4> route (3);
+  ATestTag<16> peek;
+
+  std::clock_t start = std::clock ();
+  for (uint32_t i = 0; i < packets; ++i)
+    {
+      Ptr<Packet> p = Create<Packet> (1000);
+      p->AddPacketTag (flow);
+      for (uint32_t h = 0; h < hops; ++h)
+        {
+          p = p->Copy ();
+          p->AddPacketTag (frame);
+          route.m_data = h;
+          p->ReplacePacketTag (route);
+          p->PeekPacketTag (peek);
+          p->PeekPacketTag (flow);
+          p->RemovePacketTag (frame);
+        }
+      NS_TEST_ASSERT_MSG_EQ (p->PeekPacketTag (route), true, "route tag missing");
+    }
+  std::clock_t ticks = std::clock () - start;
+  double per = 1e9 * double (ticks) / (double (packets) * CLOCKS_PER_SEC);
+  NS_LOG_UNCOND (GetName () << ": " << hops << " hops, "
+                 << std::fixed << std::setprecision (1) << per
+                 << " ns/packet");
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Measure the copy-on-write cost of packet tag lists.
+ *
+ * A list of four tags is shared by several copies, as when a packet is
+ * delivered to several receivers.  Each copy either only reads the
+ * tags, or rewrites one, adds and removes another, as a forwarding hop
+ * does.  The lists are used directly, without packets, so that the
+ * measure is not diluted by the cost of packet copies.
+ */
+class PacketTagCowPerfTest : public TestCase
+{
+public:
+  PacketTagCowPerfTest ();
+private:
+  void DoRun (void);
+};
+
+PacketTagCowPerfTest::PacketTagCowPerfTest ()
+  : TestCase ("Measure the copy-on-write cost of packet tag lists")
+{
+}
+
+void
+PacketTagCowPerfTest::DoRun (void)
+{
+  const uint32_t lists = 200000;
+  const uint32_t copies = 8;
+  ATestTag<8> a (1);
+  ATestTag<4> b (2);
+  ATestTag<12> c (3);
+  ATestTag<2> d (4);
+  ATestTag<16> e (5);
+  ATestTag<8> pa;
+  ATestTag<4> pb;
+  ATestTag<12> pc;
+  ATestTag<2> pd;
+  uint32_t found = 0;
+
+  // Copies which only read the shared tags
+  std::clock_t start = std::clock ();
+  for (uint32_t i = 0; i < lists; ++i)
+    {
+      PacketTagList list;
+      list.Add (a);
+      list.Add (b);
+      list.Add (c);
+      list.Add (d);
+      for (uint32_t k = 0; k < copies; ++k)
+        {
+          PacketTagList copy (list);
+          found += copy.Peek (pa) + copy.Peek (pb) + copy.Peek (pc) + copy.Peek (pd);
+        }
+    }
+  std::clock_t read = std::clock () - start;
+  NS_TEST_ASSERT_MSG_EQ (found, lists * copies * 4, "tags missing");
+
+  // Copies which write, each one copied from the previous one
+  found = 0;
+  start = std::clock ();
+  for (uint32_t i = 0; i < lists; ++i)
+    {
+      PacketTagList list;
+      list.Add (a);
+      list.Add (b);
+      list.Add (c);
+      list.Add (d);
+      for (uint32_t k = 0; k < copies; ++k)
+        {
+          PacketTagList copy (list);
+          a.m_data = k;
+          copy.Replace (a);
+          copy.Add (e);
+          found += copy.Peek (pd);
+          copy.Remove (e);
+          list = copy;
+        }
+    }
+  std::clock_t write = std::clock () - start;
+  NS_TEST_ASSERT_MSG_EQ (found, lists * copies, "tags missing");
+
+  double scale = 1e9 / (double (lists) * CLOCKS_PER_SEC);
+  NS_LOG_UNCOND (GetName () << ": " << copies << " copies, "
+                 << std::fixed << std::setprecision (1)
+                 << "read " << double (read) * scale << " ns/list, "
+                 << "write " << double (write) * scale << " ns/list");
+}
+
 //-----------------------------------------------------------------------------
 class PacketTestSuite : public TestSuite
 {
@@ -862,3 +1012,19 @@ PacketTestSuite::PacketTestSuite ()
 }
 
 static PacketTestSuite g_packetTestSuite;
+
+//-----------------------------------------------------------------------------
+class PacketTagPerfTestSuite : public TestSuite
+{
+public:
+  PacketTagPerfTestSuite ();
+};
+
+PacketTagPerfTestSuite::PacketTagPerfTestSuite ()
+  : TestSuite ("packet-tag-perf", PERFORMANCE)
+{
+  AddTestCase (new PacketTagPerfTest, TestCase::QUICK);
+  AddTestCase (new PacketTagCowPerfTest, TestCase::QUICK);
+}
+
+static PacketTagPerfTestSuite g_packetTagPerfTestSuite;
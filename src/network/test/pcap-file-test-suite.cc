@@ -21,10 +21,16 @@
 #include <cstdlib>
 #include <sstream>
 #include <cstring>
+#include <fstream>
+#include <iterator>
 
 #include "ns3/log.h"
 #include "ns3/test.h"
 #include "ns3/pcap-file.h"
+#include "ns3/pcap-file-wrapper.h"
+#include "ns3/packet.h"
+#include "ns3/nstime.h"
+#include "ns3/string.h"
 
 using namespace ns3;
 
@@ -60,6 +66,14 @@ CheckFileExists (std::string filename)
 }
 
 
+static std::string
+ReadFileContents (std::string filename)
+{
+  std::ifstream f (filename.c_str (), std::ios::in | std::ios::binary);
+  return std::string ((std::istreambuf_iterator<char> (f)),
+                      std::istreambuf_iterator<char> ());
+}
+
 static bool
 CheckFileLength (std::string filename, uint64_t sizeExpected)
 {
@@ -1121,6 +1135,216 @@ DiffTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (usec, 3696, "Files are different from 2.3696 seconds");
 }
 
+// ===========================================================================
+// Test case to make sure that buffered and asynchronous writes produce the
+// same file as unbuffered writes.
+// ===========================================================================
+class BufferedWriteTestCase : public TestCase
+{
+public:
+  BufferedWriteTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Write a file with packets of various sizes, some truncated.
+   * \param filename the file name
+   * \param bufferSize the write buffer size
+   * \param asynchronous whether to write from a background thread
+   */
+  void WriteFile (std::string filename, uint32_t bufferSize, bool asynchronous);
+};
+
+BufferedWriteTestCase::BufferedWriteTestCase ()
+  : TestCase ("Check that buffered writes give the same file as unbuffered writes")
+{
+}
+
+void
+BufferedWriteTestCase::WriteFile (std::string filename, uint32_t bufferSize, bool asynchronous)
+{
+  PcapFile f;
+  f.Open (filename, std::ios::out);
+  NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Open (" << filename << ", \"std::ios::out\") returns error");
+  f.SetBuffering (bufferSize, asynchronous);
+  f.Init (1, 1000);
+
+  uint8_t data[1500];
+  for (uint32_t i = 0; i < sizeof(data); ++i)
+    {
+      data[i] = i;
+    }
+  for (uint32_t i = 0; i < 2000; ++i)
+    {
+      uint32_t size = (i * 37) % sizeof(data);
+      if (i % 2)
+        {
+          f.Write (i, i % 1000000, data, size);
+        }
+      else
+        {
+          f.Write (i, i % 1000000, Create<Packet> (data, size));
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (f.Fail (), false, "Write must not fail");
+  f.Close ();
+}
+
+void
+BufferedWriteTestCase::DoRun (void)
+{
+  std::string plain = CreateTempDirFilename ("plain.pcap");
+  std::string buffered = CreateTempDirFilename ("buffered.pcap");
+  std::string async = CreateTempDirFilename ("async.pcap");
+
+  WriteFile (plain, 0, false);
+  WriteFile (buffered, 1, false);
+  WriteFile (async, 8192, true);
+
+  std::string expected = ReadFileContents (plain);
+  NS_TEST_ASSERT_MSG_GT (expected.size (), 24, "Unbuffered file is empty");
+  NS_TEST_EXPECT_MSG_EQ ((ReadFileContents (buffered) == expected), true,
+                         "Buffered file differs from unbuffered file");
+  NS_TEST_EXPECT_MSG_EQ ((ReadFileContents (async) == expected), true,
+                         "Asynchronous file differs from unbuffered file");
+}
+
+// ===========================================================================
+// Test case to make sure that pcapng files with several interfaces are
+// written and read back.
+// ===========================================================================
+class PcapNgTestCase : public TestCase
+{
+public:
+  PcapNgTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+PcapNgTestCase::PcapNgTestCase ()
+  : TestCase ("Check that PcapFile writes and reads pcapng files")
+{
+}
+
+void
+PcapNgTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("interfaces.pcapng");
+  uint8_t data[100];
+  for (uint32_t i = 0; i < sizeof(data); ++i)
+    {
+      data[i] = i;
+    }
+
+  PcapFile f;
+  f.Open (filename, std::ios::out);
+  NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Open (" << filename << ", \"std::ios::out\") returns error");
+  f.SetBuffering (4096, true);
+  f.InitPcapNg ();
+  NS_TEST_ASSERT_MSG_EQ (f.AddInterface (1, 65535, "first"), 0, "Unexpected interface id");
+  NS_TEST_ASSERT_MSG_EQ (f.AddInterface (105, 32, "second-interface"), 1, "Unexpected interface id");
+  for (uint32_t i = 0; i < 10; ++i)
+    {
+      f.Write (i, 10 * i, data, 50 + i, i % 2);
+    }
+  f.Write (10, 0, Create<Packet> (data, 40), 1);
+  NS_TEST_EXPECT_MSG_EQ (f.Fail (), false, "Write must not fail");
+  f.Close ();
+
+  f.Open (filename, std::ios::in);
+  NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Open (" << filename << ", \"std::ios::in\") returns error");
+  NS_TEST_EXPECT_MSG_EQ (f.IsPcapNg (), true, "File not recognized as pcapng");
+  NS_TEST_EXPECT_MSG_EQ (f.GetInterfaceCount (), 2, "Interfaces not read");
+  NS_TEST_EXPECT_MSG_EQ (f.GetDataLinkType (), 1, "Data link type of the first interface not reported");
+
+  uint8_t in[100];
+  uint32_t tsSec, tsUsec, inclLen, origLen, readLen;
+  for (uint32_t i = 0; i < 11; ++i)
+    {
+      uint32_t size = i < 10 ? 50 + i : 40;
+      uint32_t interface = i < 10 ? i % 2 : 1;
+      f.Read (in, sizeof(in), tsSec, tsUsec, inclLen, origLen, readLen);
+      NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Read() of pcapng file returns error");
+      NS_TEST_EXPECT_MSG_EQ (f.GetInterfaceId (), interface, "Incorrect interface");
+      NS_TEST_EXPECT_MSG_EQ (tsSec, i, "Incorrect seconds timestamp");
+      NS_TEST_EXPECT_MSG_EQ (tsUsec, (i < 10 ? 10 * i : 0), "Incorrect microseconds timestamp");
+      NS_TEST_EXPECT_MSG_EQ (origLen, size, "Incorrect original length");
+      NS_TEST_EXPECT_MSG_EQ (inclLen, (interface ? 32 : size), "Snapshot length not applied");
+      NS_TEST_EXPECT_MSG_EQ (readLen, inclLen, "Incorrect read length");
+      NS_TEST_EXPECT_MSG_EQ (std::memcmp (in, data, readLen), 0, "Incorrect packet data");
+    }
+  f.Read (in, sizeof(in), tsSec, tsUsec, inclLen, origLen, readLen);
+  NS_TEST_EXPECT_MSG_EQ (f.Eof (), true, "Read() at end of pcapng file does not return error");
+  f.Close ();
+
+  uint32_t sec (0), usec (0), packets (0);
+  bool diff = PcapFile::Diff (filename, filename, sec, usec, packets);
+  NS_TEST_EXPECT_MSG_EQ (diff, false, "PcapDiff(file, file) must always be false");
+  NS_TEST_EXPECT_MSG_EQ (packets, 11, "PcapDiff did not read every packet");
+}
+
+// ===========================================================================
+// Test case to make sure that PcapFileWrapper objects can share a single
+// pcapng file.
+// ===========================================================================
+class SingleFileTestCase : public TestCase
+{
+public:
+  SingleFileTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SingleFileTestCase::SingleFileTestCase ()
+  : TestCase ("Check that PcapFileWrapper objects share a single pcapng file")
+{
+}
+
+void
+SingleFileTestCase::DoRun (void)
+{
+  std::string shared = CreateTempDirFilename ("shared.pcapng");
+  std::string first = CreateTempDirFilename ("device-0-1.pcap");
+  std::string second = CreateTempDirFilename ("device-1-1.pcap");
+
+  Ptr<PcapFileWrapper> a = CreateObject<PcapFileWrapper> ();
+  Ptr<PcapFileWrapper> b = CreateObject<PcapFileWrapper> ();
+  a->SetAttribute ("SingleFile", StringValue (shared));
+  b->SetAttribute ("SingleFile", StringValue (shared));
+  a->Open (first, std::ios::out);
+  b->Open (second, std::ios::out);
+  NS_TEST_ASSERT_MSG_EQ (a->Fail () || b->Fail (), false, "Open of shared file returns error");
+  a->Init (1);
+  b->Init (9);
+
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      Ptr<PcapFileWrapper> w = i % 2 ? b : a;
+      w->Write (MilliSeconds (i), Create<Packet> (10 + i));
+    }
+  a = 0;
+  b = 0;
+  NS_TEST_EXPECT_MSG_EQ (CheckFileExists (first), false, "Per-device file created");
+
+  PcapFile f;
+  f.Open (shared, std::ios::in);
+  NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Open (" << shared << ", \"std::ios::in\") returns error");
+  NS_TEST_EXPECT_MSG_EQ (f.GetInterfaceCount (), 2, "One interface per wrapper expected");
+  uint8_t in[100];
+  uint32_t tsSec, tsUsec, inclLen, origLen, readLen;
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      f.Read (in, sizeof(in), tsSec, tsUsec, inclLen, origLen, readLen);
+      NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Read() of shared file returns error");
+      NS_TEST_EXPECT_MSG_EQ (f.GetInterfaceId (), i % 2, "Incorrect interface");
+      NS_TEST_EXPECT_MSG_EQ (tsUsec, 1000 * i, "Incorrect timestamp");
+      NS_TEST_EXPECT_MSG_EQ (origLen, 10 + i, "Incorrect packet length");
+    }
+  f.Close ();
+}
+
 class PcapFileTestSuite : public TestSuite
 {
 public:
@@ -1138,6 +1362,9 @@ PcapFileTestSuite::PcapFileTestSuite ()
   AddTestCase (new RecordHeaderTestCase, TestCase::QUICK);
   AddTestCase (new ReadFileTestCase, TestCase::QUICK);
   AddTestCase (new DiffTestCase, TestCase::QUICK);
+  AddTestCase (new BufferedWriteTestCase, TestCase::QUICK);
+  AddTestCase (new PcapNgTestCase, TestCase::QUICK);
+  AddTestCase (new SingleFileTestCase, TestCase::QUICK);
 }
 
 static PcapFileTestSuite pcapFileTestSuite;
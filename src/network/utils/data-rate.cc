@@ -19,6 +19,8 @@
 //
 
 #include "data-rate.h"
+#include "ns3/core-config.h"
+#include "ns3/assert.h"
 #include "ns3/nstime.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
@@ -188,12 +190,122 @@ DataRate::DataRate ()
   : m_bps (0)
 {
   NS_LOG_FUNCTION (this);
+  UpdateByteTime ();
 }
 
 DataRate::DataRate(uint64_t bps)
   : m_bps (bps)
 {
   NS_LOG_FUNCTION (this << bps);
+  UpdateByteTime ();
+}
+
+/**
+ * \param [in] a A number.
+ * \param [in] b A number smaller than c.
+ * \param [in] c The divisor.
+ * \returns a * b / c, rounded down, computed without overflow.
+ */
+static uint64_t
+MulDiv (uint64_t a, uint64_t b, uint64_t c)
+{
+  NS_ASSERT (b < c);
+#ifdef HAVE___UINT128_T
+  return static_cast<uint64_t> (static_cast<__uint128_t> (a) * b / c);
+#else
+  // 128-bit product from 32-bit halves, then long division: the
+  // quotient is smaller than a, so it fits in 64 bits.
+  uint64_t aLo = a & 0xffffffff;
+  uint64_t aHi = a >> 32;
+  uint64_t bLo = b & 0xffffffff;
+  uint64_t bHi = b >> 32;
+  uint64_t mid1 = aHi * bLo;
+  uint64_t mid2 = aLo * bHi;
+  uint64_t lo = aLo * bLo;
+  uint64_t hi = aHi * bHi + (mid1 >> 32) + (mid2 >> 32);
+  uint64_t sum = lo + (mid1 << 32);
+  hi += (sum < lo);
+  lo = sum + (mid2 << 32);
+  hi += (lo < sum);
+  uint64_t quotient = 0;
+  uint64_t remainder = hi;
+  for (int i = 63; i >= 0; --i)
+    {
+      bool carry = (remainder >> 63) != 0;
+      remainder = (remainder << 1) | ((lo >> i) & 1);
+      quotient <<= 1;
+      if (carry || remainder >= c)
+        {
+          remainder -= c;
+          quotient |= 1;
+        }
+    }
+  return quotient;
+#endif
+}
+
+/**
+ * \param [in] n A number of bits or bytes.
+ * \param [in] quotient The integer part of the time of one bit or byte.
+ * \param [in] remainder The fractional part of the time of one bit or
+ *             byte, times the rate.
+ * \param [in] bps The rate.
+ * \returns n * (quotient + remainder / bps), rounded down, or -1 if
+ *          it does not fit in an int64_t.
+ */
+static int64_t
+ScaleSteps (uint32_t n, int64_t quotient, uint64_t remainder, uint64_t bps)
+{
+  uint64_t fraction;
+  if (remainder <= 0xffffffffULL)
+    {
+      fraction = (n * remainder) / bps;
+    }
+  else
+    {
+      fraction = MulDiv (n, remainder, bps);
+    }
+  if (n != 0 && quotient > static_cast<int64_t> (0x7fffffffffffffffLL - fraction) / n)
+    {
+      return -1;
+    }
+  return n * quotient + fraction;
+}
+
+void
+DataRate::UpdateByteTime (void) const
+{
+  m_stepsPerByte = -1;
+  m_stepsPerByteRem = 0;
+  m_resolution = Time::GetResolution ();
+  for (uint32_t i = 0; i < TX_TIME_CACHE_SIZE; i++)
+    {
+      // a valid entry: zero bytes take no time at any rate.
+      m_txTimeCache[i].bytes = 0;
+      m_txTimeCache[i].steps = 0;
+    }
+  switch (m_resolution)
+    {
+    case Time::S:  m_stepsPerSecond = 1; break;
+    case Time::MS: m_stepsPerSecond = 1000; break;
+    case Time::US: m_stepsPerSecond = 1000000; break;
+    case Time::NS: m_stepsPerSecond = 1000000000; break;
+    case Time::PS: m_stepsPerSecond = 1000000000000ULL; break;
+    case Time::FS: m_stepsPerSecond = 1000000000000000ULL; break;
+    default:       m_stepsPerSecond = 0; return;
+    }
+  if (m_bps == 0)
+    {
+      return;
+    }
+  m_stepsPerByte = (8 * m_stepsPerSecond) / m_bps;
+  m_stepsPerByteRem = (8 * m_stepsPerSecond) % m_bps;
+}
+
+int64_t
+DataRate::CalculateBytesTxSteps (uint32_t bytes) const
+{
+  return ScaleSteps (bytes, m_stepsPerByte, m_stepsPerByteRem, m_bps);
 }
 
 bool DataRate::operator < (const DataRate& rhs) const
@@ -235,14 +347,46 @@ double DataRate::CalculateTxTime (uint32_t bytes) const
 Time DataRate::CalculateBytesTxTime (uint32_t bytes) const
 {
   NS_LOG_FUNCTION (this << bytes);
-  // \todo avoid to use double (if possible).
+  if (m_resolution != Time::GetResolution ())
+    {
+      UpdateByteTime ();
+    }
+  if (m_stepsPerByte >= 0)
+    {
+      // Fibonacci hashing: the top bits spread the common frame sizes.
+      uint32_t index = (bytes * 2654435761U) >> 30;
+      struct TxTimeCacheEntry &entry = m_txTimeCache[index % TX_TIME_CACHE_SIZE];
+      if (entry.bytes != bytes)
+        {
+          entry.bytes = bytes;
+          entry.steps = CalculateBytesTxSteps (bytes);
+        }
+      if (entry.steps >= 0)
+        {
+          return TimeStep (entry.steps);
+        }
+    }
+  // zero rate, unusual resolution, or overflow.
   return Seconds (static_cast<double>(bytes)*8/m_bps);
 }
 
 Time DataRate::CalculateBitsTxTime (uint32_t bits) const
 {
   NS_LOG_FUNCTION (this << bits);
-  // \todo avoid to use double (if possible).
+  if (m_resolution != Time::GetResolution ())
+    {
+      UpdateByteTime ();
+    }
+  if (m_stepsPerByte >= 0)
+    {
+      int64_t steps = ScaleSteps (bits, m_stepsPerSecond / m_bps,
+                                  m_stepsPerSecond % m_bps, m_bps);
+      if (steps >= 0)
+        {
+          return TimeStep (steps);
+        }
+    }
+  // zero rate, unusual resolution, or overflow.
   return Seconds (static_cast<double>(bits)/m_bps);
 }
 
@@ -260,6 +404,7 @@ DataRate::DataRate (std::string rate)
     {
       NS_FATAL_ERROR ("Could not parse rate: "<<rate);
     }
+  UpdateByteTime ();
 }
 
 /* For printing of data rate */
@@ -163,7 +163,9 @@ public:
   /**
    * \brief Calculate transmission time
    *
-   * Calculates the transmission time at this data rate
+   * Calculates the transmission time at this data rate, rounded down
+   * to the Time resolution. The computation is exact integer
+   * arithmetic, and the times of the last few frame sizes are cached.
    * \param bytes The number of bytes (not bits) for which to calculate
    * \return The transmission time for the number of bytes specified
    */
@@ -172,7 +174,8 @@ public:
   /**
    * \brief Calculate transmission time
    *
-   * Calculates the transmission time at this data rate
+   * Calculates the transmission time at this data rate, rounded down
+   * to the Time resolution.
    * \param bits The number of bits (not bytes) for which to calculate
    * \return The transmission time for the number of bits specified
    */
@@ -214,10 +217,47 @@ private:
    */
   static bool DoParse (const std::string s, uint64_t *v);
 
+  /**
+   * Precompute the transmission time of one byte in Time steps,
+   * used by CalculateBytesTxTime() and CalculateBitsTxTime(),
+   * and clear the transmission time cache.
+   *
+   * This only updates the cached fields, which depend on the rate and
+   * on the current Time resolution, so it is const.
+   */
+  void UpdateByteTime (void) const;
+
+  /**
+   * \param [in] bytes A number of bytes.
+   * \returns the transmission time of bytes in Time steps at m_resolution,
+   * rounded down, or -1 if it does not fit in a Time.
+   */
+  int64_t CalculateBytesTxSteps (uint32_t bytes) const;
+
+  /** Number of entries of the transmission time cache. */
+  static const uint32_t TX_TIME_CACHE_SIZE = 4;
+  /** A transmission time cache entry. */
+  struct TxTimeCacheEntry
+  {
+    uint32_t bytes; //!< Frame size
+    int64_t steps;  //!< Transmission time of bytes, in Time steps
+  };
+
   // Uses DoParse
   friend std::istream &operator >> (std::istream &is, DataRate &rate);
   
   uint64_t m_bps; //!< data rate [bps]
+  /**
+   * Transmission time of one byte, in Time steps at m_resolution, is
+   * m_stepsPerByte + m_stepsPerByteRem / m_bps.  m_stepsPerByte is -1
+   * if the rate is zero or the resolution is not supported.
+   */
+  mutable int64_t m_stepsPerByte;
+  mutable uint64_t m_stepsPerByteRem; //!< Remainder of the transmission time of one byte
+  mutable uint64_t m_stepsPerSecond;  //!< Number of Time steps in a second at m_resolution
+  mutable Time::Unit m_resolution;    //!< Time resolution of m_stepsPerByte
+  /** Transmission times of recent frame sizes, indexed by size. */
+  mutable struct TxTimeCacheEntry m_txTimeCache[TX_TIME_CACHE_SIZE];
 };
 
 /**
@@ -71,6 +71,7 @@
 #include "ns3/enum.h"
 #include "ns3/double.h"
 #include "ns3/string.h"
+#include "ns3/uinteger.h"
 #include "ns3/pointer.h"
 
 namespace ns3 {
@@ -168,12 +169,20 @@ TypeId RateErrorModel::GetTypeId (void)
                    StringValue ("ns3::UniformRandomVariable[Min=0.0|Max=1.0]"),
                    MakePointerAccessor (&RateErrorModel::m_ranvar),
                    MakePointerChecker<RandomVariableStream> ())
+    .AddAttribute ("BufferSize",
+                   "The number of decision variates drawn at once from RanVar; "
+                   "0 draws one variate per packet.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&RateErrorModel::m_bufferSize),
+                   MakeUintegerChecker<uint32_t> ())
   ;
   return tid;
 }
 
 
 RateErrorModel::RateErrorModel ()
+  : m_bufferPos (0),
+    m_bufferSource (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -223,9 +232,30 @@ RateErrorModel::AssignStreams (int64_t stream)
 {
   NS_LOG_FUNCTION (this << stream);
   m_ranvar->SetStream (stream);
+  m_buffer.clear ();
+  m_bufferPos = 0;
   return 1;
 }
 
+double
+RateErrorModel::GetDecisionValue (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_bufferPos < m_buffer.size () && m_bufferSource == PeekPointer (m_ranvar))
+    {
+      return m_buffer[m_bufferPos++];
+    }
+  if (m_bufferSize == 0)
+    {
+      return m_ranvar->GetValue ();
+    }
+  m_buffer.resize (m_bufferSize);
+  m_ranvar->GetValues (&m_buffer[0], m_bufferSize);
+  m_bufferSource = PeekPointer (m_ranvar);
+  m_bufferPos = 1;
+  return m_buffer[0];
+}
+
 bool 
 RateErrorModel::DoCorrupt (Ptr<Packet> p) 
 { 
@@ -253,7 +283,7 @@ bool
 RateErrorModel::DoCorruptPkt (Ptr<Packet> p)
 {
   NS_LOG_FUNCTION (this << p);
-  return (m_ranvar->GetValue () < m_rate);
+  return (GetDecisionValue () < m_rate);
 }
 
 bool
@@ -262,7 +292,7 @@ RateErrorModel::DoCorruptByte (Ptr<Packet> p)
   NS_LOG_FUNCTION (this << p);
   // compute pkt error rate, assume uniformly distributed byte error
   double per = 1 - std::pow (1.0 - m_rate, static_cast<double> (p->GetSize ()));
-  return (m_ranvar->GetValue () < per);
+  return (GetDecisionValue () < per);
 }
 
 bool
@@ -271,7 +301,7 @@ RateErrorModel::DoCorruptBit (Ptr<Packet> p)
   NS_LOG_FUNCTION (this << p);
   // compute pkt error rate, assume uniformly distributed bit error
   double per = 1 - std::pow (1.0 - m_rate, static_cast<double> (8 * p->GetSize ()) );
-  return (m_ranvar->GetValue () < per);
+  return (GetDecisionValue () < per);
 }
 
 void 
@@ -64,6 +64,7 @@
 #define ERROR_MODEL_H
 
 #include <list>
+#include <vector>
 #include "ns3/object.h"
 #include "ns3/random-variable-stream.h"
 
@@ -174,6 +175,12 @@ private:
  * unit (which may be per-bit, per-byte, and per-packet).
  * Users can optionally provide a RandomVariableStream object; the default
  * is to use a Uniform(0,1) distribution.
+ *
+ * When the \c BufferSize attribute is non-zero, the decision variates are
+ * drawn from the random variable in blocks of that size, with
+ * RandomVariableStream::GetValues().  The decisions are the same as
+ * without buffering, as long as the random variable is not used
+ * elsewhere nor reconfigured while values are buffered.
 
  * Reset() on this model will do nothing
  *
@@ -255,11 +262,20 @@ private:
    */
   virtual bool DoCorruptBit (Ptr<Packet> p);
   virtual void DoReset (void);
+  /**
+   * Get the next decision variate, from the buffer if enabled.
+   * \returns the next value of the random variable
+   */
+  double GetDecisionValue (void);
 
   enum ErrorUnit m_unit; //!< Error rate unit
   double m_rate; //!< Error rate
 
   Ptr<RandomVariableStream> m_ranvar; //!< rng stream
+  uint32_t m_bufferSize; //!< Number of variates drawn at once, 0 to disable buffering
+  std::vector<double> m_buffer; //!< Variates drawn ahead of use
+  uint32_t m_bufferPos; //!< Index of the next unused value in m_buffer
+  RandomVariableStream *m_bufferSource; //!< Random variable m_buffer was drawn from
 };
 
 
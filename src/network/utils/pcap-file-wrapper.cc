@@ -16,8 +16,13 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <map>
 #include "ns3/log.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
+#include "ns3/simple-ref-count.h"
 #include "ns3/buffer.h"
 #include "ns3/header.h"
 #include "pcap-file-wrapper.h"
@@ -28,6 +33,82 @@ NS_LOG_COMPONENT_DEFINE ("PcapFileWrapper");
 
 NS_OBJECT_ENSURE_REGISTERED (PcapFileWrapper);
 
+/**
+ * \ingroup network
+ * A pcapng file written by several PcapFileWrapper objects, each on its
+ * own interface.  The file is closed when the last wrapper releases it.
+ */
+class PcapSharedFile : public SimpleRefCount<PcapSharedFile>
+{
+public:
+  /**
+   * Get the shared file with the given name, creating it if needed.
+   * \param filename the file name
+   * \param bufferSize the size of the write buffers, when creating it
+   * \param asynchronous whether to write from a background thread, when
+   * creating it
+   * \returns the shared file
+   */
+  static Ptr<PcapSharedFile> Get (std::string filename,
+                                  uint32_t bufferSize, bool asynchronous);
+  /**
+   * Register a shared file; use Get() instead.
+   * \param filename the file name
+   */
+  PcapSharedFile (std::string filename);
+  /** Close the file. */
+  ~PcapSharedFile ();
+
+  PcapFile m_file;          //!< the file
+private:
+  /** Map of open shared files, by name. */
+  typedef std::map<std::string, PcapSharedFile *> Files;
+  /** \returns the open shared files */
+  static Files & GetFiles (void);
+
+  std::string m_filename;   //!< the file name
+};
+
+PcapSharedFile::Files &
+PcapSharedFile::GetFiles (void)
+{
+  static Files files;
+  return files;
+}
+
+Ptr<PcapSharedFile>
+PcapSharedFile::Get (std::string filename, uint32_t bufferSize, bool asynchronous)
+{
+  NS_LOG_FUNCTION (filename << bufferSize << asynchronous);
+  Files::iterator i = GetFiles ().find (filename);
+  if (i != GetFiles ().end ())
+    {
+      return Ptr<PcapSharedFile> (i->second);
+    }
+  Ptr<PcapSharedFile> file = Create<PcapSharedFile> (filename);
+  file->m_file.Open (filename, std::ios::out);
+  if (!file->m_file.Fail ())
+    {
+      file->m_file.SetBuffering (bufferSize, asynchronous);
+      file->m_file.InitPcapNg ();
+    }
+  return file;
+}
+
+PcapSharedFile::PcapSharedFile (std::string filename)
+  : m_filename (filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  GetFiles ()[filename] = this;
+}
+
+PcapSharedFile::~PcapSharedFile ()
+{
+  NS_LOG_FUNCTION (this);
+  GetFiles ().erase (m_filename);
+  m_file.Close ();
+}
+
 TypeId 
 PcapFileWrapper::GetTypeId (void)
 {
@@ -40,12 +121,36 @@ PcapFileWrapper::GetTypeId (void)
                    UintegerValue (PcapFile::SNAPLEN_DEFAULT),
                    MakeUintegerAccessor (&PcapFileWrapper::m_snapLen),
                    MakeUintegerChecker<uint32_t> (0, PcapFile::SNAPLEN_DEFAULT))
+    .AddAttribute ("BufferSize",
+                   "Size of the write buffers of output files, "
+                   "or 0 to write every packet as it is captured",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&PcapFileWrapper::m_bufferSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Asynchronous",
+                   "Write the write buffers from a background thread",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PcapFileWrapper::m_asynchronous),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Format",
+                   "Format of output files",
+                   EnumValue (PCAP),
+                   MakeEnumAccessor (&PcapFileWrapper::m_format),
+                   MakeEnumChecker (PCAP, "Pcap",
+                                    PCAPNG, "PcapNg"))
+    .AddAttribute ("SingleFile",
+                   "If not empty, the name of a pcapng file written "
+                   "instead of every output file, with one interface per file",
+                   StringValue (""),
+                   MakeStringAccessor (&PcapFileWrapper::m_singleFile),
+                   MakeStringChecker ())
   ;
   return tid;
 }
 
 
 PcapFileWrapper::PcapFileWrapper ()
+  : m_interface (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -57,29 +162,42 @@ PcapFileWrapper::~PcapFileWrapper ()
 }
 
 
+PcapFile &
+PcapFileWrapper::GetFile (void)
+{
+  return m_shared ? m_shared->m_file : m_file;
+}
+
+const PcapFile &
+PcapFileWrapper::GetFile (void) const
+{
+  return m_shared ? m_shared->m_file : m_file;
+}
+
 bool 
 PcapFileWrapper::Fail (void) const
 {
   NS_LOG_FUNCTION (this);
-  return m_file.Fail ();
+  return GetFile ().Fail ();
 }
 bool 
 PcapFileWrapper::Eof (void) const
 {
   NS_LOG_FUNCTION (this);
-  return m_file.Eof ();
+  return GetFile ().Eof ();
 }
 void 
 PcapFileWrapper::Clear (void)
 {
   NS_LOG_FUNCTION (this);
-  m_file.Clear ();
+  GetFile ().Clear ();
 }
 
 void
 PcapFileWrapper::Close (void)
 {
   NS_LOG_FUNCTION (this);
+  m_shared = 0;
   m_file.Close ();
 }
 
@@ -87,7 +205,17 @@ void
 PcapFileWrapper::Open (std::string const &filename, std::ios::openmode mode)
 {
   NS_LOG_FUNCTION (this << filename << mode);
+  m_filename = filename;
+  if ((mode & std::ios::out) && !m_singleFile.empty ())
+    {
+      m_shared = PcapSharedFile::Get (m_singleFile, m_bufferSize, m_asynchronous);
+      return;
+    }
   m_file.Open (filename, mode);
+  if ((mode & std::ios::out) && !m_file.Fail ())
+    {
+      m_file.SetBuffering (m_bufferSize, m_asynchronous);
+    }
 }
 
 void
@@ -99,14 +227,23 @@ PcapFileWrapper::Init (uint32_t dataLinkType, uint32_t snapLen, int32_t tzCorrec
   // a snaplen, we use the one provided.
   //
   NS_LOG_FUNCTION (this << dataLinkType << snapLen << tzCorrection);
-  if (snapLen != std::numeric_limits<uint32_t>::max ())
+  if (snapLen == std::numeric_limits<uint32_t>::max ())
     {
-      m_file.Init (dataLinkType, snapLen, tzCorrection);
-    } 
+      snapLen = m_snapLen;
+    }
+  if (m_shared)
+    {
+      m_interface = m_shared->m_file.AddInterface (dataLinkType, snapLen, m_filename);
+    }
+  else if (m_format == PCAPNG)
+    {
+      m_file.InitPcapNg ();
+      m_interface = m_file.AddInterface (dataLinkType, snapLen, m_filename);
+    }
   else
     {
-      m_file.Init (dataLinkType, m_snapLen, tzCorrection);
-    } 
+      m_file.Init (dataLinkType, snapLen, tzCorrection);
+    }
 }
 
 void
@@ -117,7 +254,7 @@ PcapFileWrapper::Write (Time t, Ptr<const Packet> p)
   uint64_t s = current / 1000000;
   uint64_t us = current % 1000000;
 
-  m_file.Write (s, us, p);
+  GetFile ().Write (s, us, p, m_interface);
 }
 
 void
@@ -128,7 +265,7 @@ PcapFileWrapper::Write (Time t, const Header &header, Ptr<const Packet> p)
   uint64_t s = current / 1000000;
   uint64_t us = current % 1000000;
 
-  m_file.Write (s, us, header, p);
+  GetFile ().Write (s, us, header, p, m_interface);
 }
 
 void
@@ -139,56 +276,56 @@ PcapFileWrapper::Write (Time t, uint8_t const *buffer, uint32_t length)
   uint64_t s = current / 1000000;
   uint64_t us = current % 1000000;
 
-  m_file.Write (s, us, buffer, length);
+  GetFile ().Write (s, us, buffer, length, m_interface);
 }
 
 uint32_t
 PcapFileWrapper::GetMagic (void)
 {
   NS_LOG_FUNCTION (this);
-  return m_file.GetMagic ();
+  return GetFile ().GetMagic ();
 }
 
 uint16_t
 PcapFileWrapper::GetVersionMajor (void)
 {
   NS_LOG_FUNCTION (this);
-  return m_file.GetVersionMajor ();
+  return GetFile ().GetVersionMajor ();
 }
 
 uint16_t
 PcapFileWrapper::GetVersionMinor (void)
 {
   NS_LOG_FUNCTION (this);
-  return m_file.GetVersionMinor ();
+  return GetFile ().GetVersionMinor ();
 }
 
 int32_t
 PcapFileWrapper::GetTimeZoneOffset (void)
 {
   NS_LOG_FUNCTION (this);
-  return m_file.GetTimeZoneOffset ();
+  return GetFile ().GetTimeZoneOffset ();
 }
 
 uint32_t
 PcapFileWrapper::GetSigFigs (void)
 {
   NS_LOG_FUNCTION (this);
-  return m_file.GetSigFigs ();
+  return GetFile ().GetSigFigs ();
 }
 
 uint32_t
 PcapFileWrapper::GetSnapLen (void)
 {
   NS_LOG_FUNCTION (this);
-  return m_file.GetSnapLen ();
+  return GetFile ().GetSnapLen ();
 }
 
 uint32_t
 PcapFileWrapper::GetDataLinkType (void)
 {
   NS_LOG_FUNCTION (this);
-  return m_file.GetDataLinkType ();
+  return GetFile ().GetDataLinkType ();
 }
 
 } // namespace ns3
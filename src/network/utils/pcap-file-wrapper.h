@@ -30,11 +30,28 @@
 
 namespace ns3 {
 
+class PcapSharedFile;
+
 /**
  * A class that wraps a PcapFile as an ns3::Object and provides a higher-layer
  * ns-3 interface to the low-level public methods of PcapFile.  Users are
  * encouraged to use this object instead of class ns3::PcapFile in ns-3
  * public APIs.
+ *
+ * Attributes select how output files are written:
+ *  - "Format" writes pcapng files instead of pcap files;
+ *  - "SingleFile" writes the packets of every wrapper opened for output
+ *    to one pcapng file, each wrapper adding an interface named after the
+ *    file it would have written;
+ *  - "BufferSize" and "Asynchronous" gather records in large write
+ *    buffers, written by a background thread if requested (see
+ *    PcapFile::SetBuffering()).  Buffered data is written when the
+ *    wrapper is closed or destroyed.
+ *
+ * For example, to capture every device of a simulation in one file:
+ * \code
+ *   Config::SetDefault ("ns3::PcapFileWrapper::SingleFile", StringValue ("all.pcapng"));
+ * \endcode
  */
 class PcapFileWrapper : public Object
 {
@@ -45,6 +62,13 @@ public:
    */
   static TypeId GetTypeId (void);
 
+  /** Output file formats. */
+  enum Format
+  {
+    PCAP,     //!< classic pcap format
+    PCAPNG    //!< pcapng format
+  };
+
   PcapFileWrapper ();
   ~PcapFileWrapper ();
 
@@ -213,8 +237,25 @@ public:
   uint32_t GetDataLinkType (void);
 
 private:
+  /**
+   * \returns the file written or read: the shared file, if any
+   */
+  PcapFile & GetFile (void);
+
+  /**
+   * \returns the file written or read: the shared file, if any
+   */
+  const PcapFile & GetFile (void) const;
+
   PcapFile m_file; //!< Pcap file
   uint32_t m_snapLen; //!< max length of saved packets
+  uint32_t m_bufferSize; //!< size of the write buffers
+  bool m_asynchronous; //!< whether write buffers are written by a background thread
+  enum Format m_format; //!< output file format
+  std::string m_singleFile; //!< name of the file shared by all the wrappers, if any
+  std::string m_filename; //!< name of the file opened
+  Ptr<PcapSharedFile> m_shared; //!< shared file, if any
+  uint32_t m_interface; //!< pcapng interface of the packets written
 };
 
 } // namespace ns3
@@ -20,6 +20,7 @@
 
 #include <iostream>
 #include <cstring>
+#include <deque>
 #include "ns3/assert.h"
 #include "ns3/packet.h"
 #include "ns3/fatal-error.h"
@@ -29,6 +30,11 @@
 #include "pcap-file.h"
 #include "ns3/log.h"
 #include "ns3/build-profile.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#include <pthread.h>
+#endif
 //
 // This file is used as part of the ns-3 test framework, so please refrain from 
 // adding any ns-3 specific constructs such as Packet to this file.
@@ -47,9 +53,229 @@ const uint32_t NS_SWAPPED_MAGIC = 0xd43cb2a1; /**< Looks this way if byte swappi
 const uint16_t VERSION_MAJOR = 2;             /**< Major version of supported pcap file format */
 const uint16_t VERSION_MINOR = 4;             /**< Minor version of supported pcap file format */
 
+const uint32_t NG_SECTION_HEADER = 0x0a0d0d0a;   /**< pcapng section header block type */
+const uint32_t NG_INTERFACE = 0x00000001;        /**< pcapng interface description block type */
+const uint32_t NG_ENHANCED_PACKET = 0x00000006;  /**< pcapng enhanced packet block type */
+const uint32_t NG_BYTE_ORDER = 0x1a2b3c4d;       /**< pcapng byte order magic */
+const uint32_t NG_SWAPPED_BYTE_ORDER = 0x4d3c2b1a; /**< Looks this way if byte swapping is required */
+const uint16_t NG_VERSION_MAJOR = 1;             /**< Major version of supported pcapng format */
+const uint16_t NG_VERSION_MINOR = 0;             /**< Minor version of supported pcapng format */
+const uint16_t NG_OPT_ENDOFOPT = 0;              /**< pcapng end of options option code */
+const uint16_t NG_OPT_IF_NAME = 2;               /**< pcapng interface name option code */
+const uint16_t NG_OPT_IF_TSRESOL = 9;            /**< pcapng timestamp resolution option code */
+const uint32_t NG_PACKET_OVERHEAD = 32;          /**< Size of an enhanced packet block without data */
+const uint32_t MAX_WRITE_BUFFERS = 4;            /**< Write buffers used by the asynchronous writer */
+
+/**
+ * \param size a block length
+ * \returns the length padded to 32 bits, as pcapng blocks and options are
+ */
+static uint32_t
+PadLength (uint32_t size)
+{
+  return (size + 3) & ~3U;
+}
+
+#ifdef HAVE_PTHREAD_H
+/**
+ * \ingroup network
+ * Write full write buffers to a file from a background thread.
+ *
+ * The writer owns a small pool of write buffers: the producer hands over
+ * a full buffer with Exchange() and gets an empty one back, waiting only
+ * when every buffer is still queued for writing.
+ *
+ * The waits use pthread conditions directly: SystemCondition::Wait()
+ * clears its flag before waiting, so it misses a signal sent between
+ * the test of the queues and the wait.  Here the queues are the
+ * predicate, tested under the mutex of the condition.
+ */
+class PcapAsyncWriter
+{
+public:
+  /**
+   * Start the writer thread.
+   * \param file the file to write to
+   * \param bufferSize the size of the write buffers
+   */
+  PcapAsyncWriter (std::ostream *file, uint32_t bufferSize);
+  /** Write the queued buffers, then stop the writer thread. */
+  ~PcapAsyncWriter ();
+  /**
+   * Queue a full buffer for writing.
+   * \param buffer the buffer
+   * \param size the number of bytes to write
+   * \returns an empty buffer
+   */
+  char * Exchange (char *buffer, uint32_t size);
+  /** Wait until all the queued buffers are written. */
+  void Drain (void);
+  /** \returns true if writing failed */
+  bool Fail (void);
+private:
+  /** The writer thread body. */
+  void Run (void);
+  /** A buffer queued for writing. */
+  struct Chunk
+  {
+    char *m_data;     //!< buffer
+    uint32_t m_size;  //!< bytes to write
+  };
+  std::ostream *m_file;          //!< file to write to
+  uint32_t m_bufferSize;         //!< size of the write buffers
+  std::deque<Chunk> m_full;      //!< buffers queued for writing
+  std::vector<char *> m_free;    //!< empty buffers
+  uint32_t m_allocated;          //!< number of buffers allocated
+  bool m_busy;                   //!< whether a buffer is being written
+  bool m_stop;                   //!< whether the writer thread must stop
+  bool m_fail;                   //!< whether writing failed
+  pthread_mutex_t m_mutex;       //!< protects the fields above
+  pthread_cond_t m_work;         //!< signaled when a buffer is queued
+  pthread_cond_t m_done;         //!< signaled when a buffer is written
+  Ptr<SystemThread> m_thread;    //!< the writer thread
+};
+
+PcapAsyncWriter::PcapAsyncWriter (std::ostream *file, uint32_t bufferSize)
+  : m_file (file),
+    m_bufferSize (bufferSize),
+    m_allocated (1),
+    m_busy (false),
+    m_stop (false),
+    m_fail (false)
+{
+  NS_LOG_FUNCTION (this << file << bufferSize);
+  pthread_mutex_init (&m_mutex, NULL);
+  pthread_cond_init (&m_work, NULL);
+  pthread_cond_init (&m_done, NULL);
+  m_thread = Create<SystemThread> (MakeCallback (&PcapAsyncWriter::Run, this));
+  m_thread->Start ();
+}
+
+PcapAsyncWriter::~PcapAsyncWriter ()
+{
+  NS_LOG_FUNCTION (this);
+  pthread_mutex_lock (&m_mutex);
+  m_stop = true;
+  pthread_cond_signal (&m_work);
+  pthread_mutex_unlock (&m_mutex);
+  m_thread->Join ();
+  for (std::vector<char *>::iterator i = m_free.begin (); i != m_free.end (); ++i)
+    {
+      delete [] *i;
+    }
+  pthread_cond_destroy (&m_done);
+  pthread_cond_destroy (&m_work);
+  pthread_mutex_destroy (&m_mutex);
+}
+
+char *
+PcapAsyncWriter::Exchange (char *buffer, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  Chunk chunk;
+  chunk.m_data = buffer;
+  chunk.m_size = size;
+  pthread_mutex_lock (&m_mutex);
+  m_full.push_back (chunk);
+  pthread_cond_signal (&m_work);
+  while (m_free.empty () && m_allocated == MAX_WRITE_BUFFERS)
+    {
+      pthread_cond_wait (&m_done, &m_mutex);
+    }
+  char *empty;
+  if (!m_free.empty ())
+    {
+      empty = m_free.back ();
+      m_free.pop_back ();
+    }
+  else
+    {
+      ++m_allocated;
+      empty = new char [m_bufferSize];
+    }
+  pthread_mutex_unlock (&m_mutex);
+  return empty;
+}
+
+void
+PcapAsyncWriter::Drain (void)
+{
+  NS_LOG_FUNCTION (this);
+  pthread_mutex_lock (&m_mutex);
+  while (!m_full.empty () || m_busy)
+    {
+      pthread_cond_wait (&m_done, &m_mutex);
+    }
+  pthread_mutex_unlock (&m_mutex);
+}
+
+bool
+PcapAsyncWriter::Fail (void)
+{
+  pthread_mutex_lock (&m_mutex);
+  bool fail = m_fail;
+  pthread_mutex_unlock (&m_mutex);
+  return fail;
+}
+
+void
+PcapAsyncWriter::Run (void)
+{
+  // No logging here: log output is not synchronized across threads.
+  pthread_mutex_lock (&m_mutex);
+  while (true)
+    {
+      while (m_full.empty () && !m_stop)
+        {
+          pthread_cond_wait (&m_work, &m_mutex);
+        }
+      if (m_full.empty ())
+        {
+          break;
+        }
+      Chunk chunk = m_full.front ();
+      m_full.pop_front ();
+      m_busy = true;
+      pthread_mutex_unlock (&m_mutex);
+      m_file->write (chunk.m_data, chunk.m_size);
+      pthread_mutex_lock (&m_mutex);
+      m_fail = m_fail || m_file->fail ();
+      m_free.push_back (chunk.m_data);
+      m_busy = false;
+      pthread_cond_broadcast (&m_done);
+    }
+  pthread_mutex_unlock (&m_mutex);
+}
+
+#else /* HAVE_PTHREAD_H */
+
+/**
+ * \ingroup network
+ * Placeholder for the background writer, when threads are not available:
+ * write buffers are then written synchronously.
+ */
+class PcapAsyncWriter
+{
+public:
+  /** \returns an empty buffer */
+  char * Exchange (char *, uint32_t) { return 0; }
+  /** Nothing to wait for. */
+  void Drain (void) {}
+  /** \returns false */
+  bool Fail (void) { return false; }
+};
+
+#endif /* HAVE_PTHREAD_H */
+
 PcapFile::PcapFile ()
   : m_file (),
-    m_swapMode (false)
+    m_swapMode (false),
+    m_pcapNg (false),
+    m_interfaceId (0),
+    m_buffer (0),
+    m_bufferSize (0),
+    m_bufferUsed (0),
+    m_writer (0)
 {
   NS_LOG_FUNCTION (this);
   FatalImpl::RegisterStream (&m_file);
@@ -67,6 +293,11 @@ bool
 PcapFile::Fail (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_writer != 0)
+    {
+      // The writer thread owns the stream state.
+      return m_writer->Fail ();
+    }
   return m_file.fail ();
 }
 bool 
@@ -87,7 +318,122 @@ void
 PcapFile::Close (void)
 {
   NS_LOG_FUNCTION (this);
+  StopBuffering ();
   m_file.close ();
+  m_pcapNg = false;
+  m_interfaces.clear ();
+}
+
+void
+PcapFile::SetBuffering (uint32_t bufferSize, bool asynchronous)
+{
+  NS_LOG_FUNCTION (this << bufferSize << asynchronous);
+  StopBuffering ();
+  if (bufferSize == 0)
+    {
+      return;
+    }
+  m_bufferSize = (bufferSize + BUFFER_ALIGNMENT - 1) / BUFFER_ALIGNMENT * BUFFER_ALIGNMENT;
+  m_buffer = new char [m_bufferSize];
+  m_bufferUsed = 0;
+#ifdef HAVE_PTHREAD_H
+  if (asynchronous)
+    {
+      m_writer = new PcapAsyncWriter (&m_file, m_bufferSize);
+    }
+#endif
+}
+
+void
+PcapFile::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  FlushBuffer ();
+  if (m_writer != 0)
+    {
+      m_writer->Drain ();
+    }
+  m_file.flush ();
+}
+
+void
+PcapFile::FlushBuffer (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_bufferUsed == 0)
+    {
+      return;
+    }
+  if (m_writer != 0)
+    {
+      m_buffer = m_writer->Exchange (m_buffer, m_bufferUsed);
+    }
+  else
+    {
+      m_file.write (m_buffer, m_bufferUsed);
+    }
+  m_bufferUsed = 0;
+}
+
+void
+PcapFile::StopBuffering (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_buffer == 0)
+    {
+      return;
+    }
+  FlushBuffer ();
+  delete m_writer;
+  m_writer = 0;
+  delete [] m_buffer;
+  m_buffer = 0;
+  m_bufferSize = 0;
+  m_file.flush ();
+}
+
+void
+PcapFile::Append (void const *data, uint32_t size)
+{
+  if (m_buffer == 0)
+    {
+      m_file.write ((const char *)data, size);
+      return;
+    }
+  const char *from = (const char *)data;
+  while (size > 0)
+    {
+      uint32_t n = std::min (size, m_bufferSize - m_bufferUsed);
+      std::memcpy (m_buffer + m_bufferUsed, from, n);
+      m_bufferUsed += n;
+      from += n;
+      size -= n;
+      if (m_bufferUsed == m_bufferSize)
+        {
+          FlushBuffer ();
+        }
+    }
+}
+
+void
+PcapFile::AppendPacket (Ptr<const Packet> p, uint32_t size)
+{
+  if (m_buffer == 0)
+    {
+      p->CopyData (&m_file, size);
+    }
+  else if (size <= m_bufferSize - m_bufferUsed)
+    {
+      // Only the first size bytes of the packet are serialized.
+      p->CopyData ((uint8_t *)m_buffer + m_bufferUsed, size);
+      m_bufferUsed += size;
+    }
+  else if (size > 0)
+    {
+      m_scratch.resize (size);
+      p->CopyData (&m_scratch[0], size);
+      Append (&m_scratch[0], size);
+    }
 }
 
 uint32_t
@@ -139,6 +485,27 @@ PcapFile::GetDataLinkType (void)
   return m_fileHeader.m_type;
 }
 
+bool
+PcapFile::IsPcapNg (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_pcapNg;
+}
+
+uint32_t
+PcapFile::GetInterfaceCount (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_pcapNg ? m_interfaces.size () : 1;
+}
+
+uint32_t
+PcapFile::GetInterfaceId (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_interfaceId;
+}
+
 bool
 PcapFile::GetSwapMode (void)
 {
@@ -196,9 +563,12 @@ PcapFile::WriteFileHeader (void)
   NS_LOG_FUNCTION (this);
   //
   // If we're initializing the file, we need to write the pcap file header
-  // at the start of the file.
+  // at the start of the file.  When buffering, nothing has been written yet.
   //
-  m_file.seekp (0, std::ios::beg);
+  if (m_buffer == 0)
+    {
+      m_file.seekp (0, std::ios::beg);
+    }
  
   //
   // We have the ability to write out the pcap file header in a foreign endian
@@ -226,13 +596,13 @@ PcapFile::WriteFileHeader (void)
   // Watch out for memory alignment differences between machines, so write
   // them all individually.
   //
-  m_file.write ((const char *)&headerOut->m_magicNumber, sizeof(headerOut->m_magicNumber));
-  m_file.write ((const char *)&headerOut->m_versionMajor, sizeof(headerOut->m_versionMajor));
-  m_file.write ((const char *)&headerOut->m_versionMinor, sizeof(headerOut->m_versionMinor));
-  m_file.write ((const char *)&headerOut->m_zone, sizeof(headerOut->m_zone));
-  m_file.write ((const char *)&headerOut->m_sigFigs, sizeof(headerOut->m_sigFigs));
-  m_file.write ((const char *)&headerOut->m_snapLen, sizeof(headerOut->m_snapLen));
-  m_file.write ((const char *)&headerOut->m_type, sizeof(headerOut->m_type));
+  Append (&headerOut->m_magicNumber, sizeof(headerOut->m_magicNumber));
+  Append (&headerOut->m_versionMajor, sizeof(headerOut->m_versionMajor));
+  Append (&headerOut->m_versionMinor, sizeof(headerOut->m_versionMinor));
+  Append (&headerOut->m_zone, sizeof(headerOut->m_zone));
+  Append (&headerOut->m_sigFigs, sizeof(headerOut->m_sigFigs));
+  Append (&headerOut->m_snapLen, sizeof(headerOut->m_snapLen));
+  Append (&headerOut->m_type, sizeof(headerOut->m_type));
 }
 
 void
@@ -249,6 +619,11 @@ PcapFile::ReadAndVerifyFileHeader (void)
   // them all individually.
   //
   m_file.read ((char *)&m_fileHeader.m_magicNumber, sizeof(m_fileHeader.m_magicNumber));
+  if (m_file.good () && m_fileHeader.m_magicNumber == NG_SECTION_HEADER)
+    {
+      ReadAndVerifySectionHeader ();
+      return;
+    }
   m_file.read ((char *)&m_fileHeader.m_versionMajor, sizeof(m_fileHeader.m_versionMajor));
   m_file.read ((char *)&m_fileHeader.m_versionMinor, sizeof(m_fileHeader.m_versionMinor));
   m_file.read ((char *)&m_fileHeader.m_zone, sizeof(m_fileHeader.m_zone));
@@ -307,6 +682,150 @@ PcapFile::ReadAndVerifyFileHeader (void)
     }
 }
 
+void
+PcapFile::ReadAndVerifySectionHeader (void)
+{
+  NS_LOG_FUNCTION (this);
+  //
+  // The block type is the same in both byte orders; the byte order magic
+  // tells how the rest of the section is written.
+  //
+  uint32_t length = 0;
+  uint32_t byteOrder = 0;
+  uint16_t versionMajor = 0;
+  uint16_t versionMinor = 0;
+  m_file.read ((char *)&length, sizeof(length));
+  m_file.read ((char *)&byteOrder, sizeof(byteOrder));
+  m_file.read ((char *)&versionMajor, sizeof(versionMajor));
+  m_file.read ((char *)&versionMinor, sizeof(versionMinor));
+  if (m_file.fail ())
+    {
+      return;
+    }
+  if (byteOrder != NG_BYTE_ORDER && byteOrder != NG_SWAPPED_BYTE_ORDER)
+    {
+      m_file.setstate (std::ios::failbit);
+      m_file.close ();
+      return;
+    }
+  m_swapMode = (byteOrder == NG_SWAPPED_BYTE_ORDER);
+  if (m_swapMode)
+    {
+      length = Swap (length);
+      versionMajor = Swap (versionMajor);
+      versionMinor = Swap (versionMinor);
+    }
+  if (versionMajor != NG_VERSION_MAJOR || length < 28 || length % 4 != 0)
+    {
+      m_file.setstate (std::ios::failbit);
+      m_file.close ();
+      return;
+    }
+  // Skip the section length and the options.
+  m_file.seekg (length - 16, std::ios::cur);
+
+  m_pcapNg = true;
+  m_interfaces.clear ();
+  m_fileHeader.m_magicNumber = NG_SECTION_HEADER;
+  m_fileHeader.m_versionMajor = versionMajor;
+  m_fileHeader.m_versionMinor = versionMinor;
+  m_fileHeader.m_zone = 0;
+  m_fileHeader.m_sigFigs = 0;
+  m_fileHeader.m_snapLen = 0;
+  m_fileHeader.m_type = 0;
+
+  //
+  // Read the interface descriptions that precede the first packet, so that
+  // the data link type is known right after Open, as with pcap files.
+  //
+  while (m_file.good ())
+    {
+      std::streampos start = m_file.tellg ();
+      uint32_t type = 0;
+      m_file.read ((char *)&type, sizeof(type));
+      m_file.read ((char *)&length, sizeof(length));
+      if (m_swapMode)
+        {
+          type = Swap (type);
+          length = Swap (length);
+        }
+      if (m_file.fail () || type != NG_INTERFACE)
+        {
+          m_file.clear ();
+          m_file.seekg (start);
+          break;
+        }
+      ReadInterfaceBlock (length);
+    }
+}
+
+void
+PcapFile::ReadInterfaceBlock (uint32_t length)
+{
+  NS_LOG_FUNCTION (this << length);
+  uint16_t linkType = 0;
+  uint16_t reserved = 0;
+  uint32_t snapLen = 0;
+  m_file.read ((char *)&linkType, sizeof(linkType));
+  m_file.read ((char *)&reserved, sizeof(reserved));
+  m_file.read ((char *)&snapLen, sizeof(snapLen));
+  uint32_t consumed = 16;
+  Interface interface;
+  interface.m_type = m_swapMode ? Swap (linkType) : linkType;
+  interface.m_snapLen = m_swapMode ? Swap (snapLen) : snapLen;
+  interface.m_tsPerSecond = 1000000;
+
+  //
+  // The timestamp resolution is the only option we need.
+  //
+  while (m_file.good () && consumed + 4 <= length - 4)
+    {
+      uint16_t code = 0;
+      uint16_t optionLength = 0;
+      m_file.read ((char *)&code, sizeof(code));
+      m_file.read ((char *)&optionLength, sizeof(optionLength));
+      consumed += 4;
+      if (m_swapMode)
+        {
+          code = Swap (code);
+          optionLength = Swap (optionLength);
+        }
+      if (code == NG_OPT_ENDOFOPT)
+        {
+          break;
+        }
+      uint32_t skip = PadLength (optionLength);
+      if (code == NG_OPT_IF_TSRESOL && optionLength >= 1)
+        {
+          uint8_t resolution = 0;
+          m_file.read ((char *)&resolution, sizeof(resolution));
+          consumed += 1;
+          skip -= 1;
+          uint64_t base = (resolution & 0x80) ? 2 : 10;
+          interface.m_tsPerSecond = 1;
+          for (uint8_t i = 0; i < (resolution & 0x7f); ++i)
+            {
+              interface.m_tsPerSecond *= base;
+            }
+        }
+      m_file.seekg (skip, std::ios::cur);
+      consumed += skip;
+    }
+  if (length < consumed + 4 || length % 4 != 0)
+    {
+      m_file.setstate (std::ios::failbit);
+      return;
+    }
+  m_file.seekg (length - consumed, std::ios::cur);
+
+  if (m_interfaces.empty ())
+    {
+      m_fileHeader.m_snapLen = interface.m_snapLen;
+      m_fileHeader.m_type = interface.m_type;
+    }
+  m_interfaces.push_back (interface);
+}
+
 void
 PcapFile::Open (std::string const &filename, std::ios::openmode mode)
 {
@@ -367,15 +886,119 @@ PcapFile::Init (uint32_t dataLinkType, uint32_t snapLen, int32_t timeZoneCorrect
   // And set swap mode if requested or we are on a big-endian system.
   //
   m_swapMode = swapMode | bigEndian;
+  m_pcapNg = false;
 
   WriteFileHeader ();
 }
 
+void
+PcapFile::InitPcapNg (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_fileHeader.m_magicNumber = NG_SECTION_HEADER;
+  m_fileHeader.m_versionMajor = NG_VERSION_MAJOR;
+  m_fileHeader.m_versionMinor = NG_VERSION_MINOR;
+  m_fileHeader.m_zone = 0;
+  m_fileHeader.m_sigFigs = 0;
+  m_fileHeader.m_snapLen = 0;
+  m_fileHeader.m_type = 0;
+  m_swapMode = false;
+  m_pcapNg = true;
+  m_interfaces.clear ();
+
+  if (m_buffer == 0)
+    {
+      m_file.seekp (0, std::ios::beg);
+    }
+
+  //
+  // Readers find out the byte order from the section header, so pcapng
+  // files are written in the byte order of this system.
+  //
+  uint32_t length = 28;
+  int64_t sectionLength = -1;
+  Append (&NG_SECTION_HEADER, sizeof(NG_SECTION_HEADER));
+  Append (&length, sizeof(length));
+  Append (&NG_BYTE_ORDER, sizeof(NG_BYTE_ORDER));
+  Append (&NG_VERSION_MAJOR, sizeof(NG_VERSION_MAJOR));
+  Append (&NG_VERSION_MINOR, sizeof(NG_VERSION_MINOR));
+  Append (&sectionLength, sizeof(sectionLength));
+  Append (&length, sizeof(length));
+}
+
 uint32_t
-PcapFile::WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen)
+PcapFile::AddInterface (uint32_t dataLinkType, uint32_t snapLen, std::string const &name)
 {
-  NS_LOG_FUNCTION (this << tsSec << tsUsec << totalLen);
-  NS_ASSERT (m_file.good ());
+  NS_LOG_FUNCTION (this << dataLinkType << snapLen << name);
+  NS_ASSERT_MSG (m_pcapNg, "Interfaces can only be added to pcapng files");
+
+  uint32_t nameLength = std::min<uint32_t> (name.size (), 0xffff);
+  uint32_t length = 20;
+  if (nameLength > 0)
+    {
+      length += 4 + PadLength (nameLength) + 4;
+    }
+  uint16_t linkType = dataLinkType;
+  uint16_t reserved = 0;
+  Append (&NG_INTERFACE, sizeof(NG_INTERFACE));
+  Append (&length, sizeof(length));
+  Append (&linkType, sizeof(linkType));
+  Append (&reserved, sizeof(reserved));
+  Append (&snapLen, sizeof(snapLen));
+  if (nameLength > 0)
+    {
+      uint16_t code = NG_OPT_IF_NAME;
+      uint16_t optionLength = nameLength;
+      uint32_t padding = 0;
+      Append (&code, sizeof(code));
+      Append (&optionLength, sizeof(optionLength));
+      Append (name.data (), nameLength);
+      Append (&padding, PadLength (nameLength) - nameLength);
+      code = NG_OPT_ENDOFOPT;
+      optionLength = 0;
+      Append (&code, sizeof(code));
+      Append (&optionLength, sizeof(optionLength));
+    }
+  Append (&length, sizeof(length));
+  NS_BUILD_DEBUG (if (m_buffer == 0) m_file.flush ());
+
+  Interface interface;
+  interface.m_type = dataLinkType;
+  interface.m_snapLen = snapLen;
+  interface.m_tsPerSecond = 1000000;
+  if (m_interfaces.empty ())
+    {
+      m_fileHeader.m_snapLen = snapLen;
+      m_fileHeader.m_type = dataLinkType;
+    }
+  m_interfaces.push_back (interface);
+  return m_interfaces.size () - 1;
+}
+
+uint32_t
+PcapFile::WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen,
+                             uint32_t interfaceId)
+{
+  NS_LOG_FUNCTION (this << tsSec << tsUsec << totalLen << interfaceId);
+  NS_ASSERT (m_writer != 0 || m_file.good ());
+
+  if (m_pcapNg)
+    {
+      NS_ASSERT_MSG (interfaceId < m_interfaces.size (), "Unknown pcapng interface " << interfaceId);
+      uint32_t snapLen = m_interfaces[interfaceId].m_snapLen;
+      uint32_t inclLen = (snapLen != 0 && totalLen > snapLen) ? snapLen : totalLen;
+      uint64_t ts = uint64_t (tsSec) * 1000000 + tsUsec;
+      uint32_t block[7];
+      block[0] = NG_ENHANCED_PACKET;
+      block[1] = NG_PACKET_OVERHEAD + PadLength (inclLen);
+      block[2] = interfaceId;
+      block[3] = ts >> 32;
+      block[4] = ts & 0xffffffff;
+      block[5] = inclLen;
+      block[6] = totalLen;
+      Append (block, sizeof(block));
+      return inclLen;
+    }
 
   uint32_t inclLen = totalLen > m_fileHeader.m_snapLen ? m_fileHeader.m_snapLen : totalLen;
 
@@ -394,47 +1017,72 @@ PcapFile::WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen)
   // Watch out for memory alignment differences between machines, so write
   // them all individually.
   //
-  m_file.write ((const char *)&header.m_tsSec, sizeof(header.m_tsSec));
-  m_file.write ((const char *)&header.m_tsUsec, sizeof(header.m_tsUsec));
-  m_file.write ((const char *)&header.m_inclLen, sizeof(header.m_inclLen));
-  m_file.write ((const char *)&header.m_origLen, sizeof(header.m_origLen));
-  NS_BUILD_DEBUG(m_file.flush());
+  Append (&header.m_tsSec, sizeof(header.m_tsSec));
+  Append (&header.m_tsUsec, sizeof(header.m_tsUsec));
+  Append (&header.m_inclLen, sizeof(header.m_inclLen));
+  Append (&header.m_origLen, sizeof(header.m_origLen));
+  NS_BUILD_DEBUG(if (m_buffer == 0) m_file.flush());
   return inclLen;
 }
 
 void
-PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, uint8_t const * const data, uint32_t totalLen)
+PcapFile::WritePacketTrailer (uint32_t inclLen)
 {
-  NS_LOG_FUNCTION (this << tsSec << tsUsec << &data << totalLen);
-  uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, totalLen);
-  m_file.write ((const char *)data, inclLen);
-  NS_BUILD_DEBUG(m_file.flush());
+  NS_LOG_FUNCTION (this << inclLen);
+  if (m_pcapNg)
+    {
+      uint32_t padding = 0;
+      uint32_t length = NG_PACKET_OVERHEAD + PadLength (inclLen);
+      Append (&padding, PadLength (inclLen) - inclLen);
+      Append (&length, sizeof(length));
+    }
+  NS_BUILD_DEBUG(if (m_buffer == 0) m_file.flush());
+}
+
+void
+PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, uint8_t const * const data, uint32_t totalLen,
+                 uint32_t interfaceId)
+{
+  NS_LOG_FUNCTION (this << tsSec << tsUsec << &data << totalLen << interfaceId);
+  uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, totalLen, interfaceId);
+  Append (data, inclLen);
+  WritePacketTrailer (inclLen);
 }
 
 void 
-PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, Ptr<const Packet> p)
+PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, Ptr<const Packet> p, uint32_t interfaceId)
 {
-  NS_LOG_FUNCTION (this << tsSec << tsUsec << p);
-  uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, p->GetSize ());
-  p->CopyData (&m_file, inclLen);
-  NS_BUILD_DEBUG(m_file.flush());
+  NS_LOG_FUNCTION (this << tsSec << tsUsec << p << interfaceId);
+  uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, p->GetSize (), interfaceId);
+  AppendPacket (p, inclLen);
+  WritePacketTrailer (inclLen);
 }
 
 void 
-PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, const Header &header, Ptr<const Packet> p)
+PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, const Header &header, Ptr<const Packet> p,
+                 uint32_t interfaceId)
 {
-  NS_LOG_FUNCTION (this << tsSec << tsUsec << &header << p);
+  NS_LOG_FUNCTION (this << tsSec << tsUsec << &header << p << interfaceId);
   uint32_t headerSize = header.GetSerializedSize ();
   uint32_t totalSize = headerSize + p->GetSize ();
-  uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, totalSize);
+  uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, totalSize, interfaceId);
 
   Buffer headerBuffer;
   headerBuffer.AddAtStart (headerSize);
   header.Serialize (headerBuffer.Begin ());
   uint32_t toCopy = std::min (headerSize, inclLen);
-  headerBuffer.CopyData (&m_file, toCopy);
-  inclLen -= toCopy;
-  p->CopyData (&m_file, inclLen);
+  if (m_buffer == 0)
+    {
+      headerBuffer.CopyData (&m_file, toCopy);
+    }
+  else if (toCopy > 0)
+    {
+      m_scratch.resize (toCopy);
+      headerBuffer.CopyData (&m_scratch[0], toCopy);
+      Append (&m_scratch[0], toCopy);
+    }
+  AppendPacket (p, inclLen - toCopy);
+  WritePacketTrailer (inclLen);
 }
 
 void
@@ -450,6 +1098,12 @@ PcapFile::Read (
   NS_LOG_FUNCTION (this << &data <<maxBytes << tsSec << tsUsec << inclLen << origLen << readLen);
   NS_ASSERT (m_file.good ());
 
+  if (m_pcapNg)
+    {
+      ReadPcapNg (data, maxBytes, tsSec, tsUsec, inclLen, origLen, readLen);
+      return;
+    }
+
   PcapRecordHeader header;
 
   //
@@ -496,6 +1150,91 @@ PcapFile::Read (
     }
 }
 
+void
+PcapFile::ReadPcapNg (
+  uint8_t * const data, 
+  uint32_t maxBytes,
+  uint32_t &tsSec, 
+  uint32_t &tsUsec, 
+  uint32_t &inclLen, 
+  uint32_t &origLen,
+  uint32_t &readLen)
+{
+  NS_LOG_FUNCTION (this << &data << maxBytes);
+  //
+  // Interface descriptions may appear anywhere in a section; blocks we
+  // have no use for are skipped.
+  //
+  while (true)
+    {
+      uint32_t type = 0;
+      uint32_t length = 0;
+      m_file.read ((char *)&type, sizeof(type));
+      if (type == NG_SECTION_HEADER)
+        {
+          ReadAndVerifySectionHeader ();
+          if (!m_file.good ())
+            {
+              return;
+            }
+          continue;
+        }
+      m_file.read ((char *)&length, sizeof(length));
+      if (m_file.fail ())
+        {
+          return;
+        }
+      if (m_swapMode)
+        {
+          type = Swap (type);
+          length = Swap (length);
+        }
+      if (length < 12 || length % 4 != 0)
+        {
+          m_file.setstate (std::ios::failbit);
+          return;
+        }
+      if (type == NG_INTERFACE)
+        {
+          ReadInterfaceBlock (length);
+          continue;
+        }
+      if (type != NG_ENHANCED_PACKET)
+        {
+          m_file.seekg (length - 8, std::ios::cur);
+          continue;
+        }
+
+      uint32_t fields[5];
+      m_file.read ((char *)fields, sizeof(fields));
+      if (m_file.fail ())
+        {
+          return;
+        }
+      for (uint32_t i = 0; m_swapMode && i < 5; ++i)
+        {
+          fields[i] = Swap (fields[i]);
+        }
+      if (fields[0] >= m_interfaces.size () || length < NG_PACKET_OVERHEAD + fields[3])
+        {
+          m_file.setstate (std::ios::failbit);
+          return;
+        }
+      m_interfaceId = fields[0];
+      uint64_t ts = (uint64_t (fields[1]) << 32) | fields[2];
+      uint64_t perSecond = m_interfaces[m_interfaceId].m_tsPerSecond;
+      tsSec = ts / perSecond;
+      tsUsec = (ts % perSecond) * 1000000 / perSecond;
+      inclLen = fields[3];
+      origLen = fields[4];
+
+      readLen = maxBytes < inclLen ? maxBytes : inclLen;
+      m_file.read ((char *)data, readLen);
+      m_file.seekg (length - 28 - readLen, std::ios::cur);
+      return;
+    }
+}
+
 bool
 PcapFile::Diff (std::string const & f1, std::string const & f2, 
                 uint32_t & sec, uint32_t & usec, uint32_t & packets,
@@ -23,6 +23,7 @@
 
 #include <string>
 #include <fstream>
+#include <vector>
 #include <stdint.h>
 #include "ns3/ptr.h"
 
@@ -30,6 +31,7 @@ namespace ns3 {
 
 class Packet;
 class Header;
+class PcapAsyncWriter;
 
 
 /**
@@ -38,12 +40,22 @@ class Header;
  * A class representing a pcap file.  This allows easy creation, writing and 
  * reading of files composed of stored packets; which may be viewed using
  * standard tools.
+ *
+ * Files are written either in the classic pcap format (see Init()), or in
+ * the pcapng format (see InitPcapNg()), where a single file holds packets
+ * captured on several interfaces, each with its own data link type and
+ * snapshot length.  Both formats can be read back.
+ *
+ * By default every record is written to the underlying file stream as
+ * it is produced.  SetBuffering() gathers records in large write buffers
+ * instead, optionally written to the file by a background thread.
  */
 class PcapFile
 {
 public:
   static const int32_t  ZONE_DEFAULT    = 0;           /**< Time zone offset for current location */
   static const uint32_t SNAPLEN_DEFAULT = 65535;       /**< Default value for maximum octets to save per packet */
+  static const uint32_t BUFFER_ALIGNMENT = 4096;       /**< Write buffer sizes are a multiple of this value */
 
 public:
   PcapFile ();
@@ -118,6 +130,62 @@ public:
              int32_t timeZoneCorrection = ZONE_DEFAULT,
              bool swapMode = false);
 
+  /**
+   * Initialize the pcapng file associated with this object.  This file must
+   * have been previously opened with write permissions.  This writes the
+   * section header; interfaces are then declared with AddInterface().
+   *
+   * pcapng files are written with the byte order of the writing system,
+   * which the section header records.
+   *
+   * \warning Calling this method on an existing file will result in the loss
+   * any existing data.
+   */
+  void InitPcapNg (void);
+
+  /**
+   * Declare a capture interface in a pcapng file initialized with
+   * InitPcapNg().  Interfaces can be added at any time; the packets
+   * captured on an interface are written by passing its id to Write().
+   *
+   * \param dataLinkType The data link type of the interface, as in Init().
+   * \param snapLen The maximum size of the packets written for this
+   * interface.  Longer packets are truncated.
+   * \param name An optional interface name, such as the name of the
+   * per-device pcap file the interface replaces.
+   *
+   * \returns the id of the new interface.
+   */
+  uint32_t AddInterface (uint32_t dataLinkType,
+                         uint32_t snapLen = SNAPLEN_DEFAULT,
+                         std::string const &name = "");
+
+  /**
+   * Gather written records in large write buffers.
+   *
+   * Records are copied to a write buffer of \p bufferSize bytes, rounded
+   * up to a multiple of BUFFER_ALIGNMENT, and only full buffers are written
+   * to the file, so that the file is written in large chunks at aligned
+   * offsets.  In asynchronous mode, full buffers are handed over to a
+   * background writer thread, and the caller only waits when all the
+   * buffers are in flight.  Without thread support, asynchronous mode
+   * falls back to synchronous writes.  Buffered data is written by Flush()
+   * and Close().
+   *
+   * This must be called after Open(), and before Init() or InitPcapNg().
+   *
+   * \param bufferSize The size of a write buffer, in bytes, or 0 to write
+   * every record to the file as it is produced.
+   * \param asynchronous Whether full buffers are written by a background
+   * thread.
+   */
+  void SetBuffering (uint32_t bufferSize, bool asynchronous = false);
+
+  /**
+   * Write all the buffered data to the file, and wait until it is written.
+   */
+  void Flush (void);
+
   /**
    * \brief Write next packet to file
    * 
@@ -125,9 +193,11 @@ public:
    * \param tsUsec      Packet timestamp, microseconds
    * \param data        Data buffer
    * \param totalLen    Total packet length
+   * \param interfaceId Interface the packet was captured on (pcapng only)
    * 
    */
-  void Write (uint32_t tsSec, uint32_t tsUsec, uint8_t const * const data, uint32_t totalLen);
+  void Write (uint32_t tsSec, uint32_t tsUsec, uint8_t const * const data, uint32_t totalLen,
+              uint32_t interfaceId = 0);
 
   /**
    * \brief Write next packet to file
@@ -135,9 +205,10 @@ public:
    * \param tsSec       Packet timestamp, seconds 
    * \param tsUsec      Packet timestamp, microseconds
    * \param p           Packet to write
+   * \param interfaceId Interface the packet was captured on (pcapng only)
    * 
    */
-  void Write (uint32_t tsSec, uint32_t tsUsec, Ptr<const Packet> p);
+  void Write (uint32_t tsSec, uint32_t tsUsec, Ptr<const Packet> p, uint32_t interfaceId = 0);
   /**
    * \brief Write next packet to file
    * 
@@ -145,9 +216,11 @@ public:
    * \param tsUsec      Packet timestamp, microseconds
    * \param header      Header to write, in front of packet
    * \param p           Packet to write
+   * \param interfaceId Interface the packet was captured on (pcapng only)
    * 
    */
-  void Write (uint32_t tsSec, uint32_t tsUsec, const Header &header, Ptr<const Packet> p);
+  void Write (uint32_t tsSec, uint32_t tsUsec, const Header &header, Ptr<const Packet> p,
+              uint32_t interfaceId = 0);
 
 
   /**
@@ -170,6 +243,23 @@ public:
              uint32_t &origLen, 
              uint32_t &readLen);
 
+  /**
+   * \returns true if the file is in the pcapng format.
+   */
+  bool IsPcapNg (void) const;
+
+  /**
+   * \returns the number of interfaces of a pcapng file: those added so far
+   * when writing, those read so far when reading.  Classic pcap files have
+   * a single interface.
+   */
+  uint32_t GetInterfaceCount (void) const;
+
+  /**
+   * \returns the interface the last packet read was captured on.
+   */
+  uint32_t GetInterfaceId (void) const;
+
   /**
    * \brief Get the swap mode of the file.
    *
@@ -344,19 +434,99 @@ private:
    * \param tsSec Time stamp (seconds part)
    * \param tsUsec Time stamp (microseconds part)
    * \param totalLen total packet length
+   * \param interfaceId interface the packet was captured on (pcapng only)
    * \returns the length of the packet to write in the Pcap file
    */
-  uint32_t WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen);
+  uint32_t WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen,
+                              uint32_t interfaceId);
+
+  /**
+   * \brief Write the end of a packet record
+   * \param inclLen the length of the packet data written
+   */
+  void WritePacketTrailer (uint32_t inclLen);
 
   /**
    * \brief Read and verify a Pcap file header
    */
   void ReadAndVerifyFileHeader (void);
 
+  /**
+   * \brief Read and verify a pcapng section header, after its block type
+   */
+  void ReadAndVerifySectionHeader (void);
+
+  /**
+   * \brief Read the next packet of a pcapng file
+   *
+   * \param data        [out] Data buffer
+   * \param maxBytes    Allocated data buffer size
+   * \param tsSec       [out] Packet timestamp, seconds
+   * \param tsUsec      [out] Packet timestamp, microseconds
+   * \param inclLen     [out] Included length
+   * \param origLen     [out] Original length
+   * \param readLen     [out] Number of bytes read
+   */
+  void ReadPcapNg (uint8_t * const data,
+                   uint32_t maxBytes,
+                   uint32_t &tsSec,
+                   uint32_t &tsUsec,
+                   uint32_t &inclLen,
+                   uint32_t &origLen,
+                   uint32_t &readLen);
+
+  /**
+   * \brief Read the body of a pcapng interface description block
+   * \param length the total block length
+   */
+  void ReadInterfaceBlock (uint32_t length);
+
+  /**
+   * \brief Write data to the file, through the write buffer if any
+   * \param data the data
+   * \param size the data size
+   */
+  void Append (void const *data, uint32_t size);
+
+  /**
+   * \brief Write the start of a packet to the file
+   * \param p the packet
+   * \param size the number of bytes to write
+   */
+  void AppendPacket (Ptr<const Packet> p, uint32_t size);
+
+  /**
+   * \brief Hand the write buffer over to the file or the writer thread
+   */
+  void FlushBuffer (void);
+
+  /**
+   * \brief Stop buffering, after writing all the buffered data
+   */
+  void StopBuffering (void);
+
+  /**
+   * \brief A pcapng capture interface
+   */
+  struct Interface
+  {
+    uint32_t m_type;          //!< data link type
+    uint32_t m_snapLen;       //!< maximum length of packet data stored
+    uint64_t m_tsPerSecond;   //!< timestamp units per second
+  };
+
   std::string    m_filename;    //!< file name
   std::fstream   m_file;        //!< file stream
   PcapFileHeader m_fileHeader;  //!< file header
   bool m_swapMode;              //!< swap mode
+  bool m_pcapNg;                //!< pcapng format
+  std::vector<Interface> m_interfaces; //!< pcapng interfaces
+  uint32_t m_interfaceId;       //!< interface of the last packet read
+  char *m_buffer;               //!< write buffer, if buffering
+  uint32_t m_bufferSize;        //!< size of the write buffer
+  uint32_t m_bufferUsed;        //!< bytes used in the write buffer
+  PcapAsyncWriter *m_writer;    //!< background writer, if asynchronous
+  std::vector<uint8_t> m_scratch; //!< scratch space for records spanning buffers
 };
 
 } // namespace ns3
@@ -23,6 +23,12 @@
 #include "ns3/simulator.h"
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/point-to-point-channel.h"
+#include "ns3/data-rate.h"
+#include "ns3/packet.h"
+
+#include <ctime>
+#include <iostream>
+#include <map>
 
 using namespace ns3;
 
@@ -93,6 +99,160 @@ PointToPointTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \brief Forward packets along a chain of point-to-point links and
+ * check that, in steady state, no packet storage comes from the heap.
+ */
+class PointToPointChainTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   *
+   * \param nodes number of nodes in the chain
+   * \param packets number of packets sent
+   * \param report print the forwarding time and allocation counters
+   */
+  PointToPointChainTest (uint32_t nodes, uint32_t packets, bool report);
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send a packet from the first node, and schedule the next one
+   *
+   * \param device the device of the first node
+   */
+  void Send (Ptr<NetDevice> device);
+  /**
+   * \brief Receive a packet and forward it to the next link
+   *
+   * \param device the receiving device
+   * \param packet the packet
+   * \param protocol the protocol number
+   * \param from the sender address
+   * \returns true
+   */
+  bool Forward (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                uint16_t protocol, const Address &from);
+
+  uint32_t m_nodes;    //!< number of nodes in the chain
+  uint32_t m_packets;  //!< number of packets to send
+  bool m_report;       //!< print the results
+  uint32_t m_sent;     //!< number of packets sent
+  uint32_t m_received; //!< number of packets received by the last node
+  std::map<Ptr<NetDevice>, Ptr<NetDevice> > m_next; //!< next hop of each receiving device
+};
+
+PointToPointChainTest::PointToPointChainTest (uint32_t nodes, uint32_t packets, bool report)
+  : TestCase ("PointToPoint chain forwarding allocations"),
+    m_nodes (nodes),
+    m_packets (packets),
+    m_report (report),
+    m_sent (0),
+    m_received (0)
+{
+}
+
+void
+PointToPointChainTest::Send (Ptr<NetDevice> device)
+{
+  if (m_sent == m_packets / 2)
+    {
+      // the pools are warm: measure from now on.
+      Packet::ResetAllocationStats ();
+    }
+  device->Send (Create<Packet> (1000), device->GetBroadcast (), 0x800);
+  m_sent++;
+  if (m_sent < m_packets)
+    {
+      Simulator::Schedule (MicroSeconds (10), &PointToPointChainTest::Send, this, device);
+    }
+}
+
+bool
+PointToPointChainTest::Forward (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                uint16_t protocol, const Address &from)
+{
+  std::map<Ptr<NetDevice>, Ptr<NetDevice> >::const_iterator i = m_next.find (device);
+  if (i == m_next.end ())
+    {
+      m_received++;
+      return true;
+    }
+  i->second->Send (packet->Copy (), i->second->GetBroadcast (), protocol);
+  return true;
+}
+
+void
+PointToPointChainTest::DoRun (void)
+{
+  Ptr<NetDevice> first;
+  Ptr<PointToPointNetDevice> previous;
+  for (uint32_t n = 0; n < m_nodes; n++)
+    {
+      Ptr<Node> node = CreateObject<Node> ();
+      Ptr<PointToPointNetDevice> in;
+      if (n > 0)
+        {
+          in = CreateObject<PointToPointNetDevice> ();
+          in->SetAddress (Mac48Address::Allocate ());
+          in->SetQueue (CreateObject<DropTailQueue> ());
+          node->AddDevice (in);
+          Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+          channel->SetAttribute ("Delay", TimeValue (MicroSeconds (1)));
+          previous->Attach (channel);
+          in->Attach (channel);
+          in->SetReceiveCallback (MakeCallback (&PointToPointChainTest::Forward, this));
+        }
+      if (n + 1 < m_nodes)
+        {
+          Ptr<PointToPointNetDevice> out = CreateObject<PointToPointNetDevice> ();
+          out->SetAddress (Mac48Address::Allocate ());
+          out->SetQueue (CreateObject<DropTailQueue> ());
+          out->SetDataRate (DataRate ("1Gbps"));
+          node->AddDevice (out);
+          if (in != 0)
+            {
+              m_next[in] = out;
+            }
+          else
+            {
+              first = out;
+            }
+          previous = out;
+        }
+    }
+
+  Simulator::ScheduleNow (&PointToPointChainTest::Send, this, first);
+  std::clock_t start = std::clock ();
+  Simulator::Run ();
+  std::clock_t ticks = std::clock () - start;
+  PacketAllocationStats stats = Packet::GetAllocationStats ();
+  Simulator::Destroy ();
+  m_next.clear ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_received, m_packets, "Packets lost along the chain");
+  NS_TEST_ASSERT_MSG_GT (stats.packets, m_packets - m_packets / 2, "Packets were not counted");
+  NS_TEST_ASSERT_MSG_EQ (stats.packetAllocs, 0, "Packets allocated in steady state");
+  NS_TEST_ASSERT_MSG_EQ (stats.bufferAllocs, 0, "Buffers allocated in steady state");
+  NS_TEST_ASSERT_MSG_EQ (stats.byteTagAllocs, 0, "Byte tags allocated in steady state");
+  NS_TEST_ASSERT_MSG_EQ (stats.packetTagAllocs, 0, "Packet tags allocated in steady state");
+  NS_TEST_ASSERT_MSG_EQ (stats.metadataAllocs, 0, "Metadata allocated in steady state");
+  if (m_report)
+    {
+      double hops = double (m_packets) * (m_nodes - 1);
+      std::cout << GetName () << ": " << m_nodes << " nodes, "
+                << 1e9 * double (ticks) / (hops * CLOCKS_PER_SEC)
+                << " ns/packet/hop, steady state: " << stats.packets << " packets, "
+                << stats.packetAllocs << " packet and "
+                << stats.bufferAllocs << " buffer allocations" << std::endl;
+    }
+}
+
 /**
  * \brief TestSuite for PointToPoint module
  */
@@ -109,6 +269,27 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest, TestCase::QUICK);
+  AddTestCase (new PointToPointChainTest (4, 200, false), TestCase::QUICK);
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite; //!< The testsuite
+
+/**
+ * \brief Point-to-point chain forwarding benchmark
+ */
+class PointToPointChainPerfTestSuite : public TestSuite
+{
+public:
+  /**
+   * \brief Constructor
+   */
+  PointToPointChainPerfTestSuite ();
+};
+
+PointToPointChainPerfTestSuite::PointToPointChainPerfTestSuite ()
+  : TestSuite ("point-to-point-chain-perf", PERFORMANCE)
+{
+  AddTestCase (new PointToPointChainTest (16, 100000, true), TestCase::QUICK);
+}
+
+static PointToPointChainPerfTestSuite g_pointToPointChainPerfTestSuite; //!< The benchmark suite
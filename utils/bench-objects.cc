@@ -0,0 +1,212 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/object-factory.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/data-rate.h"
+#include "ns3/node.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/drop-tail-queue.h"
+#include "ns3/error-model.h"
+#include "ns3/simple-channel.h"
+#include "ns3/packet-socket-factory.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/config.h"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+using namespace ns3;
+
+// Benchmark the object system paths hit while building a topology:
+// TypeId name lookup, attribute and trace source lookup by name,
+// aggregate lookup, object creation through ObjectFactory, trace source
+// connection and Config path resolution.
+
+static void
+DropSink (Ptr<const Packet> p)
+{
+}
+
+static void
+DropContextSink (std::string context, Ptr<const Packet> p)
+{
+}
+
+static void
+Report (std::string what, uint32_t n, int64_t ms)
+{
+  std::cout << std::left << std::setw (36) << what
+            << std::right << std::setw (10) << n
+            << std::setw (10) << ms << " ms"
+            << std::setw (12) << std::fixed << std::setprecision (1)
+            << (ms * 1e6 / n) << " ns/op" << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t nodes = 10000;
+  uint32_t devices = 4;
+  uint32_t lookups = 1000000;
+
+  CommandLine cmd;
+  cmd.AddValue ("nodes", "number of nodes to create", nodes);
+  cmd.AddValue ("devices", "number of devices per node", devices);
+  cmd.AddValue ("lookups", "number of name lookups to run", lookups);
+  cmd.Parse (argc, argv);
+
+  SystemWallClockMs time;
+  const char *names[] = {
+    "ns3::Node", "ns3::SimpleNetDevice", "ns3::DropTailQueue",
+    "ns3::SimpleChannel", "ns3::Object"
+  };
+  uint32_t nNames = sizeof (names) / sizeof (names[0]);
+
+  time.Start ();
+  for (uint32_t i = 0; i < lookups; ++i)
+    {
+      TypeId::LookupByName (names[i % nNames]);
+    }
+  Report ("TypeId::LookupByName", lookups, time.End ());
+
+  TypeId tid = DropTailQueue::GetTypeId ();
+  struct TypeId::AttributeInformation info;
+  time.Start ();
+  for (uint32_t i = 0; i < lookups; ++i)
+    {
+      tid.LookupAttributeByName ("MaxBytes", &info);
+    }
+  Report ("TypeId::LookupAttributeByName", lookups, time.End ());
+
+  time.Start ();
+  for (uint32_t i = 0; i < lookups; ++i)
+    {
+      tid.LookupTraceSourceByName ("Drop");
+    }
+  Report ("TypeId::LookupTraceSourceByName", lookups, time.End ());
+
+  Ptr<Node> aggregate = CreateObject<Node> ();
+  aggregate->AggregateObject (CreateObject<DropTailQueue> ());
+  aggregate->AggregateObject (CreateObject<SimpleChannel> ());
+  aggregate->AggregateObject (CreateObject<RateErrorModel> ());
+  aggregate->AggregateObject (CreateObject<PacketSocketFactory> ());
+  aggregate->AggregateObject (CreateObject<ListErrorModel> ());
+  uint32_t found = 0;
+  time.Start ();
+  for (uint32_t i = 0; i < lookups; ++i)
+    {
+      found += aggregate->GetObject<ListErrorModel> () != 0;
+      found += aggregate->GetObject<Queue> () != 0;
+    }
+  Report ("GetObject (hit, 6 aggregates)", 2 * lookups, time.End ());
+  time.Start ();
+  for (uint32_t i = 0; i < lookups; ++i)
+    {
+      found += aggregate->GetObject<SimpleNetDevice> () != 0;
+    }
+  Report ("GetObject (miss, 6 aggregates)", lookups, time.End ());
+  if (found != 2 * lookups)
+    {
+      std::cerr << "GetObject returned unexpected results" << std::endl;
+      return 1;
+    }
+  aggregate->Dispose ();
+
+  ObjectFactory nodeFactory ("ns3::Node");
+  ObjectFactory deviceFactory ("ns3::SimpleNetDevice");
+  ObjectFactory queueFactory ("ns3::DropTailQueue");
+  std::vector<Ptr<Node> > topology;
+  topology.reserve (nodes);
+
+  SystemWallClockMs total;
+  total.Start ();
+  time.Start ();
+  for (uint32_t i = 0; i < nodes; ++i)
+    {
+      Ptr<Node> node = nodeFactory.Create<Node> ();
+      for (uint32_t j = 0; j < devices; ++j)
+        {
+          deviceFactory.Set ("PointToPointMode", BooleanValue (true));
+          deviceFactory.Set ("DataRate", DataRateValue (DataRate ("10Mbps")));
+          Ptr<SimpleNetDevice> device = deviceFactory.Create<SimpleNetDevice> ();
+          queueFactory.Set ("MaxPackets", UintegerValue (100));
+          Ptr<Queue> queue = queueFactory.Create<Queue> ();
+          device->SetQueue (queue);
+          node->AddDevice (device);
+        }
+      topology.push_back (node);
+    }
+  Report ("ObjectFactory::Create (node+devs)", nodes, time.End ());
+
+  time.Start ();
+  for (uint32_t i = 0; i < nodes; ++i)
+    {
+      for (uint32_t j = 0; j < devices; ++j)
+        {
+          Ptr<NetDevice> device = topology[i]->GetDevice (j);
+          device->SetAttribute ("DataRate", DataRateValue (DataRate ("100Mbps")));
+          device->TraceConnectWithoutContext ("PhyRxDrop", MakeCallback (&DropSink));
+        }
+    }
+  Report ("SetAttribute+TraceConnect (devs)", nodes * devices, time.End ());
+
+  time.Start ();
+  Config::Set ("/NodeList/*/DeviceList/*/$ns3::SimpleNetDevice/DataRate",
+               DataRateValue (DataRate ("1Gbps")));
+  Config::Set ("/NodeList/*/DeviceList/*/$ns3::SimpleNetDevice/TxQueue/MaxPackets",
+               UintegerValue (200));
+  Config::Connect ("/NodeList/*/DeviceList/*/$ns3::SimpleNetDevice/PhyRxDrop",
+                   MakeCallback (&DropContextSink));
+  Config::Connect ("/NodeList/*/DeviceList/*/$ns3::SimpleNetDevice/TxQueue/Drop",
+                   MakeCallback (&DropContextSink));
+  Report ("Config::Set+Connect (4 paths)", nodes, time.End ());
+  Report ("topology setup total", nodes, total.End ());
+
+  time.Start ();
+  Config::Batch batch;
+  batch.Set ("/NodeList/*/DeviceList/*/$ns3::SimpleNetDevice/DataRate",
+             DataRateValue (DataRate ("1Gbps")));
+  batch.Set ("/NodeList/*/DeviceList/*/$ns3::SimpleNetDevice/TxQueue/MaxPackets",
+             UintegerValue (200));
+  batch.Connect ("/NodeList/*/DeviceList/*/$ns3::SimpleNetDevice/PhyRxDrop",
+                 MakeCallback (&DropContextSink));
+  batch.Connect ("/NodeList/*/DeviceList/*/$ns3::SimpleNetDevice/TxQueue/Drop",
+                 MakeCallback (&DropContextSink));
+  batch.Apply ();
+  Report ("Config::Batch::Apply (4 paths)", nodes, time.End ());
+
+  uint32_t added = nodes / 100 + 1;
+  for (uint32_t i = 0; i < added; ++i)
+    {
+      Ptr<Node> node = nodeFactory.Create<Node> ();
+      Ptr<SimpleNetDevice> device = deviceFactory.Create<SimpleNetDevice> ();
+      device->SetQueue (queueFactory.Create<Queue> ());
+      node->AddDevice (device);
+      topology.push_back (node);
+    }
+  time.Start ();
+  batch.Update ();
+  Report ("Config::Batch::Update (new nodes)", added, time.End ());
+
+  topology.clear ();
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,65 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/command-line.h"
+#include "ns3/log.h"
+
+#include <fstream>
+#include <iostream>
+
+using namespace ns3;
+
+// Decode a binary log file written with NS_LOG_BINARY or
+// LogBinaryEnable() to text.
+
+int main (int argc, char *argv[])
+{
+  std::string file;
+  std::string output;
+
+  CommandLine cmd;
+  cmd.AddValue ("file", "binary log file to decode", file);
+  cmd.AddValue ("output", "text output file (default: standard output)", output);
+  cmd.Parse (argc, argv);
+
+  if (file.empty ())
+    {
+      std::cerr << "Usage: log-decode --file=<binary log> [--output=<text file>]" << std::endl;
+      return 1;
+    }
+  std::ifstream is (file.c_str (), std::ios::in | std::ios::binary);
+  if (!is.is_open ())
+    {
+      std::cerr << "Can't open " << file << std::endl;
+      return 1;
+    }
+  std::ofstream os;
+  if (!output.empty ())
+    {
+      os.open (output.c_str ());
+      if (!os.is_open ())
+        {
+          std::cerr << "Can't open " << output << std::endl;
+          return 1;
+        }
+    }
+  if (!LogBinaryDecode (is, output.empty () ? std::cout : os))
+    {
+      std::cerr << file << " is not a binary log file, or is truncated" << std::endl;
+      return 1;
+    }
+  return 0;
+}